@@ -0,0 +1,365 @@
+// sk_gpu_bench measures the CPU time spent inside sk_gpu's per-draw calls,
+// using a frame that looks roughly like a real app's: lots of draws, with
+// pipeline, mesh, texture and constant buffer changes mixed in at different
+// rates so the state caching gets a realistic workout.
+//
+// usage: sk_gpu_bench [--frames N] [--draws N] [--json report.json]
+
+#include "../../src/sk_gpu_dev.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+///////////////////////////////////////////
+
+#if   defined(SKG_NULL)
+const char *bench_backend = "null";
+#elif defined(SKG_OPENGL)
+const char *bench_backend = "opengl";
+#elif defined(SKG_DIRECT3D11)
+const char *bench_backend = "d3d11";
+#else
+const char *bench_backend = "unknown";
+#endif
+
+typedef std::chrono::steady_clock bench_clock;
+
+enum bench_call_ {
+	bench_call_pipeline_bind,
+	bench_call_mesh_bind,
+	bench_call_tex_bind,
+	bench_call_buffer_set_contents,
+	bench_call_buffer_bind,
+	bench_call_draw,
+	bench_call_max,
+};
+const char *bench_call_names[bench_call_max] = {
+	"skg_pipeline_bind",
+	"skg_mesh_bind",
+	"skg_tex_bind",
+	"skg_buffer_set_contents",
+	"skg_buffer_bind",
+	"skg_draw",
+};
+
+typedef struct bench_call_t {
+	int64_t count;
+	int64_t ns;
+} bench_call_t;
+
+typedef struct bench_constants_t {
+	float offset_scale[4];
+	float color[4];
+} bench_constants_t;
+
+const int32_t bench_pipeline_count = 8;
+const int32_t bench_mesh_count     = 16;
+const int32_t bench_tex_count      = 16;
+
+int32_t             bench_frames = 100;
+int32_t             bench_draws  = 10000;
+const char         *bench_json   = nullptr;
+
+skg_shader_t        bench_shader;
+skg_shader_meta_t   bench_meta;
+skg_pipeline_t      bench_pipelines[bench_pipeline_count];
+skg_buffer_t        bench_vbuffs   [bench_mesh_count];
+skg_buffer_t        bench_ibuffs   [bench_mesh_count];
+skg_mesh_t          bench_meshes   [bench_mesh_count];
+skg_tex_t           bench_textures [bench_tex_count];
+skg_buffer_t        bench_constants;
+skg_tex_t           bench_target;
+skg_tex_t           bench_target_depth;
+
+bench_call_t        bench_calls[bench_call_max];
+double              bench_frame_ms_timed   = 0;
+double              bench_frame_ms_untimed = 0;
+double              bench_timer_overhead   = 0;
+skg_stats_t         bench_stats            = {};
+
+///////////////////////////////////////////
+
+const char *bench_vs = R"_(#version 450
+layout(location = 0) in vec4 in_var_SV_POSITION;
+layout(location = 1) in vec3 in_var_NORMAL;
+layout(location = 2) in vec2 in_var_TEXCOORD0;
+layout(location = 3) in vec4 in_var_COLOR;
+
+layout(std140) uniform BenchBuffer {
+	vec4 offset_scale;
+	vec4 color;
+} bench;
+
+out vec2 fs_var_TEXCOORD0;
+out vec4 fs_var_COLOR;
+
+void main() {
+	gl_Position      = vec4(in_var_SV_POSITION.xy * bench.offset_scale.zw + bench.offset_scale.xy, 0.5, 1.0);
+	fs_var_TEXCOORD0 = in_var_TEXCOORD0;
+	fs_var_COLOR     = in_var_COLOR * bench.color;
+})_";
+
+const char *bench_ps = R"_(#version 450
+precision mediump float;
+precision highp int;
+
+uniform highp sampler2D tex;
+
+in highp vec2 fs_var_TEXCOORD0;
+in highp vec4 fs_var_COLOR;
+layout(location = 0) out highp vec4 out_var_SV_TARGET;
+
+void main() {
+	out_var_SV_TARGET = texture(tex, fs_var_TEXCOORD0) * fs_var_COLOR;
+})_";
+
+///////////////////////////////////////////
+
+bool bench_init    ();
+void bench_shutdown();
+void bench_frame   (bool timed);
+void bench_report  ();
+
+///////////////////////////////////////////
+
+int main(int argc, char **argv) {
+	for (int32_t i = 1; i < argc; i++) {
+		if      (strcmp(argv[i], "--frames") == 0 && i+1 < argc) bench_frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--draws" ) == 0 && i+1 < argc) bench_draws  = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--json"  ) == 0 && i+1 < argc) bench_json   = argv[++i];
+		else {
+			printf("usage: %s [--frames N] [--draws N] [--json report.json]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (bench_frames < 1) bench_frames = 1;
+	if (bench_draws  < 1) bench_draws  = 1;
+
+	skg_callback_log([](skg_log_ level, const char *text) {
+		if (level != skg_log_info)
+			fprintf(stderr, "[%d] %s\n", level, text);
+	});
+	if (!bench_init())
+		return -1;
+
+	// Figure out how much a pair of clock reads costs, so it can be
+	// subtracted from each individual call measurement.
+	const int32_t calibrate_count = 100000;
+	int64_t       calibrate_ns    = 0;
+	for (int32_t i = 0; i < calibrate_count; i++) {
+		bench_clock::time_point start = bench_clock::now();
+		bench_clock::time_point end   = bench_clock::now();
+		calibrate_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+	bench_timer_overhead = (double)calibrate_ns / calibrate_count;
+
+	// Warm up the driver and any caches before measuring anything
+	for (int32_t i = 0; i < 5; i++) bench_frame(false);
+
+	// Per-call timings
+	memset(bench_calls, 0, sizeof(bench_calls));
+	bench_clock::time_point start = bench_clock::now();
+	for (int32_t i = 0; i < bench_frames; i++) bench_frame(true);
+	bench_frame_ms_timed = std::chrono::duration<double, std::milli>(bench_clock::now() - start).count() / bench_frames;
+
+	// Whole frame timings, without the per-call clock reads getting in the
+	// way.
+	skg_stats_reset();
+	start = bench_clock::now();
+	for (int32_t i = 0; i < bench_frames; i++) bench_frame(false);
+	bench_frame_ms_untimed = std::chrono::duration<double, std::milli>(bench_clock::now() - start).count() / bench_frames;
+	bench_stats = skg_stats_get();
+
+	bench_report();
+	bench_shutdown();
+	return 0;
+}
+
+///////////////////////////////////////////
+
+bool bench_init() {
+	if (skg_init("sk_gpu_bench", nullptr) <= 0) {
+		fprintf(stderr, "Failed to initialize sk_gpu!\n");
+		return false;
+	}
+
+	// Render into an offscreen target, so no window is needed
+	bench_target       = skg_tex_create(skg_tex_type_rendertarget, skg_use_static, skg_tex_fmt_rgba32_linear, skg_mip_none);
+	bench_target_depth = skg_tex_create(skg_tex_type_zbuffer,      skg_use_static, skg_tex_fmt_depth32,       skg_mip_none);
+	skg_tex_set_contents(&bench_target,       nullptr, 256, 256);
+	skg_tex_set_contents(&bench_target_depth, nullptr, 256, 256);
+	skg_tex_attach_depth(&bench_target, &bench_target_depth);
+
+	// Shader, with hand assembled metadata since this doesn't go through
+	// skshaderc.
+	bench_meta = {};
+	snprintf(bench_meta.name, sizeof(bench_meta.name), "bench");
+	bench_meta.buffer_count   = 1;
+	bench_meta.buffers        = (skg_shader_buffer_t  *)calloc(1, sizeof(skg_shader_buffer_t));
+	bench_meta.resource_count = 1;
+	bench_meta.resources      = (skg_shader_resource_t*)calloc(1, sizeof(skg_shader_resource_t));
+	snprintf(bench_meta.buffers[0].name, sizeof(bench_meta.buffers[0].name), "BenchBuffer");
+	bench_meta.buffers  [0].name_hash = skg_hash(bench_meta.buffers[0].name);
+	bench_meta.buffers  [0].bind      = { 0, skg_stage_vertex | skg_stage_pixel, skg_register_constant };
+	bench_meta.buffers  [0].size      = sizeof(bench_constants_t);
+	snprintf(bench_meta.resources[0].name, sizeof(bench_meta.resources[0].name), "tex");
+	bench_meta.resources[0].name_hash = skg_hash(bench_meta.resources[0].name);
+	bench_meta.resources[0].bind      = { 0, skg_stage_pixel, skg_register_resource };
+
+	skg_shader_stage_t v_stage = skg_shader_stage_create(bench_vs, strlen(bench_vs), skg_stage_vertex);
+	skg_shader_stage_t p_stage = skg_shader_stage_create(bench_ps, strlen(bench_ps), skg_stage_pixel);
+	bench_shader = skg_shader_create_manual(&bench_meta, v_stage, p_stage, {});
+	skg_shader_stage_destroy(&v_stage);
+	skg_shader_stage_destroy(&p_stage);
+	if (!skg_shader_is_valid(&bench_shader)) {
+		fprintf(stderr, "Failed to create the benchmark shader!\n");
+		return false;
+	}
+
+	// Pipelines with a spread of different states
+	for (int32_t i = 0; i < bench_pipeline_count; i++) {
+		bench_pipelines[i] = skg_pipeline_create(&bench_shader);
+		skg_pipeline_set_transparency(&bench_pipelines[i], (i & 1) ? skg_transparency_blend : skg_transparency_none);
+		skg_pipeline_set_cull        (&bench_pipelines[i], (i & 2) ? skg_cull_none         : skg_cull_back);
+		skg_pipeline_set_depth_write (&bench_pipelines[i], (i & 4) == 0);
+		skg_pipeline_set_depth_test  (&bench_pipelines[i], (i & 4) ? skg_depth_test_always : skg_depth_test_less);
+	}
+
+	// Small quad meshes, each in their own buffers
+	for (int32_t i = 0; i < bench_mesh_count; i++) {
+		float s = 0.5f + i * 0.05f;
+		skg_vert_t verts[] = {
+			{ {-s, s,0}, {0,0,1}, {0,1}, {255,255,255,255} },
+			{ { s, s,0}, {0,0,1}, {1,1}, {255,255,255,255} },
+			{ { s,-s,0}, {0,0,1}, {1,0}, {255,255,255,255} },
+			{ {-s,-s,0}, {0,0,1}, {0,0}, {255,255,255,255} } };
+		uint32_t inds[] = { 2,1,0, 3,2,0 };
+		bench_vbuffs[i] = skg_buffer_create(verts, 4, sizeof(skg_vert_t), skg_buffer_type_vertex, skg_use_static);
+		bench_ibuffs[i] = skg_buffer_create(inds,  6, sizeof(uint32_t  ), skg_buffer_type_index,  skg_use_static);
+		bench_meshes[i] = skg_mesh_create(&bench_vbuffs[i], &bench_ibuffs[i]);
+	}
+
+	// Tiny solid color textures
+	for (int32_t i = 0; i < bench_tex_count; i++) {
+		skg_color32_t colors[4*4];
+		for (int32_t c = 0; c < 4*4; c++) colors[c] = { (uint8_t)(i * 16), (uint8_t)(255 - i * 16), 128, 255 };
+		bench_textures[i] = skg_tex_create(skg_tex_type_image, skg_use_static, skg_tex_fmt_rgba32_linear, skg_mip_none);
+		skg_tex_set_contents(&bench_textures[i], colors, 4, 4);
+	}
+
+	bench_constants = skg_buffer_create(nullptr, 1, sizeof(bench_constants_t), skg_buffer_type_constant, skg_use_dynamic);
+	return true;
+}
+
+///////////////////////////////////////////
+
+void bench_shutdown() {
+	skg_tex_target_bind(nullptr, -1, 0);
+	skg_buffer_destroy(&bench_constants);
+	for (int32_t i = 0; i < bench_tex_count;      i++) skg_tex_destroy     (&bench_textures [i]);
+	for (int32_t i = 0; i < bench_mesh_count;     i++) {
+		skg_mesh_destroy  (&bench_meshes[i]);
+		skg_buffer_destroy(&bench_vbuffs[i]);
+		skg_buffer_destroy(&bench_ibuffs[i]);
+	}
+	for (int32_t i = 0; i < bench_pipeline_count; i++) skg_pipeline_destroy(&bench_pipelines[i]);
+	skg_shader_destroy(&bench_shader);
+	skg_tex_destroy(&bench_target);
+	skg_tex_destroy(&bench_target_depth);
+	skg_shutdown();
+}
+
+///////////////////////////////////////////
+
+#define BENCH_CALL(call_id, call) \
+	if (timed) { \
+		bench_clock::time_point _start = bench_clock::now(); \
+		call; \
+		bench_calls[call_id].ns    += std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - _start).count(); \
+		bench_calls[call_id].count += 1; \
+	} else { call; }
+
+void bench_frame(bool timed) {
+	skg_draw_begin();
+
+	float clear_color[4] = { 0,0,0,1 };
+	skg_tex_target_bind(&bench_target, -1, 0);
+	skg_target_clear(true, clear_color);
+
+	const skg_bind_t constant_bind = bench_meta.buffers  [0].bind;
+	const skg_bind_t tex_bind      = bench_meta.resources[0].bind;
+
+	// State changes at different rates, pipelines every 64 draws, textures
+	// every 4, meshes every 2, and constants on every draw.
+	bench_constants_t constants = {};
+	for (int32_t i = 0; i < bench_draws; i++) {
+		if (i % 64 == 0) { BENCH_CALL(bench_call_pipeline_bind, skg_pipeline_bind(&bench_pipelines[(i / 64) % bench_pipeline_count])) }
+		if (i % 4  == 0) { BENCH_CALL(bench_call_tex_bind,      skg_tex_bind     (&bench_textures [(i / 4 ) % bench_tex_count], tex_bind)) }
+		if (i % 2  == 0) { BENCH_CALL(bench_call_mesh_bind,     skg_mesh_bind    (&bench_meshes   [(i / 2 ) % bench_mesh_count])) }
+
+		constants.offset_scale[0] = ((i % 100) / 50.0f) - 1.0f;
+		constants.offset_scale[1] = ((i / 100) % 100 / 50.0f) - 1.0f;
+		constants.offset_scale[2] = 0.02f;
+		constants.offset_scale[3] = 0.02f;
+		constants.color[0] = constants.color[1] = constants.color[2] = constants.color[3] = 1;
+		BENCH_CALL(bench_call_buffer_set_contents, skg_buffer_set_contents(&bench_constants, &constants, sizeof(constants)))
+		BENCH_CALL(bench_call_buffer_bind,         skg_buffer_bind        (&bench_constants, constant_bind))
+		BENCH_CALL(bench_call_draw,                skg_draw               (0, 0, 6, 1))
+	}
+
+	skg_tex_target_bind(nullptr, -1, 0);
+}
+
+///////////////////////////////////////////
+
+void bench_report() {
+	printf("sk_gpu_bench: %s (%s), %d frames of %d draws\n", bench_backend, skg_adapter_name(), bench_frames, bench_draws);
+	printf("%-26s %12s %12s\n", "call", "count", "ns/call");
+	double ns_per_call[bench_call_max];
+	for (int32_t i = 0; i < bench_call_max; i++) {
+		ns_per_call[i] = bench_calls[i].count > 0
+			? (double)bench_calls[i].ns / bench_calls[i].count - bench_timer_overhead
+			: 0;
+		if (ns_per_call[i] < 0) ns_per_call[i] = 0;
+		printf("%-26s %12lld %12.1f\n", bench_call_names[i], (long long)bench_calls[i].count, ns_per_call[i]);
+	}
+	printf("frame ms (per-call timed): %.3f\n", bench_frame_ms_timed);
+	printf("frame ms (untimed):        %.3f\n", bench_frame_ms_untimed);
+	printf("clock overhead ns:         %.1f\n", bench_timer_overhead);
+
+	const char *stat_names[skg_stat_max] = { "program", "blend", "cull", "depth", "texture", "buffer", "layout", "sampler" };
+	printf("%-26s %12s %12s\n", "state cache", "hits/frame", "misses/frame");
+	for (int32_t i = 0; i < skg_stat_max; i++) {
+		printf("%-26s %12d %12d\n", stat_names[i], bench_stats.cache_hits[i] / bench_frames, bench_stats.cache_misses[i] / bench_frames);
+	}
+
+	if (bench_json == nullptr) return;
+	FILE *fp = fopen(bench_json, "w");
+	if (fp == nullptr) {
+		fprintf(stderr, "Couldn't open %s for writing!\n", bench_json);
+		return;
+	}
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"backend\": \"%s\",\n", bench_backend);
+	fprintf(fp, "\t\"frames\": %d,\n", bench_frames);
+	fprintf(fp, "\t\"draws_per_frame\": %d,\n", bench_draws);
+	fprintf(fp, "\t\"clock_overhead_ns\": %.2f,\n", bench_timer_overhead);
+	fprintf(fp, "\t\"frame_ms_timed\": %.4f,\n", bench_frame_ms_timed);
+	fprintf(fp, "\t\"frame_ms_untimed\": %.4f,\n", bench_frame_ms_untimed);
+	fprintf(fp, "\t\"calls\": {\n");
+	for (int32_t i = 0; i < bench_call_max; i++) {
+		fprintf(fp, "\t\t\"%s\": { \"count\": %lld, \"ns_per_call\": %.2f }%s\n",
+			bench_call_names[i], (long long)bench_calls[i].count, ns_per_call[i], i < bench_call_max-1 ? "," : "");
+	}
+	fprintf(fp, "\t},\n");
+	fprintf(fp, "\t\"state_cache_per_frame\": {\n");
+	for (int32_t i = 0; i < skg_stat_max; i++) {
+		fprintf(fp, "\t\t\"%s\": { \"hits\": %d, \"misses\": %d }%s\n",
+			stat_names[i], bench_stats.cache_hits[i] / bench_frames, bench_stats.cache_misses[i] / bench_frames, i < skg_stat_max-1 ? "," : "");
+	}
+	fprintf(fp, "\t}\n");
+	fprintf(fp, "}\n");
+	fclose(fp);
+}
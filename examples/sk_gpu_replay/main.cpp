@@ -0,0 +1,597 @@
+// skg_replay plays back a capture file written by skg_capture_start, as fast
+// as it can, and reports how long the frames in it took. Since it needs no
+// app, window or XR runtime, a heavy frame can be captured once and then
+// replayed in CI to catch CPU or driver-side throughput regressions.
+//
+// Resources the capture refers to but never created (ones made before the
+// capture started, or shaders made with skg_shader_create_manual) can't be
+// replayed, so calls that use them are skipped and counted.
+//
+// usage: skg_replay capture.skgc [--loops N] [--json report.json]
+
+#include "../../src/sk_gpu_dev.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+///////////////////////////////////////////
+
+#if   defined(SKG_NULL)
+const char *replay_backend = "null";
+#elif defined(SKG_OPENGL)
+const char *replay_backend = "opengl";
+#elif defined(SKG_DIRECT3D11)
+const char *replay_backend = "d3d11";
+#else
+const char *replay_backend = "unknown";
+#endif
+
+typedef std::chrono::steady_clock replay_clock;
+
+typedef struct replay_pipeline_t {
+	uint64_t       shader_id;
+	skg_pipeline_t pipeline;
+} replay_pipeline_t;
+
+const char   *replay_file    = nullptr;
+const char   *replay_json    = nullptr;
+int32_t       replay_loops   = 1;
+
+uint8_t      *replay_data    = nullptr;
+size_t        replay_size    = 0;
+
+std::unordered_map<uint64_t, skg_buffer_t>      replay_buffers;
+std::unordered_map<uint64_t, skg_tex_t>         replay_textures;
+std::unordered_map<uint64_t, skg_shader_t>      replay_shaders;
+std::unordered_map<uint64_t, replay_pipeline_t> replay_pipelines;
+std::map<std::pair<uint64_t, uint64_t>, skg_mesh_t> replay_meshes;
+
+std::vector<double> replay_frame_ms;
+std::vector<double> replay_gpu_ms;
+double              replay_setup_ms = 0;
+int64_t             replay_records  = 0;
+int64_t             replay_skipped  = 0;
+skg_stats_t         replay_stats    = {};
+
+///////////////////////////////////////////
+
+bool replay_load   ();
+bool replay_run    (bool record_frames);
+void replay_release();
+void replay_report ();
+
+///////////////////////////////////////////
+
+int main(int argc, char **argv) {
+	for (int32_t i = 1; i < argc; i++) {
+		if      (strcmp(argv[i], "--loops") == 0 && i+1 < argc) replay_loops = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--json" ) == 0 && i+1 < argc) replay_json  = argv[++i];
+		else if (argv[i][0] != '-' && replay_file == nullptr)   replay_file  = argv[i];
+		else {
+			replay_file = nullptr;
+			break;
+		}
+	}
+	if (replay_file == nullptr) {
+		printf("usage: %s capture.skgc [--loops N] [--json report.json]\n", argv[0]);
+		return 1;
+	}
+	if (replay_loops < 1) replay_loops = 1;
+
+	skg_callback_log([](skg_log_ level, const char *text) {
+		if (level != skg_log_info)
+			fprintf(stderr, "[%d] %s\n", level, text);
+	});
+	if (!replay_load())
+		return -1;
+	if (skg_init("skg_replay", nullptr) <= 0) {
+		fprintf(stderr, "Failed to initialize sk_gpu!\n");
+		return -1;
+	}
+
+	// When looping, the first pass just warms up the driver and any caches,
+	// and only the later passes get measured.
+	bool ok = true;
+	for (int32_t i = 0; ok && i < replay_loops; i++) {
+		bool record = replay_loops == 1 || i > 0;
+		if (record) skg_stats_reset();
+		ok = replay_run(record);
+		if (record) {
+			skg_stats_t stats = skg_stats_get();
+			for (int32_t s = 0; s < skg_stat_max; s++) {
+				replay_stats.cache_hits  [s] += stats.cache_hits  [s];
+				replay_stats.cache_misses[s] += stats.cache_misses[s];
+			}
+			replay_stats.draws        += stats.draws;
+			replay_stats.dispatches   += stats.dispatches;
+			replay_stats.upload_bytes += stats.upload_bytes;
+		}
+		replay_release();
+	}
+
+	// GPU timer results show up a few frames late, so give them a moment.
+	if (skg_capability(skg_cap_gpu_timer)) {
+		for (int32_t i = 0; i < 8; i++) skg_draw_begin();
+		skg_timer_result_t results[64];
+		int32_t            count;
+		while ((count = skg_timer_get_results(results, 64)) > 0) {
+			for (int32_t i = 0; i < count; i++) {
+				if (strcmp(results[i].name, "skg_replay_frame") == 0)
+					replay_gpu_ms.push_back(results[i].duration_ns / 1000000.0);
+			}
+		}
+	}
+
+	if (ok) replay_report();
+	skg_shutdown();
+	free(replay_data);
+	return ok ? 0 : -1;
+}
+
+///////////////////////////////////////////
+
+bool replay_load() {
+	void  *data = nullptr;
+	size_t size = 0;
+	if (!skg_read_file(replay_file, &data, &size)) {
+		fprintf(stderr, "Couldn't read %s!\n", replay_file);
+		return false;
+	}
+	replay_data = (uint8_t*)data;
+	replay_size = size;
+
+	skg_capture_header_t header = {};
+	if (replay_size >= sizeof(header)) memcpy(&header, replay_data, sizeof(header));
+	if (header.magic != SKG_CAPTURE_MAGIC) {
+		fprintf(stderr, "%s isn't an sk_gpu capture file!\n", replay_file);
+		return false;
+	}
+	if (header.version != SKG_CAPTURE_VERSION) {
+		fprintf(stderr, "%s is capture version %u, this replayer understands version %u.\n", replay_file, header.version, SKG_CAPTURE_VERSION);
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+void replay_release() {
+	skg_tex_target_bind(nullptr, -1, 0);
+	for (auto &it : replay_meshes   ) skg_mesh_destroy    (&it.second);
+	for (auto &it : replay_pipelines) skg_pipeline_destroy(&it.second.pipeline);
+	for (auto &it : replay_buffers  ) skg_buffer_destroy  (&it.second);
+	for (auto &it : replay_textures ) skg_tex_destroy     (&it.second);
+	for (auto &it : replay_shaders  ) skg_shader_destroy  (&it.second);
+	replay_meshes   .clear();
+	replay_pipelines.clear();
+	replay_buffers  .clear();
+	replay_textures .clear();
+	replay_shaders  .clear();
+}
+
+///////////////////////////////////////////
+
+template <typename T>
+T *replay_find(std::unordered_map<uint64_t, T> &map, uint64_t id) {
+	auto it = map.find(id);
+	if (it == map.end()) return nullptr;
+	return &it->second;
+}
+
+///////////////////////////////////////////
+
+// Meshes aren't captured as objects, just as the pair of buffers that got
+// bound, so they're made on demand here. They hold onto their buffers on
+// some backends, so they need to go when either buffer does.
+void replay_meshes_drop(uint64_t buffer_id) {
+	for (auto it = replay_meshes.begin(); it != replay_meshes.end(); ) {
+		if (it->first.first == buffer_id || it->first.second == buffer_id) {
+			skg_mesh_destroy(&it->second);
+			it = replay_meshes.erase(it);
+		} else it++;
+	}
+}
+
+///////////////////////////////////////////
+
+// Pipelines are captured as the state they had at bind time, so the
+// replayer keeps one pipeline per unique state.
+skg_pipeline_t *replay_pipeline(const skg_capture_pipeline_t *state) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < sizeof(*state); i++) {
+		hash = (hash ^ ((const uint8_t*)state)[i]) * 1099511628211ULL;
+	}
+	replay_pipeline_t *result = replay_find(replay_pipelines, hash);
+	if (result) return &result->pipeline;
+
+	skg_shader_t *shader = replay_find(replay_shaders, state->shader_id);
+	if (shader == nullptr) return nullptr;
+
+	replay_pipeline_t pipeline = {};
+	pipeline.shader_id = state->shader_id;
+	pipeline.pipeline  = skg_pipeline_create(shader);
+	skg_pipeline_set_transparency(&pipeline.pipeline, (skg_transparency_)state->transparency);
+	skg_pipeline_set_cull        (&pipeline.pipeline, (skg_cull_        )state->cull);
+	skg_pipeline_set_color_write (&pipeline.pipeline, (skg_color_write_ )state->color_write);
+	skg_pipeline_set_depth_test  (&pipeline.pipeline, (skg_depth_test_  )state->depth_test);
+	skg_pipeline_set_wireframe   (&pipeline.pipeline, state->wireframe   != 0);
+	skg_pipeline_set_depth_write (&pipeline.pipeline, state->depth_write != 0);
+	skg_pipeline_set_depth_clip  (&pipeline.pipeline, state->depth_clip  != 0);
+	skg_pipeline_set_scissor     (&pipeline.pipeline, state->scissor     != 0);
+	replay_pipelines[hash] = pipeline;
+	return &replay_pipelines[hash].pipeline;
+}
+
+///////////////////////////////////////////
+
+skg_bind_t replay_bind(const skg_capture_bind_t *bind) {
+	skg_bind_t result = {};
+	result.slot          = (uint16_t)bind->slot;
+	result.stage_bits    = (uint8_t )bind->stage_bits;
+	result.register_type = (uint8_t )bind->register_type;
+	return result;
+}
+
+///////////////////////////////////////////
+
+skg_bind_t replay_bind(const skg_capture_bind_range_t *bind) {
+	skg_bind_t result = {};
+	result.slot          = (uint16_t)bind->slot;
+	result.stage_bits    = (uint8_t )bind->stage_bits;
+	result.register_type = (uint8_t )bind->register_type;
+	return result;
+}
+
+///////////////////////////////////////////
+
+#define REPLAY_PAYLOAD(type, name) \
+	if (record.size < sizeof(type)) { fprintf(stderr, "Truncated record %u in capture!\n", record.op); return false; } \
+	const type *name = (const type *)payload; \
+	const uint8_t *data      = payload     + sizeof(type); \
+	size_t         data_size = record.size - sizeof(type); \
+	(void)data; (void)data_size;
+
+#define REPLAY_FIND(var, map, id) \
+	auto *var = replay_find(map, id); \
+	if (var == nullptr) { replay_skipped += 1; break; }
+
+bool replay_run(bool record_frames) {
+	replay_clock::time_point frame_start = replay_clock::now();
+	bool   in_frame = false;
+	bool   timing   = skg_capability(skg_cap_gpu_timer);
+	size_t at       = sizeof(skg_capture_header_t);
+
+	while (at + sizeof(skg_capture_record_t) <= replay_size) {
+		skg_capture_record_t record;
+		memcpy(&record, replay_data + at, sizeof(record));
+		at += sizeof(record);
+		if (at + record.size > replay_size) {
+			fprintf(stderr, "Capture file ends partway through a record, it may have been cut short.\n");
+			break;
+		}
+		// Records are 4 byte aligned at best, so copy the payload somewhere
+		// that the 8 byte ids inside it can be safely read from.
+		static std::vector<uint64_t> payload_mem;
+		payload_mem.resize(record.size / sizeof(uint64_t) + 1);
+		memcpy(payload_mem.data(), replay_data + at, record.size);
+		const uint8_t *payload = (const uint8_t *)payload_mem.data();
+		at += record.size;
+		replay_records += record_frames ? 1 : 0;
+
+		switch (record.op) {
+		case skg_capture_op_frame: {
+			if (timing && in_frame) skg_timer_end();
+			replay_clock::time_point now = replay_clock::now();
+			double ms = std::chrono::duration<double, std::milli>(now - frame_start).count();
+			if (record_frames) {
+				if (in_frame) replay_frame_ms.push_back(ms);
+				else          replay_setup_ms += ms;
+			}
+			frame_start = now;
+			in_frame    = true;
+			skg_draw_begin();
+			if (timing) skg_timer_begin("skg_replay_frame");
+		} break;
+		case skg_capture_op_draw: {
+			REPLAY_PAYLOAD(skg_capture_draw_t, draw);
+			skg_draw(draw->index_start, draw->index_base, draw->index_count, draw->instance_count);
+		} break;
+		case skg_capture_op_draw_indirect: {
+			REPLAY_PAYLOAD(skg_capture_draw_indirect_t, draw);
+			REPLAY_FIND(buffer, replay_buffers, draw->id);
+			skg_draw_indirect(buffer, draw->offset, draw->draw_count, draw->stride);
+		} break;
+		case skg_capture_op_draw_multi: {
+			REPLAY_PAYLOAD(skg_capture_draw_multi_t, draw);
+			if (data_size < sizeof(skg_draw_args_t) * draw->draw_count) { fprintf(stderr, "Truncated record %u in capture!\n", record.op); return false; }
+			skg_draw_multi((const skg_draw_args_t*)data, draw->draw_count);
+		} break;
+		case skg_capture_op_compute: {
+			REPLAY_PAYLOAD(skg_capture_compute_t, compute);
+			skg_compute(compute->thread_count[0], compute->thread_count[1], compute->thread_count[2]);
+		} break;
+		case skg_capture_op_viewport: {
+			REPLAY_PAYLOAD(skg_capture_rect_t, rect);
+			skg_viewport(rect->xywh);
+		} break;
+		case skg_capture_op_scissor: {
+			REPLAY_PAYLOAD(skg_capture_rect_t, rect);
+			skg_scissor(rect->xywh);
+		} break;
+		case skg_capture_op_target_clear: {
+			REPLAY_PAYLOAD(skg_capture_clear_t, clear);
+			skg_target_clear(clear->depth != 0, clear->has_color ? clear->color : nullptr);
+		} break;
+		case skg_capture_op_event_begin: {
+			char name[128];
+			size_t len = record.size < sizeof(name) - 1 ? record.size : sizeof(name) - 1;
+			memcpy(name, payload, len);
+			name[len] = '\0';
+			skg_event_begin(name);
+		} break;
+		case skg_capture_op_event_end: skg_event_end(); break;
+
+		case skg_capture_op_buffer_create: {
+			REPLAY_PAYLOAD(skg_capture_buffer_t, create);
+			skg_buffer_t *existing = replay_find(replay_buffers, create->id);
+			if (existing) {
+				replay_meshes_drop(create->id);
+				skg_buffer_destroy(existing);
+			}
+			replay_buffers[create->id] = skg_buffer_create(create->has_data ? data : nullptr, create->size_count, create->size_stride, (skg_buffer_type_)create->type, (skg_use_)create->use);
+		} break;
+		case skg_capture_op_buffer_set_contents: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			REPLAY_FIND(buffer, replay_buffers, id->id);
+			skg_buffer_set_contents(buffer, data, (uint32_t)data_size);
+		} break;
+		case skg_capture_op_buffer_set_range: {
+			REPLAY_PAYLOAD(skg_capture_buffer_range_t, range);
+			REPLAY_FIND(buffer, replay_buffers, range->id);
+			skg_buffer_set_contents_range(buffer, range->offset, data, (uint32_t)data_size);
+		} break;
+		case skg_capture_op_buffer_bind: {
+			REPLAY_PAYLOAD(skg_capture_bind_t, bind);
+			REPLAY_FIND(buffer, replay_buffers, bind->id);
+			skg_buffer_bind(buffer, replay_bind(bind));
+		} break;
+		case skg_capture_op_buffer_bind_range: {
+			REPLAY_PAYLOAD(skg_capture_bind_range_t, bind);
+			REPLAY_FIND(buffer, replay_buffers, bind->id);
+			skg_buffer_bind_range(buffer, replay_bind(bind), bind->offset, bind->size);
+		} break;
+		case skg_capture_op_transient_bind: {
+			REPLAY_PAYLOAD(skg_capture_bind_range_t, bind);
+			skg_transient_bind(data, (uint32_t)data_size, replay_bind(bind));
+		} break;
+		case skg_capture_op_buffer_clear: {
+			REPLAY_PAYLOAD(skg_capture_bind_t, bind);
+			skg_buffer_clear(replay_bind(bind));
+		} break;
+		case skg_capture_op_buffer_destroy: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			REPLAY_FIND(buffer, replay_buffers, id->id);
+			replay_meshes_drop(id->id);
+			skg_buffer_destroy(buffer);
+			replay_buffers.erase(id->id);
+		} break;
+		case skg_capture_op_mesh_bind: {
+			REPLAY_PAYLOAD(skg_capture_mesh_t, mesh);
+			std::pair<uint64_t, uint64_t> key = { mesh->vert_id, mesh->ind_id };
+			auto it = replay_meshes.find(key);
+			if (it == replay_meshes.end()) {
+				skg_buffer_t *vert = replay_find(replay_buffers, mesh->vert_id);
+				skg_buffer_t *ind  = replay_find(replay_buffers, mesh->ind_id);
+				if ((mesh->vert_id && !vert) || (mesh->ind_id && !ind)) { replay_skipped += 1; break; }
+				it = replay_meshes.insert({ key, skg_mesh_create(vert, ind) }).first;
+			}
+			// Any trailing data is the mesh's vertex format. Different meshes
+			// can share the same buffers with different formats, so apply it
+			// on every bind rather than only when the cache entry is made.
+			if (data_size >= sizeof(skg_vert_component_t))
+				skg_mesh_set_format(&it->second, (const skg_vert_component_t *)data, (int32_t)(data_size / sizeof(skg_vert_component_t)));
+			skg_mesh_bind(&it->second);
+		} break;
+
+		case skg_capture_op_shader_create: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			skg_shader_t *existing = replay_find(replay_shaders, id->id);
+			if (existing) skg_shader_destroy(existing);
+			replay_shaders[id->id] = skg_shader_create_memory(data, data_size);
+		} break;
+		case skg_capture_op_shader_compute_bind: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			if (id->id == 0) { skg_shader_compute_bind(nullptr); break; }
+			REPLAY_FIND(shader, replay_shaders, id->id);
+			skg_shader_compute_bind(shader);
+		} break;
+		case skg_capture_op_shader_destroy: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			REPLAY_FIND(shader, replay_shaders, id->id);
+			for (auto it = replay_pipelines.begin(); it != replay_pipelines.end(); ) {
+				if (it->second.shader_id == id->id) {
+					skg_pipeline_destroy(&it->second.pipeline);
+					it = replay_pipelines.erase(it);
+				} else it++;
+			}
+			skg_shader_destroy(shader);
+			replay_shaders.erase(id->id);
+		} break;
+		case skg_capture_op_pipeline_bind: {
+			REPLAY_PAYLOAD(skg_capture_pipeline_t, state);
+			skg_pipeline_t *pipeline = replay_pipeline(state);
+			if (pipeline == nullptr) { replay_skipped += 1; break; }
+			skg_pipeline_bind(pipeline);
+		} break;
+
+		case skg_capture_op_tex_create: {
+			REPLAY_PAYLOAD(skg_capture_tex_t, create);
+			skg_tex_t *existing = replay_find(replay_textures, create->id);
+			if (existing) skg_tex_destroy(existing);
+			replay_textures[create->id] = skg_tex_create((skg_tex_type_)create->type, (skg_use_)create->use, (skg_tex_fmt_)create->format, (skg_mip_)create->mips);
+		} break;
+		case skg_capture_op_tex_create_existing: {
+			// The native texture is long gone, so a regular texture of the
+			// same shape stands in for it.
+			REPLAY_PAYLOAD(skg_capture_tex_t, create);
+			skg_tex_t *existing = replay_find(replay_textures, create->id);
+			if (existing) skg_tex_destroy(existing);
+			skg_tex_t tex = skg_tex_create((skg_tex_type_)create->type, skg_use_static, (skg_tex_fmt_)create->format, skg_mip_none);
+			skg_tex_set_contents_arr(&tex, nullptr, create->array_count, 1, create->width, create->height, create->multisample);
+			replay_textures[create->id] = tex;
+		} break;
+		case skg_capture_op_tex_settings: {
+			REPLAY_PAYLOAD(skg_capture_tex_settings_t, settings);
+			REPLAY_FIND(tex, replay_textures, settings->id);
+			skg_tex_settings(tex, (skg_tex_address_)settings->address, (skg_tex_sample_)settings->sample, (skg_sample_compare_)settings->compare, settings->anisotropy);
+		} break;
+		case skg_capture_op_tex_set_contents: {
+			REPLAY_PAYLOAD(skg_capture_tex_contents_t, contents);
+			REPLAY_FIND(tex, replay_textures, contents->id);
+			if (!contents->has_data) {
+				skg_tex_set_contents_arr(tex, nullptr, contents->array_count, contents->mip_count, contents->width, contents->height, contents->multisample);
+				break;
+			}
+			std::vector<const void*> arrays(contents->array_count);
+			size_t array_size = contents->array_count > 0 ? data_size / contents->array_count : 0;
+			for (int32_t i = 0; i < contents->array_count; i++) arrays[i] = data + i * array_size;
+			skg_tex_set_contents_arr(tex, arrays.data(), contents->array_count, contents->mip_count, contents->width, contents->height, contents->multisample);
+		} break;
+		case skg_capture_op_tex_attach_depth: {
+			REPLAY_PAYLOAD(skg_capture_tex_pair_t, pair);
+			REPLAY_FIND(tex,   replay_textures, pair->id);
+			REPLAY_FIND(depth, replay_textures, pair->other_id);
+			skg_tex_attach_depth(tex, depth);
+		} break;
+		case skg_capture_op_tex_copy_to: {
+			REPLAY_PAYLOAD(skg_capture_tex_pair_t, pair);
+			REPLAY_FIND(tex,  replay_textures, pair->id);
+			REPLAY_FIND(dest, replay_textures, pair->other_id);
+			skg_tex_copy_to(tex, pair->surface, dest, pair->other_surface);
+		} break;
+		case skg_capture_op_tex_gen_mips: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			REPLAY_FIND(tex, replay_textures, id->id);
+			skg_tex_gen_mips(tex);
+		} break;
+		case skg_capture_op_tex_bind: {
+			REPLAY_PAYLOAD(skg_capture_bind_t, bind);
+			REPLAY_FIND(tex, replay_textures, bind->id);
+			skg_tex_bind(tex, replay_bind(bind));
+		} break;
+		case skg_capture_op_tex_clear: {
+			REPLAY_PAYLOAD(skg_capture_bind_t, bind);
+			skg_tex_clear(replay_bind(bind));
+		} break;
+		case skg_capture_op_tex_target_bind: {
+			REPLAY_PAYLOAD(skg_capture_target_t, target);
+			if (target->id == 0) { skg_tex_target_bind(nullptr, target->layer_idx, target->mip_level); break; }
+			REPLAY_FIND(tex, replay_textures, target->id);
+			skg_tex_target_bind(tex, target->layer_idx, target->mip_level);
+		} break;
+		case skg_capture_op_tex_target_discard: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			REPLAY_FIND(tex, replay_textures, id->id);
+			skg_tex_target_discard(tex);
+		} break;
+		case skg_capture_op_tex_destroy: {
+			REPLAY_PAYLOAD(skg_capture_id_t, id);
+			REPLAY_FIND(tex, replay_textures, id->id);
+			skg_tex_destroy(tex);
+			replay_textures.erase(id->id);
+		} break;
+		default: replay_skipped += record_frames ? 1 : 0; break;
+		}
+	}
+
+	if (timing && in_frame) skg_timer_end();
+	if (record_frames && in_frame) {
+		replay_frame_ms.push_back(std::chrono::duration<double, std::milli>(replay_clock::now() - frame_start).count());
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+void replay_report() {
+	int32_t frames = (int32_t)replay_frame_ms.size();
+	double  avg = 0, min = 0, max = 0, median = 0;
+	if (frames > 0) {
+		std::vector<double> sorted = replay_frame_ms;
+		std::sort(sorted.begin(), sorted.end());
+		for (double ms : sorted) avg += ms;
+		avg   /= frames;
+		min    = sorted.front();
+		max    = sorted.back();
+		median = sorted[frames / 2];
+	}
+	double gpu_avg = 0;
+	for (double ms : replay_gpu_ms) gpu_avg += ms;
+	if (!replay_gpu_ms.empty()) gpu_avg /= replay_gpu_ms.size();
+	int32_t per = frames > 0 ? frames : 1;
+
+	printf("skg_replay: %s (%s), %s\n", replay_backend, skg_adapter_name(), replay_file);
+	printf("records:                   %lld (%lld skipped)\n", (long long)replay_records, (long long)replay_skipped);
+	printf("setup ms:                  %.3f\n", replay_setup_ms);
+	printf("frames:                    %d\n", frames);
+	printf("frame ms avg/median:       %.3f / %.3f\n", avg, median);
+	printf("frame ms min/max:          %.3f / %.3f\n", min, max);
+	if (!replay_gpu_ms.empty())
+		printf("gpu frame ms avg:          %.3f\n", gpu_avg);
+	printf("draws/frame:               %d\n", replay_stats.draws / per);
+
+	const char *stat_names[skg_stat_max] = { "program", "blend", "cull", "depth", "texture", "buffer", "layout", "sampler" };
+	printf("%-26s %12s %12s\n", "state cache", "hits/frame", "misses/frame");
+	for (int32_t i = 0; i < skg_stat_max; i++) {
+		printf("%-26s %12d %12d\n", stat_names[i], replay_stats.cache_hits[i] / per, replay_stats.cache_misses[i] / per);
+	}
+
+	skg_mem_stats_t mem = skg_mem_get();
+	const char *mem_names[skg_mem_max] = { "buffer", "tex_image", "tex_rendertarget", "tex_depth", "msaa", "framebuffer" };
+	printf("%-26s %12s\n", "memory", "peak KB");
+	for (int32_t i = 0; i < skg_mem_max; i++) {
+		printf("%-26s %12lld\n", mem_names[i], (long long)(mem.peak_bytes[i] / 1024));
+	}
+	printf("%-26s %12lld\n", "total", (long long)(mem.total_peak_bytes / 1024));
+
+	if (replay_json == nullptr) return;
+	FILE *fp = fopen(replay_json, "w");
+	if (fp == nullptr) {
+		fprintf(stderr, "Couldn't open %s for writing!\n", replay_json);
+		return;
+	}
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"backend\": \"%s\",\n", replay_backend);
+	fprintf(fp, "\t\"records\": %lld,\n", (long long)replay_records);
+	fprintf(fp, "\t\"skipped\": %lld,\n", (long long)replay_skipped);
+	fprintf(fp, "\t\"setup_ms\": %.4f,\n", replay_setup_ms);
+	fprintf(fp, "\t\"frames\": %d,\n", frames);
+	fprintf(fp, "\t\"frame_ms_avg\": %.4f,\n", avg);
+	fprintf(fp, "\t\"frame_ms_median\": %.4f,\n", median);
+	fprintf(fp, "\t\"frame_ms_min\": %.4f,\n", min);
+	fprintf(fp, "\t\"frame_ms_max\": %.4f,\n", max);
+	if (!replay_gpu_ms.empty())
+		fprintf(fp, "\t\"gpu_frame_ms_avg\": %.4f,\n", gpu_avg);
+	fprintf(fp, "\t\"draws_per_frame\": %d,\n", replay_stats.draws / per);
+	fprintf(fp, "\t\"state_cache_per_frame\": {\n");
+	for (int32_t i = 0; i < skg_stat_max; i++) {
+		fprintf(fp, "\t\t\"%s\": { \"hits\": %d, \"misses\": %d }%s\n",
+			stat_names[i], replay_stats.cache_hits[i] / per, replay_stats.cache_misses[i] / per, i < skg_stat_max-1 ? "," : "");
+	}
+	fprintf(fp, "\t},\n");
+	fprintf(fp, "\t\"memory_peak_bytes\": {\n");
+	for (int32_t i = 0; i < skg_mem_max; i++) {
+		fprintf(fp, "\t\t\"%s\": %lld,\n", mem_names[i], (long long)mem.peak_bytes[i]);
+	}
+	fprintf(fp, "\t\t\"total\": %lld\n", (long long)mem.total_peak_bytes);
+	fprintf(fp, "\t}\n");
+	fprintf(fp, "}\n");
+	fclose(fp);
+}
@@ -31,6 +31,29 @@ sk_gpu.h
 // optimization for clearer debug information.
 //#define SKG_GL_EXPLICIT_STATE
 
+// On Linux, sk_gpu uses desktop GL through GLX by default. Define this to use
+// GLES through EGL instead. With EGL, if the DISPLAY environment variable is
+// empty, sk_gpu runs headless and never touches an X server: it renders on
+// the first EGL device that initializes (EGL_EXT_platform_device), or through
+// EGL_MESA_platform_surfaceless. Headless apps render into skg_tex_t render
+// targets, and skg_swapchain_create accepts a null window to make an
+// offscreen pbuffer swapchain of the requested size.
+//#define SKG_LINUX_EGL
+
+// sk_gpu can record a CPU trace of every skg_ call, along with the backend
+// work hiding inside them like shader compiles and texture uploads. Define
+// this, then use skg_trace_start/skg_trace_stop to write a Chrome trace-event
+// JSON file that can be opened in Perfetto or chrome://tracing.
+//#define SKG_TRACE
+
+// sk_gpu can also capture the stream of skg_ calls, along with the data that
+// goes with them, to a compact binary file. Define this, then use
+// skg_capture_start/skg_capture_stop around the frames you want. The
+// sk_gpu_replay example can play these files back against any backend. Only
+// resources created while the capture is running make it into the file, so
+// start capturing before loading the assets your frames need.
+//#define SKG_CAPTURE
+
 #if   defined( SKG_FORCE_NULL )
 #define SKG_NULL
 #elif defined( SKG_FORCE_DIRECT3D11 )
@@ -94,6 +117,7 @@ typedef enum skg_buffer_type_ {
 	skg_buffer_type_index,
 	skg_buffer_type_constant,
 	skg_buffer_type_compute,
+	skg_buffer_type_indirect,
 } skg_buffer_type_;
 
 typedef enum skg_tex_type_ {
@@ -284,9 +308,37 @@ typedef enum skg_cap_ {
 	skg_cap_fmt_atc,
 	skg_cap_multiview,
 	skg_cap_multiview_tiled_multisample,
+	skg_cap_gpu_timer,
 	skg_cap_max,
 } skg_cap_;
 
+// Categories of GPU state that the backends track for skg_stats_t's cache
+// hit/miss counters. Backends without a state cache report every change as
+// a miss.
+typedef enum skg_stat_ {
+	skg_stat_program,
+	skg_stat_blend,   // Transparency and color write mask
+	skg_stat_cull,    // Cull mode, plus scissor and wireframe
+	skg_stat_depth,   // Depth test, write, and clip
+	skg_stat_texture,
+	skg_stat_buffer,
+	skg_stat_layout,  // Vertex array objects, or input layouts
+	skg_stat_sampler,
+	skg_stat_max,
+} skg_stat_;
+
+// Categories of GPU memory that skg_mem_get tracks. Each allocation only
+// counts towards one category, so they add up to the total.
+typedef enum skg_mem_ {
+	skg_mem_buffer,
+	skg_mem_tex_image,
+	skg_mem_tex_rendertarget,
+	skg_mem_tex_depth,       // Both zbuffer and depthtarget textures
+	skg_mem_msaa,            // Multisample textures, counting every sample
+	skg_mem_framebuffer,     // Implicit multisample surfaces behind tiled MSAA framebuffer layers
+	skg_mem_max,
+} skg_mem_;
+
 typedef struct {
 	uint8_t r, g, b, a;
 } skg_color32_t;
@@ -341,6 +393,17 @@ typedef struct skg_vert_t {
 	skg_color32_t col;
 } skg_vert_t;
 
+// Laid out to match both GL's DrawElementsIndirectCommand and D3D11's
+// DrawIndexedInstancedIndirect args, so compute shaders can write these
+// straight into a skg_buffer_type_indirect buffer.
+typedef struct skg_draw_args_t {
+	uint32_t index_count;
+	uint32_t instance_count;
+	uint32_t index_start;
+	int32_t  index_base;
+	uint32_t instance_start;
+} skg_draw_args_t;
+
 typedef struct skg_bind_t {
 	uint16_t slot;
 	uint8_t  stage_bits;
@@ -381,6 +444,35 @@ typedef struct skg_shader_ops_t {
 	int32_t dynamic_flow;
 } skg_shader_ops_t;
 
+typedef struct skg_stats_t {
+	int32_t cache_hits  [skg_stat_max];
+	int32_t cache_misses[skg_stat_max];
+	int32_t draws;
+	int32_t dispatches;
+	int64_t upload_bytes;
+} skg_stats_t;
+
+typedef struct skg_mem_stats_t {
+	int64_t bytes      [skg_mem_max];
+	int64_t peak_bytes [skg_mem_max];
+	int32_t allocations[skg_mem_max];
+	int64_t total_bytes;
+	int64_t total_peak_bytes;
+} skg_mem_stats_t;
+
+typedef struct skg_mem_allocation_t {
+	char     name[32];
+	skg_mem_ type;
+	int64_t  bytes;
+} skg_mem_allocation_t;
+
+typedef struct skg_timer_result_t {
+	char     name[32];
+	int32_t  depth;
+	uint64_t frame;
+	uint64_t duration_ns;
+} skg_timer_result_t;
+
 typedef struct skg_shader_meta_t {
 	char                   name[256];
 	uint32_t               buffer_count;
@@ -428,6 +520,8 @@ typedef struct skg_buffer_t {
 	ID3D11Buffer    *_buffer;
 	ID3D11ShaderResourceView  *_resource;
 	ID3D11UnorderedAccessView *_unordered;
+	struct d3d_buffer_dirty_t *_dirty;
+	skg_ind_fmt_               _ind_format;
 } skg_buffer_t;
 
 typedef struct skg_computebuffer_t {
@@ -440,6 +534,8 @@ typedef struct skg_computebuffer_t {
 typedef struct skg_mesh_t {
 	ID3D11Buffer* _ind_buffer;
 	ID3D11Buffer* _vert_buffer;
+	skg_ind_fmt_  _ind_format;
+	int32_t       _vert_fmt;
 } skg_mesh_t;
 
 typedef struct skg_shader_stage_t {
@@ -484,6 +580,7 @@ typedef struct skg_tex_t {
 	skg_tex_type_              type;
 	skg_tex_fmt_               format;
 	skg_mip_                   mips;
+	uint32_t                   _id;
 	ID3D11Texture2D           *_texture;
 	ID3D11SamplerState        *_sampler;
 	ID3D11ShaderResourceView  *_resource;
@@ -494,6 +591,17 @@ typedef struct skg_tex_t {
 	ID3D11DepthStencilView   **_depth_array_view;
 } skg_tex_t;
 
+typedef struct skg_readback_t {
+	int32_t          width;
+	int32_t          height;
+	skg_tex_fmt_     format;
+	size_t           size;
+	ID3D11Resource  *_staging;
+	ID3D11Query     *_query;
+	void            *_data;
+	bool             _copied;
+} skg_readback_t;
+
 typedef struct skg_swapchain_t {
 	int32_t          width;
 	int32_t          height;
@@ -525,17 +633,23 @@ typedef struct skg_buffer_t {
 	uint32_t         stride;
 	uint32_t         _target;
 	uint32_t         _buffer;
+	uint32_t         _size;
+	struct gl_buffer_dirty_t *_dirty;
+	skg_ind_fmt_     _ind_format;
 } skg_buffer_t;
 
 typedef struct skg_mesh_t {
-	uint32_t _ind_buffer;
-	uint32_t _vert_buffer;
-	uint32_t _layout;
+	uint32_t            _ind_buffer;
+	uint32_t            _vert_buffer;
+	struct gl_layout_t *_layout;
+	skg_ind_fmt_        _ind_format;
+	int32_t             _vert_fmt;
 } skg_mesh_t;
 
 typedef struct skg_shader_stage_t {
 	skg_stage_ type;
 	uint32_t   _shader;
+	char      *_source;
 } skg_shader_stage_t;
 
 typedef struct skg_shader_t {
@@ -544,6 +658,7 @@ typedef struct skg_shader_t {
 	uint32_t           _pixel;
 	uint32_t           _program;
 	uint32_t           _compute;
+	uint64_t           _inputs;
 } skg_shader_t;
 
 typedef struct skg_pipeline_t {
@@ -579,8 +694,20 @@ typedef struct skg_tex_t {
 	skg_tex_sample_     _sample;
 	skg_sample_compare_ _compare;
 	int32_t             _anisotropy;
+	uint32_t            _sampler;
+	bool                _view;
 } skg_tex_t;
 
+typedef struct skg_readback_t {
+	int32_t       width;
+	int32_t       height;
+	skg_tex_fmt_  format;
+	size_t        size;
+	uint32_t      _buffer;
+	void         *_fence;
+	void         *_data;
+} skg_readback_t;
+
 typedef struct skg_swapchain_t {
 	int32_t  width;
 	int32_t  height;
@@ -590,6 +717,7 @@ typedef struct skg_swapchain_t {
 	void *_hwnd;
 #elif defined(_SKG_GL_LOAD_EGL)
 	void *_egl_surface;
+	bool  _egl_pbuffer;
 #elif defined(_SKG_GL_LOAD_GLX)
 	void *_x_window;
 #elif defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
@@ -623,12 +751,49 @@ typedef struct skg_platform_data_t {
 #elif defined(SKG_NULL)
 
 
+///////////////////////////////////////////
+
+// The null backend does no rendering at all, it just keeps CPU-side records
+// of the resources it's been handed, and counts the calls made into it. This
+// makes it handy for headless CI, and for measuring the CPU cost of an app's
+// own render loop without any driver noise.
+
+typedef struct skg_null_calls_t {
+	int32_t draws;
+	int32_t draw_instances;
+	int32_t draw_indices;
+	int32_t computes;
+	int32_t pipeline_binds;
+	int32_t mesh_binds;
+	int32_t tex_binds;
+	int32_t buffer_binds;
+	int32_t target_binds;
+	int32_t target_clears;
+	int32_t buffer_uploads;
+	int32_t tex_uploads;
+	int64_t upload_bytes;
+} skg_null_calls_t;
+
+typedef struct skg_null_live_t {
+	int32_t buffers;
+	int32_t meshes;
+	int32_t shaders;
+	int32_t pipelines;
+	int32_t textures;
+	int64_t buffer_bytes;
+	int64_t tex_bytes;
+} skg_null_live_t;
+
 ///////////////////////////////////////////
 
 typedef struct skg_buffer_t {
 	skg_use_           use;
 	skg_buffer_type_   type;
 	uint32_t           stride;
+	uint32_t           _id;
+	uint32_t           _size;
+	void              *_data;
+	skg_ind_fmt_       _ind_format;
 } skg_buffer_t;
 
 typedef struct skg_computebuffer_t {
@@ -637,14 +802,21 @@ typedef struct skg_computebuffer_t {
 } skg_computebuffer_t;
 
 typedef struct skg_mesh_t {
+	uint32_t           _id;
+	uint32_t           _vert_buffer;
+	uint32_t           _ind_buffer;
+	skg_ind_fmt_       _ind_format;
+	int32_t            _vert_fmt;
 } skg_mesh_t;
 
 typedef struct skg_shader_stage_t {
 	skg_stage_         type;
+	uint32_t           _id;
 } skg_shader_stage_t;
 
 typedef struct skg_shader_t {
 	skg_shader_meta_t* meta;
+	uint32_t           _id;
 } skg_shader_t;
 
 typedef struct skg_pipeline_t {
@@ -652,9 +824,13 @@ typedef struct skg_pipeline_t {
 	skg_cull_          cull;
 	bool               wireframe;
 	bool               depth_write;
+	bool               depth_clip;
+	skg_color_write_   color_write;
 	bool               scissor;
 	skg_depth_test_    depth_test;
 	skg_shader_meta_t* meta;
+	uint32_t           _id;
+	uint32_t           _shader;
 } skg_pipeline_t;
 
 typedef struct skg_tex_t {
@@ -667,14 +843,34 @@ typedef struct skg_tex_t {
 	skg_tex_type_      type;
 	skg_tex_fmt_       format;
 	skg_mip_           mips;
+	uint32_t           _id;
+	uint32_t           _depth;
+	int32_t            _mip_count;
+	size_t             _data_size;
+	void              *_data;
+	skg_tex_address_    _address;
+	skg_tex_sample_     _sample;
+	skg_sample_compare_ _compare;
+	int32_t             _anisotropy;
 } skg_tex_t;
 
+typedef struct skg_readback_t {
+	int32_t            width;
+	int32_t            height;
+	skg_tex_fmt_       format;
+	size_t             size;
+	void              *_data;
+} skg_readback_t;
+
 typedef struct skg_swapchain_t {
 	int32_t            width;
 	int32_t            height;
 } skg_swapchain_t;
 
 typedef struct skg_platform_data_t {
+	const skg_null_calls_t *_calls_last_frame;
+	const skg_null_calls_t *_calls_this_frame;
+	const skg_null_live_t  *_live;
 } skg_platform_data_t;
 
 #endif
@@ -687,14 +883,64 @@ SKG_API const char*         skg_adapter_name             ();
 SKG_API void                skg_shutdown                 ();
 SKG_API void                skg_callback_log             (void (*callback)(skg_log_ level, const char *text));
 SKG_API void                skg_callback_file_read       (bool (*callback)(const char *filename, void **out_data, size_t *out_size));
+SKG_API void                skg_callback_file_write      (bool (*callback)(const char *filename, const void *data, size_t size));
 SKG_API skg_platform_data_t skg_get_platform_data        ();
 SKG_API bool                skg_capability               (skg_cap_ capability);
+// Wrap buffer and texture creation on a worker thread with these. On GL
+// they make a shared context current, and end waits for the GPU to finish
+// the uploads before the resources go back to the render thread. One worker
+// holds the context at a time. Meshes, render targets, and updates to
+// dynamic buffers still need the render thread. Returns false if this
+// thread can't upload.
+SKG_API bool                skg_upload_thread_begin      ();
+SKG_API void                skg_upload_thread_end        ();
+// With deferred destruction on, skg_buffer_destroy, skg_tex_destroy and
+// skg_shader_destroy can be called from any thread, and the GPU objects are
+// released on a later skg_draw_begin, once the GPU has finished the frame
+// they were destroyed in. Off by default.
+SKG_API void                skg_deferred_destroy_enable  (bool enabled);
+// Stats accumulate until skg_stats_reset is called, so call it once a frame
+// for per-frame numbers.
+SKG_API skg_stats_t         skg_stats_get                ();
+SKG_API void                skg_stats_reset              ();
+// Memory is estimated from the size and format of each resource sk_gpu
+// allocates, textures made from native handles aren't counted. Peaks are
+// high-water marks since init, or since the last skg_mem_reset_peaks.
+// skg_mem_get_allocations fills out_allocations largest first, named with
+// skg_buffer_name or skg_tex_name, and returns how many it wrote. Pass
+// nullptr to get the total number of live allocations.
+SKG_API skg_mem_stats_t     skg_mem_get                  ();
+SKG_API void                skg_mem_reset_peaks          ();
+SKG_API int32_t             skg_mem_get_allocations      (skg_mem_allocation_t *out_allocations, int32_t max_allocations);
 
 SKG_API void                skg_event_begin              (const char *name);
 SKG_API void                skg_event_end                ();
+// GPU timers nest, and their results show up in skg_timer_get_results a few
+// frames after they're recorded, once the GPU has caught up. Reading them
+// never waits on the GPU. Check skg_cap_gpu_timer for support.
+SKG_API void                skg_timer_begin              (const char *name);
+SKG_API void                skg_timer_end                ();
+SKG_API int32_t             skg_timer_get_results        (skg_timer_result_t *out_results, int32_t max_results);
+// Requires SKG_TRACE, see the top of this file.
+SKG_API bool                skg_trace_start              (const char *filename);
+SKG_API void                skg_trace_stop               ();
+// Requires SKG_CAPTURE, see the top of this file.
+SKG_API bool                skg_capture_start            (const char *filename);
+SKG_API void                skg_capture_stop             ();
 
 SKG_API void                skg_draw_begin               ();
 SKG_API void                skg_draw                     (int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count);
+// Draws the bound mesh once for each skg_draw_args_t in a
+// skg_buffer_type_indirect buffer, starting offset bytes in. A stride of 0
+// means tightly packed, and offset and stride must be multiples of 4. Args
+// written by skg_compute are picked up without any extra sync. Where the GPU
+// can't draw indirectly (WebGL, GLES 3.0), the args are read back and looped
+// on the CPU, which stalls.
+SKG_API void                skg_draw_indirect            (const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride);
+// Submits a list of draws for the bound mesh as one call where the API
+// allows it, and as a CPU loop otherwise. instance_start is ignored by the
+// CPU loop on GL.
+SKG_API void                skg_draw_multi               (const skg_draw_args_t *draws, uint32_t draw_count);
 SKG_API void                skg_compute                  (uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z);
 SKG_API void                skg_viewport                 (const int32_t *xywh);
 SKG_API void                skg_viewport_get             (int32_t *out_xywh);
@@ -705,8 +951,28 @@ SKG_API skg_buffer_t        skg_buffer_create            (const void *data, uint
 SKG_API void                skg_buffer_name              (      skg_buffer_t *buffer, const char* name);
 SKG_API bool                skg_buffer_is_valid          (const skg_buffer_t *buffer);
 SKG_API void                skg_buffer_set_contents      (      skg_buffer_t *buffer, const void *data, uint32_t size_bytes);
+// Writes part of a dynamic buffer. Writes are batched rather than sent right
+// away, and go up by the next draw or dispatch, whether or not the buffer is
+// already bound. Many small writes between draws cost only one upload per
+// contiguous run of changed bytes.
+SKG_API void                skg_buffer_set_contents_range(      skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes);
 SKG_API void                skg_buffer_get_contents      (const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size);
+// Like skg_tex_read_async, but copies the whole buffer, and leaves the
+// readback's format as skg_tex_fmt_none. Collect it with skg_readback_poll
+// and skg_readback_map.
+SKG_API bool                skg_buffer_read_async        (const skg_buffer_t *buffer, skg_readback_t *ref_readback);
 SKG_API void                skg_buffer_bind              (const skg_buffer_t *buffer, skg_bind_t slot_vc);
+// Binds only part of a constant or compute buffer, so many small blocks can
+// share one buffer. offset must be a multiple of skg_buffer_range_align.
+SKG_API void                skg_buffer_bind_range        (const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes);
+SKG_API uint32_t            skg_buffer_range_align       (skg_buffer_type_ type);
+// Copies a block of constants into a shared per-frame buffer, and binds just
+// that range. This saves a constant buffer per object for data that changes
+// every draw. The copy is only valid until the next skg_draw_begin, and
+// size_bytes should cover the whole cbuffer the shader expects. Each
+// skg_draw_begin recycles this memory. Apps that don't call it still work,
+// but reuse memory only once the GPU is done with it, and may wait for it.
+SKG_API bool                skg_transient_bind           (const void *data, uint32_t size_bytes, skg_bind_t slot_vc);
 SKG_API void                skg_buffer_clear             (      skg_bind_t bind);
 SKG_API void                skg_buffer_destroy           (      skg_buffer_t *buffer);
 
@@ -714,17 +980,30 @@ SKG_API skg_mesh_t          skg_mesh_create              (const skg_buffer_t *ve
 SKG_API void                skg_mesh_name                (      skg_mesh_t *mesh, const char* name);
 SKG_API void                skg_mesh_set_verts           (      skg_mesh_t *mesh, const skg_buffer_t *vert_buffer);
 SKG_API void                skg_mesh_set_inds            (      skg_mesh_t *mesh, const skg_buffer_t *ind_buffer);
+// Describes the vertex buffer's layout, so meshes don't need the full 36
+// byte skg_vert_t. Components are laid out like a C struct with the same
+// members, and are matched to the shader's inputs by semantic. Shader inputs
+// the mesh lacks read as 1s. A null list goes back to skg_vert_t.
+SKG_API void                skg_mesh_set_format          (      skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count);
 SKG_API void                skg_mesh_bind                (const skg_mesh_t *mesh);
 SKG_API void                skg_mesh_destroy             (      skg_mesh_t *mesh);
 
 SKG_API skg_shader_stage_t  skg_shader_stage_create      (const void *shader_data, size_t shader_size, skg_stage_ type);
 SKG_API void                skg_shader_stage_destroy     (skg_shader_stage_t *stage);
+// Where GL program binaries are cached between runs, files are read and
+// written through skg_callback_file_read/write. Null disables the cache,
+// which is the default. Backends without program binaries ignore this.
+SKG_API void                skg_shader_cache_set_folder  (const char *folder);
 
 SKG_API skg_shader_t        skg_shader_create_file       (const char *sks_filename);
 SKG_API skg_shader_t        skg_shader_create_memory     (const void *sks_memory, size_t sks_memory_size);
 SKG_API skg_shader_t        skg_shader_create_manual     (skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader);
 SKG_API void                skg_shader_name              (      skg_shader_t *shader, const char* name);
 SKG_API bool                skg_shader_is_valid          (const skg_shader_t *shader);
+// False while the driver is still compiling the shader in the background,
+// so a fallback can be drawn instead. Using a shader that isn't ready, or
+// asking if it's valid, waits for it to finish.
+SKG_API bool                skg_shader_is_ready          (const skg_shader_t *shader);
 SKG_API void                skg_shader_compute_bind      (const skg_shader_t *shader);
 SKG_API skg_bind_t          skg_shader_get_bind          (const skg_shader_t *shader, const char *name);
 SKG_API int32_t             skg_shader_get_var_count     (const skg_shader_t *shader);
@@ -775,6 +1054,16 @@ SKG_API bool                skg_tex_get_contents         (      skg_tex_t *tex,
 SKG_API bool                skg_tex_get_mip_contents     (      skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size);
 SKG_API bool                skg_tex_get_mip_contents_arr (      skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size);
 SKG_API bool                skg_tex_gen_mips             (      skg_tex_t *tex);
+// skg_tex_read_async queues a copy of one mip and array slice into CPU
+// readable memory without waiting on the GPU. skg_readback_poll reports when
+// the copy has landed, usually a frame or two later, and skg_readback_map
+// then returns the tightly packed pixels. Mapping before the readback is
+// ready will wait on the GPU. Handing a readback back to skg_tex_read_async
+// reuses its memory, and invalidates anything previously mapped from it.
+SKG_API bool                skg_tex_read_async           (const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback);
+SKG_API bool                skg_readback_poll            (      skg_readback_t *readback);
+SKG_API const void*         skg_readback_map             (      skg_readback_t *readback, size_t *out_size);
+SKG_API void                skg_readback_destroy         (      skg_readback_t *readback);
 SKG_API void*               skg_tex_get_native           (const skg_tex_t *tex);
 SKG_API void                skg_tex_bind                 (const skg_tex_t *tex, skg_bind_t bind);
 SKG_API void                skg_tex_clear                (skg_bind_t bind);
@@ -818,16 +1107,124 @@ typedef struct {
 	skg_shader_file_stage_t *stages;
 } skg_shader_file_t;
 
+#define SKG_VERT_COMPONENT_MAX 8
+
+// A registered vertex layout. Components are placed like the members of the
+// equivalent C struct: each aligned to its own element size, with the stride
+// padded to the largest element.
+typedef struct {
+	skg_vert_component_t components[SKG_VERT_COMPONENT_MAX];
+	uint32_t             offsets   [SKG_VERT_COMPONENT_MAX];
+	int32_t              component_count;
+	uint32_t             stride;
+} skg_vert_fmt_t;
+
+typedef enum {
+	skg_draw_sort_state,         // Fewest state changes, then nearest first
+	skg_draw_sort_back_to_front, // Farthest first, for blended draws
+	skg_draw_sort_none,          // Submission order
+} skg_draw_sort_;
+
+// A draw for skg_draw_queue_add. The texture, buffer and constant lists are
+// copied in, but the resources they point to must live until the queue runs.
+// Pipeline or mesh can be null to draw with whatever is already bound.
+typedef struct {
+	const skg_pipeline_t *pipeline;
+	const skg_mesh_t     *mesh;
+	const skg_tex_t     **textures;
+	const skg_bind_t     *texture_binds;
+	int32_t               texture_count;
+	const skg_buffer_t  **buffers;
+	const skg_bind_t     *buffer_binds;
+	int32_t               buffer_count;
+	const void           *constants; // Optional, bound with skg_transient_bind
+	uint32_t              constants_size;
+	skg_bind_t            constants_bind;
+	int32_t               index_start;
+	int32_t               index_base;
+	int32_t               index_count;
+	int32_t               instance_count;
+	float                 depth;
+} skg_draw_packet_t;
+
+typedef struct {
+	struct skg_draw_item_t *_items;
+	int32_t                 _item_count;
+	int32_t                 _item_cap;
+	struct skg_draw_res_t  *_res;
+	int32_t                 _res_count;
+	int32_t                 _res_cap;
+	uint8_t                *_data;
+	uint32_t                _data_size;
+	uint32_t                _data_cap;
+	struct skg_draw_key_t  *_keys;
+	int32_t                 _key_cap;
+	uint64_t               *_rank_ids;
+	uint32_t               *_rank_vals;
+	uint32_t                _rank_cap;
+} skg_draw_queue_t;
+
+// Recorded commands live in a chain of blocks that are kept and reused
+// after a clear, so a list recorded every frame stops allocating.
+typedef struct {
+	struct skg_cmd_block_t *_first;
+	struct skg_cmd_block_t *_current;
+	int32_t                 _count;
+} skg_cmd_list_t;
+
 ///////////////////////////////////////////
 
 SKG_API void                    skg_log                        (skg_log_ level, const char *text);
 SKG_API void                    skg_logf                       (skg_log_ level, const char *text, ...);
 SKG_API void                    skg_log_enable                 (bool enabled);
 SKG_API bool                    skg_read_file                  (const char *filename, void **out_data, size_t *out_size);
+SKG_API bool                    skg_write_file                 (const char *filename, const void *data, size_t size);
+SKG_API const char*             skg_shader_cache_folder        ();
 SKG_API uint64_t                skg_hash                       (const char *string);
 SKG_API uint32_t                skg_mip_count                  (int32_t width, int32_t height);
 SKG_API void                    skg_mip_dimensions             (int32_t width, int32_t height, int32_t mip_level, int32_t *out_width, int32_t *out_height);
 SKG_API int32_t                 skg_fmt_size                   (skg_fmt_ format);
+SKG_API uint32_t                skg_ind_fmt_size               (skg_ind_fmt_ format);
+SKG_API skg_ind_fmt_            skg_ind_fmt_from_stride        (uint32_t stride);
+// Vertex formats are registered once and referred to by id, id 0 is always
+// the skg_vert_t layout. Returns -1 if the components can't be used.
+SKG_API int32_t                 skg_vert_fmt_register          (const skg_vert_component_t *components, int32_t component_count);
+SKG_API const skg_vert_fmt_t   *skg_vert_fmt_get               (int32_t id);
+SKG_API int32_t                 skg_vert_fmt_find              (const skg_vert_fmt_t *format, skg_semantic_ semantic, uint8_t semantic_slot);
+SKG_API void                    skg_vert_fmt_clear             ();
+// Draws added to a queue run on skg_draw_queue_execute, reordered so that
+// draws sharing a shader, textures and mesh are next to each other. They go
+// through the regular bind and draw calls, so whatever the last draw bound
+// stays bound. Executing leaves the queue's draws in place until cleared.
+SKG_API skg_draw_queue_t        skg_draw_queue_create          ();
+SKG_API void                    skg_draw_queue_add             (skg_draw_queue_t *queue, const skg_draw_packet_t *packet);
+SKG_API void                    skg_draw_queue_execute         (skg_draw_queue_t *queue, skg_draw_sort_ sort);
+SKG_API void                    skg_draw_queue_clear           (skg_draw_queue_t *queue);
+SKG_API void                    skg_draw_queue_destroy         (skg_draw_queue_t *queue);
+// Command lists record the same bind and draw calls as the immediate API,
+// on any thread, and skg_cmd_list_execute replays them in order on the
+// render thread. Data like transient constants and draw args is copied in,
+// but resources are kept by pointer and must live until the list runs. A
+// list can be executed more than once, and only one thread may record into
+// it at a time.
+SKG_API skg_cmd_list_t          skg_cmd_list_create            ();
+SKG_API void                    skg_cmd_list_pipeline_bind     (skg_cmd_list_t *list, const skg_pipeline_t *pipeline);
+SKG_API void                    skg_cmd_list_mesh_bind         (skg_cmd_list_t *list, const skg_mesh_t *mesh);
+SKG_API void                    skg_cmd_list_tex_bind          (skg_cmd_list_t *list, const skg_tex_t *texture, skg_bind_t bind);
+SKG_API void                    skg_cmd_list_buffer_bind       (skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc);
+SKG_API void                    skg_cmd_list_buffer_bind_range (skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes);
+SKG_API void                    skg_cmd_list_buffer_clear      (skg_cmd_list_t *list, skg_bind_t bind);
+SKG_API void                    skg_cmd_list_transient_bind    (skg_cmd_list_t *list, const void *data, uint32_t size_bytes, skg_bind_t slot_vc);
+SKG_API void                    skg_cmd_list_shader_compute_bind(skg_cmd_list_t *list, const skg_shader_t *shader);
+SKG_API void                    skg_cmd_list_viewport          (skg_cmd_list_t *list, const int32_t *xywh);
+SKG_API void                    skg_cmd_list_scissor           (skg_cmd_list_t *list, const int32_t *xywh);
+SKG_API void                    skg_cmd_list_draw              (skg_cmd_list_t *list, int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count);
+SKG_API void                    skg_cmd_list_draw_indirect     (skg_cmd_list_t *list, const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride);
+SKG_API void                    skg_cmd_list_draw_multi        (skg_cmd_list_t *list, const skg_draw_args_t *draws, uint32_t draw_count);
+SKG_API void                    skg_cmd_list_compute           (skg_cmd_list_t *list, uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z);
+SKG_API void                    skg_cmd_list_execute           (const skg_cmd_list_t *list);
+SKG_API void                    skg_cmd_list_clear             (skg_cmd_list_t *list);
+SKG_API void                    skg_cmd_list_destroy           (skg_cmd_list_t *list);
 
 SKG_API skg_color32_t           skg_col_hsv32                  (float hue, float saturation, float value, float alpha);
 SKG_API skg_color128_t          skg_col_hsv128                 (float hue, float saturation, float value, float alpha);
@@ -862,6 +1259,316 @@ SKG_API int32_t                 skg_shader_meta_get_var_index_h(const skg_shader
 SKG_API const skg_shader_var_t *skg_shader_meta_get_var_info   (const skg_shader_meta_t *meta, int32_t var_index);
 SKG_API void                    skg_shader_meta_reference      (skg_shader_meta_t *meta);
 SKG_API void                    skg_shader_meta_release        (skg_shader_meta_t *meta);
+
+///////////////////////////////////////////
+// Capture file format                   //
+///////////////////////////////////////////
+
+// skg_capture_start writes a small header, followed by a stream of records.
+// Each record is a skg_capture_record_t, then `size` bytes of payload. The
+// payload starts with the op's struct below, and any trailing bytes are the
+// raw data that came along with the call (buffer contents, texture pixels,
+// .sks shader files, event names). Resources are identified by a 64 bit id
+// that's unique while the resource is alive, but may be reused after it's
+// destroyed.
+
+#define SKG_CAPTURE_MAGIC   0x43474B53 // "SKGC"
+#define SKG_CAPTURE_VERSION 1
+
+typedef enum skg_capture_op_ {
+	skg_capture_op_frame = 1,
+	skg_capture_op_draw,
+	skg_capture_op_compute,
+	skg_capture_op_viewport,
+	skg_capture_op_scissor,
+	skg_capture_op_target_clear,
+	skg_capture_op_event_begin,
+	skg_capture_op_event_end,
+	skg_capture_op_buffer_create,
+	skg_capture_op_buffer_set_contents,
+	skg_capture_op_buffer_bind,
+	skg_capture_op_buffer_clear,
+	skg_capture_op_buffer_destroy,
+	skg_capture_op_mesh_bind,
+	skg_capture_op_shader_create,
+	skg_capture_op_shader_compute_bind,
+	skg_capture_op_shader_destroy,
+	skg_capture_op_pipeline_bind,
+	skg_capture_op_tex_create,
+	skg_capture_op_tex_create_existing,
+	skg_capture_op_tex_settings,
+	skg_capture_op_tex_set_contents,
+	skg_capture_op_tex_attach_depth,
+	skg_capture_op_tex_copy_to,
+	skg_capture_op_tex_gen_mips,
+	skg_capture_op_tex_bind,
+	skg_capture_op_tex_clear,
+	skg_capture_op_tex_target_bind,
+	skg_capture_op_tex_target_discard,
+	skg_capture_op_tex_destroy,
+	skg_capture_op_buffer_bind_range,
+	skg_capture_op_transient_bind,
+	skg_capture_op_buffer_set_range,
+	skg_capture_op_draw_indirect,
+	skg_capture_op_draw_multi,
+	skg_capture_op_max,
+} skg_capture_op_;
+
+typedef struct skg_capture_header_t {
+	uint32_t magic;
+	uint32_t version;
+} skg_capture_header_t;
+
+typedef struct skg_capture_record_t {
+	uint32_t op;
+	uint32_t size;
+} skg_capture_record_t;
+
+// skg_capture_op_draw
+typedef struct skg_capture_draw_t {
+	int32_t  index_start;
+	int32_t  index_base;
+	int32_t  index_count;
+	int32_t  instance_count;
+} skg_capture_draw_t;
+
+// skg_capture_op_draw_indirect
+typedef struct skg_capture_draw_indirect_t {
+	uint64_t id;
+	uint32_t offset;
+	uint32_t draw_count;
+	uint32_t stride;
+	uint32_t _pad;
+} skg_capture_draw_indirect_t;
+
+// skg_capture_op_draw_multi, followed by draw_count skg_draw_args_t
+typedef struct skg_capture_draw_multi_t {
+	uint32_t draw_count;
+} skg_capture_draw_multi_t;
+
+// skg_capture_op_compute
+typedef struct skg_capture_compute_t {
+	uint32_t thread_count[3];
+} skg_capture_compute_t;
+
+// skg_capture_op_viewport, skg_capture_op_scissor
+typedef struct skg_capture_rect_t {
+	int32_t  xywh[4];
+} skg_capture_rect_t;
+
+// skg_capture_op_target_clear
+typedef struct skg_capture_clear_t {
+	uint32_t depth;
+	uint32_t has_color;
+	float    color[4];
+} skg_capture_clear_t;
+
+// skg_capture_op_buffer_create, followed by size_count*size_stride bytes if
+// has_data is set.
+typedef struct skg_capture_buffer_t {
+	uint64_t id;
+	uint32_t size_count;
+	uint32_t size_stride;
+	int32_t  type;
+	int32_t  use;
+	uint32_t has_data;
+	uint32_t _pad;
+} skg_capture_buffer_t;
+
+// skg_capture_op_buffer_set_contents, skg_capture_op_buffer_destroy,
+// skg_capture_op_shader_create (followed by the .sks file),
+// skg_capture_op_shader_compute_bind, skg_capture_op_shader_destroy,
+// skg_capture_op_tex_gen_mips, skg_capture_op_tex_target_discard,
+// skg_capture_op_tex_destroy
+typedef struct skg_capture_id_t {
+	uint64_t id;
+} skg_capture_id_t;
+
+// skg_capture_op_buffer_bind, skg_capture_op_buffer_clear,
+// skg_capture_op_tex_bind, skg_capture_op_tex_clear
+typedef struct skg_capture_bind_t {
+	uint64_t id;
+	uint32_t slot;
+	uint32_t stage_bits;
+	uint32_t register_type;
+	uint32_t _pad;
+} skg_capture_bind_t;
+
+// skg_capture_op_buffer_bind_range, skg_capture_op_transient_bind. Transient
+// binds have no id, and are followed by size bytes of constant data.
+typedef struct skg_capture_bind_range_t {
+	uint64_t id;
+	uint32_t slot;
+	uint32_t stage_bits;
+	uint32_t register_type;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t _pad;
+} skg_capture_bind_range_t;
+
+// skg_capture_op_buffer_set_range, followed by size bytes of data.
+typedef struct skg_capture_buffer_range_t {
+	uint64_t id;
+	uint32_t offset;
+	uint32_t size;
+} skg_capture_buffer_range_t;
+
+// skg_capture_op_mesh_bind, followed by the mesh's skg_vert_component_t
+// list when it doesn't use the skg_vert_t layout.
+typedef struct skg_capture_mesh_t {
+	uint64_t vert_id;
+	uint64_t ind_id;
+} skg_capture_mesh_t;
+
+// skg_capture_op_pipeline_bind, pipelines are captured as the full state at
+// bind time, rather than as objects.
+typedef struct skg_capture_pipeline_t {
+	uint64_t shader_id;
+	int32_t  transparency;
+	int32_t  cull;
+	int32_t  color_write;
+	int32_t  depth_test;
+	uint32_t wireframe;
+	uint32_t depth_write;
+	uint32_t depth_clip;
+	uint32_t scissor;
+} skg_capture_pipeline_t;
+
+// skg_capture_op_tex_create, skg_capture_op_tex_create_existing. Textures
+// created from a native texture are replayed as regular textures, since the
+// native texture won't exist at replay time.
+typedef struct skg_capture_tex_t {
+	uint64_t id;
+	int32_t  type;
+	int32_t  use;
+	int32_t  format;
+	int32_t  mips;
+	int32_t  width;
+	int32_t  height;
+	int32_t  array_count;
+	int32_t  multisample;
+} skg_capture_tex_t;
+
+// skg_capture_op_tex_settings
+typedef struct skg_capture_tex_settings_t {
+	uint64_t id;
+	int32_t  address;
+	int32_t  sample;
+	int32_t  compare;
+	int32_t  anisotropy;
+} skg_capture_tex_settings_t;
+
+// skg_capture_op_tex_set_contents, followed by array_count tightly packed
+// arrays of mip_count mips each, if has_data is set.
+typedef struct skg_capture_tex_contents_t {
+	uint64_t id;
+	int32_t  array_count;
+	int32_t  mip_count;
+	int32_t  width;
+	int32_t  height;
+	int32_t  multisample;
+	uint32_t has_data;
+} skg_capture_tex_contents_t;
+
+// skg_capture_op_tex_attach_depth, skg_capture_op_tex_copy_to
+typedef struct skg_capture_tex_pair_t {
+	uint64_t id;
+	uint64_t other_id;
+	int32_t  surface;
+	int32_t  other_surface;
+} skg_capture_tex_pair_t;
+
+// skg_capture_op_tex_target_bind, an id of 0 binds no target.
+typedef struct skg_capture_target_t {
+	uint64_t id;
+	int32_t  layer_idx;
+	int32_t  mip_level;
+} skg_capture_target_t;
+
+///////////////////////////////////////////
+
+// Used by the backends to record skg_stats_t data.
+extern skg_stats_t _skg_stats;
+#define SKG_STAT_HIT(stat)   (_skg_stats.cache_hits  [stat] += 1)
+#define SKG_STAT_MISS(stat)  (_skg_stats.cache_misses[stat] += 1)
+// Safe to call from upload threads, unlike the macros above.
+void        skg_stats_upload               (int64_t bytes);
+
+// Used by the backends to feed skg_mem_get. Keys come from the backend's
+// skg_mem_key overloads, and must stay unique while the resource is alive.
+// Tracking 0 bytes drops that category from the allocation. Names only
+// stick to keys that are being tracked, skg_mem_add starts tracking one
+// before it has any memory.
+uint64_t    skg_mem_key                    (const skg_buffer_t *buffer);
+uint64_t    skg_mem_key                    (const skg_tex_t    *tex);
+void        skg_mem_track                  (uint64_t key, skg_mem_ type, int64_t bytes);
+void        skg_mem_track_tex              (uint64_t key, const skg_tex_t *tex, int32_t mip_count, int32_t physical_multisample);
+void        skg_mem_add                    (uint64_t key);
+void        skg_mem_release                (uint64_t key);
+void        skg_mem_name                   (uint64_t key, const char *name);
+
+// Used by the backends to time their work for skg_trace_start. These scopes
+// record from construction until they go out of scope.
+#if defined(SKG_TRACE)
+extern bool _skg_trace_active;
+int64_t     skg_trace_now    ();
+void        skg_trace_record (const char *name, const char *detail, int64_t start_ns, int64_t end_ns);
+
+typedef struct skg_trace_scope_t {
+	const char *name;
+	const char *detail;
+	int64_t     start;
+	skg_trace_scope_t(const char *name, const char *detail = nullptr) : name(name), detail(detail), start(_skg_trace_active ? skg_trace_now() : -1) {}
+	~skg_trace_scope_t() { if (start >= 0) skg_trace_record(name, detail, start, skg_trace_now()); }
+} skg_trace_scope_t;
+
+#define SKG_TRACE_SCOPE(name)                skg_trace_scope_t _skg_trace_scope  (name)
+#define SKG_TRACE_SCOPE_DETAIL(name, detail) skg_trace_scope_t _skg_trace_scope_d(name, detail)
+#define SKG_TRACE_FUNC()                     skg_trace_scope_t _skg_trace_func   (__func__)
+#else
+#define SKG_TRACE_SCOPE(name)
+#define SKG_TRACE_SCOPE_DETAIL(name, detail)
+#define SKG_TRACE_FUNC()
+#endif
+
+// Used by the backends to feed skg_capture_start. Each backend provides the
+// skg_capture_id overloads, and should wrap capture calls in SKG_CAPTURE_CALL so
+// they cost nothing when capture isn't compiled in or running.
+#if defined(SKG_CAPTURE)
+extern bool _skg_capture_active;
+uint64_t    skg_capture_id                 (const skg_buffer_t *buffer);
+uint64_t    skg_capture_id                 (const skg_shader_t *shader);
+uint64_t    skg_capture_id                 (const skg_tex_t    *tex);
+
+void        skg_capture_frame              ();
+void        skg_capture_draw               (int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count);
+void        skg_capture_draw_indirect      (const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride);
+void        skg_capture_draw_multi         (const skg_draw_args_t *draws, uint32_t draw_count);
+void        skg_capture_compute            (uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z);
+void        skg_capture_rect               (skg_capture_op_ op, const int32_t *xywh);
+void        skg_capture_target_clear       (bool depth, const float *clear_color_4);
+void        skg_capture_event_begin        (const char *name);
+void        skg_capture_event_end          ();
+void        skg_capture_buffer_create      (const skg_buffer_t *buffer, const void *data, uint32_t size_count, uint32_t size_stride);
+void        skg_capture_buffer_set_contents(const skg_buffer_t *buffer, const void *data, uint32_t size_bytes);
+void        skg_capture_buffer_set_range   (const skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes);
+void        skg_capture_bind               (skg_capture_op_ op, uint64_t id, skg_bind_t bind);
+void        skg_capture_bind_range         (skg_capture_op_ op, uint64_t id, skg_bind_t bind, uint32_t offset, uint32_t size, const void *data);
+void        skg_capture_mesh_bind          (uint64_t vert_id, uint64_t ind_id, int32_t vert_fmt);
+void        skg_capture_shader_create      (const skg_shader_t *shader, const void *sks_data, size_t sks_data_size);
+void        skg_capture_pipeline_bind      (const skg_pipeline_t *pipeline, uint64_t shader_id);
+void        skg_capture_tex_create         (skg_capture_op_ op, const skg_tex_t *tex);
+void        skg_capture_tex_settings       (const skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy);
+void        skg_capture_tex_set_contents   (const skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample);
+void        skg_capture_tex_pair           (skg_capture_op_ op, uint64_t id, int32_t surface, uint64_t other_id, int32_t other_surface);
+void        skg_capture_tex_target_bind    (uint64_t id, int32_t layer_idx, int32_t mip_level);
+void        skg_capture_id_op              (skg_capture_op_ op, uint64_t id);
+
+#define SKG_CAPTURE_CALL(call) if (_skg_capture_active) { call; }
+#else
+#define SKG_CAPTURE_CALL(call)
+#endif
+
 ///////////////////////////////////////////
 // Implementations!                      //
 ///////////////////////////////////////////
@@ -881,6 +1588,7 @@ SKG_API void                    skg_shader_meta_release        (skg_shader_meta_
 #endif
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <dxgi1_6.h>
 
 #if !defined(SKG_NO_D3DCOMPILER)
@@ -893,6 +1601,10 @@ SKG_API void                    skg_shader_meta_release        (skg_shader_meta_
 
 // Manually defining this lets us skip d3dcommon.h and dxguid.lib
 const GUID WKPDID_D3DDebugObjectName = { 0x429b8c22, 0x9188, 0x4b0c, { 0x87,0x42,0xac,0xb0,0xbf,0x85,0xc2,0x00 } };
+// Private data on vertex shaders: their bytecode, and the input layouts built
+// for each vertex format, with the format id in the last byte.
+const GUID d3d_guid_vs_bytecode = { 0x6d3c1e2a, 0x5b7f, 0x4c61, { 0x9a,0x0e,0x31,0xd4,0x7c,0x28,0x45,0x00 } };
+const GUID d3d_guid_vs_layout   = { 0x6d3c1e2b, 0x5b7f, 0x4c61, { 0x9a,0x0e,0x31,0xd4,0x7c,0x28,0x46,0x00 } };
 
 ///////////////////////////////////////////
 
@@ -904,22 +1616,98 @@ ID3D11DepthStencilState *d3d_depthstate  = nullptr;
 skg_tex_t               *d3d_active_rendertarget = nullptr;
 int32_t                  d3d_active_rendertarget_layer = 0;
 char                    *d3d_adapter_name = nullptr;
+uint32_t                 d3d_tex_next_id  = 1;
 
 ID3D11DeviceContext     *d3d_deferred    = nullptr;
 HANDLE                   d3d_deferred_mtx= nullptr;
 DWORD                    d3d_main_thread = 0;
 
 #if defined(_DEBUG)
-#include <d3d11_1.h>
 ID3DUserDefinedAnnotation *d3d_annotate = nullptr;
 #endif
 
+// Constant buffer offsets need 11.1's context, and an OS that supports them
+ID3D11DeviceContext1    *d3d_context1        = nullptr;
+bool                     d3d_cb_offsetting   = false;
+bool                     d3d_cb_no_overwrite = false;
+
+#define SKG_D3D_TRANSIENT_MIN (64 * 1024)
+
+// A dynamic constant buffer that's filled front to back with
+// WRITE_NO_OVERWRITE, and renamed with WRITE_DISCARD when it runs out.
+typedef struct d3d_transient_t {
+	ID3D11Buffer *buffer;
+	uint32_t      size;
+	uint32_t      used;
+} d3d_transient_t;
+d3d_transient_t          d3d_transient       = {};
+
+// Dynamic D3D11 buffers can only be written by discarding the whole thing,
+// so ranged writes collect in a full CPU copy, and go up in one Map when the
+// buffer is next used.
+typedef struct d3d_buffer_dirty_t {
+	ID3D11Buffer *buffer;
+	uint8_t      *shadow;
+	uint32_t      size;
+	bool          dirty;
+	bool          queued;
+} d3d_buffer_dirty_t;
+
+// Buffers with pending ranged writes. Bound buffers can be written to
+// after the bind, so the queue is flushed before each draw and dispatch.
+d3d_buffer_dirty_t **d3d_dirty_queue       = nullptr;
+int32_t              d3d_dirty_queue_count = 0;
+int32_t              d3d_dirty_queue_cap   = 0;
+
+// Input layouts depend on both the vertex shader and the mesh's format, so
+// they're picked at draw time once both are known.
+ID3D11VertexShader  *d3d_layout_vs      = nullptr;
+ID3D11InputLayout   *d3d_layout_default = nullptr;
+ID3D11InputLayout   *d3d_layout_curr    = nullptr;
+skg_shader_meta_t   *d3d_layout_meta    = nullptr;
+int32_t              d3d_layout_fmt     = 0;
+bool                 d3d_layout_dirty   = false;
+// Zero stride vertex buffer of 1s, for shader inputs a mesh doesn't have
+ID3D11Buffer        *d3d_layout_ones    = nullptr;
+
+#define SKG_D3D_TIMER_COUNT  256
+#define SKG_D3D_TIMER_DEPTH  16
+#define SKG_D3D_TIMER_FRAMES 8
+
+typedef struct d3d_timer_t {
+	char         name[32];
+	int32_t      depth;
+	uint64_t     frame;
+	ID3D11Query *queries[2];
+	bool         ended;
+} d3d_timer_t;
+
+d3d_timer_t         d3d_timers       [SKG_D3D_TIMER_COUNT];
+skg_timer_result_t  d3d_timer_results[SKG_D3D_TIMER_COUNT];
+ID3D11Query        *d3d_timer_disjoint[SKG_D3D_TIMER_FRAMES];
+bool                d3d_timer_disjoint_active = false;
+int32_t             d3d_timer_result_count    = 0;
+uint32_t            d3d_timer_head            = 0;
+uint32_t            d3d_timer_tail            = 0;
+int32_t             d3d_timer_stack[SKG_D3D_TIMER_DEPTH];
+int32_t             d3d_timer_stack_count     = 0;
+uint64_t            d3d_frame                 = 0;
+
 ///////////////////////////////////////////
 
 bool        skg_tex_make_view    (skg_tex_t *tex, uint32_t mip_count, uint32_t array_start, bool use_in_shader);
 DXGI_FORMAT skg_ind_to_dxgi      (skg_ind_fmt_ format);
+DXGI_FORMAT skg_fmt_to_dxgi      (skg_fmt_ format, uint8_t count);
+const char *skg_semantic_to_d3d  (skg_semantic_ semantic);
+void        d3d_layout_apply     ();
 int64_t     d3d_tex_fmt_to_native(skg_tex_fmt_ format, bool depth_readable);
 DXGI_FORMAT d3d_tex_fmt_to_view  (int64_t format);
+void        d3d_timer_frame      ();
+void        d3d_readback_prepare (skg_readback_t *readback, size_t size);
+void        d3d_buffer_flush     (const skg_buffer_t *buffer);
+uint16_t   *d3d_ind_widen        (const void *data, uint32_t count);
+void        d3d_buffer_read      (const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size);
+void        d3d_dirty_flush_queue();
 
 template <typename T>
 void skg_downsample_1(T *data, int32_t width, int32_t height, T **out_data, int32_t *out_width, int32_t *out_height);
@@ -929,6 +1717,7 @@ void skg_downsample_4(T *data, T data_max, int32_t width, int32_t height, T **ou
 ///////////////////////////////////////////
 
 int32_t skg_init(const char *, void *adapter_id) {
+	SKG_TRACE_FUNC();
 	UINT creation_flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
 #if defined(_DEBUG)
 	creation_flags |= D3D11_CREATE_DEVICE_DEBUG;
@@ -1046,6 +1835,13 @@ int32_t skg_init(const char *, void *adapter_id) {
 	d3d_context->QueryInterface(__uuidof(ID3DUserDefinedAnnotation), (void **)&d3d_annotate);
 #endif
 
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (SUCCEEDED(d3d_context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void **)&d3d_context1)) &&
+		SUCCEEDED(d3d_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+		d3d_cb_offsetting   = options.ConstantBufferOffsetting;
+		d3d_cb_no_overwrite = options.MapNoOverwriteOnDynamicConstantBuffer;
+	}
+
 	D3D11_RASTERIZER_DESC desc_rasterizer = {};
 	desc_rasterizer.FillMode = D3D11_FILL_SOLID;
 	desc_rasterizer.CullMode = D3D11_CULL_BACK;
@@ -1086,8 +1882,43 @@ const char* skg_adapter_name() {
 ///////////////////////////////////////////
 
 void skg_shutdown() {
+	SKG_TRACE_FUNC();
 	free(d3d_adapter_name);
+	for (int32_t i = 0; i < SKG_D3D_TIMER_COUNT; i++) {
+		if (d3d_timers[i].queries[0]) d3d_timers[i].queries[0]->Release();
+		if (d3d_timers[i].queries[1]) d3d_timers[i].queries[1]->Release();
+		d3d_timers[i] = {};
+	}
+	for (int32_t i = 0; i < SKG_D3D_TIMER_FRAMES; i++) {
+		if (d3d_timer_disjoint[i]) { d3d_timer_disjoint[i]->Release(); d3d_timer_disjoint[i] = nullptr; }
+	}
+	d3d_timer_disjoint_active = false;
+	d3d_timer_head            = 0;
+	d3d_timer_tail            = 0;
+	d3d_timer_stack_count     = 0;
+	d3d_timer_result_count    = 0;
+
+	if (d3d_transient.buffer) {
+		skg_mem_release((uint64_t)d3d_transient.buffer);
+		d3d_transient.buffer->Release();
+	}
+	d3d_transient       = {};
+	d3d_cb_offsetting   = false;
+	d3d_cb_no_overwrite = false;
+	free(d3d_dirty_queue);
+	d3d_dirty_queue       = nullptr;
+	d3d_dirty_queue_count = 0;
+	d3d_dirty_queue_cap   = 0;
+	if (d3d_layout_ones) { d3d_layout_ones->Release(); d3d_layout_ones = nullptr; }
+	d3d_layout_vs      = nullptr;
+	d3d_layout_default = nullptr;
+	d3d_layout_curr    = nullptr;
+	d3d_layout_meta    = nullptr;
+	d3d_layout_fmt     = 0;
+	skg_vert_fmt_clear();
+
 	CloseHandle(d3d_deferred_mtx);
+	if (d3d_context1   ) { d3d_context1   ->Release(); d3d_context1    = nullptr; }
 	if (d3d_rasterstate) { d3d_rasterstate->Release(); d3d_rasterstate = nullptr; }
 	if (d3d_depthstate ) { d3d_depthstate ->Release(); d3d_depthstate  = nullptr; }
 	if (d3d_info       ) { d3d_info       ->Release(); d3d_info        = nullptr; }
@@ -1099,6 +1930,8 @@ void skg_shutdown() {
 ///////////////////////////////////////////
 
 void skg_draw_begin() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_frame());
 	ID3D11CommandList* command_list = nullptr;
 	WaitForSingleObject(d3d_deferred_mtx, INFINITE);
 	d3d_deferred->FinishCommandList(false, &command_list);
@@ -1106,6 +1939,8 @@ void skg_draw_begin() {
 	d3d_context->ExecuteCommandList(command_list, false);
 	command_list->Release();
 
+	d3d_timer_frame();
+
 	d3d_context->RSSetState            (d3d_rasterstate);
 	d3d_context->OMSetDepthStencilState(d3d_depthstate, 1);
 	d3d_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1141,6 +1976,25 @@ skg_platform_data_t skg_get_platform_data() {
 
 ///////////////////////////////////////////
 
+bool skg_upload_thread_begin() {
+	// The D3D11 device is free threaded, and context work off the main
+	// thread already goes through d3d_threadsafe_context_get.
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_upload_thread_end() {
+}
+
+///////////////////////////////////////////
+
+void skg_deferred_destroy_enable(bool enabled) {
+	// D3D11 already holds released resources until the GPU is done with them
+}
+
+///////////////////////////////////////////
+
 bool skg_capability(skg_cap_ capability) {
 	switch (capability) {
 	case skg_cap_tex_layer_select: {
@@ -1149,6 +2003,7 @@ bool skg_capability(skg_cap_ capability) {
 		return options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer;
 	} break;
 	case skg_cap_wireframe: return true;
+	case skg_cap_gpu_timer: return true;
 	default: return false;
 	}
 }
@@ -1156,6 +2011,8 @@ bool skg_capability(skg_cap_ capability) {
 ///////////////////////////////////////////
 
 void skg_event_begin (const char *name) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_begin(name));
 #if defined(_DEBUG)
 	wchar_t name_w[64];
 	MultiByteToWideChar(CP_UTF8, 0, name, -1, name_w, _countof(name_w));
@@ -1166,6 +2023,8 @@ void skg_event_begin (const char *name) {
 ///////////////////////////////////////////
 
 void skg_event_end () {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_end());
 #if defined(_DEBUG)
 	d3d_annotate->EndEvent();
 #endif
@@ -1173,12 +2032,138 @@ void skg_event_end () {
 
 ///////////////////////////////////////////
 
+void d3d_timer_frame() {
+	// Timestamps only mean something inside a disjoint query, which tells
+	// us the frequency, and whether the clock held steady. We keep one per
+	// frame.
+	if (d3d_timer_disjoint_active)
+		d3d_context->End(d3d_timer_disjoint[d3d_frame % SKG_D3D_TIMER_FRAMES]);
+
+	// Timers complete in the order they were issued, so we can stop at the
+	// first one that isn't ready yet.
+	while (d3d_timer_tail != d3d_timer_head) {
+		d3d_timer_t *timer = &d3d_timers[d3d_timer_tail % SKG_D3D_TIMER_COUNT];
+		if (!timer->ended) break;
+
+		// If the GPU is so far behind that this frame's disjoint query is
+		// about to be reused, drop the timer.
+		bool expired = timer->frame + SKG_D3D_TIMER_FRAMES <= d3d_frame + 1;
+		if (!expired) {
+			D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+			uint64_t start, end;
+			if (d3d_context->GetData(d3d_timer_disjoint[timer->frame % SKG_D3D_TIMER_FRAMES], &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+			if (d3d_context->GetData(timer->queries[0], &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+			if (d3d_context->GetData(timer->queries[1], &end,   sizeof(end),   D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+
+			if (!disjoint.Disjoint && disjoint.Frequency > 0 && d3d_timer_result_count < SKG_D3D_TIMER_COUNT) {
+				skg_timer_result_t *result = &d3d_timer_results[d3d_timer_result_count];
+				memcpy(result->name, timer->name, sizeof(result->name));
+				result->depth       = timer->depth;
+				result->frame       = timer->frame;
+				result->duration_ns = end > start ? (uint64_t)((end - start) * (1000000000.0 / disjoint.Frequency)) : 0;
+				d3d_timer_result_count += 1;
+			}
+		}
+		timer->ended    = false;
+		d3d_timer_tail += 1;
+	}
+
+	d3d_frame += 1;
+	ID3D11Query **disjoint = &d3d_timer_disjoint[d3d_frame % SKG_D3D_TIMER_FRAMES];
+	if (*disjoint == nullptr) {
+		D3D11_QUERY_DESC desc = { D3D11_QUERY_TIMESTAMP_DISJOINT };
+		if (FAILED(d3d_device->CreateQuery(&desc, disjoint))) {
+			d3d_timer_disjoint_active = false;
+			return;
+		}
+	}
+	d3d_context->Begin(*disjoint);
+	d3d_timer_disjoint_active = true;
+}
+
+///////////////////////////////////////////
+
+void skg_timer_begin(const char *name) {
+	SKG_TRACE_FUNC();
+	if (d3d_timer_stack_count >= SKG_D3D_TIMER_DEPTH) {
+		skg_log(skg_log_warning, "skg_timer_begin nested too deeply, ignoring timer");
+		d3d_timer_stack_count += 1;
+		return;
+	}
+
+	// Timers need a frame's disjoint query, which starts at skg_draw_begin.
+	// If the GPU is so far behind that the ring is full of unread timers,
+	// we skip this one rather than wait for it.
+	if (!d3d_timer_disjoint_active || d3d_timer_head - d3d_timer_tail >= SKG_D3D_TIMER_COUNT) {
+		d3d_timer_stack[d3d_timer_stack_count++] = -1;
+		return;
+	}
+
+	int32_t      index = d3d_timer_head % SKG_D3D_TIMER_COUNT;
+	d3d_timer_t *timer = &d3d_timers[index];
+	if (timer->queries[0] == nullptr) {
+		D3D11_QUERY_DESC desc = { D3D11_QUERY_TIMESTAMP };
+		if (FAILED(d3d_device->CreateQuery(&desc, &timer->queries[0])) ||
+			FAILED(d3d_device->CreateQuery(&desc, &timer->queries[1]))) {
+			skg_log(skg_log_warning, "Failed to create timestamp queries");
+			if (timer->queries[0]) { timer->queries[0]->Release(); timer->queries[0] = nullptr; }
+			if (timer->queries[1]) { timer->queries[1]->Release(); timer->queries[1] = nullptr; }
+			d3d_timer_stack[d3d_timer_stack_count++] = -1;
+			return;
+		}
+	}
+	snprintf(timer->name, sizeof(timer->name), "%s", name ? name : "");
+	timer->depth = d3d_timer_stack_count;
+	timer->frame = d3d_frame;
+	timer->ended = false;
+	d3d_context->End(timer->queries[0]);
+
+	d3d_timer_head += 1;
+	d3d_timer_stack[d3d_timer_stack_count++] = index;
+}
+
+///////////////////////////////////////////
+
+void skg_timer_end() {
+	SKG_TRACE_FUNC();
+	if (d3d_timer_stack_count <= 0) {
+		skg_log(skg_log_warning, "skg_timer_end called without a matching skg_timer_begin");
+		return;
+	}
+
+	d3d_timer_stack_count -= 1;
+	if (d3d_timer_stack_count >= SKG_D3D_TIMER_DEPTH) return;
+	int32_t index = d3d_timer_stack[d3d_timer_stack_count];
+	if (index < 0) return;
+
+	d3d_context->End(d3d_timers[index].queries[1]);
+	d3d_timers[index].ended = true;
+}
+
+///////////////////////////////////////////
+
+int32_t skg_timer_get_results(skg_timer_result_t *out_results, int32_t max_results) {
+	int32_t count = d3d_timer_result_count < max_results ? d3d_timer_result_count : max_results;
+	if (count <= 0) return 0;
+
+	memcpy(out_results, d3d_timer_results, sizeof(skg_timer_result_t) * count);
+	d3d_timer_result_count -= count;
+	memmove(d3d_timer_results, &d3d_timer_results[count], sizeof(skg_timer_result_t) * d3d_timer_result_count);
+	return count;
+}
+
+///////////////////////////////////////////
+
 void skg_tex_target_discard(skg_tex_t *render_target) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_target_discard, skg_capture_id(render_target)));
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_target_bind(render_target ? skg_capture_id(render_target) : 0, layer_idx, mip_level));
 	d3d_active_rendertarget = render_target;
 	d3d_active_rendertarget_layer = layer_idx;
 
@@ -1212,6 +2197,8 @@ void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mi
 ///////////////////////////////////////////
 
 void skg_target_clear(bool depth, const float *clear_color_4) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_target_clear(depth, clear_color_4));
 	if (!d3d_active_rendertarget) return;
 
 	if (clear_color_4 && d3d_active_rendertarget->_target_view) {
@@ -1242,18 +2229,65 @@ skg_tex_t *skg_tex_target_get() {
 ///////////////////////////////////////////
 
 void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw(index_start, index_base, index_count, instance_count));
+	_skg_stats.draws += 1;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
+	d3d_layout_apply();
 	d3d_context->DrawIndexedInstanced(index_count, instance_count, index_start, index_base, 0);
 }
 
 ///////////////////////////////////////////
 
+void skg_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_indirect(args_buffer, offset, draw_count, stride));
+	if (args_buffer->type != skg_buffer_type_indirect) {
+		skg_log(skg_log_warning, "skg_draw_indirect needs a skg_buffer_type_indirect buffer");
+		return;
+	}
+	if (stride == 0) stride = sizeof(skg_draw_args_t);
+	if (offset % 4 != 0 || stride % 4 != 0) {
+		skg_log(skg_log_warning, "skg_draw_indirect offset and stride need to be multiples of 4");
+		return;
+	}
+	_skg_stats.draws += draw_count;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
+	d3d_buffer_flush(args_buffer);
+	d3d_layout_apply();
+	// D3D11 has no multi-draw, but the args still never leave the GPU, and
+	// the runtime handles the hazard with compute writes.
+	for (uint32_t i = 0; i < draw_count; i++)
+		d3d_context->DrawIndexedInstancedIndirect(args_buffer->_buffer, offset + i * stride);
+}
+
+///////////////////////////////////////////
+
+void skg_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_multi(draws, draw_count));
+	_skg_stats.draws += draw_count;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
+	d3d_layout_apply();
+	for (uint32_t i = 0; i < draw_count; i++)
+		d3d_context->DrawIndexedInstanced(draws[i].index_count, draws[i].instance_count, draws[i].index_start, draws[i].index_base, draws[i].instance_start);
+}
+
+///////////////////////////////////////////
+
 void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_compute(thread_count_x, thread_count_y, thread_count_z));
+	_skg_stats.dispatches += 1;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
 	d3d_context->Dispatch(thread_count_x, thread_count_y, thread_count_z);
 }
 
 ///////////////////////////////////////////
 
 void skg_viewport(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_viewport, xywh));
 	D3D11_VIEWPORT viewport = {};
 	viewport.TopLeftX = (float)xywh[0];
 	viewport.TopLeftY = (float)xywh[1];
@@ -1266,6 +2300,7 @@ void skg_viewport(const int32_t *xywh) {
 ///////////////////////////////////////////
 
 void skg_viewport_get(int32_t *out_xywh) {
+	SKG_TRACE_FUNC();
 	uint32_t       count = 1;
 	D3D11_VIEWPORT viewport;
 	d3d_context->RSGetViewports(&count, &viewport);
@@ -1278,6 +2313,8 @@ void skg_viewport_get(int32_t *out_xywh) {
 ///////////////////////////////////////////
 
 void skg_scissor(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_scissor, xywh));
 	D3D11_RECT rect = {xywh[0], xywh[1], xywh[0]+xywh[2], xywh[1]+xywh[3]};
 	d3d_context->RSSetScissorRects(1, &rect);
 }
@@ -1285,15 +2322,28 @@ void skg_scissor(const int32_t *xywh) {
 ///////////////////////////////////////////
 
 skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
+	SKG_TRACE_FUNC();
 	skg_buffer_t result = {};
 	result.use    = use;
 	result.type   = type;
 	result.stride = size_stride;
 
-	D3D11_SUBRESOURCE_DATA buffer_data = { data };
+	// D3D11 has no 8 bit indices, so those are stored as 16 bit
+	uint32_t  gpu_stride = size_stride;
+	uint16_t *widened    = nullptr;
+	if (type == skg_buffer_type_index) {
+		result._ind_format = skg_ind_fmt_from_stride(size_stride);
+		if (result._ind_format == skg_ind_fmt_u8) {
+			result._ind_format = skg_ind_fmt_u16;
+			gpu_stride         = sizeof(uint16_t);
+			if (data) widened  = d3d_ind_widen(data, size_count);
+		}
+	}
+
+	D3D11_SUBRESOURCE_DATA buffer_data = { widened ? widened : data };
 	D3D11_BUFFER_DESC      buffer_desc = {};
-	buffer_desc.ByteWidth           = size_count * size_stride;
-	buffer_desc.StructureByteStride = size_stride;
+	buffer_desc.ByteWidth           = size_count * gpu_stride;
+	buffer_desc.StructureByteStride = gpu_stride;
 	buffer_desc.Usage               = D3D11_USAGE_DEFAULT;
 
 	if (use & skg_use_dynamic) {
@@ -1305,18 +2355,32 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 		buffer_desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE; 
 		buffer_desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 	}
+	// Indirect args can't be structured, so compute sees them through raw
+	// views instead, as a (RW)ByteAddressBuffer.
+	bool raw_views = false;
+	if (type == skg_buffer_type_indirect) {
+		raw_views = (use & skg_use_compute_write) || (use & skg_use_compute_read);
+		buffer_desc.StructureByteStride = 0;
+		buffer_desc.MiscFlags           = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+		if (raw_views) buffer_desc.MiscFlags |= D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+		else           buffer_desc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+	}
 
 	switch (type) {
 	case skg_buffer_type_vertex:   buffer_desc.BindFlags |= D3D11_BIND_VERTEX_BUFFER;   break;
 	case skg_buffer_type_index:    buffer_desc.BindFlags |= D3D11_BIND_INDEX_BUFFER;    break;
 	case skg_buffer_type_constant: buffer_desc.BindFlags |= D3D11_BIND_CONSTANT_BUFFER; break;
 	case skg_buffer_type_compute:  break;
+	case skg_buffer_type_indirect: break;
 	}
 	HRESULT hr = d3d_device->CreateBuffer(&buffer_desc, data == nullptr ? nullptr : &buffer_data, &result._buffer);
+	free(widened);
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "CreateBuffer failed: 0x%08X", hr);
 		return {};
 	}
+	if (data) skg_stats_upload(buffer_desc.ByteWidth);
+	skg_mem_track(skg_mem_key(&result), skg_mem_buffer, buffer_desc.ByteWidth);
 
 	if (use & skg_use_compute_write) {
 		D3D11_UNORDERED_ACCESS_VIEW_DESC view = {};
@@ -1324,6 +2388,11 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 		view.Format        = DXGI_FORMAT_UNKNOWN;
 		view.Buffer.FirstElement = 0;
 		view.Buffer.NumElements  = size_count; 
+		if (raw_views) {
+			view.Format             = DXGI_FORMAT_R32_TYPELESS;
+			view.Buffer.NumElements = buffer_desc.ByteWidth / 4;
+			view.Buffer.Flags       = D3D11_BUFFER_UAV_FLAG_RAW;
+		}
 
 		hr = d3d_device->CreateUnorderedAccessView( result._buffer, &view, &result._unordered );
 		if(FAILED(hr)) {
@@ -1338,6 +2407,11 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 		view.Format        = DXGI_FORMAT_UNKNOWN;
 		view.BufferEx.FirstElement = 0;
 		view.BufferEx.NumElements  = size_count;
+		if (raw_views) {
+			view.Format               = DXGI_FORMAT_R32_TYPELESS;
+			view.BufferEx.NumElements = buffer_desc.ByteWidth / 4;
+			view.BufferEx.Flags       = D3D11_BUFFEREX_SRV_FLAG_RAW;
+		}
 
 		hr = d3d_device->CreateShaderResourceView(result._buffer, &view, &result._resource);
 		if (FAILED(hr)) {
@@ -1346,12 +2420,15 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 			return {};
 		}
 	} 
+	SKG_CAPTURE_CALL(skg_capture_buffer_create(&result, data, size_count, size_stride));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(buffer), name);
 	if (buffer->_buffer != nullptr)
 		buffer->_buffer->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)strlen(name), name);
 
@@ -1375,14 +2452,33 @@ bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
 ///////////////////////////////////////////
 
 void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
 	if (buffer->use != skg_use_dynamic) {
 		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
 		return;
 	}
 
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_contents(buffer, data, size_bytes));
 	HRESULT hr = E_FAIL;
 	D3D11_MAPPED_SUBRESOURCE resource = {};
 
+	uint16_t *widened = nullptr;
+	if (buffer->type == skg_buffer_type_index && buffer->stride == 1) {
+		data        = widened = d3d_ind_widen(data, size_bytes);
+		size_bytes *= sizeof(uint16_t);
+	}
+
+	// With a CPU copy around, keep it current, and send all of it so
+	// earlier ranged writes past size_bytes survive the discard.
+	d3d_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty) {
+		if (size_bytes > dirty->size) size_bytes = dirty->size;
+		memcpy(dirty->shadow, data, size_bytes);
+		dirty->dirty = false;
+		data         = dirty->shadow;
+		size_bytes   = dirty->size;
+	}
+
 	// Map the memory so we can access it on CPU! In a multi-threaded
 	// context this can be tricky, here we're using a deferred context to
 	// push this operation over to the main thread. The deferred context is
@@ -1392,18 +2488,143 @@ void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t si
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "Failed to set contents of buffer, may not be using a writeable buffer type: 0x%08X", hr);
 		d3d_threadsafe_context_release(context);
+		free(widened);
 		return;
 	}
 
 	memcpy(resource.pData, data, size_bytes);
+	skg_stats_upload(size_bytes);
 
 	context->Unmap(buffer->_buffer, 0);
 	d3d_threadsafe_context_release(context);
+	free(widened);
+}
+
+///////////////////////////////////////////
+
+uint16_t *d3d_ind_widen(const void *data, uint32_t count) {
+	uint16_t *result = (uint16_t*)malloc(sizeof(uint16_t) * (count > 0 ? count : 1));
+	for (uint32_t i = 0; i < count; i++)
+		result[i] = ((const uint8_t*)data)[i];
+	return result;
+}
+
+///////////////////////////////////////////
+
+void d3d_buffer_flush(const skg_buffer_t *buffer) {
+	d3d_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr || !dirty->dirty) return;
+	SKG_TRACE_FUNC();
+
+	D3D11_MAPPED_SUBRESOURCE resource = {};
+	HRESULT hr = d3d_context->Map(dirty->buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "Failed to flush buffer range writes: 0x%08X", hr);
+		return;
+	}
+	memcpy(resource.pData, dirty->shadow, dirty->size);
+	d3d_context->Unmap(dirty->buffer, 0);
+	dirty->dirty = false;
+}
+
+///////////////////////////////////////////
+
+void d3d_dirty_flush_queue() {
+	for (int32_t i = 0; i < d3d_dirty_queue_count; i++) {
+		d3d_buffer_dirty_t *dirty = d3d_dirty_queue[i];
+		dirty->queued = false;
+		if (!dirty->dirty) continue;
+
+		D3D11_MAPPED_SUBRESOURCE resource = {};
+		if (SUCCEEDED(d3d_context->Map(dirty->buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource))) {
+			memcpy(resource.pData, dirty->shadow, dirty->size);
+			d3d_context->Unmap(dirty->buffer, 0);
+		}
+		dirty->dirty = false;
+	}
+	d3d_dirty_queue_count = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents_range(skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+
+	d3d_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr) {
+		// The first ranged write pays for one readback, so the untouched
+		// bytes are still there when the whole copy goes up.
+		D3D11_BUFFER_DESC desc = {};
+		buffer->_buffer->GetDesc(&desc);
+		dirty = (d3d_buffer_dirty_t*)calloc(1, sizeof(d3d_buffer_dirty_t));
+		dirty->buffer = buffer->_buffer;
+		dirty->size   = desc.ByteWidth;
+		dirty->shadow = (uint8_t*)malloc(desc.ByteWidth);
+		d3d_buffer_read(buffer, dirty->shadow, desc.ByteWidth);
+		buffer->_dirty = dirty;
+	}
+	// 8 bit indices are 16 bit on the GPU, so the range doubles
+	bool     widened   = buffer->type == skg_buffer_type_index && buffer->stride == 1;
+	uint32_t gpu_scale = widened ? sizeof(uint16_t) : 1;
+	if (offset > dirty->size / gpu_scale || size_bytes > dirty->size / gpu_scale - offset) {
+		skg_log(skg_log_warning, "skg_buffer_set_contents_range is writing outside of the buffer!");
+		return;
+	}
+	if (size_bytes == 0) return;
+
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_range(buffer, offset, data, size_bytes));
+	if (widened) {
+		uint16_t *dest = (uint16_t*)(dirty->shadow + offset * gpu_scale);
+		for (uint32_t i = 0; i < size_bytes; i++)
+			dest[i] = ((const uint8_t*)data)[i];
+	} else {
+		memcpy(dirty->shadow + offset, data, size_bytes);
+	}
+	dirty->dirty = true;
+	skg_stats_upload(size_bytes * gpu_scale);
+
+	if (!dirty->queued) {
+		if (d3d_dirty_queue_count == d3d_dirty_queue_cap) {
+			d3d_dirty_queue_cap = d3d_dirty_queue_cap == 0 ? 16 : d3d_dirty_queue_cap * 2;
+			d3d_dirty_queue     = (d3d_buffer_dirty_t**)realloc(d3d_dirty_queue, sizeof(d3d_buffer_dirty_t*) * d3d_dirty_queue_cap);
+		}
+		d3d_dirty_queue[d3d_dirty_queue_count++] = dirty;
+		dirty->queued = true;
+	}
 }
 
 ///////////////////////////////////////////
 
 void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	SKG_TRACE_FUNC();
+	if (buffer->type != skg_buffer_type_index || buffer->stride != 1) {
+		d3d_buffer_read(buffer, ref_buffer, buffer_size);
+		return;
+	}
+
+	// 8 bit indices were widened on the way in, narrow them back
+	uint16_t *wide = (uint16_t*)malloc(sizeof(uint16_t) * (buffer_size > 0 ? buffer_size : 1));
+	d3d_buffer_read(buffer, wide, buffer_size * sizeof(uint16_t));
+	for (uint32_t i = 0; i < buffer_size; i++)
+		((uint8_t*)ref_buffer)[i] = (uint8_t)wide[i];
+	free(wide);
+}
+
+///////////////////////////////////////////
+
+void d3d_buffer_read(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	// The CPU copy already has the latest contents, pending or not
+	if (buffer->_dirty) {
+		uint32_t copy_size = buffer_size < buffer->_dirty->size ? buffer_size : buffer->_dirty->size;
+		memcpy(ref_buffer, buffer->_dirty->shadow, copy_size);
+		if (copy_size < buffer_size) memset((uint8_t*)ref_buffer + copy_size, 0, buffer_size - copy_size);
+		return;
+	}
+
 	ID3D11Buffer* cpu_buff = nullptr;
 
 	D3D11_BUFFER_DESC desc = {};
@@ -1433,7 +2654,46 @@ void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint3
 
 ///////////////////////////////////////////
 
+bool skg_buffer_read_async(const skg_buffer_t *buffer, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	D3D11_BUFFER_DESC desc = {};
+	buffer->_buffer->GetDesc(&desc);
+
+	// Reuse the staging buffer when the size hasn't changed
+	if (ref_readback->_staging && (ref_readback->format != skg_tex_fmt_none || ref_readback->size != desc.ByteWidth)) {
+		ref_readback->_staging->Release();
+		ref_readback->_staging = nullptr;
+	}
+	if (ref_readback->_staging == nullptr) {
+		desc.CPUAccessFlags      = D3D11_CPU_ACCESS_READ;
+		desc.Usage               = D3D11_USAGE_STAGING;
+		desc.BindFlags           = 0;
+		desc.MiscFlags           = 0;
+		desc.StructureByteStride = 0;
+		ID3D11Buffer *staging = nullptr;
+		HRESULT hr = d3d_device->CreateBuffer(&desc, nullptr, &staging);
+		if (FAILED(hr)) {
+			skg_logf(skg_log_critical, "skg_buffer_read_async CreateBuffer failed: 0x%08X", hr);
+			return false;
+		}
+		ref_readback->_staging = staging;
+	}
+	d3d_buffer_flush(buffer);
+	d3d_readback_prepare(ref_readback, desc.ByteWidth);
+	ref_readback->width  = (int32_t)desc.ByteWidth;
+	ref_readback->height = 1;
+	ref_readback->format = skg_tex_fmt_none;
+
+	d3d_context->CopyResource(ref_readback->_staging, buffer->_buffer);
+	if (ref_readback->_query) d3d_context->End(ref_readback->_query);
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_buffer_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_clear, 0, bind));
 	if (bind.register_type == skg_register_readwrite) {
 		ID3D11UnorderedAccessView *null_uav = nullptr;
 		d3d_context->CSSetUnorderedAccessViews(bind.slot, 1, &null_uav, nullptr);
@@ -1442,8 +2702,12 @@ void skg_buffer_clear(skg_bind_t bind) {
 
 ///////////////////////////////////////////
 void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_bind, skg_capture_id(buffer), bind));
+	SKG_STAT_MISS(skg_stat_buffer);
+	d3d_buffer_flush(buffer);
 	switch (bind.register_type) {
-	case skg_register_index:  d3d_context->IASetIndexBuffer(buffer->_buffer, DXGI_FORMAT_R32_UINT, 0); break;
+	case skg_register_index:  d3d_context->IASetIndexBuffer(buffer->_buffer, skg_ind_to_dxgi(buffer->_ind_format), 0); break;
 	case skg_register_vertex: d3d_context->IASetVertexBuffers(bind.slot, 1, &buffer->_buffer, &buffer->stride, NULL); break;
 	case skg_register_constant: {
 #if !defined(NDEBUG)
@@ -1455,7 +2719,7 @@ void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
 	} break;
 	case skg_register_resource: {
 #if !defined(NDEBUG)
-		if (buffer->type != skg_buffer_type_compute) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a resource register! Use skg_buffer_type_compute");
+		if (buffer->type != skg_buffer_type_compute && buffer->type != skg_buffer_type_indirect) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a resource register! Use skg_buffer_type_compute");
 #endif
 		if (bind.stage_bits & skg_stage_vertex ) d3d_context->VSSetShaderResources(bind.slot, 1, &buffer->_resource);
 		if (bind.stage_bits & skg_stage_pixel  ) d3d_context->PSSetShaderResources(bind.slot, 1, &buffer->_resource);
@@ -1463,7 +2727,7 @@ void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
 	} break;
 	case skg_register_readwrite: {
 #if !defined(NDEBUG)
-		if (buffer->type != skg_buffer_type_compute) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a UAV register! Use skg_buffer_type_compute");
+		if (buffer->type != skg_buffer_type_compute && buffer->type != skg_buffer_type_indirect) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a UAV register! Use skg_buffer_type_compute");
 #endif
 		if (bind.stage_bits & skg_stage_compute) d3d_context->CSSetUnorderedAccessViews(bind.slot, 1, &buffer->_unordered, nullptr);
 	} break;
@@ -1472,7 +2736,129 @@ void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
 
 ///////////////////////////////////////////
 
+void d3d_bind_constant_range(ID3D11Buffer *buffer, skg_bind_t bind, uint32_t offset, uint32_t size_bytes) {
+	// Offsets and sizes are counted in 16 byte constants, and both must be
+	// multiples of 16 constants.
+	UINT first = offset / 16;
+	UINT count = ((size_bytes + 255) / 256) * 16;
+	if (bind.stage_bits & skg_stage_vertex ) d3d_context1->VSSetConstantBuffers1(bind.slot, 1, &buffer, &first, &count);
+	if (bind.stage_bits & skg_stage_pixel  ) d3d_context1->PSSetConstantBuffers1(bind.slot, 1, &buffer, &first, &count);
+	if (bind.stage_bits & skg_stage_compute) d3d_context1->CSSetConstantBuffers1(bind.slot, 1, &buffer, &first, &count);
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_bind_range(const skg_buffer_t *buffer, skg_bind_t bind, uint32_t offset, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_buffer_bind_range, skg_capture_id(buffer), bind, offset, size_bytes, nullptr));
+	if (bind.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_buffer_bind_range only supports constant registers on D3D11");
+		return;
+	}
+#if !defined(NDEBUG)
+	if (buffer->type != skg_buffer_type_constant) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a constant register! Use skg_buffer_type_constant");
+	if (offset % skg_buffer_range_align(buffer->type) != 0) skg_log(skg_log_critical, "skg_buffer_bind_range offset isn't aligned, see skg_buffer_range_align");
+#endif
+	SKG_STAT_MISS(skg_stat_buffer);
+	d3d_buffer_flush(buffer);
+	if (d3d_cb_offsetting) {
+		d3d_bind_constant_range(buffer->_buffer, bind, offset, size_bytes);
+	} else if (offset == 0) {
+		if (bind.stage_bits & skg_stage_vertex ) d3d_context->VSSetConstantBuffers(bind.slot, 1, &buffer->_buffer);
+		if (bind.stage_bits & skg_stage_pixel  ) d3d_context->PSSetConstantBuffers(bind.slot, 1, &buffer->_buffer);
+		if (bind.stage_bits & skg_stage_compute) d3d_context->CSSetConstantBuffers(bind.slot, 1, &buffer->_buffer);
+	} else {
+		skg_log(skg_log_warning, "skg_buffer_bind_range: this device can't offset constant buffers");
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_buffer_range_align(skg_buffer_type_ type) {
+	return type == skg_buffer_type_constant ? 256 : 1;
+}
+
+///////////////////////////////////////////
+
+bool skg_transient_bind(const void *data, uint32_t size_bytes, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_transient_bind, 0, bind, 0, size_bytes, data));
+	if (bind.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_transient_bind only works with constant registers");
+		return false;
+	}
+
+	uint32_t offset  = ((d3d_transient.used + 255) / 256) * 256;
+	bool     discard = false;
+	if (d3d_transient.buffer == nullptr || size_bytes > d3d_transient.size) {
+		uint32_t size = d3d_transient.size * 2;
+		if (size < SKG_D3D_TRANSIENT_MIN) size = SKG_D3D_TRANSIENT_MIN;
+		if (size < size_bytes)            size = size_bytes;
+		size = ((size + 255) / 256) * 256;
+		if (d3d_transient.buffer) {
+			skg_mem_release((uint64_t)d3d_transient.buffer);
+			d3d_transient.buffer->Release();
+		}
+		d3d_transient = {};
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth      = size;
+		desc.Usage          = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		HRESULT hr = d3d_device->CreateBuffer(&desc, nullptr, &d3d_transient.buffer);
+		if (FAILED(hr)) {
+			skg_logf(skg_log_critical, "skg_transient_bind CreateBuffer failed: 0x%08X", hr);
+			return false;
+		}
+		d3d_transient.size = size;
+		skg_mem_track((uint64_t)d3d_transient.buffer, skg_mem_buffer, size);
+		skg_mem_name ((uint64_t)d3d_transient.buffer, "skg_transient");
+	}
+	// Without offsets, every block starts at the front of fresh memory
+	if (!d3d_cb_offsetting || !d3d_cb_no_overwrite || offset + size_bytes > d3d_transient.size) {
+		discard = true;
+		offset  = 0;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE resource = {};
+	HRESULT hr = d3d_context->Map(d3d_transient.buffer, 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &resource);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "skg_transient_bind Map failed: 0x%08X", hr);
+		return false;
+	}
+	memcpy((uint8_t*)resource.pData + offset, data, size_bytes);
+	d3d_context->Unmap(d3d_transient.buffer, 0);
+	d3d_transient.used = offset + size_bytes;
+	skg_stats_upload(size_bytes);
+
+	SKG_STAT_MISS(skg_stat_buffer);
+	if (d3d_cb_offsetting) {
+		d3d_bind_constant_range(d3d_transient.buffer, bind, offset, size_bytes);
+	} else {
+		if (bind.stage_bits & skg_stage_vertex ) d3d_context->VSSetConstantBuffers(bind.slot, 1, &d3d_transient.buffer);
+		if (bind.stage_bits & skg_stage_pixel  ) d3d_context->PSSetConstantBuffers(bind.slot, 1, &d3d_transient.buffer);
+		if (bind.stage_bits & skg_stage_compute) d3d_context->CSSetConstantBuffers(bind.slot, 1, &d3d_transient.buffer);
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_buffer_destroy(skg_buffer_t *buffer) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_buffer_destroy, skg_capture_id(buffer)));
+	skg_mem_release(skg_mem_key(buffer));
+	if (buffer->_dirty) {
+		for (int32_t i = 0; i < d3d_dirty_queue_count; i++) {
+			if (d3d_dirty_queue[i] == buffer->_dirty) {
+				d3d_dirty_queue[i] = d3d_dirty_queue[--d3d_dirty_queue_count];
+				break;
+			}
+		}
+		free(buffer->_dirty->shadow);
+		free(buffer->_dirty);
+	}
 	if (buffer->_buffer) buffer->_buffer->Release();
 	*buffer = {};
 }
@@ -1480,9 +2866,11 @@ void skg_buffer_destroy(skg_buffer_t *buffer) {
 ///////////////////////////////////////////
 
 skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
 	skg_mesh_t result = {};
 	result._ind_buffer  = ind_buffer  ? ind_buffer ->_buffer : nullptr;
 	result._vert_buffer = vert_buffer ? vert_buffer->_buffer : nullptr;
+	result._ind_format  = ind_buffer  ? ind_buffer ->_ind_format : skg_ind_fmt_u32;
 	if (result._ind_buffer ) result._ind_buffer ->AddRef();
 	if (result._vert_buffer) result._vert_buffer->AddRef();
 
@@ -1492,6 +2880,7 @@ skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *
 ///////////////////////////////////////////
 
 void skg_mesh_name(skg_mesh_t* mesh, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (mesh->_ind_buffer != nullptr) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_verts", name);
@@ -1506,6 +2895,7 @@ void skg_mesh_name(skg_mesh_t* mesh, const char* name) {
 ///////////////////////////////////////////
 
 void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
+	SKG_TRACE_FUNC();
 	if (vert_buffer && vert_buffer->_buffer) vert_buffer->_buffer->AddRef();
 	if (mesh->_vert_buffer)                  mesh->_vert_buffer->Release();
 	mesh->_vert_buffer = vert_buffer->_buffer;
@@ -1514,23 +2904,114 @@ void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
 ///////////////////////////////////////////
 
 void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
 	if (ind_buffer && ind_buffer->_buffer) ind_buffer->_buffer->AddRef();
 	if (mesh->_ind_buffer)                 mesh->_ind_buffer->Release();
 	mesh->_ind_buffer = ind_buffer->_buffer;
+	mesh->_ind_format = ind_buffer->_ind_format;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_set_format(skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count) {
+	SKG_TRACE_FUNC();
+	int32_t fmt = skg_vert_fmt_register(components, component_count);
+	if (fmt >= 0) mesh->_vert_fmt = fmt;
 }
 
 ///////////////////////////////////////////
 
 void skg_mesh_bind(const skg_mesh_t *mesh) {
-	UINT strides[] = { sizeof(skg_vert_t) };
-	UINT offsets[] = { 0 };
-	d3d_context->IASetVertexBuffers(0, 1, &mesh->_vert_buffer, strides, offsets);
-	d3d_context->IASetIndexBuffer  (mesh->_ind_buffer, DXGI_FORMAT_R32_UINT, 0);
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_mesh_bind((uint64_t)mesh->_vert_buffer, (uint64_t)mesh->_ind_buffer, mesh->_vert_fmt));
+	SKG_STAT_MISS(skg_stat_buffer);
+	if (mesh->_vert_fmt != 0 && d3d_layout_ones == nullptr) {
+		float                  ones[4]  = { 1, 1, 1, 1 };
+		D3D11_SUBRESOURCE_DATA data     = { ones };
+		D3D11_BUFFER_DESC      desc     = {};
+		desc.ByteWidth = sizeof(ones);
+		desc.Usage     = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		d3d_device->CreateBuffer(&desc, &data, &d3d_layout_ones);
+	}
+	ID3D11Buffer *buffers[] = { mesh->_vert_buffer, d3d_layout_ones };
+	UINT          strides[] = { skg_vert_fmt_get(mesh->_vert_fmt)->stride, 0 };
+	UINT          offsets[] = { 0, 0 };
+	d3d_context->IASetVertexBuffers(0, mesh->_vert_fmt != 0 ? 2 : 1, buffers, strides, offsets);
+	d3d_context->IASetIndexBuffer  (mesh->_ind_buffer, skg_ind_to_dxgi(mesh->_ind_format), 0);
+	if (d3d_layout_fmt != mesh->_vert_fmt) {
+		d3d_layout_fmt   = mesh->_vert_fmt;
+		d3d_layout_dirty = true;
+	}
+}
+
+///////////////////////////////////////////
+
+void d3d_layout_apply() {
+	if (!d3d_layout_dirty) return;
+	d3d_layout_dirty = false;
+
+	ID3D11InputLayout *layout = d3d_layout_default;
+	bool               owned  = false;
+	if (d3d_layout_fmt != 0 && d3d_layout_vs != nullptr) {
+		// Layouts live on the vertex shader they were validated against,
+		// and are released along with it.
+		GUID guid = d3d_guid_vs_layout;
+		guid.Data4[7] = (uint8_t)d3d_layout_fmt;
+		UINT size = sizeof(layout);
+		if (FAILED(d3d_layout_vs->GetPrivateData(guid, &size, &layout))) {
+			layout = nullptr;
+			UINT  code_size = 0;
+			void *code      = nullptr;
+			if (SUCCEEDED(d3d_layout_vs->GetPrivateData(d3d_guid_vs_bytecode, &code_size, nullptr)) && code_size > 0) {
+				code = malloc(code_size);
+				d3d_layout_vs->GetPrivateData(d3d_guid_vs_bytecode, &code_size, code);
+			}
+
+			// Every component the mesh has, then anything else the shader
+			// reads comes from the zero stride buffer of 1s in slot 1.
+			const skg_vert_fmt_t    *fmt        = skg_vert_fmt_get(d3d_layout_fmt);
+			D3D11_INPUT_ELEMENT_DESC desc[SKG_VERT_COMPONENT_MAX * 2];
+			UINT                     desc_count = 0;
+			for (int32_t i = 0; i < fmt->component_count; i++) {
+				const skg_vert_component_t *com = &fmt->components[i];
+				if (com->semantic == skg_semantic_none) continue;
+				desc[desc_count++] = { skg_semantic_to_d3d(com->semantic), com->semantic_slot, skg_fmt_to_dxgi(com->format, com->count), 0, fmt->offsets[i], D3D11_INPUT_PER_VERTEX_DATA, 0 };
+			}
+			int32_t input_count = d3d_layout_meta ? d3d_layout_meta->vertex_input_count : 0;
+			for (int32_t i = 0; i < input_count && desc_count < _countof(desc); i++) {
+				const skg_vert_component_t *input = &d3d_layout_meta->vertex_inputs[i];
+				if (skg_vert_fmt_find(fmt, input->semantic, input->semantic_slot) >= 0) continue;
+				desc[desc_count++] = { skg_semantic_to_d3d(input->semantic), input->semantic_slot, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+			}
+
+			HRESULT hr = code
+				? d3d_device->CreateInputLayout(desc, desc_count, code, code_size, &layout)
+				: E_FAIL;
+			free(code);
+			if (FAILED(hr)) {
+				skg_logf(skg_log_warning, "Couldn't build an input layout for vertex format %d: 0x%08X", d3d_layout_fmt, hr);
+				layout = nullptr;
+			} else {
+				d3d_layout_vs->SetPrivateDataInterface(guid, layout);
+			}
+		}
+		owned = layout != nullptr;
+	}
+
+	if (d3d_layout_curr != layout) {
+		SKG_STAT_MISS(skg_stat_layout);
+		d3d_context->IASetInputLayout(layout);
+		d3d_layout_curr = layout;
+	}
+	// The shader's private data keeps the layout alive
+	if (owned) layout->Release();
 }
 
 ///////////////////////////////////////////
 
 void skg_mesh_destroy(skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
 	if (mesh->_ind_buffer ) mesh->_ind_buffer ->Release();
 	if (mesh->_vert_buffer) mesh->_vert_buffer->Release();
 	*mesh = {};
@@ -1539,6 +3020,7 @@ void skg_mesh_destroy(skg_mesh_t *mesh) {
 ///////////////////////////////////////////
 
 skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
+	SKG_TRACE_FUNC();
 	skg_shader_stage_t result = {};
 	result.type = type;
 
@@ -1565,7 +3047,10 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 			case skg_stage_vertex:  entrypoint = "vs"; target = "vs_5_0"; break;
 			case skg_stage_pixel:   entrypoint = "ps"; target = "ps_5_0"; break;
 			case skg_stage_compute: entrypoint = "cs"; target = "cs_5_0"; break; }
-		hr = D3DCompile(file_data, shader_size, nullptr, nullptr, nullptr, entrypoint, target, flags, 0, &compiled, &errors);
+		{
+			SKG_TRACE_SCOPE("D3DCompile");
+			hr = D3DCompile(file_data, shader_size, nullptr, nullptr, nullptr, entrypoint, target, flags, 0, &compiled, &errors);
+		}
 		if (errors) {
 			skg_log(skg_log_warning, "D3DCompile errors:");
 			skg_log(skg_log_warning, (char*)errors->GetBufferPointer());
@@ -1614,6 +3099,9 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 			{"TEXCOORD",    0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
 			{"COLOR" ,      0, DXGI_FORMAT_R8G8B8A8_UNORM,  0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0} };
 		d3d_device->CreateInputLayout(vert_desc, (UINT)_countof(vert_desc), buffer, buffer_size, &result._layout);
+		// Meshes with their own vertex format need layouts validated
+		// against this shader later on.
+		((ID3D11VertexShader *)result._shader)->SetPrivateData(d3d_guid_vs_bytecode, (UINT)buffer_size, buffer);
 	}
 	if (compiled) compiled->Release();
 
@@ -1623,6 +3111,7 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 ///////////////////////////////////////////
 
 void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+	SKG_TRACE_FUNC();
 	switch(shader->type) {
 	case skg_stage_vertex  : ((ID3D11VertexShader *)shader->_shader)->Release(); shader->_layout->Release(); break;
 	case skg_stage_pixel   : ((ID3D11PixelShader  *)shader->_shader)->Release(); break;
@@ -1635,6 +3124,7 @@ void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
+	SKG_TRACE_FUNC();
 	if (v_shader._shader == nullptr && p_shader._shader == nullptr && c_shader._shader == nullptr) {
 		skg_logf(skg_log_warning, "Shader '%s' has no valid stages!", meta->name);
 		return {};
@@ -1659,6 +3149,7 @@ skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_
 ///////////////////////////////////////////
 
 void skg_shader_name(skg_shader_t *shader, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (shader->_pixel != nullptr) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_ps", name);
@@ -1683,14 +3174,25 @@ bool skg_shader_is_valid(const skg_shader_t *shader) {
 
 ///////////////////////////////////////////
 
-void skg_shader_compute_bind(const skg_shader_t *shader) {
-	if (shader) d3d_context->CSSetShader(shader->_compute, nullptr, 0);
+bool skg_shader_is_ready(const skg_shader_t *shader) {
+	// D3D11 creates shaders synchronously
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_shader_compute_bind(const skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_compute_bind, shader ? skg_capture_id(shader) : 0));
+	if (shader) d3d_context->CSSetShader(shader->_compute, nullptr, 0);
 	else        d3d_context->CSSetShader(nullptr, nullptr, 0);
 }
 
 ///////////////////////////////////////////
 
 void skg_shader_destroy(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_destroy, skg_capture_id(shader)));
 	skg_shader_meta_release(shader->meta);
 	if (shader->_vertex ) shader->_vertex ->Release();
 	if (shader->_layout ) shader->_layout ->Release();
@@ -1802,6 +3304,7 @@ void skg_pipeline_update_depth(skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
 	skg_pipeline_t result = {};
 	result.transparency = skg_transparency_none;
 	result.cull         = skg_cull_back;
@@ -1827,6 +3330,7 @@ skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
 ///////////////////////////////////////////
 
 void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (pipeline->_blend != nullptr) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_blendstate", name);
@@ -1849,17 +3353,29 @@ void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
 ///////////////////////////////////////////
 
 void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_pipeline_bind(pipeline, (uint64_t)pipeline->_vertex));
+	// D3D11 has no state cache of its own here, so these all go through to
+	// the driver.
+	SKG_STAT_MISS(skg_stat_blend);
+	SKG_STAT_MISS(skg_stat_depth);
+	SKG_STAT_MISS(skg_stat_cull);
+	SKG_STAT_MISS(skg_stat_program);
 	d3d_context->OMSetBlendState       (pipeline->_blend,  nullptr, 0xFFFFFFFF);
 	d3d_context->OMSetDepthStencilState(pipeline->_depth,  0);
 	d3d_context->RSSetState            (pipeline->_rasterize);
 	d3d_context->VSSetShader           (pipeline->_vertex, nullptr, 0);
 	d3d_context->PSSetShader           (pipeline->_pixel,  nullptr, 0);
-	d3d_context->IASetInputLayout      (pipeline->_layout);
+	d3d_layout_vs      = pipeline->_vertex;
+	d3d_layout_default = pipeline->_layout;
+	d3d_layout_meta    = pipeline->meta;
+	d3d_layout_dirty   = true;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ transparency) {
+	SKG_TRACE_FUNC();
 	if (pipeline->transparency != transparency) {
 		pipeline->transparency  = transparency;
 		skg_pipeline_update_blend(pipeline);
@@ -1869,6 +3385,7 @@ void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ t
 ///////////////////////////////////////////
 
 void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
+	SKG_TRACE_FUNC();
 	if (pipeline->cull != cull) {
 		pipeline->cull  = cull;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1878,6 +3395,7 @@ void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
+	SKG_TRACE_FUNC();
 	if (pipeline->depth_write != write) {
 		pipeline->depth_write = write;
 		skg_pipeline_update_depth(pipeline);
@@ -1887,6 +3405,7 @@ void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
+	SKG_TRACE_FUNC();
 	if (pipeline->depth_clip != clip) {
 		pipeline->depth_clip = clip;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1896,6 +3415,7 @@ void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ write) {
+	SKG_TRACE_FUNC();
 	if (pipeline->color_write != write) {
 		pipeline->color_write = write;
 		skg_pipeline_update_blend(pipeline);
@@ -1905,6 +3425,7 @@ void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ wri
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test) {
+	SKG_TRACE_FUNC();
 	if (pipeline->depth_test != test) {
 		pipeline->depth_test = test;
 		skg_pipeline_update_depth(pipeline);
@@ -1914,6 +3435,7 @@ void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test
 ///////////////////////////////////////////
 
 void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
+	SKG_TRACE_FUNC();
 	if (pipeline->wireframe != wireframe) {
 		pipeline->wireframe  = wireframe;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1923,6 +3445,7 @@ void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_scissor(skg_pipeline_t *pipeline, bool enable) {
+	SKG_TRACE_FUNC();
 	if (pipeline->scissor != enable) {
 		pipeline->scissor  = enable;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1980,6 +3503,7 @@ bool skg_pipeline_get_scissor(const skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
 	skg_shader_meta_release(pipeline->meta);
 	if (pipeline->_blend    ) pipeline->_blend    ->Release();
 	if (pipeline->_rasterize) pipeline->_rasterize->Release();
@@ -1995,6 +3519,7 @@ void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
+	SKG_TRACE_FUNC();
 	skg_swapchain_t result = {};
 	result.width  = requested_width;
 	result.height = requested_height;
@@ -2048,6 +3573,7 @@ skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fm
 ///////////////////////////////////////////
 
 void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
 	if (swapchain->_swapchain == nullptr || (width == swapchain->width && height == swapchain->height))
 		return;
 
@@ -2081,6 +3607,7 @@ void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t hei
 ///////////////////////////////////////////
 
 void skg_swapchain_present(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	HRESULT hr = swapchain->_swapchain->Present(1, 0);
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "Couldn't present swapchain: 0x%08X", hr);
@@ -2094,12 +3621,14 @@ void skg_swapchain_present(skg_swapchain_t *swapchain) {
 ///////////////////////////////////////////
 
 void skg_swapchain_bind(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	skg_tex_target_bind(swapchain->_target.format != 0 ? &swapchain->_target : nullptr, -1, 0);
 }
 
 ///////////////////////////////////////////
 
 void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	skg_tex_destroy(&swapchain->_target);
 	skg_tex_destroy(&swapchain->_depth);
 	swapchain->_swapchain->Release();
@@ -2109,9 +3638,11 @@ void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ override_format, int32_t width, int32_t height, int32_t array_count, int32_t multisample, int32_t framebuffer_multisample) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type     = type;
 	result.use      = skg_use_static;
+	result._id      = d3d_tex_next_id++;
 	result._texture = (ID3D11Texture2D *)native_tex;
 	result._texture->AddRef();
 
@@ -2124,6 +3655,7 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 	result.multisample = color_desc.SampleDesc.Count;
 	result.mips        = color_desc.MipLevels > 1 ? skg_mip_generate : skg_mip_none;
 	result.format      = override_format != 0 ? override_format : skg_tex_fmt_from_native(color_desc.Format);
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
 	skg_tex_make_view(&result, color_desc.MipLevels, -1, color_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE);
 	skg_tex_settings (&result, skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 0);
 
@@ -2133,9 +3665,11 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ override_format, int32_t width, int32_t height, int32_t array_layer) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type     = type;
 	result.use      = skg_use_static;
+	result._id      = d3d_tex_next_id++;
 	result._texture = (ID3D11Texture2D *)native_tex;
 	result._texture->AddRef();
 
@@ -2148,6 +3682,7 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 	result.array_start = array_layer;
 	result.multisample = color_desc.SampleDesc.Count;
 	result.format      = override_format != 0 ? override_format : skg_tex_fmt_from_native(color_desc.Format);
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
 	skg_tex_make_view(&result, color_desc.MipLevels, array_layer, color_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE);
 	skg_tex_settings (&result, skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 0);
 
@@ -2157,21 +3692,27 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type   = type;
 	result.use    = use;
 	result.format = format;
 	result.mips   = mip_maps;
+	result._id    = d3d_tex_next_id++;
+	skg_mem_add(skg_mem_key(&result));
 
 	if (use == skg_use_dynamic && mip_maps == skg_mip_generate)
 		skg_log(skg_log_warning, "Dynamic textures don't support mip-maps!");
 
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create, &result));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_name(skg_tex_t *tex, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(tex), name);
 	if (tex->_texture != nullptr) tex->_texture->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)strlen(name), name);
 
 	char postfix_name[256];
@@ -2200,6 +3741,8 @@ void skg_tex_name(skg_tex_t *tex, const char* name) {
 ///////////////////////////////////////////
 
 void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_copy_to, skg_capture_id(tex), tex_surface, skg_capture_id(destination), dest_surface));
 	if (destination->width != tex->width || destination->height != tex->height) {
 		skg_tex_set_contents_arr(destination, nullptr, tex->array_count, 1, tex->width, tex->height, tex->multisample);
 	}
@@ -2219,6 +3762,7 @@ void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *desti
 ///////////////////////////////////////////
 
 void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
+	SKG_TRACE_FUNC();
 	skg_tex_copy_to(tex, -1, &destination->_target, -1);
 }
 
@@ -2231,6 +3775,8 @@ bool skg_tex_is_valid(const skg_tex_t *tex) {
 ///////////////////////////////////////////
 
 void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_attach_depth, skg_capture_id(tex), 0, skg_capture_id(depth), 0));
 	if (depth->type == skg_tex_type_zbuffer || depth->type == skg_tex_type_depthtarget) {
 		if (tex->_depth_view) tex->_depth_view->Release();
 		tex->_depth_view = depth->_depth_view;
@@ -2259,6 +3805,8 @@ void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
 ///////////////////////////////////////////
 
 void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_settings(tex, address, sample, compare, anisotropy));
 	if (tex->_sampler)
 		tex->_sampler->Release();
 
@@ -2392,6 +3940,7 @@ void skg_make_mips(D3D11_SUBRESOURCE_DATA *tex_mem, const void *curr_data, skg_t
 ///////////////////////////////////////////
 
 bool skg_tex_make_view(skg_tex_t *tex, uint32_t mip_count, uint32_t array_start, bool use_in_shader) {
+	SKG_TRACE_FUNC();
 	DXGI_FORMAT format = d3d_tex_fmt_to_view(d3d_tex_fmt_to_native(tex->format, tex->type == skg_tex_type_depthtarget));
 	HRESULT     hr     = E_FAIL;
 	
@@ -2573,6 +4122,7 @@ bool skg_tex_make_view(skg_tex_t *tex, uint32_t mip_count, uint32_t array_start,
 ///////////////////////////////////////////
 
 void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
 	const void *data_arr[1] = { data };
 	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
 }
@@ -2755,6 +4305,7 @@ ID3D11Texture2D *d3d_gen_mips_data(ID3D11DeviceContext *context, D3D11_TEXTURE2D
 ///////////////////////////////////////////
 
 void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t array_count, int32_t array_mip_count, int32_t width, int32_t height, int32_t multisample) {
+	SKG_TRACE_FUNC();
 	// Some warning messages
 	if (tex->use != skg_use_dynamic && tex->_texture) {
 		skg_log(skg_log_warning, "Only dynamic textures can be updated!");
@@ -2765,6 +4316,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		return;
 	}
 
+	SKG_CAPTURE_CALL(skg_capture_tex_set_contents(tex, array_data, array_count, array_mip_count, width, height, multisample));
 	tex->width       = width;
 	tex->height      = height;
 	tex->array_count = array_count;
@@ -2800,6 +4352,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		if (generate_mips) {
 			desc.MipLevels = array_mip_count;
 
+			SKG_TRACE_SCOPE("d3d_tex_upload_gen_mips");
 			ID3D11DeviceContext *context = d3d_threadsafe_context_get();
 			tex->_texture = d3d_gen_mips_data(context, desc, array_data);
 			d3d_threadsafe_context_release(context);
@@ -2828,9 +4381,11 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 
 						mip_offset += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
 					}
+					skg_stats_upload(mip_offset);
 				}
 			}
 			
+			SKG_TRACE_SCOPE("d3d_tex_upload");
 			hr = d3d_device->CreateTexture2D(&desc, tex_mem, &tex->_texture);
 			if (FAILED(hr)) {
 				skg_logf(skg_log_critical, "Create texture error: 0x%08X", hr);
@@ -2839,6 +4394,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		}
 
 		skg_tex_make_view(tex, mip_levels, -1, true);
+		skg_mem_track_tex(skg_mem_key(tex), tex, mip_levels, multisample);
 	} else {
 		// For dynamic textures, just upload the new value into the texture!
 		
@@ -2865,6 +4421,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		}
 		
 		context->Unmap(tex->_texture, 0);
+		skg_stats_upload((int64_t)mem_pitch * height);
 
 		d3d_threadsafe_context_release(context);
 	}
@@ -2878,18 +4435,21 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 ///////////////////////////////////////////
 
 bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
 bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
 bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	// Double check on mips first
 	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
 	if (mip_level != 0) {
@@ -2984,7 +4544,138 @@ bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr
 
 ///////////////////////////////////////////
 
+void d3d_readback_prepare(skg_readback_t *readback, size_t size) {
+	if (readback->_query == nullptr) {
+		D3D11_QUERY_DESC query_desc = {};
+		query_desc.Query = D3D11_QUERY_EVENT;
+		d3d_device->CreateQuery(&query_desc, &readback->_query);
+	}
+	if (readback->size != size) {
+		free(readback->_data);
+		readback->_data = malloc(size);
+	}
+	readback->size    = size;
+	readback->_copied = false;
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_read_async(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	if (mip_level >= mip_levels || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "skg_tex_read_async: this texture doesn't have the mip level or array slice you asked for.");
+		return false;
+	}
+
+	int32_t width  = 0;
+	int32_t height = 0;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	tex->_texture->GetDesc(&desc);
+	if (desc.SampleDesc.Count > 1) {
+		skg_log(skg_log_warning, "skg_tex_read_async MSAA surfaces not implemented");
+		return false;
+	}
+	desc.Width          = width;
+	desc.Height         = height;
+	desc.MipLevels      = 1;
+	desc.ArraySize      = 1;
+	desc.MiscFlags      = 0;
+	desc.BindFlags      = 0;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.Usage          = D3D11_USAGE_STAGING;
+
+	// Reuse the staging texture when the shape hasn't changed
+	if (ref_readback->_staging && (ref_readback->width != width || ref_readback->height != height || ref_readback->format != tex->format)) {
+		ref_readback->_staging->Release();
+		ref_readback->_staging = nullptr;
+	}
+	if (ref_readback->_staging == nullptr) {
+		ID3D11Texture2D *staging = nullptr;
+		HRESULT hr = d3d_device->CreateTexture2D(&desc, nullptr, &staging);
+		if (FAILED(hr)) {
+			skg_logf(skg_log_critical, "skg_tex_read_async CreateTexture2D failed: 0x%08X", hr);
+			return false;
+		}
+		ref_readback->_staging = staging;
+	}
+	d3d_readback_prepare(ref_readback, skg_tex_fmt_memory(tex->format, width, height));
+	ref_readback->width  = width;
+	ref_readback->height = height;
+	ref_readback->format = tex->format;
+
+	D3D11_BOX box = {};
+	box.right  = width;
+	box.bottom = height;
+	box.back   = 1;
+	d3d_context->CopySubresourceRegion(ref_readback->_staging, 0, 0, 0, 0, tex->_texture, mip_level + (arr_index * mip_levels), &box);
+	if (ref_readback->_query) d3d_context->End(ref_readback->_query);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool skg_readback_poll(skg_readback_t *readback) {
+	if (readback->_staging == nullptr) return false;
+	if (readback->_copied  || readback->_query == nullptr) return true;
+	return d3d_context->GetData(readback->_query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+}
+
+///////////////////////////////////////////
+
+const void *skg_readback_map(skg_readback_t *readback, size_t *out_size) {
+	SKG_TRACE_FUNC();
+	if (out_size) *out_size = readback->size;
+	if (readback->_staging == nullptr) return nullptr;
+	if (readback->_copied)             return readback->_data;
+
+	// Map waits on the GPU if the copy hasn't finished yet
+	D3D11_MAPPED_SUBRESOURCE data;
+	HRESULT hr = d3d_context->Map(readback->_staging, 0, D3D11_MAP_READ, 0, &data);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "skg_readback_map Map failed: 0x%08X", hr);
+		return nullptr;
+	}
+
+	if (readback->format == skg_tex_fmt_none) {
+		memcpy(readback->_data, data.pData, readback->size);
+		d3d_context->Unmap(readback->_staging, 0);
+		readback->_copied = true;
+		return readback->_data;
+	}
+
+	// Staging rows are padded, so pack them tightly
+	uint8_t *src_ptr   = (uint8_t*)data.pData;
+	uint8_t *dest_ptr  = (uint8_t*)readback->_data;
+	size_t   mem_pitch = skg_tex_fmt_pitch(readback->format, readback->width);
+	size_t   rows      = readback->size / mem_pitch;
+	for (size_t h = 0; h < rows; ++h) {
+		memcpy(dest_ptr, src_ptr, mem_pitch);
+		src_ptr  += data.RowPitch;
+		dest_ptr += mem_pitch;
+	}
+	d3d_context->Unmap(readback->_staging, 0);
+	readback->_copied = true;
+	return readback->_data;
+}
+
+///////////////////////////////////////////
+
+void skg_readback_destroy(skg_readback_t *readback) {
+	SKG_TRACE_FUNC();
+	if (readback->_staging) readback->_staging->Release();
+	if (readback->_query  ) readback->_query  ->Release();
+	free(readback->_data);
+	*readback = {};
+}
+
+///////////////////////////////////////////
+
 bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_gen_mips, skg_capture_id(tex_mipped_rt)));
 	ID3D11DeviceContext *context = d3d_threadsafe_context_get();
 	bool result = d3d_gen_mips(context, tex_mipped_rt->_texture);
 	d3d_threadsafe_context_release(context);
@@ -2994,12 +4685,15 @@ bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
 ///////////////////////////////////////////
 
 void* skg_tex_get_native(const skg_tex_t* tex) {
+	SKG_TRACE_FUNC();
 	return tex->_texture;
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_clear, 0, bind));
 	switch (bind.register_type) {
 	case skg_register_resource: {
 		ID3D11SamplerState       *null_state = nullptr;
@@ -3030,6 +4724,9 @@ void skg_tex_clear(skg_bind_t bind) {
 ///////////////////////////////////////////
 
 void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_bind, skg_capture_id(texture), bind));
+	SKG_STAT_MISS(skg_stat_texture);
 	switch (bind.register_type) {
 	case skg_register_resource: {
 		if (bind.stage_bits & skg_stage_pixel ){
@@ -3055,11 +4752,14 @@ void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
 ///////////////////////////////////////////
 
 void skg_tex_destroy(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_destroy, skg_capture_id(tex)));
 	if (tex->_target_view) tex->_target_view->Release();
 	if (tex->_depth_view ) tex->_depth_view ->Release();
 	if (tex->_resource   ) tex->_resource   ->Release();
 	if (tex->_sampler    ) tex->_sampler    ->Release();
 	if (tex->_texture    ) tex->_texture    ->Release();
+	skg_mem_release(skg_mem_key(tex));
 
 	if (tex->_target_array_view) {
 		int32_t mip_count = tex->mips == skg_mip_generate ? skg_mip_count(tex->width, tex->height) : 1;
@@ -3234,7 +4934,7 @@ bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
 
 ///////////////////////////////////////////
 
-const char *skg_semantic_to_d3d(skg_el_semantic_ semantic) {
+const char *skg_el_semantic_to_d3d(skg_el_semantic_ semantic) {
 	switch (semantic) {
 	case skg_el_semantic_none:         return "";
 	case skg_el_semantic_position:     return "SV_POSITION";
@@ -3248,6 +4948,61 @@ const char *skg_semantic_to_d3d(skg_el_semantic_ semantic) {
 
 ///////////////////////////////////////////
 
+DXGI_FORMAT skg_fmt_to_dxgi(skg_fmt_ format, uint8_t count) {
+	// Indexed by component count, D3D has no 3 wide 8 or 16 bit formats
+	static const DXGI_FORMAT f32  [] = { DXGI_FORMAT_R32_FLOAT,  DXGI_FORMAT_R32G32_FLOAT,  DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT };
+	static const DXGI_FORMAT f16  [] = { DXGI_FORMAT_R16_FLOAT,  DXGI_FORMAT_R16G16_FLOAT,  DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_FLOAT };
+	static const DXGI_FORMAT i32  [] = { DXGI_FORMAT_R32_SINT,   DXGI_FORMAT_R32G32_SINT,   DXGI_FORMAT_R32G32B32_SINT,  DXGI_FORMAT_R32G32B32A32_SINT  };
+	static const DXGI_FORMAT ui32 [] = { DXGI_FORMAT_R32_UINT,   DXGI_FORMAT_R32G32_UINT,   DXGI_FORMAT_R32G32B32_UINT,  DXGI_FORMAT_R32G32B32A32_UINT  };
+	static const DXGI_FORMAT i16  [] = { DXGI_FORMAT_R16_SINT,   DXGI_FORMAT_R16G16_SINT,   DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_SINT  };
+	static const DXGI_FORMAT i16n [] = { DXGI_FORMAT_R16_SNORM,  DXGI_FORMAT_R16G16_SNORM,  DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_SNORM };
+	static const DXGI_FORMAT ui16 [] = { DXGI_FORMAT_R16_UINT,   DXGI_FORMAT_R16G16_UINT,   DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_UINT  };
+	static const DXGI_FORMAT ui16n[] = { DXGI_FORMAT_R16_UNORM,  DXGI_FORMAT_R16G16_UNORM,  DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_UNORM };
+	static const DXGI_FORMAT i8   [] = { DXGI_FORMAT_R8_SINT,    DXGI_FORMAT_R8G8_SINT,     DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_SINT      };
+	static const DXGI_FORMAT i8n  [] = { DXGI_FORMAT_R8_SNORM,   DXGI_FORMAT_R8G8_SNORM,    DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_SNORM     };
+	static const DXGI_FORMAT ui8  [] = { DXGI_FORMAT_R8_UINT,    DXGI_FORMAT_R8G8_UINT,     DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_UINT      };
+	static const DXGI_FORMAT ui8n [] = { DXGI_FORMAT_R8_UNORM,   DXGI_FORMAT_R8G8_UNORM,    DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_UNORM     };
+
+	const DXGI_FORMAT *formats = nullptr;
+	switch (format) {
+	case skg_fmt_f32:             formats = f32;   break;
+	case skg_fmt_f16:             formats = f16;   break;
+	case skg_fmt_i32:             formats = i32;   break;
+	case skg_fmt_ui32:            formats = ui32;  break;
+	case skg_fmt_i16:             formats = i16;   break;
+	case skg_fmt_i16_normalized:  formats = i16n;  break;
+	case skg_fmt_ui16:            formats = ui16;  break;
+	case skg_fmt_ui16_normalized: formats = ui16n; break;
+	case skg_fmt_i8:              formats = i8;    break;
+	case skg_fmt_i8_normalized:   formats = i8n;   break;
+	case skg_fmt_ui8:             formats = ui8;   break;
+	case skg_fmt_ui8_normalized:  formats = ui8n;  break;
+	default: break;
+	}
+	return formats != nullptr && count >= 1 && count <= 4
+		? formats[count - 1]
+		: DXGI_FORMAT_UNKNOWN;
+}
+
+///////////////////////////////////////////
+
+const char *skg_semantic_to_d3d(skg_semantic_ semantic) {
+	switch (semantic) {
+	case skg_semantic_position:     return "SV_POSITION";
+	case skg_semantic_texcoord:     return "TEXCOORD";
+	case skg_semantic_normal:       return "NORMAL";
+	case skg_semantic_binormal:     return "BINORMAL";
+	case skg_semantic_tangent:      return "TANGENT";
+	case skg_semantic_color:        return "COLOR";
+	case skg_semantic_psize:        return "PSIZE";
+	case skg_semantic_blendweight:  return "BLENDWEIGHT";
+	case skg_semantic_blendindices: return "BLENDINDICES";
+	default: return "";
+	}
+}
+
+///////////////////////////////////////////
+
 DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	switch (format) {
 	case skg_ind_fmt_u32: return DXGI_FORMAT_R32_UINT;
@@ -3257,6 +5012,32 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	}
 }
 
+///////////////////////////////////////////
+
+// Buffer pointers are always aligned, so the low bit keeps textures apart.
+uint64_t skg_mem_key(const skg_buffer_t *buffer) {
+	return (uint64_t)buffer->_buffer;
+}
+uint64_t skg_mem_key(const skg_tex_t *tex) {
+	return (uint64_t)tex->_id << 1 | 1;
+}
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+uint64_t skg_capture_id(const skg_buffer_t *buffer) {
+	return (uint64_t)buffer->_buffer;
+}
+uint64_t skg_capture_id(const skg_shader_t *shader) {
+	return shader->_vertex ? (uint64_t)shader->_vertex : (uint64_t)shader->_compute;
+}
+uint64_t skg_capture_id(const skg_tex_t *tex) {
+	// _texture is recreated when a texture's size changes, so it can't be
+	// used to identify the texture.
+	return tex->_id;
+}
+#endif
+
 #endif
 
 #ifdef SKG_OPENGL
@@ -3267,6 +5048,8 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <mutex>
+#include <atomic>
 
 ///////////////////////////////////////////
 
@@ -3274,6 +5057,9 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	#include <emscripten.h>
 	#include <emscripten/html5.h>
 	#include <GLES3/gl32.h>
+	// Emscripten implements this with WebGL2's getBufferSubData, but the
+	// GLES headers don't declare it.
+	extern "C" void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void *data);
 #elif defined(_SKG_GL_LOAD_EGL)
 	#include <EGL/egl.h>
 	#include <EGL/eglext.h>
@@ -3282,6 +5068,17 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	EGLContext egl_context;
 	EGLConfig  egl_config;
 	EGLSurface egl_temp_surface;
+	bool       egl_headless = false;
+	EGLContext egl_upload_context = EGL_NO_CONTEXT;
+	EGLSurface egl_upload_surface = EGL_NO_SURFACE;
+
+	const EGLint egl_context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 3,
+		EGL_NONE };
+
+	#ifndef EGL_PLATFORM_SURFACELESS_MESA
+	#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+	#endif
 #elif defined(_SKG_GL_LOAD_GLX)
 	#include <X11/Xutil.h>
 	#include <X11/Xlib.h>
@@ -3297,6 +5094,7 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	HWND  gl_hwnd;
 	HDC   gl_hdc;
 	HGLRC gl_hrc;
+	HGLRC gl_upload_hrc;
 #endif
 
 ///////////////////////////////////////////
@@ -3329,6 +5127,15 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	wglChoosePixelFormatARB_proc    wglChoosePixelFormatARB;
 	wglCreateContextAttribsARB_proc wglCreateContextAttribsARB;
 	wglSwapIntervalEXT_proc         wglSwapIntervalEXT;
+
+	const int wgl_context_attribs[] = {
+		WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+		WGL_CONTEXT_MINOR_VERSION_ARB, 3,
+#if !defined(NDEBUG)
+		WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
+#endif
+		WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+		0 };
 #endif
 
 #ifdef _SKG_GL_LOAD_GLX
@@ -3363,6 +5170,18 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	static GLXFBConfig  glxFBConfig;
 	static GLXDrawable  glxDrawable;
 	static GLXContext   glxContext;
+	static GLXContext   glxUploadContext;
+
+	static const int glx_context_attribs[] = {
+		GLX_RENDER_TYPE,               GLX_RGBA_TYPE,
+		GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
+		GLX_CONTEXT_MINOR_VERSION_ARB, 5,
+#if !defined(NDEBUG)
+		GLX_CONTEXT_FLAGS_ARB,         GLX_CONTEXT_DEBUG_BIT_ARB,
+#endif
+		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+		0
+	};
 #endif
 
 #ifdef _SKG_GL_MAKE_FUNCTIONS
@@ -3588,7 +5407,14 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 #define GL_COMPILE_STATUS 0x8B81
 #define GL_LINK_STATUS 0x8B82
 #define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_VENDOR 0x1F00
+#define GL_COMPLETION_STATUS_KHR 0x91B1
 #define GL_NUM_EXTENSIONS 0x821D
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MINOR_VERSION 0x821C
 #define GL_EXTENSIONS 0x1F03
 
 #define GL_DEBUG_OUTPUT                0x92E0
@@ -3599,6 +5425,28 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 #define GL_DEBUG_SEVERITY_LOW          0x9148
 #define GL_DEBUG_SOURCE_APPLICATION    0x824A
 
+#define GL_TIMESTAMP                   0x8E28
+#define GL_QUERY_RESULT                0x8866
+#define GL_QUERY_RESULT_AVAILABLE      0x8867
+#define GL_GPU_DISJOINT_EXT            0x8FBB
+
+#define GL_PIXEL_PACK_BUFFER           0x88EB
+#define GL_STREAM_READ                 0x88E1
+#define GL_MAP_READ_BIT                0x0001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE  0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT     0x00000001
+#define GL_TIMEOUT_EXPIRED             0x911B
+#define GL_COPY_READ_BUFFER            0x8F36
+#define GL_COPY_WRITE_BUFFER           0x8F37
+#define GL_BUFFER_UPDATE_BARRIER_BIT   0x00000200
+#define GL_COMMAND_BARRIER_BIT         0x00000040
+#define GL_DRAW_INDIRECT_BUFFER        0x8F3F
+#define GL_MAP_WRITE_BIT               0x0002
+#define GL_MAP_PERSISTENT_BIT          0x0040
+#define GL_MAP_COHERENT_BIT            0x0080
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT        0x8A34
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+
 // Reference from here:
 // https://github.com/ApoorvaJ/Papaya/blob/3808e39b0f45d4ca4972621c847586e4060c042a/src/libs/gl_lite.h
 
@@ -3665,6 +5513,11 @@ GLE(void,     glTexParameteri,           uint32_t target, uint32_t pname, int32_
 GLE(void,     glGetInternalformativ,     uint32_t target, uint32_t internalformat, uint32_t pname, int32_t bufSize, int32_t *params)\
 GLE(void,     glGetTexLevelParameteriv,  uint32_t target, int32_t level, uint32_t pname, int32_t *params) \
 GLE(void,     glTexParameterf,           uint32_t target, uint32_t pname, float param) \
+GLE(void,     glGenSamplers,             int32_t n, uint32_t *samplers) \
+GLE(void,     glDeleteSamplers,          int32_t n, const uint32_t *samplers) \
+GLE(void,     glBindSampler,             uint32_t unit, uint32_t sampler) \
+GLE(void,     glSamplerParameteri,       uint32_t sampler, uint32_t pname, int32_t param) \
+GLE(void,     glSamplerParameterf,       uint32_t sampler, uint32_t pname, float param) \
 GLE(void,     glTexImage2D,              uint32_t target, int32_t level, int32_t internalformat, int32_t width, int32_t height, int32_t border, uint32_t format, uint32_t type, const void *data) \
 GLE(void,     glCompressedTexImage2D,    uint32_t target, int32_t level, uint32_t internalformat, uint32_t width, uint32_t height, int32_t border, uint32_t imageSize, const void *data) \
 GLE(void,     glTexStorage2D,            uint32_t target, uint32_t levels, uint32_t internalformat, uint32_t width, uint32_t height) \
@@ -3688,10 +5541,20 @@ GLE(void,     glUniform4fv,              int32_t location, int32_t count, const
 GLE(void,     glDeleteVertexArrays,      int32_t n, const uint32_t *arrays) \
 GLE(void,     glEnableVertexAttribArray, uint32_t index) \
 GLE(void,     glVertexAttribPointer,     uint32_t index, int32_t size, uint32_t type, uint8_t normalized, int32_t stride, const void *pointer) \
+GLE(void,     glVertexAttribIPointer,    uint32_t index, int32_t size, uint32_t type, int32_t stride, const void *pointer) \
+GLE(void,     glDisableVertexAttribArray,uint32_t index) \
+GLE(void,     glVertexAttrib4f,          uint32_t index, float x, float y, float z, float w) \
+GLE(void,     glVertexAttribFormat,      uint32_t index, int32_t size, uint32_t type, uint8_t normalized, uint32_t offset) \
+GLE(void,     glVertexAttribIFormat,     uint32_t index, int32_t size, uint32_t type, uint32_t offset) \
+GLE(void,     glVertexAttribBinding,     uint32_t index, uint32_t binding) \
 GLE(void,     glUniform1i,               int32_t location, int32_t v0) \
+GLE(void,     glProgramUniform1i,        uint32_t program, int32_t location, int32_t v0) \
 GLE(void,     glDrawElementsInstanced,   uint32_t mode, int32_t count, uint32_t type, const void *indices, int32_t primcount) \
 GLE(void,     glDrawElementsInstancedBaseVertex,   uint32_t mode, int32_t count, uint32_t type, const void *indices, int32_t instancecount, int32_t basevertex) \
 GLE(void,     glDrawElements,            uint32_t mode, int32_t count, uint32_t type, const void *indices) \
+GLE(void,     glDrawElementsIndirect,    uint32_t mode, uint32_t type, const void *indirect) \
+GLE(void,     glMultiDrawElementsIndirect,    uint32_t mode, uint32_t type, const void *indirect, int32_t drawcount, int32_t stride) \
+GLE(void,     glMultiDrawElementsIndirectEXT, uint32_t mode, uint32_t type, const void *indirect, int32_t drawcount, int32_t stride) \
 GLE(void,     glDebugMessageCallback,    GLDEBUGPROC callback, const void *userParam) \
 GLE(void,     glBindBufferBase,          uint32_t target, uint32_t index, uint32_t buffer) \
 GLE(void,     glBufferSubData,           uint32_t target, int64_t offset, int32_t size, const void *data) \
@@ -3705,6 +5568,31 @@ GLE(void,     glDispatchCompute,         uint32_t num_groups_x, uint32_t num_gro
 GLE(void,     glObjectLabel,             uint32_t identifier, uint32_t name, uint32_t length, const char* label) \
 GLE(void,     glPushDebugGroupKHR,       uint32_t source, uint32_t id, uint32_t length, const char* message) \
 GLE(void,     glPopDebugGroupKHR,        void) \
+GLE(void,     glGenQueries,              int32_t n, uint32_t *ids) \
+GLE(void,     glDeleteQueries,           int32_t n, const uint32_t *ids) \
+GLE(void,     glQueryCounter,            uint32_t id, uint32_t target) \
+GLE(void,     glQueryCounterEXT,         uint32_t id, uint32_t target) \
+GLE(void,     glGetQueryObjectuiv,       uint32_t id, uint32_t pname, uint32_t *params) \
+GLE(void,     glGetQueryObjectui64v,     uint32_t id, uint32_t pname, uint64_t *params) \
+GLE(void,     glGetQueryObjectui64vEXT,  uint32_t id, uint32_t pname, uint64_t *params) \
+GLE(void *,   glFenceSync,               uint32_t condition, uint32_t flags) \
+GLE(uint32_t, glClientWaitSync,          void *sync, uint32_t flags, uint64_t timeout) \
+GLE(void,     glDeleteSync,              void *sync) \
+GLE(void *,   glMapBufferRange,          uint32_t target, int64_t offset, int64_t length, uint32_t access) \
+GLE(uint8_t,  glUnmapBuffer,             uint32_t target) \
+GLE(void,     glCopyBufferSubData,       uint32_t read_target, uint32_t write_target, int64_t read_offset, int64_t write_offset, int64_t size) \
+GLE(void,     glMemoryBarrier,           uint32_t barriers) \
+GLE(void,     glBufferStorage,           uint32_t target, int64_t size, const void *data, uint32_t flags) \
+GLE(void,     glBufferStorageEXT,        uint32_t target, int64_t size, const void *data, uint32_t flags) \
+GLE(void,     glBindBufferRange,         uint32_t target, uint32_t index, uint32_t buffer, int64_t offset, int64_t size) \
+GLE(void,     glBindBuffersRange,        uint32_t target, uint32_t first, int32_t count, const uint32_t *buffers, const intptr_t *offsets, const intptr_t *sizes) \
+GLE(void,     glBindTextures,            uint32_t first, int32_t count, const uint32_t *textures) \
+GLE(void,     glBindSamplers,            uint32_t first, int32_t count, const uint32_t *samplers) \
+GLE(void,     glGetProgramBinary,        uint32_t program, int32_t buf_size, int32_t *length, uint32_t *binary_format, void *binary) \
+GLE(void,     glProgramBinary,           uint32_t program, uint32_t binary_format, const void *binary, int32_t length) \
+GLE(void,     glProgramParameteri,       uint32_t program, uint32_t pname, int32_t value) \
+GLE(void,     glMaxShaderCompilerThreadsKHR, uint32_t count) \
+GLE(void,     glMaxShaderCompilerThreadsARB, uint32_t count) \
 GLE(const char *, glGetString,           uint32_t name) \
 GLE(const char *, glGetStringi,          uint32_t name, uint32_t index)
 
@@ -3740,9 +5628,39 @@ static void gl_load_extensions( ) {
 
 ///////////////////////////////////////////
 
+#define SKG_GL_MAX_ATTRIBS 16
+// Cache value for bindings the state cache can't vouch for
+#define SKG_GL_UNKNOWN     0xFFFFFFFF
+
+// A vertex array object, and the shader inputs its attributes are currently
+// pointed at. With vertex binding points, these are shared by every mesh of
+// a format, otherwise each mesh has its own.
+typedef struct gl_layout_t {
+	uint32_t vao;
+	uint32_t vert_buffer;
+	int32_t  vert_fmt;
+	uint32_t enabled;
+	uint64_t inputs;
+} gl_layout_t;
+
+#define SKG_GL_BIND_SLOTS 32
+
+typedef struct gl_buffer_range_t {
+	uint32_t buffer;
+	uint32_t offset;
+	uint32_t size;
+} gl_buffer_range_t;
+
 typedef struct gl_pipeline_state_t {
 	uint32_t          program;
 	uint32_t          layout;
+	skg_shader_meta_t*meta;
+	uint64_t          inputs;
+	// The bound mesh, applied at draw time once the shader is known too
+	gl_layout_t      *mesh;
+	uint32_t          mesh_verts;
+	uint32_t          mesh_inds;
+	int32_t           mesh_fmt;
 	skg_transparency_ transparency;
 	skg_cull_         cull;
 	skg_depth_test_   depth_test_type;
@@ -3752,19 +5670,184 @@ typedef struct gl_pipeline_state_t {
 	skg_color_write_  color_write;
 	bool              scissor;
 	bool              wireframe;
-	uint32_t          tex_bind[32];
-	uint32_t          buffer_bind[4];
+	uint32_t          tex_bind    [SKG_GL_BIND_SLOTS];
+	uint32_t          sampler_bind[SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ubo_bind    [SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ssbo_bind   [SKG_GL_BIND_SLOTS];
+	uint32_t          buffer_bind[5];
 } gl_pipeline_state_t;
 gl_pipeline_state_t gl_pipeline = {};
 
+// Shader resources bound since the last draw or dispatch. Dirty slots are
+// checked against gl_pipeline right before the GPU needs them, so only
+// real changes reach GL, and with multi-bind a run of them is one call.
+// Slots without a dirty bit always match gl_pipeline.
+typedef struct gl_bind_queue_t {
+	uint32_t          tex       [SKG_GL_BIND_SLOTS];
+	uint32_t          tex_target[SKG_GL_BIND_SLOTS];
+	uint32_t          sampler   [SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ubo       [SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ssbo      [SKG_GL_BIND_SLOTS];
+	uint32_t          tex_dirty;
+	uint32_t          ubo_dirty;
+	uint32_t          ssbo_dirty;
+} gl_bind_queue_t;
+gl_bind_queue_t gl_binds = {};
+
+inline bool gl_stat_check(skg_stat_ stat, bool changed) {
+	if (changed) SKG_STAT_MISS(stat);
+	else         SKG_STAT_HIT (stat);
+	return changed;
+}
+
 #if !defined(SKG_GL_EXPLICIT_STATE)
-#define PIPELINE_CHECK(state_cache, state) if ((state_cache) != (state)) { state_cache = (state);
+#define PIPELINE_CHECK(stat, state_cache, state) if (gl_stat_check(stat, (state_cache) != (state))) { state_cache = (state);
 #define PIPELINE_CHECK_END }
 #else
-#define PIPELINE_CHECK(state_cache, state)
-#define PIPELINE_CHECK_END
+#define PIPELINE_CHECK(stat, state_cache, state) { SKG_STAT_MISS(stat);
+#define PIPELINE_CHECK_END }
 #endif
 
+#define SKG_GL_TIMER_COUNT 256
+#define SKG_GL_TIMER_DEPTH 16
+
+typedef struct gl_timer_t {
+	char     name[32];
+	int32_t  depth;
+	uint64_t frame;
+	uint32_t queries[2];
+	bool     ended;
+} gl_timer_t;
+
+gl_timer_t         gl_timers       [SKG_GL_TIMER_COUNT];
+skg_timer_result_t gl_timer_results[SKG_GL_TIMER_COUNT];
+int32_t            gl_timer_result_count = 0;
+uint32_t           gl_timer_head         = 0;
+uint32_t           gl_timer_tail         = 0;
+int32_t            gl_timer_stack[SKG_GL_TIMER_DEPTH];
+int32_t            gl_timer_stack_count  = 0;
+uint64_t           gl_frame              = 0;
+uint32_t           gl_readback_fbo       = 0;
+
+bool               gl_buffer_storage     = false;
+bool               gl_vertex_binding     = false;
+bool               gl_sampler_objects    = false;
+bool               gl_multi_bind         = false;
+bool               gl_program_binary     = false;
+bool               gl_parallel_compile   = false;
+// Resources can be made on other threads through a second, shared context.
+// Only one thread holds it at a time, and render thread caches are left
+// alone while it does.
+std::mutex         gl_upload_mtx;
+thread_local bool  gl_upload_thread      = false;
+thread_local bool  gl_render_thread      = false;
+
+// Resources destroyed while deferred destruction is on wait here until a
+// fence shows the GPU is past the frame they were destroyed in. Any thread
+// can push onto the queue, and the render thread takes the whole list at
+// once, so a compare and swap is all it needs.
+typedef enum gl_destroy_type_ {
+	gl_destroy_type_buffer,
+	gl_destroy_type_tex,
+	gl_destroy_type_shader,
+} gl_destroy_type_;
+typedef struct gl_destroy_t {
+	struct gl_destroy_t *next;
+	gl_destroy_type_     type;
+	union {
+		skg_buffer_t buffer;
+		skg_tex_t    tex;
+		skg_shader_t shader;
+	};
+} gl_destroy_t;
+typedef struct gl_destroy_batch_t {
+	gl_destroy_t *items;
+	void         *fence;
+} gl_destroy_batch_t;
+std::atomic<bool>          gl_destroy_deferred    = { false };
+std::atomic<gl_destroy_t*> gl_destroy_queue       = { nullptr };
+gl_destroy_batch_t        *gl_destroy_batches     = nullptr;
+int32_t                    gl_destroy_batch_count = 0;
+int32_t                    gl_destroy_batch_cap   = 0;
+int32_t            gl_ubo_align          = 256;
+int32_t            gl_ssbo_align         = 256;
+
+#define SKG_GL_TRANSIENT_FRAMES 3
+#define SKG_GL_TRANSIENT_MIN    (64 * 1024)
+
+// One uniform buffer split into a section per frame. Each frame fills its
+// section from the start, and the section is fenced when the frame ends.
+// Dynamic buffer writes are staged here on their way to the GPU.
+typedef struct gl_transient_t {
+	uint32_t buffer;
+	uint8_t *map;
+	uint32_t frame_size;
+	uint32_t frame_index;
+	uint32_t used;
+	// Set by skg_draw_begin, and cleared when the section runs out
+	bool     frame_marked;
+	void    *fences[SKG_GL_TRANSIENT_FRAMES];
+	// Outgrown buffers, kept until the frame that used them ends
+	uint32_t*retired;
+	int32_t  retired_count;
+} gl_transient_t;
+gl_transient_t     gl_transient          = {};
+// Set by compute dispatches, so indirect draws know to wait on their writes
+bool               gl_compute_pending    = false;
+// Shared vertex layouts, keyed by vertex format and shader inputs
+gl_layout_t       *gl_layouts            = nullptr;
+int32_t            gl_layout_count       = 0;
+int32_t            gl_layout_cap         = 0;
+int32_t            gl_layout_last        = 0;
+// Shared sampler objects, keyed by the settings that went into them
+typedef struct gl_sampler_t {
+	uint64_t key;
+	uint32_t sampler;
+} gl_sampler_t;
+gl_sampler_t      *gl_samplers           = nullptr;
+int32_t            gl_sampler_count      = 0;
+int32_t            gl_sampler_cap        = 0;
+std::mutex         gl_sampler_mtx;
+// Programs still compiling on the driver's threads. Finished programs
+// leave the list, and ones that failed to link move to the failed list,
+// which is usually empty. Failed programs stay alive until
+// skg_shader_destroy, since copies of the skg_shader_t may refer to them.
+typedef struct gl_program_pending_t {
+	uint32_t           program;
+	skg_shader_meta_t *meta;
+	uint32_t           stages[3];
+	char              *cache_file;
+	uint64_t           cache_key;
+} gl_program_pending_t;
+gl_program_pending_t *gl_programs_pending      = nullptr;
+int32_t               gl_program_pending_count = 0;
+int32_t               gl_program_pending_cap   = 0;
+uint32_t             *gl_programs_failed       = nullptr;
+int32_t               gl_program_failed_count  = 0;
+int32_t               gl_program_failed_cap    = 0;
+// Format of the bound index buffer, every draw path reads from these
+uint32_t           gl_ind_type           = GL_UNSIGNED_INT;
+uint32_t           gl_ind_size           = sizeof(uint32_t);
+
+#define SKG_GL_DIRTY_RANGES 16
+
+// CPU side copy of a buffer's ranged writes that haven't reached the GPU
+// yet. Ranges are kept sorted, and touching ones are merged, so a flush
+// is one upload per contiguous run of changes.
+typedef struct gl_buffer_dirty_t {
+	uint32_t  buffer;
+	uint8_t  *shadow;
+	int32_t   range_count;
+	uint32_t  ranges[SKG_GL_DIRTY_RANGES][2];
+	bool      queued;
+} gl_buffer_dirty_t;
+
+// Buffers with pending ranged writes. Bound buffers can be written to
+// after the bind, so the queue is flushed before each draw and dispatch.
+gl_buffer_dirty_t **gl_dirty_queue       = nullptr;
+int32_t             gl_dirty_queue_count = 0;
+int32_t             gl_dirty_queue_cap   = 0;
+
 int32_t     gl_active_width        = 0;
 int32_t     gl_active_height       = 0;
 skg_tex_t  *gl_active_rendertarget = nullptr;
@@ -3782,6 +5865,34 @@ bool gl_tex_fmt_supported[skg_tex_fmt_max] = {};
 uint32_t skg_buffer_type_to_gl   (skg_buffer_type_ type);
 uint32_t skg_tex_fmt_to_gl_type  (skg_tex_fmt_ format);
 uint32_t skg_tex_fmt_to_gl_layout(skg_tex_fmt_ format);
+uint32_t skg_fmt_to_gl_type      (skg_fmt_ format);
+void     gl_readback_prepare     (skg_readback_t *readback, size_t size);
+void     gl_buffer_stage         (uint32_t buffer, uint32_t offset, const void *data, uint32_t size_bytes);
+void     gl_buffer_flush         (skg_buffer_t *buffer);
+void     gl_dirty_upload         (gl_buffer_dirty_t *dirty);
+void     gl_dirty_flush_queue    ();
+void     gl_transient_frame      ();
+void     gl_transient_advance    ();
+uint32_t gl_transient_alloc      (const void *data, uint32_t size_bytes, uint32_t align);
+void     gl_draw_elements        (uint32_t index_start, int32_t index_base, uint32_t index_count, uint32_t instance_count);
+void     gl_ind_format_set       (skg_ind_fmt_ format);
+uint64_t gl_layout_inputs        (const skg_shader_meta_t *meta);
+void     gl_layout_apply         ();
+gl_layout_t *gl_layout_find      (int32_t vert_fmt, uint64_t inputs);
+void     gl_layout_map           (gl_layout_t *layout, uint64_t inputs);
+void     gl_transient_release    ();
+uint32_t gl_sampler_find         (uint32_t wrap, uint32_t filter, uint32_t min_filter, float anisotropy, uint32_t comparison);
+void     gl_transient_free       (uint32_t buffer);
+void     gl_buffer_destroy       (skg_buffer_t *buffer);
+void     gl_tex_destroy          (skg_tex_t    *tex);
+void     gl_shader_destroy       (skg_shader_t *shader);
+void     gl_destroy_frame        ();
+void     gl_destroy_flush        ();
+void     gl_bind_buffer          (bool storage, uint32_t slot, uint32_t buffer, uint32_t offset, uint32_t size);
+void     gl_bind_forget          (uint32_t buffer);
+void     gl_bind_flush           ();
+void     gl_bind_flush_buffers   (bool storage);
+void     gl_bind_flush_textures  ();
 
 ///////////////////////////////////////////
 
@@ -3894,15 +6005,7 @@ int32_t gl_init_wgl() {
 	}
 
 	// Create an OpenGL context
-	int attributes[] = {
-		WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
-		WGL_CONTEXT_MINOR_VERSION_ARB, 3,
-#if !defined(NDEBUG)
-		WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
-#endif
-		WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-		0 };
-	gl_hrc = wglCreateContextAttribsARB( gl_hdc, 0, attributes );
+	gl_hrc = wglCreateContextAttribsARB( gl_hdc, 0, wgl_context_attribs );
 	if (!gl_hrc) {
 		skg_log(skg_log_critical, "Couldn't create GL context!");
 		return false;
@@ -3939,9 +6042,53 @@ int32_t gl_init_emscripten() {
 
 ///////////////////////////////////////////
 
+#if defined(_SKG_GL_LOAD_EGL) && defined(SKG_LINUX_EGL)
+EGLDisplay gl_egl_headless_display() {
+	const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	bool        has_device        = client_extensions != nullptr && strstr(client_extensions, "EGL_EXT_platform_device"      ) != nullptr;
+	bool        has_surfaceless   = client_extensions != nullptr && strstr(client_extensions, "EGL_MESA_platform_surfaceless") != nullptr;
+
+	PFNEGLQUERYDEVICESEXTPROC eglQueryDevicesEXT = has_device
+		? (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT")
+		: nullptr;
+	if (eglQueryDevicesEXT) {
+		const int32_t MAX_DEVICES = 10;
+		EGLDeviceEXT  devices[MAX_DEVICES];
+		EGLint        device_count = 0;
+		eglQueryDevicesEXT(MAX_DEVICES, devices, &device_count);
+		skg_logf(skg_log_info, "Found %d EGL devices.", device_count);
+
+		// Not every device can make a display, software devices and
+		// devices missing their DRM node will fail to initialize.
+		for (int32_t i = 0; i < device_count; i++) {
+			EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+				skg_logf(skg_log_info, "Running headless on EGL device %d", i);
+				return display;
+			}
+			eglGetError();
+		}
+	}
+
+	if (has_surfaceless) {
+		EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+			skg_log(skg_log_info, "Running headless on the surfaceless EGL platform");
+			return display;
+		}
+		eglGetError();
+	}
+
+	skg_log(skg_log_warning, "No EGL device or surfaceless platform available, falling back to the default EGL display");
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif
+
+///////////////////////////////////////////
+
 int32_t gl_init_egl() {
 #ifdef _SKG_GL_LOAD_EGL
-	const EGLint attribs[] = {
+	EGLint attribs[] = {
 		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT | EGL_WINDOW_BIT,
 		EGL_CONFORMANT,   EGL_OPENGL_ES3_BIT_KHR,
 		EGL_BLUE_SIZE,  8,
@@ -3951,9 +6098,6 @@ int32_t gl_init_egl() {
 		EGL_DEPTH_SIZE, 0,
 		EGL_NONE
 	};
-	EGLint context_attribs[] = { 
-		EGL_CONTEXT_CLIENT_VERSION, 3,
-		EGL_NONE };
 	EGLint format;
 	EGLint numConfigs;
 
@@ -3962,26 +6106,8 @@ int32_t gl_init_egl() {
 		#if defined(SKG_LINUX_EGL)
 		const char* display = getenv("DISPLAY");
 		if (!display || display[0] == '\0') {
-			const int MAX_DEVICES = 10;
-			EGLDeviceEXT eglDevs[MAX_DEVICES];
-			EGLint numDevices = 0;
-
-			PFNEGLQUERYDEVICESEXTPROC eglQueryDevicesEXT = 
-				(PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
-			if (!eglQueryDevicesEXT) {
-				skg_log(skg_log_critical, "Failed to get eglQueryDevicesEXT");
-				return 0;
-			}
-
-			eglQueryDevicesEXT(MAX_DEVICES, eglDevs, &numDevices);
-			skg_logf(skg_log_info, "Found %d EGL devices.", numDevices);
-			for (int idx = 0; idx < numDevices; idx++) {
-				EGLDisplay disp = eglGetPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, eglDevs[idx], 0);
-				if (disp != EGL_NO_DISPLAY) {
-					egl_display = disp;
-					break;
-				}
-			}
+			egl_headless = true;
+			egl_display  = gl_egl_headless_display();
 		} else {
 			egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
 		}
@@ -3989,7 +6115,7 @@ int32_t gl_init_egl() {
 		egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
 		#endif
 
-		if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglGetDisplay"); return 0; }
+		if (egl_display == EGL_NO_DISPLAY || eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglGetDisplay"); return 0; }
 	}
 
 	int32_t major=0, minor=0;
@@ -4000,12 +6126,15 @@ int32_t gl_init_egl() {
 	snprintf(version, sizeof(version), "EGL version %d.%d", major, minor);
 	skg_log(skg_log_info, version);
 
+	// Device and surfaceless displays have no windows to make surfaces for.
+	if (egl_headless) attribs[1] = EGL_PBUFFER_BIT;
+
 	eglChooseConfig   (egl_display, attribs, &egl_config, 1, &numConfigs);
-	if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglChooseConfig"   ); return 0; }
+	if (eglGetError() != EGL_SUCCESS || numConfigs == 0) { skg_log(skg_log_critical, "Err eglChooseConfig"   ); return 0; }
 	eglGetConfigAttrib(egl_display, egl_config, EGL_NATIVE_VISUAL_ID, &format);
 	if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglGetConfigAttrib"); return 0; }
 
-	egl_context = eglCreateContext      (egl_display, egl_config, nullptr, context_attribs);
+	egl_context = eglCreateContext      (egl_display, egl_config, nullptr, egl_context_attribs);
 	if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglCreateContext"  ); return 0; }
 
 	const char* egl_extensions       = eglQueryString(egl_display, EGL_EXTENSIONS);
@@ -4053,17 +6182,7 @@ int32_t gl_init_glx() {
 	GLXContext old_ctx = glXCreateContext(xDisplay, visualInfo, NULL, true);
 	glXMakeCurrent(xDisplay, glxDrawable, old_ctx);
 
-	int ctx_attribute_list[] = {
-		GLX_RENDER_TYPE,               GLX_RGBA_TYPE,
-		GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
-		GLX_CONTEXT_MINOR_VERSION_ARB, 5,
-#if !defined(NDEBUG)
-		GLX_CONTEXT_FLAGS_ARB,         GLX_CONTEXT_DEBUG_BIT_ARB,
-#endif
-		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
-		0
-	};
-	glxContext = glXCreateContextAttribsARB(xDisplay, glxFBConfig, NULL, true, ctx_attribute_list);
+	glxContext = glXCreateContextAttribsARB(xDisplay, glxFBConfig, NULL, true, glx_context_attribs);
 	glXDestroyContext(xDisplay, old_ctx);
 	glXMakeCurrent(xDisplay, glxDrawable, glxContext);
 
@@ -4073,7 +6192,114 @@ int32_t gl_init_glx() {
 
 ///////////////////////////////////////////
 
+// Makes the upload context current on this thread, creating it the first
+// time. It shares objects with the main context, but not container objects
+// like VAOs and framebuffers.
+bool gl_upload_context_make() {
+#if   defined(_SKG_GL_LOAD_EGL)
+	if (egl_upload_context == EGL_NO_CONTEXT) {
+		egl_upload_context = eglCreateContext(egl_display, egl_config, egl_context, egl_context_attribs);
+		if (egl_upload_context == EGL_NO_CONTEXT) { skg_log(skg_log_warning, "Err eglCreateContext for uploads"); return false; }
+
+		// A surface can only be current on one thread, so this can't share
+		// the main context's temporary one.
+		if (egl_temp_surface != nullptr) {
+			EGLint temp_buffer_attr[] = {
+				EGL_WIDTH,  1,
+				EGL_HEIGHT, 1,
+				EGL_NONE };
+			egl_upload_surface = eglCreatePbufferSurface(egl_display, egl_config, temp_buffer_attr);
+		}
+	}
+	return eglMakeCurrent(egl_display, egl_upload_surface, egl_upload_surface, egl_upload_context) == EGL_TRUE;
+#elif defined(_SKG_GL_LOAD_GLX)
+	if (glxUploadContext == nullptr) {
+		glxUploadContext = glXCreateContextAttribsARB(xDisplay, glxFBConfig, glxContext, true, glx_context_attribs);
+		if (glxUploadContext == nullptr) { skg_log(skg_log_warning, "Couldn't create GL context for uploads!"); return false; }
+	}
+	return glXMakeCurrent(xDisplay, glxDrawable, glxUploadContext);
+#elif defined(_SKG_GL_LOAD_WGL)
+	if (gl_upload_hrc == nullptr) {
+		gl_upload_hrc = wglCreateContextAttribsARB(gl_hdc, gl_hrc, wgl_context_attribs);
+		if (gl_upload_hrc == nullptr) { skg_log(skg_log_warning, "Couldn't create GL context for uploads!"); return false; }
+	}
+	return wglMakeCurrent(gl_hdc, gl_upload_hrc);
+#else
+	skg_log(skg_log_warning, "Uploads from other threads aren't supported on this platform.");
+	return false;
+#endif
+}
+
+///////////////////////////////////////////
+
+void gl_upload_context_release() {
+#if   defined(_SKG_GL_LOAD_EGL)
+	eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#elif defined(_SKG_GL_LOAD_GLX)
+	glXMakeCurrent(xDisplay, 0, nullptr);
+#elif defined(_SKG_GL_LOAD_WGL)
+	wglMakeCurrent(NULL, NULL);
+#endif
+}
+
+///////////////////////////////////////////
+
+void gl_upload_context_destroy() {
+#if   defined(_SKG_GL_LOAD_EGL)
+	if (egl_upload_surface != EGL_NO_SURFACE) eglDestroySurface(egl_display, egl_upload_surface);
+	if (egl_upload_context != EGL_NO_CONTEXT) eglDestroyContext(egl_display, egl_upload_context);
+	egl_upload_surface = EGL_NO_SURFACE;
+	egl_upload_context = EGL_NO_CONTEXT;
+#elif defined(_SKG_GL_LOAD_GLX)
+	if (glxUploadContext) glXDestroyContext(xDisplay, glxUploadContext);
+	glxUploadContext = nullptr;
+#elif defined(_SKG_GL_LOAD_WGL)
+	if (gl_upload_hrc) wglDeleteContext(gl_upload_hrc);
+	gl_upload_hrc = nullptr;
+#endif
+}
+
+///////////////////////////////////////////
+
+bool skg_upload_thread_begin() {
+	SKG_TRACE_FUNC();
+	if (gl_render_thread) {
+		skg_log(skg_log_warning, "skg_upload_thread_begin can't be used on the thread that called skg_init.");
+		return false;
+	}
+	gl_upload_mtx.lock();
+	if (!gl_upload_context_make()) {
+		gl_upload_mtx.unlock();
+		return false;
+	}
+	gl_upload_thread = true;
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_upload_thread_end() {
+	SKG_TRACE_FUNC();
+	if (!gl_upload_thread) return;
+
+	// Nothing from this context is safe to use elsewhere until the GPU is
+	// done with it. Waiting here keeps the stall on the worker, and off the
+	// render thread.
+	void *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+	}
+	glDeleteSync(fence);
+
+	gl_upload_context_release();
+	gl_upload_thread = false;
+	gl_upload_mtx.unlock();
+}
+
+///////////////////////////////////////////
+
 void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
+	SKG_TRACE_FUNC();
 #ifdef _SKG_GL_LOAD_GLX
 	xDisplay    =  (Display    *) dpy;
 	visualInfo  =  (XVisualInfo*) vi;
@@ -4085,6 +6311,12 @@ void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
 ///////////////////////////////////////////
 
 void gl_check_exts() {
+	bool    multi_draw_ext     = false;
+	bool    vertex_binding_ext = false;
+	bool    sampler_ext        = false;
+	bool    multi_bind_ext     = false;
+	bool    program_binary_ext = false;
+	bool    parallel_ext       = false;
 	int32_t ct;
 	glGetIntegerv(GL_NUM_EXTENSIONS, &ct);
 	for (int32_t i = 0; i < ct; i++) {
@@ -4098,7 +6330,119 @@ void gl_check_exts() {
 		if (strcmp(ext, "GL_IMG_texture_compression_pvrtc2"              ) == 0) gl_caps[skg_cap_fmt_pvrtc2] = true;
 		if (strcmp(ext, "GL_KHR_texture_compression_astc_ldr"            ) == 0) gl_caps[skg_cap_fmt_astc] = true;
 		if (strcmp(ext, "GL_AMD_compressed_ATC_texture"                  ) == 0) gl_caps[skg_cap_fmt_atc] = true;
+		if (strcmp(ext, "GL_EXT_disjoint_timer_query"                    ) == 0) gl_caps[skg_cap_gpu_timer] = true;
+		if (strcmp(ext, "GL_ARB_buffer_storage"                          ) == 0) gl_buffer_storage = true;
+		if (strcmp(ext, "GL_EXT_buffer_storage"                          ) == 0) gl_buffer_storage = true;
+		if (strcmp(ext, "GL_EXT_multi_draw_indirect"                     ) == 0) multi_draw_ext    = true;
+		if (strcmp(ext, "GL_ARB_vertex_attrib_binding"                   ) == 0) vertex_binding_ext = true;
+		if (strcmp(ext, "GL_ARB_sampler_objects"                         ) == 0) sampler_ext        = true;
+		if (strcmp(ext, "GL_ARB_multi_bind"                              ) == 0) multi_bind_ext     = true;
+		if (strcmp(ext, "GL_ARB_get_program_binary"                      ) == 0) program_binary_ext = true;
+		if (strcmp(ext, "GL_KHR_parallel_shader_compile"                 ) == 0) parallel_ext       = true;
+		if (strcmp(ext, "GL_ARB_parallel_shader_compile"                 ) == 0) parallel_ext       = true;
+	}
+
+#if defined(_SKG_GL_DESKTOP)
+	// Timestamp queries are core in desktop GL
+	gl_caps[skg_cap_gpu_timer] = true;
+#elif defined(_SKG_GL_WEB)
+	// WebGL2 only has GL_TIME_ELAPSED, which can't nest
+	gl_caps[skg_cap_gpu_timer] = false;
+#endif
+#if !defined(_SKG_GL_WEB)
+	// GLES only has these through GL_EXT_disjoint_timer_query
+	if (glQueryCounter        == nullptr) glQueryCounter        = glQueryCounterEXT;
+	if (glGetQueryObjectui64v == nullptr) glGetQueryObjectui64v = glGetQueryObjectui64vEXT;
+	if (glQueryCounter == nullptr || glGetQueryObjectui64v == nullptr || glGenQueries == nullptr)
+		gl_caps[skg_cap_gpu_timer] = false;
+
+	// Loaders hand back stubs for functions the context doesn't have, so
+	// indirect draws go by version. They're core in GL 4.3 and GLES 3.1, and
+	// multi-draw is only an extension on GLES.
+	int32_t major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	int32_t version = major * 10 + minor;
+#if defined(_SKG_GL_ES)
+	if (version < 31) glDrawElementsIndirect = nullptr;
+	glMultiDrawElementsIndirect = multi_draw_ext && glDrawElementsIndirect ? glMultiDrawElementsIndirectEXT : nullptr;
+#else
+	if (version < 43) {
+		glDrawElementsIndirect      = nullptr;
+		glMultiDrawElementsIndirect = nullptr;
 	}
+	(void)multi_draw_ext;
+#endif
+	// Separate vertex formats and buffers are core in GL 4.3 and GLES 3.1
+#if defined(_SKG_GL_ES)
+	gl_vertex_binding = version >= 31;
+	(void)vertex_binding_ext;
+#else
+	gl_vertex_binding = version >= 43 || vertex_binding_ext;
+#endif
+	gl_vertex_binding = gl_vertex_binding && glVertexAttribFormat && glVertexAttribIFormat && glVertexAttribBinding && glBindVertexBuffer;
+
+	// Sampler objects are core in GL 3.3 and GLES 3.0
+#if defined(_SKG_GL_ES)
+	gl_sampler_objects = version >= 30;
+	(void)sampler_ext;
+#else
+	gl_sampler_objects = version >= 33 || sampler_ext;
+#endif
+	gl_sampler_objects = gl_sampler_objects && glGenSamplers && glBindSampler && glSamplerParameteri;
+
+	// Multi-bind is core in GL 4.4, and isn't on GLES at all
+#if defined(_SKG_GL_ES)
+	gl_multi_bind = false;
+	(void)multi_bind_ext;
+#else
+	gl_multi_bind = version >= 44 || multi_bind_ext;
+#endif
+	gl_multi_bind = gl_multi_bind && gl_sampler_objects && glBindBuffersRange && glBindTextures && glBindSamplers;
+
+	// Program binaries are core in GL 4.1 and GLES 3.0, but a driver can
+	// still support zero binary formats, which makes them useless.
+#if defined(_SKG_GL_ES)
+	gl_program_binary = version >= 30;
+	(void)program_binary_ext;
+#else
+	gl_program_binary = version >= 41 || program_binary_ext;
+#endif
+	gl_program_binary = gl_program_binary && glGetProgramBinary && glProgramBinary && glProgramParameteri;
+	if (gl_program_binary) {
+		int32_t binary_formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+		gl_program_binary = binary_formats > 0;
+	}
+
+	// Parallel compiles let us poll a program instead of waiting on it, the
+	// thread limit starts out implementation defined, so ask for all of them.
+	if (glMaxShaderCompilerThreadsKHR == nullptr) glMaxShaderCompilerThreadsKHR = glMaxShaderCompilerThreadsARB;
+	gl_parallel_compile = parallel_ext && glMaxShaderCompilerThreadsKHR;
+	if (gl_parallel_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+	// Persistent mapping is core in GL 4.4, and an extension on GLES
+	if (glBufferStorage == nullptr) glBufferStorage = glBufferStorageEXT;
+	if (glBufferStorage == nullptr || glMapBufferRange == nullptr) gl_buffer_storage = false;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &gl_ssbo_align);
+#else
+	gl_buffer_storage = false;
+	gl_vertex_binding  = false;
+	gl_sampler_objects = true; // WebGL2 always has these
+	gl_multi_bind      = false;
+	gl_program_binary  = false; // WebGL doesn't expose program binaries
+	gl_parallel_compile = false;
+	(void)multi_draw_ext;
+	(void)vertex_binding_ext;
+	(void)sampler_ext;
+	(void)multi_bind_ext;
+	(void)program_binary_ext;
+	(void)parallel_ext;
+#endif
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &gl_ubo_align);
+	if (gl_ubo_align  <= 0) gl_ubo_align  = 256;
+	if (gl_ssbo_align <= 0) gl_ssbo_align = 256;
 	
 #ifndef _SKG_GL_WEB
 	// On some platforms, glPolygonMode is a function and not a function 
@@ -4143,6 +6487,7 @@ void gl_check_exts() {
 ///////////////////////////////////////////
 
 int32_t skg_init(const char *app_name, void *adapter_id) {
+	SKG_TRACE_FUNC();
 #if   defined(_SKG_GL_LOAD_WGL)
 	int32_t result = gl_init_wgl();
 #elif defined(_SKG_GL_LOAD_EGL)
@@ -4154,6 +6499,7 @@ int32_t skg_init(const char *app_name, void *adapter_id) {
 #endif
 	if (!result)
 		return result;
+	gl_render_thread = true;
 
 	// Load OpenGL function pointers
 #ifdef _SKG_GL_MAKE_FUNCTIONS
@@ -4241,9 +6587,58 @@ const char* skg_adapter_name() {
 ///////////////////////////////////////////
 
 void skg_shutdown() {
+	SKG_TRACE_FUNC();
+	gl_destroy_flush();
 	free(gl_adapter_name); gl_adapter_name = nullptr;
 
+	for (int32_t i = 0; i < SKG_GL_TIMER_COUNT; i++) {
+		if (gl_timers[i].queries[0] != 0) glDeleteQueries(2, gl_timers[i].queries);
+		gl_timers[i] = {};
+	}
+	gl_timer_head         = 0;
+	gl_timer_tail         = 0;
+	gl_timer_stack_count  = 0;
+	gl_timer_result_count = 0;
+
+	if (gl_readback_fbo != 0) glDeleteFramebuffers(1, &gl_readback_fbo);
+	gl_readback_fbo = 0;
+	gl_transient_release();
+	free(gl_dirty_queue);
+	gl_dirty_queue       = nullptr;
+	gl_dirty_queue_count = 0;
+	gl_dirty_queue_cap   = 0;
+	for (int32_t i = 0; i < gl_layout_count; i++)
+		glDeleteVertexArrays(1, &gl_layouts[i].vao);
+	free(gl_layouts);
+	gl_layouts      = nullptr;
+	gl_layout_count = 0;
+	gl_layout_cap   = 0;
+	gl_layout_last  = 0;
+	for (int32_t i = 0; i < gl_sampler_count; i++)
+		glDeleteSamplers(1, &gl_samplers[i].sampler);
+	free(gl_samplers);
+	gl_samplers      = nullptr;
+	gl_sampler_count = 0;
+	gl_sampler_cap   = 0;
+	for (int32_t i = 0; i < gl_program_pending_count; i++)
+		free(gl_programs_pending[i].cache_file);
+	free(gl_programs_pending);
+	gl_programs_pending      = nullptr;
+	gl_program_pending_count = 0;
+	gl_program_pending_cap   = 0;
+	free(gl_programs_failed);
+	gl_programs_failed      = nullptr;
+	gl_program_failed_count = 0;
+	gl_program_failed_cap   = 0;
+	skg_vert_fmt_clear();
+
 	gl_pipeline = {};
+	gl_binds    = {};
+
+	gl_upload_mtx.lock();
+	gl_upload_context_destroy();
+	gl_upload_mtx.unlock();
+	gl_render_thread = false;
 
 #if defined(_SKG_GL_LOAD_WGL)
 	wglMakeCurrent(NULL, NULL);
@@ -4261,54 +6656,174 @@ void skg_shutdown() {
 		if (egl_context != EGL_NO_CONTEXT) eglDestroyContext(egl_display, egl_context);
 		eglTerminate(egl_display);
 	}
-	egl_display = EGL_NO_DISPLAY;
-	egl_context = EGL_NO_CONTEXT;
+	egl_display  = EGL_NO_DISPLAY;
+	egl_context  = EGL_NO_CONTEXT;
+	egl_headless = false;
 #endif
 }
 
 ///////////////////////////////////////////
 
-void skg_draw_begin() {
+void gl_timer_poll() {
+#if !defined(_SKG_GL_WEB)
+	// A disjoint event means the timestamps can't be trusted, so anything
+	// completed during it gets thrown away.
+	int32_t disjoint = 0;
+#if defined(_SKG_GL_ES)
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+#endif
+
+	// Timers complete in the order they were issued, so we can stop at the
+	// first one that isn't ready yet.
+	while (gl_timer_tail != gl_timer_head) {
+		gl_timer_t *timer = &gl_timers[gl_timer_tail % SKG_GL_TIMER_COUNT];
+		if (!timer->ended) break;
+
+		uint32_t available = 0;
+		glGetQueryObjectuiv(timer->queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+
+		uint64_t start = 0, end = 0;
+		glGetQueryObjectui64v(timer->queries[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(timer->queries[1], GL_QUERY_RESULT, &end);
+		if (!disjoint && gl_timer_result_count < SKG_GL_TIMER_COUNT) {
+			skg_timer_result_t *result = &gl_timer_results[gl_timer_result_count];
+			memcpy(result->name, timer->name, sizeof(result->name));
+			result->depth       = timer->depth;
+			result->frame       = timer->frame;
+			result->duration_ns = end > start ? end - start : 0;
+			gl_timer_result_count += 1;
+		}
+		timer->ended   = false;
+		gl_timer_tail += 1;
+	}
+#endif
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_target_discard(skg_tex_t *render_target) {
+void skg_draw_begin() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_frame());
+	if (gl_caps[skg_cap_gpu_timer]) gl_timer_poll();
+	gl_transient_frame();
+	gl_destroy_frame();
+	gl_frame += 1;
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
-	gl_active_rendertarget = render_target;
-	gl_current_framebuffer = render_target == nullptr
-		? 0 
-		: render_target->_framebuffer_layers[layer_idx < 0 ? 0 : layer_idx];
+void skg_deferred_destroy_enable(bool enabled) {
+	gl_destroy_deferred = enabled;
+}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
-	if (render_target) {
-		glViewport(0, 0, render_target->width, render_target->height);
-	} else {
-		glViewport(0, 0, gl_active_width, gl_active_height);
-	}
+///////////////////////////////////////////
 
-#ifndef _SKG_GL_WEB
-	if (render_target == nullptr || render_target->format == skg_tex_fmt_rgba32 || render_target->format == skg_tex_fmt_bgra32) {
-		glEnable(GL_FRAMEBUFFER_SRGB);
-	} else {
-		glDisable(GL_FRAMEBUFFER_SRGB);
-	}
-#endif
+void gl_destroy_push(gl_destroy_t *item) {
+	item->next = gl_destroy_queue.load(std::memory_order_relaxed);
+	while (!gl_destroy_queue.compare_exchange_weak(item->next, item, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_release(gl_destroy_t *items) {
+	while (items != nullptr) {
+		gl_destroy_t *next = items->next;
+		switch (items->type) {
+		case gl_destroy_type_buffer: gl_buffer_destroy(&items->buffer); break;
+		case gl_destroy_type_tex:    gl_tex_destroy   (&items->tex);    break;
+		case gl_destroy_type_shader: gl_shader_destroy(&items->shader); break;
+		}
+		free(items);
+		items = next;
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_frame() {
+	// Fences pass in order, so stop at the first the GPU hasn't reached
+	int32_t done = 0;
+	while (done < gl_destroy_batch_count && glClientWaitSync(gl_destroy_batches[done].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED) {
+		glDeleteSync      (gl_destroy_batches[done].fence);
+		gl_destroy_release(gl_destroy_batches[done].items);
+		done += 1;
+	}
+	if (done > 0) {
+		gl_destroy_batch_count -= done;
+		memmove(gl_destroy_batches, &gl_destroy_batches[done], sizeof(gl_destroy_batch_t) * gl_destroy_batch_count);
+	}
+
+	// Everything queued since last frame was last used before this point
+	gl_destroy_t *items = gl_destroy_queue.exchange(nullptr, std::memory_order_acquire);
+	if (items == nullptr) return;
+
+	if (gl_destroy_batch_count + 1 > gl_destroy_batch_cap) {
+		gl_destroy_batch_cap = gl_destroy_batch_cap == 0 ? 4 : gl_destroy_batch_cap * 2;
+		gl_destroy_batches   = (gl_destroy_batch_t*)realloc(gl_destroy_batches, sizeof(gl_destroy_batch_t) * gl_destroy_batch_cap);
+	}
+	gl_destroy_batches[gl_destroy_batch_count] = { items, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) };
+	gl_destroy_batch_count += 1;
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_flush() {
+	for (int32_t i = 0; i < gl_destroy_batch_count; i++) {
+		glDeleteSync      (gl_destroy_batches[i].fence);
+		gl_destroy_release(gl_destroy_batches[i].items);
+	}
+	gl_destroy_release(gl_destroy_queue.exchange(nullptr, std::memory_order_acquire));
+	free(gl_destroy_batches);
+	gl_destroy_batches     = nullptr;
+	gl_destroy_batch_count = 0;
+	gl_destroy_batch_cap   = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_target_discard(skg_tex_t *render_target) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_target_discard, skg_capture_id(render_target)));
+}
+
+///////////////////////////////////////////
+
+void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_target_bind(render_target ? skg_capture_id(render_target) : 0, layer_idx, mip_level));
+	gl_active_rendertarget = render_target;
+	gl_current_framebuffer = render_target == nullptr
+		? 0 
+		: render_target->_framebuffer_layers[layer_idx < 0 ? 0 : layer_idx];
+
+	glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
+	if (render_target) {
+		glViewport(0, 0, render_target->width, render_target->height);
+	} else {
+		glViewport(0, 0, gl_active_width, gl_active_height);
+	}
+
+#ifndef _SKG_GL_WEB
+	if (render_target == nullptr || render_target->format == skg_tex_fmt_rgba32 || render_target->format == skg_tex_fmt_bgra32) {
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	} else {
+		glDisable(GL_FRAMEBUFFER_SRGB);
+	}
+#endif
 }
 
 ///////////////////////////////////////////
 
 void skg_target_clear(bool depth, const float *clear_color_4) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_target_clear(depth, clear_color_4));
 	uint32_t clear_mask = 0;
 	if (depth) {
 		clear_mask = GL_DEPTH_BUFFER_BIT;
 		// If DepthMask is false, glClear won't clear depth
 		
-		PIPELINE_CHECK(gl_pipeline.depth_write, true)
+		PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_write, true)
 		glDepthMask(true);
 		PIPELINE_CHECK_END
 	}
@@ -4356,6 +6871,8 @@ bool skg_capability(skg_cap_ capability) {
 ///////////////////////////////////////////
 
 void skg_event_begin (const char *name) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_begin(name));
 #if defined(_DEBUG) && !defined(_SKG_GL_WEB)
 	if (glPushDebugGroupKHR)
 		glPushDebugGroupKHR(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
@@ -4365,6 +6882,8 @@ void skg_event_begin (const char *name) {
 ///////////////////////////////////////////
 
 void skg_event_end () {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_end());
 #if defined(_DEBUG) && !defined(_SKG_GL_WEB)
 	if (glPopDebugGroupKHR)
 		glPopDebugGroupKHR();
@@ -4373,35 +6892,353 @@ void skg_event_end () {
 
 ///////////////////////////////////////////
 
+void skg_timer_begin(const char *name) {
+	SKG_TRACE_FUNC();
+	if (!gl_caps[skg_cap_gpu_timer]) return;
+	if (gl_timer_stack_count >= SKG_GL_TIMER_DEPTH) {
+		skg_log(skg_log_warning, "skg_timer_begin nested too deeply, ignoring timer");
+		gl_timer_stack_count += 1;
+		return;
+	}
+
+	// If the GPU is so far behind that the ring is full of unread timers, we
+	// skip this one rather than wait for it.
+	if (gl_timer_head - gl_timer_tail >= SKG_GL_TIMER_COUNT) {
+		gl_timer_stack[gl_timer_stack_count++] = -1;
+		return;
+	}
+
+#if !defined(_SKG_GL_WEB)
+	int32_t     index = gl_timer_head % SKG_GL_TIMER_COUNT;
+	gl_timer_t *timer = &gl_timers[index];
+	if (timer->queries[0] == 0)
+		glGenQueries(2, timer->queries);
+	snprintf(timer->name, sizeof(timer->name), "%s", name ? name : "");
+	timer->depth = gl_timer_stack_count;
+	timer->frame = gl_frame;
+	timer->ended = false;
+	glQueryCounter(timer->queries[0], GL_TIMESTAMP);
+
+	gl_timer_head += 1;
+	gl_timer_stack[gl_timer_stack_count++] = index;
+#endif
+}
+
+///////////////////////////////////////////
+
+void skg_timer_end() {
+	SKG_TRACE_FUNC();
+	if (!gl_caps[skg_cap_gpu_timer]) return;
+	if (gl_timer_stack_count <= 0) {
+		skg_log(skg_log_warning, "skg_timer_end called without a matching skg_timer_begin");
+		return;
+	}
+
+	gl_timer_stack_count -= 1;
+	if (gl_timer_stack_count >= SKG_GL_TIMER_DEPTH) return;
+	int32_t index = gl_timer_stack[gl_timer_stack_count];
+	if (index < 0) return;
+
+#if !defined(_SKG_GL_WEB)
+	glQueryCounter(gl_timers[index].queries[1], GL_TIMESTAMP);
+	gl_timers[index].ended = true;
+#endif
+}
+
+///////////////////////////////////////////
+
+int32_t skg_timer_get_results(skg_timer_result_t *out_results, int32_t max_results) {
+	int32_t count = gl_timer_result_count < max_results ? gl_timer_result_count : max_results;
+	if (count <= 0) return 0;
+
+	memcpy(out_results, gl_timer_results, sizeof(skg_timer_result_t) * count);
+	gl_timer_result_count -= count;
+	memmove(gl_timer_results, &gl_timer_results[count], sizeof(skg_timer_result_t) * gl_timer_result_count);
+	return count;
+}
+
+///////////////////////////////////////////
+
 void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw(index_start, index_base, index_count, instance_count));
+	_skg_stats.draws += 1;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_bind_flush();
+	gl_layout_apply();
+	gl_draw_elements(index_start, index_base, index_count, instance_count);
+}
+
+///////////////////////////////////////////
+
+void gl_draw_elements(uint32_t index_start, int32_t index_base, uint32_t index_count, uint32_t instance_count) {
 #ifdef _SKG_GL_WEB
-	glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, (void*)(index_start*sizeof(uint32_t)), instance_count);
+	glDrawElementsInstanced(GL_TRIANGLES, index_count, gl_ind_type, (void*)(uint64_t)(index_start*gl_ind_size), instance_count);
 #else
-	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, (void*)(index_start*sizeof(uint32_t)), instance_count, index_base);
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count, gl_ind_type, (void*)(uint64_t)(index_start*gl_ind_size), instance_count, index_base);
+#endif
+}
+
+///////////////////////////////////////////
+
+void gl_ind_format_set(skg_ind_fmt_ format) {
+	switch (format) {
+	case skg_ind_fmt_u16: gl_ind_type = GL_UNSIGNED_SHORT; break;
+	case skg_ind_fmt_u8:  gl_ind_type = GL_UNSIGNED_BYTE;  break;
+	default:              gl_ind_type = GL_UNSIGNED_INT;   break;
+	}
+	gl_ind_size = skg_ind_fmt_size(format);
+}
+
+///////////////////////////////////////////
+
+uint64_t gl_layout_inputs(const skg_shader_meta_t *meta) {
+	// FNV-1a over the input list, never 0, since that marks a layout that
+	// hasn't been pointed at any shader yet.
+	uint64_t hash = 14695981039346656037ULL;
+	int32_t  count = meta ? meta->vertex_input_count : 0;
+	for (int32_t i = 0; i < count; i++) {
+		const skg_vert_component_t *input = &meta->vertex_inputs[i];
+		uint8_t bytes[3] = { (uint8_t)input->semantic, input->semantic_slot, (uint8_t)input->format };
+		for (int32_t b = 0; b < 3; b++)
+			hash = (hash ^ bytes[b]) * 1099511628211ULL;
+	}
+	return hash == 0 ? 1 : hash;
+}
+
+///////////////////////////////////////////
+
+void gl_layout_apply() {
+	gl_layout_t *layout = gl_pipeline.mesh;
+	if (gl_vertex_binding && gl_pipeline.mesh_verts != 0)
+		layout = gl_layout_find(gl_pipeline.mesh_fmt, gl_pipeline.inputs);
+	if (layout == nullptr) return;
+
+	PIPELINE_CHECK(skg_stat_layout, gl_pipeline.layout, layout->vao)
+	glBindVertexArray(layout->vao);
+	// The element buffer binding belongs to the VAO, so what's cached no
+	// longer says anything about it.
+	gl_pipeline.buffer_bind[skg_buffer_type_index] = SKG_GL_UNKNOWN;
+	PIPELINE_CHECK_END
+	if (layout->inputs != gl_pipeline.inputs) gl_layout_map(layout, gl_pipeline.inputs);
+
+#if !defined(_SKG_GL_WEB)
+	// Shared layouts only describe the format, the mesh's vertices are a
+	// single bind.
+	if (gl_vertex_binding) {
+		PIPELINE_CHECK(skg_stat_buffer, layout->vert_buffer, gl_pipeline.mesh_verts)
+		glBindVertexBuffer(0, gl_pipeline.mesh_verts, 0, skg_vert_fmt_get(gl_pipeline.mesh_fmt)->stride);
+		PIPELINE_CHECK_END
+	}
+#endif
+	PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_index], gl_pipeline.mesh_inds)
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl_pipeline.mesh_inds);
+	PIPELINE_CHECK_END
+}
+
+///////////////////////////////////////////
+
+gl_layout_t *gl_layout_find(int32_t vert_fmt, uint64_t inputs) {
+	if (gl_layout_last < gl_layout_count &&
+		gl_layouts[gl_layout_last].vert_fmt == vert_fmt &&
+		gl_layouts[gl_layout_last].inputs   == inputs)
+		return &gl_layouts[gl_layout_last];
+
+	for (int32_t i = 0; i < gl_layout_count; i++) {
+		if (gl_layouts[i].vert_fmt == vert_fmt && gl_layouts[i].inputs == inputs) {
+			gl_layout_last = i;
+			return &gl_layouts[i];
+		}
+	}
+
+	if (gl_layout_count + 1 > gl_layout_cap) {
+		gl_layout_cap = gl_layout_cap == 0 ? 8 : gl_layout_cap * 2;
+		gl_layouts    = (gl_layout_t*)realloc(gl_layouts, sizeof(gl_layout_t) * gl_layout_cap);
+	}
+	gl_layout_t *layout = &gl_layouts[gl_layout_count];
+	*layout = {};
+	layout->vert_fmt = vert_fmt;
+	glGenVertexArrays(1, &layout->vao);
+	gl_layout_last   = gl_layout_count;
+	gl_layout_count += 1;
+	return layout;
+}
+
+///////////////////////////////////////////
+
+void gl_layout_map(gl_layout_t *layout, uint64_t inputs) {
+	SKG_STAT_MISS(skg_stat_layout);
+	layout->inputs = inputs;
+
+	// The VAO is already bound. Without vertex binding points, attribute
+	// pointers read from whatever's on GL_ARRAY_BUFFER.
+	if (!gl_vertex_binding) {
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_vertex], layout->vert_buffer)
+		glBindBuffer(GL_ARRAY_BUFFER, layout->vert_buffer);
+		PIPELINE_CHECK_END
+	}
+
+	// Shader inputs are located in the order they're declared. Without
+	// any metadata to match semantics against, components map straight
+	// across.
+	const skg_vert_fmt_t    *fmt         = skg_vert_fmt_get(layout->vert_fmt);
+	const skg_shader_meta_t *meta        = gl_pipeline.meta && gl_pipeline.meta->vertex_input_count > 0 ? gl_pipeline.meta : nullptr;
+	int32_t                  input_count = meta ? meta->vertex_input_count : fmt->component_count;
+	uint32_t                 enabled     = 0;
+	for (int32_t loc = 0; loc < input_count && loc < SKG_GL_MAX_ATTRIBS; loc++) {
+		const skg_vert_component_t *input = meta ? &meta->vertex_inputs[loc] : nullptr;
+		int32_t                     id    = input ? skg_vert_fmt_find(fmt, input->semantic, input->semantic_slot) : loc;
+		if (id < 0) {
+			glVertexAttrib4f(loc, 1, 1, 1, 1);
+			continue;
+		}
+
+		const skg_vert_component_t *com        = &fmt->components[id];
+		uint32_t                    offset     = fmt->offsets[id];
+		uint32_t                    type       = skg_fmt_to_gl_type(com->format);
+		bool                        normalized =
+			com->format == skg_fmt_i16_normalized  || com->format == skg_fmt_i8_normalized ||
+			com->format == skg_fmt_ui16_normalized || com->format == skg_fmt_ui8_normalized;
+		bool                        integer    = input && (input->format == skg_fmt_i32 || input->format == skg_fmt_ui32)
+		                                      && type != GL_FLOAT && type != GL_HALF_FLOAT && !normalized;
+#if !defined(_SKG_GL_WEB)
+		if (gl_vertex_binding) {
+			if (integer) glVertexAttribIFormat(loc, com->count, type,             offset);
+			else         glVertexAttribFormat (loc, com->count, type, normalized, offset);
+			glVertexAttribBinding(loc, 0);
+			enabled |= 1 << loc;
+			continue;
+		}
+#endif
+		if (integer) glVertexAttribIPointer(loc, com->count, type,             fmt->stride, (void*)(uint64_t)offset);
+		else         glVertexAttribPointer (loc, com->count, type, normalized, fmt->stride, (void*)(uint64_t)offset);
+		enabled |= 1 << loc;
+	}
+	for (int32_t loc = 0; loc < SKG_GL_MAX_ATTRIBS; loc++) {
+		uint32_t bit = 1 << loc;
+		if      ( (enabled & bit) && !(layout->enabled & bit)) glEnableVertexAttribArray (loc);
+		else if (!(enabled & bit) &&  (layout->enabled & bit)) glDisableVertexAttribArray(loc);
+	}
+	layout->enabled = enabled;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_indirect(args_buffer, offset, draw_count, stride));
+	if (args_buffer->type != skg_buffer_type_indirect) {
+		skg_log(skg_log_warning, "skg_draw_indirect needs a skg_buffer_type_indirect buffer");
+		return;
+	}
+	if (stride == 0) stride = sizeof(skg_draw_args_t);
+	if (draw_count == 0) return;
+	if (offset % 4 != 0 || stride % 4 != 0) {
+		skg_log(skg_log_warning, "skg_draw_indirect offset and stride need to be multiples of 4");
+		return;
+	}
+	if (offset + (uint64_t)stride * (draw_count - 1) + sizeof(skg_draw_args_t) > args_buffer->_size) {
+		skg_log(skg_log_warning, "skg_draw_indirect is reading past the end of the args buffer");
+		return;
+	}
+
+	_skg_stats.draws += draw_count;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_buffer_flush((skg_buffer_t*)args_buffer);
+	gl_bind_flush();
+	gl_layout_apply();
+
+#if !defined(_SKG_GL_WEB)
+	if (glDrawElementsIndirect) {
+		// Args written by a compute shader need to be visible to the
+		// command processor, not just other shaders.
+		if (gl_compute_pending && glMemoryBarrier) glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+		gl_compute_pending = false;
+
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_indirect], args_buffer->_buffer)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, args_buffer->_buffer);
+		PIPELINE_CHECK_END
+		if (glMultiDrawElementsIndirect) {
+			glMultiDrawElementsIndirect(GL_TRIANGLES, gl_ind_type, (void*)(uint64_t)offset, draw_count, stride);
+		} else {
+			for (uint32_t i = 0; i < draw_count; i++)
+				glDrawElementsIndirect(GL_TRIANGLES, gl_ind_type, (void*)(uint64_t)(offset + i * stride));
+		}
+		return;
+	}
+#endif
+
+	// No indirect draws on this device, so bring the args back and loop on
+	// the CPU. This waits on the GPU, but keeps GPU driven content working.
+	uint8_t *args = (uint8_t*)malloc(args_buffer->_size);
+	skg_buffer_get_contents(args_buffer, args, args_buffer->_size);
+	for (uint32_t i = 0; i < draw_count; i++) {
+		const skg_draw_args_t *draw = (const skg_draw_args_t*)(args + offset + i * stride);
+		gl_draw_elements(draw->index_start, draw->index_base, draw->index_count, draw->instance_count);
+	}
+	free(args);
+}
+
+///////////////////////////////////////////
+
+void skg_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_multi(draws, draw_count));
+	if (draw_count == 0) return;
+	_skg_stats.draws += draw_count;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_bind_flush();
+	gl_layout_apply();
+
+#if !defined(_SKG_GL_WEB)
+	// The args go through this frame's transient memory, so the whole list
+	// is one upload and one draw call.
+	if (glMultiDrawElementsIndirect) {
+		uint32_t offset = gl_transient_alloc(draws, sizeof(skg_draw_args_t) * draw_count, sizeof(uint32_t));
+		skg_stats_upload(sizeof(skg_draw_args_t) * draw_count);
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_indirect], gl_transient.buffer)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gl_transient.buffer);
+		PIPELINE_CHECK_END
+		glMultiDrawElementsIndirect(GL_TRIANGLES, gl_ind_type, (void*)(uint64_t)offset, draw_count, sizeof(skg_draw_args_t));
+		return;
+	}
 #endif
+	for (uint32_t i = 0; i < draw_count; i++)
+		gl_draw_elements(draws[i].index_start, draws[i].index_base, draws[i].index_count, draws[i].instance_count);
 }
 
 ///////////////////////////////////////////
 
 void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_compute(thread_count_x, thread_count_y, thread_count_z));
+	_skg_stats.dispatches += 1;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_bind_flush();
+	gl_compute_pending = true;
 	glDispatchCompute(thread_count_x, thread_count_y, thread_count_z);
 }
 
 ///////////////////////////////////////////
 
 void skg_viewport(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_viewport, xywh));
 	glViewport(xywh[0], xywh[1], xywh[2], xywh[3]);
 }
 
 ///////////////////////////////////////////
 
 void skg_viewport_get(int32_t *out_xywh) {
+	SKG_TRACE_FUNC();
 	glGetIntegerv(GL_VIEWPORT, out_xywh);
 }
 
 ///////////////////////////////////////////
 
 void skg_scissor(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_scissor, xywh));
 	int32_t viewport[4];
 	skg_viewport_get(viewport);
 	glScissor(xywh[0], (viewport[3]-xywh[1])-xywh[3], xywh[2], xywh[3]);
@@ -4410,23 +7247,33 @@ void skg_scissor(const int32_t *xywh) {
 ///////////////////////////////////////////
 
 skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
+	SKG_TRACE_FUNC();
 	skg_buffer_t result = {};
 	result.use     = use;
 	result.type    = type;
 	result.stride  = size_stride;
 	result._target = skg_buffer_type_to_gl(type);
+	if (type == skg_buffer_type_index)
+		result._ind_format = skg_ind_fmt_from_stride(size_stride);
+
+	result._size   = size_count * size_stride;
 
 	glGenBuffers(1, &result._buffer);
 	glBindBuffer(result._target, result._buffer);
-	gl_pipeline.buffer_bind[result.type] = result._buffer;
-	glBufferData(result._target, size_count * size_stride, data, use == skg_use_static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+	if (!gl_upload_thread) gl_pipeline.buffer_bind[result.type] = result._buffer;
+	glBufferData(result._target, result._size, data, use == skg_use_static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+	if (data) skg_stats_upload(result._size);
+	skg_mem_track(skg_mem_key(&result), skg_mem_buffer, result._size);
 
+	SKG_CAPTURE_CALL(skg_capture_buffer_create(&result, data, size_count, size_stride));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(buffer), name);
 	if (buffer->_buffer != 0)
 		glObjectLabel(GL_BUFFER, buffer->_buffer, (uint32_t)strlen(name), name);
 }
@@ -4440,1662 +7287,3966 @@ bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
 ///////////////////////////////////////////
 
 void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
 	if (buffer->use != skg_use_dynamic) {
 		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
 		return;
 	}
+	// Updates go through render thread state, like the binding cache and
+	// the transient buffer.
+	if (gl_upload_thread) {
+		skg_log(skg_log_warning, "Dynamic buffers can't be updated on an upload thread!");
+		return;
+	}
+
+	if (size_bytes > buffer->_size) {
+		skg_log(skg_log_warning, "Attempting to set more data than the buffer can hold!");
+		size_bytes = buffer->_size;
+	}
+
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_contents(buffer, data, size_bytes));
+	skg_stats_upload(size_bytes);
+	// Older ranged writes either get replaced outright, or need to land
+	// before this one.
+	if (buffer->_dirty && buffer->_dirty->range_count > 0) {
+		if (size_bytes == buffer->_size) buffer->_dirty->range_count = 0;
+		else                             gl_buffer_flush(buffer);
+	}
+
+	if (gl_buffer_storage) {
+		gl_buffer_stage(buffer->_buffer, 0, data, size_bytes);
+		return;
+	}
 
-	PIPELINE_CHECK(gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
+	PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
 	glBindBuffer(buffer->_target, buffer->_buffer);
 	PIPELINE_CHECK_END
+	// Orphaning a fully overwritten buffer lets the driver hand us fresh
+	// memory instead of waiting on draws that still use the old contents.
+	if (size_bytes == buffer->_size)
+		glBufferData(buffer->_target, buffer->_size, nullptr, GL_DYNAMIC_DRAW);
 	glBufferSubData(buffer->_target, 0, size_bytes, data);
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
-	if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute) {
-		glBindBufferBase(buffer->_target, bind.slot, buffer->_buffer);
-		gl_pipeline.buffer_bind[buffer->type] = buffer->_buffer;
-	} else {
-		PIPELINE_CHECK(gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
-		glBindBuffer(buffer->_target, buffer->_buffer);
-		PIPELINE_CHECK_END
-	}
+void gl_buffer_stage(uint32_t buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	// The data lands in this frame's part of the persistently mapped
+	// transient buffer, and the GPU copies it over in order with the draws
+	// around it. Draws before this keep the old contents, draws after see
+	// the new ones, and the CPU never waits on either. Everything else that
+	// uses the copy targets binds them first, so they're left bound.
+	uint32_t src = gl_transient_alloc(data, size_bytes, 16);
+	glBindBuffer       (GL_COPY_READ_BUFFER,  gl_transient.buffer);
+	glBindBuffer       (GL_COPY_WRITE_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, src, offset, size_bytes);
+	// Indirect buffers can live on this target too, see skg_buffer_type_to_gl
+	gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_clear(skg_bind_t bind) {
-	if (bind.stage_bits == skg_stage_compute) {
-		if (bind.register_type == skg_register_constant) {
-			glBindBufferBase(GL_UNIFORM_BUFFER, bind.slot, 0);
-			gl_pipeline.buffer_bind[skg_buffer_type_constant] = 0;
-		}
-		if (bind.register_type == skg_register_readwrite) {
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bind.slot, 0);
-			gl_pipeline.buffer_bind[skg_buffer_type_compute] = 0;
-		}
+bool gl_dirty_add(gl_buffer_dirty_t *dirty, uint32_t start, uint32_t end) {
+	// Swallow any ranges this one touches
+	int32_t insert = 0;
+	for (int32_t i = 0; i < dirty->range_count; ) {
+		uint32_t *range = dirty->ranges[i];
+		if (range[1] < start) { insert = i + 1; i++; continue; }
+		if (range[0] > end  ) break;
+
+		if (range[0] < start) start = range[0];
+		if (range[1] > end  ) end   = range[1];
+		memmove(&dirty->ranges[i], &dirty->ranges[i + 1], sizeof(dirty->ranges[0]) * (dirty->range_count - i - 1));
+		dirty->range_count -= 1;
 	}
+	if (dirty->range_count == SKG_GL_DIRTY_RANGES)
+		return false;
+
+	memmove(&dirty->ranges[insert + 1], &dirty->ranges[insert], sizeof(dirty->ranges[0]) * (dirty->range_count - insert));
+	dirty->ranges[insert][0] = start;
+	dirty->ranges[insert][1] = end;
+	dirty->range_count += 1;
+	return true;
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_destroy(skg_buffer_t *buffer) {
-	// If this buffer is currently bound, we unbind it and remove it from our
-	// pipeline cache to prevent accidental re-use of any kind.
-	if (gl_pipeline.buffer_bind[buffer->type] == buffer->_buffer) {
-		gl_pipeline.buffer_bind[buffer->type] = 0;
-		glBindBuffer(buffer->_target, 0);
+void gl_dirty_upload(gl_buffer_dirty_t *dirty) {
+	if (dirty->range_count == 0) return;
+	if (gl_buffer_storage) {
+		for (int32_t i = 0; i < dirty->range_count; i++) {
+			uint32_t start = dirty->ranges[i][0];
+			uint32_t end   = dirty->ranges[i][1];
+			gl_buffer_stage(dirty->buffer, start, dirty->shadow + start, end - start);
+		}
+		dirty->range_count = 0;
+		return;
 	}
 
-	uint32_t buffer_list[] = { buffer->_buffer };
-	glDeleteBuffers(1, buffer_list);
-	*buffer = {};
+	// The copy target leaves the cached vertex, index, and uniform bindings
+	// alone.
+	glBindBuffer(GL_COPY_WRITE_BUFFER, dirty->buffer);
+	for (int32_t i = 0; i < dirty->range_count; i++) {
+		uint32_t start = dirty->ranges[i][0];
+		uint32_t end   = dirty->ranges[i][1];
+		glBufferSubData(GL_COPY_WRITE_BUFFER, start, end - start, dirty->shadow + start);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	// Indirect buffers can live on this target too, see skg_buffer_type_to_gl
+	gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+	dirty->range_count = 0;
 }
 
 ///////////////////////////////////////////
 
-skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
-	skg_mesh_t result = {};
-	skg_mesh_set_verts(&result, vert_buffer);
-	skg_mesh_set_inds (&result, ind_buffer);
-
-	return result;
+void gl_buffer_flush(skg_buffer_t *buffer) {
+	gl_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr || dirty->range_count == 0) return;
+	SKG_TRACE_FUNC();
+	gl_dirty_upload(dirty);
 }
 
 ///////////////////////////////////////////
 
-void skg_mesh_name(skg_mesh_t *mesh, const char* name) {
-	char postfix_name[256];
-	if (mesh->_vert_buffer != 0) {
-		snprintf(postfix_name, sizeof(postfix_name), "%s_verts", name);
-		glObjectLabel(GL_BUFFER, mesh->_vert_buffer,  (uint32_t)strlen(postfix_name), postfix_name);
-	}
-	if (mesh->_ind_buffer != 0) {
-		snprintf(postfix_name, sizeof(postfix_name), "%s_inds", name);
-		glObjectLabel(GL_BUFFER, mesh->_ind_buffer,  (uint32_t)strlen(postfix_name), postfix_name);
+void gl_dirty_flush_queue() {
+	for (int32_t i = 0; i < gl_dirty_queue_count; i++) {
+		gl_dirty_upload(gl_dirty_queue[i]);
+		gl_dirty_queue[i]->queued = false;
 	}
+	gl_dirty_queue_count = 0;
 }
 
 ///////////////////////////////////////////
 
-void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
-	mesh->_vert_buffer = vert_buffer ? vert_buffer->_buffer : 0;
-	if (mesh->_vert_buffer != 0) {
-		if (mesh->_layout != 0) {
-			glDeleteVertexArrays(1, &mesh->_layout);
-			mesh->_layout = 0;
-		}
+void skg_buffer_set_contents_range(skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+	// Updates go through render thread state, like the binding cache and
+	// the transient buffer.
+	if (gl_upload_thread) {
+		skg_log(skg_log_warning, "Dynamic buffers can't be updated on an upload thread!");
+		return;
+	}
+	if (offset > buffer->_size || size_bytes > buffer->_size - offset) {
+		skg_log(skg_log_warning, "skg_buffer_set_contents_range is writing outside of the buffer!");
+		return;
+	}
+	if (size_bytes == 0) return;
 
-		PIPELINE_CHECK(gl_pipeline.buffer_bind[skg_buffer_type_vertex], mesh->_vert_buffer)
-		glBindBuffer(GL_ARRAY_BUFFER, mesh->_vert_buffer);
-		PIPELINE_CHECK_END
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_range(buffer, offset, data, size_bytes));
+	skg_stats_upload(size_bytes);
+
+	gl_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr) {
+		dirty = (gl_buffer_dirty_t*)calloc(1, sizeof(gl_buffer_dirty_t));
+		dirty->buffer   = buffer->_buffer;
+		dirty->shadow   = (uint8_t*)malloc(buffer->_size);
+		buffer->_dirty  = dirty;
+	}
+	memcpy(dirty->shadow + offset, data, size_bytes);
+	if (!gl_dirty_add(dirty, offset, offset + size_bytes)) {
+		// Out of ranges, so send what we have and start over
+		gl_buffer_flush(buffer);
+		gl_dirty_add(dirty, offset, offset + size_bytes);
+	}
 
-		// Create a vertex layout
-		glGenVertexArrays(1, &mesh->_layout);
-		glBindVertexArray(mesh->_layout);
-		gl_pipeline.layout = mesh->_layout;
-		// enable the vertex data for the shader
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-		glEnableVertexAttribArray(3);
-		// tell the shader how our vertex data binds to the shader inputs
-		glVertexAttribPointer(0, 3, GL_FLOAT,         0, sizeof(skg_vert_t), nullptr);
-		glVertexAttribPointer(1, 3, GL_FLOAT,         0, sizeof(skg_vert_t), (void*)(sizeof(float) * 3));
-		glVertexAttribPointer(2, 2, GL_FLOAT,         0, sizeof(skg_vert_t), (void*)(sizeof(float) * 6));
-		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, 1, sizeof(skg_vert_t), (void*)(sizeof(float) * 8));
+	if (!dirty->queued) {
+		if (gl_dirty_queue_count == gl_dirty_queue_cap) {
+			gl_dirty_queue_cap = gl_dirty_queue_cap == 0 ? 16 : gl_dirty_queue_cap * 2;
+			gl_dirty_queue     = (gl_buffer_dirty_t**)realloc(gl_dirty_queue, sizeof(gl_buffer_dirty_t*) * gl_dirty_queue_cap);
+		}
+		gl_dirty_queue[gl_dirty_queue_count++] = dirty;
+		dirty->queued = true;
 	}
 }
 
 ///////////////////////////////////////////
 
-void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
-	mesh->_ind_buffer = ind_buffer ? ind_buffer->_buffer : 0;
+void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	SKG_TRACE_FUNC();
+	uint32_t copy_size = buffer_size < buffer->_size ? buffer_size : buffer->_size;
+
+	if (buffer->_dirty && buffer->_dirty->range_count > 0) gl_dirty_upload(buffer->_dirty);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer->_buffer);
+#if defined(_SKG_GL_WEB)
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, copy_size, ref_buffer);
+#else
+	// Compute shaders may have written to this, and mapping doesn't wait
+	// for incoherent writes on its own.
+	if (glMemoryBarrier) glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	void *data = copy_size > 0 ? glMapBufferRange(GL_COPY_READ_BUFFER, 0, copy_size, GL_MAP_READ_BIT) : nullptr;
+	if (data) {
+		memcpy(ref_buffer, data, copy_size);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+	} else {
+		if (copy_size > 0) skg_log(skg_log_critical, "Failed to get contents of buffer");
+		copy_size = 0;
+	}
+#endif
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	if (copy_size < buffer_size) memset((uint8_t*)ref_buffer + copy_size, 0, buffer_size - copy_size);
 }
 
 ///////////////////////////////////////////
 
-void skg_mesh_bind(const skg_mesh_t *mesh) {
-	PIPELINE_CHECK(gl_pipeline.layout, mesh->_layout)
-	glBindVertexArray(mesh->_layout);
-	PIPELINE_CHECK_END
+bool skg_buffer_read_async(const skg_buffer_t *buffer, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	uint32_t size = buffer->_size;
+	if (size == 0) return false;
+	// Pending writes are part of the contents, even if they haven't been
+	// uploaded yet.
+	gl_buffer_flush((skg_buffer_t*)buffer);
 
-	PIPELINE_CHECK(gl_pipeline.buffer_bind[skg_buffer_type_vertex], mesh->_vert_buffer)
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->_vert_buffer);
-	PIPELINE_CHECK_END
-	
-	PIPELINE_CHECK(gl_pipeline.buffer_bind[skg_buffer_type_index], mesh->_ind_buffer)
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->_ind_buffer );
-	PIPELINE_CHECK_END
+	gl_readback_prepare(ref_readback, (size_t)size);
+	ref_readback->width  = size;
+	ref_readback->height = 1;
+	ref_readback->format = skg_tex_fmt_none;
+
+#if defined(_SKG_GL_WEB)
+	// WebGL can't map buffers, so this one has to wait on the GPU.
+	glBindBuffer      (GL_COPY_READ_BUFFER, buffer->_buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, ref_readback->_data);
+	glBindBuffer      (GL_COPY_READ_BUFFER, 0);
+#else
+	if (glMemoryBarrier) glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer       (GL_COPY_READ_BUFFER,  buffer->_buffer);
+	glBindBuffer       (GL_COPY_WRITE_BUFFER, ref_readback->_buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+	glBindBuffer       (GL_COPY_READ_BUFFER,  0);
+	glBindBuffer       (GL_COPY_WRITE_BUFFER, 0);
+	gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+	ref_readback->_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+	return true;
 }
 
 ///////////////////////////////////////////
 
-void skg_mesh_destroy(skg_mesh_t *mesh) {
-	// If this layout is currently bound, unbind it before deleting.
-	if (gl_pipeline.layout == mesh->_layout){
-		gl_pipeline.layout = 0;
-		glBindVertexArray(0);
+void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_bind, skg_capture_id(buffer), bind));
+	if (buffer->type == skg_buffer_type_indirect) {
+		// Indirect args are only bound to shaders for compute to fill them,
+		// draws bind them on their own.
+		gl_buffer_flush((skg_buffer_t*)buffer);
+		gl_bind_buffer(true, bind.slot, buffer->_buffer, 0, buffer->_size);
+	} else if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute) {
+		// Pending ranged writes land here, so everything written since the
+		// last bind costs at most one upload per dirty run.
+		gl_buffer_flush((skg_buffer_t*)buffer);
+		gl_bind_buffer(buffer->type == skg_buffer_type_compute, bind.slot, buffer->_buffer, 0, buffer->_size);
+	} else {
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
+		glBindBuffer(buffer->_target, buffer->_buffer);
+		PIPELINE_CHECK_END
+		if (buffer->type == skg_buffer_type_index) {
+			// Draws bind the mesh's index buffer, so this needs to replace it
+			gl_pipeline.mesh_inds = buffer->_buffer;
+			gl_ind_format_set(buffer->_ind_format);
+		}
 	}
-
-	uint32_t vao_list[] = {mesh->_layout};
-	glDeleteVertexArrays(1, vao_list);
-	*mesh = {};
 }
 
-///////////////////////////////////////////
-// skg_shader_t                          //
 ///////////////////////////////////////////
 
-skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
-	const char *file_chars = (const char *)file_data;
-
-	skg_shader_stage_t result = {}; 
-	result.type = type;
-
-	// Include terminating character
-	if (shader_size > 0 && file_chars[shader_size-1] != '\0')
-		shader_size += 1;
-
-	uint32_t gl_type = 0;
-	switch (type) {
-	case skg_stage_pixel:   gl_type = GL_FRAGMENT_SHADER; break;
-	case skg_stage_vertex:  gl_type = GL_VERTEX_SHADER;   break;
-	case skg_stage_compute: gl_type = GL_COMPUTE_SHADER;  break;
+void skg_buffer_bind_range(const skg_buffer_t *buffer, skg_bind_t bind, uint32_t offset, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_buffer_bind_range, skg_capture_id(buffer), bind, offset, size_bytes, nullptr));
+	if (buffer->type != skg_buffer_type_constant && buffer->type != skg_buffer_type_compute) {
+		skg_log(skg_log_warning, "skg_buffer_bind_range only works with constant and compute buffers");
+		return;
 	}
-
-	// Convert the prefix if it doesn't match the GL version we're using
-#if   defined(_SKG_GL_ES)
-	const char   *prefix_gl      = "#version 310 es";
-#elif defined(_SKG_GL_DESKTOP)
-	const char   *prefix_gl      = "#version 450";
-#elif defined(_SKG_GL_WEB)
-	const char   *prefix_gl      = "#version 300 es";
+#if !defined(NDEBUG)
+	if (offset % skg_buffer_range_align(buffer->type) != 0) skg_log(skg_log_critical, "skg_buffer_bind_range offset isn't aligned, see skg_buffer_range_align");
+	if (offset + size_bytes > buffer->_size) skg_log(skg_log_critical, "skg_buffer_bind_range range is outside of the buffer");
 #endif
-	const size_t  prefix_gl_size = strlen(prefix_gl);
-	char         *final_data = (char*)file_chars;
-	bool          needs_free = false;
-
-	if (shader_size >= prefix_gl_size && memcmp(prefix_gl, file_chars, prefix_gl_size) != 0) {
-		const char *end = file_chars;
-		while (*end != '\n' && *end != '\r' && *end != '\0') end++;
-		size_t version_size = end - file_chars;
+	gl_buffer_flush((skg_buffer_t*)buffer);
+	gl_bind_buffer(buffer->type == skg_buffer_type_compute, bind.slot, buffer->_buffer, offset, size_bytes);
+}
 
-		final_data = (char*)malloc(sizeof(char) * ((shader_size-version_size)+prefix_gl_size));
-		memcpy(final_data, prefix_gl, prefix_gl_size);
-		memcpy(&final_data[prefix_gl_size], &file_chars[version_size], shader_size - version_size);
-		needs_free = true;
-	}
+///////////////////////////////////////////
 
-	// create and compile the vertex shader
-	result._shader = glCreateShader(gl_type);
-	try {
-		glShaderSource (result._shader, 1, &final_data, NULL);
-		glCompileShader(result._shader);
-	} catch (...) {
-		// Some GL drivers have a habit of crashing during shader compile.
-		const char *stage_name = "";
-		switch (type) {
-			case skg_stage_pixel:   stage_name = "Pixel";   break;
-			case skg_stage_vertex:  stage_name = "Vertex";  break;
-			case skg_stage_compute: stage_name = "Compute"; break; }
-		skg_logf(skg_log_warning, "%s shader compile exception", stage_name);
-		glDeleteShader(result._shader);
-		result._shader = 0;
-		if (needs_free)
-			free(final_data);
-		return result;
+uint32_t skg_buffer_range_align(skg_buffer_type_ type) {
+	switch (type) {
+	case skg_buffer_type_constant: return (uint32_t)gl_ubo_align;
+	case skg_buffer_type_compute:  return (uint32_t)gl_ssbo_align;
+	default:                       return 1;
 	}
+}
 
-	// check for errors?
-	int32_t err, length;
-	glGetShaderiv(result._shader, GL_COMPILE_STATUS, &err);
-	if (err == 0) {
-		char *log;
+///////////////////////////////////////////
 
-		glGetShaderiv(result._shader, GL_INFO_LOG_LENGTH, &length);
-		log = (char*)malloc(length);
-		glGetShaderInfoLog(result._shader, length, &err, log);
+void gl_bind_buffer(bool storage, uint32_t slot, uint32_t buffer, uint32_t offset, uint32_t size) {
+	if (slot >= SKG_GL_BIND_SLOTS) {
+		// Past the end of the cache, so this goes straight to GL
+		uint32_t target = storage ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+		SKG_STAT_MISS(skg_stat_buffer);
+		if (buffer == 0) glBindBufferBase (target, slot, 0);
+		else             glBindBufferRange(target, slot, buffer, offset, size);
+		gl_pipeline.buffer_bind[storage ? skg_buffer_type_compute : skg_buffer_type_constant] = buffer;
+		return;
+	}
 
-		// Trim trailing newlines, we've already got that covered
-		size_t len = strlen(log);
-		while(len > 0 && log[len-1] == '\n') { log[len-1] = '\0'; len -= 1; }
+	gl_buffer_range_t range = { buffer, offset, size };
+	if (storage) { gl_binds.ssbo[slot] = range; gl_binds.ssbo_dirty |= 1u << slot; }
+	else         { gl_binds.ubo [slot] = range; gl_binds.ubo_dirty  |= 1u << slot; }
+}
 
-		skg_logf(skg_log_warning, "Unable to compile shader (%d):\n%s", err, log);
-		free(log);
+///////////////////////////////////////////
 
-		glDeleteShader(result._shader);
-		result._shader = 0;
+void gl_bind_forget(uint32_t buffer) {
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if (gl_binds   .ubo      [i].buffer == buffer) gl_binds   .ubo      [i] = {};
+		if (gl_binds   .ssbo     [i].buffer == buffer) gl_binds   .ssbo     [i] = {};
+		if (gl_pipeline.ubo_bind [i].buffer == buffer) gl_pipeline.ubo_bind [i] = {};
+		if (gl_pipeline.ssbo_bind[i].buffer == buffer) gl_pipeline.ssbo_bind[i] = {};
 	}
-	if (needs_free)
-		free(final_data);
-
-	return result;
 }
 
 ///////////////////////////////////////////
 
-void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
-	//glDeleteShader(shader->shader);
-	*shader = {};
+void gl_bind_flush() {
+	if (gl_binds.tex_dirty  != 0) gl_bind_flush_textures();
+	if (gl_binds.ubo_dirty  != 0) gl_bind_flush_buffers(false);
+	if (gl_binds.ssbo_dirty != 0) gl_bind_flush_buffers(true);
 }
 
 ///////////////////////////////////////////
 
-skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
-	if (v_shader._shader == 0 && p_shader._shader == 0 && c_shader._shader == 0) {
-#if   defined(_SKG_GL_ES)
-		const char   *gl_name      = "GLES";
-#elif defined(_SKG_GL_DESKTOP)
-		const char   *gl_name      = "OpenGL";
-#elif defined(_SKG_GL_WEB)
-		const char   *gl_name      = "WebGL";
+void gl_bind_flush_buffers(bool storage) {
+	gl_buffer_range_t *queue   = storage ? gl_binds.ssbo          : gl_binds.ubo;
+	gl_buffer_range_t *current = storage ? gl_pipeline.ssbo_bind  : gl_pipeline.ubo_bind;
+	uint32_t           target  = storage ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+	uint32_t          *dirty   = storage ? &gl_binds.ssbo_dirty   : &gl_binds.ubo_dirty;
+
+	uint32_t changed = 0;
+	int32_t  first   = SKG_GL_BIND_SLOTS;
+	int32_t  last    = -1;
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if ((*dirty & (1u << i)) == 0) continue;
+#if !defined(SKG_GL_EXPLICIT_STATE)
+		bool diff =
+			queue[i].buffer != current[i].buffer ||
+			queue[i].offset != current[i].offset ||
+			queue[i].size   != current[i].size;
+#else
+		bool diff = true;
 #endif
-		skg_logf(skg_log_warning, "Shader '%s' has no valid stages for %s!", meta->name, gl_name);
-		return {};
+		if (!gl_stat_check(skg_stat_buffer, diff)) continue;
+		changed |= 1u << i;
+		if (i < first) first = i;
+		last = i;
 	}
+	*dirty = 0;
+	if (changed == 0) return;
 
-	skg_shader_t result = {};
-	result.meta     = meta;
-	result._vertex  = v_shader._shader;
-	result._pixel   = p_shader._shader;
-	result._compute = c_shader._shader;
-	skg_shader_meta_reference(result.meta);
-
-	result._program = glCreateProgram();
-	if (result._vertex)  glAttachShader(result._program, result._vertex);
-	if (result._pixel)   glAttachShader(result._program, result._pixel);
-	if (result._compute) glAttachShader(result._program, result._compute);
-	try {
-		glLinkProgram(result._program);
-	} catch (...) {
-		// Some GL drivers have a habit of crashing during shader compile.
-		skg_logf(skg_log_warning, "Shader link exception in %s:", meta->name);
-		glDeleteProgram(result._program);
-		result._program = 0;
-		return result;
+#if !defined(_SKG_GL_WEB)
+	if (gl_multi_bind) {
+		// One call covers everything from the first change to the last,
+		// slots in between are handed their current value again.
+		uint32_t buffers[SKG_GL_BIND_SLOTS];
+		intptr_t offsets[SKG_GL_BIND_SLOTS];
+		intptr_t sizes  [SKG_GL_BIND_SLOTS];
+		for (int32_t i = first; i <= last; i++) {
+			current[i] = queue[i];
+			buffers[i - first] = queue[i].buffer;
+			offsets[i - first] = queue[i].offset;
+			// Drivers check sizes even on empty slots
+			sizes  [i - first] = queue[i].buffer != 0 ? queue[i].size : 1;
+		}
+		glBindBuffersRange(target, first, last - first + 1, buffers, offsets, sizes);
+		return;
 	}
+#endif
 
-	// check for errors?
-	int32_t err, length;
-	glGetProgramiv(result._program, GL_LINK_STATUS, &err);
-	if (err == 0) {
-		char *log;
-
-		glGetProgramiv(result._program, GL_INFO_LOG_LENGTH, &length);
-		log = (char*)malloc(length);
-		glGetProgramInfoLog(result._program, length, &err, log);
-
-		skg_logf(skg_log_warning, "Unable to link %s:", meta->name);
-		skg_log(skg_log_warning, log);
-		free(log);
+	// These also change the generic binding point
+	for (int32_t i = first; i <= last; i++) {
+		if ((changed & (1u << i)) == 0) continue;
+		current[i] = queue[i];
+		if (queue[i].buffer == 0) glBindBufferBase (target, i, 0);
+		else                      glBindBufferRange(target, i, queue[i].buffer, queue[i].offset, queue[i].size);
+		gl_pipeline.buffer_bind[storage ? skg_buffer_type_compute : skg_buffer_type_constant] = queue[i].buffer;
+	}
+}
 
-		glDeleteProgram(result._program);
-		result._program = 0;
+///////////////////////////////////////////
 
-		return result;
+void gl_bind_flush_textures() {
+	uint32_t tex_changed     = 0;
+	uint32_t sampler_changed = 0;
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if ((gl_binds.tex_dirty & (1u << i)) == 0) continue;
+#if !defined(SKG_GL_EXPLICIT_STATE)
+		bool tex_diff     = gl_binds.tex    [i] != gl_pipeline.tex_bind    [i];
+		bool sampler_diff = gl_binds.sampler[i] != gl_pipeline.sampler_bind[i];
+#else
+		bool tex_diff     = true;
+		bool sampler_diff = true;
+#endif
+		if (gl_stat_check(skg_stat_texture, tex_diff)) tex_changed |= 1u << i;
+		if (gl_sampler_objects && gl_stat_check(skg_stat_sampler, sampler_diff)) sampler_changed |= 1u << i;
 	}
+	gl_binds.tex_dirty = 0;
 
-	// Set buffer binds
-	char t_name[64];
-	for (uint32_t i = 0; i < meta->buffer_count; i++) {
-		snprintf(t_name, 64, "%s", meta->buffers[i].name);
-		// $Global is a near universal buffer name, we need to scrape the
-		// '$' character out.
-		char *pr = t_name;
-		while (*pr) {
-			if (*pr == '$')
-				*pr = '_';
-			pr++;
+#if !defined(_SKG_GL_WEB)
+	if (gl_multi_bind) {
+		uint32_t names[SKG_GL_BIND_SLOTS];
+		int32_t  first, last;
+		if (tex_changed != 0) {
+			for (first = 0;                     (tex_changed & (1u << first)) == 0; first++) {}
+			for (last  = SKG_GL_BIND_SLOTS - 1; (tex_changed & (1u << last )) == 0; last--)  {}
+			for (int32_t i = first; i <= last; i++) {
+				gl_pipeline.tex_bind[i] = gl_binds.tex[i];
+				names[i - first] = gl_binds.tex[i];
+			}
+			glBindTextures(first, last - first + 1, names);
 		}
-
-		uint32_t slot = glGetUniformBlockIndex(result._program, t_name);
-		if (slot != GL_INVALID_INDEX) {
-			glUniformBlockBinding(result._program, slot, meta->buffers[i].bind.slot);
-		} else {
-			skg_logf(skg_log_warning, "Couldn't find uniform block index for: %s", meta->buffers[i].name);
+		if (sampler_changed != 0) {
+			for (first = 0;                     (sampler_changed & (1u << first)) == 0; first++) {}
+			for (last  = SKG_GL_BIND_SLOTS - 1; (sampler_changed & (1u << last )) == 0; last--)  {}
+			for (int32_t i = first; i <= last; i++) {
+				gl_pipeline.sampler_bind[i] = gl_binds.sampler[i];
+				names[i - first] = gl_binds.sampler[i];
+			}
+			glBindSamplers(first, last - first + 1, names);
 		}
+		return;
 	}
+#endif
 
-	// Set sampler uniforms
-	PIPELINE_CHECK(gl_pipeline.program, result._program)
-		glUseProgram(result._program);
-	PIPELINE_CHECK_END
-	for (uint32_t i = 0; i < meta->resource_count; i++) {
-		int32_t loc = glGetUniformLocation(result._program, meta->resources[i].name);
-		if (loc == -1) {
-			// Sometimes the shader compiler will prefix the variable with an
-			// _, particularly if it overlaps with a keyword of some sort.
-			snprintf(t_name, 64, "_%s", meta->resources[i].name);
-			loc = glGetUniformLocation(result._program, t_name);
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if (tex_changed & (1u << i)) {
+			gl_pipeline.tex_bind[i] = gl_binds.tex[i];
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture  (gl_binds.tex_target[i], gl_binds.tex[i]);
 		}
-
-		if (loc != -1) {
-			glUniform1i(loc, meta->resources[i].bind.slot);
-		} else {
-			// This may not be much of an issue under current usage patterns,
-			// but could cause problems for compute shaders later on.
-			skg_logf(skg_log_warning, "Couldn't find uniform location for: %s (is it a compute shader buffer?)", meta->resources[i].name);
+		if (sampler_changed & (1u << i)) {
+			gl_pipeline.sampler_bind[i] = gl_binds.sampler[i];
+			glBindSampler(i, gl_binds.sampler[i]);
 		}
 	}
-
-	return result;
 }
 
 ///////////////////////////////////////////
 
-void skg_shader_name(skg_shader_t *shader, const char* name) {
-	char postfix_name[256];
-	if (shader->_program != 0) {
-		snprintf(postfix_name, sizeof(postfix_name), "%s_program", name);
-		glObjectLabel(GL_PROGRAM, shader->_program, (uint32_t)strlen(postfix_name), postfix_name);
+void gl_transient_release() {
+	for (int32_t i = 0; i < gl_transient.retired_count; i++)
+		gl_transient_free(gl_transient.retired[i]);
+	free(gl_transient.retired);
+	for (int32_t i = 0; i < SKG_GL_TRANSIENT_FRAMES; i++) {
+		if (gl_transient.fences[i]) glDeleteSync(gl_transient.fences[i]);
 	}
-	if (shader->_compute != 0) {
-		snprintf(postfix_name, sizeof(postfix_name), "%s_cs", name);
-		glObjectLabel(GL_SHADER, shader->_compute, (uint32_t)strlen(postfix_name), postfix_name);
+	if (gl_transient.buffer != 0) gl_transient_free(gl_transient.buffer);
+	gl_transient = {};
+}
+
+///////////////////////////////////////////
+
+void gl_transient_free(uint32_t buffer) {
+	if (gl_pipeline.buffer_bind[skg_buffer_type_constant] == buffer)
+		gl_pipeline.buffer_bind[skg_buffer_type_constant] = 0;
+	if (gl_pipeline.buffer_bind[skg_buffer_type_indirect] == buffer)
+		gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+	gl_bind_forget(buffer);
+	skg_mem_release((uint64_t)buffer << 1);
+	glDeleteBuffers(1, &buffer);
+}
+
+///////////////////////////////////////////
+
+void gl_transient_grow(uint32_t min_size) {
+	SKG_TRACE_FUNC();
+	// GL keeps the old buffer alive for any draws still using it
+	uint32_t align = (uint32_t)gl_ubo_align;
+	uint32_t size  = gl_transient.frame_size * 2;
+	if (size < SKG_GL_TRANSIENT_MIN) size = SKG_GL_TRANSIENT_MIN;
+	if (size < min_size)             size = min_size;
+	size = ((size + align - 1) / align) * align;
+
+	// Bindings queued up for the next draw can still point at the old
+	// buffer, so it's retired until this frame ends instead of deleted.
+	for (int32_t i = 0; i < SKG_GL_TRANSIENT_FRAMES; i++) {
+		if (gl_transient.fences[i]) glDeleteSync(gl_transient.fences[i]);
 	}
-	if (shader->_pixel != 0) {
-		snprintf(postfix_name, sizeof(postfix_name), "%s_ps", name);
-		glObjectLabel(GL_SHADER, shader->_pixel, (uint32_t)strlen(postfix_name), postfix_name);
+	uint32_t *retired       = gl_transient.retired;
+	int32_t   retired_count = gl_transient.retired_count;
+	if (gl_transient.buffer != 0) {
+		retired = (uint32_t*)realloc(retired, sizeof(uint32_t) * (retired_count + 1));
+		retired[retired_count] = gl_transient.buffer;
+		retired_count += 1;
 	}
-	if (shader->_vertex != 0) {
-		snprintf(postfix_name, sizeof(postfix_name), "%s_vs", name);
-		glObjectLabel(GL_SHADER, shader->_vertex, (uint32_t)strlen(postfix_name), postfix_name);
+	gl_transient = {};
+	gl_transient.retired       = retired;
+	gl_transient.retired_count = retired_count;
+
+	int64_t total = (int64_t)size * SKG_GL_TRANSIENT_FRAMES;
+	gl_transient.frame_size = size;
+	glGenBuffers(1, &gl_transient.buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, gl_transient.buffer);
+	gl_pipeline.buffer_bind[skg_buffer_type_constant] = gl_transient.buffer;
+	if (gl_buffer_storage) {
+		uint32_t flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, total, nullptr, flags);
+		gl_transient.map = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, total, flags);
+	} else {
+		glBufferData(GL_UNIFORM_BUFFER, (int32_t)total, nullptr, GL_DYNAMIC_DRAW);
 	}
+	skg_mem_track((uint64_t)gl_transient.buffer << 1, skg_mem_buffer, total);
+	skg_mem_name ((uint64_t)gl_transient.buffer << 1, "skg_transient");
 }
 
 ///////////////////////////////////////////
 
-void skg_shader_compute_bind(const skg_shader_t *shader) {
-	uint32_t program = shader? shader->_program : 0;
-	PIPELINE_CHECK(gl_pipeline.program, program)
-		glUseProgram(program);
-	PIPELINE_CHECK_END
+void gl_transient_frame() {
+	for (int32_t i = 0; i < gl_transient.retired_count; i++)
+		gl_transient_free(gl_transient.retired[i]);
+	gl_transient.retired_count = 0;
+	gl_transient.frame_marked  = true;
+	if (gl_transient.buffer == 0) return;
+	gl_transient_advance();
 }
 
 ///////////////////////////////////////////
 
-bool skg_shader_is_valid(const skg_shader_t *shader) {
-	return shader->meta
-		&& shader->_program;
+void gl_transient_advance() {
+	if (gl_transient.map) gl_transient.fences[gl_transient.frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_transient.frame_index = (gl_transient.frame_index + 1) % SKG_GL_TRANSIENT_FRAMES;
+	gl_transient.used        = 0;
+
+	void **fence = &gl_transient.fences[gl_transient.frame_index];
+	if (*fence) {
+		if (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+			SKG_TRACE_SCOPE("gl_transient_wait");
+			while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+		}
+		glDeleteSync(*fence);
+		*fence = nullptr;
+	}
 }
 
 ///////////////////////////////////////////
 
-void skg_shader_destroy(skg_shader_t *shader) {
-	skg_shader_meta_release(shader->meta);
-	glDeleteProgram(shader->_program);
-	glDeleteShader (shader->_vertex);
-	glDeleteShader (shader->_pixel);
-	*shader = {};
+uint32_t gl_transient_alloc(const void *data, uint32_t size_bytes, uint32_t align) {
+	// Copies data into this frame's section, and returns where it landed
+	// from the start of the buffer.
+	uint32_t offset = ((gl_transient.used + align - 1) / align) * align;
+	if (gl_transient.buffer == 0 || offset + size_bytes > gl_transient.frame_size) {
+		// Running out once in a frame means frames need more room. Running
+		// out again before skg_draw_begin, or in an app that never calls
+		// it, moves on to the next section like a new frame would, instead
+		// of growing without end.
+		if (gl_transient.buffer != 0 && !gl_transient.frame_marked && size_bytes <= gl_transient.frame_size)
+			gl_transient_advance();
+		else
+			gl_transient_grow(size_bytes);
+		gl_transient.frame_marked = false;
+		offset = 0;
+	}
+	gl_transient.used = offset + size_bytes;
+	offset += gl_transient.frame_index * gl_transient.frame_size;
+
+	if (gl_transient.map) {
+		memcpy(gl_transient.map + offset, data, size_bytes);
+	} else {
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_constant], gl_transient.buffer)
+		glBindBuffer(GL_UNIFORM_BUFFER, gl_transient.buffer);
+		PIPELINE_CHECK_END
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size_bytes, data);
+	}
+	return offset;
 }
 
-///////////////////////////////////////////
-// skg_pipeline                          //
 ///////////////////////////////////////////
 
-skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
-	skg_pipeline_t result = {};
-	result.transparency = skg_transparency_none;
-	result.cull         = skg_cull_back;
-	result.wireframe    = false;
-	result.depth_test   = skg_depth_test_less;
-	result.depth_write  = true;
-	result.depth_clip   = true;
-	result.meta         = shader->meta;
-	result._shader      = *shader;
-	skg_shader_meta_reference(result._shader.meta);
+bool skg_transient_bind(const void *data, uint32_t size_bytes, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_transient_bind, 0, bind, 0, size_bytes, data));
+	if (bind.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_transient_bind only works with constant registers");
+		return false;
+	}
 
-	return result;
+	uint32_t offset = gl_transient_alloc(data, size_bytes, (uint32_t)gl_ubo_align);
+	gl_bind_buffer(false, bind.slot, gl_transient.buffer, offset, size_bytes);
+	skg_stats_upload(size_bytes);
+	return true;
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+void skg_buffer_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_clear, 0, bind));
+	if (bind.stage_bits == skg_stage_compute) {
+		if (bind.register_type == skg_register_constant) gl_bind_buffer(false, bind.slot, 0, 0, 0);
+		if (bind.register_type == skg_register_readwrite) gl_bind_buffer(true,  bind.slot, 0, 0, 0);
+	}
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
-	PIPELINE_CHECK(gl_pipeline.program, pipeline->_shader._program)
-		glUseProgram(pipeline->_shader._program);
-	PIPELINE_CHECK_END
+void skg_buffer_destroy(skg_buffer_t *buffer) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_buffer_destroy, skg_capture_id(buffer)));
+	if (gl_destroy_deferred) {
+		gl_destroy_t *item = (gl_destroy_t*)calloc(1, sizeof(gl_destroy_t));
+		item->type   = gl_destroy_type_buffer;
+		item->buffer = *buffer;
+		gl_destroy_push(item);
+		*buffer = {};
+		return;
+	}
+	gl_buffer_destroy(buffer);
+}
 
-	
-	PIPELINE_CHECK(gl_pipeline.transparency, pipeline->transparency)
-		switch (pipeline->transparency) {
-		case skg_transparency_alpha_to_coverage:
-			glDisable  (GL_BLEND);
-			glEnable   (GL_SAMPLE_ALPHA_TO_COVERAGE);
-			break;
-		case skg_transparency_blend:
-			glDisable  (GL_SAMPLE_ALPHA_TO_COVERAGE);
-			glEnable   (GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
-			break;
-		case skg_transparency_add:
-			glDisable  (GL_SAMPLE_ALPHA_TO_COVERAGE);
-			glEnable   (GL_BLEND);
-			glBlendFunc(GL_ONE, GL_ONE);
-			glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-			break;
-		case skg_transparency_none:
-			glDisable  (GL_SAMPLE_ALPHA_TO_COVERAGE);
-			glDisable  (GL_BLEND);
-			break;
-		}
-	PIPELINE_CHECK_END
+///////////////////////////////////////////
 
-
-	PIPELINE_CHECK(gl_pipeline.cull, pipeline->cull)
-		switch (pipeline->cull) {
-		case skg_cull_back: {
-			glEnable  (GL_CULL_FACE);
-			glCullFace(GL_BACK);
-		} break;
-		case skg_cull_front: {
-			glEnable  (GL_CULL_FACE);
-			glCullFace(GL_FRONT);
-		} break;
-		case skg_cull_none: {
-			glDisable (GL_CULL_FACE);
-		} break;
+void gl_buffer_destroy(skg_buffer_t *buffer) {
+	// If this buffer is currently bound, we unbind it and remove it from our
+	// pipeline cache to prevent accidental re-use of any kind.
+	if (gl_pipeline.buffer_bind[buffer->type] == buffer->_buffer) {
+		gl_pipeline.buffer_bind[buffer->type] = 0;
+		glBindBuffer(buffer->_target, 0);
+	}
+	// Deleting also drops it from indexed slots, and the name can be reused
+	if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute || buffer->type == skg_buffer_type_indirect)
+		gl_bind_forget(buffer->_buffer);
+	// Shared layouts that aren't bound keep a deleted buffer alive, and
+	// the name may come back for a new buffer, so they need a fresh bind.
+	if (buffer->type == skg_buffer_type_vertex) {
+		for (int32_t i = 0; i < gl_layout_count; i++) {
+			if (gl_layouts[i].vert_buffer == buffer->_buffer)
+				gl_layouts[i].vert_buffer = 0;
 		}
-	PIPELINE_CHECK_END
-
-
-	PIPELINE_CHECK(gl_pipeline.scissor, pipeline->scissor)
-		if (pipeline->scissor) glEnable (GL_SCISSOR_TEST);
-		else                   glDisable(GL_SCISSOR_TEST);
-	PIPELINE_CHECK_END
+	}
 
-	PIPELINE_CHECK(gl_pipeline.color_write, pipeline->color_write)
-		switch(pipeline->color_write) {
-			case skg_color_write_rgba: glColorMask(true,  true,  true,  true ); break;
-			case skg_color_write_rgb:  glColorMask(true,  true,  true,  false); break;
-			case skg_color_write_a:    glColorMask(false, false, false, true ); break;
-			case skg_color_write_none: glColorMask(false, false, false, false); break;
+	if (buffer->_dirty) {
+		for (int32_t i = 0; i < gl_dirty_queue_count; i++) {
+			if (gl_dirty_queue[i] == buffer->_dirty) {
+				gl_dirty_queue[i] = gl_dirty_queue[--gl_dirty_queue_count];
+				break;
+			}
 		}
-	PIPELINE_CHECK_END
-	
-	PIPELINE_CHECK(gl_pipeline.depth_write, pipeline->depth_write)
-		glDepthMask(pipeline->depth_write);
-	PIPELINE_CHECK_END
-	
-	PIPELINE_CHECK(gl_pipeline.depth_clip, pipeline->depth_clip)
-		if (pipeline->depth_clip) glDisable(GL_DEPTH_CLAMP);
-		else                      glEnable (GL_DEPTH_CLAMP);
-	PIPELINE_CHECK_END
+		free(buffer->_dirty->shadow);
+		free(buffer->_dirty);
+	}
+	uint32_t buffer_list[] = { buffer->_buffer };
+	glDeleteBuffers(1, buffer_list);
+	skg_mem_release(skg_mem_key(buffer));
+	*buffer = {};
+}
 
-	bool depth_test = pipeline->depth_test != skg_depth_test_always;
-	PIPELINE_CHECK(gl_pipeline.depth_test, depth_test)
-		if (depth_test) glEnable (GL_DEPTH_TEST);
-		else            glDisable(GL_DEPTH_TEST);
-	PIPELINE_CHECK_END
+///////////////////////////////////////////
 
+skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
+	skg_mesh_t result = {};
+	skg_mesh_set_verts(&result, vert_buffer);
+	skg_mesh_set_inds (&result, ind_buffer);
 
-	PIPELINE_CHECK(gl_pipeline.depth_test_type, pipeline->depth_test)
-		switch (pipeline->depth_test) {
-		case skg_depth_test_always:        glDepthFunc(GL_ALWAYS);   break;
-		case skg_depth_test_equal:         glDepthFunc(GL_EQUAL);    break;
-		case skg_depth_test_greater:       glDepthFunc(GL_GREATER);  break;
-		case skg_depth_test_greater_or_eq: glDepthFunc(GL_GEQUAL);   break;
-		case skg_depth_test_less:          glDepthFunc(GL_LESS);     break;
-		case skg_depth_test_less_or_eq:    glDepthFunc(GL_LEQUAL);   break;
-		case skg_depth_test_never:         glDepthFunc(GL_NEVER);    break;
-		case skg_depth_test_not_equal:     glDepthFunc(GL_NOTEQUAL); break;
-		}
-	PIPELINE_CHECK_END
-	
-#ifdef _SKG_GL_DESKTOP
-	PIPELINE_CHECK(gl_pipeline.wireframe, pipeline->wireframe)
-		glPolygonMode(GL_FRONT_AND_BACK, pipeline->wireframe ? GL_LINE : GL_FILL);
-	PIPELINE_CHECK_END
-#endif
+	return result;
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ transparency) {
-	pipeline->transparency = transparency;
+void skg_mesh_name(skg_mesh_t *mesh, const char* name) {
+	SKG_TRACE_FUNC();
+	char postfix_name[256];
+	if (mesh->_vert_buffer != 0) {
+		snprintf(postfix_name, sizeof(postfix_name), "%s_verts", name);
+		glObjectLabel(GL_BUFFER, mesh->_vert_buffer,  (uint32_t)strlen(postfix_name), postfix_name);
+	}
+	if (mesh->_ind_buffer != 0) {
+		snprintf(postfix_name, sizeof(postfix_name), "%s_inds", name);
+		glObjectLabel(GL_BUFFER, mesh->_ind_buffer,  (uint32_t)strlen(postfix_name), postfix_name);
+	}
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
-	pipeline->cull = cull;
+void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
+	SKG_TRACE_FUNC();
+	mesh->_vert_buffer = vert_buffer ? vert_buffer->_buffer : 0;
+	// With vertex binding points, layouts are shared by format, and the
+	// buffer is bound on its own at draw time.
+	if (gl_vertex_binding) return;
+
+	if (mesh->_vert_buffer != 0 && mesh->_layout == nullptr) {
+		mesh->_layout = (gl_layout_t*)calloc(1, sizeof(gl_layout_t));
+		mesh->_layout->vert_fmt = mesh->_vert_fmt;
+		glGenVertexArrays(1, &mesh->_layout->vao);
+	}
+	// Attributes get pointed at the buffer on the next draw, once the
+	// shader they need to feed is known.
+	if (mesh->_layout != nullptr) {
+		mesh->_layout->vert_buffer = mesh->_vert_buffer;
+		mesh->_layout->inputs      = 0;
+	}
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
-	pipeline->wireframe = wireframe;
+void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
+	mesh->_ind_buffer = ind_buffer ? ind_buffer->_buffer : 0;
+	mesh->_ind_format = ind_buffer ? ind_buffer->_ind_format : skg_ind_fmt_u32;
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
-	pipeline->depth_write = write;
+void skg_mesh_set_format(skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count) {
+	SKG_TRACE_FUNC();
+	int32_t fmt = skg_vert_fmt_register(components, component_count);
+	if (fmt < 0) return;
+
+	mesh->_vert_fmt = fmt;
+	if (mesh->_layout != nullptr) {
+		mesh->_layout->vert_fmt = fmt;
+		mesh->_layout->inputs   = 0;
+	}
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
-	pipeline->depth_clip = clip;
+void skg_mesh_bind(const skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_mesh_bind(mesh->_vert_buffer, mesh->_ind_buffer, mesh->_vert_fmt));
+	// Which VAO this needs depends on the shader too, so the GL work waits
+	// for the draw.
+	gl_pipeline.mesh       = mesh->_layout;
+	gl_pipeline.mesh_verts = mesh->_vert_buffer;
+	gl_pipeline.mesh_inds  = mesh->_ind_buffer;
+	gl_pipeline.mesh_fmt   = mesh->_vert_fmt;
+	gl_ind_format_set(mesh->_ind_format);
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ write) {
-	pipeline->color_write = write;
+void skg_mesh_destroy(skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	if (mesh->_layout != nullptr) {
+		// If this layout is currently bound, unbind it before deleting.
+		if (gl_pipeline.layout == mesh->_layout->vao) {
+			gl_pipeline.layout = 0;
+			gl_pipeline.buffer_bind[skg_buffer_type_index] = SKG_GL_UNKNOWN;
+			glBindVertexArray(0);
+		}
+		if (gl_pipeline.mesh == mesh->_layout)
+			gl_pipeline.mesh = nullptr;
+
+		uint32_t vao_list[] = {mesh->_layout->vao};
+		glDeleteVertexArrays(1, vao_list);
+		free(mesh->_layout);
+	}
+	*mesh = {};
 }
 
+///////////////////////////////////////////
+// skg_shader_t                          //
 ///////////////////////////////////////////
 
-void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test) {
-	pipeline->depth_test = test;
-}
+bool gl_shader_check(uint32_t shader) {
+	// check for errors?
+	int32_t err, length;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &err);
+	if (err == 0) {
+		char *log;
 
-///////////////////////////////////////////
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		log = (char*)malloc(length);
+		glGetShaderInfoLog(shader, length, &err, log);
 
-void skg_pipeline_set_scissor(skg_pipeline_t *pipeline, bool enable) {
-	pipeline->scissor = enable;
+		// Trim trailing newlines, we've already got that covered
+		size_t len = strlen(log);
+		while(len > 0 && log[len-1] == '\n') { log[len-1] = '\0'; len -= 1; }
 
+		skg_logf(skg_log_warning, "Unable to compile shader (%d):\n%s", err, log);
+		free(log);
+		return false;
+	}
+	return true;
 }
 
 ///////////////////////////////////////////
 
-skg_transparency_ skg_pipeline_get_transparency(const skg_pipeline_t *pipeline) {
-	return pipeline->transparency;
-}
+uint32_t gl_shader_compile(const char *source, skg_stage_ type) {
+	uint32_t gl_type = 0;
+	switch (type) {
+	case skg_stage_pixel:   gl_type = GL_FRAGMENT_SHADER; break;
+	case skg_stage_vertex:  gl_type = GL_VERTEX_SHADER;   break;
+	case skg_stage_compute: gl_type = GL_COMPUTE_SHADER;  break;
+	}
 
-///////////////////////////////////////////
+	// create and compile the vertex shader
+	SKG_TRACE_SCOPE("gl_shader_compile");
+	uint32_t shader = glCreateShader(gl_type);
+	try {
+		glShaderSource (shader, 1, &source, NULL);
+		glCompileShader(shader);
+	} catch (...) {
+		// Some GL drivers have a habit of crashing during shader compile.
+		const char *stage_name = "";
+		switch (type) {
+			case skg_stage_pixel:   stage_name = "Pixel";   break;
+			case skg_stage_vertex:  stage_name = "Vertex";  break;
+			case skg_stage_compute: stage_name = "Compute"; break; }
+		skg_logf(skg_log_warning, "%s shader compile exception", stage_name);
+		glDeleteShader(shader);
+		return 0;
+	}
 
-skg_cull_ skg_pipeline_get_cull(const skg_pipeline_t *pipeline) {
-	return pipeline->cull;
+	// Parallel compiles are checked when the program links, asking now
+	// would wait on the compile.
+	if (!gl_parallel_compile && !gl_shader_check(shader)) {
+		glDeleteShader(shader);
+		shader = 0;
+	}
+	return shader;
 }
 
 ///////////////////////////////////////////
 
-bool skg_pipeline_get_wireframe(const skg_pipeline_t *pipeline) {
-	return pipeline->wireframe;
-}
+skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
+	SKG_TRACE_FUNC();
+	const char *file_chars = (const char *)file_data;
 
-///////////////////////////////////////////
+	skg_shader_stage_t result = {}; 
+	result.type = type;
 
-bool skg_pipeline_get_depth_write(const skg_pipeline_t *pipeline) {
-	return pipeline->depth_write;
+	// Include terminating character
+	if (shader_size > 0 && file_chars[shader_size-1] != '\0')
+		shader_size += 1;
+
+	// Convert the prefix if it doesn't match the GL version we're using
+#if   defined(_SKG_GL_ES)
+	const char   *prefix_gl      = "#version 310 es";
+#elif defined(_SKG_GL_DESKTOP)
+	const char   *prefix_gl      = "#version 450";
+#elif defined(_SKG_GL_WEB)
+	const char   *prefix_gl      = "#version 300 es";
+#endif
+	const size_t  prefix_gl_size = strlen(prefix_gl);
+	char         *final_data = (char*)file_chars;
+	bool          needs_free = false;
+
+	if (shader_size >= prefix_gl_size && memcmp(prefix_gl, file_chars, prefix_gl_size) != 0) {
+		const char *end = file_chars;
+		while (*end != '\n' && *end != '\r' && *end != '\0') end++;
+		size_t version_size = end - file_chars;
+
+		final_data = (char*)malloc(sizeof(char) * ((shader_size-version_size)+prefix_gl_size));
+		memcpy(final_data, prefix_gl, prefix_gl_size);
+		memcpy(&final_data[prefix_gl_size], &file_chars[version_size], shader_size - version_size);
+		needs_free = true;
+	}
+
+	// With the program cache on, compiling waits until
+	// skg_shader_create_manual knows whether the program is already cached.
+	if (gl_program_binary && skg_shader_cache_folder() != nullptr) {
+		if (!needs_free) {
+			size_t len = strlen(final_data);
+			final_data = (char*)malloc(len + 1);
+			memcpy(final_data, file_chars, len + 1);
+		}
+		result._source = final_data;
+		return result;
+	}
+
+	result._shader = gl_shader_compile(final_data, type);
+	if (needs_free)
+		free(final_data);
+
+	return result;
 }
 
 ///////////////////////////////////////////
 
-bool skg_pipeline_get_depth_clip(const skg_pipeline_t *pipeline) {
-	return pipeline->depth_clip;
+void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+	SKG_TRACE_FUNC();
+	//glDeleteShader(shader->shader);
+	free(shader->_source);
+	*shader = {};
 }
 
 ///////////////////////////////////////////
 
-skg_color_write_ skg_pipeline_get_color_write(const skg_pipeline_t *pipeline) {
-	return pipeline->color_write;
+#if !defined(_SKG_GL_WEB)
+
+#define SKG_GL_PROGRAM_MAGIC   0x50474B53 // "SKGP"
+#define SKG_GL_PROGRAM_VERSION 1
+
+typedef struct gl_program_file_t {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;
+	uint32_t size;
+} gl_program_file_t;
+
+uint64_t gl_program_hash(uint64_t hash, const char *string) {
+	if (string == nullptr) string = "";
+	while (*string != '\0') {
+		hash = (hash ^ (uint8_t)*string) * 1099511628211;
+		string++;
+	}
+	// Separate strings, so "ab"+"c" and "a"+"bc" don't collide
+	return (hash ^ 0xFF) * 1099511628211;
 }
 
 ///////////////////////////////////////////
 
-skg_depth_test_ skg_pipeline_get_depth_test(const skg_pipeline_t *pipeline) {
-	return pipeline->depth_test;
+// Binaries are only valid for the driver that made them, so the driver's
+// identity is part of the key along with each stage's source.
+uint64_t gl_program_key(const skg_shader_stage_t **stages, int32_t stage_count) {
+	uint64_t hash = 14695981039346656037UL;
+	hash = gl_program_hash(hash, (const char *)glGetString(GL_VENDOR));
+	hash = gl_program_hash(hash, (const char *)glGetString(GL_RENDERER));
+	hash = gl_program_hash(hash, (const char *)glGetString(GL_VERSION));
+	for (int32_t i = 0; i < stage_count; i++) {
+		hash = (hash ^ (uint64_t)(stages[i]->type + 1)) * 1099511628211;
+		hash = gl_program_hash(hash, stages[i]->_source);
+	}
+	return hash;
 }
 
 ///////////////////////////////////////////
 
-bool skg_pipeline_get_scissor(const skg_pipeline_t *pipeline) {
-	return pipeline->scissor;
+bool gl_program_load(uint32_t program, const char *filename, uint64_t key) {
+	SKG_TRACE_FUNC();
+	void  *data = nullptr;
+	size_t size = 0;
+	if (!skg_read_file(filename, &data, &size))
+		return false;
+
+	gl_program_file_t header = {};
+	if (size >= sizeof(header))
+		memcpy(&header, data, sizeof(header));
+	bool valid = size >= sizeof(header)
+		&& header.magic   == SKG_GL_PROGRAM_MAGIC
+		&& header.version == SKG_GL_PROGRAM_VERSION
+		&& header.key     == key
+		&& header.size    == size - sizeof(header);
+
+	int32_t linked = 0;
+	if (valid) {
+		glProgramBinary(program, header.format, (uint8_t*)data + sizeof(header), (int32_t)header.size);
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	}
+	free(data);
+
+	// Driver updates are the usual reason for this, so it's not a warning
+	if (linked == 0)
+		skg_logf(skg_log_info, "Program cache rejected %s, recompiling.", filename);
+	return linked != 0;
 }
 
 ///////////////////////////////////////////
 
-void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
-	// TODO: destroy pipeline handles and reset gl_pipeline state
-	skg_shader_meta_release(pipeline->_shader.meta);
-	*pipeline = {};
+void gl_program_save(uint32_t program, const char *filename, uint64_t key) {
+	SKG_TRACE_FUNC();
+	int32_t length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	gl_program_file_t header = {};
+	header.magic   = SKG_GL_PROGRAM_MAGIC;
+	header.version = SKG_GL_PROGRAM_VERSION;
+	header.key     = key;
+
+	uint8_t *data = (uint8_t*)malloc(sizeof(header) + length);
+	glGetProgramBinary(program, length, &length, &header.format, data + sizeof(header));
+	header.size = (uint32_t)length;
+	memcpy(data, &header, sizeof(header));
+
+	if (!skg_write_file(filename, data, sizeof(header) + length))
+		skg_logf(skg_log_warning, "Couldn't write program cache file %s", filename);
+	free(data);
 }
 
+#endif
+
 ///////////////////////////////////////////
 
-skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
-	skg_swapchain_t result = {};
+// Checks the link, and sets up everything that needs a linked program.
+bool gl_program_setup(uint32_t program, skg_shader_meta_t *meta, const uint32_t *stages, const char *cache_file, uint64_t cache_key) {
+	SKG_TRACE_SCOPE_DETAIL("gl_program_setup", meta->name);
 
-#if defined(_SKG_GL_LOAD_WGL)
-	result._hwnd  = hwnd;
-	result._hdc   = GetDC((HWND)hwnd);
-	result.width  = requested_width;
-	result.height = requested_height;
+	// check for errors?
+	int32_t err, length;
+	glGetProgramiv(program, GL_LINK_STATUS, &err);
+	if (err == 0) {
+		// Parallel compiles skip the stage checks, so report them here
+		if (gl_parallel_compile) {
+			for (int32_t i = 0; i < 3; i++)
+				if (stages[i]) gl_shader_check(stages[i]);
+		}
 
-	// Find a pixel format
-	const int format_attribs[] = {
-		WGL_DRAW_TO_WINDOW_ARB, true,
-		WGL_SUPPORT_OPENGL_ARB, true,
-		WGL_DOUBLE_BUFFER_ARB,  true,
-		WGL_ACCELERATION_ARB,   WGL_FULL_ACCELERATION_ARB,
-		WGL_PIXEL_TYPE_ARB,     WGL_TYPE_RGBA_ARB,
-		WGL_COLOR_BITS_ARB,     32,
-		WGL_DEPTH_BITS_ARB,     0,
-		WGL_STENCIL_BITS_ARB,   0,
-		WGL_SAMPLE_BUFFERS_ARB, 0,
-		WGL_SAMPLES_ARB,        0,
-		0 };
+		char *log;
 
-	int  pixel_format = 0;
-	UINT num_formats  = 0;
-	if (!wglChoosePixelFormatARB((HDC)result._hdc, format_attribs, nullptr, 1, &pixel_format, &num_formats)) {
-		skg_log(skg_log_critical, "Couldn't find pixel format!");
-		result = {};
-		return result;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		log = (char*)malloc(length);
+		glGetProgramInfoLog(program, length, &err, log);
+
+		skg_logf(skg_log_warning, "Unable to link %s:", meta->name);
+		skg_log(skg_log_warning, log);
+		free(log);
+
+		return false;
 	}
+#if !defined(_SKG_GL_WEB)
+	if (cache_file)
+		gl_program_save(program, cache_file, cache_key);
+#else
+	(void)cache_file;
+	(void)cache_key;
+#endif
 
-	PIXELFORMATDESCRIPTOR format_desc = { sizeof(PIXELFORMATDESCRIPTOR) };
-	DescribePixelFormat((HDC)result._hdc, pixel_format, sizeof(format_desc), &format_desc);
-	if (!SetPixelFormat((HDC)result._hdc, pixel_format, &format_desc)) {
-		skg_log(skg_log_critical, "Couldn't set pixel format!");
-		result = {};
-		return result;
+	// Set buffer binds
+	char t_name[64];
+	for (uint32_t i = 0; i < meta->buffer_count; i++) {
+		snprintf(t_name, 64, "%s", meta->buffers[i].name);
+		// $Global is a near universal buffer name, we need to scrape the
+		// '$' character out.
+		char *pr = t_name;
+		while (*pr) {
+			if (*pr == '$')
+				*pr = '_';
+			pr++;
+		}
+
+		uint32_t slot = glGetUniformBlockIndex(program, t_name);
+		if (slot != GL_INVALID_INDEX) {
+			glUniformBlockBinding(program, slot, meta->buffers[i].bind.slot);
+		} else {
+			skg_logf(skg_log_warning, "Couldn't find uniform block index for: %s", meta->buffers[i].name);
+		}
 	}
-#elif defined(_SKG_GL_LOAD_EGL)
-	EGLint attribs[] = { 
-		EGL_GL_COLORSPACE_KHR, EGL_GL_COLORSPACE_SRGB_KHR,
-		EGL_NONE };
-	result._egl_surface = eglCreateWindowSurface(egl_display, egl_config, (EGLNativeWindowType)hwnd, attribs);
-	if (eglGetError() != EGL_SUCCESS) skg_log(skg_log_critical, "Err eglCreateWindowSurface");
-	
-	if (eglMakeCurrent(egl_display, result._egl_surface, result._egl_surface, egl_context) == EGL_FALSE)
-		skg_log(skg_log_critical, "Unable to eglMakeCurrent for swapchain");
 
-	eglQuerySurface(egl_display, result._egl_surface, EGL_WIDTH,  &result.width );
-	eglQuerySurface(egl_display, result._egl_surface, EGL_HEIGHT, &result.height);
-#elif defined(_SKG_GL_LOAD_GLX)
-	result._x_window = hwnd;
-	result.width  = requested_width;
-	result.height = requested_height;
+	// Set sampler uniforms. GL 4.1 and GLES 3.1 can do this without binding
+	// the program, which matters when setup happens mid-frame.
+#if defined(_SKG_GL_WEB)
+	PIPELINE_CHECK(skg_stat_program, gl_pipeline.program, program)
+		glUseProgram(program);
+	PIPELINE_CHECK_END
+#endif
+	for (uint32_t i = 0; i < meta->resource_count; i++) {
+		int32_t loc = glGetUniformLocation(program, meta->resources[i].name);
+		if (loc == -1) {
+			// Sometimes the shader compiler will prefix the variable with an
+			// _, particularly if it overlaps with a keyword of some sort.
+			snprintf(t_name, 64, "_%s", meta->resources[i].name);
+			loc = glGetUniformLocation(program, t_name);
+		}
+
+		if (loc != -1) {
+#if defined(_SKG_GL_WEB)
+			glUniform1i(loc, meta->resources[i].bind.slot);
 #else
-	int32_t viewport[4];
-	glGetIntegerv(GL_VIEWPORT, viewport);
-	result.width  = viewport[2];
-	result.height = viewport[3];
+			glProgramUniform1i(program, loc, meta->resources[i].bind.slot);
 #endif
+		} else {
+			// This may not be much of an issue under current usage patterns,
+			// but could cause problems for compute shaders later on.
+			skg_logf(skg_log_warning, "Couldn't find uniform location for: %s (is it a compute shader buffer?)", meta->resources[i].name);
+		}
+	}
+	return true;
+}
 
-#if defined(_SKG_GL_WEB) && defined(SKG_MANUAL_SRGB)
-	const char *vs = R"_(#version 300 es
-layout(location = 0) in vec4 in_var_SV_POSITION;
-layout(location = 1) in vec3 in_var_NORMAL;
-layout(location = 2) in vec2 in_var_TEXCOORD0;
-layout(location = 3) in vec4 in_var_COLOR;
+///////////////////////////////////////////
 
-out vec2 fs_var_TEXCOORD0;
+void gl_program_pending_add(uint32_t program, skg_shader_meta_t *meta, const uint32_t *stages, const char *cache_file, uint64_t cache_key) {
+	if (gl_program_pending_count + 1 > gl_program_pending_cap) {
+		gl_program_pending_cap = gl_program_pending_cap == 0 ? 16 : gl_program_pending_cap * 2;
+		gl_programs_pending    = (gl_program_pending_t*)realloc(gl_programs_pending, sizeof(gl_program_pending_t) * gl_program_pending_cap);
+	}
+	gl_program_pending_t *item = &gl_programs_pending[gl_program_pending_count];
+	*item = {};
+	item->program   = program;
+	item->meta      = meta;
+	item->cache_key = cache_key;
+	memcpy(item->stages, stages, sizeof(item->stages));
+	if (cache_file) {
+		size_t len = strlen(cache_file);
+		item->cache_file = (char*)malloc(len + 1);
+		memcpy(item->cache_file, cache_file, len + 1);
+	}
+	gl_program_pending_count += 1;
+}
 
-void main() {
-    gl_Position = in_var_SV_POSITION;
-    fs_var_TEXCOORD0 = in_var_TEXCOORD0;
-})_";
-	const char *ps = R"_(#version 300 es
-precision mediump float;
-precision highp int;
+///////////////////////////////////////////
 
-uniform highp sampler2D tex;
+int32_t gl_program_pending_find(uint32_t program) {
+	if (program == 0) return -1;
+	for (int32_t i = 0; i < gl_program_pending_count; i++) {
+		if (gl_programs_pending[i].program == program) return i;
+	}
+	return -1;
+}
 
-in highp vec2 fs_var_TEXCOORD0;
-layout(location = 0) out highp vec4 out_var_SV_TARGET;
+///////////////////////////////////////////
 
-void main() {
-	vec4 color = texture(tex, fs_var_TEXCOORD0);
-    out_var_SV_TARGET = vec4(pow(color.xyz, vec3(1.0 / 2.2)), color.w);
-})_";
+void gl_program_pending_remove(int32_t index) {
+	free(gl_programs_pending[index].cache_file);
+	gl_programs_pending[index] = gl_programs_pending[gl_program_pending_count - 1];
+	gl_program_pending_count -= 1;
+}
 
-	skg_shader_meta_t *meta = (skg_shader_meta_t *)malloc(sizeof(skg_shader_meta_t));
-	*meta = {};
-	meta->resource_count = 1;
-	meta->resources = (skg_shader_resource_t*)malloc(sizeof(skg_shader_resource_t));
-	meta->resources[0].bind = { 0, skg_stage_pixel };
-	strcpy(meta->resources[0].name, "tex");
-	meta->resources[0].name_hash = skg_hash(meta->resources[0].name);
+///////////////////////////////////////////
 
-	skg_shader_stage_t v_stage = skg_shader_stage_create(vs, strlen(vs), skg_stage_vertex);
-	skg_shader_stage_t p_stage = skg_shader_stage_create(ps, strlen(ps), skg_stage_pixel);
-	result._convert_shader = skg_shader_create_manual(meta, v_stage, p_stage, {});
-	result._convert_pipe   = skg_pipeline_create(&result._convert_shader);
+int32_t gl_program_failed_find(uint32_t program) {
+	if (program == 0) return -1;
+	for (int32_t i = 0; i < gl_program_failed_count; i++) {
+		if (gl_programs_failed[i] == program) return i;
+	}
+	return -1;
+}
 
-	result._surface = skg_tex_create(skg_tex_type_rendertarget, skg_use_static, skg_tex_fmt_rgba32_linear, skg_mip_none);
-	skg_tex_set_contents(&result._surface, nullptr, result.width, result.height);
+///////////////////////////////////////////
 
-	result._surface_depth = skg_tex_create(skg_tex_type_zbuffer, skg_use_static, depth_format, skg_mip_none);
-	skg_tex_set_contents(&result._surface_depth, nullptr, result.width, result.height);
-	skg_tex_attach_depth(&result._surface, &result._surface_depth);
+// Waits on a pending program and finishes setting it up. Returns false if
+// the program failed to link.
+bool gl_program_finish(uint32_t program) {
+	if (gl_program_failed_count > 0 && gl_program_failed_find(program) >= 0) return false;
+	if (gl_program_pending_count == 0) return true;
+	int32_t index = gl_program_pending_find(program);
+	if (index < 0) return true;
 
-	skg_vert_t quad_verts[] = { 
-		{ {-1, 1,0}, {0,0,1}, {0,1}, {255,255,255,255} },
-		{ { 1, 1,0}, {0,0,1}, {1,1}, {255,255,255,255} },
-		{ { 1,-1,0}, {0,0,1}, {1,0}, {255,255,255,255} },
-		{ {-1,-1,0}, {0,0,1}, {0,0}, {255,255,255,255} } };
-	uint32_t quad_inds[] = { 2,1,0, 3,2,0 };
-	result._quad_vbuff = skg_buffer_create(quad_verts, 4, sizeof(skg_vert_t), skg_buffer_type_vertex, skg_use_static);
-	result._quad_ibuff = skg_buffer_create(quad_inds,  6, sizeof(uint32_t  ), skg_buffer_type_index,  skg_use_static);
-	result._quad_mesh  = skg_mesh_create(&result._quad_vbuff, &result._quad_ibuff);
+	gl_program_pending_t *item = &gl_programs_pending[index];
+	bool linked = gl_program_setup(item->program, item->meta, item->stages, item->cache_file, item->cache_key);
+	gl_program_pending_remove(index);
+	if (!linked) {
+		if (gl_program_failed_count == gl_program_failed_cap) {
+			gl_program_failed_cap = gl_program_failed_cap == 0 ? 4 : gl_program_failed_cap * 2;
+			gl_programs_failed    = (uint32_t*)realloc(gl_programs_failed, sizeof(uint32_t) * gl_program_failed_cap);
+		}
+		gl_programs_failed[gl_program_failed_count++] = program;
+	}
+	return linked;
+}
+
+///////////////////////////////////////////
+
+skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
+	SKG_TRACE_FUNC();
+	bool deferred = v_shader._source || p_shader._source || c_shader._source;
+	if (v_shader._shader == 0 && p_shader._shader == 0 && c_shader._shader == 0 && !deferred) {
+#if   defined(_SKG_GL_ES)
+		const char   *gl_name      = "GLES";
+#elif defined(_SKG_GL_DESKTOP)
+		const char   *gl_name      = "OpenGL";
+#elif defined(_SKG_GL_WEB)
+		const char   *gl_name      = "WebGL";
+#endif
+		skg_logf(skg_log_warning, "Shader '%s' has no valid stages for %s!", meta->name, gl_name);
+		return {};
+	}
+
+	skg_shader_t result = {};
+	result.meta     = meta;
+	result._vertex  = v_shader._shader;
+	result._pixel   = p_shader._shader;
+	result._compute = c_shader._shader;
+	result._inputs  = gl_layout_inputs(meta);
+	skg_shader_meta_reference(result.meta);
+
+	// Drivers often defer the real link work until the program's status is
+	// queried, so unless the link is left to run in parallel, this covers
+	// everything through to the uniform setup.
+	SKG_TRACE_SCOPE_DETAIL("gl_program_link", meta->name);
+	result._program = glCreateProgram();
+
+	// Stages deferred by the program cache only compile when the cached
+	// binary is missing, or the driver rejects it.
+	bool     loaded          = false;
+	char     cache_file[1024] = "";
+	uint64_t cache_key       = 0;
+#if !defined(_SKG_GL_WEB)
+	if (deferred) {
+		const skg_shader_stage_t *stages[3];
+		int32_t                   stage_count = 0;
+		if (v_shader._source) stages[stage_count++] = &v_shader;
+		if (p_shader._source) stages[stage_count++] = &p_shader;
+		if (c_shader._source) stages[stage_count++] = &c_shader;
+		cache_key = gl_program_key(stages, stage_count);
+		snprintf(cache_file, sizeof(cache_file), "%s/%016llx.skgp", skg_shader_cache_folder(), (unsigned long long)cache_key);
+
+		loaded = gl_program_load(result._program, cache_file, cache_key);
+		if (!loaded) {
+			// A rejected binary can leave the program in an odd state
+			glDeleteProgram(result._program);
+			result._program = glCreateProgram();
+			glProgramParameteri(result._program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+			if (v_shader._source) result._vertex  = gl_shader_compile(v_shader._source, v_shader.type);
+			if (p_shader._source) result._pixel   = gl_shader_compile(p_shader._source, p_shader.type);
+			if (c_shader._source) result._compute = gl_shader_compile(c_shader._source, c_shader.type);
+		}
+	}
 #endif
+
+	if (!loaded) {
+		if (result._vertex)  glAttachShader(result._program, result._vertex);
+		if (result._pixel)   glAttachShader(result._program, result._pixel);
+		if (result._compute) glAttachShader(result._program, result._compute);
+		try {
+			glLinkProgram(result._program);
+		} catch (...) {
+			// Some GL drivers have a habit of crashing during shader compile.
+			skg_logf(skg_log_warning, "Shader link exception in %s:", meta->name);
+			glDeleteProgram(result._program);
+			result._program = 0;
+			return result;
+		}
+	}
+
+	uint32_t    stages[3] = { result._vertex, result._pixel, result._compute };
+	const char *save_file = deferred && !loaded ? cache_file : nullptr;
+
+	// Parallel compiles finish on the driver's threads. skg_shader_is_ready
+	// polls them, and anything that needs the program waits on it.
+	if (gl_parallel_compile && !loaded) {
+		gl_program_pending_add(result._program, meta, stages, save_file, cache_key);
+		return result;
+	}
+
+	if (!gl_program_setup(result._program, meta, stages, save_file, cache_key)) {
+		glDeleteProgram(result._program);
+		result._program = 0;
+	}
 	return result;
 }
 
 ///////////////////////////////////////////
 
-void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
-	if (width == swapchain->width && height == swapchain->height)
+void skg_shader_name(skg_shader_t *shader, const char* name) {
+	SKG_TRACE_FUNC();
+	char postfix_name[256];
+	if (shader->_program != 0) {
+		snprintf(postfix_name, sizeof(postfix_name), "%s_program", name);
+		glObjectLabel(GL_PROGRAM, shader->_program, (uint32_t)strlen(postfix_name), postfix_name);
+	}
+	if (shader->_compute != 0) {
+		snprintf(postfix_name, sizeof(postfix_name), "%s_cs", name);
+		glObjectLabel(GL_SHADER, shader->_compute, (uint32_t)strlen(postfix_name), postfix_name);
+	}
+	if (shader->_pixel != 0) {
+		snprintf(postfix_name, sizeof(postfix_name), "%s_ps", name);
+		glObjectLabel(GL_SHADER, shader->_pixel, (uint32_t)strlen(postfix_name), postfix_name);
+	}
+	if (shader->_vertex != 0) {
+		snprintf(postfix_name, sizeof(postfix_name), "%s_vs", name);
+		glObjectLabel(GL_SHADER, shader->_vertex, (uint32_t)strlen(postfix_name), postfix_name);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_shader_compute_bind(const skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_compute_bind, shader ? skg_capture_id(shader) : 0));
+	uint32_t program = shader? shader->_program : 0;
+	PIPELINE_CHECK(skg_stat_program, gl_pipeline.program, program)
+		// A program that failed to link can't be used, and leaving the last
+		// one bound would dispatch the wrong shader.
+		if (!gl_program_finish(program)) {
+			program             = 0;
+			gl_pipeline.program = 0;
+		}
+		glUseProgram(program);
+	PIPELINE_CHECK_END
+}
+
+///////////////////////////////////////////
+
+bool skg_shader_is_valid(const skg_shader_t *shader) {
+	return shader->meta
+		&& shader->_program
+		&& gl_program_finish(shader->_program);
+}
+
+///////////////////////////////////////////
+
+bool skg_shader_is_ready(const skg_shader_t *shader) {
+	if (gl_program_pending_find(shader->_program) < 0)
+		return true;
+
+#if !defined(_SKG_GL_WEB)
+	int32_t complete = 0;
+	glGetProgramiv(shader->_program, GL_COMPLETION_STATUS_KHR, &complete);
+	if (complete == 0)
+		return false;
+#endif
+	gl_program_finish(shader->_program);
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_shader_destroy(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_destroy, skg_capture_id(shader)));
+	if (gl_destroy_deferred) {
+		gl_destroy_t *item = (gl_destroy_t*)calloc(1, sizeof(gl_destroy_t));
+		item->type   = gl_destroy_type_shader;
+		item->shader = *shader;
+		gl_destroy_push(item);
+		*shader = {};
+		return;
+	}
+	gl_shader_destroy(shader);
+}
+
+///////////////////////////////////////////
+
+void gl_shader_destroy(skg_shader_t *shader) {
+	int32_t pending = gl_program_pending_find(shader->_program);
+	if (pending >= 0) gl_program_pending_remove(pending);
+	int32_t failed = gl_program_failed_find(shader->_program);
+	if (failed >= 0) gl_programs_failed[failed] = gl_programs_failed[--gl_program_failed_count];
+	// Draws read vertex inputs from the bound meta, which may be freed here
+	if (gl_pipeline.meta == shader->meta)
+		gl_pipeline.meta = nullptr;
+	skg_shader_meta_release(shader->meta);
+	glDeleteProgram(shader->_program);
+	glDeleteShader (shader->_vertex);
+	glDeleteShader (shader->_pixel);
+	*shader = {};
+}
+
+///////////////////////////////////////////
+// skg_pipeline                          //
+///////////////////////////////////////////
+
+skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	skg_pipeline_t result = {};
+	result.transparency = skg_transparency_none;
+	result.cull         = skg_cull_back;
+	result.wireframe    = false;
+	result.depth_test   = skg_depth_test_less;
+	result.depth_write  = true;
+	result.depth_clip   = true;
+	result.meta         = shader->meta;
+	result._shader      = *shader;
+	skg_shader_meta_reference(result._shader.meta);
+
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_pipeline_bind(pipeline, skg_capture_id(&pipeline->_shader)));
+	PIPELINE_CHECK(skg_stat_program, gl_pipeline.program, pipeline->_shader._program)
+		// A program that failed to link can't be used, and leaving the last
+		// one bound would draw with the wrong shader.
+		uint32_t program = pipeline->_shader._program;
+		if (!gl_program_finish(program)) {
+			program             = 0;
+			gl_pipeline.program = 0;
+		}
+		glUseProgram(program);
+	PIPELINE_CHECK_END
+	gl_pipeline.meta   = pipeline->_shader.meta;
+	gl_pipeline.inputs = pipeline->_shader._inputs;
+
+	
+	PIPELINE_CHECK(skg_stat_blend, gl_pipeline.transparency, pipeline->transparency)
+		switch (pipeline->transparency) {
+		case skg_transparency_alpha_to_coverage:
+			glDisable  (GL_BLEND);
+			glEnable   (GL_SAMPLE_ALPHA_TO_COVERAGE);
+			break;
+		case skg_transparency_blend:
+			glDisable  (GL_SAMPLE_ALPHA_TO_COVERAGE);
+			glEnable   (GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+			break;
+		case skg_transparency_add:
+			glDisable  (GL_SAMPLE_ALPHA_TO_COVERAGE);
+			glEnable   (GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE);
+			glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+			break;
+		case skg_transparency_none:
+			glDisable  (GL_SAMPLE_ALPHA_TO_COVERAGE);
+			glDisable  (GL_BLEND);
+			break;
+		}
+	PIPELINE_CHECK_END
+
+
+	PIPELINE_CHECK(skg_stat_cull, gl_pipeline.cull, pipeline->cull)
+		switch (pipeline->cull) {
+		case skg_cull_back: {
+			glEnable  (GL_CULL_FACE);
+			glCullFace(GL_BACK);
+		} break;
+		case skg_cull_front: {
+			glEnable  (GL_CULL_FACE);
+			glCullFace(GL_FRONT);
+		} break;
+		case skg_cull_none: {
+			glDisable (GL_CULL_FACE);
+		} break;
+		}
+	PIPELINE_CHECK_END
+
+
+	PIPELINE_CHECK(skg_stat_cull, gl_pipeline.scissor, pipeline->scissor)
+		if (pipeline->scissor) glEnable (GL_SCISSOR_TEST);
+		else                   glDisable(GL_SCISSOR_TEST);
+	PIPELINE_CHECK_END
+
+	PIPELINE_CHECK(skg_stat_blend, gl_pipeline.color_write, pipeline->color_write)
+		switch(pipeline->color_write) {
+			case skg_color_write_rgba: glColorMask(true,  true,  true,  true ); break;
+			case skg_color_write_rgb:  glColorMask(true,  true,  true,  false); break;
+			case skg_color_write_a:    glColorMask(false, false, false, true ); break;
+			case skg_color_write_none: glColorMask(false, false, false, false); break;
+		}
+	PIPELINE_CHECK_END
+	
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_write, pipeline->depth_write)
+		glDepthMask(pipeline->depth_write);
+	PIPELINE_CHECK_END
+	
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_clip, pipeline->depth_clip)
+		if (pipeline->depth_clip) glDisable(GL_DEPTH_CLAMP);
+		else                      glEnable (GL_DEPTH_CLAMP);
+	PIPELINE_CHECK_END
+
+	bool depth_test = pipeline->depth_test != skg_depth_test_always;
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_test, depth_test)
+		if (depth_test) glEnable (GL_DEPTH_TEST);
+		else            glDisable(GL_DEPTH_TEST);
+	PIPELINE_CHECK_END
+
+
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_test_type, pipeline->depth_test)
+		switch (pipeline->depth_test) {
+		case skg_depth_test_always:        glDepthFunc(GL_ALWAYS);   break;
+		case skg_depth_test_equal:         glDepthFunc(GL_EQUAL);    break;
+		case skg_depth_test_greater:       glDepthFunc(GL_GREATER);  break;
+		case skg_depth_test_greater_or_eq: glDepthFunc(GL_GEQUAL);   break;
+		case skg_depth_test_less:          glDepthFunc(GL_LESS);     break;
+		case skg_depth_test_less_or_eq:    glDepthFunc(GL_LEQUAL);   break;
+		case skg_depth_test_never:         glDepthFunc(GL_NEVER);    break;
+		case skg_depth_test_not_equal:     glDepthFunc(GL_NOTEQUAL); break;
+		}
+	PIPELINE_CHECK_END
+	
+#ifdef _SKG_GL_DESKTOP
+	PIPELINE_CHECK(skg_stat_cull, gl_pipeline.wireframe, pipeline->wireframe)
+		glPolygonMode(GL_FRONT_AND_BACK, pipeline->wireframe ? GL_LINE : GL_FILL);
+	PIPELINE_CHECK_END
+#endif
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ transparency) {
+	SKG_TRACE_FUNC();
+	pipeline->transparency = transparency;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
+	SKG_TRACE_FUNC();
+	pipeline->cull = cull;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
+	SKG_TRACE_FUNC();
+	pipeline->wireframe = wireframe;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
+	SKG_TRACE_FUNC();
+	pipeline->depth_write = write;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
+	SKG_TRACE_FUNC();
+	pipeline->depth_clip = clip;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ write) {
+	SKG_TRACE_FUNC();
+	pipeline->color_write = write;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test) {
+	SKG_TRACE_FUNC();
+	pipeline->depth_test = test;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_set_scissor(skg_pipeline_t *pipeline, bool enable) {
+	SKG_TRACE_FUNC();
+	pipeline->scissor = enable;
+
+}
+
+///////////////////////////////////////////
+
+skg_transparency_ skg_pipeline_get_transparency(const skg_pipeline_t *pipeline) {
+	return pipeline->transparency;
+}
+
+///////////////////////////////////////////
+
+skg_cull_ skg_pipeline_get_cull(const skg_pipeline_t *pipeline) {
+	return pipeline->cull;
+}
+
+///////////////////////////////////////////
+
+bool skg_pipeline_get_wireframe(const skg_pipeline_t *pipeline) {
+	return pipeline->wireframe;
+}
+
+///////////////////////////////////////////
+
+bool skg_pipeline_get_depth_write(const skg_pipeline_t *pipeline) {
+	return pipeline->depth_write;
+}
+
+///////////////////////////////////////////
+
+bool skg_pipeline_get_depth_clip(const skg_pipeline_t *pipeline) {
+	return pipeline->depth_clip;
+}
+
+///////////////////////////////////////////
+
+skg_color_write_ skg_pipeline_get_color_write(const skg_pipeline_t *pipeline) {
+	return pipeline->color_write;
+}
+
+///////////////////////////////////////////
+
+skg_depth_test_ skg_pipeline_get_depth_test(const skg_pipeline_t *pipeline) {
+	return pipeline->depth_test;
+}
+
+///////////////////////////////////////////
+
+bool skg_pipeline_get_scissor(const skg_pipeline_t *pipeline) {
+	return pipeline->scissor;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	// TODO: destroy pipeline handles and reset gl_pipeline state
+	if (gl_pipeline.meta == pipeline->_shader.meta)
+		gl_pipeline.meta = nullptr;
+	skg_shader_meta_release(pipeline->_shader.meta);
+	*pipeline = {};
+}
+
+///////////////////////////////////////////
+
+#if defined(_SKG_GL_LOAD_EGL)
+EGLSurface gl_egl_pbuffer_create(int32_t width, int32_t height) {
+	EGLint attribs[] = {
+		EGL_WIDTH,  width  > 0 ? width  : 1,
+		EGL_HEIGHT, height > 0 ? height : 1,
+		EGL_NONE };
+	return eglCreatePbufferSurface(egl_display, egl_config, attribs);
+}
+#endif
+
+///////////////////////////////////////////
+
+skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
+	SKG_TRACE_FUNC();
+	skg_swapchain_t result = {};
+
+#if defined(_SKG_GL_LOAD_WGL)
+	result._hwnd  = hwnd;
+	result._hdc   = GetDC((HWND)hwnd);
+	result.width  = requested_width;
+	result.height = requested_height;
+
+	// Find a pixel format
+	const int format_attribs[] = {
+		WGL_DRAW_TO_WINDOW_ARB, true,
+		WGL_SUPPORT_OPENGL_ARB, true,
+		WGL_DOUBLE_BUFFER_ARB,  true,
+		WGL_ACCELERATION_ARB,   WGL_FULL_ACCELERATION_ARB,
+		WGL_PIXEL_TYPE_ARB,     WGL_TYPE_RGBA_ARB,
+		WGL_COLOR_BITS_ARB,     32,
+		WGL_DEPTH_BITS_ARB,     0,
+		WGL_STENCIL_BITS_ARB,   0,
+		WGL_SAMPLE_BUFFERS_ARB, 0,
+		WGL_SAMPLES_ARB,        0,
+		0 };
+
+	int  pixel_format = 0;
+	UINT num_formats  = 0;
+	if (!wglChoosePixelFormatARB((HDC)result._hdc, format_attribs, nullptr, 1, &pixel_format, &num_formats)) {
+		skg_log(skg_log_critical, "Couldn't find pixel format!");
+		result = {};
+		return result;
+	}
+
+	PIXELFORMATDESCRIPTOR format_desc = { sizeof(PIXELFORMATDESCRIPTOR) };
+	DescribePixelFormat((HDC)result._hdc, pixel_format, sizeof(format_desc), &format_desc);
+	if (!SetPixelFormat((HDC)result._hdc, pixel_format, &format_desc)) {
+		skg_log(skg_log_critical, "Couldn't set pixel format!");
+		result = {};
+		return result;
+	}
+#elif defined(_SKG_GL_LOAD_EGL)
+	if (hwnd == nullptr) {
+		// No window, so this is an offscreen swapchain for headless
+		// rendering. Presenting it does nothing.
+		result._egl_pbuffer = true;
+		result._egl_surface = gl_egl_pbuffer_create(requested_width, requested_height);
+		if (result._egl_surface == EGL_NO_SURFACE) {
+			skg_log(skg_log_critical, "Err eglCreatePbufferSurface, headless swapchains need pbuffer support");
+			result = {};
+			return result;
+		}
+	} else {
+		EGLint attribs[] = { 
+			EGL_GL_COLORSPACE_KHR, EGL_GL_COLORSPACE_SRGB_KHR,
+			EGL_NONE };
+		result._egl_surface = eglCreateWindowSurface(egl_display, egl_config, (EGLNativeWindowType)hwnd, attribs);
+		if (eglGetError() != EGL_SUCCESS) skg_log(skg_log_critical, "Err eglCreateWindowSurface");
+	}
+	
+	if (eglMakeCurrent(egl_display, result._egl_surface, result._egl_surface, egl_context) == EGL_FALSE)
+		skg_log(skg_log_critical, "Unable to eglMakeCurrent for swapchain");
+
+	eglQuerySurface(egl_display, result._egl_surface, EGL_WIDTH,  &result.width );
+	eglQuerySurface(egl_display, result._egl_surface, EGL_HEIGHT, &result.height);
+#elif defined(_SKG_GL_LOAD_GLX)
+	result._x_window = hwnd;
+	result.width  = requested_width;
+	result.height = requested_height;
+#else
+	int32_t viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	result.width  = viewport[2];
+	result.height = viewport[3];
+#endif
+
+#if defined(_SKG_GL_WEB) && defined(SKG_MANUAL_SRGB)
+	const char *vs = R"_(#version 300 es
+layout(location = 0) in vec4 in_var_SV_POSITION;
+layout(location = 1) in vec3 in_var_NORMAL;
+layout(location = 2) in vec2 in_var_TEXCOORD0;
+layout(location = 3) in vec4 in_var_COLOR;
+
+out vec2 fs_var_TEXCOORD0;
+
+void main() {
+    gl_Position = in_var_SV_POSITION;
+    fs_var_TEXCOORD0 = in_var_TEXCOORD0;
+})_";
+	const char *ps = R"_(#version 300 es
+precision mediump float;
+precision highp int;
+
+uniform highp sampler2D tex;
+
+in highp vec2 fs_var_TEXCOORD0;
+layout(location = 0) out highp vec4 out_var_SV_TARGET;
+
+void main() {
+	vec4 color = texture(tex, fs_var_TEXCOORD0);
+    out_var_SV_TARGET = vec4(pow(color.xyz, vec3(1.0 / 2.2)), color.w);
+})_";
+
+	skg_shader_meta_t *meta = (skg_shader_meta_t *)malloc(sizeof(skg_shader_meta_t));
+	*meta = {};
+	meta->resource_count = 1;
+	meta->resources = (skg_shader_resource_t*)malloc(sizeof(skg_shader_resource_t));
+	meta->resources[0].bind = { 0, skg_stage_pixel };
+	strcpy(meta->resources[0].name, "tex");
+	meta->resources[0].name_hash = skg_hash(meta->resources[0].name);
+
+	skg_shader_stage_t v_stage = skg_shader_stage_create(vs, strlen(vs), skg_stage_vertex);
+	skg_shader_stage_t p_stage = skg_shader_stage_create(ps, strlen(ps), skg_stage_pixel);
+	result._convert_shader = skg_shader_create_manual(meta, v_stage, p_stage, {});
+	skg_shader_stage_destroy(&v_stage);
+	skg_shader_stage_destroy(&p_stage);
+	result._convert_pipe   = skg_pipeline_create(&result._convert_shader);
+
+	result._surface = skg_tex_create(skg_tex_type_rendertarget, skg_use_static, skg_tex_fmt_rgba32_linear, skg_mip_none);
+	skg_tex_set_contents(&result._surface, nullptr, result.width, result.height);
+
+	result._surface_depth = skg_tex_create(skg_tex_type_zbuffer, skg_use_static, depth_format, skg_mip_none);
+	skg_tex_set_contents(&result._surface_depth, nullptr, result.width, result.height);
+	skg_tex_attach_depth(&result._surface, &result._surface_depth);
+
+	skg_vert_t quad_verts[] = { 
+		{ {-1, 1,0}, {0,0,1}, {0,1}, {255,255,255,255} },
+		{ { 1, 1,0}, {0,0,1}, {1,1}, {255,255,255,255} },
+		{ { 1,-1,0}, {0,0,1}, {1,0}, {255,255,255,255} },
+		{ {-1,-1,0}, {0,0,1}, {0,0}, {255,255,255,255} } };
+	uint32_t quad_inds[] = { 2,1,0, 3,2,0 };
+	result._quad_vbuff = skg_buffer_create(quad_verts, 4, sizeof(skg_vert_t), skg_buffer_type_vertex, skg_use_static);
+	result._quad_ibuff = skg_buffer_create(quad_inds,  6, sizeof(uint32_t  ), skg_buffer_type_index,  skg_use_static);
+	result._quad_mesh  = skg_mesh_create(&result._quad_vbuff, &result._quad_ibuff);
+#endif
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
+	if (width == swapchain->width && height == swapchain->height)
+		return;
+
+#if defined(_SKG_GL_LOAD_EGL)
+	if (swapchain->_egl_pbuffer) {
+		// Make the new surface before letting go of the old one, so a
+		// failure leaves the swapchain, and the context, as they were.
+		EGLSurface surface = gl_egl_pbuffer_create(width, height);
+		if (surface == EGL_NO_SURFACE) {
+			skg_log(skg_log_critical, "Err eglCreatePbufferSurface while resizing");
+			return;
+		}
+		eglMakeCurrent   (egl_display, surface, surface, egl_context);
+		eglDestroySurface(egl_display, swapchain->_egl_surface);
+		swapchain->_egl_surface = surface;
+	}
+#endif
+
+	swapchain->width  = width;
+	swapchain->height = height;
+
+#ifdef _SKG_GL_WEB
+	skg_tex_fmt_ color_fmt = swapchain->_surface.format;
+	skg_tex_fmt_ depth_fmt = swapchain->_surface_depth.format;
+
+	if (skg_tex_is_valid(&swapchain->_surface      )) skg_tex_destroy(&swapchain->_surface);
+	if (skg_tex_is_valid(&swapchain->_surface_depth)) skg_tex_destroy(&swapchain->_surface_depth);
+
+	swapchain->_surface = skg_tex_create(skg_tex_type_rendertarget, skg_use_static, color_fmt, skg_mip_none);
+	skg_tex_set_contents(&swapchain->_surface, nullptr, swapchain->width, swapchain->height);
+
+	swapchain->_surface_depth = skg_tex_create(skg_tex_type_depth, skg_use_static, depth_fmt, skg_mip_none);
+	skg_tex_set_contents(&swapchain->_surface_depth, nullptr, swapchain->width, swapchain->height);
+	skg_tex_attach_depth(&swapchain->_surface, &swapchain->_surface_depth);
+#endif
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_present(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+#if   defined(_SKG_GL_LOAD_WGL)
+	SwapBuffers((HDC)swapchain->_hdc);
+#elif defined(_SKG_GL_LOAD_EGL)
+	eglSwapBuffers(egl_display, swapchain->_egl_surface);
+#elif defined(_SKG_GL_LOAD_GLX)
+	glXSwapBuffers(xDisplay, (Drawable) swapchain->_x_window);
+#elif defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
+	float clear[4] = { 0,0,0,1 };
+	skg_tex_target_bind(nullptr, -1, 0);
+	skg_target_clear   (true, clear);
+	skg_tex_bind      (&swapchain->_surface, {0, skg_stage_pixel});
+	skg_mesh_bind     (&swapchain->_quad_mesh);
+	skg_pipeline_bind (&swapchain->_convert_pipe);
+	skg_draw          (0, 0, 6, 1);
+#endif
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_bind(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+	gl_active_width  = swapchain->width;
+	gl_active_height = swapchain->height;
+#if   defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
+	skg_tex_target_bind(&swapchain->_surface, -1, 0);
+#elif defined(_SKG_GL_LOAD_WGL)
+	wglMakeCurrent((HDC)swapchain->_hdc, gl_hrc);
+	if (wglSwapIntervalEXT) wglSwapIntervalEXT(1); // Enable VSync
+	skg_tex_target_bind(nullptr, -1, 0);
+#elif defined(_SKG_GL_LOAD_EGL)
+	eglMakeCurrent(egl_display, swapchain->_egl_surface, swapchain->_egl_surface, egl_context);
+	skg_tex_target_bind(nullptr, -1, 0);
+#elif defined(_SKG_GL_LOAD_GLX)
+	glXMakeCurrent(xDisplay, (Drawable)swapchain->_x_window, glxContext);
+	skg_tex_target_bind(nullptr, -1, 0);
+#endif
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+#if defined(_SKG_GL_LOAD_WGL)
+	if (swapchain->_hdc != nullptr) {
+		wglMakeCurrent(nullptr, nullptr);
+		ReleaseDC((HWND)swapchain->_hwnd, (HDC)swapchain->_hdc);
+		swapchain->_hwnd = nullptr;
+		swapchain->_hdc  = nullptr;
+	}
+#elif defined(_SKG_GL_LOAD_EGL)
+	eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (swapchain->_egl_surface != EGL_NO_SURFACE) eglDestroySurface(egl_display, swapchain->_egl_surface);
+	swapchain->_egl_surface = EGL_NO_SURFACE;
+#endif
+}
+
+///////////////////////////////////////////
+
+uint32_t gl_tex_target(skg_use_ tex_use, int32_t array_count, int32_t multisample) {
+	if (multisample > 1) {
+		return array_count == 1
+			? GL_TEXTURE_2D_MULTISAMPLE
+			: GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
+	} else {
+		return array_count > 1
+			? ((tex_use & skg_use_cubemap) > 0 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D_ARRAY)
+			: GL_TEXTURE_2D;
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_framebuffer_attach(uint32_t texture, uint32_t target, skg_tex_fmt_ format, int32_t physical_multisample, int32_t multisample, int32_t array_count, uint32_t layer, uint32_t mip_level, bool multiview) {
+	SKG_TRACE_FUNC();
+	uint32_t attach = GL_COLOR_ATTACHMENT0;
+	if      (format == skg_tex_fmt_depthstencil)                             attach = GL_DEPTH_STENCIL_ATTACHMENT;
+	else if (format == skg_tex_fmt_depth16 || format == skg_tex_fmt_depth32) attach = GL_DEPTH_ATTACHMENT;
+
+	bool is_framebuffer_msaa = multisample > physical_multisample;
+	if      (multiview && array_count == skg_multiview_ct && gl_caps[skg_cap_multiview_tiled_multisample] == true && is_framebuffer_msaa)
+	                                                                            glFramebufferTextureMultisampleMultiviewOVR(GL_FRAMEBUFFER, attach,         texture, mip_level, multisample, layer, skg_multiview_ct);
+	else if (multiview && array_count == skg_multiview_ct && gl_caps[skg_cap_multiview] == true)
+	                                                                            glFramebufferTextureMultiviewOVR           (GL_FRAMEBUFFER, attach,         texture, mip_level, layer, skg_multiview_ct);
+	else if (array_count > 1)                                                   glFramebufferTextureLayer                  (GL_FRAMEBUFFER, attach,         texture, mip_level, layer);
+	else if (gl_caps[skg_cap_tiled_multisample] == true && is_framebuffer_msaa) glFramebufferTexture2DMultisampleEXT       (GL_FRAMEBUFFER, attach, target, texture, mip_level, multisample);
+	else                                                                        glFramebufferTexture                       (GL_FRAMEBUFFER, attach,         texture, mip_level);
+	
+	uint32_t status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		skg_logf(skg_log_critical, "Framebuffer incomplete: %x\n", status);
+	}
+}
+
+///////////////////////////////////////////
+
+skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_count, int32_t physical_multisample, int32_t framebuffer_multisample) {
+	SKG_TRACE_FUNC();
+	uint32_t err = glGetError();
+	while(err) {
+		skg_logf(skg_log_warning, "Unsourced (skg_tex_create_from_existing) err: %x", err);
+		err = glGetError();
+	}
+	
+	skg_tex_t result = {};
+	result.type        = type;
+	result.use         = skg_use_static;
+	result.mips        = skg_mip_none;
+	result.format      = format;
+	result.width       = width;
+	result.height      = height;
+	result.array_count = array_count;
+	result.multisample = framebuffer_multisample > physical_multisample ? framebuffer_multisample : physical_multisample;
+	result._physical_multisample = physical_multisample;
+	result._texture    = (uint32_t)(uint64_t)native_tex;
+	result._format     = (uint32_t)skg_tex_fmt_to_native(result.format);
+	result._target     = gl_tex_target(result.use, array_count, physical_multisample);
+
+	// Check if this is an external texture
+	gl_pipeline.tex_bind[0] = result._texture; // Similar to a PIPELINE_CHECK
+	gl_binds.tex_dirty     |= 1;               // Queued binds for slot 0 need to come back
+	skg_log_enable(false); // Intentional error, don't scare the users.
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture  (GL_TEXTURE_EXTERNAL_OES, result._texture);
+	skg_log_enable(true);
+	if (!glGetError()) {
+		result._target = GL_TEXTURE_EXTERNAL_OES;
+	}
+
+	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
+		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * result.array_count);
+		glGenFramebuffers(result.array_count, result._framebuffer_layers);
+
+		for (int32_t i = 0; i < result.array_count; i++) {
+			bool multiview = i == 0 && array_count == skg_multiview_ct && skg_capability(skg_cap_multiview);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, result._framebuffer_layers[i]);
+			gl_framebuffer_attach(result._texture, result._target, result.format, result._physical_multisample, result.multisample, result.array_count, i, 0, multiview);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
+
+		// The texture itself belongs to whoever made it, but any tiled MSAA
+		// surfaces behind our framebuffers are ours.
+		if (gl_caps[skg_cap_tiled_multisample])
+			skg_mem_track_tex(skg_mem_key(&result), &result, 0, result._physical_multisample);
+	}
+
+	err = glGetError();
+	while(err) {
+		skg_logf(skg_log_warning, "skg_tex_create_from_existing err: %x", err);
+		err = glGetError();
+	}
+	
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
+	return result;
+}
+
+///////////////////////////////////////////
+
+skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_layer) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = {};
+	result.type        = type;
+	result.use         = skg_use_static;
+	result.mips        = skg_mip_none;
+	result.format      = format;
+	result.width       = width;
+	result.height      = height;
+	result.array_count = 1;
+	result.array_start = array_layer;
+	result.multisample = 1;
+	result._physical_multisample = 1;
+	result._texture    = (uint32_t)(uint64_t)native_tex;
+	result._format     = (uint32_t)skg_tex_fmt_to_native(result.format);
+	result._target     = gl_tex_target(result.use, 2, result._physical_multisample);
+	result._view       = true;
+
+	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
+		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * 1);
+		glGenFramebuffers(1, result._framebuffer_layers);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, result._framebuffer_layers[0]);
+		gl_framebuffer_attach(result._texture, result._target, result.format, result._physical_multisample, result.multisample, result.array_count, array_layer, 0, false);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
+	}
+
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
+	return result;
+}
+
+///////////////////////////////////////////
+
+skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = {};
+	result.type    = type;
+	result.use     = use;
+	result.format  = format;
+	result.mips    = mip_maps;
+	result._format = (uint32_t)skg_tex_fmt_to_native(result.format);
+
+	if      (use & skg_use_compute_read && use & skg_use_compute_write) result._access = GL_READ_WRITE;
+	else if (use & skg_use_compute_read)                                result._access = GL_READ_ONLY;
+	else if (use & skg_use_compute_write)                               result._access = GL_WRITE_ONLY;
+	result._format = (uint32_t)skg_tex_fmt_to_native(result.format);
+
+	// Framebuffers belong to the context that made them
+	if (gl_upload_thread && (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget)) {
+		skg_log(skg_log_warning, "Render targets can't be created on an upload thread!");
+		return {};
+	}
+
+	glGenTextures(1, &result._texture);
+	skg_mem_add(skg_mem_key(&result));
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create, &result));
+	skg_tex_settings(&result, (use & skg_use_cubemap) > 0 ? skg_tex_address_clamp : skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 1);
+
+	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
+		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * result.array_count);
+		glGenFramebuffers(result.array_count, result._framebuffer_layers);
+	}
+	
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_name(skg_tex_t *tex, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(tex), name);
+	if (tex->_texture != 0)
+		glObjectLabel(GL_TEXTURE, tex->_texture, (uint32_t)strlen(name), name);
+
+	char postfix_name[256];
+	if (tex->_framebuffer_layers) {
+		for (int32_t i = 0; i<tex->array_count; i+=1) {
+			snprintf(postfix_name, sizeof(postfix_name), "%s_framebuffer_layer_%d", name, i);
+			glBindFramebuffer(GL_FRAMEBUFFER, tex->_framebuffer_layers[i]);
+			glObjectLabel    (GL_FRAMEBUFFER, tex->_framebuffer_layers[i], (uint32_t)strlen(postfix_name), postfix_name);
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_is_valid(const skg_tex_t *tex) {
+	return tex->_target != 0;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_copy_to, skg_capture_id(tex), tex_surface, skg_capture_id(destination), dest_surface));
+	uint32_t err = glGetError();
+	while(err) {
+		skg_logf(skg_log_warning, "Unsourced (skg_tex_copy_to) err: %x", err);
+		err = glGetError();
+	}
+
+	if (destination->width != tex->width || destination->height != tex->height) {
+		skg_tex_set_contents_arr(destination, nullptr, tex->array_count, 1, tex->width, tex->height, tex->multisample);
+	}
+
+	if (tex_surface == -1 && dest_surface == -1) {
+		if (tex->array_count != destination->array_count) skg_log(skg_log_critical, "Mismatching texture array count.");
+
+		for (int32_t i=0; i<destination->array_count; i+=1) {
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, tex        ->_framebuffer_layers[i]);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination->_framebuffer_layers[i]);
+
+			glBlitFramebuffer(0, 0, tex->width, tex->height, 0, 0, tex->width, tex->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+	} else {
+		bool     src_destroy  = false;
+		uint32_t src_buffer   = tex->_framebuffer_layers ? tex->_framebuffer_layers[tex_surface] : 0;
+		bool     dest_destroy = false;
+		uint32_t dest_buffer  = destination->_framebuffer_layers ? destination->_framebuffer_layers[dest_surface] : 0;
+
+		// This could be problematic if we're genuinely interested in the
+		// primary surface, but this is probably unlikely.
+		if (src_buffer == 0) {
+			src_destroy = true;
+			glGenFramebuffers(1, &src_buffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, src_buffer);
+			gl_framebuffer_attach(tex->_texture, tex->_target, tex->format, tex->_physical_multisample, tex->multisample, 0, 0, 0, false);
+		}
+		if (dest_buffer == 0) {
+			dest_destroy = true;
+			glGenFramebuffers(1, &dest_buffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, dest_buffer);
+			gl_framebuffer_attach(destination->_texture, destination->_target, destination->format, destination->_physical_multisample, destination->multisample, 0, 0, 0, false);
+		}
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, src_buffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dest_buffer);
+
+		glBlitFramebuffer(0, 0, tex->width, tex->height, 0, 0, tex->width, tex->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+		if (src_destroy ) glDeleteFramebuffers(1, &src_buffer );
+		if (dest_destroy) glDeleteFramebuffers(1, &dest_buffer);
+	}
+
+	err = glGetError();
+	while(err) {
+		skg_logf(skg_log_warning, "skg_tex_copy_to err: %x", err);
+		err = glGetError();
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
+	SKG_TRACE_FUNC();
+	skg_swapchain_bind(destination);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, tex->_framebuffer_layers[0]); // TODO: layer stuff
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0,0,tex->width,tex->height,0,0,tex->width,tex->height, GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+}
+
+///////////////////////////////////////////
+
+void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
+	SKG_TRACE_FUNC();
+	if (tex->type != skg_tex_type_rendertarget) {
+		skg_log(skg_log_warning, "Can't bind a depth texture to a non-rendertarget");
+		return;
+	}
+	if (tex->array_count != depth->array_count) {
+		skg_log(skg_log_warning, "Mismatching array count for depth texture");
+		return;
+	}
+
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_attach_depth, skg_capture_id(tex), 0, skg_capture_id(depth), 0));
+	uint32_t err = glGetError();
+	while(err) {
+		skg_logf(skg_log_warning, "Unsourced (skg_tex_attach_depth) err: %x", err);
+		err = glGetError();
+	}
+	
+	for (int32_t i = 0; i < tex->array_count; i++) {
+		bool multiview = i == 0 && tex->array_count == skg_multiview_ct && skg_capability(skg_cap_multiview);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, tex->_framebuffer_layers[i]);
+		gl_framebuffer_attach(depth->_texture, depth->_target, depth->format, depth->_physical_multisample, depth->multisample, depth->array_count, i, 0, multiview);
+	}
+
+	err = glGetError();
+	while(err) {
+		skg_logf(skg_log_warning, "skg_tex_attach_depth err: %x", err);
+		err = glGetError();
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_settings(tex, address, sample, compare, anisotropy));
+	tex->_address    = address;
+	tex->_sample     = sample;
+	tex->_anisotropy = anisotropy;
+	tex->_compare    = compare;
+
+	uint32_t mode;
+	switch (address) {
+	case skg_tex_address_clamp:  mode = GL_CLAMP_TO_EDGE;   break;
+	case skg_tex_address_repeat: mode = GL_REPEAT;          break;
+	case skg_tex_address_mirror: mode = GL_MIRRORED_REPEAT; break;
+	default: mode = GL_REPEAT;
+	}
+
+	uint32_t filter, min_filter;
+	switch (sample) {
+	case skg_tex_sample_linear:     filter = GL_LINEAR;  min_filter = tex->mips == skg_mip_generate ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR; break;
+	case skg_tex_sample_point:      filter = GL_NEAREST; min_filter = GL_NEAREST;                                                           break;
+	case skg_tex_sample_anisotropic:filter = GL_LINEAR;  min_filter = tex->mips == skg_mip_generate ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR; break;
+	default: filter = GL_LINEAR; min_filter = GL_LINEAR;
+	}
+
+	uint32_t comparison = 0;
+	switch (compare) {
+		case skg_sample_compare_none:          comparison = 0;          break;
+		case skg_sample_compare_less:          comparison = GL_LESS;    break;
+		case skg_sample_compare_less_or_eq:    comparison = GL_LEQUAL;  break;
+		case skg_sample_compare_greater:       comparison = GL_GREATER; break;
+		case skg_sample_compare_greater_or_eq: comparison = GL_GEQUAL;  break;
+		case skg_sample_compare_equal:         comparison = GL_EQUAL;   break;
+		case skg_sample_compare_not_equal:     comparison = GL_NOTEQUAL;break;
+		case skg_sample_compare_always:        comparison = GL_ALWAYS;  break;
+		case skg_sample_compare_never:         comparison = GL_NEVER;   break;
+		default: comparison = GL_LESS;
+	}
+	float aniso = sample == skg_tex_sample_anisotropic ? (float)anisotropy : 1.0f;
+
+	// Multisample textures throw errors if you try to set sampler states.
+	bool multisample = tex->_target == GL_TEXTURE_2D_MULTISAMPLE || tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
+
+	// With sampler objects, the texture itself is left alone. It picks up
+	// a shared sampler that skg_tex_bind puts on the same slot.
+	if (gl_sampler_objects) {
+		tex->_sampler = multisample ? 0 : gl_sampler_find(mode, filter, min_filter, aniso, comparison);
+
+		// Slots this texture is already on need the new sampler too
+		if (tex->_texture != 0 && !gl_upload_thread) {
+			for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+				if (gl_binds.tex[i] != tex->_texture) continue;
+				gl_binds.sampler[i] = tex->_sampler;
+				gl_binds.tex_dirty |= 1u << i;
+			}
+		}
+		return;
+	}
+
+	if (!skg_tex_is_valid(tex)) return;
+	if (multisample) return;
+
+	glActiveTexture(skg_settings_tex_slot);
+	glBindTexture(tex->_target, tex->_texture);
+
+	glTexParameteri(tex->_target, GL_TEXTURE_WRAP_S, mode);
+	glTexParameteri(tex->_target, GL_TEXTURE_WRAP_T, mode);
+	if ((tex->use & skg_use_cubemap) > 0) {
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, mode);
+	}
+	glTexParameteri(tex->_target, GL_TEXTURE_MIN_FILTER, min_filter);
+	glTexParameteri(tex->_target, GL_TEXTURE_MAG_FILTER, filter    );
+#ifdef _SKG_GL_DESKTOP
+	glTexParameterf(tex->_target, GL_TEXTURE_MAX_ANISOTROPY_EXT, aniso);
+#endif
+	
+	if (comparison != 0) {
+		glTexParameteri(tex->_target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(tex->_target, GL_TEXTURE_COMPARE_FUNC, comparison);
+	}
+
+	int32_t err = glGetError();
+	while (err != 0) {
+		skg_logf(skg_log_warning, "skg_tex_settings err: 0x%x", err);
+		err = glGetError();
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t gl_sampler_find(uint32_t wrap, uint32_t filter, uint32_t min_filter, float anisotropy, uint32_t comparison) {
+	// GL enums for these all fit in 16 bits, so they pack into one key
+	uint32_t aniso_bits = anisotropy < 1 ? 1 : (uint32_t)anisotropy;
+	uint64_t key =
+		((uint64_t)(wrap       & 0xFFFF)      ) |
+		((uint64_t)(min_filter & 0xFFFF) << 16) |
+		((uint64_t)(comparison & 0xFFFF) << 32) |
+		((uint64_t)(aniso_bits & 0xFF  ) << 48) |
+		((uint64_t)(filter == GL_NEAREST ? 1 : 0) << 56);
+
+	// Samplers are shared between contexts, so upload threads use this too
+	std::lock_guard<std::mutex> lock(gl_sampler_mtx);
+	for (int32_t i = 0; i < gl_sampler_count; i++) {
+		if (gl_samplers[i].key == key) return gl_samplers[i].sampler;
+	}
+
+	if (gl_sampler_count + 1 > gl_sampler_cap) {
+		gl_sampler_cap = gl_sampler_cap == 0 ? 8 : gl_sampler_cap * 2;
+		gl_samplers    = (gl_sampler_t*)realloc(gl_samplers, sizeof(gl_sampler_t) * gl_sampler_cap);
+	}
+	uint32_t sampler = 0;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S,     wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T,     wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R,     wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, min_filter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, filter);
+#ifdef _SKG_GL_DESKTOP
+	glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+#endif
+	if (comparison != 0) {
+		glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, comparison);
+	}
+
+	int32_t err = glGetError();
+	while (err != 0) {
+		skg_logf(skg_log_warning, "gl_sampler_find err: 0x%x", err);
+		err = glGetError();
+	}
+
+	gl_samplers[gl_sampler_count] = { key, sampler };
+	gl_sampler_count += 1;
+	return sampler;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
+	const void *data_arr[1] = { data };
+	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
+}
+
+///////////////////////////////////////////
+
+void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_set_contents(tex, array_data, array_count, mip_count, width, height, multisample));
+	int32_t err = glGetError();
+	while (err != 0) {
+		skg_logf(skg_log_info, "Clearing unsourced (skg_tex_set_contents_arr) err: 0x%x", err);
+		err = glGetError();
+	}
+
+	if (multisample > 1) {
+		int32_t max_samples = 0;
+		glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+		if (multisample > max_samples)
+			multisample = max_samples;
+	}
+#ifdef _SKG_GL_WEB
+	multisample = 1;
+#endif
+
+	tex->width                 = width;
+	tex->height                = height;
+	tex->array_count           = array_count;
+	tex->multisample           = multisample; // multisample render to texture is technically an MSAA surface, but functions like a normal single sample texture.
+	tex->_physical_multisample = gl_caps[skg_cap_tiled_multisample] ? 1 : multisample;
+	tex->_target               = gl_tex_target(tex->use, tex->array_count, tex->_physical_multisample);
+
+	glActiveTexture(skg_settings_tex_slot);
+	glBindTexture(tex->_target, tex->_texture);
+
+	if (tex->format == skg_tex_fmt_r8)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	else if (tex->format == skg_tex_fmt_r16u || tex->format == skg_tex_fmt_r16s || tex->format == skg_tex_fmt_r16f || tex->format == skg_tex_fmt_r8g8 || tex->format == skg_tex_fmt_depth16)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+
+	tex->_format           = (uint32_t)skg_tex_fmt_to_native    (tex->format);
+	uint32_t layout        =           skg_tex_fmt_to_gl_layout (tex->format);
+	uint32_t type          =           skg_tex_fmt_to_gl_type   (tex->format);
+	bool     is_compressed =           skg_tex_fmt_is_compressed(tex->format);
+	if ((tex->use & skg_use_cubemap) > 0) {
+		if (array_count != 6) {
+			skg_log(skg_log_warning, "Cubemaps need 6 data frames");
+			return;
+		}
+	}
+
+	if      (tex->_target == GL_TEXTURE_2D_MULTISAMPLE)       { glTexStorage2DMultisample(tex->_target, tex->multisample, tex->_format, width, height, true); }
+	else if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) { glTexStorage3DMultisample(tex->_target, tex->multisample, tex->_format, width, height, array_count, true); }
+	else if (tex->_target == GL_TEXTURE_2D_ARRAY)             { glTexStorage3D           (tex->_target, mip_count,        tex->_format, width, height, array_count); }
+
+	for (int32_t array_idx = 0; array_idx < array_count; array_idx++) {
+		SKG_TRACE_SCOPE("gl_tex_upload");
+		int32_t mip_offset = 0;
+		for (int32_t m = 0; m < mip_count; m++) {
+			int32_t mip_width, mip_height;
+			skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
+			int32_t mip_bytes = skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+			void*   mip_data  = array_data == nullptr ? nullptr : (uint8_t*)array_data[array_idx] + mip_offset;
+			if (mip_data) skg_stats_upload(mip_bytes);
+
+			if        (tex->_target == GL_TEXTURE_2D_MULTISAMPLE) {
+			} else if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) {
+			} else if (tex->_target == GL_TEXTURE_2D_ARRAY) {
+				if (is_compressed) glCompressedTexSubImage3D(tex->_target,                           m, 0, 0, array_idx, mip_width, mip_height, 1, layout, mip_bytes, mip_data);
+				else               glTexSubImage3D          (tex->_target,                           m, 0, 0, array_idx, mip_width, mip_height, 1, layout, type,      mip_data);
+			} else if (tex->_target == GL_TEXTURE_CUBE_MAP) {
+				if (is_compressed) glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+array_idx , m, tex->_format, mip_width, mip_height, 0, mip_bytes,    mip_data);
+				else               glTexImage2D          (GL_TEXTURE_CUBE_MAP_POSITIVE_X+array_idx , m, tex->_format, mip_width, mip_height, 0, layout, type, mip_data);
+			} else {
+				if (is_compressed) glCompressedTexImage2D(tex->_target,                              m, tex->_format, mip_width, mip_height, 0, mip_bytes,    mip_data);
+				else               glTexImage2D          (tex->_target,                              m, tex->_format, mip_width, mip_height, 0, layout, type, mip_data);
+			}
+			mip_offset += mip_bytes;
+		}
+	}
+
+	err = glGetError();
+	while (err != 0) {
+		skg_logf(skg_log_warning, "skg_tex_set_contents_arr creation err: 0x%x", err);
+		err = glGetError();
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (tex->mips == skg_mip_generate && mip_count == 1) {
+		SKG_TRACE_SCOPE("glGenerateMipmap");
+		glGenerateMipmap(tex->_target);
+
+		err = glGetError();
+		if (err != 0) {
+			skg_logf(skg_log_warning, "skg_tex_set_contents_arr mip err: 0x%x", err);
+		}
+	}
+	skg_mem_track_tex(skg_mem_key(tex), tex, tex->mips == skg_mip_generate && mip_count == 1 ? (int32_t)skg_mip_count(width, height) : mip_count, tex->_physical_multisample);
+
+	if (tex->type == skg_tex_type_rendertarget || tex->type == skg_tex_type_depthtarget) {
+		SKG_TRACE_SCOPE("gl_framebuffer_setup");
+		tex->_framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * tex->array_count);
+		glGenFramebuffers(tex->array_count, tex->_framebuffer_layers);
+
+		for (int32_t i = 0; i < tex->array_count; i++) {
+			glBindFramebuffer(GL_FRAMEBUFFER, tex->_framebuffer_layers[i]);
+			gl_framebuffer_attach(tex->_texture, tex->_target, tex->format, tex->_physical_multisample, tex->multisample, tex->array_count, i, 0, false);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
+
+		err = glGetError();
+		while (err != 0) {
+			skg_logf(skg_log_warning, "skg_tex_set_contents_arr framebuffer err: 0x%x", err);
+			err = glGetError();
+		}
+	}
+
+	skg_tex_settings(tex, tex->_address, tex->_sample, tex->_compare, tex->_anisotropy);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	uint32_t result = glGetError();
+	while (result != 0) {
+		skg_logf(skg_log_warning, "skg_tex_get_mip_contents_arr: eating a gl error from somewhere else: 0x%x", result);
+		result = glGetError();
+	}
+	
+	// Double check on mips first
+	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	if (mip_level != 0) {
+		if (tex->mips != skg_mip_generate) {
+			skg_log(skg_log_critical, "Can't get mip data from a texture with no mips!");
+			return false;
+		}
+		if (mip_level >= mip_levels) {
+			skg_log(skg_log_critical, "This texture doesn't have quite as many mip levels as you think.");
+			return false;
+		}
+	}
+
+	// Make sure we've been provided enough memory to hold this texture
+	int32_t width       = 0;
+	int32_t height      = 0;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+
+	if (data_size != skg_tex_fmt_memory(tex->format, width, height)) {
+		skg_log(skg_log_critical, "Insufficient buffer size for skg_tex_get_mip_contents_arr");
+		return false;
+	}
+
+	int64_t layout = skg_tex_fmt_to_gl_layout(tex->format);
+	glActiveTexture(skg_settings_tex_slot);
+	glBindTexture  (tex->_target, tex->_texture);
+
+#if defined(_SKG_GL_WEB) || defined(_SKG_GL_ES)
+	// Referenced from here:
+	// https://stackoverflow.com/questions/53993820/opengl-es-2-0-android-c-glgetteximage-alternative
+	uint32_t fbo = 0;
+	glGenFramebuffers     (1, &fbo); 
+	glBindFramebuffer     (GL_FRAMEBUFFER, fbo);
+	if (tex->_target == GL_TEXTURE_CUBE_MAP) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X+arr_index, tex->_texture, mip_level);
+	} else {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->_target, tex->_texture, mip_level);
+	}
+
+	glReadPixels(0, 0, width, height, layout, skg_tex_fmt_to_gl_type(tex->format), ref_data);
+
+	glBindFramebuffer   (GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+#else
+	if (tex->_target == GL_TEXTURE_CUBE_MAP) {
+		glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X+arr_index, mip_level, (uint32_t)layout, skg_tex_fmt_to_gl_type(tex->format), ref_data);
+	} else {
+		glGetTexImage(tex->_target, mip_level, (uint32_t)layout, skg_tex_fmt_to_gl_type(tex->format), ref_data);
+	}
+#endif
+
+	result = glGetError();
+	if (result != 0) {
+		skg_logf(skg_log_critical, "skg_tex_get_mip_contents_arr error: 0x%x", result);
+	}
+
+	return result == 0;
+}
+
+///////////////////////////////////////////
+
+void gl_readback_prepare(skg_readback_t *readback, size_t size) {
+#if defined(_SKG_GL_WEB)
+	if (readback->size != size) {
+		free(readback->_data);
+		readback->_data = malloc(size);
+	}
+#else
+	if (readback->_fence) glDeleteSync(readback->_fence);
+	readback->_fence = nullptr;
+
+	if (readback->_buffer == 0) glGenBuffers(1, &readback->_buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->_buffer);
+	if (readback->_data) {
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		readback->_data = nullptr;
+	}
+	if (readback->size != size)
+		glBufferData(GL_PIXEL_PACK_BUFFER, (int32_t)size, nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+	readback->size = size;
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_read_async(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	if (skg_tex_fmt_is_compressed(tex->format) || skg_tex_fmt_is_depth(tex->format) || tex->_physical_multisample > 1) {
+		skg_log(skg_log_warning, "skg_tex_read_async doesn't support compressed, depth, or MSAA textures");
+		return false;
+	}
+	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	if (mip_level >= mip_levels || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "skg_tex_read_async: this texture doesn't have the mip level or array slice you asked for.");
+		return false;
+	}
+
+	int32_t width, height;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+	gl_readback_prepare(ref_readback, skg_tex_fmt_memory(tex->format, width, height));
+	ref_readback->width  = width;
+	ref_readback->height = height;
+	ref_readback->format = tex->format;
+
+	// Reading through a framebuffer works on every flavor of GL, and lets
+	// us pick out a single array slice.
+	if (gl_readback_fbo == 0) glGenFramebuffers(1, &gl_readback_fbo);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, gl_readback_fbo);
+	if      (tex->_target == GL_TEXTURE_CUBE_MAP) glFramebufferTexture2D   (GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X+arr_index, tex->_texture, mip_level);
+	else if (tex->_target == GL_TEXTURE_2D_ARRAY) glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->_texture, mip_level, arr_index);
+	else                                          glFramebufferTexture2D   (GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->_target, tex->_texture, mip_level);
+
+	uint32_t layout = skg_tex_fmt_to_gl_layout(tex->format);
+	uint32_t type   = skg_tex_fmt_to_gl_type  (tex->format);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#if defined(_SKG_GL_WEB)
+	// WebGL can't map buffers, so this one has to wait on the GPU.
+	glReadPixels(0, 0, width, height, layout, type, ref_readback->_data);
+#else
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ref_readback->_buffer);
+	glReadPixels(0, 0, width, height, layout, type, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	ref_readback->_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	// Detach, so the framebuffer doesn't keep a destroyed texture alive.
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+	glBindFramebuffer     (GL_READ_FRAMEBUFFER, gl_current_framebuffer);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool skg_readback_poll(skg_readback_t *readback) {
+#if defined(_SKG_GL_WEB)
+	return readback->_data != nullptr;
+#else
+	if (readback->_buffer == 0) return false;
+	if (readback->_fence  == nullptr) return true;
+
+	if (glClientWaitSync(readback->_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+		return false;
+	glDeleteSync(readback->_fence);
+	readback->_fence = nullptr;
+	return true;
+#endif
+}
+
+///////////////////////////////////////////
+
+const void *skg_readback_map(skg_readback_t *readback, size_t *out_size) {
+	SKG_TRACE_FUNC();
+	if (out_size) *out_size = readback->size;
+#if !defined(_SKG_GL_WEB)
+	if (readback->_buffer == 0 || readback->_data != nullptr)
+		return readback->_data;
+
+	if (readback->_fence) {
+		SKG_TRACE_SCOPE("gl_readback_wait");
+		while (glClientWaitSync(readback->_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+		glDeleteSync(readback->_fence);
+		readback->_fence = nullptr;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->_buffer);
+	readback->_data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback->size, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+	return readback->_data;
+}
+
+///////////////////////////////////////////
+
+void skg_readback_destroy(skg_readback_t *readback) {
+	SKG_TRACE_FUNC();
+#if defined(_SKG_GL_WEB)
+	free(readback->_data);
+#else
+	// Deleting a mapped buffer unmaps it too.
+	if (readback->_fence ) glDeleteSync   (readback->_fence);
+	if (readback->_buffer) glDeleteBuffers(1, &readback->_buffer);
+#endif
+	*readback = {};
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_gen_mips, skg_capture_id(tex_mipped_rt)));
+	uint32_t err = glGetError();
+	while (err != 0) {
+		skg_logf(skg_log_warning, "skg_tex_gen_mips: eating a gl error from somewhere else: 0x%x", err);
+		err = glGetError();
+	}
+
+	glActiveTexture(skg_settings_tex_slot);
+	glBindTexture(tex_mipped_rt->_target, tex_mipped_rt->_texture);
+
+	glGenerateMipmap(tex_mipped_rt->_target);
+
+	err = glGetError();
+	if (err != 0)
+		skg_logf(skg_log_critical, "skg_tex_gen_mips error: 0x%x", err);
+
+	return err == 0;
+}
+
+///////////////////////////////////////////
+
+void* skg_tex_get_native(const skg_tex_t* tex) {
+	SKG_TRACE_FUNC();
+	return (void*)((uint64_t)tex->_texture);
+}
+
+///////////////////////////////////////////
+
+void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_bind, skg_capture_id(texture), bind));
+	if (bind.stage_bits & skg_stage_compute) {
+#if !defined(_SKG_GL_WEB)
+		glBindImageTexture(bind.slot, texture->_texture, 0, false, 0, texture->_access, (uint32_t)skg_tex_fmt_to_native( texture->format ));
+#endif
+	} else if (bind.slot >= SKG_GL_BIND_SLOTS) {
+		// Past the end of the cache, so this goes straight to GL
+		SKG_STAT_MISS(skg_stat_texture);
+		glActiveTexture(GL_TEXTURE0 + bind.slot);
+		glBindTexture(texture->_target, texture->_texture);
+		if (gl_sampler_objects) glBindSampler(bind.slot, texture->_sampler);
+	} else {
+		gl_binds.tex       [bind.slot] = texture->_texture;
+		gl_binds.tex_target[bind.slot] = texture->_target;
+		gl_binds.sampler   [bind.slot] = texture->_sampler;
+		gl_binds.tex_dirty |= 1u << bind.slot;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_tex_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_clear, 0, bind));
+}
+
+///////////////////////////////////////////
+
+void skg_tex_destroy(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_destroy, skg_capture_id(tex)));
+	if (gl_destroy_deferred) {
+		gl_destroy_t *item = (gl_destroy_t*)calloc(1, sizeof(gl_destroy_t));
+		item->type = gl_destroy_type_tex;
+		item->tex  = *tex;
+		gl_destroy_push(item);
+		*tex = {};
+		return;
+	}
+	gl_tex_destroy(tex);
+}
+
+///////////////////////////////////////////
+
+void gl_tex_destroy(skg_tex_t *tex) {
+	// Make sure it's not bound or cached in our pipeline state
+	if (tex->_target) {
+		for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+			if (gl_binds.tex[i] == tex->_texture) gl_binds.tex[i] = 0;
+			if (gl_pipeline.tex_bind[i] != tex->_texture) continue;
+
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture  (tex->_target, 0);
+			gl_pipeline.tex_bind[i] = 0;
+		}
+	}
+	
+	uint32_t tex_list[] = { tex->_texture };
+	if (tex->_texture ) glDeleteTextures (1, tex_list);
+	if (tex->_framebuffer_layers) {
+		glDeleteFramebuffers(tex->array_count, tex->_framebuffer_layers);
+		free(tex->_framebuffer_layers);
+	}
+	skg_mem_release(skg_mem_key(tex));
+	*tex = {};
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_buffer_type_to_gl(skg_buffer_type_ type) {
+	switch (type) {
+	case skg_buffer_type_vertex:   return GL_ARRAY_BUFFER;
+	case skg_buffer_type_index:    return GL_ELEMENT_ARRAY_BUFFER;
+	case skg_buffer_type_constant: return GL_UNIFORM_BUFFER;
+	case skg_buffer_type_compute:  return GL_SHADER_STORAGE_BUFFER;
+#if defined(_SKG_GL_WEB)
+	case skg_buffer_type_indirect: return GL_COPY_WRITE_BUFFER;
+#else
+	// Without indirect draws, the buffer is only ever a copy source
+	case skg_buffer_type_indirect: return glDrawElementsIndirect ? GL_DRAW_INDIRECT_BUFFER : GL_COPY_WRITE_BUFFER;
+#endif
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_fmt_to_gl_type(skg_fmt_ format) {
+	switch (format) {
+	case skg_fmt_f32:             return GL_FLOAT;
+	case skg_fmt_f16:             return GL_HALF_FLOAT;
+	case skg_fmt_i32:             return GL_INT;
+	case skg_fmt_i16:
+	case skg_fmt_i16_normalized:  return GL_SHORT;
+	case skg_fmt_i8:
+	case skg_fmt_i8_normalized:   return GL_BYTE;
+	case skg_fmt_ui32:            return GL_UNSIGNED_INT;
+	case skg_fmt_ui16:
+	case skg_fmt_ui16_normalized: return GL_UNSIGNED_SHORT;
+	case skg_fmt_ui8:
+	case skg_fmt_ui8_normalized:  return GL_UNSIGNED_BYTE;
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+int64_t skg_tex_fmt_to_native(skg_tex_fmt_ format) {
+	switch (format) {
+	case skg_tex_fmt_rgba32:        return GL_SRGB8_ALPHA8;
+	case skg_tex_fmt_rgba32_linear: return GL_RGBA8;
+	case skg_tex_fmt_bgra32:        return GL_RGBA8;
+	case skg_tex_fmt_bgra32_linear: return GL_RGBA8;
+	case skg_tex_fmt_rg11b10:       return GL_R11F_G11F_B10F;
+	case skg_tex_fmt_rgb10a2:       return GL_RGB10_A2;
+	case skg_tex_fmt_rgba64u:       return GL_RGBA16;
+	case skg_tex_fmt_rgba64s:       return GL_RGBA16_SNORM;
+	case skg_tex_fmt_rgba64f:       return GL_RGBA16F;
+	case skg_tex_fmt_rgba128:       return GL_RGBA32F;
+	case skg_tex_fmt_depth16:       return GL_DEPTH_COMPONENT16;
+	case skg_tex_fmt_depth32:       return GL_DEPTH_COMPONENT32F;
+	case skg_tex_fmt_depthstencil:  return GL_DEPTH24_STENCIL8;
+	case skg_tex_fmt_r8:            return GL_R8;
+	case skg_tex_fmt_r16u:          return GL_R16;
+	case skg_tex_fmt_r16s:          return GL_R16_SNORM;
+	case skg_tex_fmt_r16f:          return GL_R16F;
+	case skg_tex_fmt_r32:           return GL_R32F;
+	case skg_tex_fmt_r8g8:          return GL_RG8;
+
+	case skg_tex_fmt_etc1_rgb:          return GL_ETC1_RGB8_OES;
+	case skg_tex_fmt_etc2_rgba:         return GL_COMPRESSED_RGBA8_ETC2_EAC;
+	case skg_tex_fmt_etc2_rgba_srgb:    return GL_COMPRESSED_SRGB8_ETC2;
+	case skg_tex_fmt_etc2_r11:          return GL_COMPRESSED_R11_EAC;
+	case skg_tex_fmt_etc2_rg11:         return GL_COMPRESSED_RG11_EAC;
+
+	// These extensions are only available on real GLES
+	case skg_tex_fmt_pvrtc1_rgb:        return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG        : 0;
+	case skg_tex_fmt_pvrtc1_rgb_srgb:   return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_SRGB_PVRTC_4BPPV1_EXT       : 0;
+	case skg_tex_fmt_pvrtc1_rgba:       return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG       : 0;
+	case skg_tex_fmt_pvrtc1_rgba_srgb:  return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV1_EXT : 0;
+	case skg_tex_fmt_pvrtc2_rgba:       return gl_caps[skg_cap_fmt_pvrtc2] ? GL_COMPRESSED_RGBA_PVRTC_4BPPV2_IMG       : 0;
+	case skg_tex_fmt_pvrtc2_rgba_srgb:  return gl_caps[skg_cap_fmt_pvrtc2] ? GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV2_IMG : 0;
+	case skg_tex_fmt_astc4x4_rgba:      return gl_caps[skg_cap_fmt_astc  ] ? GL_COMPRESSED_RGBA_ASTC_4x4_KHR           : 0;
+	case skg_tex_fmt_astc4x4_rgba_srgb: return gl_caps[skg_cap_fmt_astc  ] ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR   : 0;
+	case skg_tex_fmt_atc_rgb:           return gl_caps[skg_cap_fmt_atc   ] ? GL_ATC_RGB_AMD                            : 0;
+	case skg_tex_fmt_atc_rgba:          return gl_caps[skg_cap_fmt_atc   ] ? GL_ATC_RGBA_EXPLICIT_ALPHA_AMD            : 0;
+
+	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+	case skg_tex_fmt_bc1_rgb_srgb:      return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+	case skg_tex_fmt_bc1_rgb:           return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case skg_tex_fmt_bc3_rgba_srgb:     return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+	case skg_tex_fmt_bc3_rgba:          return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	case skg_tex_fmt_bc5_rg:            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+skg_tex_fmt_ skg_tex_fmt_from_native(int64_t format) {
+	switch (format) {
+	case GL_SRGB8_ALPHA8:       return skg_tex_fmt_rgba32;
+	case GL_RGBA8:              return skg_tex_fmt_rgba32_linear;
+	case GL_R11F_G11F_B10F:     return skg_tex_fmt_rg11b10;
+	case GL_RGB10_A2:           return skg_tex_fmt_rgb10a2;
+	case GL_RGBA16:             return skg_tex_fmt_rgba64u;
+	case GL_RGBA16_SNORM:       return skg_tex_fmt_rgba64s;
+	case GL_RGBA16F:            return skg_tex_fmt_rgba64f;
+	case GL_RGBA32F:            return skg_tex_fmt_rgba128;
+	case GL_DEPTH_COMPONENT16:  return skg_tex_fmt_depth16;
+	case GL_DEPTH_COMPONENT32F: return skg_tex_fmt_depth32;
+	case GL_DEPTH24_STENCIL8:   return skg_tex_fmt_depthstencil;
+	case GL_R8:                 return skg_tex_fmt_r8;
+	case GL_R16:                return skg_tex_fmt_r16u;
+	case GL_R16F:               return skg_tex_fmt_r16f;
+	case GL_R16_SNORM:          return skg_tex_fmt_r16s;
+	case GL_R32F:               return skg_tex_fmt_r32;
+	case GL_RG8:                return skg_tex_fmt_r8g8;
+
+	case GL_ETC1_RGB8_OES:                         return skg_tex_fmt_etc1_rgb;
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:             return skg_tex_fmt_etc2_rgba;
+	case GL_COMPRESSED_SRGB8_ETC2:                 return skg_tex_fmt_etc2_rgba_srgb;
+	case GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG:       return skg_tex_fmt_pvrtc1_rgb;
+	case GL_COMPRESSED_SRGB_PVRTC_4BPPV1_EXT:      return skg_tex_fmt_pvrtc1_rgb_srgb;
+	case GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG:      return skg_tex_fmt_pvrtc1_rgba;
+	case GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV1_EXT:return skg_tex_fmt_pvrtc1_rgba_srgb;
+	case GL_COMPRESSED_RGBA_PVRTC_4BPPV2_IMG:      return skg_tex_fmt_pvrtc2_rgba;
+	case GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV2_IMG:return skg_tex_fmt_pvrtc2_rgba_srgb;
+	case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:          return skg_tex_fmt_astc4x4_rgba;
+	case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR:  return skg_tex_fmt_astc4x4_rgba_srgb;
+	case GL_ATC_RGB_AMD:                           return skg_tex_fmt_atc_rgb;
+
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:       return skg_tex_fmt_bc1_rgb_srgb;
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:        return skg_tex_fmt_bc1_rgb;
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT: return skg_tex_fmt_bc3_rgba_srgb;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:       return skg_tex_fmt_bc3_rgba;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:       return skg_tex_fmt_bc5_rg;
+
+	default: return skg_tex_fmt_none;
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_tex_fmt_to_gl_layout(skg_tex_fmt_ format) {
+	switch (format) {
+	case skg_tex_fmt_rgba32:
+	case skg_tex_fmt_rgba32_linear:
+	case skg_tex_fmt_rgb10a2:
+	case skg_tex_fmt_rgba64u:
+	case skg_tex_fmt_rgba64s:
+	case skg_tex_fmt_rgba64f:
+	case skg_tex_fmt_rgba128:
+	case skg_tex_fmt_atc_rgba:
+	case skg_tex_fmt_pvrtc1_rgba:
+	case skg_tex_fmt_pvrtc1_rgba_srgb:
+	case skg_tex_fmt_pvrtc2_rgba:
+	case skg_tex_fmt_pvrtc2_rgba_srgb:
+	case skg_tex_fmt_astc4x4_rgba:
+	case skg_tex_fmt_astc4x4_rgba_srgb:
+	case skg_tex_fmt_bc3_rgba_srgb:
+	case skg_tex_fmt_bc3_rgba:
+	case skg_tex_fmt_etc2_rgba_srgb:
+	case skg_tex_fmt_etc2_rgba:     return GL_RGBA;
+	case skg_tex_fmt_etc1_rgb:
+	case skg_tex_fmt_atc_rgb:
+	case skg_tex_fmt_pvrtc1_rgb:
+	case skg_tex_fmt_pvrtc1_rgb_srgb:
+	case skg_tex_fmt_bc1_rgb_srgb:
+	case skg_tex_fmt_bc1_rgb:
+	case skg_tex_fmt_rg11b10:       return GL_RGB;
+	case skg_tex_fmt_bgra32:
+	case skg_tex_fmt_bgra32_linear:
+		#ifdef _SKG_GL_WEB // WebGL has no GL_BGRA?
+		return GL_RGBA;
+		#else
+		return GL_BGRA;
+		#endif
+	case skg_tex_fmt_depth16:
+	case skg_tex_fmt_depth32:       return GL_DEPTH_COMPONENT;
+	case skg_tex_fmt_depthstencil:  return GL_DEPTH_STENCIL;
+	case skg_tex_fmt_r8:
+	case skg_tex_fmt_r16u:
+	case skg_tex_fmt_r16s:
+	case skg_tex_fmt_r16f:
+	case skg_tex_fmt_r32:
+	case skg_tex_fmt_etc2_r11:      return GL_RED;
+	case skg_tex_fmt_bc5_rg:
+	case skg_tex_fmt_etc2_rg11:
+	case skg_tex_fmt_r8g8:          return GL_RG;
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_tex_fmt_to_gl_type(skg_tex_fmt_ format) {
+	switch (format) {
+	case skg_tex_fmt_rgba32:        return GL_UNSIGNED_BYTE;
+	case skg_tex_fmt_rgba32_linear: return GL_UNSIGNED_BYTE;
+	case skg_tex_fmt_bgra32:        return GL_UNSIGNED_BYTE;
+	case skg_tex_fmt_bgra32_linear: return GL_UNSIGNED_BYTE;
+	case skg_tex_fmt_r8g8:          return GL_UNSIGNED_BYTE;
+	case skg_tex_fmt_r8:            return GL_UNSIGNED_BYTE;
+	case skg_tex_fmt_rgba64u:       return GL_UNSIGNED_SHORT;
+	case skg_tex_fmt_depth16:       return GL_UNSIGNED_SHORT;
+	case skg_tex_fmt_r16u:          return GL_UNSIGNED_SHORT;
+	case skg_tex_fmt_r16s:          return GL_SHORT;
+	case skg_tex_fmt_rgba64s:       return GL_SHORT;
+	case skg_tex_fmt_rgb10a2:       return GL_UNSIGNED_INT_2_10_10_10_REV;
+	case skg_tex_fmt_rg11b10:       return GL_UNSIGNED_INT_10F_11F_11F_REV;
+	case skg_tex_fmt_rgba128:       return GL_FLOAT;
+	case skg_tex_fmt_depth32:       return GL_FLOAT;
+	case skg_tex_fmt_r32:           return GL_FLOAT;
+	case skg_tex_fmt_rgba64f:       return GL_HALF_FLOAT;
+	case skg_tex_fmt_r16f:          return GL_HALF_FLOAT;
+	case skg_tex_fmt_depthstencil:  return GL_UNSIGNED_INT_24_8;
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
+	return gl_tex_fmt_supported[format];
+}
+
+///////////////////////////////////////////
+
+// Buffer and texture names can overlap, so the low bit keeps them apart.
+// Layer views share their texture with the one that owns the memory, and
+// are never tracked, so the next bit gives them keys that match nothing.
+uint64_t skg_mem_key(const skg_buffer_t *buffer) {
+	return (uint64_t)buffer->_buffer << 1;
+}
+uint64_t skg_mem_key(const skg_tex_t *tex) {
+	return (uint64_t)tex->_texture << 2 | (tex->_view ? 2 : 0) | 1;
+}
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+uint64_t skg_capture_id(const skg_buffer_t *buffer) {
+	return buffer->_buffer;
+}
+uint64_t skg_capture_id(const skg_shader_t *shader) {
+	return shader->_program;
+}
+uint64_t skg_capture_id(const skg_tex_t *tex) {
+	// Layers made with skg_tex_create_from_layer share their texture name.
+	return (uint64_t)tex->array_start << 32 | tex->_texture;
+}
+#endif
+
+#endif
+#ifdef SKG_NULL
+///////////////////////////////////////////
+// Null Implementation                   //
+///////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////
+
+skg_null_calls_t null_calls       = {};
+skg_null_calls_t null_calls_last  = {};
+skg_null_live_t  null_live        = {};
+uint32_t         null_next_id     = 1;
+int32_t          null_viewport[4] = {};
+skg_tex_t       *null_active_rendertarget = nullptr;
+char             null_adapter_name[]      = "sk_gpu null device";
+
+///////////////////////////////////////////
+
+size_t null_tex_mip_offset(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index) {
+	size_t layer_size = 0;
+	size_t mip_offset = 0;
+	for (int32_t m = 0; m < tex->_mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(tex->width, tex->height, m, &mip_width, &mip_height);
+		if (m == mip_level) mip_offset = layer_size;
+		layer_size += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	return layer_size * arr_index + mip_offset;
+}
+
+///////////////////////////////////////////
+
+void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+int32_t skg_init(const char *app_name, void *adapter_id) {
+	SKG_TRACE_FUNC();
+	null_calls      = {};
+	null_calls_last = {};
+	null_live       = {};
+	skg_logf(skg_log_info, "Using %s", null_adapter_name);
+	return 1;
+}
+
+///////////////////////////////////////////
+
+const char* skg_adapter_name() {
+	return null_adapter_name;
+}
+
+///////////////////////////////////////////
+
+void skg_shutdown() {
+	SKG_TRACE_FUNC();
+	if (null_live.buffers + null_live.textures + null_live.shaders + null_live.pipelines + null_live.meshes > 0) {
+		skg_logf(skg_log_info, "Null shutdown with live resources: %d buffers, %d meshes, %d shaders, %d pipelines, %d textures",
+			null_live.buffers, null_live.meshes, null_live.shaders, null_live.pipelines, null_live.textures);
+	}
+	null_active_rendertarget = nullptr;
+	skg_vert_fmt_clear();
+}
+
+///////////////////////////////////////////
+
+skg_platform_data_t skg_get_platform_data() {
+	skg_platform_data_t result = {};
+	result._calls_last_frame = &null_calls_last;
+	result._calls_this_frame = &null_calls;
+	result._live             = &null_live;
+	return result;
+}
+
+///////////////////////////////////////////
+
+bool skg_capability(skg_cap_ capability) {
+	return false;
+}
+
+///////////////////////////////////////////
+
+bool skg_upload_thread_begin() {
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_upload_thread_end() {
+}
+
+///////////////////////////////////////////
+
+void skg_deferred_destroy_enable(bool enabled) {
+}
+
+///////////////////////////////////////////
+
+void skg_event_begin(const char *name) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_begin(name));
+}
+
+///////////////////////////////////////////
+
+void skg_event_end() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_end());
+}
+
+///////////////////////////////////////////
+
+void skg_timer_begin(const char *name) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_timer_end() {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+int32_t skg_timer_get_results(skg_timer_result_t *out_results, int32_t max_results) {
+	return 0;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_begin() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_frame());
+	null_calls_last = null_calls;
+	null_calls      = {};
+}
+
+///////////////////////////////////////////
+
+void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw(index_start, index_base, index_count, instance_count));
+	_skg_stats.draws          += 1;
+	null_calls.draws          += 1;
+	null_calls.draw_indices   += index_count;
+	null_calls.draw_instances += instance_count;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_indirect(args_buffer, offset, draw_count, stride));
+	if (args_buffer->type != skg_buffer_type_indirect) {
+		skg_log(skg_log_warning, "skg_draw_indirect needs a skg_buffer_type_indirect buffer");
+		return;
+	}
+	if (stride == 0) stride = sizeof(skg_draw_args_t);
+	if (draw_count == 0) return;
+	if (offset % 4 != 0 || stride % 4 != 0) {
+		skg_log(skg_log_warning, "skg_draw_indirect offset and stride need to be multiples of 4");
+		return;
+	}
+	if (offset + (uint64_t)stride * (draw_count - 1) + sizeof(skg_draw_args_t) > args_buffer->_size) {
+		skg_log(skg_log_warning, "skg_draw_indirect is reading past the end of the args buffer");
+		return;
+	}
+	_skg_stats.draws += draw_count;
+	for (uint32_t i = 0; i < draw_count; i++) {
+		const skg_draw_args_t *draw = (const skg_draw_args_t*)((uint8_t*)args_buffer->_data + offset + i * stride);
+		null_calls.draws          += 1;
+		null_calls.draw_indices   += draw->index_count;
+		null_calls.draw_instances += draw->instance_count;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_multi(draws, draw_count));
+	_skg_stats.draws += draw_count;
+	for (uint32_t i = 0; i < draw_count; i++) {
+		null_calls.draws          += 1;
+		null_calls.draw_indices   += draws[i].index_count;
+		null_calls.draw_instances += draws[i].instance_count;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_compute(thread_count_x, thread_count_y, thread_count_z));
+	_skg_stats.dispatches += 1;
+	null_calls.computes   += 1;
+}
+
+///////////////////////////////////////////
+
+void skg_viewport(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_viewport, xywh));
+	memcpy(null_viewport, xywh, sizeof(null_viewport));
+}
+
+///////////////////////////////////////////
+
+void skg_viewport_get(int32_t *out_xywh) {
+	SKG_TRACE_FUNC();
+	memcpy(out_xywh, null_viewport, sizeof(null_viewport));
+}
+
+///////////////////////////////////////////
+
+void skg_scissor(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_scissor, xywh));
+}
+
+///////////////////////////////////////////
+
+void skg_target_clear(bool depth, const float *clear_color_4) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_target_clear(depth, clear_color_4));
+	null_calls.target_clears += 1;
+}
+
+///////////////////////////////////////////
+// skg_buffer_t                          //
+///////////////////////////////////////////
+
+skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
+	SKG_TRACE_FUNC();
+	skg_buffer_t result = {};
+	result.use    = use;
+	result.type   = type;
+	result.stride = size_stride;
+	result._id    = null_next_id++;
+	result._size  = size_count * size_stride;
+	result._data  = calloc(result._size > 0 ? result._size : 1, 1);
+	if (data) memcpy(result._data, data, result._size);
+	if (type == skg_buffer_type_index)
+		result._ind_format = skg_ind_fmt_from_stride(size_stride);
+
+	null_live.buffers      += 1;
+	null_live.buffer_bytes += result._size;
+	skg_mem_track(skg_mem_key(&result), skg_mem_buffer, result._size);
+	SKG_CAPTURE_CALL(skg_capture_buffer_create(&result, data, size_count, size_stride));
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(buffer), name);
+}
+
+///////////////////////////////////////////
+
+bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
+	return buffer->_id != 0;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
 		return;
+	}
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_contents(buffer, data, size_bytes));
+	if (size_bytes > buffer->_size) {
+		skg_log(skg_log_warning, "Attempting to set more data than the buffer can hold!");
+		size_bytes = buffer->_size;
+	}
+	memcpy(buffer->_data, data, size_bytes);
 
-	swapchain->width  = width;
-	swapchain->height = height;
-
-#ifdef _SKG_GL_WEB
-	skg_tex_fmt_ color_fmt = swapchain->_surface.format;
-	skg_tex_fmt_ depth_fmt = swapchain->_surface_depth.format;
+	skg_stats_upload(size_bytes);
+	null_calls.buffer_uploads += 1;
+	null_calls.upload_bytes   += size_bytes;
+}
 
-	if (skg_tex_is_valid(&swapchain->_surface      )) skg_tex_destroy(&swapchain->_surface);
-	if (skg_tex_is_valid(&swapchain->_surface_depth)) skg_tex_destroy(&swapchain->_surface_depth);
+///////////////////////////////////////////
 
-	swapchain->_surface = skg_tex_create(skg_tex_type_rendertarget, skg_use_static, color_fmt, skg_mip_none);
-	skg_tex_set_contents(&swapchain->_surface, nullptr, swapchain->width, swapchain->height);
+void skg_buffer_set_contents_range(skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+	if (offset > buffer->_size || size_bytes > buffer->_size - offset) {
+		skg_log(skg_log_warning, "skg_buffer_set_contents_range is writing outside of the buffer!");
+		return;
+	}
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_range(buffer, offset, data, size_bytes));
+	memcpy((uint8_t*)buffer->_data + offset, data, size_bytes);
 
-	swapchain->_surface_depth = skg_tex_create(skg_tex_type_depth, skg_use_static, depth_fmt, skg_mip_none);
-	skg_tex_set_contents(&swapchain->_surface_depth, nullptr, swapchain->width, swapchain->height);
-	skg_tex_attach_depth(&swapchain->_surface, &swapchain->_surface_depth);
-#endif
+	skg_stats_upload(size_bytes);
+	null_calls.buffer_uploads += 1;
+	null_calls.upload_bytes   += size_bytes;
 }
 
 ///////////////////////////////////////////
 
-void skg_swapchain_present(skg_swapchain_t *swapchain) {
-#if   defined(_SKG_GL_LOAD_WGL)
-	SwapBuffers((HDC)swapchain->_hdc);
-#elif defined(_SKG_GL_LOAD_EGL)
-	eglSwapBuffers(egl_display, swapchain->_egl_surface);
-#elif defined(_SKG_GL_LOAD_GLX)
-	glXSwapBuffers(xDisplay, (Drawable) swapchain->_x_window);
-#elif defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
-	float clear[4] = { 0,0,0,1 };
-	skg_tex_target_bind(nullptr, -1, 0);
-	skg_target_clear   (true, clear);
-	skg_tex_bind      (&swapchain->_surface, {0, skg_stage_pixel});
-	skg_mesh_bind     (&swapchain->_quad_mesh);
-	skg_pipeline_bind (&swapchain->_convert_pipe);
-	skg_draw          (0, 0, 6, 1);
-#endif
+void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	SKG_TRACE_FUNC();
+	uint32_t copy_size = buffer_size < buffer->_size ? buffer_size : buffer->_size;
+	memcpy(ref_buffer, buffer->_data, copy_size);
+	if (copy_size < buffer_size) memset((uint8_t*)ref_buffer + copy_size, 0, buffer_size - copy_size);
 }
 
 ///////////////////////////////////////////
 
-void skg_swapchain_bind(skg_swapchain_t *swapchain) {
-	gl_active_width  = swapchain->width;
-	gl_active_height = swapchain->height;
-#if   defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
-	skg_tex_target_bind(&swapchain->_surface, -1, 0);
-#elif defined(_SKG_GL_LOAD_WGL)
-	wglMakeCurrent((HDC)swapchain->_hdc, gl_hrc);
-	if (wglSwapIntervalEXT) wglSwapIntervalEXT(1); // Enable VSync
-	skg_tex_target_bind(nullptr, -1, 0);
-#elif defined(_SKG_GL_LOAD_EGL)
-	eglMakeCurrent(egl_display, swapchain->_egl_surface, swapchain->_egl_surface, egl_context);
-	skg_tex_target_bind(nullptr, -1, 0);
-#elif defined(_SKG_GL_LOAD_GLX)
-	glXMakeCurrent(xDisplay, (Drawable)swapchain->_x_window, glxContext);
-	skg_tex_target_bind(nullptr, -1, 0);
-#endif
+bool skg_buffer_read_async(const skg_buffer_t *buffer, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	if (buffer->_data == nullptr || buffer->_size == 0) return false;
+
+	if (ref_readback->size != buffer->_size) {
+		free(ref_readback->_data);
+		ref_readback->_data = malloc(buffer->_size);
+		ref_readback->size  = buffer->_size;
+	}
+	ref_readback->width  = (int32_t)buffer->_size;
+	ref_readback->height = 1;
+	ref_readback->format = skg_tex_fmt_none;
+	memcpy(ref_readback->_data, buffer->_data, buffer->_size);
+	return true;
 }
 
 ///////////////////////////////////////////
 
-void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
-#if defined(_SKG_GL_LOAD_WGL)
-	if (swapchain->_hdc != nullptr) {
-		wglMakeCurrent(nullptr, nullptr);
-		ReleaseDC((HWND)swapchain->_hwnd, (HDC)swapchain->_hdc);
-		swapchain->_hwnd = nullptr;
-		swapchain->_hdc  = nullptr;
-	}
-#elif defined(_SKG_GL_LOAD_EGL)
-	eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-	if (swapchain->_egl_surface != EGL_NO_SURFACE) eglDestroySurface(egl_display, swapchain->_egl_surface);
-	swapchain->_egl_surface = EGL_NO_SURFACE;
-#endif
+void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t slot_vc) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_bind, skg_capture_id(buffer), slot_vc));
+	SKG_STAT_MISS(skg_stat_buffer);
+	null_calls.buffer_binds += 1;
 }
 
 ///////////////////////////////////////////
 
-uint32_t gl_tex_target(skg_use_ tex_use, int32_t array_count, int32_t multisample) {
-	if (multisample > 1) {
-		return array_count == 1
-			? GL_TEXTURE_2D_MULTISAMPLE
-			: GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
-	} else {
-		return array_count > 1
-			? ((tex_use & skg_use_cubemap) > 0 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D_ARRAY)
-			: GL_TEXTURE_2D;
-	}
+void skg_buffer_bind_range(const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_buffer_bind_range, skg_capture_id(buffer), slot_vc, offset, size_bytes, nullptr));
+	if (offset % skg_buffer_range_align(buffer->type) != 0 || offset + size_bytes > buffer->_size)
+		skg_log(skg_log_warning, "skg_buffer_bind_range range is misaligned, or outside of the buffer");
+	SKG_STAT_MISS(skg_stat_buffer);
+	null_calls.buffer_binds += 1;
 }
 
 ///////////////////////////////////////////
 
-void gl_framebuffer_attach(uint32_t texture, uint32_t target, skg_tex_fmt_ format, int32_t physical_multisample, int32_t multisample, int32_t array_count, uint32_t layer, uint32_t mip_level, bool multiview) {
-	uint32_t attach = GL_COLOR_ATTACHMENT0;
-	if      (format == skg_tex_fmt_depthstencil)                             attach = GL_DEPTH_STENCIL_ATTACHMENT;
-	else if (format == skg_tex_fmt_depth16 || format == skg_tex_fmt_depth32) attach = GL_DEPTH_ATTACHMENT;
-
-	bool is_framebuffer_msaa = multisample > physical_multisample;
-	if      (multiview && array_count == skg_multiview_ct && gl_caps[skg_cap_multiview_tiled_multisample] == true && is_framebuffer_msaa)
-	                                                                            glFramebufferTextureMultisampleMultiviewOVR(GL_FRAMEBUFFER, attach,         texture, mip_level, multisample, layer, skg_multiview_ct);
-	else if (multiview && array_count == skg_multiview_ct && gl_caps[skg_cap_multiview] == true)
-	                                                                            glFramebufferTextureMultiviewOVR           (GL_FRAMEBUFFER, attach,         texture, mip_level, layer, skg_multiview_ct);
-	else if (array_count > 1)                                                   glFramebufferTextureLayer                  (GL_FRAMEBUFFER, attach,         texture, mip_level, layer);
-	else if (gl_caps[skg_cap_tiled_multisample] == true && is_framebuffer_msaa) glFramebufferTexture2DMultisampleEXT       (GL_FRAMEBUFFER, attach, target, texture, mip_level, multisample);
-	else                                                                        glFramebufferTexture                       (GL_FRAMEBUFFER, attach,         texture, mip_level);
-	
-	uint32_t status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (status != GL_FRAMEBUFFER_COMPLETE) {
-		skg_logf(skg_log_critical, "Framebuffer incomplete: %x\n", status);
-	}
+uint32_t skg_buffer_range_align(skg_buffer_type_ type) {
+	return type == skg_buffer_type_constant ? 256 : 1;
 }
 
 ///////////////////////////////////////////
 
-skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_count, int32_t physical_multisample, int32_t framebuffer_multisample) {
-	uint32_t err = glGetError();
-	while(err) {
-		skg_logf(skg_log_warning, "Unsourced (skg_tex_create_from_existing) err: %x", err);
-		err = glGetError();
+bool skg_transient_bind(const void *data, uint32_t size_bytes, skg_bind_t slot_vc) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_transient_bind, 0, slot_vc, 0, size_bytes, data));
+	if (slot_vc.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_transient_bind only works with constant registers");
+		return false;
 	}
-	
-	skg_tex_t result = {};
-	result.type        = type;
-	result.use         = skg_use_static;
-	result.mips        = skg_mip_none;
-	result.format      = format;
-	result.width       = width;
-	result.height      = height;
-	result.array_count = array_count;
-	result.multisample = framebuffer_multisample > physical_multisample ? framebuffer_multisample : physical_multisample;
-	result._physical_multisample = physical_multisample;
-	result._texture    = (uint32_t)(uint64_t)native_tex;
-	result._format     = (uint32_t)skg_tex_fmt_to_native(result.format);
-	result._target     = gl_tex_target(result.use, array_count, physical_multisample);
+	SKG_STAT_MISS(skg_stat_buffer);
+	skg_stats_upload(size_bytes);
+	null_calls.buffer_binds   += 1;
+	null_calls.upload_bytes   += size_bytes;
+	return true;
+}
 
-	// Check if this is an external texture
-	gl_pipeline.tex_bind[0] = result._texture; // Similar to a PIPELINE_CHECK
-	skg_log_enable(false); // Intentional error, don't scare the users.
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture  (GL_TEXTURE_EXTERNAL_OES, result._texture);
-	skg_log_enable(true);
-	if (!glGetError()) {
-		result._target = GL_TEXTURE_EXTERNAL_OES;
-	}
+///////////////////////////////////////////
 
-	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
-		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * result.array_count);
-		glGenFramebuffers(result.array_count, result._framebuffer_layers);
+void skg_buffer_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_clear, 0, bind));
+}
 
-		for (int32_t i = 0; i < result.array_count; i++) {
-			bool multiview = i == 0 && array_count == skg_multiview_ct && skg_capability(skg_cap_multiview);
+///////////////////////////////////////////
 
-			glBindFramebuffer(GL_FRAMEBUFFER, result._framebuffer_layers[i]);
-			gl_framebuffer_attach(result._texture, result._target, result.format, result._physical_multisample, result.multisample, result.array_count, i, 0, multiview);
-		}
+void skg_buffer_destroy(skg_buffer_t *buffer) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_buffer_destroy, skg_capture_id(buffer)));
+	if (buffer->_id != 0) {
+		null_live.buffers      -= 1;
+		null_live.buffer_bytes -= buffer->_size;
+		skg_mem_release(skg_mem_key(buffer));
+	}
+	free(buffer->_data);
+	*buffer = {};
+}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
-	}
+///////////////////////////////////////////
+// skg_mesh_t                            //
+///////////////////////////////////////////
 
-	err = glGetError();
-	while(err) {
-		skg_logf(skg_log_warning, "skg_tex_create_from_existing err: %x", err);
-		err = glGetError();
-	}
-	
+skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
+	skg_mesh_t result = {};
+	result._id = null_next_id++;
+	skg_mesh_set_verts(&result, vert_buffer);
+	skg_mesh_set_inds (&result, ind_buffer);
+
+	null_live.meshes += 1;
 	return result;
 }
 
 ///////////////////////////////////////////
 
-skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_layer) {
-	skg_tex_t result = {};
-	result.type        = type;
-	result.use         = skg_use_static;
-	result.mips        = skg_mip_none;
-	result.format      = format;
-	result.width       = width;
-	result.height      = height;
-	result.array_count = 1;
-	result.array_start = array_layer;
-	result.multisample = 1;
-	result._physical_multisample = 1;
-	result._texture    = (uint32_t)(uint64_t)native_tex;
-	result._format     = (uint32_t)skg_tex_fmt_to_native(result.format);
-	result._target     = gl_tex_target(result.use, 2, result._physical_multisample);
+void skg_mesh_name(skg_mesh_t *mesh, const char* name) {
+	SKG_TRACE_FUNC();
+}
 
-	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
-		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * 1);
-		glGenFramebuffers(1, result._framebuffer_layers);
+///////////////////////////////////////////
 
-		glBindFramebuffer(GL_FRAMEBUFFER, result._framebuffer_layers[0]);
-		gl_framebuffer_attach(result._texture, result._target, result.format, result._physical_multisample, result.multisample, result.array_count, array_layer, 0, false);
+void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
+	SKG_TRACE_FUNC();
+	mesh->_vert_buffer = vert_buffer ? vert_buffer->_id : 0;
+}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
-	}
+///////////////////////////////////////////
 
-	return result;
+void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
+	mesh->_ind_buffer = ind_buffer ? ind_buffer->_id : 0;
+	mesh->_ind_format = ind_buffer ? ind_buffer->_ind_format : skg_ind_fmt_u32;
 }
 
 ///////////////////////////////////////////
 
-skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
-	skg_tex_t result = {};
-	result.type    = type;
-	result.use     = use;
-	result.format  = format;
-	result.mips    = mip_maps;
-	result._format = (uint32_t)skg_tex_fmt_to_native(result.format);
+void skg_mesh_set_format(skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count) {
+	SKG_TRACE_FUNC();
+	int32_t fmt = skg_vert_fmt_register(components, component_count);
+	if (fmt >= 0) mesh->_vert_fmt = fmt;
+}
 
-	if      (use & skg_use_compute_read && use & skg_use_compute_write) result._access = GL_READ_WRITE;
-	else if (use & skg_use_compute_read)                                result._access = GL_READ_ONLY;
-	else if (use & skg_use_compute_write)                               result._access = GL_WRITE_ONLY;
-	result._format = (uint32_t)skg_tex_fmt_to_native(result.format);
+///////////////////////////////////////////
 
-	glGenTextures(1, &result._texture);
-	skg_tex_settings(&result, (use & skg_use_cubemap) > 0 ? skg_tex_address_clamp : skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 1);
+void skg_mesh_bind(const skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_mesh_bind(mesh->_vert_buffer, mesh->_ind_buffer, mesh->_vert_fmt));
+	SKG_STAT_MISS(skg_stat_layout);
+	SKG_STAT_MISS(skg_stat_buffer);
+	null_calls.mesh_binds += 1;
+}
 
-	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
-		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * result.array_count);
-		glGenFramebuffers(result.array_count, result._framebuffer_layers);
-	}
-	
-	return result;
+///////////////////////////////////////////
+
+void skg_mesh_destroy(skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	if (mesh->_id != 0) null_live.meshes -= 1;
+	*mesh = {};
 }
 
+///////////////////////////////////////////
+// skg_shader_t                          //
 ///////////////////////////////////////////
 
-void skg_tex_name(skg_tex_t *tex, const char* name) {
-	if (tex->_texture != 0)
-		glObjectLabel(GL_TEXTURE, tex->_texture, (uint32_t)strlen(name), name);
+skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
+	SKG_TRACE_FUNC();
+	skg_shader_stage_t result = {};
+	result.type = type;
+	result._id  = null_next_id++;
 
-	char postfix_name[256];
-	if (tex->_framebuffer_layers) {
-		for (int32_t i = 0; i<tex->array_count; i+=1) {
-			snprintf(postfix_name, sizeof(postfix_name), "%s_framebuffer_layer_%d", name, i);
-			glBindFramebuffer(GL_FRAMEBUFFER, tex->_framebuffer_layers[i]);
-			glObjectLabel    (GL_FRAMEBUFFER, tex->_framebuffer_layers[i], (uint32_t)strlen(postfix_name), postfix_name);
-		}
-	}
+	return result;
 }
 
 ///////////////////////////////////////////
 
-bool skg_tex_is_valid(const skg_tex_t *tex) {
-	return tex->_target != 0;
+void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+	SKG_TRACE_FUNC();
+	*shader = {};
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
-	uint32_t err = glGetError();
-	while(err) {
-		skg_logf(skg_log_warning, "Unsourced (skg_tex_copy_to) err: %x", err);
-		err = glGetError();
-	}
-
-	if (destination->width != tex->width || destination->height != tex->height) {
-		skg_tex_set_contents_arr(destination, nullptr, tex->array_count, 1, tex->width, tex->height, tex->multisample);
+skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
+	SKG_TRACE_FUNC();
+	if (v_shader._id == 0 && p_shader._id == 0 && c_shader._id == 0) {
+		skg_logf(skg_log_warning, "Shader '%s' has no valid stages!", meta->name);
+		return {};
 	}
 
-	if (tex_surface == -1 && dest_surface == -1) {
-		if (tex->array_count != destination->array_count) skg_log(skg_log_critical, "Mismatching texture array count.");
+	skg_shader_t result = {};
+	result.meta = meta;
+	result._id  = null_next_id++;
+	skg_shader_meta_reference(result.meta);
 
-		for (int32_t i=0; i<destination->array_count; i+=1) {
-			glBindFramebuffer(GL_READ_FRAMEBUFFER, tex        ->_framebuffer_layers[i]);
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination->_framebuffer_layers[i]);
+	null_live.shaders += 1;
+	return result;
+}
 
-			glBlitFramebuffer(0, 0, tex->width, tex->height, 0, 0, tex->width, tex->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-		}
-	} else {
-		bool     src_destroy  = false;
-		uint32_t src_buffer   = tex->_framebuffer_layers ? tex->_framebuffer_layers[tex_surface] : 0;
-		bool     dest_destroy = false;
-		uint32_t dest_buffer  = destination->_framebuffer_layers ? destination->_framebuffer_layers[dest_surface] : 0;
+///////////////////////////////////////////
 
-		// This could be problematic if we're genuinely interested in the
-		// primary surface, but this is probably unlikely.
-		if (src_buffer == 0) {
-			src_destroy = true;
-			glGenFramebuffers(1, &src_buffer);
-			glBindFramebuffer(GL_FRAMEBUFFER, src_buffer);
-			gl_framebuffer_attach(tex->_texture, tex->_target, tex->format, tex->_physical_multisample, tex->multisample, 0, 0, 0, false);
-		}
-		if (dest_buffer == 0) {
-			dest_destroy = true;
-			glGenFramebuffers(1, &dest_buffer);
-			glBindFramebuffer(GL_FRAMEBUFFER, dest_buffer);
-			gl_framebuffer_attach(destination->_texture, destination->_target, destination->format, destination->_physical_multisample, destination->multisample, 0, 0, 0, false);
-		}
+void skg_shader_name(skg_shader_t *shader, const char* name) {
+	SKG_TRACE_FUNC();
+}
 
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, src_buffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dest_buffer);
+///////////////////////////////////////////
 
-		glBlitFramebuffer(0, 0, tex->width, tex->height, 0, 0, tex->width, tex->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+bool skg_shader_is_valid(const skg_shader_t *shader) {
+	return shader->meta
+		&& shader->_id;
+}
 
-		if (src_destroy ) glDeleteFramebuffers(1, &src_buffer );
-		if (dest_destroy) glDeleteFramebuffers(1, &dest_buffer);
-	}
+///////////////////////////////////////////
 
-	err = glGetError();
-	while(err) {
-		skg_logf(skg_log_warning, "skg_tex_copy_to err: %x", err);
-		err = glGetError();
-	}
+bool skg_shader_is_ready(const skg_shader_t *shader) {
+	return true;
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
-	skg_swapchain_bind(destination);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, tex->_framebuffer_layers[0]); // TODO: layer stuff
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-	glBlitFramebuffer(0,0,tex->width,tex->height,0,0,tex->width,tex->height, GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+void skg_shader_compute_bind(const skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_compute_bind, shader ? skg_capture_id(shader) : 0));
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
-	if (tex->type != skg_tex_type_rendertarget) {
-		skg_log(skg_log_warning, "Can't bind a depth texture to a non-rendertarget");
-		return;
-	}
-	if (tex->array_count != depth->array_count) {
-		skg_log(skg_log_warning, "Mismatching array count for depth texture");
-		return;
-	}
+void skg_shader_destroy(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_destroy, skg_capture_id(shader)));
+	if (shader->_id != 0) null_live.shaders -= 1;
+	skg_shader_meta_release(shader->meta);
+	*shader = {};
+}
 
-	uint32_t err = glGetError();
-	while(err) {
-		skg_logf(skg_log_warning, "Unsourced (skg_tex_attach_depth) err: %x", err);
-		err = glGetError();
-	}
-	
-	for (int32_t i = 0; i < tex->array_count; i++) {
-		bool multiview = i == 0 && tex->array_count == skg_multiview_ct && skg_capability(skg_cap_multiview);
+///////////////////////////////////////////
+// skg_pipeline                          //
+///////////////////////////////////////////
 
-		glBindFramebuffer(GL_FRAMEBUFFER, tex->_framebuffer_layers[i]);
-		gl_framebuffer_attach(depth->_texture, depth->_target, depth->format, depth->_physical_multisample, depth->multisample, depth->array_count, i, 0, multiview);
-	}
+skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	skg_pipeline_t result = {};
+	result.transparency = skg_transparency_none;
+	result.cull         = skg_cull_back;
+	result.wireframe    = false;
+	result.depth_test   = skg_depth_test_less;
+	result.depth_write  = true;
+	result.depth_clip   = true;
+	result.meta         = shader->meta;
+	result._id          = null_next_id++;
+	result._shader      = shader->_id;
+	skg_shader_meta_reference(result.meta);
 
-	err = glGetError();
-	while(err) {
-		skg_logf(skg_log_warning, "skg_tex_attach_depth err: %x", err);
-		err = glGetError();
-	}
+	null_live.pipelines += 1;
+	return result;
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
-	tex->_address    = address;
-	tex->_sample     = sample;
-	tex->_anisotropy = anisotropy;
-	tex->_compare    = compare;
+void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+	SKG_TRACE_FUNC();
+}
 
-	uint32_t mode;
-	switch (address) {
-	case skg_tex_address_clamp:  mode = GL_CLAMP_TO_EDGE;   break;
-	case skg_tex_address_repeat: mode = GL_REPEAT;          break;
-	case skg_tex_address_mirror: mode = GL_MIRRORED_REPEAT; break;
-	default: mode = GL_REPEAT;
-	}
+///////////////////////////////////////////
 
-	uint32_t filter, min_filter;
-	switch (sample) {
-	case skg_tex_sample_linear:     filter = GL_LINEAR;  min_filter = tex->mips == skg_mip_generate ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR; break;
-	case skg_tex_sample_point:      filter = GL_NEAREST; min_filter = GL_NEAREST;                                                           break;
-	case skg_tex_sample_anisotropic:filter = GL_LINEAR;  min_filter = tex->mips == skg_mip_generate ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR; break;
-	default: filter = GL_LINEAR; min_filter = GL_LINEAR;
-	}
+void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_pipeline_bind(pipeline, pipeline->_shader));
+	SKG_STAT_MISS(skg_stat_program);
+	SKG_STAT_MISS(skg_stat_blend);
+	SKG_STAT_MISS(skg_stat_cull);
+	SKG_STAT_MISS(skg_stat_depth);
+	null_calls.pipeline_binds += 1;
+}
 
-	if (!skg_tex_is_valid(tex)) return;
-	// Multisample textures throw errors if you try to set sampler states.
-	if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE || tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) return;
+///////////////////////////////////////////
 
-	glActiveTexture(skg_settings_tex_slot);
-	glBindTexture(tex->_target, tex->_texture);
+void              skg_pipeline_set_transparency(      skg_pipeline_t *pipeline, skg_transparency_ transparency) { pipeline->transparency = transparency; }
+skg_transparency_ skg_pipeline_get_transparency(const skg_pipeline_t *pipeline)                                 { return pipeline->transparency; }
+void              skg_pipeline_set_cull        (      skg_pipeline_t *pipeline, skg_cull_ cull)                 { pipeline->cull = cull; }
+skg_cull_         skg_pipeline_get_cull        (const skg_pipeline_t *pipeline)                                 { return pipeline->cull; }
+void              skg_pipeline_set_wireframe   (      skg_pipeline_t *pipeline, bool wireframe)                 { pipeline->wireframe = wireframe; }
+bool              skg_pipeline_get_wireframe   (const skg_pipeline_t *pipeline)                                 { return pipeline->wireframe; }
+void              skg_pipeline_set_depth_write (      skg_pipeline_t *pipeline, bool write)                     { pipeline->depth_write = write; }
+bool              skg_pipeline_get_depth_write (const skg_pipeline_t *pipeline)                                 { return pipeline->depth_write; }
+void              skg_pipeline_set_depth_clip  (      skg_pipeline_t *pipeline, bool clip)                      { pipeline->depth_clip = clip; }
+bool              skg_pipeline_get_depth_clip  (const skg_pipeline_t *pipeline)                                 { return pipeline->depth_clip; }
+void              skg_pipeline_set_color_write (      skg_pipeline_t *pipeline, skg_color_write_ write)         { pipeline->color_write = write; }
+skg_color_write_  skg_pipeline_get_color_write (const skg_pipeline_t *pipeline)                                 { return pipeline->color_write; }
+void              skg_pipeline_set_depth_test  (      skg_pipeline_t *pipeline, skg_depth_test_ test)           { pipeline->depth_test = test; }
+skg_depth_test_   skg_pipeline_get_depth_test  (const skg_pipeline_t *pipeline)                                 { return pipeline->depth_test; }
+void              skg_pipeline_set_scissor     (      skg_pipeline_t *pipeline, bool enable)                    { pipeline->scissor = enable; }
+bool              skg_pipeline_get_scissor     (const skg_pipeline_t *pipeline)                                 { return pipeline->scissor; }
 
-	glTexParameteri(tex->_target, GL_TEXTURE_WRAP_S, mode);
-	glTexParameteri(tex->_target, GL_TEXTURE_WRAP_T, mode);
-	if ((tex->use & skg_use_cubemap) > 0) {
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, mode);
-	}
-	glTexParameteri(tex->_target, GL_TEXTURE_MIN_FILTER, min_filter);
-	glTexParameteri(tex->_target, GL_TEXTURE_MAG_FILTER, filter    );
-#ifdef _SKG_GL_DESKTOP
-	glTexParameterf(tex->_target, GL_TEXTURE_MAX_ANISOTROPY_EXT, sample == skg_tex_sample_anisotropic ? anisotropy : 1.0f);
-#endif
-	
-	if (compare != skg_sample_compare_none) {
-		uint32_t comparison;
-		switch (compare) {
-			case skg_sample_compare_none:          comparison = GL_LESS;    break; // Shouldn't matter, but this is what we've been using
-			case skg_sample_compare_less:          comparison = GL_LESS;    break;
-			case skg_sample_compare_less_or_eq:    comparison = GL_LEQUAL;  break;
-			case skg_sample_compare_greater:       comparison = GL_GREATER; break;
-			case skg_sample_compare_greater_or_eq: comparison = GL_GEQUAL;  break;
-			case skg_sample_compare_equal:         comparison = GL_EQUAL;   break;
-			case skg_sample_compare_not_equal:     comparison = GL_NOTEQUAL;break;
-			case skg_sample_compare_always:        comparison = GL_ALWAYS;  break;
-			case skg_sample_compare_never:         comparison = GL_NEVER;   break;
-			default: comparison = GL_LESS;
-		}
-		glTexParameteri(tex->_target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-		glTexParameteri(tex->_target, GL_TEXTURE_COMPARE_FUNC, comparison);
-	}
+///////////////////////////////////////////
 
-	int32_t err = glGetError();
-	while (err != 0) {
-		skg_logf(skg_log_warning, "skg_tex_settings err: 0x%x", err);
-		err = glGetError();
-	}
+void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	if (pipeline->_id != 0) null_live.pipelines -= 1;
+	skg_shader_meta_release(pipeline->meta);
+	*pipeline = {};
 }
 
+///////////////////////////////////////////
+// skg_swapchain_t                       //
 ///////////////////////////////////////////
 
-void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
-	const void *data_arr[1] = { data };
-	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
+skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
+	SKG_TRACE_FUNC();
+	skg_swapchain_t result = {};
+	result.width  = requested_width;
+	result.height = requested_height;
+	return result;
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
-	int32_t err = glGetError();
-	while (err != 0) {
-		skg_logf(skg_log_info, "Clearing unsourced (skg_tex_set_contents_arr) err: 0x%x", err);
-		err = glGetError();
-	}
-
-	if (multisample > 1) {
-		int32_t max_samples = 0;
-		glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
-		if (multisample > max_samples)
-			multisample = max_samples;
-	}
-#ifdef _SKG_GL_WEB
-	multisample = 1;
-#endif
-
-	tex->width                 = width;
-	tex->height                = height;
-	tex->array_count           = array_count;
-	tex->multisample           = multisample; // multisample render to texture is technically an MSAA surface, but functions like a normal single sample texture.
-	tex->_physical_multisample = gl_caps[skg_cap_tiled_multisample] ? 1 : multisample;
-	tex->_target               = gl_tex_target(tex->use, tex->array_count, tex->_physical_multisample);
-
-	glActiveTexture(skg_settings_tex_slot);
-	glBindTexture(tex->_target, tex->_texture);
+void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
+	swapchain->width  = width;
+	swapchain->height = height;
+}
 
-	if (tex->format == skg_tex_fmt_r8)
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	else if (tex->format == skg_tex_fmt_r16u || tex->format == skg_tex_fmt_r16s || tex->format == skg_tex_fmt_r16f || tex->format == skg_tex_fmt_r8g8 || tex->format == skg_tex_fmt_depth16)
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+///////////////////////////////////////////
 
-	tex->_format           = (uint32_t)skg_tex_fmt_to_native    (tex->format);
-	uint32_t layout        =           skg_tex_fmt_to_gl_layout (tex->format);
-	uint32_t type          =           skg_tex_fmt_to_gl_type   (tex->format);
-	bool     is_compressed =           skg_tex_fmt_is_compressed(tex->format);
-	if ((tex->use & skg_use_cubemap) > 0) {
-		if (array_count != 6) {
-			skg_log(skg_log_warning, "Cubemaps need 6 data frames");
-			return;
-		}
-	}
+void skg_swapchain_present(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+}
 
-	if      (tex->_target == GL_TEXTURE_2D_MULTISAMPLE)       { glTexStorage2DMultisample(tex->_target, tex->multisample, tex->_format, width, height, true); }
-	else if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) { glTexStorage3DMultisample(tex->_target, tex->multisample, tex->_format, width, height, array_count, true); }
-	else if (tex->_target == GL_TEXTURE_2D_ARRAY)             { glTexStorage3D           (tex->_target, mip_count,        tex->_format, width, height, array_count); }
+///////////////////////////////////////////
 
-	for (int32_t array_idx = 0; array_idx < array_count; array_idx++) {
-		int32_t mip_offset = 0;
-		for (int32_t m = 0; m < mip_count; m++) {
-			int32_t mip_width, mip_height;
-			skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
-			int32_t mip_bytes = skg_tex_fmt_memory(tex->format, mip_width, mip_height);
-			void*   mip_data  = array_data == nullptr ? nullptr : (uint8_t*)array_data[array_idx] + mip_offset;
+void skg_swapchain_bind(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+	null_active_rendertarget = nullptr;
+	int32_t viewport[4] = { 0, 0, swapchain->width, swapchain->height };
+	skg_viewport(viewport);
+}
 
-			if        (tex->_target == GL_TEXTURE_2D_MULTISAMPLE) {
-			} else if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) {
-			} else if (tex->_target == GL_TEXTURE_2D_ARRAY) {
-				if (is_compressed) glCompressedTexSubImage3D(tex->_target,                           m, 0, 0, array_idx, mip_width, mip_height, 1, layout, mip_bytes, mip_data);
-				else               glTexSubImage3D          (tex->_target,                           m, 0, 0, array_idx, mip_width, mip_height, 1, layout, type,      mip_data);
-			} else if (tex->_target == GL_TEXTURE_CUBE_MAP) {
-				if (is_compressed) glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+array_idx , m, tex->_format, mip_width, mip_height, 0, mip_bytes,    mip_data);
-				else               glTexImage2D          (GL_TEXTURE_CUBE_MAP_POSITIVE_X+array_idx , m, tex->_format, mip_width, mip_height, 0, layout, type, mip_data);
-			} else {
-				if (is_compressed) glCompressedTexImage2D(tex->_target,                              m, tex->_format, mip_width, mip_height, 0, mip_bytes,    mip_data);
-				else               glTexImage2D          (tex->_target,                              m, tex->_format, mip_width, mip_height, 0, layout, type, mip_data);
-			}
-			mip_offset += mip_bytes;
-		}
-	}
+///////////////////////////////////////////
 
-	err = glGetError();
-	while (err != 0) {
-		skg_logf(skg_log_warning, "skg_tex_set_contents_arr creation err: 0x%x", err);
-		err = glGetError();
-	}
+void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+	*swapchain = {};
+}
 
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+///////////////////////////////////////////
+// skg_tex_t                             //
+///////////////////////////////////////////
 
-	if (tex->mips == skg_mip_generate && mip_count == 1) {
-		glGenerateMipmap(tex->_target);
+skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_count, int32_t multisample, int32_t framebuffer_multisample) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = {};
+	result.type        = type;
+	result.use         = skg_use_static;
+	result.mips        = skg_mip_none;
+	result.format      = format;
+	result.width       = width;
+	result.height      = height;
+	result.array_count = array_count;
+	result.multisample = framebuffer_multisample > multisample ? framebuffer_multisample : multisample;
+	result._id         = null_next_id++;
+	result._mip_count  = 1;
 
-		err = glGetError();
-		if (err != 0) {
-			skg_logf(skg_log_warning, "skg_tex_set_contents_arr mip err: 0x%x", err);
-		}
-	}
+	null_live.textures += 1;
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
+	return result;
+}
 
-	if (tex->type == skg_tex_type_rendertarget || tex->type == skg_tex_type_depthtarget) {
-		tex->_framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * tex->array_count);
-		glGenFramebuffers(tex->array_count, tex->_framebuffer_layers);
+///////////////////////////////////////////
 
-		for (int32_t i = 0; i < tex->array_count; i++) {
-			glBindFramebuffer(GL_FRAMEBUFFER, tex->_framebuffer_layers[i]);
-			gl_framebuffer_attach(tex->_texture, tex->_target, tex->format, tex->_physical_multisample, tex->multisample, tex->array_count, i, 0, false);
-		}
+skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_layer) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = skg_tex_create_from_existing(native_tex, type, format, width, height, 1, 1, 1);
+	result.array_start = array_layer;
+	return result;
+}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
+///////////////////////////////////////////
 
-		err = glGetError();
-		while (err != 0) {
-			skg_logf(skg_log_warning, "skg_tex_set_contents_arr framebuffer err: 0x%x", err);
-			err = glGetError();
-		}
-	}
+skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = {};
+	result.type        = type;
+	result.use         = use;
+	result.format      = format;
+	result.mips        = mip_maps;
+	result.array_count = 1;
+	result._id         = null_next_id++;
+	skg_mem_add(skg_mem_key(&result));
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create, &result));
+	skg_tex_settings(&result, (use & skg_use_cubemap) > 0 ? skg_tex_address_clamp : skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 1);
 
-	skg_tex_settings(tex, tex->_address, tex->_sample, tex->_compare, tex->_anisotropy);
+	null_live.textures += 1;
+	return result;
 }
 
 ///////////////////////////////////////////
 
-bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
-	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
+void skg_tex_name(skg_tex_t *tex, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(tex), name);
 }
 
 ///////////////////////////////////////////
 
-bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
-	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
+bool skg_tex_is_valid(const skg_tex_t *tex) {
+	return tex->_id != 0;
 }
 
 ///////////////////////////////////////////
 
-bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
-	uint32_t result = glGetError();
-	while (result != 0) {
-		skg_logf(skg_log_warning, "skg_tex_get_mip_contents_arr: eating a gl error from somewhere else: 0x%x", result);
-		result = glGetError();
+void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_copy_to, skg_capture_id(tex), tex_surface, skg_capture_id(destination), dest_surface));
+	if (destination->width != tex->width || destination->height != tex->height) {
+		skg_tex_set_contents_arr(destination, nullptr, tex->array_count, 1, tex->width, tex->height, tex->multisample);
 	}
-	
-	// Double check on mips first
-	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
-	if (mip_level != 0) {
-		if (tex->mips != skg_mip_generate) {
-			skg_log(skg_log_critical, "Can't get mip data from a texture with no mips!");
-			return false;
-		}
-		if (mip_level >= mip_levels) {
-			skg_log(skg_log_critical, "This texture doesn't have quite as many mip levels as you think.");
-			return false;
+	if (tex->_data == nullptr || destination->_data == nullptr || tex->format != destination->format) return;
+
+	if (tex_surface == -1 && dest_surface == -1) {
+		for (int32_t i = 0; i < destination->array_count && i < tex->array_count; i++) {
+			size_t size = skg_tex_fmt_memory(tex->format, tex->width, tex->height);
+			memcpy((uint8_t*)destination->_data + null_tex_mip_offset(destination, 0, i), (uint8_t*)tex->_data + null_tex_mip_offset(tex, 0, i), size);
 		}
+	} else {
+		size_t size = skg_tex_fmt_memory(tex->format, tex->width, tex->height);
+		memcpy((uint8_t*)destination->_data + null_tex_mip_offset(destination, 0, dest_surface < 0 ? 0 : dest_surface), (uint8_t*)tex->_data + null_tex_mip_offset(tex, 0, tex_surface < 0 ? 0 : tex_surface), size);
 	}
+}
 
-	// Make sure we've been provided enough memory to hold this texture
-	int32_t width       = 0;
-	int32_t height      = 0;
-	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+///////////////////////////////////////////
 
-	if (data_size != skg_tex_fmt_memory(tex->format, width, height)) {
-		skg_log(skg_log_critical, "Insufficient buffer size for skg_tex_get_mip_contents_arr");
-		return false;
-	}
+void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
+	SKG_TRACE_FUNC();
+}
 
-	int64_t layout = skg_tex_fmt_to_gl_layout(tex->format);
-	glActiveTexture(skg_settings_tex_slot);
-	glBindTexture  (tex->_target, tex->_texture);
+///////////////////////////////////////////
 
-#if defined(_SKG_GL_WEB) || defined(_SKG_GL_ES)
-	// Referenced from here:
-	// https://stackoverflow.com/questions/53993820/opengl-es-2-0-android-c-glgetteximage-alternative
-	uint32_t fbo = 0;
-	glGenFramebuffers     (1, &fbo); 
-	glBindFramebuffer     (GL_FRAMEBUFFER, fbo);
-	if (tex->_target == GL_TEXTURE_CUBE_MAP) {
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X+arr_index, tex->_texture, mip_level);
-	} else {
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->_target, tex->_texture, mip_level);
+void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
+	SKG_TRACE_FUNC();
+	if (tex->type != skg_tex_type_rendertarget) {
+		skg_log(skg_log_warning, "Can't bind a depth texture to a non-rendertarget");
+		return;
+	}
+	if (tex->array_count != depth->array_count) {
+		skg_log(skg_log_warning, "Mismatching array count for depth texture");
+		return;
 	}
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_attach_depth, skg_capture_id(tex), 0, skg_capture_id(depth), 0));
+	tex->_depth = depth->_id;
+}
 
-	glReadPixels(0, 0, width, height, layout, skg_tex_fmt_to_gl_type(tex->format), ref_data);
+///////////////////////////////////////////
 
-	glBindFramebuffer   (GL_FRAMEBUFFER, 0);
-	glDeleteFramebuffers(1, &fbo);
-#else
-	if (tex->_target == GL_TEXTURE_CUBE_MAP) {
-		glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X+arr_index, mip_level, (uint32_t)layout, skg_tex_fmt_to_gl_type(tex->format), ref_data);
-	} else {
-		glGetTexImage(tex->_target, mip_level, (uint32_t)layout, skg_tex_fmt_to_gl_type(tex->format), ref_data);
-	}
-#endif
+void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_settings(tex, address, sample, compare, anisotropy));
+	tex->_address    = address;
+	tex->_sample     = sample;
+	tex->_compare    = compare;
+	tex->_anisotropy = anisotropy;
+}
 
-	result = glGetError();
-	if (result != 0) {
-		skg_logf(skg_log_critical, "skg_tex_get_mip_contents_arr error: 0x%x", result);
-	}
+///////////////////////////////////////////
 
-	return result == 0;
+void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
+	const void *data_arr[1] = { data };
+	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
 }
 
 ///////////////////////////////////////////
 
-bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
-	uint32_t err = glGetError();
-	while (err != 0) {
-		skg_logf(skg_log_warning, "skg_tex_gen_mips: eating a gl error from somewhere else: 0x%x", err);
-		err = glGetError();
+void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
+	SKG_TRACE_FUNC();
+	if ((tex->use & skg_use_cubemap) > 0 && array_count != 6) {
+		skg_log(skg_log_warning, "Cubemaps need 6 data frames");
+		return;
 	}
 
-	glActiveTexture(skg_settings_tex_slot);
-	glBindTexture(tex_mipped_rt->_target, tex_mipped_rt->_texture);
+	SKG_CAPTURE_CALL(skg_capture_tex_set_contents(tex, array_data, array_count, mip_count, width, height, multisample));
+	null_live.tex_bytes -= tex->_data_size;
+	free(tex->_data);
 
-	glGenerateMipmap(tex_mipped_rt->_target);
+	tex->width       = width;
+	tex->height      = height;
+	tex->array_count = array_count;
+	tex->multisample = multisample;
+	tex->_mip_count  = tex->mips == skg_mip_generate && mip_count == 1
+		? (int32_t)skg_mip_count(width, height)
+		: mip_count;
 
-	err = glGetError();
-	if (err != 0)
-		skg_logf(skg_log_critical, "skg_tex_gen_mips error: 0x%x", err);
+	// Keep a CPU copy of the texture's contents, laid out as
+	// [array][mip], same as the data we're given.
+	size_t layer_size = null_tex_mip_offset(tex, 0, 1);
+	size_t data_size  = 0;
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
+		data_size += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	tex->_data_size = layer_size * array_count;
+	tex->_data      = calloc(tex->_data_size > 0 ? tex->_data_size : 1, 1);
+	for (int32_t a = 0; array_data != nullptr && a < array_count; a++) {
+		if (array_data[a] == nullptr) continue;
+		memcpy((uint8_t*)tex->_data + layer_size * a, array_data[a], data_size);
+		null_calls.upload_bytes += data_size;
+		skg_stats_upload(data_size);
+	}
 
-	return err == 0;
+	null_live.tex_bytes   += tex->_data_size;
+	null_calls.tex_uploads += 1;
+	// Account for memory the way a GPU would store it, every sample of a
+	// multisample texture included.
+	skg_mem_track_tex(skg_mem_key(tex), tex, tex->_mip_count, tex->multisample);
 }
 
 ///////////////////////////////////////////
 
-void* skg_tex_get_native(const skg_tex_t* tex) {
-	return (void*)((uint64_t)tex->_texture);
+bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
-	if (bind.stage_bits & skg_stage_compute) {
-#if !defined(_SKG_GL_WEB)
-		glBindImageTexture(bind.slot, texture->_texture, 0, false, 0, texture->_access, (uint32_t)skg_tex_fmt_to_native( texture->format ));
-#endif
-	} else {
-		PIPELINE_CHECK(gl_pipeline.tex_bind[bind.slot], texture->_texture)
-		glActiveTexture(GL_TEXTURE0 + bind.slot);
-		glBindTexture(texture->_target, texture->_texture);
-		PIPELINE_CHECK_END
-	}
+bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_clear(skg_bind_t bind) {
+bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	// Textures wrapping an existing or parent resource have no CPU copy
+	if (tex->_data == nullptr || mip_level >= tex->_mip_count || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "This texture doesn't have quite as many mip levels or array slices as you think.");
+		return false;
+	}
+
+	int32_t width, height;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+	if (data_size != skg_tex_fmt_memory(tex->format, width, height)) {
+		skg_log(skg_log_critical, "Insufficient buffer size for skg_tex_get_mip_contents_arr");
+		return false;
+	}
+
+	memcpy(ref_data, (uint8_t*)tex->_data + null_tex_mip_offset(tex, mip_level, arr_index), data_size);
+	return true;
 }
 
 ///////////////////////////////////////////
 
-void skg_tex_destroy(skg_tex_t *tex) {
-	// Make sure it's not bound or cached in our pipeline state
-	if (tex->_target) {
-		int32_t slot_count = sizeof(gl_pipeline.tex_bind) / sizeof(gl_pipeline.tex_bind[0]);
-		for (int32_t i = 0; i < slot_count; i++) {
-			if (gl_pipeline.tex_bind[i] != tex->_texture) continue;
-
-			glActiveTexture(GL_TEXTURE0 + i);
-			glBindTexture  (tex->_target, 0);
-			gl_pipeline.tex_bind[i] = 0;
-		}
-	}
-	
-	uint32_t tex_list[] = { tex->_texture };
-	if (tex->_texture ) glDeleteTextures (1, tex_list);
-	if (tex->_framebuffer_layers) {
-		glDeleteFramebuffers(tex->array_count, tex->_framebuffer_layers);
-		free(tex->_framebuffer_layers);
+bool skg_tex_read_async(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	if (tex->_data == nullptr || mip_level >= tex->_mip_count || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "skg_tex_read_async: this texture doesn't have the mip level or array slice you asked for.");
+		return false;
 	}
-	*tex = {};
+
+	int32_t width, height;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+	size_t size = skg_tex_fmt_memory(tex->format, width, height);
+	if (ref_readback->size != size) {
+		free(ref_readback->_data);
+		ref_readback->_data = malloc(size);
+		ref_readback->size  = size;
+	}
+	ref_readback->width  = width;
+	ref_readback->height = height;
+	ref_readback->format = tex->format;
+
+	// There's no GPU to wait on, so the copy is ready right away.
+	memcpy(ref_readback->_data, (uint8_t*)tex->_data + null_tex_mip_offset(tex, mip_level, arr_index), size);
+	return true;
 }
 
 ///////////////////////////////////////////
 
-uint32_t skg_buffer_type_to_gl(skg_buffer_type_ type) {
-	switch (type) {
-	case skg_buffer_type_vertex:   return GL_ARRAY_BUFFER;
-	case skg_buffer_type_index:    return GL_ELEMENT_ARRAY_BUFFER;
-	case skg_buffer_type_constant: return GL_UNIFORM_BUFFER;
-	case skg_buffer_type_compute:  return GL_SHADER_STORAGE_BUFFER;
-	default: return 0;
-	}
+bool skg_readback_poll(skg_readback_t *readback) {
+	return readback->_data != nullptr;
 }
 
 ///////////////////////////////////////////
 
-int64_t skg_tex_fmt_to_native(skg_tex_fmt_ format) {
-	switch (format) {
-	case skg_tex_fmt_rgba32:        return GL_SRGB8_ALPHA8;
-	case skg_tex_fmt_rgba32_linear: return GL_RGBA8;
-	case skg_tex_fmt_bgra32:        return GL_RGBA8;
-	case skg_tex_fmt_bgra32_linear: return GL_RGBA8;
-	case skg_tex_fmt_rg11b10:       return GL_R11F_G11F_B10F;
-	case skg_tex_fmt_rgb10a2:       return GL_RGB10_A2;
-	case skg_tex_fmt_rgba64u:       return GL_RGBA16;
-	case skg_tex_fmt_rgba64s:       return GL_RGBA16_SNORM;
-	case skg_tex_fmt_rgba64f:       return GL_RGBA16F;
-	case skg_tex_fmt_rgba128:       return GL_RGBA32F;
-	case skg_tex_fmt_depth16:       return GL_DEPTH_COMPONENT16;
-	case skg_tex_fmt_depth32:       return GL_DEPTH_COMPONENT32F;
-	case skg_tex_fmt_depthstencil:  return GL_DEPTH24_STENCIL8;
-	case skg_tex_fmt_r8:            return GL_R8;
-	case skg_tex_fmt_r16u:          return GL_R16;
-	case skg_tex_fmt_r16s:          return GL_R16_SNORM;
-	case skg_tex_fmt_r16f:          return GL_R16F;
-	case skg_tex_fmt_r32:           return GL_R32F;
-	case skg_tex_fmt_r8g8:          return GL_RG8;
+const void *skg_readback_map(skg_readback_t *readback, size_t *out_size) {
+	if (out_size) *out_size = readback->size;
+	return readback->_data;
+}
 
-	case skg_tex_fmt_etc1_rgb:          return GL_ETC1_RGB8_OES;
-	case skg_tex_fmt_etc2_rgba:         return GL_COMPRESSED_RGBA8_ETC2_EAC;
-	case skg_tex_fmt_etc2_rgba_srgb:    return GL_COMPRESSED_SRGB8_ETC2;
-	case skg_tex_fmt_etc2_r11:          return GL_COMPRESSED_R11_EAC;
-	case skg_tex_fmt_etc2_rg11:         return GL_COMPRESSED_RG11_EAC;
+///////////////////////////////////////////
 
-	// These extensions are only available on real GLES
-	case skg_tex_fmt_pvrtc1_rgb:        return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG        : 0;
-	case skg_tex_fmt_pvrtc1_rgb_srgb:   return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_SRGB_PVRTC_4BPPV1_EXT       : 0;
-	case skg_tex_fmt_pvrtc1_rgba:       return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG       : 0;
-	case skg_tex_fmt_pvrtc1_rgba_srgb:  return gl_caps[skg_cap_fmt_pvrtc1] ? GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV1_EXT : 0;
-	case skg_tex_fmt_pvrtc2_rgba:       return gl_caps[skg_cap_fmt_pvrtc2] ? GL_COMPRESSED_RGBA_PVRTC_4BPPV2_IMG       : 0;
-	case skg_tex_fmt_pvrtc2_rgba_srgb:  return gl_caps[skg_cap_fmt_pvrtc2] ? GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV2_IMG : 0;
-	case skg_tex_fmt_astc4x4_rgba:      return gl_caps[skg_cap_fmt_astc  ] ? GL_COMPRESSED_RGBA_ASTC_4x4_KHR           : 0;
-	case skg_tex_fmt_astc4x4_rgba_srgb: return gl_caps[skg_cap_fmt_astc  ] ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR   : 0;
-	case skg_tex_fmt_atc_rgb:           return gl_caps[skg_cap_fmt_atc   ] ? GL_ATC_RGB_AMD                            : 0;
-	case skg_tex_fmt_atc_rgba:          return gl_caps[skg_cap_fmt_atc   ] ? GL_ATC_RGBA_EXPLICIT_ALPHA_AMD            : 0;
+void skg_readback_destroy(skg_readback_t *readback) {
+	free(readback->_data);
+	*readback = {};
+}
 
-	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
-	case skg_tex_fmt_bc1_rgb_srgb:      return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
-	case skg_tex_fmt_bc1_rgb:           return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
-	case skg_tex_fmt_bc3_rgba_srgb:     return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
-	case skg_tex_fmt_bc3_rgba:          return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
-	case skg_tex_fmt_bc5_rg:            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
-	default: return 0;
-	}
+///////////////////////////////////////////
+
+bool skg_tex_gen_mips(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_gen_mips, skg_capture_id(tex)));
+	return true;
 }
 
 ///////////////////////////////////////////
 
-skg_tex_fmt_ skg_tex_fmt_from_native(int64_t format) {
-	switch (format) {
-	case GL_SRGB8_ALPHA8:       return skg_tex_fmt_rgba32;
-	case GL_RGBA8:              return skg_tex_fmt_rgba32_linear;
-	case GL_R11F_G11F_B10F:     return skg_tex_fmt_rg11b10;
-	case GL_RGB10_A2:           return skg_tex_fmt_rgb10a2;
-	case GL_RGBA16:             return skg_tex_fmt_rgba64u;
-	case GL_RGBA16_SNORM:       return skg_tex_fmt_rgba64s;
-	case GL_RGBA16F:            return skg_tex_fmt_rgba64f;
-	case GL_RGBA32F:            return skg_tex_fmt_rgba128;
-	case GL_DEPTH_COMPONENT16:  return skg_tex_fmt_depth16;
-	case GL_DEPTH_COMPONENT32F: return skg_tex_fmt_depth32;
-	case GL_DEPTH24_STENCIL8:   return skg_tex_fmt_depthstencil;
-	case GL_R8:                 return skg_tex_fmt_r8;
-	case GL_R16:                return skg_tex_fmt_r16u;
-	case GL_R16F:               return skg_tex_fmt_r16f;
-	case GL_R16_SNORM:          return skg_tex_fmt_r16s;
-	case GL_R32F:               return skg_tex_fmt_r32;
-	case GL_RG8:                return skg_tex_fmt_r8g8;
+void* skg_tex_get_native(const skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	return (void*)(uint64_t)tex->_id;
+}
 
-	case GL_ETC1_RGB8_OES:                         return skg_tex_fmt_etc1_rgb;
-	case GL_COMPRESSED_RGBA8_ETC2_EAC:             return skg_tex_fmt_etc2_rgba;
-	case GL_COMPRESSED_SRGB8_ETC2:                 return skg_tex_fmt_etc2_rgba_srgb;
-	case GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG:       return skg_tex_fmt_pvrtc1_rgb;
-	case GL_COMPRESSED_SRGB_PVRTC_4BPPV1_EXT:      return skg_tex_fmt_pvrtc1_rgb_srgb;
-	case GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG:      return skg_tex_fmt_pvrtc1_rgba;
-	case GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV1_EXT:return skg_tex_fmt_pvrtc1_rgba_srgb;
-	case GL_COMPRESSED_RGBA_PVRTC_4BPPV2_IMG:      return skg_tex_fmt_pvrtc2_rgba;
-	case GL_COMPRESSED_SRGB_ALPHA_PVRTC_4BPPV2_IMG:return skg_tex_fmt_pvrtc2_rgba_srgb;
-	case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:          return skg_tex_fmt_astc4x4_rgba;
-	case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR:  return skg_tex_fmt_astc4x4_rgba_srgb;
-	case GL_ATC_RGB_AMD:                           return skg_tex_fmt_atc_rgb;
+///////////////////////////////////////////
 
-	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:       return skg_tex_fmt_bc1_rgb_srgb;
-	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:        return skg_tex_fmt_bc1_rgb;
-	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT: return skg_tex_fmt_bc3_rgba_srgb;
-	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:       return skg_tex_fmt_bc3_rgba;
-	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:       return skg_tex_fmt_bc5_rg;
+void skg_tex_bind(const skg_tex_t *tex, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_bind, skg_capture_id(tex), bind));
+	SKG_STAT_MISS(skg_stat_texture);
+	null_calls.tex_binds += 1;
+}
 
-	default: return skg_tex_fmt_none;
-	}
+///////////////////////////////////////////
+
+void skg_tex_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_clear, 0, bind));
 }
 
 ///////////////////////////////////////////
 
-uint32_t skg_tex_fmt_to_gl_layout(skg_tex_fmt_ format) {
-	switch (format) {
-	case skg_tex_fmt_rgba32:
-	case skg_tex_fmt_rgba32_linear:
-	case skg_tex_fmt_rgb10a2:
-	case skg_tex_fmt_rgba64u:
-	case skg_tex_fmt_rgba64s:
-	case skg_tex_fmt_rgba64f:
-	case skg_tex_fmt_rgba128:
-	case skg_tex_fmt_atc_rgba:
-	case skg_tex_fmt_pvrtc1_rgba:
-	case skg_tex_fmt_pvrtc1_rgba_srgb:
-	case skg_tex_fmt_pvrtc2_rgba:
-	case skg_tex_fmt_pvrtc2_rgba_srgb:
-	case skg_tex_fmt_astc4x4_rgba:
-	case skg_tex_fmt_astc4x4_rgba_srgb:
-	case skg_tex_fmt_bc3_rgba_srgb:
-	case skg_tex_fmt_bc3_rgba:
-	case skg_tex_fmt_etc2_rgba_srgb:
-	case skg_tex_fmt_etc2_rgba:     return GL_RGBA;
-	case skg_tex_fmt_etc1_rgb:
-	case skg_tex_fmt_atc_rgb:
-	case skg_tex_fmt_pvrtc1_rgb:
-	case skg_tex_fmt_pvrtc1_rgb_srgb:
-	case skg_tex_fmt_bc1_rgb_srgb:
-	case skg_tex_fmt_bc1_rgb:
-	case skg_tex_fmt_rg11b10:       return GL_RGB;
-	case skg_tex_fmt_bgra32:
-	case skg_tex_fmt_bgra32_linear:
-		#ifdef _SKG_GL_WEB // WebGL has no GL_BGRA?
-		return GL_RGBA;
-		#else
-		return GL_BGRA;
-		#endif
-	case skg_tex_fmt_depth16:
-	case skg_tex_fmt_depth32:       return GL_DEPTH_COMPONENT;
-	case skg_tex_fmt_depthstencil:  return GL_DEPTH_STENCIL;
-	case skg_tex_fmt_r8:
-	case skg_tex_fmt_r16u:
-	case skg_tex_fmt_r16s:
-	case skg_tex_fmt_r16f:
-	case skg_tex_fmt_r32:
-	case skg_tex_fmt_etc2_r11:      return GL_RED;
-	case skg_tex_fmt_bc5_rg:
-	case skg_tex_fmt_etc2_rg11:
-	case skg_tex_fmt_r8g8:          return GL_RG;
-	default: return 0;
-	}
+void skg_tex_target_discard(skg_tex_t *render_target) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_target_discard, skg_capture_id(render_target)));
 }
 
 ///////////////////////////////////////////
 
-uint32_t skg_tex_fmt_to_gl_type(skg_tex_fmt_ format) {
-	switch (format) {
-	case skg_tex_fmt_rgba32:        return GL_UNSIGNED_BYTE;
-	case skg_tex_fmt_rgba32_linear: return GL_UNSIGNED_BYTE;
-	case skg_tex_fmt_bgra32:        return GL_UNSIGNED_BYTE;
-	case skg_tex_fmt_bgra32_linear: return GL_UNSIGNED_BYTE;
-	case skg_tex_fmt_r8g8:          return GL_UNSIGNED_BYTE;
-	case skg_tex_fmt_r8:            return GL_UNSIGNED_BYTE;
-	case skg_tex_fmt_rgba64u:       return GL_UNSIGNED_SHORT;
-	case skg_tex_fmt_depth16:       return GL_UNSIGNED_SHORT;
-	case skg_tex_fmt_r16u:          return GL_UNSIGNED_SHORT;
-	case skg_tex_fmt_r16s:          return GL_SHORT;
-	case skg_tex_fmt_rgba64s:       return GL_SHORT;
-	case skg_tex_fmt_rgb10a2:       return GL_UNSIGNED_INT_2_10_10_10_REV;
-	case skg_tex_fmt_rg11b10:       return GL_UNSIGNED_INT_10F_11F_11F_REV;
-	case skg_tex_fmt_rgba128:       return GL_FLOAT;
-	case skg_tex_fmt_depth32:       return GL_FLOAT;
-	case skg_tex_fmt_r32:           return GL_FLOAT;
-	case skg_tex_fmt_rgba64f:       return GL_HALF_FLOAT;
-	case skg_tex_fmt_r16f:          return GL_HALF_FLOAT;
-	case skg_tex_fmt_depthstencil:  return GL_UNSIGNED_INT_24_8;
-	default: return 0;
+void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_target_bind(render_target ? skg_capture_id(render_target) : 0, layer_idx, mip_level));
+	null_active_rendertarget = render_target;
+	null_calls.target_binds += 1;
+	if (render_target) {
+		int32_t viewport[4] = { 0, 0, render_target->width, render_target->height };
+		skg_viewport(viewport);
 	}
 }
 
 ///////////////////////////////////////////
 
-bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
-	return gl_tex_fmt_supported[format];
+skg_tex_t *skg_tex_target_get() {
+	return null_active_rendertarget;
 }
 
-#endif
-#ifdef SKG_NULL
-///////////////////////////////////////////
-// Null Implementation                   //
 ///////////////////////////////////////////
 
-skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
-	skg_shader_stage_t result = {};
-	result.type = type;
+void skg_tex_destroy(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_destroy, skg_capture_id(tex)));
+	if (null_active_rendertarget == tex) null_active_rendertarget = nullptr;
+	if (tex->_id != 0) {
+		null_live.textures  -= 1;
+		null_live.tex_bytes -= tex->_data_size;
+		skg_mem_release(skg_mem_key(tex));
+	}
+	free(tex->_data);
+	*tex = {};
+}
 
-	return result;
+///////////////////////////////////////////
+
+int64_t skg_tex_fmt_to_native(skg_tex_fmt_ format) {
+	return (int64_t)format;
 }
 
 ///////////////////////////////////////////
 
-void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+skg_tex_fmt_ skg_tex_fmt_from_native(int64_t format) {
+	return format > skg_tex_fmt_none && format < skg_tex_fmt_max
+		? (skg_tex_fmt_)format
+		: skg_tex_fmt_none;
 }
 
 ///////////////////////////////////////////
 
-skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
-	skg_shader_t result = {};
-	result.meta = meta;
-	skg_shader_meta_reference(result.meta);
-	return result;
+bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
+	return format > skg_tex_fmt_none && format < skg_tex_fmt_max;
 }
 
+///////////////////////////////////////////
+
+uint64_t skg_mem_key(const skg_buffer_t *buffer) { return buffer->_id; }
+uint64_t skg_mem_key(const skg_tex_t    *tex   ) { return tex   ->_id; }
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+uint64_t skg_capture_id(const skg_buffer_t *buffer) { return buffer->_id; }
+uint64_t skg_capture_id(const skg_shader_t *shader) { return shader->_id; }
+uint64_t skg_capture_id(const skg_tex_t    *tex   ) { return tex   ->_id; }
+#endif
+
 #endif
+
 ///////////////////////////////////////////
 // Common Code                           //
 ///////////////////////////////////////////
@@ -6133,13 +11284,489 @@ void skg_logf (skg_log_ level, const char *text, ...) {
 
 	 _skg_log(level, buffer);
 
-	free(buffer);
-	va_end(args);
-	va_end(copy);
+	free(buffer);
+	va_end(args);
+	va_end(copy);
+}
+void skg_log_enable(bool enabled) {
+	_skg_log_disabled = !enabled;
+}
+
+///////////////////////////////////////////
+
+#include <atomic>
+
+skg_stats_t _skg_stats = {};
+// Upload threads create resources too, so this one counter is shared
+std::atomic<int64_t> _skg_stats_upload_bytes = { 0 };
+
+skg_stats_t skg_stats_get() {
+	skg_stats_t result = _skg_stats;
+	result.upload_bytes = _skg_stats_upload_bytes.load(std::memory_order_relaxed);
+	return result;
+}
+void skg_stats_reset() {
+	_skg_stats = {};
+	_skg_stats_upload_bytes.store(0, std::memory_order_relaxed);
+}
+void skg_stats_upload(int64_t bytes) {
+	_skg_stats_upload_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////
+
+#include <mutex>
+#include <unordered_map>
+
+typedef struct skg_mem_entry_t {
+	int64_t bytes[skg_mem_max];
+	char    name [32];
+} skg_mem_entry_t;
+
+skg_mem_stats_t                               _skg_mem = {};
+std::unordered_map<uint64_t, skg_mem_entry_t> _skg_mem_entries;
+std::mutex                                    _skg_mem_mtx;
+
+///////////////////////////////////////////
+
+void skg_mem_set(skg_mem_entry_t *entry, skg_mem_ type, int64_t bytes) {
+	int64_t delta = bytes - entry->bytes[type];
+	if (delta == 0) return;
+
+	if      (entry->bytes[type] == 0) _skg_mem.allocations[type] += 1;
+	else if (bytes              == 0) _skg_mem.allocations[type] -= 1;
+	entry->bytes[type]    = bytes;
+	_skg_mem.bytes[type] += delta;
+	_skg_mem.total_bytes += delta;
+	if (_skg_mem.bytes[type] > _skg_mem.peak_bytes[type]) _skg_mem.peak_bytes[type] = _skg_mem.bytes[type];
+	if (_skg_mem.total_bytes > _skg_mem.total_peak_bytes) _skg_mem.total_peak_bytes = _skg_mem.total_bytes;
+}
+
+///////////////////////////////////////////
+
+void skg_mem_track(uint64_t key, skg_mem_ type, int64_t bytes) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	if (bytes == 0) {
+		auto entry = _skg_mem_entries.find(key);
+		if (entry != _skg_mem_entries.end())
+			skg_mem_set(&entry->second, type, 0);
+	} else {
+		skg_mem_set(&_skg_mem_entries[key], type, bytes);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_mem_track_tex(uint64_t key, const skg_tex_t *tex, int32_t mip_count, int32_t physical_multisample) {
+	int64_t layer_bytes = 0;
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(tex->width, tex->height, m, &mip_width, &mip_height);
+		layer_bytes += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	int64_t  tex_bytes = layer_bytes * tex->array_count;
+	skg_mem_ type      = skg_mem_tex_image;
+	if      (tex->type == skg_tex_type_rendertarget) type = skg_mem_tex_rendertarget;
+	else if (tex->type != skg_tex_type_image)        type = skg_mem_tex_depth;
+
+	// Multisample textures keep every sample, while tiled MSAA renders into
+	// a multisample surface the driver allocates alongside each framebuffer
+	// layer, and resolves into a single sample texture.
+	int64_t fb_bytes = tex->multisample > physical_multisample
+		? (int64_t)skg_tex_fmt_memory(tex->format, tex->width, tex->height) * tex->multisample * tex->array_count
+		: 0;
+	skg_mem_track(key, type,                physical_multisample > 1 ? 0 : tex_bytes);
+	skg_mem_track(key, skg_mem_msaa,        physical_multisample > 1 ? tex_bytes * physical_multisample : 0);
+	skg_mem_track(key, skg_mem_framebuffer, fb_bytes);
+}
+
+///////////////////////////////////////////
+
+void skg_mem_release(uint64_t key) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	auto entry = _skg_mem_entries.find(key);
+	if (entry == _skg_mem_entries.end()) return;
+
+	for (int32_t i = 0; i < skg_mem_max; i++)
+		skg_mem_set(&entry->second, (skg_mem_)i, 0);
+	_skg_mem_entries.erase(entry);
+}
+
+///////////////////////////////////////////
+
+void skg_mem_add(uint64_t key) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	_skg_mem_entries[key];
+}
+
+///////////////////////////////////////////
+
+void skg_mem_name(uint64_t key, const char *name) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	auto entry = _skg_mem_entries.find(key);
+	if (entry == _skg_mem_entries.end()) return;
+	snprintf(entry->second.name, sizeof(entry->second.name), "%s", name);
+}
+
+///////////////////////////////////////////
+
+skg_mem_stats_t skg_mem_get() {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	return _skg_mem;
+}
+
+///////////////////////////////////////////
+
+void skg_mem_reset_peaks() {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	memcpy(_skg_mem.peak_bytes, _skg_mem.bytes, sizeof(_skg_mem.bytes));
+	_skg_mem.total_peak_bytes = _skg_mem.total_bytes;
+}
+
+///////////////////////////////////////////
+
+int32_t skg_mem_get_allocations(skg_mem_allocation_t *out_allocations, int32_t max_allocations) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	int32_t total = 0;
+	for (int32_t i = 0; i < skg_mem_max; i++) total += _skg_mem.allocations[i];
+	if (out_allocations == nullptr) return total;
+	if (max_allocations <= 0 || total == 0) return 0;
+
+	skg_mem_allocation_t *list  = (skg_mem_allocation_t*)malloc(sizeof(skg_mem_allocation_t) * total);
+	int32_t               count = 0;
+	for (auto &entry : _skg_mem_entries) {
+		for (int32_t i = 0; i < skg_mem_max; i++) {
+			if (entry.second.bytes[i] == 0 || count >= total) continue;
+			skg_mem_allocation_t *item = &list[count++];
+			memcpy(item->name, entry.second.name, sizeof(item->name));
+			item->type  = (skg_mem_)i;
+			item->bytes = entry.second.bytes[i];
+		}
+	}
+	qsort(list, count, sizeof(skg_mem_allocation_t), [](const void *a, const void *b) {
+		int64_t a_bytes = ((const skg_mem_allocation_t*)a)->bytes;
+		int64_t b_bytes = ((const skg_mem_allocation_t*)b)->bytes;
+		return a_bytes < b_bytes ? 1 : (a_bytes > b_bytes ? -1 : 0);
+	});
+
+	if (count > max_allocations) count = max_allocations;
+	memcpy(out_allocations, list, sizeof(skg_mem_allocation_t) * count);
+	free(list);
+	return count;
+}
+
+///////////////////////////////////////////
+
+#if defined(SKG_TRACE)
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+typedef struct skg_trace_event_t {
+	const char *name;
+	char        detail[64];
+	int64_t     start_ns;
+	int64_t     end_ns;
+	uint32_t    thread;
+} skg_trace_event_t;
+
+bool                  _skg_trace_active = false;
+char                 *_skg_trace_file   = nullptr;
+int64_t               _skg_trace_epoch  = 0;
+skg_trace_event_t    *_skg_trace_events = nullptr;
+size_t                _skg_trace_count  = 0;
+size_t                _skg_trace_cap    = 0;
+std::mutex            _skg_trace_mtx;
+std::atomic<uint32_t> _skg_trace_next_thread(1);
+thread_local uint32_t _skg_trace_thread = 0;
+
+int64_t skg_trace_now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void skg_trace_record(const char *name, const char *detail, int64_t start_ns, int64_t end_ns) {
+	if (_skg_trace_thread == 0) _skg_trace_thread = _skg_trace_next_thread++;
+
+	std::lock_guard<std::mutex> lock(_skg_trace_mtx);
+	if (!_skg_trace_active) return;
+	if (_skg_trace_count >= _skg_trace_cap) {
+		size_t             new_cap    = _skg_trace_cap == 0 ? 4096 : _skg_trace_cap * 2;
+		skg_trace_event_t *new_events = (skg_trace_event_t*)realloc(_skg_trace_events, sizeof(skg_trace_event_t) * new_cap);
+		if (new_events == nullptr) return;
+		_skg_trace_events = new_events;
+		_skg_trace_cap    = new_cap;
+	}
+	skg_trace_event_t *evt = &_skg_trace_events[_skg_trace_count++];
+	evt->name     = name;
+	evt->start_ns = start_ns;
+	evt->end_ns   = end_ns;
+	evt->thread   = _skg_trace_thread;
+	snprintf(evt->detail, sizeof(evt->detail), "%s", detail ? detail : "");
+}
+
+bool skg_trace_start(const char *filename) {
+	std::lock_guard<std::mutex> lock(_skg_trace_mtx);
+	if (_skg_trace_active) {
+		skg_log(skg_log_warning, "skg_trace_start called while a trace is already running");
+		return false;
+	}
+	size_t len = strlen(filename) + 1;
+	_skg_trace_file   = (char*)malloc(len);
+	memcpy(_skg_trace_file, filename, len);
+	_skg_trace_count  = 0;
+	_skg_trace_epoch  = skg_trace_now();
+	_skg_trace_active = true;
+	return true;
+}
+
+void skg_trace_stop() {
+	std::lock_guard<std::mutex> lock(_skg_trace_mtx);
+	if (!_skg_trace_active) return;
+	_skg_trace_active = false;
+
+	FILE *fp = fopen(_skg_trace_file, "w");
+	if (fp == nullptr) {
+		skg_logf(skg_log_warning, "Couldn't open trace file %s", _skg_trace_file);
+	} else {
+		fprintf(fp, "{\"traceEvents\":[\n");
+		for (size_t i = 0; i < _skg_trace_count; i++) {
+			const skg_trace_event_t *evt = &_skg_trace_events[i];
+			fprintf(fp, "{\"name\":\"%s\",\"cat\":\"skg\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+				evt->name, evt->thread, (evt->start_ns - _skg_trace_epoch) / 1000.0, (evt->end_ns - evt->start_ns) / 1000.0);
+			if (evt->detail[0] != '\0') {
+				fprintf(fp, ",\"args\":{\"detail\":\"");
+				for (const char *ch = evt->detail; *ch; ch++) {
+					if      (*ch == '"' || *ch == '\\') fprintf(fp, "\\%c", *ch);
+					else if ((uint8_t)*ch < 0x20)        fprintf(fp, "\\u%04x", *ch);
+					else                                 fputc(*ch, fp);
+				}
+				fprintf(fp, "\"}");
+			}
+			fprintf(fp, "}%s\n", i + 1 < _skg_trace_count ? "," : "");
+		}
+		fprintf(fp, "],\"displayTimeUnit\":\"ns\"}\n");
+		fclose(fp);
+	}
+
+	free(_skg_trace_file);
+	free(_skg_trace_events);
+	_skg_trace_file   = nullptr;
+	_skg_trace_events = nullptr;
+	_skg_trace_count  = 0;
+	_skg_trace_cap    = 0;
+}
+#else
+bool skg_trace_start(const char *filename) {
+	skg_log(skg_log_warning, "skg_trace_start requires sk_gpu to be built with SKG_TRACE defined");
+	return false;
+}
+void skg_trace_stop() {
+}
+#endif
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+#include <mutex>
+
+bool       _skg_capture_active = false;
+FILE      *_skg_capture_fp     = nullptr;
+std::mutex _skg_capture_mtx;
+
+void skg_capture_write(skg_capture_op_ op, const void *payload, size_t payload_size, const void *data = nullptr, size_t data_size = 0) {
+	std::lock_guard<std::mutex> lock(_skg_capture_mtx);
+	if (!_skg_capture_active) return;
+
+	skg_capture_record_t record = { (uint32_t)op, (uint32_t)(payload_size + data_size) };
+	fwrite(&record, sizeof(record), 1, _skg_capture_fp);
+	if (payload_size > 0) fwrite(payload, payload_size, 1, _skg_capture_fp);
+	if (data_size    > 0) fwrite(data,    data_size,    1, _skg_capture_fp);
+}
+
+bool skg_capture_start(const char *filename) {
+	std::lock_guard<std::mutex> lock(_skg_capture_mtx);
+	if (_skg_capture_active) {
+		skg_log(skg_log_warning, "skg_capture_start called while a capture is already running");
+		return false;
+	}
+	_skg_capture_fp = fopen(filename, "wb");
+	if (_skg_capture_fp == nullptr) {
+		skg_logf(skg_log_warning, "Couldn't open capture file %s", filename);
+		return false;
+	}
+	skg_capture_header_t header = { SKG_CAPTURE_MAGIC, SKG_CAPTURE_VERSION };
+	fwrite(&header, sizeof(header), 1, _skg_capture_fp);
+	_skg_capture_active = true;
+	return true;
+}
+
+void skg_capture_stop() {
+	std::lock_guard<std::mutex> lock(_skg_capture_mtx);
+	if (!_skg_capture_active) return;
+	_skg_capture_active = false;
+	fclose(_skg_capture_fp);
+	_skg_capture_fp = nullptr;
+}
+
+///////////////////////////////////////////
+
+void skg_capture_frame() {
+	skg_capture_write(skg_capture_op_frame, nullptr, 0);
+}
+void skg_capture_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	skg_capture_draw_t draw = { index_start, index_base, index_count, instance_count };
+	skg_capture_write(skg_capture_op_draw, &draw, sizeof(draw));
+}
+void skg_capture_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	skg_capture_draw_indirect_t draw = { skg_capture_id(args_buffer), offset, draw_count, stride, 0 };
+	skg_capture_write(skg_capture_op_draw_indirect, &draw, sizeof(draw));
+}
+void skg_capture_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	skg_capture_draw_multi_t draw = { draw_count };
+	skg_capture_write(skg_capture_op_draw_multi, &draw, sizeof(draw), draws, sizeof(skg_draw_args_t) * draw_count);
+}
+void skg_capture_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	skg_capture_compute_t compute = { { thread_count_x, thread_count_y, thread_count_z } };
+	skg_capture_write(skg_capture_op_compute, &compute, sizeof(compute));
+}
+void skg_capture_rect(skg_capture_op_ op, const int32_t *xywh) {
+	skg_capture_rect_t rect = { { xywh[0], xywh[1], xywh[2], xywh[3] } };
+	skg_capture_write(op, &rect, sizeof(rect));
+}
+void skg_capture_target_clear(bool depth, const float *clear_color_4) {
+	skg_capture_clear_t clear = {};
+	clear.depth     = depth;
+	clear.has_color = clear_color_4 != nullptr;
+	if (clear_color_4) memcpy(clear.color, clear_color_4, sizeof(clear.color));
+	skg_capture_write(skg_capture_op_target_clear, &clear, sizeof(clear));
+}
+void skg_capture_event_begin(const char *name) {
+	skg_capture_write(skg_capture_op_event_begin, nullptr, 0, name, strlen(name));
+}
+void skg_capture_event_end() {
+	skg_capture_write(skg_capture_op_event_end, nullptr, 0);
+}
+
+///////////////////////////////////////////
+
+void skg_capture_buffer_create(const skg_buffer_t *buffer, const void *data, uint32_t size_count, uint32_t size_stride) {
+	skg_capture_buffer_t create = {};
+	create.id          = skg_capture_id(buffer);
+	create.size_count  = size_count;
+	create.size_stride = size_stride;
+	create.type        = buffer->type;
+	create.use         = buffer->use;
+	create.has_data    = data != nullptr;
+	skg_capture_write(skg_capture_op_buffer_create, &create, sizeof(create), data, data ? (size_t)size_count * size_stride : 0);
+}
+void skg_capture_buffer_set_contents(const skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	skg_capture_id_t id = { skg_capture_id(buffer) };
+	skg_capture_write(skg_capture_op_buffer_set_contents, &id, sizeof(id), data, data ? size_bytes : 0);
+}
+void skg_capture_buffer_set_range(const skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	skg_capture_buffer_range_t range = { skg_capture_id(buffer), offset, size_bytes };
+	skg_capture_write(skg_capture_op_buffer_set_range, &range, sizeof(range), data, size_bytes);
+}
+void skg_capture_bind(skg_capture_op_ op, uint64_t id, skg_bind_t bind) {
+	skg_capture_bind_t capture = { id, bind.slot, bind.stage_bits, bind.register_type, 0 };
+	skg_capture_write(op, &capture, sizeof(capture));
+}
+void skg_capture_bind_range(skg_capture_op_ op, uint64_t id, skg_bind_t bind, uint32_t offset, uint32_t size, const void *data) {
+	skg_capture_bind_range_t capture = { id, bind.slot, bind.stage_bits, bind.register_type, offset, size, 0 };
+	skg_capture_write(op, &capture, sizeof(capture), data, data ? size : 0);
+}
+void skg_capture_mesh_bind(uint64_t vert_id, uint64_t ind_id, int32_t vert_fmt) {
+	skg_capture_mesh_t    mesh = { vert_id, ind_id };
+	const skg_vert_fmt_t *fmt  = skg_vert_fmt_get(vert_fmt);
+	if (vert_fmt > 0) skg_capture_write(skg_capture_op_mesh_bind, &mesh, sizeof(mesh), fmt->components, sizeof(skg_vert_component_t) * fmt->component_count);
+	else              skg_capture_write(skg_capture_op_mesh_bind, &mesh, sizeof(mesh));
+}
+void skg_capture_shader_create(const skg_shader_t *shader, const void *sks_data, size_t sks_data_size) {
+	skg_capture_id_t id = { skg_capture_id(shader) };
+	skg_capture_write(skg_capture_op_shader_create, &id, sizeof(id), sks_data, sks_data_size);
+}
+void skg_capture_pipeline_bind(const skg_pipeline_t *pipeline, uint64_t shader_id) {
+	skg_capture_pipeline_t capture = {};
+	capture.shader_id    = shader_id;
+	capture.transparency = pipeline->transparency;
+	capture.cull         = pipeline->cull;
+	capture.color_write  = pipeline->color_write;
+	capture.depth_test   = pipeline->depth_test;
+	capture.wireframe    = pipeline->wireframe;
+	capture.depth_write  = pipeline->depth_write;
+	capture.depth_clip   = pipeline->depth_clip;
+	capture.scissor      = pipeline->scissor;
+	skg_capture_write(skg_capture_op_pipeline_bind, &capture, sizeof(capture));
+}
+
+///////////////////////////////////////////
+
+void skg_capture_tex_create(skg_capture_op_ op, const skg_tex_t *tex) {
+	skg_capture_tex_t create = {};
+	create.id          = skg_capture_id(tex);
+	create.type        = tex->type;
+	create.use         = tex->use;
+	create.format      = tex->format;
+	create.mips        = tex->mips;
+	create.width       = tex->width;
+	create.height      = tex->height;
+	create.array_count = tex->array_count;
+	create.multisample = tex->multisample;
+	skg_capture_write(op, &create, sizeof(create));
+}
+void skg_capture_tex_settings(const skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	skg_capture_tex_settings_t settings = { skg_capture_id(tex), address, sample, compare, anisotropy };
+	skg_capture_write(skg_capture_op_tex_settings, &settings, sizeof(settings));
+}
+void skg_capture_tex_set_contents(const skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
+	skg_capture_tex_contents_t contents = {};
+	contents.id          = skg_capture_id(tex);
+	contents.array_count = array_count;
+	contents.mip_count   = mip_count;
+	contents.width       = width;
+	contents.height      = height;
+	contents.multisample = multisample;
+	contents.has_data    = array_data != nullptr;
+	if (array_data == nullptr) {
+		skg_capture_write(skg_capture_op_tex_set_contents, &contents, sizeof(contents));
+		return;
+	}
+
+	// Pack the arrays together so they can go out as a single record. Missing
+	// arrays are filled with zeros.
+	size_t array_size = 0;
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
+		array_size += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	uint8_t *data = (uint8_t*)calloc(array_count, array_size);
+	for (int32_t i = 0; i < array_count; i++) {
+		if (array_data[i]) memcpy(data + i * array_size, array_data[i], array_size);
+	}
+	skg_capture_write(skg_capture_op_tex_set_contents, &contents, sizeof(contents), data, array_count * array_size);
+	free(data);
 }
-void skg_log_enable(bool enabled) {
-	_skg_log_disabled = !enabled;
+void skg_capture_tex_pair(skg_capture_op_ op, uint64_t id, int32_t surface, uint64_t other_id, int32_t other_surface) {
+	skg_capture_tex_pair_t pair = { id, other_id, surface, other_surface };
+	skg_capture_write(op, &pair, sizeof(pair));
+}
+void skg_capture_tex_target_bind(uint64_t id, int32_t layer_idx, int32_t mip_level) {
+	skg_capture_target_t target = { id, layer_idx, mip_level };
+	skg_capture_write(skg_capture_op_tex_target_bind, &target, sizeof(target));
+}
+void skg_capture_id_op(skg_capture_op_ op, uint64_t id) {
+	skg_capture_id_t capture = { id };
+	skg_capture_write(op, &capture, sizeof(capture));
+}
+#else
+bool skg_capture_start(const char *filename) {
+	skg_log(skg_log_warning, "skg_capture_start requires sk_gpu to be built with SKG_CAPTURE defined");
+	return false;
 }
+void skg_capture_stop() {
+}
+#endif
 
 ///////////////////////////////////////////
 
@@ -6175,6 +11802,48 @@ bool skg_read_file(const char *filename, void **out_data, size_t *out_size) {
 
 ///////////////////////////////////////////
 
+bool (*_skg_write_file)(const char *filename, const void *data, size_t size);
+void skg_callback_file_write(bool (*callback)(const char *filename, const void *data, size_t size)) {
+	_skg_write_file = callback;
+}
+bool skg_write_file(const char *filename, const void *data, size_t size) {
+	if (_skg_write_file) return _skg_write_file(filename, data, size);
+	FILE *fp;
+#if _WIN32
+	if (fopen_s(&fp, filename, "wb") != 0 || fp == nullptr) {
+		return false;
+	}
+#else
+	fp = fopen(filename, "wb");
+	if (fp == nullptr) {
+		return false;
+	}
+#endif
+
+	bool result = fwrite(data, size, 1, fp) == 1;
+	fclose(fp);
+
+	return result;
+}
+
+///////////////////////////////////////////
+
+char *_skg_shader_cache_folder = nullptr;
+void skg_shader_cache_set_folder(const char *folder) {
+	free(_skg_shader_cache_folder);
+	_skg_shader_cache_folder = nullptr;
+	if (folder == nullptr) return;
+
+	size_t len = strlen(folder);
+	_skg_shader_cache_folder = (char*)malloc(len + 1);
+	memcpy(_skg_shader_cache_folder, folder, len + 1);
+}
+const char *skg_shader_cache_folder() {
+	return _skg_shader_cache_folder;
+}
+
+///////////////////////////////////////////
+
 uint64_t skg_hash(const char *string) {
 	uint64_t hash = 14695981039346656037UL;
 	while (*string != '\0') {
@@ -6572,6 +12241,7 @@ skg_color128_t skg_col_to_linear(skg_color128_t srgb) {
 ///////////////////////////////////////////
 
 bool skg_shader_file_load(const char *file, skg_shader_file_t *out_file) {
+	SKG_TRACE_FUNC();
 	void  *data = nullptr;
 	size_t size = 0;
 
@@ -6610,6 +12280,7 @@ bool skg_shader_file_verify(const void *data, size_t size, uint16_t *out_version
 ///////////////////////////////////////////
 
 bool skg_shader_file_load_memory(const void *data, size_t size, skg_shader_file_t *out_file) {
+	SKG_TRACE_FUNC();
 	uint16_t file_version = 0;
 	if (!skg_shader_file_verify(data, size, &file_version, nullptr, 0) || file_version != 3) {
 		return false;
@@ -6832,21 +12503,18 @@ void skg_shader_meta_release(skg_shader_meta_t *meta) {
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_file(const char *sks_filename) {
-	skg_shader_file_t file;
-	if (!skg_shader_file_load(sks_filename, &file)) {
+	SKG_TRACE_SCOPE_DETAIL(__func__, sks_filename);
+	void  *data = nullptr;
+	size_t size = 0;
+	if (!skg_read_file(sks_filename, &data, &size)) {
 		skg_shader_t empty = {};
 		return empty;
 	}
 
-	skg_shader_stage_t vs     = skg_shader_file_create_stage(&file, skg_stage_vertex);
-	skg_shader_stage_t ps     = skg_shader_file_create_stage(&file, skg_stage_pixel);
-	skg_shader_stage_t cs     = skg_shader_file_create_stage(&file, skg_stage_compute);
-	skg_shader_t       result = skg_shader_create_manual( file.meta, vs, ps, cs );
-
-	skg_shader_stage_destroy(&vs);
-	skg_shader_stage_destroy(&ps);
-	skg_shader_stage_destroy(&cs);
-	skg_shader_file_destroy (&file);
+	// Going through skg_shader_create_memory means captures get a copy of
+	// the file's data too.
+	skg_shader_t result = skg_shader_create_memory(data, size);
+	free(data);
 
 	return result;
 }
@@ -6854,6 +12522,7 @@ skg_shader_t skg_shader_create_file(const char *sks_filename) {
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_memory(const void *sks_data, size_t sks_data_size) {
+	SKG_TRACE_FUNC();
 	skg_shader_file_t file;
 	if (!skg_shader_file_load_memory(sks_data, sks_data_size, &file)) {
 		skg_shader_t empty = {};
@@ -6870,6 +12539,7 @@ skg_shader_t skg_shader_create_memory(const void *sks_data, size_t sks_data_size
 	skg_shader_stage_destroy(&cs);
 	skg_shader_file_destroy (&file);
 
+	SKG_CAPTURE_CALL(skg_capture_shader_create(&result, sks_data, sks_data_size));
 	return result;
 }
 
@@ -7022,6 +12692,649 @@ int32_t skg_fmt_size(skg_fmt_ format) {
 		default: return 0;
 	}
 }
+
+///////////////////////////////////////////
+
+uint32_t skg_ind_fmt_size(skg_ind_fmt_ format) {
+	switch (format) {
+		case skg_ind_fmt_u32: return 4;
+		case skg_ind_fmt_u16: return 2;
+		case skg_ind_fmt_u8:  return 1;
+		default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+skg_ind_fmt_ skg_ind_fmt_from_stride(uint32_t stride) {
+	// Index buffers take their format from the stride they were created
+	// with, anything unexpected is treated as 32 bit.
+	switch (stride) {
+		case 2:  return skg_ind_fmt_u16;
+		case 1:  return skg_ind_fmt_u8;
+		default: return skg_ind_fmt_u32;
+	}
+}
+///////////////////////////////////////////
+
+#define SKG_VERT_FMT_MAX 64
+
+// Fixed size, so pointers from skg_vert_fmt_get stay valid while other
+// threads register new formats.
+skg_vert_fmt_t _skg_vert_fmts[SKG_VERT_FMT_MAX] = {
+	{ { {skg_fmt_f32,            3, skg_semantic_position, 0},
+	    {skg_fmt_f32,            3, skg_semantic_normal,   0},
+	    {skg_fmt_f32,            2, skg_semantic_texcoord, 0},
+	    {skg_fmt_ui8_normalized, 4, skg_semantic_color,    0} },
+	  { 0, 12, 24, 32 }, 4, sizeof(skg_vert_t) },
+};
+int32_t    _skg_vert_fmt_count = 1;
+std::mutex _skg_vert_fmt_mtx;
+
+int32_t skg_vert_fmt_register(const skg_vert_component_t *components, int32_t component_count) {
+	if (components == nullptr || component_count == 0) return 0;
+	if (component_count < 0 || component_count > SKG_VERT_COMPONENT_MAX) {
+		skg_logf(skg_log_warning, "Vertex formats can have at most %d components", SKG_VERT_COMPONENT_MAX);
+		return -1;
+	}
+
+	skg_vert_fmt_t fmt       = {};
+	uint32_t       align_max = 1;
+	for (int32_t i = 0; i < component_count; i++) {
+		const skg_vert_component_t *com  = &components[i];
+		uint32_t                    size = (uint32_t)skg_fmt_size(com->format);
+		// No backend can feed doubles or 32 bit normalized values to a
+		// vertex shader, and D3D has no 3 wide 8 or 16 bit formats.
+		if (size == 0 || com->count < 1 || com->count > 4 ||
+			(size < 4 && com->count == 3) ||
+			com->format == skg_fmt_f64 ||
+			com->format == skg_fmt_i32_normalized ||
+			com->format == skg_fmt_ui32_normalized) {
+			skg_logf(skg_log_warning, "Unsupported vertex component %d (format %d x%d)", i, com->format, com->count);
+			return -1;
+		}
+		fmt.stride = (fmt.stride + size - 1) / size * size;
+		fmt.components[i].format        = com->format;
+		fmt.components[i].count         = com->count;
+		fmt.components[i].semantic      = com->semantic;
+		fmt.components[i].semantic_slot = com->semantic_slot;
+		fmt.offsets   [i] = fmt.stride;
+		fmt.stride       += size * com->count;
+		if (size > align_max) align_max = size;
+	}
+	fmt.component_count = component_count;
+	fmt.stride          = (fmt.stride + align_max - 1) / align_max * align_max;
+
+	std::lock_guard<std::mutex> lock(_skg_vert_fmt_mtx);
+	for (int32_t f = 0; f < _skg_vert_fmt_count; f++) {
+		const skg_vert_fmt_t *curr  = &_skg_vert_fmts[f];
+		bool                  match = curr->component_count == fmt.component_count && curr->stride == fmt.stride;
+		for (int32_t i = 0; match && i < fmt.component_count; i++) {
+			match = curr->components[i].format        == fmt.components[i].format
+			     && curr->components[i].count         == fmt.components[i].count
+			     && curr->components[i].semantic      == fmt.components[i].semantic
+			     && curr->components[i].semantic_slot == fmt.components[i].semantic_slot;
+		}
+		if (match) return f;
+	}
+	if (_skg_vert_fmt_count >= SKG_VERT_FMT_MAX) {
+		skg_logf(skg_log_warning, "Too many vertex formats, max is %d", SKG_VERT_FMT_MAX);
+		return -1;
+	}
+	_skg_vert_fmts[_skg_vert_fmt_count] = fmt;
+	_skg_vert_fmt_count += 1;
+	return _skg_vert_fmt_count - 1;
+}
+
+///////////////////////////////////////////
+
+const skg_vert_fmt_t *skg_vert_fmt_get(int32_t id) {
+	return id > 0 && id < SKG_VERT_FMT_MAX
+		? &_skg_vert_fmts[id]
+		: &_skg_vert_fmts[0];
+}
+
+///////////////////////////////////////////
+
+int32_t skg_vert_fmt_find(const skg_vert_fmt_t *format, skg_semantic_ semantic, uint8_t semantic_slot) {
+	for (int32_t i = 0; i < format->component_count; i++) {
+		if (format->components[i].semantic      == semantic &&
+			format->components[i].semantic_slot == semantic_slot)
+			return i;
+	}
+	return -1;
+}
+
+///////////////////////////////////////////
+
+void skg_vert_fmt_clear() {
+	std::lock_guard<std::mutex> lock(_skg_vert_fmt_mtx);
+	_skg_vert_fmt_count = 1;
+}
+
+///////////////////////////////////////////
+// Draw queue                            //
+///////////////////////////////////////////
+
+typedef struct skg_draw_item_t {
+	const skg_pipeline_t *pipeline;
+	const skg_mesh_t     *mesh;
+	int32_t               res_start;
+	int32_t               texture_count;
+	int32_t               buffer_count;
+	uint64_t              texture_hash;
+	uint64_t              buffer_hash;
+	uint32_t              constants_offset;
+	uint32_t              constants_size;
+	skg_bind_t            constants_bind;
+	int32_t               index_start;
+	int32_t               index_base;
+	int32_t               index_count;
+	int32_t               instance_count;
+	float                 depth;
+} skg_draw_item_t;
+
+typedef struct skg_draw_res_t {
+	const void *resource;
+	skg_bind_t  bind;
+} skg_draw_res_t;
+
+typedef struct skg_draw_key_t {
+	uint64_t key;
+	uint32_t item;
+} skg_draw_key_t;
+
+///////////////////////////////////////////
+
+skg_draw_queue_t skg_draw_queue_create() {
+	return {};
+}
+
+///////////////////////////////////////////
+
+uint64_t skg_draw_hash(uint64_t hash, uint64_t value) {
+	// FNV-1a, a byte at a time
+	for (int32_t i = 0; i < 8; i++) {
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_add(skg_draw_queue_t *queue, const skg_draw_packet_t *packet) {
+	if (queue->_item_count + 1 > queue->_item_cap) {
+		queue->_item_cap = queue->_item_cap == 0 ? 64 : queue->_item_cap * 2;
+		queue->_items    = (skg_draw_item_t*)realloc(queue->_items, sizeof(skg_draw_item_t) * queue->_item_cap);
+	}
+	int32_t res_count = packet->texture_count + packet->buffer_count;
+	if (queue->_res_count + res_count > queue->_res_cap) {
+		while (queue->_res_count + res_count > queue->_res_cap)
+			queue->_res_cap = queue->_res_cap == 0 ? 64 : queue->_res_cap * 2;
+		queue->_res = (skg_draw_res_t*)realloc(queue->_res, sizeof(skg_draw_res_t) * queue->_res_cap);
+	}
+	if (queue->_data_size + packet->constants_size > queue->_data_cap) {
+		while (queue->_data_size + packet->constants_size > queue->_data_cap)
+			queue->_data_cap = queue->_data_cap == 0 ? 4096 : queue->_data_cap * 2;
+		queue->_data = (uint8_t*)realloc(queue->_data, queue->_data_cap);
+	}
+
+	skg_draw_item_t *item = &queue->_items[queue->_item_count];
+	*item = {};
+	item->pipeline       = packet->pipeline;
+	item->mesh           = packet->mesh;
+	item->res_start      = queue->_res_count;
+	item->texture_count  = packet->texture_count;
+	item->buffer_count   = packet->buffer_count;
+	item->index_start    = packet->index_start;
+	item->index_base     = packet->index_base;
+	item->index_count    = packet->index_count;
+	item->instance_count = packet->instance_count;
+	item->depth          = packet->depth;
+
+	// Textures are identified by their native handle, so copies of the same
+	// skg_tex_t still count as one texture.
+	uint64_t hash = 14695981039346656037ULL;
+	for (int32_t i = 0; i < packet->texture_count; i++) {
+		skg_draw_res_t *res = &queue->_res[queue->_res_count++];
+		res->resource = packet->textures[i];
+		res->bind     = packet->texture_binds[i];
+		hash = skg_draw_hash(hash, (uint64_t)skg_tex_get_native(packet->textures[i]));
+		hash = skg_draw_hash(hash, ((uint64_t)res->bind.slot << 16) | ((uint64_t)res->bind.stage_bits << 8) | res->bind.register_type);
+	}
+	item->texture_hash = hash;
+
+	hash = 14695981039346656037ULL;
+	for (int32_t i = 0; i < packet->buffer_count; i++) {
+		skg_draw_res_t *res = &queue->_res[queue->_res_count++];
+		res->resource = packet->buffers[i];
+		res->bind     = packet->buffer_binds[i];
+		hash = skg_draw_hash(hash, (uint64_t)packet->buffers[i]);
+		hash = skg_draw_hash(hash, ((uint64_t)res->bind.slot << 16) | ((uint64_t)res->bind.stage_bits << 8) | res->bind.register_type);
+	}
+	item->buffer_hash = hash;
+
+	if (packet->constants != nullptr && packet->constants_size > 0) {
+		memcpy(queue->_data + queue->_data_size, packet->constants, packet->constants_size);
+		item->constants_offset = queue->_data_size;
+		item->constants_size   = packet->constants_size;
+		item->constants_bind   = packet->constants_bind;
+		queue->_data_size     += packet->constants_size;
+	}
+	queue->_item_count += 1;
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_draw_rank(skg_draw_queue_t *queue, uint64_t id, uint32_t *ref_count) {
+	// Hands out small ids in order of first appearance, so the sort key has
+	// room for several kinds of state. 0 stays 0 for null resources.
+	if (id == 0) return 0;
+	uint32_t mask = queue->_rank_cap - 1;
+	uint32_t at   = (uint32_t)((id * 11400714819323198485ULL) >> 40) & mask;
+	while (queue->_rank_ids[at] != 0 && queue->_rank_ids[at] != id)
+		at = (at + 1) & mask;
+	if (queue->_rank_ids[at] == 0) {
+		queue->_rank_ids [at] = id;
+		queue->_rank_vals[at] = *ref_count;
+		*ref_count += 1;
+	}
+	return queue->_rank_vals[at];
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_draw_depth_bits(float depth) {
+	// Flips float bits so they sort as unsigned ints, negatives included
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+///////////////////////////////////////////
+
+skg_draw_key_t *skg_draw_radix_sort(skg_draw_key_t *keys, skg_draw_key_t *temp, int32_t count) {
+	// Least significant byte first, skipping bytes that are the same for
+	// every key, which is most of them for small queues.
+	uint32_t histogram[8][256] = {};
+	for (int32_t i = 0; i < count; i++) {
+		for (int32_t b = 0; b < 8; b++)
+			histogram[b][(keys[i].key >> (b * 8)) & 0xFF] += 1;
+	}
+
+	skg_draw_key_t *src = keys;
+	skg_draw_key_t *dst = temp;
+	for (int32_t b = 0; b < 8; b++) {
+		uint32_t *hist = histogram[b];
+		if (hist[(src[0].key >> (b * 8)) & 0xFF] == (uint32_t)count) continue;
+
+		uint32_t offset = 0;
+		for (int32_t i = 0; i < 256; i++) {
+			uint32_t ct = hist[i];
+			hist[i] = offset;
+			offset += ct;
+		}
+		for (int32_t i = 0; i < count; i++) {
+			dst[hist[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+		}
+		skg_draw_key_t *swap = src;
+		src = dst;
+		dst = swap;
+	}
+	return src;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_execute(skg_draw_queue_t *queue, skg_draw_sort_ sort) {
+	SKG_TRACE_FUNC();
+	int32_t count = queue->_item_count;
+	if (count == 0) return;
+
+	if (queue->_key_cap < count) {
+		queue->_key_cap = queue->_item_cap;
+		queue->_keys    = (skg_draw_key_t*)realloc(queue->_keys, sizeof(skg_draw_key_t) * queue->_key_cap * 2);
+	}
+	uint32_t rank_cap = 64;
+	while (rank_cap < (uint32_t)count * 2) rank_cap *= 2;
+	if (queue->_rank_cap < rank_cap) {
+		queue->_rank_cap  = rank_cap;
+		queue->_rank_ids  = (uint64_t*)realloc(queue->_rank_ids,  sizeof(uint64_t) * rank_cap);
+		queue->_rank_vals = (uint32_t*)realloc(queue->_rank_vals, sizeof(uint32_t) * rank_cap);
+	}
+
+	// Rank each kind of state, from most to least expensive to switch:
+	// shader program, the rest of the pipeline, textures, vertex format,
+	// then the mesh's buffers. Ranks past what the key has room for share
+	// the last value, which still draws correctly, just less sorted.
+	skg_draw_key_t *keys      = queue->_keys;
+	const int32_t   bits[5]   = { 10, 8, 12, 6, 12 };
+	for (int32_t i = 0; i < count; i++) {
+		keys[i].key  = 0;
+		keys[i].item = (uint32_t)i;
+	}
+	for (int32_t r = 0; r < 5; r++) {
+		memset(queue->_rank_ids, 0, sizeof(uint64_t) * queue->_rank_cap);
+		uint32_t rank_count = 1;
+		uint32_t rank_max   = (1u << bits[r]) - 1;
+		for (int32_t i = 0; i < count; i++) {
+			const skg_draw_item_t *item = &queue->_items[i];
+			uint64_t id = 0;
+			switch (r) {
+			case 0: id = item->pipeline          ? (uint64_t)item->pipeline->meta      : 0; break;
+			case 1: id = (uint64_t)item->pipeline;                                          break;
+			case 2: id = item->texture_count > 0 ? item->texture_hash                  : 0; break;
+			case 3: id = item->mesh              ? (uint64_t)item->mesh->_vert_fmt + 1 : 0; break;
+			case 4: id = (uint64_t)item->mesh;                                              break;
+			}
+			uint32_t rank = skg_draw_rank(queue, id, &rank_count);
+			keys[i].key = (keys[i].key << bits[r]) | (rank < rank_max ? rank : rank_max);
+		}
+	}
+
+	// 48 bits of state, and depth fills out the rest
+	for (int32_t i = 0; i < count; i++) {
+		uint32_t depth = skg_draw_depth_bits(queue->_items[i].depth);
+		switch (sort) {
+		case skg_draw_sort_state:         keys[i].key = (keys[i].key << 16) | (depth >> 16); break;
+		case skg_draw_sort_back_to_front: keys[i].key = ((uint64_t)~depth << 32) | (keys[i].key >> 16); break;
+		default:                          keys[i].key = 0; break;
+		}
+	}
+	if (sort != skg_draw_sort_none)
+		keys = skg_draw_radix_sort(keys, queue->_keys + queue->_key_cap, count);
+
+	const skg_pipeline_t *last_pipeline = nullptr;
+	const skg_mesh_t     *last_mesh     = nullptr;
+	uint64_t              last_textures = 0;
+	uint64_t              last_buffers  = 0;
+	for (int32_t i = 0; i < count; i++) {
+		const skg_draw_item_t *item = &queue->_items[keys[i].item];
+		const skg_draw_res_t  *res  = &queue->_res[item->res_start];
+
+		if (item->pipeline && item->pipeline != last_pipeline) {
+			skg_pipeline_bind(item->pipeline);
+			last_pipeline = item->pipeline;
+		}
+		if (item->mesh && item->mesh != last_mesh) {
+			skg_mesh_bind(item->mesh);
+			last_mesh = item->mesh;
+		}
+		if (item->texture_count > 0 && item->texture_hash != last_textures) {
+			for (int32_t t = 0; t < item->texture_count; t++)
+				skg_tex_bind((const skg_tex_t*)res[t].resource, res[t].bind);
+			last_textures = item->texture_hash;
+		}
+		if (item->buffer_count > 0 && item->buffer_hash != last_buffers) {
+			for (int32_t b = 0; b < item->buffer_count; b++)
+				skg_buffer_bind((const skg_buffer_t*)res[item->texture_count + b].resource, res[item->texture_count + b].bind);
+			last_buffers = item->buffer_hash;
+		}
+		if (item->constants_size > 0) {
+			// This may have replaced one of the buffers, so the next packet
+			// can't assume they're still bound.
+			skg_transient_bind(queue->_data + item->constants_offset, item->constants_size, item->constants_bind);
+			last_buffers = 0;
+		}
+
+		skg_draw(item->index_start, item->index_base, item->index_count, item->instance_count);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_clear(skg_draw_queue_t *queue) {
+	queue->_item_count = 0;
+	queue->_res_count  = 0;
+	queue->_data_size  = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_destroy(skg_draw_queue_t *queue) {
+	free(queue->_items);
+	free(queue->_res);
+	free(queue->_data);
+	free(queue->_keys);
+	free(queue->_rank_ids);
+	free(queue->_rank_vals);
+	*queue = {};
+}
+
+///////////////////////////////////////////
+// Command lists                         //
+///////////////////////////////////////////
+
+#define SKG_CMD_BLOCK_SIZE (16 * 1024)
+
+typedef enum skg_cmd_op_ {
+	skg_cmd_op_pipeline_bind,
+	skg_cmd_op_mesh_bind,
+	skg_cmd_op_tex_bind,
+	skg_cmd_op_buffer_bind,
+	skg_cmd_op_buffer_bind_range,
+	skg_cmd_op_buffer_clear,
+	skg_cmd_op_transient_bind,
+	skg_cmd_op_shader_compute_bind,
+	skg_cmd_op_viewport,
+	skg_cmd_op_scissor,
+	skg_cmd_op_draw,
+	skg_cmd_op_draw_indirect,
+	skg_cmd_op_draw_multi,
+	skg_cmd_op_compute,
+} skg_cmd_op_;
+
+// Every command is one of these, followed by data_size bytes of copied
+// data, padded to 8 bytes.
+typedef struct skg_cmd_t {
+	skg_cmd_op_ op;
+	uint32_t    data_size;
+	const void *resource;
+	skg_bind_t  bind;
+	int32_t     args[4];
+} skg_cmd_t;
+
+typedef struct skg_cmd_block_t {
+	struct skg_cmd_block_t *next;
+	uint32_t                size;
+	uint32_t                cap;
+} skg_cmd_block_t;
+
+///////////////////////////////////////////
+
+skg_cmd_list_t skg_cmd_list_create() {
+	return {};
+}
+
+///////////////////////////////////////////
+
+skg_cmd_t *skg_cmd_list_push(skg_cmd_list_t *list, skg_cmd_op_ op, const void *data, uint32_t data_size) {
+	uint32_t         size  = (uint32_t)sizeof(skg_cmd_t) + ((data_size + 7) & ~7u);
+	skg_cmd_block_t *block = list->_current;
+	if (block == nullptr || block->size + size > block->cap) {
+		// Blocks left over from before a clear get reused, unless they're
+		// too small for this command.
+		skg_cmd_block_t *next = block ? block->next : list->_first;
+		if (next == nullptr || next->cap < size) {
+			uint32_t         cap   = size > SKG_CMD_BLOCK_SIZE ? size : SKG_CMD_BLOCK_SIZE;
+			skg_cmd_block_t *added = (skg_cmd_block_t*)malloc(sizeof(skg_cmd_block_t) + cap);
+			added->next = next;
+			added->cap  = cap;
+			if (block) block->next  = added;
+			else       list->_first = added;
+			next = added;
+		}
+		next->size     = 0;
+		list->_current = next;
+		block          = next;
+	}
+
+	skg_cmd_t *cmd = (skg_cmd_t*)((uint8_t*)(block + 1) + block->size);
+	*cmd = {};
+	cmd->op        = op;
+	cmd->data_size = data_size;
+	if (data_size > 0) memcpy(cmd + 1, data, data_size);
+	block->size  += size;
+	list->_count += 1;
+	return cmd;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_pipeline_bind(skg_cmd_list_t *list, const skg_pipeline_t *pipeline) {
+	skg_cmd_list_push(list, skg_cmd_op_pipeline_bind, nullptr, 0)->resource = pipeline;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_mesh_bind(skg_cmd_list_t *list, const skg_mesh_t *mesh) {
+	skg_cmd_list_push(list, skg_cmd_op_mesh_bind, nullptr, 0)->resource = mesh;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_tex_bind(skg_cmd_list_t *list, const skg_tex_t *texture, skg_bind_t bind) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_tex_bind, nullptr, 0);
+	cmd->resource = texture;
+	cmd->bind     = bind;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_buffer_bind(skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_buffer_bind, nullptr, 0);
+	cmd->resource = buffer;
+	cmd->bind     = slot_vc;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_buffer_bind_range(skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_buffer_bind_range, nullptr, 0);
+	cmd->resource = buffer;
+	cmd->bind     = slot_vc;
+	cmd->args[0]  = (int32_t)offset;
+	cmd->args[1]  = (int32_t)size_bytes;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_buffer_clear(skg_cmd_list_t *list, skg_bind_t bind) {
+	skg_cmd_list_push(list, skg_cmd_op_buffer_clear, nullptr, 0)->bind = bind;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_transient_bind(skg_cmd_list_t *list, const void *data, uint32_t size_bytes, skg_bind_t slot_vc) {
+	skg_cmd_list_push(list, skg_cmd_op_transient_bind, data, size_bytes)->bind = slot_vc;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_shader_compute_bind(skg_cmd_list_t *list, const skg_shader_t *shader) {
+	skg_cmd_list_push(list, skg_cmd_op_shader_compute_bind, nullptr, 0)->resource = shader;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_viewport(skg_cmd_list_t *list, const int32_t *xywh) {
+	memcpy(skg_cmd_list_push(list, skg_cmd_op_viewport, nullptr, 0)->args, xywh, sizeof(int32_t) * 4);
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_scissor(skg_cmd_list_t *list, const int32_t *xywh) {
+	memcpy(skg_cmd_list_push(list, skg_cmd_op_scissor, nullptr, 0)->args, xywh, sizeof(int32_t) * 4);
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_draw(skg_cmd_list_t *list, int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_draw, nullptr, 0);
+	cmd->args[0] = index_start;
+	cmd->args[1] = index_base;
+	cmd->args[2] = index_count;
+	cmd->args[3] = instance_count;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_draw_indirect(skg_cmd_list_t *list, const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_draw_indirect, nullptr, 0);
+	cmd->resource = args_buffer;
+	cmd->args[0]  = (int32_t)offset;
+	cmd->args[1]  = (int32_t)draw_count;
+	cmd->args[2]  = (int32_t)stride;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_draw_multi(skg_cmd_list_t *list, const skg_draw_args_t *draws, uint32_t draw_count) {
+	skg_cmd_list_push(list, skg_cmd_op_draw_multi, draws, draw_count * (uint32_t)sizeof(skg_draw_args_t));
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_compute(skg_cmd_list_t *list, uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_compute, nullptr, 0);
+	cmd->args[0] = (int32_t)thread_count_x;
+	cmd->args[1] = (int32_t)thread_count_y;
+	cmd->args[2] = (int32_t)thread_count_z;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_execute(const skg_cmd_list_t *list) {
+	SKG_TRACE_FUNC();
+	for (const skg_cmd_block_t *block = list->_first; block != nullptr; block = block->next) {
+		const uint8_t *data = (const uint8_t*)(block + 1);
+		uint32_t       at   = 0;
+		while (at < block->size) {
+			const skg_cmd_t *cmd     = (const skg_cmd_t*)(data + at);
+			const void      *payload = cmd + 1;
+			switch (cmd->op) {
+			case skg_cmd_op_pipeline_bind:       skg_pipeline_bind      ((const skg_pipeline_t*)cmd->resource); break;
+			case skg_cmd_op_mesh_bind:           skg_mesh_bind          ((const skg_mesh_t    *)cmd->resource); break;
+			case skg_cmd_op_tex_bind:            skg_tex_bind           ((const skg_tex_t     *)cmd->resource, cmd->bind); break;
+			case skg_cmd_op_buffer_bind:         skg_buffer_bind        ((const skg_buffer_t  *)cmd->resource, cmd->bind); break;
+			case skg_cmd_op_buffer_bind_range:   skg_buffer_bind_range  ((const skg_buffer_t  *)cmd->resource, cmd->bind, (uint32_t)cmd->args[0], (uint32_t)cmd->args[1]); break;
+			case skg_cmd_op_buffer_clear:        skg_buffer_clear       (cmd->bind); break;
+			case skg_cmd_op_transient_bind:      skg_transient_bind     (payload, cmd->data_size, cmd->bind); break;
+			case skg_cmd_op_shader_compute_bind: skg_shader_compute_bind((const skg_shader_t  *)cmd->resource); break;
+			case skg_cmd_op_viewport:            skg_viewport           (cmd->args); break;
+			case skg_cmd_op_scissor:             skg_scissor            (cmd->args); break;
+			case skg_cmd_op_draw:                skg_draw               (cmd->args[0], cmd->args[1], cmd->args[2], cmd->args[3]); break;
+			case skg_cmd_op_draw_indirect:       skg_draw_indirect      ((const skg_buffer_t  *)cmd->resource, (uint32_t)cmd->args[0], (uint32_t)cmd->args[1], (uint32_t)cmd->args[2]); break;
+			case skg_cmd_op_draw_multi:          skg_draw_multi         ((const skg_draw_args_t*)payload, cmd->data_size / (uint32_t)sizeof(skg_draw_args_t)); break;
+			case skg_cmd_op_compute:             skg_compute            ((uint32_t)cmd->args[0], (uint32_t)cmd->args[1], (uint32_t)cmd->args[2]); break;
+			}
+			at += (uint32_t)sizeof(skg_cmd_t) + ((cmd->data_size + 7) & ~7u);
+		}
+		// Blocks past the current one hold stale commands from before a clear
+		if (block == list->_current) break;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_clear(skg_cmd_list_t *list) {
+	list->_current = list->_first;
+	list->_count   = 0;
+	if (list->_first) list->_first->size = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_destroy(skg_cmd_list_t *list) {
+	skg_cmd_block_t *block = list->_first;
+	while (block != nullptr) {
+		skg_cmd_block_t *next = block->next;
+		free(block);
+		block = next;
+	}
+	*list = {};
+}
 #endif // SKG_IMPL
 /*
 Copyright (c) 2020-2024 Nick Klingensmith
@@ -46,6 +46,482 @@ void skg_log_enable(bool enabled) {
 
 ///////////////////////////////////////////
 
+#include <atomic>
+
+skg_stats_t _skg_stats = {};
+// Upload threads create resources too, so this one counter is shared
+std::atomic<int64_t> _skg_stats_upload_bytes = { 0 };
+
+skg_stats_t skg_stats_get() {
+	skg_stats_t result = _skg_stats;
+	result.upload_bytes = _skg_stats_upload_bytes.load(std::memory_order_relaxed);
+	return result;
+}
+void skg_stats_reset() {
+	_skg_stats = {};
+	_skg_stats_upload_bytes.store(0, std::memory_order_relaxed);
+}
+void skg_stats_upload(int64_t bytes) {
+	_skg_stats_upload_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////
+
+#include <mutex>
+#include <unordered_map>
+
+typedef struct skg_mem_entry_t {
+	int64_t bytes[skg_mem_max];
+	char    name [32];
+} skg_mem_entry_t;
+
+skg_mem_stats_t                               _skg_mem = {};
+std::unordered_map<uint64_t, skg_mem_entry_t> _skg_mem_entries;
+std::mutex                                    _skg_mem_mtx;
+
+///////////////////////////////////////////
+
+void skg_mem_set(skg_mem_entry_t *entry, skg_mem_ type, int64_t bytes) {
+	int64_t delta = bytes - entry->bytes[type];
+	if (delta == 0) return;
+
+	if      (entry->bytes[type] == 0) _skg_mem.allocations[type] += 1;
+	else if (bytes              == 0) _skg_mem.allocations[type] -= 1;
+	entry->bytes[type]    = bytes;
+	_skg_mem.bytes[type] += delta;
+	_skg_mem.total_bytes += delta;
+	if (_skg_mem.bytes[type] > _skg_mem.peak_bytes[type]) _skg_mem.peak_bytes[type] = _skg_mem.bytes[type];
+	if (_skg_mem.total_bytes > _skg_mem.total_peak_bytes) _skg_mem.total_peak_bytes = _skg_mem.total_bytes;
+}
+
+///////////////////////////////////////////
+
+void skg_mem_track(uint64_t key, skg_mem_ type, int64_t bytes) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	if (bytes == 0) {
+		auto entry = _skg_mem_entries.find(key);
+		if (entry != _skg_mem_entries.end())
+			skg_mem_set(&entry->second, type, 0);
+	} else {
+		skg_mem_set(&_skg_mem_entries[key], type, bytes);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_mem_track_tex(uint64_t key, const skg_tex_t *tex, int32_t mip_count, int32_t physical_multisample) {
+	int64_t layer_bytes = 0;
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(tex->width, tex->height, m, &mip_width, &mip_height);
+		layer_bytes += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	int64_t  tex_bytes = layer_bytes * tex->array_count;
+	skg_mem_ type      = skg_mem_tex_image;
+	if      (tex->type == skg_tex_type_rendertarget) type = skg_mem_tex_rendertarget;
+	else if (tex->type != skg_tex_type_image)        type = skg_mem_tex_depth;
+
+	// Multisample textures keep every sample, while tiled MSAA renders into
+	// a multisample surface the driver allocates alongside each framebuffer
+	// layer, and resolves into a single sample texture.
+	int64_t fb_bytes = tex->multisample > physical_multisample
+		? (int64_t)skg_tex_fmt_memory(tex->format, tex->width, tex->height) * tex->multisample * tex->array_count
+		: 0;
+	skg_mem_track(key, type,                physical_multisample > 1 ? 0 : tex_bytes);
+	skg_mem_track(key, skg_mem_msaa,        physical_multisample > 1 ? tex_bytes * physical_multisample : 0);
+	skg_mem_track(key, skg_mem_framebuffer, fb_bytes);
+}
+
+///////////////////////////////////////////
+
+void skg_mem_release(uint64_t key) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	auto entry = _skg_mem_entries.find(key);
+	if (entry == _skg_mem_entries.end()) return;
+
+	for (int32_t i = 0; i < skg_mem_max; i++)
+		skg_mem_set(&entry->second, (skg_mem_)i, 0);
+	_skg_mem_entries.erase(entry);
+}
+
+///////////////////////////////////////////
+
+void skg_mem_add(uint64_t key) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	_skg_mem_entries[key];
+}
+
+///////////////////////////////////////////
+
+void skg_mem_name(uint64_t key, const char *name) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	auto entry = _skg_mem_entries.find(key);
+	if (entry == _skg_mem_entries.end()) return;
+	snprintf(entry->second.name, sizeof(entry->second.name), "%s", name);
+}
+
+///////////////////////////////////////////
+
+skg_mem_stats_t skg_mem_get() {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	return _skg_mem;
+}
+
+///////////////////////////////////////////
+
+void skg_mem_reset_peaks() {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	memcpy(_skg_mem.peak_bytes, _skg_mem.bytes, sizeof(_skg_mem.bytes));
+	_skg_mem.total_peak_bytes = _skg_mem.total_bytes;
+}
+
+///////////////////////////////////////////
+
+int32_t skg_mem_get_allocations(skg_mem_allocation_t *out_allocations, int32_t max_allocations) {
+	std::lock_guard<std::mutex> lock(_skg_mem_mtx);
+	int32_t total = 0;
+	for (int32_t i = 0; i < skg_mem_max; i++) total += _skg_mem.allocations[i];
+	if (out_allocations == nullptr) return total;
+	if (max_allocations <= 0 || total == 0) return 0;
+
+	skg_mem_allocation_t *list  = (skg_mem_allocation_t*)malloc(sizeof(skg_mem_allocation_t) * total);
+	int32_t               count = 0;
+	for (auto &entry : _skg_mem_entries) {
+		for (int32_t i = 0; i < skg_mem_max; i++) {
+			if (entry.second.bytes[i] == 0 || count >= total) continue;
+			skg_mem_allocation_t *item = &list[count++];
+			memcpy(item->name, entry.second.name, sizeof(item->name));
+			item->type  = (skg_mem_)i;
+			item->bytes = entry.second.bytes[i];
+		}
+	}
+	qsort(list, count, sizeof(skg_mem_allocation_t), [](const void *a, const void *b) {
+		int64_t a_bytes = ((const skg_mem_allocation_t*)a)->bytes;
+		int64_t b_bytes = ((const skg_mem_allocation_t*)b)->bytes;
+		return a_bytes < b_bytes ? 1 : (a_bytes > b_bytes ? -1 : 0);
+	});
+
+	if (count > max_allocations) count = max_allocations;
+	memcpy(out_allocations, list, sizeof(skg_mem_allocation_t) * count);
+	free(list);
+	return count;
+}
+
+///////////////////////////////////////////
+
+#if defined(SKG_TRACE)
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+typedef struct skg_trace_event_t {
+	const char *name;
+	char        detail[64];
+	int64_t     start_ns;
+	int64_t     end_ns;
+	uint32_t    thread;
+} skg_trace_event_t;
+
+bool                  _skg_trace_active = false;
+char                 *_skg_trace_file   = nullptr;
+int64_t               _skg_trace_epoch  = 0;
+skg_trace_event_t    *_skg_trace_events = nullptr;
+size_t                _skg_trace_count  = 0;
+size_t                _skg_trace_cap    = 0;
+std::mutex            _skg_trace_mtx;
+std::atomic<uint32_t> _skg_trace_next_thread(1);
+thread_local uint32_t _skg_trace_thread = 0;
+
+int64_t skg_trace_now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void skg_trace_record(const char *name, const char *detail, int64_t start_ns, int64_t end_ns) {
+	if (_skg_trace_thread == 0) _skg_trace_thread = _skg_trace_next_thread++;
+
+	std::lock_guard<std::mutex> lock(_skg_trace_mtx);
+	if (!_skg_trace_active) return;
+	if (_skg_trace_count >= _skg_trace_cap) {
+		size_t             new_cap    = _skg_trace_cap == 0 ? 4096 : _skg_trace_cap * 2;
+		skg_trace_event_t *new_events = (skg_trace_event_t*)realloc(_skg_trace_events, sizeof(skg_trace_event_t) * new_cap);
+		if (new_events == nullptr) return;
+		_skg_trace_events = new_events;
+		_skg_trace_cap    = new_cap;
+	}
+	skg_trace_event_t *evt = &_skg_trace_events[_skg_trace_count++];
+	evt->name     = name;
+	evt->start_ns = start_ns;
+	evt->end_ns   = end_ns;
+	evt->thread   = _skg_trace_thread;
+	snprintf(evt->detail, sizeof(evt->detail), "%s", detail ? detail : "");
+}
+
+bool skg_trace_start(const char *filename) {
+	std::lock_guard<std::mutex> lock(_skg_trace_mtx);
+	if (_skg_trace_active) {
+		skg_log(skg_log_warning, "skg_trace_start called while a trace is already running");
+		return false;
+	}
+	size_t len = strlen(filename) + 1;
+	_skg_trace_file   = (char*)malloc(len);
+	memcpy(_skg_trace_file, filename, len);
+	_skg_trace_count  = 0;
+	_skg_trace_epoch  = skg_trace_now();
+	_skg_trace_active = true;
+	return true;
+}
+
+void skg_trace_stop() {
+	std::lock_guard<std::mutex> lock(_skg_trace_mtx);
+	if (!_skg_trace_active) return;
+	_skg_trace_active = false;
+
+	FILE *fp = fopen(_skg_trace_file, "w");
+	if (fp == nullptr) {
+		skg_logf(skg_log_warning, "Couldn't open trace file %s", _skg_trace_file);
+	} else {
+		fprintf(fp, "{\"traceEvents\":[\n");
+		for (size_t i = 0; i < _skg_trace_count; i++) {
+			const skg_trace_event_t *evt = &_skg_trace_events[i];
+			fprintf(fp, "{\"name\":\"%s\",\"cat\":\"skg\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+				evt->name, evt->thread, (evt->start_ns - _skg_trace_epoch) / 1000.0, (evt->end_ns - evt->start_ns) / 1000.0);
+			if (evt->detail[0] != '\0') {
+				fprintf(fp, ",\"args\":{\"detail\":\"");
+				for (const char *ch = evt->detail; *ch; ch++) {
+					if      (*ch == '"' || *ch == '\\') fprintf(fp, "\\%c", *ch);
+					else if ((uint8_t)*ch < 0x20)        fprintf(fp, "\\u%04x", *ch);
+					else                                 fputc(*ch, fp);
+				}
+				fprintf(fp, "\"}");
+			}
+			fprintf(fp, "}%s\n", i + 1 < _skg_trace_count ? "," : "");
+		}
+		fprintf(fp, "],\"displayTimeUnit\":\"ns\"}\n");
+		fclose(fp);
+	}
+
+	free(_skg_trace_file);
+	free(_skg_trace_events);
+	_skg_trace_file   = nullptr;
+	_skg_trace_events = nullptr;
+	_skg_trace_count  = 0;
+	_skg_trace_cap    = 0;
+}
+#else
+bool skg_trace_start(const char *filename) {
+	skg_log(skg_log_warning, "skg_trace_start requires sk_gpu to be built with SKG_TRACE defined");
+	return false;
+}
+void skg_trace_stop() {
+}
+#endif
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+#include <mutex>
+
+bool       _skg_capture_active = false;
+FILE      *_skg_capture_fp     = nullptr;
+std::mutex _skg_capture_mtx;
+
+void skg_capture_write(skg_capture_op_ op, const void *payload, size_t payload_size, const void *data = nullptr, size_t data_size = 0) {
+	std::lock_guard<std::mutex> lock(_skg_capture_mtx);
+	if (!_skg_capture_active) return;
+
+	skg_capture_record_t record = { (uint32_t)op, (uint32_t)(payload_size + data_size) };
+	fwrite(&record, sizeof(record), 1, _skg_capture_fp);
+	if (payload_size > 0) fwrite(payload, payload_size, 1, _skg_capture_fp);
+	if (data_size    > 0) fwrite(data,    data_size,    1, _skg_capture_fp);
+}
+
+bool skg_capture_start(const char *filename) {
+	std::lock_guard<std::mutex> lock(_skg_capture_mtx);
+	if (_skg_capture_active) {
+		skg_log(skg_log_warning, "skg_capture_start called while a capture is already running");
+		return false;
+	}
+	_skg_capture_fp = fopen(filename, "wb");
+	if (_skg_capture_fp == nullptr) {
+		skg_logf(skg_log_warning, "Couldn't open capture file %s", filename);
+		return false;
+	}
+	skg_capture_header_t header = { SKG_CAPTURE_MAGIC, SKG_CAPTURE_VERSION };
+	fwrite(&header, sizeof(header), 1, _skg_capture_fp);
+	_skg_capture_active = true;
+	return true;
+}
+
+void skg_capture_stop() {
+	std::lock_guard<std::mutex> lock(_skg_capture_mtx);
+	if (!_skg_capture_active) return;
+	_skg_capture_active = false;
+	fclose(_skg_capture_fp);
+	_skg_capture_fp = nullptr;
+}
+
+///////////////////////////////////////////
+
+void skg_capture_frame() {
+	skg_capture_write(skg_capture_op_frame, nullptr, 0);
+}
+void skg_capture_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	skg_capture_draw_t draw = { index_start, index_base, index_count, instance_count };
+	skg_capture_write(skg_capture_op_draw, &draw, sizeof(draw));
+}
+void skg_capture_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	skg_capture_draw_indirect_t draw = { skg_capture_id(args_buffer), offset, draw_count, stride, 0 };
+	skg_capture_write(skg_capture_op_draw_indirect, &draw, sizeof(draw));
+}
+void skg_capture_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	skg_capture_draw_multi_t draw = { draw_count };
+	skg_capture_write(skg_capture_op_draw_multi, &draw, sizeof(draw), draws, sizeof(skg_draw_args_t) * draw_count);
+}
+void skg_capture_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	skg_capture_compute_t compute = { { thread_count_x, thread_count_y, thread_count_z } };
+	skg_capture_write(skg_capture_op_compute, &compute, sizeof(compute));
+}
+void skg_capture_rect(skg_capture_op_ op, const int32_t *xywh) {
+	skg_capture_rect_t rect = { { xywh[0], xywh[1], xywh[2], xywh[3] } };
+	skg_capture_write(op, &rect, sizeof(rect));
+}
+void skg_capture_target_clear(bool depth, const float *clear_color_4) {
+	skg_capture_clear_t clear = {};
+	clear.depth     = depth;
+	clear.has_color = clear_color_4 != nullptr;
+	if (clear_color_4) memcpy(clear.color, clear_color_4, sizeof(clear.color));
+	skg_capture_write(skg_capture_op_target_clear, &clear, sizeof(clear));
+}
+void skg_capture_event_begin(const char *name) {
+	skg_capture_write(skg_capture_op_event_begin, nullptr, 0, name, strlen(name));
+}
+void skg_capture_event_end() {
+	skg_capture_write(skg_capture_op_event_end, nullptr, 0);
+}
+
+///////////////////////////////////////////
+
+void skg_capture_buffer_create(const skg_buffer_t *buffer, const void *data, uint32_t size_count, uint32_t size_stride) {
+	skg_capture_buffer_t create = {};
+	create.id          = skg_capture_id(buffer);
+	create.size_count  = size_count;
+	create.size_stride = size_stride;
+	create.type        = buffer->type;
+	create.use         = buffer->use;
+	create.has_data    = data != nullptr;
+	skg_capture_write(skg_capture_op_buffer_create, &create, sizeof(create), data, data ? (size_t)size_count * size_stride : 0);
+}
+void skg_capture_buffer_set_contents(const skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	skg_capture_id_t id = { skg_capture_id(buffer) };
+	skg_capture_write(skg_capture_op_buffer_set_contents, &id, sizeof(id), data, data ? size_bytes : 0);
+}
+void skg_capture_buffer_set_range(const skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	skg_capture_buffer_range_t range = { skg_capture_id(buffer), offset, size_bytes };
+	skg_capture_write(skg_capture_op_buffer_set_range, &range, sizeof(range), data, size_bytes);
+}
+void skg_capture_bind(skg_capture_op_ op, uint64_t id, skg_bind_t bind) {
+	skg_capture_bind_t capture = { id, bind.slot, bind.stage_bits, bind.register_type, 0 };
+	skg_capture_write(op, &capture, sizeof(capture));
+}
+void skg_capture_bind_range(skg_capture_op_ op, uint64_t id, skg_bind_t bind, uint32_t offset, uint32_t size, const void *data) {
+	skg_capture_bind_range_t capture = { id, bind.slot, bind.stage_bits, bind.register_type, offset, size, 0 };
+	skg_capture_write(op, &capture, sizeof(capture), data, data ? size : 0);
+}
+void skg_capture_mesh_bind(uint64_t vert_id, uint64_t ind_id, int32_t vert_fmt) {
+	skg_capture_mesh_t    mesh = { vert_id, ind_id };
+	const skg_vert_fmt_t *fmt  = skg_vert_fmt_get(vert_fmt);
+	if (vert_fmt > 0) skg_capture_write(skg_capture_op_mesh_bind, &mesh, sizeof(mesh), fmt->components, sizeof(skg_vert_component_t) * fmt->component_count);
+	else              skg_capture_write(skg_capture_op_mesh_bind, &mesh, sizeof(mesh));
+}
+void skg_capture_shader_create(const skg_shader_t *shader, const void *sks_data, size_t sks_data_size) {
+	skg_capture_id_t id = { skg_capture_id(shader) };
+	skg_capture_write(skg_capture_op_shader_create, &id, sizeof(id), sks_data, sks_data_size);
+}
+void skg_capture_pipeline_bind(const skg_pipeline_t *pipeline, uint64_t shader_id) {
+	skg_capture_pipeline_t capture = {};
+	capture.shader_id    = shader_id;
+	capture.transparency = pipeline->transparency;
+	capture.cull         = pipeline->cull;
+	capture.color_write  = pipeline->color_write;
+	capture.depth_test   = pipeline->depth_test;
+	capture.wireframe    = pipeline->wireframe;
+	capture.depth_write  = pipeline->depth_write;
+	capture.depth_clip   = pipeline->depth_clip;
+	capture.scissor      = pipeline->scissor;
+	skg_capture_write(skg_capture_op_pipeline_bind, &capture, sizeof(capture));
+}
+
+///////////////////////////////////////////
+
+void skg_capture_tex_create(skg_capture_op_ op, const skg_tex_t *tex) {
+	skg_capture_tex_t create = {};
+	create.id          = skg_capture_id(tex);
+	create.type        = tex->type;
+	create.use         = tex->use;
+	create.format      = tex->format;
+	create.mips        = tex->mips;
+	create.width       = tex->width;
+	create.height      = tex->height;
+	create.array_count = tex->array_count;
+	create.multisample = tex->multisample;
+	skg_capture_write(op, &create, sizeof(create));
+}
+void skg_capture_tex_settings(const skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	skg_capture_tex_settings_t settings = { skg_capture_id(tex), address, sample, compare, anisotropy };
+	skg_capture_write(skg_capture_op_tex_settings, &settings, sizeof(settings));
+}
+void skg_capture_tex_set_contents(const skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
+	skg_capture_tex_contents_t contents = {};
+	contents.id          = skg_capture_id(tex);
+	contents.array_count = array_count;
+	contents.mip_count   = mip_count;
+	contents.width       = width;
+	contents.height      = height;
+	contents.multisample = multisample;
+	contents.has_data    = array_data != nullptr;
+	if (array_data == nullptr) {
+		skg_capture_write(skg_capture_op_tex_set_contents, &contents, sizeof(contents));
+		return;
+	}
+
+	// Pack the arrays together so they can go out as a single record. Missing
+	// arrays are filled with zeros.
+	size_t array_size = 0;
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
+		array_size += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	uint8_t *data = (uint8_t*)calloc(array_count, array_size);
+	for (int32_t i = 0; i < array_count; i++) {
+		if (array_data[i]) memcpy(data + i * array_size, array_data[i], array_size);
+	}
+	skg_capture_write(skg_capture_op_tex_set_contents, &contents, sizeof(contents), data, array_count * array_size);
+	free(data);
+}
+void skg_capture_tex_pair(skg_capture_op_ op, uint64_t id, int32_t surface, uint64_t other_id, int32_t other_surface) {
+	skg_capture_tex_pair_t pair = { id, other_id, surface, other_surface };
+	skg_capture_write(op, &pair, sizeof(pair));
+}
+void skg_capture_tex_target_bind(uint64_t id, int32_t layer_idx, int32_t mip_level) {
+	skg_capture_target_t target = { id, layer_idx, mip_level };
+	skg_capture_write(skg_capture_op_tex_target_bind, &target, sizeof(target));
+}
+void skg_capture_id_op(skg_capture_op_ op, uint64_t id) {
+	skg_capture_id_t capture = { id };
+	skg_capture_write(op, &capture, sizeof(capture));
+}
+#else
+bool skg_capture_start(const char *filename) {
+	skg_log(skg_log_warning, "skg_capture_start requires sk_gpu to be built with SKG_CAPTURE defined");
+	return false;
+}
+void skg_capture_stop() {
+}
+#endif
+
+///////////////////////////////////////////
+
 bool (*_skg_read_file)(const char *filename, void **out_data, size_t *out_size);
 void skg_callback_file_read(bool (*callback)(const char *filename, void **out_data, size_t *out_size)) {
 	_skg_read_file = callback;
@@ -78,6 +554,48 @@ bool skg_read_file(const char *filename, void **out_data, size_t *out_size) {
 
 ///////////////////////////////////////////
 
+bool (*_skg_write_file)(const char *filename, const void *data, size_t size);
+void skg_callback_file_write(bool (*callback)(const char *filename, const void *data, size_t size)) {
+	_skg_write_file = callback;
+}
+bool skg_write_file(const char *filename, const void *data, size_t size) {
+	if (_skg_write_file) return _skg_write_file(filename, data, size);
+	FILE *fp;
+#if _WIN32
+	if (fopen_s(&fp, filename, "wb") != 0 || fp == nullptr) {
+		return false;
+	}
+#else
+	fp = fopen(filename, "wb");
+	if (fp == nullptr) {
+		return false;
+	}
+#endif
+
+	bool result = fwrite(data, size, 1, fp) == 1;
+	fclose(fp);
+
+	return result;
+}
+
+///////////////////////////////////////////
+
+char *_skg_shader_cache_folder = nullptr;
+void skg_shader_cache_set_folder(const char *folder) {
+	free(_skg_shader_cache_folder);
+	_skg_shader_cache_folder = nullptr;
+	if (folder == nullptr) return;
+
+	size_t len = strlen(folder);
+	_skg_shader_cache_folder = (char*)malloc(len + 1);
+	memcpy(_skg_shader_cache_folder, folder, len + 1);
+}
+const char *skg_shader_cache_folder() {
+	return _skg_shader_cache_folder;
+}
+
+///////////////////////////////////////////
+
 uint64_t skg_hash(const char *string) {
 	uint64_t hash = 14695981039346656037UL;
 	while (*string != '\0') {
@@ -475,6 +993,7 @@ skg_color128_t skg_col_to_linear(skg_color128_t srgb) {
 ///////////////////////////////////////////
 
 bool skg_shader_file_load(const char *file, skg_shader_file_t *out_file) {
+	SKG_TRACE_FUNC();
 	void  *data = nullptr;
 	size_t size = 0;
 
@@ -513,6 +1032,7 @@ bool skg_shader_file_verify(const void *data, size_t size, uint16_t *out_version
 ///////////////////////////////////////////
 
 bool skg_shader_file_load_memory(const void *data, size_t size, skg_shader_file_t *out_file) {
+	SKG_TRACE_FUNC();
 	uint16_t file_version = 0;
 	if (!skg_shader_file_verify(data, size, &file_version, nullptr, 0) || file_version != 3) {
 		return false;
@@ -735,21 +1255,18 @@ void skg_shader_meta_release(skg_shader_meta_t *meta) {
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_file(const char *sks_filename) {
-	skg_shader_file_t file;
-	if (!skg_shader_file_load(sks_filename, &file)) {
+	SKG_TRACE_SCOPE_DETAIL(__func__, sks_filename);
+	void  *data = nullptr;
+	size_t size = 0;
+	if (!skg_read_file(sks_filename, &data, &size)) {
 		skg_shader_t empty = {};
 		return empty;
 	}
 
-	skg_shader_stage_t vs     = skg_shader_file_create_stage(&file, skg_stage_vertex);
-	skg_shader_stage_t ps     = skg_shader_file_create_stage(&file, skg_stage_pixel);
-	skg_shader_stage_t cs     = skg_shader_file_create_stage(&file, skg_stage_compute);
-	skg_shader_t       result = skg_shader_create_manual( file.meta, vs, ps, cs );
-
-	skg_shader_stage_destroy(&vs);
-	skg_shader_stage_destroy(&ps);
-	skg_shader_stage_destroy(&cs);
-	skg_shader_file_destroy (&file);
+	// Going through skg_shader_create_memory means captures get a copy of
+	// the file's data too.
+	skg_shader_t result = skg_shader_create_memory(data, size);
+	free(data);
 
 	return result;
 }
@@ -757,6 +1274,7 @@ skg_shader_t skg_shader_create_file(const char *sks_filename) {
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_memory(const void *sks_data, size_t sks_data_size) {
+	SKG_TRACE_FUNC();
 	skg_shader_file_t file;
 	if (!skg_shader_file_load_memory(sks_data, sks_data_size, &file)) {
 		skg_shader_t empty = {};
@@ -773,6 +1291,7 @@ skg_shader_t skg_shader_create_memory(const void *sks_data, size_t sks_data_size
 	skg_shader_stage_destroy(&cs);
 	skg_shader_file_destroy (&file);
 
+	SKG_CAPTURE_CALL(skg_capture_shader_create(&result, sks_data, sks_data_size));
 	return result;
 }
 
@@ -924,4 +1443,647 @@ int32_t skg_fmt_size(skg_fmt_ format) {
 		case skg_fmt_ui8_normalized: return 1;
 		default: return 0;
 	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_ind_fmt_size(skg_ind_fmt_ format) {
+	switch (format) {
+		case skg_ind_fmt_u32: return 4;
+		case skg_ind_fmt_u16: return 2;
+		case skg_ind_fmt_u8:  return 1;
+		default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+skg_ind_fmt_ skg_ind_fmt_from_stride(uint32_t stride) {
+	// Index buffers take their format from the stride they were created
+	// with, anything unexpected is treated as 32 bit.
+	switch (stride) {
+		case 2:  return skg_ind_fmt_u16;
+		case 1:  return skg_ind_fmt_u8;
+		default: return skg_ind_fmt_u32;
+	}
+}
+///////////////////////////////////////////
+
+#define SKG_VERT_FMT_MAX 64
+
+// Fixed size, so pointers from skg_vert_fmt_get stay valid while other
+// threads register new formats.
+skg_vert_fmt_t _skg_vert_fmts[SKG_VERT_FMT_MAX] = {
+	{ { {skg_fmt_f32,            3, skg_semantic_position, 0},
+	    {skg_fmt_f32,            3, skg_semantic_normal,   0},
+	    {skg_fmt_f32,            2, skg_semantic_texcoord, 0},
+	    {skg_fmt_ui8_normalized, 4, skg_semantic_color,    0} },
+	  { 0, 12, 24, 32 }, 4, sizeof(skg_vert_t) },
+};
+int32_t    _skg_vert_fmt_count = 1;
+std::mutex _skg_vert_fmt_mtx;
+
+int32_t skg_vert_fmt_register(const skg_vert_component_t *components, int32_t component_count) {
+	if (components == nullptr || component_count == 0) return 0;
+	if (component_count < 0 || component_count > SKG_VERT_COMPONENT_MAX) {
+		skg_logf(skg_log_warning, "Vertex formats can have at most %d components", SKG_VERT_COMPONENT_MAX);
+		return -1;
+	}
+
+	skg_vert_fmt_t fmt       = {};
+	uint32_t       align_max = 1;
+	for (int32_t i = 0; i < component_count; i++) {
+		const skg_vert_component_t *com  = &components[i];
+		uint32_t                    size = (uint32_t)skg_fmt_size(com->format);
+		// No backend can feed doubles or 32 bit normalized values to a
+		// vertex shader, and D3D has no 3 wide 8 or 16 bit formats.
+		if (size == 0 || com->count < 1 || com->count > 4 ||
+			(size < 4 && com->count == 3) ||
+			com->format == skg_fmt_f64 ||
+			com->format == skg_fmt_i32_normalized ||
+			com->format == skg_fmt_ui32_normalized) {
+			skg_logf(skg_log_warning, "Unsupported vertex component %d (format %d x%d)", i, com->format, com->count);
+			return -1;
+		}
+		fmt.stride = (fmt.stride + size - 1) / size * size;
+		fmt.components[i].format        = com->format;
+		fmt.components[i].count         = com->count;
+		fmt.components[i].semantic      = com->semantic;
+		fmt.components[i].semantic_slot = com->semantic_slot;
+		fmt.offsets   [i] = fmt.stride;
+		fmt.stride       += size * com->count;
+		if (size > align_max) align_max = size;
+	}
+	fmt.component_count = component_count;
+	fmt.stride          = (fmt.stride + align_max - 1) / align_max * align_max;
+
+	std::lock_guard<std::mutex> lock(_skg_vert_fmt_mtx);
+	for (int32_t f = 0; f < _skg_vert_fmt_count; f++) {
+		const skg_vert_fmt_t *curr  = &_skg_vert_fmts[f];
+		bool                  match = curr->component_count == fmt.component_count && curr->stride == fmt.stride;
+		for (int32_t i = 0; match && i < fmt.component_count; i++) {
+			match = curr->components[i].format        == fmt.components[i].format
+			     && curr->components[i].count         == fmt.components[i].count
+			     && curr->components[i].semantic      == fmt.components[i].semantic
+			     && curr->components[i].semantic_slot == fmt.components[i].semantic_slot;
+		}
+		if (match) return f;
+	}
+	if (_skg_vert_fmt_count >= SKG_VERT_FMT_MAX) {
+		skg_logf(skg_log_warning, "Too many vertex formats, max is %d", SKG_VERT_FMT_MAX);
+		return -1;
+	}
+	_skg_vert_fmts[_skg_vert_fmt_count] = fmt;
+	_skg_vert_fmt_count += 1;
+	return _skg_vert_fmt_count - 1;
+}
+
+///////////////////////////////////////////
+
+const skg_vert_fmt_t *skg_vert_fmt_get(int32_t id) {
+	return id > 0 && id < SKG_VERT_FMT_MAX
+		? &_skg_vert_fmts[id]
+		: &_skg_vert_fmts[0];
+}
+
+///////////////////////////////////////////
+
+int32_t skg_vert_fmt_find(const skg_vert_fmt_t *format, skg_semantic_ semantic, uint8_t semantic_slot) {
+	for (int32_t i = 0; i < format->component_count; i++) {
+		if (format->components[i].semantic      == semantic &&
+			format->components[i].semantic_slot == semantic_slot)
+			return i;
+	}
+	return -1;
+}
+
+///////////////////////////////////////////
+
+void skg_vert_fmt_clear() {
+	std::lock_guard<std::mutex> lock(_skg_vert_fmt_mtx);
+	_skg_vert_fmt_count = 1;
+}
+
+///////////////////////////////////////////
+// Draw queue                            //
+///////////////////////////////////////////
+
+typedef struct skg_draw_item_t {
+	const skg_pipeline_t *pipeline;
+	const skg_mesh_t     *mesh;
+	int32_t               res_start;
+	int32_t               texture_count;
+	int32_t               buffer_count;
+	uint64_t              texture_hash;
+	uint64_t              buffer_hash;
+	uint32_t              constants_offset;
+	uint32_t              constants_size;
+	skg_bind_t            constants_bind;
+	int32_t               index_start;
+	int32_t               index_base;
+	int32_t               index_count;
+	int32_t               instance_count;
+	float                 depth;
+} skg_draw_item_t;
+
+typedef struct skg_draw_res_t {
+	const void *resource;
+	skg_bind_t  bind;
+} skg_draw_res_t;
+
+typedef struct skg_draw_key_t {
+	uint64_t key;
+	uint32_t item;
+} skg_draw_key_t;
+
+///////////////////////////////////////////
+
+skg_draw_queue_t skg_draw_queue_create() {
+	return {};
+}
+
+///////////////////////////////////////////
+
+uint64_t skg_draw_hash(uint64_t hash, uint64_t value) {
+	// FNV-1a, a byte at a time
+	for (int32_t i = 0; i < 8; i++) {
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_add(skg_draw_queue_t *queue, const skg_draw_packet_t *packet) {
+	if (queue->_item_count + 1 > queue->_item_cap) {
+		queue->_item_cap = queue->_item_cap == 0 ? 64 : queue->_item_cap * 2;
+		queue->_items    = (skg_draw_item_t*)realloc(queue->_items, sizeof(skg_draw_item_t) * queue->_item_cap);
+	}
+	int32_t res_count = packet->texture_count + packet->buffer_count;
+	if (queue->_res_count + res_count > queue->_res_cap) {
+		while (queue->_res_count + res_count > queue->_res_cap)
+			queue->_res_cap = queue->_res_cap == 0 ? 64 : queue->_res_cap * 2;
+		queue->_res = (skg_draw_res_t*)realloc(queue->_res, sizeof(skg_draw_res_t) * queue->_res_cap);
+	}
+	if (queue->_data_size + packet->constants_size > queue->_data_cap) {
+		while (queue->_data_size + packet->constants_size > queue->_data_cap)
+			queue->_data_cap = queue->_data_cap == 0 ? 4096 : queue->_data_cap * 2;
+		queue->_data = (uint8_t*)realloc(queue->_data, queue->_data_cap);
+	}
+
+	skg_draw_item_t *item = &queue->_items[queue->_item_count];
+	*item = {};
+	item->pipeline       = packet->pipeline;
+	item->mesh           = packet->mesh;
+	item->res_start      = queue->_res_count;
+	item->texture_count  = packet->texture_count;
+	item->buffer_count   = packet->buffer_count;
+	item->index_start    = packet->index_start;
+	item->index_base     = packet->index_base;
+	item->index_count    = packet->index_count;
+	item->instance_count = packet->instance_count;
+	item->depth          = packet->depth;
+
+	// Textures are identified by their native handle, so copies of the same
+	// skg_tex_t still count as one texture.
+	uint64_t hash = 14695981039346656037ULL;
+	for (int32_t i = 0; i < packet->texture_count; i++) {
+		skg_draw_res_t *res = &queue->_res[queue->_res_count++];
+		res->resource = packet->textures[i];
+		res->bind     = packet->texture_binds[i];
+		hash = skg_draw_hash(hash, (uint64_t)skg_tex_get_native(packet->textures[i]));
+		hash = skg_draw_hash(hash, ((uint64_t)res->bind.slot << 16) | ((uint64_t)res->bind.stage_bits << 8) | res->bind.register_type);
+	}
+	item->texture_hash = hash;
+
+	hash = 14695981039346656037ULL;
+	for (int32_t i = 0; i < packet->buffer_count; i++) {
+		skg_draw_res_t *res = &queue->_res[queue->_res_count++];
+		res->resource = packet->buffers[i];
+		res->bind     = packet->buffer_binds[i];
+		hash = skg_draw_hash(hash, (uint64_t)packet->buffers[i]);
+		hash = skg_draw_hash(hash, ((uint64_t)res->bind.slot << 16) | ((uint64_t)res->bind.stage_bits << 8) | res->bind.register_type);
+	}
+	item->buffer_hash = hash;
+
+	if (packet->constants != nullptr && packet->constants_size > 0) {
+		memcpy(queue->_data + queue->_data_size, packet->constants, packet->constants_size);
+		item->constants_offset = queue->_data_size;
+		item->constants_size   = packet->constants_size;
+		item->constants_bind   = packet->constants_bind;
+		queue->_data_size     += packet->constants_size;
+	}
+	queue->_item_count += 1;
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_draw_rank(skg_draw_queue_t *queue, uint64_t id, uint32_t *ref_count) {
+	// Hands out small ids in order of first appearance, so the sort key has
+	// room for several kinds of state. 0 stays 0 for null resources.
+	if (id == 0) return 0;
+	uint32_t mask = queue->_rank_cap - 1;
+	uint32_t at   = (uint32_t)((id * 11400714819323198485ULL) >> 40) & mask;
+	while (queue->_rank_ids[at] != 0 && queue->_rank_ids[at] != id)
+		at = (at + 1) & mask;
+	if (queue->_rank_ids[at] == 0) {
+		queue->_rank_ids [at] = id;
+		queue->_rank_vals[at] = *ref_count;
+		*ref_count += 1;
+	}
+	return queue->_rank_vals[at];
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_draw_depth_bits(float depth) {
+	// Flips float bits so they sort as unsigned ints, negatives included
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+///////////////////////////////////////////
+
+skg_draw_key_t *skg_draw_radix_sort(skg_draw_key_t *keys, skg_draw_key_t *temp, int32_t count) {
+	// Least significant byte first, skipping bytes that are the same for
+	// every key, which is most of them for small queues.
+	uint32_t histogram[8][256] = {};
+	for (int32_t i = 0; i < count; i++) {
+		for (int32_t b = 0; b < 8; b++)
+			histogram[b][(keys[i].key >> (b * 8)) & 0xFF] += 1;
+	}
+
+	skg_draw_key_t *src = keys;
+	skg_draw_key_t *dst = temp;
+	for (int32_t b = 0; b < 8; b++) {
+		uint32_t *hist = histogram[b];
+		if (hist[(src[0].key >> (b * 8)) & 0xFF] == (uint32_t)count) continue;
+
+		uint32_t offset = 0;
+		for (int32_t i = 0; i < 256; i++) {
+			uint32_t ct = hist[i];
+			hist[i] = offset;
+			offset += ct;
+		}
+		for (int32_t i = 0; i < count; i++) {
+			dst[hist[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+		}
+		skg_draw_key_t *swap = src;
+		src = dst;
+		dst = swap;
+	}
+	return src;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_execute(skg_draw_queue_t *queue, skg_draw_sort_ sort) {
+	SKG_TRACE_FUNC();
+	int32_t count = queue->_item_count;
+	if (count == 0) return;
+
+	if (queue->_key_cap < count) {
+		queue->_key_cap = queue->_item_cap;
+		queue->_keys    = (skg_draw_key_t*)realloc(queue->_keys, sizeof(skg_draw_key_t) * queue->_key_cap * 2);
+	}
+	uint32_t rank_cap = 64;
+	while (rank_cap < (uint32_t)count * 2) rank_cap *= 2;
+	if (queue->_rank_cap < rank_cap) {
+		queue->_rank_cap  = rank_cap;
+		queue->_rank_ids  = (uint64_t*)realloc(queue->_rank_ids,  sizeof(uint64_t) * rank_cap);
+		queue->_rank_vals = (uint32_t*)realloc(queue->_rank_vals, sizeof(uint32_t) * rank_cap);
+	}
+
+	// Rank each kind of state, from most to least expensive to switch:
+	// shader program, the rest of the pipeline, textures, vertex format,
+	// then the mesh's buffers. Ranks past what the key has room for share
+	// the last value, which still draws correctly, just less sorted.
+	skg_draw_key_t *keys      = queue->_keys;
+	const int32_t   bits[5]   = { 10, 8, 12, 6, 12 };
+	for (int32_t i = 0; i < count; i++) {
+		keys[i].key  = 0;
+		keys[i].item = (uint32_t)i;
+	}
+	for (int32_t r = 0; r < 5; r++) {
+		memset(queue->_rank_ids, 0, sizeof(uint64_t) * queue->_rank_cap);
+		uint32_t rank_count = 1;
+		uint32_t rank_max   = (1u << bits[r]) - 1;
+		for (int32_t i = 0; i < count; i++) {
+			const skg_draw_item_t *item = &queue->_items[i];
+			uint64_t id = 0;
+			switch (r) {
+			case 0: id = item->pipeline          ? (uint64_t)item->pipeline->meta      : 0; break;
+			case 1: id = (uint64_t)item->pipeline;                                          break;
+			case 2: id = item->texture_count > 0 ? item->texture_hash                  : 0; break;
+			case 3: id = item->mesh              ? (uint64_t)item->mesh->_vert_fmt + 1 : 0; break;
+			case 4: id = (uint64_t)item->mesh;                                              break;
+			}
+			uint32_t rank = skg_draw_rank(queue, id, &rank_count);
+			keys[i].key = (keys[i].key << bits[r]) | (rank < rank_max ? rank : rank_max);
+		}
+	}
+
+	// 48 bits of state, and depth fills out the rest
+	for (int32_t i = 0; i < count; i++) {
+		uint32_t depth = skg_draw_depth_bits(queue->_items[i].depth);
+		switch (sort) {
+		case skg_draw_sort_state:         keys[i].key = (keys[i].key << 16) | (depth >> 16); break;
+		case skg_draw_sort_back_to_front: keys[i].key = ((uint64_t)~depth << 32) | (keys[i].key >> 16); break;
+		default:                          keys[i].key = 0; break;
+		}
+	}
+	if (sort != skg_draw_sort_none)
+		keys = skg_draw_radix_sort(keys, queue->_keys + queue->_key_cap, count);
+
+	const skg_pipeline_t *last_pipeline = nullptr;
+	const skg_mesh_t     *last_mesh     = nullptr;
+	uint64_t              last_textures = 0;
+	uint64_t              last_buffers  = 0;
+	for (int32_t i = 0; i < count; i++) {
+		const skg_draw_item_t *item = &queue->_items[keys[i].item];
+		const skg_draw_res_t  *res  = &queue->_res[item->res_start];
+
+		if (item->pipeline && item->pipeline != last_pipeline) {
+			skg_pipeline_bind(item->pipeline);
+			last_pipeline = item->pipeline;
+		}
+		if (item->mesh && item->mesh != last_mesh) {
+			skg_mesh_bind(item->mesh);
+			last_mesh = item->mesh;
+		}
+		if (item->texture_count > 0 && item->texture_hash != last_textures) {
+			for (int32_t t = 0; t < item->texture_count; t++)
+				skg_tex_bind((const skg_tex_t*)res[t].resource, res[t].bind);
+			last_textures = item->texture_hash;
+		}
+		if (item->buffer_count > 0 && item->buffer_hash != last_buffers) {
+			for (int32_t b = 0; b < item->buffer_count; b++)
+				skg_buffer_bind((const skg_buffer_t*)res[item->texture_count + b].resource, res[item->texture_count + b].bind);
+			last_buffers = item->buffer_hash;
+		}
+		if (item->constants_size > 0) {
+			// This may have replaced one of the buffers, so the next packet
+			// can't assume they're still bound.
+			skg_transient_bind(queue->_data + item->constants_offset, item->constants_size, item->constants_bind);
+			last_buffers = 0;
+		}
+
+		skg_draw(item->index_start, item->index_base, item->index_count, item->instance_count);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_clear(skg_draw_queue_t *queue) {
+	queue->_item_count = 0;
+	queue->_res_count  = 0;
+	queue->_data_size  = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_queue_destroy(skg_draw_queue_t *queue) {
+	free(queue->_items);
+	free(queue->_res);
+	free(queue->_data);
+	free(queue->_keys);
+	free(queue->_rank_ids);
+	free(queue->_rank_vals);
+	*queue = {};
+}
+
+///////////////////////////////////////////
+// Command lists                         //
+///////////////////////////////////////////
+
+#define SKG_CMD_BLOCK_SIZE (16 * 1024)
+
+typedef enum skg_cmd_op_ {
+	skg_cmd_op_pipeline_bind,
+	skg_cmd_op_mesh_bind,
+	skg_cmd_op_tex_bind,
+	skg_cmd_op_buffer_bind,
+	skg_cmd_op_buffer_bind_range,
+	skg_cmd_op_buffer_clear,
+	skg_cmd_op_transient_bind,
+	skg_cmd_op_shader_compute_bind,
+	skg_cmd_op_viewport,
+	skg_cmd_op_scissor,
+	skg_cmd_op_draw,
+	skg_cmd_op_draw_indirect,
+	skg_cmd_op_draw_multi,
+	skg_cmd_op_compute,
+} skg_cmd_op_;
+
+// Every command is one of these, followed by data_size bytes of copied
+// data, padded to 8 bytes.
+typedef struct skg_cmd_t {
+	skg_cmd_op_ op;
+	uint32_t    data_size;
+	const void *resource;
+	skg_bind_t  bind;
+	int32_t     args[4];
+} skg_cmd_t;
+
+typedef struct skg_cmd_block_t {
+	struct skg_cmd_block_t *next;
+	uint32_t                size;
+	uint32_t                cap;
+} skg_cmd_block_t;
+
+///////////////////////////////////////////
+
+skg_cmd_list_t skg_cmd_list_create() {
+	return {};
+}
+
+///////////////////////////////////////////
+
+skg_cmd_t *skg_cmd_list_push(skg_cmd_list_t *list, skg_cmd_op_ op, const void *data, uint32_t data_size) {
+	uint32_t         size  = (uint32_t)sizeof(skg_cmd_t) + ((data_size + 7) & ~7u);
+	skg_cmd_block_t *block = list->_current;
+	if (block == nullptr || block->size + size > block->cap) {
+		// Blocks left over from before a clear get reused, unless they're
+		// too small for this command.
+		skg_cmd_block_t *next = block ? block->next : list->_first;
+		if (next == nullptr || next->cap < size) {
+			uint32_t         cap   = size > SKG_CMD_BLOCK_SIZE ? size : SKG_CMD_BLOCK_SIZE;
+			skg_cmd_block_t *added = (skg_cmd_block_t*)malloc(sizeof(skg_cmd_block_t) + cap);
+			added->next = next;
+			added->cap  = cap;
+			if (block) block->next  = added;
+			else       list->_first = added;
+			next = added;
+		}
+		next->size     = 0;
+		list->_current = next;
+		block          = next;
+	}
+
+	skg_cmd_t *cmd = (skg_cmd_t*)((uint8_t*)(block + 1) + block->size);
+	*cmd = {};
+	cmd->op        = op;
+	cmd->data_size = data_size;
+	if (data_size > 0) memcpy(cmd + 1, data, data_size);
+	block->size  += size;
+	list->_count += 1;
+	return cmd;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_pipeline_bind(skg_cmd_list_t *list, const skg_pipeline_t *pipeline) {
+	skg_cmd_list_push(list, skg_cmd_op_pipeline_bind, nullptr, 0)->resource = pipeline;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_mesh_bind(skg_cmd_list_t *list, const skg_mesh_t *mesh) {
+	skg_cmd_list_push(list, skg_cmd_op_mesh_bind, nullptr, 0)->resource = mesh;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_tex_bind(skg_cmd_list_t *list, const skg_tex_t *texture, skg_bind_t bind) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_tex_bind, nullptr, 0);
+	cmd->resource = texture;
+	cmd->bind     = bind;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_buffer_bind(skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_buffer_bind, nullptr, 0);
+	cmd->resource = buffer;
+	cmd->bind     = slot_vc;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_buffer_bind_range(skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_buffer_bind_range, nullptr, 0);
+	cmd->resource = buffer;
+	cmd->bind     = slot_vc;
+	cmd->args[0]  = (int32_t)offset;
+	cmd->args[1]  = (int32_t)size_bytes;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_buffer_clear(skg_cmd_list_t *list, skg_bind_t bind) {
+	skg_cmd_list_push(list, skg_cmd_op_buffer_clear, nullptr, 0)->bind = bind;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_transient_bind(skg_cmd_list_t *list, const void *data, uint32_t size_bytes, skg_bind_t slot_vc) {
+	skg_cmd_list_push(list, skg_cmd_op_transient_bind, data, size_bytes)->bind = slot_vc;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_shader_compute_bind(skg_cmd_list_t *list, const skg_shader_t *shader) {
+	skg_cmd_list_push(list, skg_cmd_op_shader_compute_bind, nullptr, 0)->resource = shader;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_viewport(skg_cmd_list_t *list, const int32_t *xywh) {
+	memcpy(skg_cmd_list_push(list, skg_cmd_op_viewport, nullptr, 0)->args, xywh, sizeof(int32_t) * 4);
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_scissor(skg_cmd_list_t *list, const int32_t *xywh) {
+	memcpy(skg_cmd_list_push(list, skg_cmd_op_scissor, nullptr, 0)->args, xywh, sizeof(int32_t) * 4);
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_draw(skg_cmd_list_t *list, int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_draw, nullptr, 0);
+	cmd->args[0] = index_start;
+	cmd->args[1] = index_base;
+	cmd->args[2] = index_count;
+	cmd->args[3] = instance_count;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_draw_indirect(skg_cmd_list_t *list, const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_draw_indirect, nullptr, 0);
+	cmd->resource = args_buffer;
+	cmd->args[0]  = (int32_t)offset;
+	cmd->args[1]  = (int32_t)draw_count;
+	cmd->args[2]  = (int32_t)stride;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_draw_multi(skg_cmd_list_t *list, const skg_draw_args_t *draws, uint32_t draw_count) {
+	skg_cmd_list_push(list, skg_cmd_op_draw_multi, draws, draw_count * (uint32_t)sizeof(skg_draw_args_t));
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_compute(skg_cmd_list_t *list, uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	skg_cmd_t *cmd = skg_cmd_list_push(list, skg_cmd_op_compute, nullptr, 0);
+	cmd->args[0] = (int32_t)thread_count_x;
+	cmd->args[1] = (int32_t)thread_count_y;
+	cmd->args[2] = (int32_t)thread_count_z;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_execute(const skg_cmd_list_t *list) {
+	SKG_TRACE_FUNC();
+	for (const skg_cmd_block_t *block = list->_first; block != nullptr; block = block->next) {
+		const uint8_t *data = (const uint8_t*)(block + 1);
+		uint32_t       at   = 0;
+		while (at < block->size) {
+			const skg_cmd_t *cmd     = (const skg_cmd_t*)(data + at);
+			const void      *payload = cmd + 1;
+			switch (cmd->op) {
+			case skg_cmd_op_pipeline_bind:       skg_pipeline_bind      ((const skg_pipeline_t*)cmd->resource); break;
+			case skg_cmd_op_mesh_bind:           skg_mesh_bind          ((const skg_mesh_t    *)cmd->resource); break;
+			case skg_cmd_op_tex_bind:            skg_tex_bind           ((const skg_tex_t     *)cmd->resource, cmd->bind); break;
+			case skg_cmd_op_buffer_bind:         skg_buffer_bind        ((const skg_buffer_t  *)cmd->resource, cmd->bind); break;
+			case skg_cmd_op_buffer_bind_range:   skg_buffer_bind_range  ((const skg_buffer_t  *)cmd->resource, cmd->bind, (uint32_t)cmd->args[0], (uint32_t)cmd->args[1]); break;
+			case skg_cmd_op_buffer_clear:        skg_buffer_clear       (cmd->bind); break;
+			case skg_cmd_op_transient_bind:      skg_transient_bind     (payload, cmd->data_size, cmd->bind); break;
+			case skg_cmd_op_shader_compute_bind: skg_shader_compute_bind((const skg_shader_t  *)cmd->resource); break;
+			case skg_cmd_op_viewport:            skg_viewport           (cmd->args); break;
+			case skg_cmd_op_scissor:             skg_scissor            (cmd->args); break;
+			case skg_cmd_op_draw:                skg_draw               (cmd->args[0], cmd->args[1], cmd->args[2], cmd->args[3]); break;
+			case skg_cmd_op_draw_indirect:       skg_draw_indirect      ((const skg_buffer_t  *)cmd->resource, (uint32_t)cmd->args[0], (uint32_t)cmd->args[1], (uint32_t)cmd->args[2]); break;
+			case skg_cmd_op_draw_multi:          skg_draw_multi         ((const skg_draw_args_t*)payload, cmd->data_size / (uint32_t)sizeof(skg_draw_args_t)); break;
+			case skg_cmd_op_compute:             skg_compute            ((uint32_t)cmd->args[0], (uint32_t)cmd->args[1], (uint32_t)cmd->args[2]); break;
+			}
+			at += (uint32_t)sizeof(skg_cmd_t) + ((cmd->data_size + 7) & ~7u);
+		}
+		// Blocks past the current one hold stale commands from before a clear
+		if (block == list->_current) break;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_clear(skg_cmd_list_t *list) {
+	list->_current = list->_first;
+	list->_count   = 0;
+	if (list->_first) list->_first->size = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_cmd_list_destroy(skg_cmd_list_t *list) {
+	skg_cmd_block_t *block = list->_first;
+	while (block != nullptr) {
+		skg_cmd_block_t *next = block->next;
+		free(block);
+		block = next;
+	}
+	*list = {};
 }
\ No newline at end of file
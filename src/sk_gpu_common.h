@@ -24,16 +24,124 @@ typedef struct {
 	skg_shader_file_stage_t *stages;
 } skg_shader_file_t;
 
+#define SKG_VERT_COMPONENT_MAX 8
+
+// A registered vertex layout. Components are placed like the members of the
+// equivalent C struct: each aligned to its own element size, with the stride
+// padded to the largest element.
+typedef struct {
+	skg_vert_component_t components[SKG_VERT_COMPONENT_MAX];
+	uint32_t             offsets   [SKG_VERT_COMPONENT_MAX];
+	int32_t              component_count;
+	uint32_t             stride;
+} skg_vert_fmt_t;
+
+typedef enum {
+	skg_draw_sort_state,         // Fewest state changes, then nearest first
+	skg_draw_sort_back_to_front, // Farthest first, for blended draws
+	skg_draw_sort_none,          // Submission order
+} skg_draw_sort_;
+
+// A draw for skg_draw_queue_add. The texture, buffer and constant lists are
+// copied in, but the resources they point to must live until the queue runs.
+// Pipeline or mesh can be null to draw with whatever is already bound.
+typedef struct {
+	const skg_pipeline_t *pipeline;
+	const skg_mesh_t     *mesh;
+	const skg_tex_t     **textures;
+	const skg_bind_t     *texture_binds;
+	int32_t               texture_count;
+	const skg_buffer_t  **buffers;
+	const skg_bind_t     *buffer_binds;
+	int32_t               buffer_count;
+	const void           *constants; // Optional, bound with skg_transient_bind
+	uint32_t              constants_size;
+	skg_bind_t            constants_bind;
+	int32_t               index_start;
+	int32_t               index_base;
+	int32_t               index_count;
+	int32_t               instance_count;
+	float                 depth;
+} skg_draw_packet_t;
+
+typedef struct {
+	struct skg_draw_item_t *_items;
+	int32_t                 _item_count;
+	int32_t                 _item_cap;
+	struct skg_draw_res_t  *_res;
+	int32_t                 _res_count;
+	int32_t                 _res_cap;
+	uint8_t                *_data;
+	uint32_t                _data_size;
+	uint32_t                _data_cap;
+	struct skg_draw_key_t  *_keys;
+	int32_t                 _key_cap;
+	uint64_t               *_rank_ids;
+	uint32_t               *_rank_vals;
+	uint32_t                _rank_cap;
+} skg_draw_queue_t;
+
+// Recorded commands live in a chain of blocks that are kept and reused
+// after a clear, so a list recorded every frame stops allocating.
+typedef struct {
+	struct skg_cmd_block_t *_first;
+	struct skg_cmd_block_t *_current;
+	int32_t                 _count;
+} skg_cmd_list_t;
+
 ///////////////////////////////////////////
 
 SKG_API void                    skg_log                        (skg_log_ level, const char *text);
 SKG_API void                    skg_logf                       (skg_log_ level, const char *text, ...);
 SKG_API void                    skg_log_enable                 (bool enabled);
 SKG_API bool                    skg_read_file                  (const char *filename, void **out_data, size_t *out_size);
+SKG_API bool                    skg_write_file                 (const char *filename, const void *data, size_t size);
+SKG_API const char*             skg_shader_cache_folder        ();
 SKG_API uint64_t                skg_hash                       (const char *string);
 SKG_API uint32_t                skg_mip_count                  (int32_t width, int32_t height);
 SKG_API void                    skg_mip_dimensions             (int32_t width, int32_t height, int32_t mip_level, int32_t *out_width, int32_t *out_height);
 SKG_API int32_t                 skg_fmt_size                   (skg_fmt_ format);
+SKG_API uint32_t                skg_ind_fmt_size               (skg_ind_fmt_ format);
+SKG_API skg_ind_fmt_            skg_ind_fmt_from_stride        (uint32_t stride);
+// Vertex formats are registered once and referred to by id, id 0 is always
+// the skg_vert_t layout. Returns -1 if the components can't be used.
+SKG_API int32_t                 skg_vert_fmt_register          (const skg_vert_component_t *components, int32_t component_count);
+SKG_API const skg_vert_fmt_t   *skg_vert_fmt_get               (int32_t id);
+SKG_API int32_t                 skg_vert_fmt_find              (const skg_vert_fmt_t *format, skg_semantic_ semantic, uint8_t semantic_slot);
+SKG_API void                    skg_vert_fmt_clear             ();
+// Draws added to a queue run on skg_draw_queue_execute, reordered so that
+// draws sharing a shader, textures and mesh are next to each other. They go
+// through the regular bind and draw calls, so whatever the last draw bound
+// stays bound. Executing leaves the queue's draws in place until cleared.
+SKG_API skg_draw_queue_t        skg_draw_queue_create          ();
+SKG_API void                    skg_draw_queue_add             (skg_draw_queue_t *queue, const skg_draw_packet_t *packet);
+SKG_API void                    skg_draw_queue_execute         (skg_draw_queue_t *queue, skg_draw_sort_ sort);
+SKG_API void                    skg_draw_queue_clear           (skg_draw_queue_t *queue);
+SKG_API void                    skg_draw_queue_destroy         (skg_draw_queue_t *queue);
+// Command lists record the same bind and draw calls as the immediate API,
+// on any thread, and skg_cmd_list_execute replays them in order on the
+// render thread. Data like transient constants and draw args is copied in,
+// but resources are kept by pointer and must live until the list runs. A
+// list can be executed more than once, and only one thread may record into
+// it at a time.
+SKG_API skg_cmd_list_t          skg_cmd_list_create            ();
+SKG_API void                    skg_cmd_list_pipeline_bind     (skg_cmd_list_t *list, const skg_pipeline_t *pipeline);
+SKG_API void                    skg_cmd_list_mesh_bind         (skg_cmd_list_t *list, const skg_mesh_t *mesh);
+SKG_API void                    skg_cmd_list_tex_bind          (skg_cmd_list_t *list, const skg_tex_t *texture, skg_bind_t bind);
+SKG_API void                    skg_cmd_list_buffer_bind       (skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc);
+SKG_API void                    skg_cmd_list_buffer_bind_range (skg_cmd_list_t *list, const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes);
+SKG_API void                    skg_cmd_list_buffer_clear      (skg_cmd_list_t *list, skg_bind_t bind);
+SKG_API void                    skg_cmd_list_transient_bind    (skg_cmd_list_t *list, const void *data, uint32_t size_bytes, skg_bind_t slot_vc);
+SKG_API void                    skg_cmd_list_shader_compute_bind(skg_cmd_list_t *list, const skg_shader_t *shader);
+SKG_API void                    skg_cmd_list_viewport          (skg_cmd_list_t *list, const int32_t *xywh);
+SKG_API void                    skg_cmd_list_scissor           (skg_cmd_list_t *list, const int32_t *xywh);
+SKG_API void                    skg_cmd_list_draw              (skg_cmd_list_t *list, int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count);
+SKG_API void                    skg_cmd_list_draw_indirect     (skg_cmd_list_t *list, const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride);
+SKG_API void                    skg_cmd_list_draw_multi        (skg_cmd_list_t *list, const skg_draw_args_t *draws, uint32_t draw_count);
+SKG_API void                    skg_cmd_list_compute           (skg_cmd_list_t *list, uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z);
+SKG_API void                    skg_cmd_list_execute           (const skg_cmd_list_t *list);
+SKG_API void                    skg_cmd_list_clear             (skg_cmd_list_t *list);
+SKG_API void                    skg_cmd_list_destroy           (skg_cmd_list_t *list);
 
 SKG_API skg_color32_t           skg_col_hsv32                  (float hue, float saturation, float value, float alpha);
 SKG_API skg_color128_t          skg_col_hsv128                 (float hue, float saturation, float value, float alpha);
@@ -67,4 +175,313 @@ SKG_API int32_t                 skg_shader_meta_get_var_index  (const skg_shader
 SKG_API int32_t                 skg_shader_meta_get_var_index_h(const skg_shader_meta_t *meta, uint64_t name_hash);
 SKG_API const skg_shader_var_t *skg_shader_meta_get_var_info   (const skg_shader_meta_t *meta, int32_t var_index);
 SKG_API void                    skg_shader_meta_reference      (skg_shader_meta_t *meta);
-SKG_API void                    skg_shader_meta_release        (skg_shader_meta_t *meta);
\ No newline at end of file
+SKG_API void                    skg_shader_meta_release        (skg_shader_meta_t *meta);
+
+///////////////////////////////////////////
+// Capture file format                   //
+///////////////////////////////////////////
+
+// skg_capture_start writes a small header, followed by a stream of records.
+// Each record is a skg_capture_record_t, then `size` bytes of payload. The
+// payload starts with the op's struct below, and any trailing bytes are the
+// raw data that came along with the call (buffer contents, texture pixels,
+// .sks shader files, event names). Resources are identified by a 64 bit id
+// that's unique while the resource is alive, but may be reused after it's
+// destroyed.
+
+#define SKG_CAPTURE_MAGIC   0x43474B53 // "SKGC"
+#define SKG_CAPTURE_VERSION 1
+
+typedef enum skg_capture_op_ {
+	skg_capture_op_frame = 1,
+	skg_capture_op_draw,
+	skg_capture_op_compute,
+	skg_capture_op_viewport,
+	skg_capture_op_scissor,
+	skg_capture_op_target_clear,
+	skg_capture_op_event_begin,
+	skg_capture_op_event_end,
+	skg_capture_op_buffer_create,
+	skg_capture_op_buffer_set_contents,
+	skg_capture_op_buffer_bind,
+	skg_capture_op_buffer_clear,
+	skg_capture_op_buffer_destroy,
+	skg_capture_op_mesh_bind,
+	skg_capture_op_shader_create,
+	skg_capture_op_shader_compute_bind,
+	skg_capture_op_shader_destroy,
+	skg_capture_op_pipeline_bind,
+	skg_capture_op_tex_create,
+	skg_capture_op_tex_create_existing,
+	skg_capture_op_tex_settings,
+	skg_capture_op_tex_set_contents,
+	skg_capture_op_tex_attach_depth,
+	skg_capture_op_tex_copy_to,
+	skg_capture_op_tex_gen_mips,
+	skg_capture_op_tex_bind,
+	skg_capture_op_tex_clear,
+	skg_capture_op_tex_target_bind,
+	skg_capture_op_tex_target_discard,
+	skg_capture_op_tex_destroy,
+	skg_capture_op_buffer_bind_range,
+	skg_capture_op_transient_bind,
+	skg_capture_op_buffer_set_range,
+	skg_capture_op_draw_indirect,
+	skg_capture_op_draw_multi,
+	skg_capture_op_max,
+} skg_capture_op_;
+
+typedef struct skg_capture_header_t {
+	uint32_t magic;
+	uint32_t version;
+} skg_capture_header_t;
+
+typedef struct skg_capture_record_t {
+	uint32_t op;
+	uint32_t size;
+} skg_capture_record_t;
+
+// skg_capture_op_draw
+typedef struct skg_capture_draw_t {
+	int32_t  index_start;
+	int32_t  index_base;
+	int32_t  index_count;
+	int32_t  instance_count;
+} skg_capture_draw_t;
+
+// skg_capture_op_draw_indirect
+typedef struct skg_capture_draw_indirect_t {
+	uint64_t id;
+	uint32_t offset;
+	uint32_t draw_count;
+	uint32_t stride;
+	uint32_t _pad;
+} skg_capture_draw_indirect_t;
+
+// skg_capture_op_draw_multi, followed by draw_count skg_draw_args_t
+typedef struct skg_capture_draw_multi_t {
+	uint32_t draw_count;
+} skg_capture_draw_multi_t;
+
+// skg_capture_op_compute
+typedef struct skg_capture_compute_t {
+	uint32_t thread_count[3];
+} skg_capture_compute_t;
+
+// skg_capture_op_viewport, skg_capture_op_scissor
+typedef struct skg_capture_rect_t {
+	int32_t  xywh[4];
+} skg_capture_rect_t;
+
+// skg_capture_op_target_clear
+typedef struct skg_capture_clear_t {
+	uint32_t depth;
+	uint32_t has_color;
+	float    color[4];
+} skg_capture_clear_t;
+
+// skg_capture_op_buffer_create, followed by size_count*size_stride bytes if
+// has_data is set.
+typedef struct skg_capture_buffer_t {
+	uint64_t id;
+	uint32_t size_count;
+	uint32_t size_stride;
+	int32_t  type;
+	int32_t  use;
+	uint32_t has_data;
+	uint32_t _pad;
+} skg_capture_buffer_t;
+
+// skg_capture_op_buffer_set_contents, skg_capture_op_buffer_destroy,
+// skg_capture_op_shader_create (followed by the .sks file),
+// skg_capture_op_shader_compute_bind, skg_capture_op_shader_destroy,
+// skg_capture_op_tex_gen_mips, skg_capture_op_tex_target_discard,
+// skg_capture_op_tex_destroy
+typedef struct skg_capture_id_t {
+	uint64_t id;
+} skg_capture_id_t;
+
+// skg_capture_op_buffer_bind, skg_capture_op_buffer_clear,
+// skg_capture_op_tex_bind, skg_capture_op_tex_clear
+typedef struct skg_capture_bind_t {
+	uint64_t id;
+	uint32_t slot;
+	uint32_t stage_bits;
+	uint32_t register_type;
+	uint32_t _pad;
+} skg_capture_bind_t;
+
+// skg_capture_op_buffer_bind_range, skg_capture_op_transient_bind. Transient
+// binds have no id, and are followed by size bytes of constant data.
+typedef struct skg_capture_bind_range_t {
+	uint64_t id;
+	uint32_t slot;
+	uint32_t stage_bits;
+	uint32_t register_type;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t _pad;
+} skg_capture_bind_range_t;
+
+// skg_capture_op_buffer_set_range, followed by size bytes of data.
+typedef struct skg_capture_buffer_range_t {
+	uint64_t id;
+	uint32_t offset;
+	uint32_t size;
+} skg_capture_buffer_range_t;
+
+// skg_capture_op_mesh_bind, followed by the mesh's skg_vert_component_t
+// list when it doesn't use the skg_vert_t layout.
+typedef struct skg_capture_mesh_t {
+	uint64_t vert_id;
+	uint64_t ind_id;
+} skg_capture_mesh_t;
+
+// skg_capture_op_pipeline_bind, pipelines are captured as the full state at
+// bind time, rather than as objects.
+typedef struct skg_capture_pipeline_t {
+	uint64_t shader_id;
+	int32_t  transparency;
+	int32_t  cull;
+	int32_t  color_write;
+	int32_t  depth_test;
+	uint32_t wireframe;
+	uint32_t depth_write;
+	uint32_t depth_clip;
+	uint32_t scissor;
+} skg_capture_pipeline_t;
+
+// skg_capture_op_tex_create, skg_capture_op_tex_create_existing. Textures
+// created from a native texture are replayed as regular textures, since the
+// native texture won't exist at replay time.
+typedef struct skg_capture_tex_t {
+	uint64_t id;
+	int32_t  type;
+	int32_t  use;
+	int32_t  format;
+	int32_t  mips;
+	int32_t  width;
+	int32_t  height;
+	int32_t  array_count;
+	int32_t  multisample;
+} skg_capture_tex_t;
+
+// skg_capture_op_tex_settings
+typedef struct skg_capture_tex_settings_t {
+	uint64_t id;
+	int32_t  address;
+	int32_t  sample;
+	int32_t  compare;
+	int32_t  anisotropy;
+} skg_capture_tex_settings_t;
+
+// skg_capture_op_tex_set_contents, followed by array_count tightly packed
+// arrays of mip_count mips each, if has_data is set.
+typedef struct skg_capture_tex_contents_t {
+	uint64_t id;
+	int32_t  array_count;
+	int32_t  mip_count;
+	int32_t  width;
+	int32_t  height;
+	int32_t  multisample;
+	uint32_t has_data;
+} skg_capture_tex_contents_t;
+
+// skg_capture_op_tex_attach_depth, skg_capture_op_tex_copy_to
+typedef struct skg_capture_tex_pair_t {
+	uint64_t id;
+	uint64_t other_id;
+	int32_t  surface;
+	int32_t  other_surface;
+} skg_capture_tex_pair_t;
+
+// skg_capture_op_tex_target_bind, an id of 0 binds no target.
+typedef struct skg_capture_target_t {
+	uint64_t id;
+	int32_t  layer_idx;
+	int32_t  mip_level;
+} skg_capture_target_t;
+
+///////////////////////////////////////////
+
+// Used by the backends to record skg_stats_t data.
+extern skg_stats_t _skg_stats;
+#define SKG_STAT_HIT(stat)   (_skg_stats.cache_hits  [stat] += 1)
+#define SKG_STAT_MISS(stat)  (_skg_stats.cache_misses[stat] += 1)
+// Safe to call from upload threads, unlike the macros above.
+void        skg_stats_upload               (int64_t bytes);
+
+// Used by the backends to feed skg_mem_get. Keys come from the backend's
+// skg_mem_key overloads, and must stay unique while the resource is alive.
+// Tracking 0 bytes drops that category from the allocation. Names only
+// stick to keys that are being tracked, skg_mem_add starts tracking one
+// before it has any memory.
+uint64_t    skg_mem_key                    (const skg_buffer_t *buffer);
+uint64_t    skg_mem_key                    (const skg_tex_t    *tex);
+void        skg_mem_track                  (uint64_t key, skg_mem_ type, int64_t bytes);
+void        skg_mem_track_tex              (uint64_t key, const skg_tex_t *tex, int32_t mip_count, int32_t physical_multisample);
+void        skg_mem_add                    (uint64_t key);
+void        skg_mem_release                (uint64_t key);
+void        skg_mem_name                   (uint64_t key, const char *name);
+
+// Used by the backends to time their work for skg_trace_start. These scopes
+// record from construction until they go out of scope.
+#if defined(SKG_TRACE)
+extern bool _skg_trace_active;
+int64_t     skg_trace_now    ();
+void        skg_trace_record (const char *name, const char *detail, int64_t start_ns, int64_t end_ns);
+
+typedef struct skg_trace_scope_t {
+	const char *name;
+	const char *detail;
+	int64_t     start;
+	skg_trace_scope_t(const char *name, const char *detail = nullptr) : name(name), detail(detail), start(_skg_trace_active ? skg_trace_now() : -1) {}
+	~skg_trace_scope_t() { if (start >= 0) skg_trace_record(name, detail, start, skg_trace_now()); }
+} skg_trace_scope_t;
+
+#define SKG_TRACE_SCOPE(name)                skg_trace_scope_t _skg_trace_scope  (name)
+#define SKG_TRACE_SCOPE_DETAIL(name, detail) skg_trace_scope_t _skg_trace_scope_d(name, detail)
+#define SKG_TRACE_FUNC()                     skg_trace_scope_t _skg_trace_func   (__func__)
+#else
+#define SKG_TRACE_SCOPE(name)
+#define SKG_TRACE_SCOPE_DETAIL(name, detail)
+#define SKG_TRACE_FUNC()
+#endif
+
+// Used by the backends to feed skg_capture_start. Each backend provides the
+// skg_capture_id overloads, and should wrap capture calls in SKG_CAPTURE_CALL so
+// they cost nothing when capture isn't compiled in or running.
+#if defined(SKG_CAPTURE)
+extern bool _skg_capture_active;
+uint64_t    skg_capture_id                 (const skg_buffer_t *buffer);
+uint64_t    skg_capture_id                 (const skg_shader_t *shader);
+uint64_t    skg_capture_id                 (const skg_tex_t    *tex);
+
+void        skg_capture_frame              ();
+void        skg_capture_draw               (int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count);
+void        skg_capture_draw_indirect      (const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride);
+void        skg_capture_draw_multi         (const skg_draw_args_t *draws, uint32_t draw_count);
+void        skg_capture_compute            (uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z);
+void        skg_capture_rect               (skg_capture_op_ op, const int32_t *xywh);
+void        skg_capture_target_clear       (bool depth, const float *clear_color_4);
+void        skg_capture_event_begin        (const char *name);
+void        skg_capture_event_end          ();
+void        skg_capture_buffer_create      (const skg_buffer_t *buffer, const void *data, uint32_t size_count, uint32_t size_stride);
+void        skg_capture_buffer_set_contents(const skg_buffer_t *buffer, const void *data, uint32_t size_bytes);
+void        skg_capture_buffer_set_range   (const skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes);
+void        skg_capture_bind               (skg_capture_op_ op, uint64_t id, skg_bind_t bind);
+void        skg_capture_bind_range         (skg_capture_op_ op, uint64_t id, skg_bind_t bind, uint32_t offset, uint32_t size, const void *data);
+void        skg_capture_mesh_bind          (uint64_t vert_id, uint64_t ind_id, int32_t vert_fmt);
+void        skg_capture_shader_create      (const skg_shader_t *shader, const void *sks_data, size_t sks_data_size);
+void        skg_capture_pipeline_bind      (const skg_pipeline_t *pipeline, uint64_t shader_id);
+void        skg_capture_tex_create         (skg_capture_op_ op, const skg_tex_t *tex);
+void        skg_capture_tex_settings       (const skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy);
+void        skg_capture_tex_set_contents   (const skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample);
+void        skg_capture_tex_pair           (skg_capture_op_ op, uint64_t id, int32_t surface, uint64_t other_id, int32_t other_surface);
+void        skg_capture_tex_target_bind    (uint64_t id, int32_t layer_idx, int32_t mip_level);
+void        skg_capture_id_op              (skg_capture_op_ op, uint64_t id);
+
+#define SKG_CAPTURE_CALL(call) if (_skg_capture_active) { call; }
+#else
+#define SKG_CAPTURE_CALL(call)
+#endif
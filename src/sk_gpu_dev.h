@@ -31,6 +31,29 @@ sk_gpu.h
 // optimization for clearer debug information.
 //#define SKG_GL_EXPLICIT_STATE
 
+// On Linux, sk_gpu uses desktop GL through GLX by default. Define this to use
+// GLES through EGL instead. With EGL, if the DISPLAY environment variable is
+// empty, sk_gpu runs headless and never touches an X server: it renders on
+// the first EGL device that initializes (EGL_EXT_platform_device), or through
+// EGL_MESA_platform_surfaceless. Headless apps render into skg_tex_t render
+// targets, and skg_swapchain_create accepts a null window to make an
+// offscreen pbuffer swapchain of the requested size.
+//#define SKG_LINUX_EGL
+
+// sk_gpu can record a CPU trace of every skg_ call, along with the backend
+// work hiding inside them like shader compiles and texture uploads. Define
+// this, then use skg_trace_start/skg_trace_stop to write a Chrome trace-event
+// JSON file that can be opened in Perfetto or chrome://tracing.
+//#define SKG_TRACE
+
+// sk_gpu can also capture the stream of skg_ calls, along with the data that
+// goes with them, to a compact binary file. Define this, then use
+// skg_capture_start/skg_capture_stop around the frames you want. The
+// sk_gpu_replay example can play these files back against any backend. Only
+// resources created while the capture is running make it into the file, so
+// start capturing before loading the assets your frames need.
+//#define SKG_CAPTURE
+
 #if   defined( SKG_FORCE_NULL )
 #define SKG_NULL
 #elif defined( SKG_FORCE_DIRECT3D11 )
@@ -94,6 +117,7 @@ typedef enum skg_buffer_type_ {
 	skg_buffer_type_index,
 	skg_buffer_type_constant,
 	skg_buffer_type_compute,
+	skg_buffer_type_indirect,
 } skg_buffer_type_;
 
 typedef enum skg_tex_type_ {
@@ -284,9 +308,37 @@ typedef enum skg_cap_ {
 	skg_cap_fmt_atc,
 	skg_cap_multiview,
 	skg_cap_multiview_tiled_multisample,
+	skg_cap_gpu_timer,
 	skg_cap_max,
 } skg_cap_;
 
+// Categories of GPU state that the backends track for skg_stats_t's cache
+// hit/miss counters. Backends without a state cache report every change as
+// a miss.
+typedef enum skg_stat_ {
+	skg_stat_program,
+	skg_stat_blend,   // Transparency and color write mask
+	skg_stat_cull,    // Cull mode, plus scissor and wireframe
+	skg_stat_depth,   // Depth test, write, and clip
+	skg_stat_texture,
+	skg_stat_buffer,
+	skg_stat_layout,  // Vertex array objects, or input layouts
+	skg_stat_sampler,
+	skg_stat_max,
+} skg_stat_;
+
+// Categories of GPU memory that skg_mem_get tracks. Each allocation only
+// counts towards one category, so they add up to the total.
+typedef enum skg_mem_ {
+	skg_mem_buffer,
+	skg_mem_tex_image,
+	skg_mem_tex_rendertarget,
+	skg_mem_tex_depth,       // Both zbuffer and depthtarget textures
+	skg_mem_msaa,            // Multisample textures, counting every sample
+	skg_mem_framebuffer,     // Implicit multisample surfaces behind tiled MSAA framebuffer layers
+	skg_mem_max,
+} skg_mem_;
+
 typedef struct {
 	uint8_t r, g, b, a;
 } skg_color32_t;
@@ -341,6 +393,17 @@ typedef struct skg_vert_t {
 	skg_color32_t col;
 } skg_vert_t;
 
+// Laid out to match both GL's DrawElementsIndirectCommand and D3D11's
+// DrawIndexedInstancedIndirect args, so compute shaders can write these
+// straight into a skg_buffer_type_indirect buffer.
+typedef struct skg_draw_args_t {
+	uint32_t index_count;
+	uint32_t instance_count;
+	uint32_t index_start;
+	int32_t  index_base;
+	uint32_t instance_start;
+} skg_draw_args_t;
+
 typedef struct skg_bind_t {
 	uint16_t slot;
 	uint8_t  stage_bits;
@@ -381,6 +444,35 @@ typedef struct skg_shader_ops_t {
 	int32_t dynamic_flow;
 } skg_shader_ops_t;
 
+typedef struct skg_stats_t {
+	int32_t cache_hits  [skg_stat_max];
+	int32_t cache_misses[skg_stat_max];
+	int32_t draws;
+	int32_t dispatches;
+	int64_t upload_bytes;
+} skg_stats_t;
+
+typedef struct skg_mem_stats_t {
+	int64_t bytes      [skg_mem_max];
+	int64_t peak_bytes [skg_mem_max];
+	int32_t allocations[skg_mem_max];
+	int64_t total_bytes;
+	int64_t total_peak_bytes;
+} skg_mem_stats_t;
+
+typedef struct skg_mem_allocation_t {
+	char     name[32];
+	skg_mem_ type;
+	int64_t  bytes;
+} skg_mem_allocation_t;
+
+typedef struct skg_timer_result_t {
+	char     name[32];
+	int32_t  depth;
+	uint64_t frame;
+	uint64_t duration_ns;
+} skg_timer_result_t;
+
 typedef struct skg_shader_meta_t {
 	char                   name[256];
 	uint32_t               buffer_count;
@@ -417,14 +509,64 @@ SKG_API const char*         skg_adapter_name             ();
 SKG_API void                skg_shutdown                 ();
 SKG_API void                skg_callback_log             (void (*callback)(skg_log_ level, const char *text));
 SKG_API void                skg_callback_file_read       (bool (*callback)(const char *filename, void **out_data, size_t *out_size));
+SKG_API void                skg_callback_file_write      (bool (*callback)(const char *filename, const void *data, size_t size));
 SKG_API skg_platform_data_t skg_get_platform_data        ();
 SKG_API bool                skg_capability               (skg_cap_ capability);
+// Wrap buffer and texture creation on a worker thread with these. On GL
+// they make a shared context current, and end waits for the GPU to finish
+// the uploads before the resources go back to the render thread. One worker
+// holds the context at a time. Meshes, render targets, and updates to
+// dynamic buffers still need the render thread. Returns false if this
+// thread can't upload.
+SKG_API bool                skg_upload_thread_begin      ();
+SKG_API void                skg_upload_thread_end        ();
+// With deferred destruction on, skg_buffer_destroy, skg_tex_destroy and
+// skg_shader_destroy can be called from any thread, and the GPU objects are
+// released on a later skg_draw_begin, once the GPU has finished the frame
+// they were destroyed in. Off by default.
+SKG_API void                skg_deferred_destroy_enable  (bool enabled);
+// Stats accumulate until skg_stats_reset is called, so call it once a frame
+// for per-frame numbers.
+SKG_API skg_stats_t         skg_stats_get                ();
+SKG_API void                skg_stats_reset              ();
+// Memory is estimated from the size and format of each resource sk_gpu
+// allocates, textures made from native handles aren't counted. Peaks are
+// high-water marks since init, or since the last skg_mem_reset_peaks.
+// skg_mem_get_allocations fills out_allocations largest first, named with
+// skg_buffer_name or skg_tex_name, and returns how many it wrote. Pass
+// nullptr to get the total number of live allocations.
+SKG_API skg_mem_stats_t     skg_mem_get                  ();
+SKG_API void                skg_mem_reset_peaks          ();
+SKG_API int32_t             skg_mem_get_allocations      (skg_mem_allocation_t *out_allocations, int32_t max_allocations);
 
 SKG_API void                skg_event_begin              (const char *name);
 SKG_API void                skg_event_end                ();
+// GPU timers nest, and their results show up in skg_timer_get_results a few
+// frames after they're recorded, once the GPU has caught up. Reading them
+// never waits on the GPU. Check skg_cap_gpu_timer for support.
+SKG_API void                skg_timer_begin              (const char *name);
+SKG_API void                skg_timer_end                ();
+SKG_API int32_t             skg_timer_get_results        (skg_timer_result_t *out_results, int32_t max_results);
+// Requires SKG_TRACE, see the top of this file.
+SKG_API bool                skg_trace_start              (const char *filename);
+SKG_API void                skg_trace_stop               ();
+// Requires SKG_CAPTURE, see the top of this file.
+SKG_API bool                skg_capture_start            (const char *filename);
+SKG_API void                skg_capture_stop             ();
 
 SKG_API void                skg_draw_begin               ();
 SKG_API void                skg_draw                     (int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count);
+// Draws the bound mesh once for each skg_draw_args_t in a
+// skg_buffer_type_indirect buffer, starting offset bytes in. A stride of 0
+// means tightly packed, and offset and stride must be multiples of 4. Args
+// written by skg_compute are picked up without any extra sync. Where the GPU
+// can't draw indirectly (WebGL, GLES 3.0), the args are read back and looped
+// on the CPU, which stalls.
+SKG_API void                skg_draw_indirect            (const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride);
+// Submits a list of draws for the bound mesh as one call where the API
+// allows it, and as a CPU loop otherwise. instance_start is ignored by the
+// CPU loop on GL.
+SKG_API void                skg_draw_multi               (const skg_draw_args_t *draws, uint32_t draw_count);
 SKG_API void                skg_compute                  (uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z);
 SKG_API void                skg_viewport                 (const int32_t *xywh);
 SKG_API void                skg_viewport_get             (int32_t *out_xywh);
@@ -435,8 +577,28 @@ SKG_API skg_buffer_t        skg_buffer_create            (const void *data, uint
 SKG_API void                skg_buffer_name              (      skg_buffer_t *buffer, const char* name);
 SKG_API bool                skg_buffer_is_valid          (const skg_buffer_t *buffer);
 SKG_API void                skg_buffer_set_contents      (      skg_buffer_t *buffer, const void *data, uint32_t size_bytes);
+// Writes part of a dynamic buffer. Writes are batched rather than sent right
+// away, and go up by the next draw or dispatch, whether or not the buffer is
+// already bound. Many small writes between draws cost only one upload per
+// contiguous run of changed bytes.
+SKG_API void                skg_buffer_set_contents_range(      skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes);
 SKG_API void                skg_buffer_get_contents      (const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size);
+// Like skg_tex_read_async, but copies the whole buffer, and leaves the
+// readback's format as skg_tex_fmt_none. Collect it with skg_readback_poll
+// and skg_readback_map.
+SKG_API bool                skg_buffer_read_async        (const skg_buffer_t *buffer, skg_readback_t *ref_readback);
 SKG_API void                skg_buffer_bind              (const skg_buffer_t *buffer, skg_bind_t slot_vc);
+// Binds only part of a constant or compute buffer, so many small blocks can
+// share one buffer. offset must be a multiple of skg_buffer_range_align.
+SKG_API void                skg_buffer_bind_range        (const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes);
+SKG_API uint32_t            skg_buffer_range_align       (skg_buffer_type_ type);
+// Copies a block of constants into a shared per-frame buffer, and binds just
+// that range. This saves a constant buffer per object for data that changes
+// every draw. The copy is only valid until the next skg_draw_begin, and
+// size_bytes should cover the whole cbuffer the shader expects. Each
+// skg_draw_begin recycles this memory. Apps that don't call it still work,
+// but reuse memory only once the GPU is done with it, and may wait for it.
+SKG_API bool                skg_transient_bind           (const void *data, uint32_t size_bytes, skg_bind_t slot_vc);
 SKG_API void                skg_buffer_clear             (      skg_bind_t bind);
 SKG_API void                skg_buffer_destroy           (      skg_buffer_t *buffer);
 
@@ -444,17 +606,30 @@ SKG_API skg_mesh_t          skg_mesh_create              (const skg_buffer_t *ve
 SKG_API void                skg_mesh_name                (      skg_mesh_t *mesh, const char* name);
 SKG_API void                skg_mesh_set_verts           (      skg_mesh_t *mesh, const skg_buffer_t *vert_buffer);
 SKG_API void                skg_mesh_set_inds            (      skg_mesh_t *mesh, const skg_buffer_t *ind_buffer);
+// Describes the vertex buffer's layout, so meshes don't need the full 36
+// byte skg_vert_t. Components are laid out like a C struct with the same
+// members, and are matched to the shader's inputs by semantic. Shader inputs
+// the mesh lacks read as 1s. A null list goes back to skg_vert_t.
+SKG_API void                skg_mesh_set_format          (      skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count);
 SKG_API void                skg_mesh_bind                (const skg_mesh_t *mesh);
 SKG_API void                skg_mesh_destroy             (      skg_mesh_t *mesh);
 
 SKG_API skg_shader_stage_t  skg_shader_stage_create      (const void *shader_data, size_t shader_size, skg_stage_ type);
 SKG_API void                skg_shader_stage_destroy     (skg_shader_stage_t *stage);
+// Where GL program binaries are cached between runs, files are read and
+// written through skg_callback_file_read/write. Null disables the cache,
+// which is the default. Backends without program binaries ignore this.
+SKG_API void                skg_shader_cache_set_folder  (const char *folder);
 
 SKG_API skg_shader_t        skg_shader_create_file       (const char *sks_filename);
 SKG_API skg_shader_t        skg_shader_create_memory     (const void *sks_memory, size_t sks_memory_size);
 SKG_API skg_shader_t        skg_shader_create_manual     (skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader);
 SKG_API void                skg_shader_name              (      skg_shader_t *shader, const char* name);
 SKG_API bool                skg_shader_is_valid          (const skg_shader_t *shader);
+// False while the driver is still compiling the shader in the background,
+// so a fallback can be drawn instead. Using a shader that isn't ready, or
+// asking if it's valid, waits for it to finish.
+SKG_API bool                skg_shader_is_ready          (const skg_shader_t *shader);
 SKG_API void                skg_shader_compute_bind      (const skg_shader_t *shader);
 SKG_API skg_bind_t          skg_shader_get_bind          (const skg_shader_t *shader, const char *name);
 SKG_API int32_t             skg_shader_get_var_count     (const skg_shader_t *shader);
@@ -505,6 +680,16 @@ SKG_API bool                skg_tex_get_contents         (      skg_tex_t *tex,
 SKG_API bool                skg_tex_get_mip_contents     (      skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size);
 SKG_API bool                skg_tex_get_mip_contents_arr (      skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size);
 SKG_API bool                skg_tex_gen_mips             (      skg_tex_t *tex);
+// skg_tex_read_async queues a copy of one mip and array slice into CPU
+// readable memory without waiting on the GPU. skg_readback_poll reports when
+// the copy has landed, usually a frame or two later, and skg_readback_map
+// then returns the tightly packed pixels. Mapping before the readback is
+// ready will wait on the GPU. Handing a readback back to skg_tex_read_async
+// reuses its memory, and invalidates anything previously mapped from it.
+SKG_API bool                skg_tex_read_async           (const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback);
+SKG_API bool                skg_readback_poll            (      skg_readback_t *readback);
+SKG_API const void*         skg_readback_map             (      skg_readback_t *readback, size_t *out_size);
+SKG_API void                skg_readback_destroy         (      skg_readback_t *readback);
 SKG_API void*               skg_tex_get_native           (const skg_tex_t *tex);
 SKG_API void                skg_tex_bind                 (const skg_tex_t *tex, skg_bind_t bind);
 SKG_API void                skg_tex_clear                (skg_bind_t bind);
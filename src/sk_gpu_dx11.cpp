@@ -12,6 +12,7 @@
 #endif
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <dxgi1_6.h>
 
 #if !defined(SKG_NO_D3DCOMPILER)
@@ -24,6 +25,10 @@
 
 // Manually defining this lets us skip d3dcommon.h and dxguid.lib
 const GUID WKPDID_D3DDebugObjectName = { 0x429b8c22, 0x9188, 0x4b0c, { 0x87,0x42,0xac,0xb0,0xbf,0x85,0xc2,0x00 } };
+// Private data on vertex shaders: their bytecode, and the input layouts built
+// for each vertex format, with the format id in the last byte.
+const GUID d3d_guid_vs_bytecode = { 0x6d3c1e2a, 0x5b7f, 0x4c61, { 0x9a,0x0e,0x31,0xd4,0x7c,0x28,0x45,0x00 } };
+const GUID d3d_guid_vs_layout   = { 0x6d3c1e2b, 0x5b7f, 0x4c61, { 0x9a,0x0e,0x31,0xd4,0x7c,0x28,0x46,0x00 } };
 
 ///////////////////////////////////////////
 
@@ -35,22 +40,98 @@ ID3D11DepthStencilState *d3d_depthstate  = nullptr;
 skg_tex_t               *d3d_active_rendertarget = nullptr;
 int32_t                  d3d_active_rendertarget_layer = 0;
 char                    *d3d_adapter_name = nullptr;
+uint32_t                 d3d_tex_next_id  = 1;
 
 ID3D11DeviceContext     *d3d_deferred    = nullptr;
 HANDLE                   d3d_deferred_mtx= nullptr;
 DWORD                    d3d_main_thread = 0;
 
 #if defined(_DEBUG)
-#include <d3d11_1.h>
 ID3DUserDefinedAnnotation *d3d_annotate = nullptr;
 #endif
 
+// Constant buffer offsets need 11.1's context, and an OS that supports them
+ID3D11DeviceContext1    *d3d_context1        = nullptr;
+bool                     d3d_cb_offsetting   = false;
+bool                     d3d_cb_no_overwrite = false;
+
+#define SKG_D3D_TRANSIENT_MIN (64 * 1024)
+
+// A dynamic constant buffer that's filled front to back with
+// WRITE_NO_OVERWRITE, and renamed with WRITE_DISCARD when it runs out.
+typedef struct d3d_transient_t {
+	ID3D11Buffer *buffer;
+	uint32_t      size;
+	uint32_t      used;
+} d3d_transient_t;
+d3d_transient_t          d3d_transient       = {};
+
+// Dynamic D3D11 buffers can only be written by discarding the whole thing,
+// so ranged writes collect in a full CPU copy, and go up in one Map when the
+// buffer is next used.
+typedef struct d3d_buffer_dirty_t {
+	ID3D11Buffer *buffer;
+	uint8_t      *shadow;
+	uint32_t      size;
+	bool          dirty;
+	bool          queued;
+} d3d_buffer_dirty_t;
+
+// Buffers with pending ranged writes. Bound buffers can be written to
+// after the bind, so the queue is flushed before each draw and dispatch.
+d3d_buffer_dirty_t **d3d_dirty_queue       = nullptr;
+int32_t              d3d_dirty_queue_count = 0;
+int32_t              d3d_dirty_queue_cap   = 0;
+
+// Input layouts depend on both the vertex shader and the mesh's format, so
+// they're picked at draw time once both are known.
+ID3D11VertexShader  *d3d_layout_vs      = nullptr;
+ID3D11InputLayout   *d3d_layout_default = nullptr;
+ID3D11InputLayout   *d3d_layout_curr    = nullptr;
+skg_shader_meta_t   *d3d_layout_meta    = nullptr;
+int32_t              d3d_layout_fmt     = 0;
+bool                 d3d_layout_dirty   = false;
+// Zero stride vertex buffer of 1s, for shader inputs a mesh doesn't have
+ID3D11Buffer        *d3d_layout_ones    = nullptr;
+
+#define SKG_D3D_TIMER_COUNT  256
+#define SKG_D3D_TIMER_DEPTH  16
+#define SKG_D3D_TIMER_FRAMES 8
+
+typedef struct d3d_timer_t {
+	char         name[32];
+	int32_t      depth;
+	uint64_t     frame;
+	ID3D11Query *queries[2];
+	bool         ended;
+} d3d_timer_t;
+
+d3d_timer_t         d3d_timers       [SKG_D3D_TIMER_COUNT];
+skg_timer_result_t  d3d_timer_results[SKG_D3D_TIMER_COUNT];
+ID3D11Query        *d3d_timer_disjoint[SKG_D3D_TIMER_FRAMES];
+bool                d3d_timer_disjoint_active = false;
+int32_t             d3d_timer_result_count    = 0;
+uint32_t            d3d_timer_head            = 0;
+uint32_t            d3d_timer_tail            = 0;
+int32_t             d3d_timer_stack[SKG_D3D_TIMER_DEPTH];
+int32_t             d3d_timer_stack_count     = 0;
+uint64_t            d3d_frame                 = 0;
+
 ///////////////////////////////////////////
 
 bool        skg_tex_make_view    (skg_tex_t *tex, uint32_t mip_count, uint32_t array_start, bool use_in_shader);
 DXGI_FORMAT skg_ind_to_dxgi      (skg_ind_fmt_ format);
+DXGI_FORMAT skg_fmt_to_dxgi      (skg_fmt_ format, uint8_t count);
+const char *skg_semantic_to_d3d  (skg_semantic_ semantic);
+void        d3d_layout_apply     ();
 int64_t     d3d_tex_fmt_to_native(skg_tex_fmt_ format, bool depth_readable);
 DXGI_FORMAT d3d_tex_fmt_to_view  (int64_t format);
+void        d3d_timer_frame      ();
+void        d3d_readback_prepare (skg_readback_t *readback, size_t size);
+void        d3d_buffer_flush     (const skg_buffer_t *buffer);
+uint16_t   *d3d_ind_widen        (const void *data, uint32_t count);
+void        d3d_buffer_read      (const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size);
+void        d3d_dirty_flush_queue();
 
 template <typename T>
 void skg_downsample_1(T *data, int32_t width, int32_t height, T **out_data, int32_t *out_width, int32_t *out_height);
@@ -60,6 +141,7 @@ void skg_downsample_4(T *data, T data_max, int32_t width, int32_t height, T **ou
 ///////////////////////////////////////////
 
 int32_t skg_init(const char *, void *adapter_id) {
+	SKG_TRACE_FUNC();
 	UINT creation_flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
 #if defined(_DEBUG)
 	creation_flags |= D3D11_CREATE_DEVICE_DEBUG;
@@ -177,6 +259,13 @@ int32_t skg_init(const char *, void *adapter_id) {
 	d3d_context->QueryInterface(__uuidof(ID3DUserDefinedAnnotation), (void **)&d3d_annotate);
 #endif
 
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (SUCCEEDED(d3d_context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void **)&d3d_context1)) &&
+		SUCCEEDED(d3d_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+		d3d_cb_offsetting   = options.ConstantBufferOffsetting;
+		d3d_cb_no_overwrite = options.MapNoOverwriteOnDynamicConstantBuffer;
+	}
+
 	D3D11_RASTERIZER_DESC desc_rasterizer = {};
 	desc_rasterizer.FillMode = D3D11_FILL_SOLID;
 	desc_rasterizer.CullMode = D3D11_CULL_BACK;
@@ -217,8 +306,43 @@ const char* skg_adapter_name() {
 ///////////////////////////////////////////
 
 void skg_shutdown() {
+	SKG_TRACE_FUNC();
 	free(d3d_adapter_name);
+	for (int32_t i = 0; i < SKG_D3D_TIMER_COUNT; i++) {
+		if (d3d_timers[i].queries[0]) d3d_timers[i].queries[0]->Release();
+		if (d3d_timers[i].queries[1]) d3d_timers[i].queries[1]->Release();
+		d3d_timers[i] = {};
+	}
+	for (int32_t i = 0; i < SKG_D3D_TIMER_FRAMES; i++) {
+		if (d3d_timer_disjoint[i]) { d3d_timer_disjoint[i]->Release(); d3d_timer_disjoint[i] = nullptr; }
+	}
+	d3d_timer_disjoint_active = false;
+	d3d_timer_head            = 0;
+	d3d_timer_tail            = 0;
+	d3d_timer_stack_count     = 0;
+	d3d_timer_result_count    = 0;
+
+	if (d3d_transient.buffer) {
+		skg_mem_release((uint64_t)d3d_transient.buffer);
+		d3d_transient.buffer->Release();
+	}
+	d3d_transient       = {};
+	d3d_cb_offsetting   = false;
+	d3d_cb_no_overwrite = false;
+	free(d3d_dirty_queue);
+	d3d_dirty_queue       = nullptr;
+	d3d_dirty_queue_count = 0;
+	d3d_dirty_queue_cap   = 0;
+	if (d3d_layout_ones) { d3d_layout_ones->Release(); d3d_layout_ones = nullptr; }
+	d3d_layout_vs      = nullptr;
+	d3d_layout_default = nullptr;
+	d3d_layout_curr    = nullptr;
+	d3d_layout_meta    = nullptr;
+	d3d_layout_fmt     = 0;
+	skg_vert_fmt_clear();
+
 	CloseHandle(d3d_deferred_mtx);
+	if (d3d_context1   ) { d3d_context1   ->Release(); d3d_context1    = nullptr; }
 	if (d3d_rasterstate) { d3d_rasterstate->Release(); d3d_rasterstate = nullptr; }
 	if (d3d_depthstate ) { d3d_depthstate ->Release(); d3d_depthstate  = nullptr; }
 	if (d3d_info       ) { d3d_info       ->Release(); d3d_info        = nullptr; }
@@ -230,6 +354,8 @@ void skg_shutdown() {
 ///////////////////////////////////////////
 
 void skg_draw_begin() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_frame());
 	ID3D11CommandList* command_list = nullptr;
 	WaitForSingleObject(d3d_deferred_mtx, INFINITE);
 	d3d_deferred->FinishCommandList(false, &command_list);
@@ -237,6 +363,8 @@ void skg_draw_begin() {
 	d3d_context->ExecuteCommandList(command_list, false);
 	command_list->Release();
 
+	d3d_timer_frame();
+
 	d3d_context->RSSetState            (d3d_rasterstate);
 	d3d_context->OMSetDepthStencilState(d3d_depthstate, 1);
 	d3d_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -272,6 +400,25 @@ skg_platform_data_t skg_get_platform_data() {
 
 ///////////////////////////////////////////
 
+bool skg_upload_thread_begin() {
+	// The D3D11 device is free threaded, and context work off the main
+	// thread already goes through d3d_threadsafe_context_get.
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_upload_thread_end() {
+}
+
+///////////////////////////////////////////
+
+void skg_deferred_destroy_enable(bool enabled) {
+	// D3D11 already holds released resources until the GPU is done with them
+}
+
+///////////////////////////////////////////
+
 bool skg_capability(skg_cap_ capability) {
 	switch (capability) {
 	case skg_cap_tex_layer_select: {
@@ -280,6 +427,7 @@ bool skg_capability(skg_cap_ capability) {
 		return options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer;
 	} break;
 	case skg_cap_wireframe: return true;
+	case skg_cap_gpu_timer: return true;
 	default: return false;
 	}
 }
@@ -287,6 +435,8 @@ bool skg_capability(skg_cap_ capability) {
 ///////////////////////////////////////////
 
 void skg_event_begin (const char *name) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_begin(name));
 #if defined(_DEBUG)
 	wchar_t name_w[64];
 	MultiByteToWideChar(CP_UTF8, 0, name, -1, name_w, _countof(name_w));
@@ -297,6 +447,8 @@ void skg_event_begin (const char *name) {
 ///////////////////////////////////////////
 
 void skg_event_end () {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_end());
 #if defined(_DEBUG)
 	d3d_annotate->EndEvent();
 #endif
@@ -304,12 +456,138 @@ void skg_event_end () {
 
 ///////////////////////////////////////////
 
+void d3d_timer_frame() {
+	// Timestamps only mean something inside a disjoint query, which tells
+	// us the frequency, and whether the clock held steady. We keep one per
+	// frame.
+	if (d3d_timer_disjoint_active)
+		d3d_context->End(d3d_timer_disjoint[d3d_frame % SKG_D3D_TIMER_FRAMES]);
+
+	// Timers complete in the order they were issued, so we can stop at the
+	// first one that isn't ready yet.
+	while (d3d_timer_tail != d3d_timer_head) {
+		d3d_timer_t *timer = &d3d_timers[d3d_timer_tail % SKG_D3D_TIMER_COUNT];
+		if (!timer->ended) break;
+
+		// If the GPU is so far behind that this frame's disjoint query is
+		// about to be reused, drop the timer.
+		bool expired = timer->frame + SKG_D3D_TIMER_FRAMES <= d3d_frame + 1;
+		if (!expired) {
+			D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+			uint64_t start, end;
+			if (d3d_context->GetData(d3d_timer_disjoint[timer->frame % SKG_D3D_TIMER_FRAMES], &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+			if (d3d_context->GetData(timer->queries[0], &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+			if (d3d_context->GetData(timer->queries[1], &end,   sizeof(end),   D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) break;
+
+			if (!disjoint.Disjoint && disjoint.Frequency > 0 && d3d_timer_result_count < SKG_D3D_TIMER_COUNT) {
+				skg_timer_result_t *result = &d3d_timer_results[d3d_timer_result_count];
+				memcpy(result->name, timer->name, sizeof(result->name));
+				result->depth       = timer->depth;
+				result->frame       = timer->frame;
+				result->duration_ns = end > start ? (uint64_t)((end - start) * (1000000000.0 / disjoint.Frequency)) : 0;
+				d3d_timer_result_count += 1;
+			}
+		}
+		timer->ended    = false;
+		d3d_timer_tail += 1;
+	}
+
+	d3d_frame += 1;
+	ID3D11Query **disjoint = &d3d_timer_disjoint[d3d_frame % SKG_D3D_TIMER_FRAMES];
+	if (*disjoint == nullptr) {
+		D3D11_QUERY_DESC desc = { D3D11_QUERY_TIMESTAMP_DISJOINT };
+		if (FAILED(d3d_device->CreateQuery(&desc, disjoint))) {
+			d3d_timer_disjoint_active = false;
+			return;
+		}
+	}
+	d3d_context->Begin(*disjoint);
+	d3d_timer_disjoint_active = true;
+}
+
+///////////////////////////////////////////
+
+void skg_timer_begin(const char *name) {
+	SKG_TRACE_FUNC();
+	if (d3d_timer_stack_count >= SKG_D3D_TIMER_DEPTH) {
+		skg_log(skg_log_warning, "skg_timer_begin nested too deeply, ignoring timer");
+		d3d_timer_stack_count += 1;
+		return;
+	}
+
+	// Timers need a frame's disjoint query, which starts at skg_draw_begin.
+	// If the GPU is so far behind that the ring is full of unread timers,
+	// we skip this one rather than wait for it.
+	if (!d3d_timer_disjoint_active || d3d_timer_head - d3d_timer_tail >= SKG_D3D_TIMER_COUNT) {
+		d3d_timer_stack[d3d_timer_stack_count++] = -1;
+		return;
+	}
+
+	int32_t      index = d3d_timer_head % SKG_D3D_TIMER_COUNT;
+	d3d_timer_t *timer = &d3d_timers[index];
+	if (timer->queries[0] == nullptr) {
+		D3D11_QUERY_DESC desc = { D3D11_QUERY_TIMESTAMP };
+		if (FAILED(d3d_device->CreateQuery(&desc, &timer->queries[0])) ||
+			FAILED(d3d_device->CreateQuery(&desc, &timer->queries[1]))) {
+			skg_log(skg_log_warning, "Failed to create timestamp queries");
+			if (timer->queries[0]) { timer->queries[0]->Release(); timer->queries[0] = nullptr; }
+			if (timer->queries[1]) { timer->queries[1]->Release(); timer->queries[1] = nullptr; }
+			d3d_timer_stack[d3d_timer_stack_count++] = -1;
+			return;
+		}
+	}
+	snprintf(timer->name, sizeof(timer->name), "%s", name ? name : "");
+	timer->depth = d3d_timer_stack_count;
+	timer->frame = d3d_frame;
+	timer->ended = false;
+	d3d_context->End(timer->queries[0]);
+
+	d3d_timer_head += 1;
+	d3d_timer_stack[d3d_timer_stack_count++] = index;
+}
+
+///////////////////////////////////////////
+
+void skg_timer_end() {
+	SKG_TRACE_FUNC();
+	if (d3d_timer_stack_count <= 0) {
+		skg_log(skg_log_warning, "skg_timer_end called without a matching skg_timer_begin");
+		return;
+	}
+
+	d3d_timer_stack_count -= 1;
+	if (d3d_timer_stack_count >= SKG_D3D_TIMER_DEPTH) return;
+	int32_t index = d3d_timer_stack[d3d_timer_stack_count];
+	if (index < 0) return;
+
+	d3d_context->End(d3d_timers[index].queries[1]);
+	d3d_timers[index].ended = true;
+}
+
+///////////////////////////////////////////
+
+int32_t skg_timer_get_results(skg_timer_result_t *out_results, int32_t max_results) {
+	int32_t count = d3d_timer_result_count < max_results ? d3d_timer_result_count : max_results;
+	if (count <= 0) return 0;
+
+	memcpy(out_results, d3d_timer_results, sizeof(skg_timer_result_t) * count);
+	d3d_timer_result_count -= count;
+	memmove(d3d_timer_results, &d3d_timer_results[count], sizeof(skg_timer_result_t) * d3d_timer_result_count);
+	return count;
+}
+
+///////////////////////////////////////////
+
 void skg_tex_target_discard(skg_tex_t *render_target) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_target_discard, skg_capture_id(render_target)));
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_target_bind(render_target ? skg_capture_id(render_target) : 0, layer_idx, mip_level));
 	d3d_active_rendertarget = render_target;
 	d3d_active_rendertarget_layer = layer_idx;
 
@@ -343,6 +621,8 @@ void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mi
 ///////////////////////////////////////////
 
 void skg_target_clear(bool depth, const float *clear_color_4) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_target_clear(depth, clear_color_4));
 	if (!d3d_active_rendertarget) return;
 
 	if (clear_color_4 && d3d_active_rendertarget->_target_view) {
@@ -373,18 +653,65 @@ skg_tex_t *skg_tex_target_get() {
 ///////////////////////////////////////////
 
 void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw(index_start, index_base, index_count, instance_count));
+	_skg_stats.draws += 1;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
+	d3d_layout_apply();
 	d3d_context->DrawIndexedInstanced(index_count, instance_count, index_start, index_base, 0);
 }
 
 ///////////////////////////////////////////
 
+void skg_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_indirect(args_buffer, offset, draw_count, stride));
+	if (args_buffer->type != skg_buffer_type_indirect) {
+		skg_log(skg_log_warning, "skg_draw_indirect needs a skg_buffer_type_indirect buffer");
+		return;
+	}
+	if (stride == 0) stride = sizeof(skg_draw_args_t);
+	if (offset % 4 != 0 || stride % 4 != 0) {
+		skg_log(skg_log_warning, "skg_draw_indirect offset and stride need to be multiples of 4");
+		return;
+	}
+	_skg_stats.draws += draw_count;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
+	d3d_buffer_flush(args_buffer);
+	d3d_layout_apply();
+	// D3D11 has no multi-draw, but the args still never leave the GPU, and
+	// the runtime handles the hazard with compute writes.
+	for (uint32_t i = 0; i < draw_count; i++)
+		d3d_context->DrawIndexedInstancedIndirect(args_buffer->_buffer, offset + i * stride);
+}
+
+///////////////////////////////////////////
+
+void skg_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_multi(draws, draw_count));
+	_skg_stats.draws += draw_count;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
+	d3d_layout_apply();
+	for (uint32_t i = 0; i < draw_count; i++)
+		d3d_context->DrawIndexedInstanced(draws[i].index_count, draws[i].instance_count, draws[i].index_start, draws[i].index_base, draws[i].instance_start);
+}
+
+///////////////////////////////////////////
+
 void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_compute(thread_count_x, thread_count_y, thread_count_z));
+	_skg_stats.dispatches += 1;
+	if (d3d_dirty_queue_count > 0) d3d_dirty_flush_queue();
 	d3d_context->Dispatch(thread_count_x, thread_count_y, thread_count_z);
 }
 
 ///////////////////////////////////////////
 
 void skg_viewport(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_viewport, xywh));
 	D3D11_VIEWPORT viewport = {};
 	viewport.TopLeftX = (float)xywh[0];
 	viewport.TopLeftY = (float)xywh[1];
@@ -397,6 +724,7 @@ void skg_viewport(const int32_t *xywh) {
 ///////////////////////////////////////////
 
 void skg_viewport_get(int32_t *out_xywh) {
+	SKG_TRACE_FUNC();
 	uint32_t       count = 1;
 	D3D11_VIEWPORT viewport;
 	d3d_context->RSGetViewports(&count, &viewport);
@@ -409,6 +737,8 @@ void skg_viewport_get(int32_t *out_xywh) {
 ///////////////////////////////////////////
 
 void skg_scissor(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_scissor, xywh));
 	D3D11_RECT rect = {xywh[0], xywh[1], xywh[0]+xywh[2], xywh[1]+xywh[3]};
 	d3d_context->RSSetScissorRects(1, &rect);
 }
@@ -416,15 +746,28 @@ void skg_scissor(const int32_t *xywh) {
 ///////////////////////////////////////////
 
 skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
+	SKG_TRACE_FUNC();
 	skg_buffer_t result = {};
 	result.use    = use;
 	result.type   = type;
 	result.stride = size_stride;
 
-	D3D11_SUBRESOURCE_DATA buffer_data = { data };
+	// D3D11 has no 8 bit indices, so those are stored as 16 bit
+	uint32_t  gpu_stride = size_stride;
+	uint16_t *widened    = nullptr;
+	if (type == skg_buffer_type_index) {
+		result._ind_format = skg_ind_fmt_from_stride(size_stride);
+		if (result._ind_format == skg_ind_fmt_u8) {
+			result._ind_format = skg_ind_fmt_u16;
+			gpu_stride         = sizeof(uint16_t);
+			if (data) widened  = d3d_ind_widen(data, size_count);
+		}
+	}
+
+	D3D11_SUBRESOURCE_DATA buffer_data = { widened ? widened : data };
 	D3D11_BUFFER_DESC      buffer_desc = {};
-	buffer_desc.ByteWidth           = size_count * size_stride;
-	buffer_desc.StructureByteStride = size_stride;
+	buffer_desc.ByteWidth           = size_count * gpu_stride;
+	buffer_desc.StructureByteStride = gpu_stride;
 	buffer_desc.Usage               = D3D11_USAGE_DEFAULT;
 
 	if (use & skg_use_dynamic) {
@@ -436,18 +779,32 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 		buffer_desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE; 
 		buffer_desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 	}
+	// Indirect args can't be structured, so compute sees them through raw
+	// views instead, as a (RW)ByteAddressBuffer.
+	bool raw_views = false;
+	if (type == skg_buffer_type_indirect) {
+		raw_views = (use & skg_use_compute_write) || (use & skg_use_compute_read);
+		buffer_desc.StructureByteStride = 0;
+		buffer_desc.MiscFlags           = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+		if (raw_views) buffer_desc.MiscFlags |= D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+		else           buffer_desc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+	}
 
 	switch (type) {
 	case skg_buffer_type_vertex:   buffer_desc.BindFlags |= D3D11_BIND_VERTEX_BUFFER;   break;
 	case skg_buffer_type_index:    buffer_desc.BindFlags |= D3D11_BIND_INDEX_BUFFER;    break;
 	case skg_buffer_type_constant: buffer_desc.BindFlags |= D3D11_BIND_CONSTANT_BUFFER; break;
 	case skg_buffer_type_compute:  break;
+	case skg_buffer_type_indirect: break;
 	}
 	HRESULT hr = d3d_device->CreateBuffer(&buffer_desc, data == nullptr ? nullptr : &buffer_data, &result._buffer);
+	free(widened);
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "CreateBuffer failed: 0x%08X", hr);
 		return {};
 	}
+	if (data) skg_stats_upload(buffer_desc.ByteWidth);
+	skg_mem_track(skg_mem_key(&result), skg_mem_buffer, buffer_desc.ByteWidth);
 
 	if (use & skg_use_compute_write) {
 		D3D11_UNORDERED_ACCESS_VIEW_DESC view = {};
@@ -455,6 +812,11 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 		view.Format        = DXGI_FORMAT_UNKNOWN;
 		view.Buffer.FirstElement = 0;
 		view.Buffer.NumElements  = size_count; 
+		if (raw_views) {
+			view.Format             = DXGI_FORMAT_R32_TYPELESS;
+			view.Buffer.NumElements = buffer_desc.ByteWidth / 4;
+			view.Buffer.Flags       = D3D11_BUFFER_UAV_FLAG_RAW;
+		}
 
 		hr = d3d_device->CreateUnorderedAccessView( result._buffer, &view, &result._unordered );
 		if(FAILED(hr)) {
@@ -469,6 +831,11 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 		view.Format        = DXGI_FORMAT_UNKNOWN;
 		view.BufferEx.FirstElement = 0;
 		view.BufferEx.NumElements  = size_count;
+		if (raw_views) {
+			view.Format               = DXGI_FORMAT_R32_TYPELESS;
+			view.BufferEx.NumElements = buffer_desc.ByteWidth / 4;
+			view.BufferEx.Flags       = D3D11_BUFFEREX_SRV_FLAG_RAW;
+		}
 
 		hr = d3d_device->CreateShaderResourceView(result._buffer, &view, &result._resource);
 		if (FAILED(hr)) {
@@ -477,12 +844,15 @@ skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t s
 			return {};
 		}
 	} 
+	SKG_CAPTURE_CALL(skg_capture_buffer_create(&result, data, size_count, size_stride));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(buffer), name);
 	if (buffer->_buffer != nullptr)
 		buffer->_buffer->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)strlen(name), name);
 
@@ -506,14 +876,33 @@ bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
 ///////////////////////////////////////////
 
 void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
 	if (buffer->use != skg_use_dynamic) {
 		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
 		return;
 	}
 
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_contents(buffer, data, size_bytes));
 	HRESULT hr = E_FAIL;
 	D3D11_MAPPED_SUBRESOURCE resource = {};
 
+	uint16_t *widened = nullptr;
+	if (buffer->type == skg_buffer_type_index && buffer->stride == 1) {
+		data        = widened = d3d_ind_widen(data, size_bytes);
+		size_bytes *= sizeof(uint16_t);
+	}
+
+	// With a CPU copy around, keep it current, and send all of it so
+	// earlier ranged writes past size_bytes survive the discard.
+	d3d_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty) {
+		if (size_bytes > dirty->size) size_bytes = dirty->size;
+		memcpy(dirty->shadow, data, size_bytes);
+		dirty->dirty = false;
+		data         = dirty->shadow;
+		size_bytes   = dirty->size;
+	}
+
 	// Map the memory so we can access it on CPU! In a multi-threaded
 	// context this can be tricky, here we're using a deferred context to
 	// push this operation over to the main thread. The deferred context is
@@ -523,18 +912,143 @@ void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t si
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "Failed to set contents of buffer, may not be using a writeable buffer type: 0x%08X", hr);
 		d3d_threadsafe_context_release(context);
+		free(widened);
 		return;
 	}
 
 	memcpy(resource.pData, data, size_bytes);
+	skg_stats_upload(size_bytes);
 
 	context->Unmap(buffer->_buffer, 0);
 	d3d_threadsafe_context_release(context);
+	free(widened);
+}
+
+///////////////////////////////////////////
+
+uint16_t *d3d_ind_widen(const void *data, uint32_t count) {
+	uint16_t *result = (uint16_t*)malloc(sizeof(uint16_t) * (count > 0 ? count : 1));
+	for (uint32_t i = 0; i < count; i++)
+		result[i] = ((const uint8_t*)data)[i];
+	return result;
+}
+
+///////////////////////////////////////////
+
+void d3d_buffer_flush(const skg_buffer_t *buffer) {
+	d3d_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr || !dirty->dirty) return;
+	SKG_TRACE_FUNC();
+
+	D3D11_MAPPED_SUBRESOURCE resource = {};
+	HRESULT hr = d3d_context->Map(dirty->buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "Failed to flush buffer range writes: 0x%08X", hr);
+		return;
+	}
+	memcpy(resource.pData, dirty->shadow, dirty->size);
+	d3d_context->Unmap(dirty->buffer, 0);
+	dirty->dirty = false;
+}
+
+///////////////////////////////////////////
+
+void d3d_dirty_flush_queue() {
+	for (int32_t i = 0; i < d3d_dirty_queue_count; i++) {
+		d3d_buffer_dirty_t *dirty = d3d_dirty_queue[i];
+		dirty->queued = false;
+		if (!dirty->dirty) continue;
+
+		D3D11_MAPPED_SUBRESOURCE resource = {};
+		if (SUCCEEDED(d3d_context->Map(dirty->buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource))) {
+			memcpy(resource.pData, dirty->shadow, dirty->size);
+			d3d_context->Unmap(dirty->buffer, 0);
+		}
+		dirty->dirty = false;
+	}
+	d3d_dirty_queue_count = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents_range(skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+
+	d3d_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr) {
+		// The first ranged write pays for one readback, so the untouched
+		// bytes are still there when the whole copy goes up.
+		D3D11_BUFFER_DESC desc = {};
+		buffer->_buffer->GetDesc(&desc);
+		dirty = (d3d_buffer_dirty_t*)calloc(1, sizeof(d3d_buffer_dirty_t));
+		dirty->buffer = buffer->_buffer;
+		dirty->size   = desc.ByteWidth;
+		dirty->shadow = (uint8_t*)malloc(desc.ByteWidth);
+		d3d_buffer_read(buffer, dirty->shadow, desc.ByteWidth);
+		buffer->_dirty = dirty;
+	}
+	// 8 bit indices are 16 bit on the GPU, so the range doubles
+	bool     widened   = buffer->type == skg_buffer_type_index && buffer->stride == 1;
+	uint32_t gpu_scale = widened ? sizeof(uint16_t) : 1;
+	if (offset > dirty->size / gpu_scale || size_bytes > dirty->size / gpu_scale - offset) {
+		skg_log(skg_log_warning, "skg_buffer_set_contents_range is writing outside of the buffer!");
+		return;
+	}
+	if (size_bytes == 0) return;
+
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_range(buffer, offset, data, size_bytes));
+	if (widened) {
+		uint16_t *dest = (uint16_t*)(dirty->shadow + offset * gpu_scale);
+		for (uint32_t i = 0; i < size_bytes; i++)
+			dest[i] = ((const uint8_t*)data)[i];
+	} else {
+		memcpy(dirty->shadow + offset, data, size_bytes);
+	}
+	dirty->dirty = true;
+	skg_stats_upload(size_bytes * gpu_scale);
+
+	if (!dirty->queued) {
+		if (d3d_dirty_queue_count == d3d_dirty_queue_cap) {
+			d3d_dirty_queue_cap = d3d_dirty_queue_cap == 0 ? 16 : d3d_dirty_queue_cap * 2;
+			d3d_dirty_queue     = (d3d_buffer_dirty_t**)realloc(d3d_dirty_queue, sizeof(d3d_buffer_dirty_t*) * d3d_dirty_queue_cap);
+		}
+		d3d_dirty_queue[d3d_dirty_queue_count++] = dirty;
+		dirty->queued = true;
+	}
 }
 
 ///////////////////////////////////////////
 
 void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	SKG_TRACE_FUNC();
+	if (buffer->type != skg_buffer_type_index || buffer->stride != 1) {
+		d3d_buffer_read(buffer, ref_buffer, buffer_size);
+		return;
+	}
+
+	// 8 bit indices were widened on the way in, narrow them back
+	uint16_t *wide = (uint16_t*)malloc(sizeof(uint16_t) * (buffer_size > 0 ? buffer_size : 1));
+	d3d_buffer_read(buffer, wide, buffer_size * sizeof(uint16_t));
+	for (uint32_t i = 0; i < buffer_size; i++)
+		((uint8_t*)ref_buffer)[i] = (uint8_t)wide[i];
+	free(wide);
+}
+
+///////////////////////////////////////////
+
+void d3d_buffer_read(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	// The CPU copy already has the latest contents, pending or not
+	if (buffer->_dirty) {
+		uint32_t copy_size = buffer_size < buffer->_dirty->size ? buffer_size : buffer->_dirty->size;
+		memcpy(ref_buffer, buffer->_dirty->shadow, copy_size);
+		if (copy_size < buffer_size) memset((uint8_t*)ref_buffer + copy_size, 0, buffer_size - copy_size);
+		return;
+	}
+
 	ID3D11Buffer* cpu_buff = nullptr;
 
 	D3D11_BUFFER_DESC desc = {};
@@ -564,7 +1078,46 @@ void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint3
 
 ///////////////////////////////////////////
 
+bool skg_buffer_read_async(const skg_buffer_t *buffer, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	D3D11_BUFFER_DESC desc = {};
+	buffer->_buffer->GetDesc(&desc);
+
+	// Reuse the staging buffer when the size hasn't changed
+	if (ref_readback->_staging && (ref_readback->format != skg_tex_fmt_none || ref_readback->size != desc.ByteWidth)) {
+		ref_readback->_staging->Release();
+		ref_readback->_staging = nullptr;
+	}
+	if (ref_readback->_staging == nullptr) {
+		desc.CPUAccessFlags      = D3D11_CPU_ACCESS_READ;
+		desc.Usage               = D3D11_USAGE_STAGING;
+		desc.BindFlags           = 0;
+		desc.MiscFlags           = 0;
+		desc.StructureByteStride = 0;
+		ID3D11Buffer *staging = nullptr;
+		HRESULT hr = d3d_device->CreateBuffer(&desc, nullptr, &staging);
+		if (FAILED(hr)) {
+			skg_logf(skg_log_critical, "skg_buffer_read_async CreateBuffer failed: 0x%08X", hr);
+			return false;
+		}
+		ref_readback->_staging = staging;
+	}
+	d3d_buffer_flush(buffer);
+	d3d_readback_prepare(ref_readback, desc.ByteWidth);
+	ref_readback->width  = (int32_t)desc.ByteWidth;
+	ref_readback->height = 1;
+	ref_readback->format = skg_tex_fmt_none;
+
+	d3d_context->CopyResource(ref_readback->_staging, buffer->_buffer);
+	if (ref_readback->_query) d3d_context->End(ref_readback->_query);
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_buffer_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_clear, 0, bind));
 	if (bind.register_type == skg_register_readwrite) {
 		ID3D11UnorderedAccessView *null_uav = nullptr;
 		d3d_context->CSSetUnorderedAccessViews(bind.slot, 1, &null_uav, nullptr);
@@ -573,8 +1126,12 @@ void skg_buffer_clear(skg_bind_t bind) {
 
 ///////////////////////////////////////////
 void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_bind, skg_capture_id(buffer), bind));
+	SKG_STAT_MISS(skg_stat_buffer);
+	d3d_buffer_flush(buffer);
 	switch (bind.register_type) {
-	case skg_register_index:  d3d_context->IASetIndexBuffer(buffer->_buffer, DXGI_FORMAT_R32_UINT, 0); break;
+	case skg_register_index:  d3d_context->IASetIndexBuffer(buffer->_buffer, skg_ind_to_dxgi(buffer->_ind_format), 0); break;
 	case skg_register_vertex: d3d_context->IASetVertexBuffers(bind.slot, 1, &buffer->_buffer, &buffer->stride, NULL); break;
 	case skg_register_constant: {
 #if !defined(NDEBUG)
@@ -586,7 +1143,7 @@ void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
 	} break;
 	case skg_register_resource: {
 #if !defined(NDEBUG)
-		if (buffer->type != skg_buffer_type_compute) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a resource register! Use skg_buffer_type_compute");
+		if (buffer->type != skg_buffer_type_compute && buffer->type != skg_buffer_type_indirect) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a resource register! Use skg_buffer_type_compute");
 #endif
 		if (bind.stage_bits & skg_stage_vertex ) d3d_context->VSSetShaderResources(bind.slot, 1, &buffer->_resource);
 		if (bind.stage_bits & skg_stage_pixel  ) d3d_context->PSSetShaderResources(bind.slot, 1, &buffer->_resource);
@@ -594,7 +1151,7 @@ void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
 	} break;
 	case skg_register_readwrite: {
 #if !defined(NDEBUG)
-		if (buffer->type != skg_buffer_type_compute) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a UAV register! Use skg_buffer_type_compute");
+		if (buffer->type != skg_buffer_type_compute && buffer->type != skg_buffer_type_indirect) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a UAV register! Use skg_buffer_type_compute");
 #endif
 		if (bind.stage_bits & skg_stage_compute) d3d_context->CSSetUnorderedAccessViews(bind.slot, 1, &buffer->_unordered, nullptr);
 	} break;
@@ -603,7 +1160,129 @@ void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
 
 ///////////////////////////////////////////
 
+void d3d_bind_constant_range(ID3D11Buffer *buffer, skg_bind_t bind, uint32_t offset, uint32_t size_bytes) {
+	// Offsets and sizes are counted in 16 byte constants, and both must be
+	// multiples of 16 constants.
+	UINT first = offset / 16;
+	UINT count = ((size_bytes + 255) / 256) * 16;
+	if (bind.stage_bits & skg_stage_vertex ) d3d_context1->VSSetConstantBuffers1(bind.slot, 1, &buffer, &first, &count);
+	if (bind.stage_bits & skg_stage_pixel  ) d3d_context1->PSSetConstantBuffers1(bind.slot, 1, &buffer, &first, &count);
+	if (bind.stage_bits & skg_stage_compute) d3d_context1->CSSetConstantBuffers1(bind.slot, 1, &buffer, &first, &count);
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_bind_range(const skg_buffer_t *buffer, skg_bind_t bind, uint32_t offset, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_buffer_bind_range, skg_capture_id(buffer), bind, offset, size_bytes, nullptr));
+	if (bind.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_buffer_bind_range only supports constant registers on D3D11");
+		return;
+	}
+#if !defined(NDEBUG)
+	if (buffer->type != skg_buffer_type_constant) skg_log(skg_log_critical, "Attempting to bind the wrong buffer type to a constant register! Use skg_buffer_type_constant");
+	if (offset % skg_buffer_range_align(buffer->type) != 0) skg_log(skg_log_critical, "skg_buffer_bind_range offset isn't aligned, see skg_buffer_range_align");
+#endif
+	SKG_STAT_MISS(skg_stat_buffer);
+	d3d_buffer_flush(buffer);
+	if (d3d_cb_offsetting) {
+		d3d_bind_constant_range(buffer->_buffer, bind, offset, size_bytes);
+	} else if (offset == 0) {
+		if (bind.stage_bits & skg_stage_vertex ) d3d_context->VSSetConstantBuffers(bind.slot, 1, &buffer->_buffer);
+		if (bind.stage_bits & skg_stage_pixel  ) d3d_context->PSSetConstantBuffers(bind.slot, 1, &buffer->_buffer);
+		if (bind.stage_bits & skg_stage_compute) d3d_context->CSSetConstantBuffers(bind.slot, 1, &buffer->_buffer);
+	} else {
+		skg_log(skg_log_warning, "skg_buffer_bind_range: this device can't offset constant buffers");
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_buffer_range_align(skg_buffer_type_ type) {
+	return type == skg_buffer_type_constant ? 256 : 1;
+}
+
+///////////////////////////////////////////
+
+bool skg_transient_bind(const void *data, uint32_t size_bytes, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_transient_bind, 0, bind, 0, size_bytes, data));
+	if (bind.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_transient_bind only works with constant registers");
+		return false;
+	}
+
+	uint32_t offset  = ((d3d_transient.used + 255) / 256) * 256;
+	bool     discard = false;
+	if (d3d_transient.buffer == nullptr || size_bytes > d3d_transient.size) {
+		uint32_t size = d3d_transient.size * 2;
+		if (size < SKG_D3D_TRANSIENT_MIN) size = SKG_D3D_TRANSIENT_MIN;
+		if (size < size_bytes)            size = size_bytes;
+		size = ((size + 255) / 256) * 256;
+		if (d3d_transient.buffer) {
+			skg_mem_release((uint64_t)d3d_transient.buffer);
+			d3d_transient.buffer->Release();
+		}
+		d3d_transient = {};
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth      = size;
+		desc.Usage          = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		HRESULT hr = d3d_device->CreateBuffer(&desc, nullptr, &d3d_transient.buffer);
+		if (FAILED(hr)) {
+			skg_logf(skg_log_critical, "skg_transient_bind CreateBuffer failed: 0x%08X", hr);
+			return false;
+		}
+		d3d_transient.size = size;
+		skg_mem_track((uint64_t)d3d_transient.buffer, skg_mem_buffer, size);
+		skg_mem_name ((uint64_t)d3d_transient.buffer, "skg_transient");
+	}
+	// Without offsets, every block starts at the front of fresh memory
+	if (!d3d_cb_offsetting || !d3d_cb_no_overwrite || offset + size_bytes > d3d_transient.size) {
+		discard = true;
+		offset  = 0;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE resource = {};
+	HRESULT hr = d3d_context->Map(d3d_transient.buffer, 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &resource);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "skg_transient_bind Map failed: 0x%08X", hr);
+		return false;
+	}
+	memcpy((uint8_t*)resource.pData + offset, data, size_bytes);
+	d3d_context->Unmap(d3d_transient.buffer, 0);
+	d3d_transient.used = offset + size_bytes;
+	skg_stats_upload(size_bytes);
+
+	SKG_STAT_MISS(skg_stat_buffer);
+	if (d3d_cb_offsetting) {
+		d3d_bind_constant_range(d3d_transient.buffer, bind, offset, size_bytes);
+	} else {
+		if (bind.stage_bits & skg_stage_vertex ) d3d_context->VSSetConstantBuffers(bind.slot, 1, &d3d_transient.buffer);
+		if (bind.stage_bits & skg_stage_pixel  ) d3d_context->PSSetConstantBuffers(bind.slot, 1, &d3d_transient.buffer);
+		if (bind.stage_bits & skg_stage_compute) d3d_context->CSSetConstantBuffers(bind.slot, 1, &d3d_transient.buffer);
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_buffer_destroy(skg_buffer_t *buffer) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_buffer_destroy, skg_capture_id(buffer)));
+	skg_mem_release(skg_mem_key(buffer));
+	if (buffer->_dirty) {
+		for (int32_t i = 0; i < d3d_dirty_queue_count; i++) {
+			if (d3d_dirty_queue[i] == buffer->_dirty) {
+				d3d_dirty_queue[i] = d3d_dirty_queue[--d3d_dirty_queue_count];
+				break;
+			}
+		}
+		free(buffer->_dirty->shadow);
+		free(buffer->_dirty);
+	}
 	if (buffer->_buffer) buffer->_buffer->Release();
 	*buffer = {};
 }
@@ -611,9 +1290,11 @@ void skg_buffer_destroy(skg_buffer_t *buffer) {
 ///////////////////////////////////////////
 
 skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
 	skg_mesh_t result = {};
 	result._ind_buffer  = ind_buffer  ? ind_buffer ->_buffer : nullptr;
 	result._vert_buffer = vert_buffer ? vert_buffer->_buffer : nullptr;
+	result._ind_format  = ind_buffer  ? ind_buffer ->_ind_format : skg_ind_fmt_u32;
 	if (result._ind_buffer ) result._ind_buffer ->AddRef();
 	if (result._vert_buffer) result._vert_buffer->AddRef();
 
@@ -623,6 +1304,7 @@ skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *
 ///////////////////////////////////////////
 
 void skg_mesh_name(skg_mesh_t* mesh, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (mesh->_ind_buffer != nullptr) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_verts", name);
@@ -637,6 +1319,7 @@ void skg_mesh_name(skg_mesh_t* mesh, const char* name) {
 ///////////////////////////////////////////
 
 void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
+	SKG_TRACE_FUNC();
 	if (vert_buffer && vert_buffer->_buffer) vert_buffer->_buffer->AddRef();
 	if (mesh->_vert_buffer)                  mesh->_vert_buffer->Release();
 	mesh->_vert_buffer = vert_buffer->_buffer;
@@ -645,23 +1328,114 @@ void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
 ///////////////////////////////////////////
 
 void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
 	if (ind_buffer && ind_buffer->_buffer) ind_buffer->_buffer->AddRef();
 	if (mesh->_ind_buffer)                 mesh->_ind_buffer->Release();
 	mesh->_ind_buffer = ind_buffer->_buffer;
+	mesh->_ind_format = ind_buffer->_ind_format;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_set_format(skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count) {
+	SKG_TRACE_FUNC();
+	int32_t fmt = skg_vert_fmt_register(components, component_count);
+	if (fmt >= 0) mesh->_vert_fmt = fmt;
 }
 
 ///////////////////////////////////////////
 
 void skg_mesh_bind(const skg_mesh_t *mesh) {
-	UINT strides[] = { sizeof(skg_vert_t) };
-	UINT offsets[] = { 0 };
-	d3d_context->IASetVertexBuffers(0, 1, &mesh->_vert_buffer, strides, offsets);
-	d3d_context->IASetIndexBuffer  (mesh->_ind_buffer, DXGI_FORMAT_R32_UINT, 0);
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_mesh_bind((uint64_t)mesh->_vert_buffer, (uint64_t)mesh->_ind_buffer, mesh->_vert_fmt));
+	SKG_STAT_MISS(skg_stat_buffer);
+	if (mesh->_vert_fmt != 0 && d3d_layout_ones == nullptr) {
+		float                  ones[4]  = { 1, 1, 1, 1 };
+		D3D11_SUBRESOURCE_DATA data     = { ones };
+		D3D11_BUFFER_DESC      desc     = {};
+		desc.ByteWidth = sizeof(ones);
+		desc.Usage     = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		d3d_device->CreateBuffer(&desc, &data, &d3d_layout_ones);
+	}
+	ID3D11Buffer *buffers[] = { mesh->_vert_buffer, d3d_layout_ones };
+	UINT          strides[] = { skg_vert_fmt_get(mesh->_vert_fmt)->stride, 0 };
+	UINT          offsets[] = { 0, 0 };
+	d3d_context->IASetVertexBuffers(0, mesh->_vert_fmt != 0 ? 2 : 1, buffers, strides, offsets);
+	d3d_context->IASetIndexBuffer  (mesh->_ind_buffer, skg_ind_to_dxgi(mesh->_ind_format), 0);
+	if (d3d_layout_fmt != mesh->_vert_fmt) {
+		d3d_layout_fmt   = mesh->_vert_fmt;
+		d3d_layout_dirty = true;
+	}
+}
+
+///////////////////////////////////////////
+
+void d3d_layout_apply() {
+	if (!d3d_layout_dirty) return;
+	d3d_layout_dirty = false;
+
+	ID3D11InputLayout *layout = d3d_layout_default;
+	bool               owned  = false;
+	if (d3d_layout_fmt != 0 && d3d_layout_vs != nullptr) {
+		// Layouts live on the vertex shader they were validated against,
+		// and are released along with it.
+		GUID guid = d3d_guid_vs_layout;
+		guid.Data4[7] = (uint8_t)d3d_layout_fmt;
+		UINT size = sizeof(layout);
+		if (FAILED(d3d_layout_vs->GetPrivateData(guid, &size, &layout))) {
+			layout = nullptr;
+			UINT  code_size = 0;
+			void *code      = nullptr;
+			if (SUCCEEDED(d3d_layout_vs->GetPrivateData(d3d_guid_vs_bytecode, &code_size, nullptr)) && code_size > 0) {
+				code = malloc(code_size);
+				d3d_layout_vs->GetPrivateData(d3d_guid_vs_bytecode, &code_size, code);
+			}
+
+			// Every component the mesh has, then anything else the shader
+			// reads comes from the zero stride buffer of 1s in slot 1.
+			const skg_vert_fmt_t    *fmt        = skg_vert_fmt_get(d3d_layout_fmt);
+			D3D11_INPUT_ELEMENT_DESC desc[SKG_VERT_COMPONENT_MAX * 2];
+			UINT                     desc_count = 0;
+			for (int32_t i = 0; i < fmt->component_count; i++) {
+				const skg_vert_component_t *com = &fmt->components[i];
+				if (com->semantic == skg_semantic_none) continue;
+				desc[desc_count++] = { skg_semantic_to_d3d(com->semantic), com->semantic_slot, skg_fmt_to_dxgi(com->format, com->count), 0, fmt->offsets[i], D3D11_INPUT_PER_VERTEX_DATA, 0 };
+			}
+			int32_t input_count = d3d_layout_meta ? d3d_layout_meta->vertex_input_count : 0;
+			for (int32_t i = 0; i < input_count && desc_count < _countof(desc); i++) {
+				const skg_vert_component_t *input = &d3d_layout_meta->vertex_inputs[i];
+				if (skg_vert_fmt_find(fmt, input->semantic, input->semantic_slot) >= 0) continue;
+				desc[desc_count++] = { skg_semantic_to_d3d(input->semantic), input->semantic_slot, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+			}
+
+			HRESULT hr = code
+				? d3d_device->CreateInputLayout(desc, desc_count, code, code_size, &layout)
+				: E_FAIL;
+			free(code);
+			if (FAILED(hr)) {
+				skg_logf(skg_log_warning, "Couldn't build an input layout for vertex format %d: 0x%08X", d3d_layout_fmt, hr);
+				layout = nullptr;
+			} else {
+				d3d_layout_vs->SetPrivateDataInterface(guid, layout);
+			}
+		}
+		owned = layout != nullptr;
+	}
+
+	if (d3d_layout_curr != layout) {
+		SKG_STAT_MISS(skg_stat_layout);
+		d3d_context->IASetInputLayout(layout);
+		d3d_layout_curr = layout;
+	}
+	// The shader's private data keeps the layout alive
+	if (owned) layout->Release();
 }
 
 ///////////////////////////////////////////
 
 void skg_mesh_destroy(skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
 	if (mesh->_ind_buffer ) mesh->_ind_buffer ->Release();
 	if (mesh->_vert_buffer) mesh->_vert_buffer->Release();
 	*mesh = {};
@@ -670,6 +1444,7 @@ void skg_mesh_destroy(skg_mesh_t *mesh) {
 ///////////////////////////////////////////
 
 skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
+	SKG_TRACE_FUNC();
 	skg_shader_stage_t result = {};
 	result.type = type;
 
@@ -696,7 +1471,10 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 			case skg_stage_vertex:  entrypoint = "vs"; target = "vs_5_0"; break;
 			case skg_stage_pixel:   entrypoint = "ps"; target = "ps_5_0"; break;
 			case skg_stage_compute: entrypoint = "cs"; target = "cs_5_0"; break; }
-		hr = D3DCompile(file_data, shader_size, nullptr, nullptr, nullptr, entrypoint, target, flags, 0, &compiled, &errors);
+		{
+			SKG_TRACE_SCOPE("D3DCompile");
+			hr = D3DCompile(file_data, shader_size, nullptr, nullptr, nullptr, entrypoint, target, flags, 0, &compiled, &errors);
+		}
 		if (errors) {
 			skg_log(skg_log_warning, "D3DCompile errors:");
 			skg_log(skg_log_warning, (char*)errors->GetBufferPointer());
@@ -745,6 +1523,9 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 			{"TEXCOORD",    0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
 			{"COLOR" ,      0, DXGI_FORMAT_R8G8B8A8_UNORM,  0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0} };
 		d3d_device->CreateInputLayout(vert_desc, (UINT)_countof(vert_desc), buffer, buffer_size, &result._layout);
+		// Meshes with their own vertex format need layouts validated
+		// against this shader later on.
+		((ID3D11VertexShader *)result._shader)->SetPrivateData(d3d_guid_vs_bytecode, (UINT)buffer_size, buffer);
 	}
 	if (compiled) compiled->Release();
 
@@ -754,6 +1535,7 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 ///////////////////////////////////////////
 
 void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+	SKG_TRACE_FUNC();
 	switch(shader->type) {
 	case skg_stage_vertex  : ((ID3D11VertexShader *)shader->_shader)->Release(); shader->_layout->Release(); break;
 	case skg_stage_pixel   : ((ID3D11PixelShader  *)shader->_shader)->Release(); break;
@@ -766,6 +1548,7 @@ void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
+	SKG_TRACE_FUNC();
 	if (v_shader._shader == nullptr && p_shader._shader == nullptr && c_shader._shader == nullptr) {
 		skg_logf(skg_log_warning, "Shader '%s' has no valid stages!", meta->name);
 		return {};
@@ -790,6 +1573,7 @@ skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_
 ///////////////////////////////////////////
 
 void skg_shader_name(skg_shader_t *shader, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (shader->_pixel != nullptr) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_ps", name);
@@ -814,7 +1598,16 @@ bool skg_shader_is_valid(const skg_shader_t *shader) {
 
 ///////////////////////////////////////////
 
+bool skg_shader_is_ready(const skg_shader_t *shader) {
+	// D3D11 creates shaders synchronously
+	return true;
+}
+
+///////////////////////////////////////////
+
 void skg_shader_compute_bind(const skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_compute_bind, shader ? skg_capture_id(shader) : 0));
 	if (shader) d3d_context->CSSetShader(shader->_compute, nullptr, 0);
 	else        d3d_context->CSSetShader(nullptr, nullptr, 0);
 }
@@ -822,6 +1615,8 @@ void skg_shader_compute_bind(const skg_shader_t *shader) {
 ///////////////////////////////////////////
 
 void skg_shader_destroy(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_destroy, skg_capture_id(shader)));
 	skg_shader_meta_release(shader->meta);
 	if (shader->_vertex ) shader->_vertex ->Release();
 	if (shader->_layout ) shader->_layout ->Release();
@@ -933,6 +1728,7 @@ void skg_pipeline_update_depth(skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
 	skg_pipeline_t result = {};
 	result.transparency = skg_transparency_none;
 	result.cull         = skg_cull_back;
@@ -958,6 +1754,7 @@ skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
 ///////////////////////////////////////////
 
 void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (pipeline->_blend != nullptr) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_blendstate", name);
@@ -980,17 +1777,29 @@ void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
 ///////////////////////////////////////////
 
 void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_pipeline_bind(pipeline, (uint64_t)pipeline->_vertex));
+	// D3D11 has no state cache of its own here, so these all go through to
+	// the driver.
+	SKG_STAT_MISS(skg_stat_blend);
+	SKG_STAT_MISS(skg_stat_depth);
+	SKG_STAT_MISS(skg_stat_cull);
+	SKG_STAT_MISS(skg_stat_program);
 	d3d_context->OMSetBlendState       (pipeline->_blend,  nullptr, 0xFFFFFFFF);
 	d3d_context->OMSetDepthStencilState(pipeline->_depth,  0);
 	d3d_context->RSSetState            (pipeline->_rasterize);
 	d3d_context->VSSetShader           (pipeline->_vertex, nullptr, 0);
 	d3d_context->PSSetShader           (pipeline->_pixel,  nullptr, 0);
-	d3d_context->IASetInputLayout      (pipeline->_layout);
+	d3d_layout_vs      = pipeline->_vertex;
+	d3d_layout_default = pipeline->_layout;
+	d3d_layout_meta    = pipeline->meta;
+	d3d_layout_dirty   = true;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ transparency) {
+	SKG_TRACE_FUNC();
 	if (pipeline->transparency != transparency) {
 		pipeline->transparency  = transparency;
 		skg_pipeline_update_blend(pipeline);
@@ -1000,6 +1809,7 @@ void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ t
 ///////////////////////////////////////////
 
 void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
+	SKG_TRACE_FUNC();
 	if (pipeline->cull != cull) {
 		pipeline->cull  = cull;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1009,6 +1819,7 @@ void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
+	SKG_TRACE_FUNC();
 	if (pipeline->depth_write != write) {
 		pipeline->depth_write = write;
 		skg_pipeline_update_depth(pipeline);
@@ -1018,6 +1829,7 @@ void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
+	SKG_TRACE_FUNC();
 	if (pipeline->depth_clip != clip) {
 		pipeline->depth_clip = clip;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1027,6 +1839,7 @@ void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ write) {
+	SKG_TRACE_FUNC();
 	if (pipeline->color_write != write) {
 		pipeline->color_write = write;
 		skg_pipeline_update_blend(pipeline);
@@ -1036,6 +1849,7 @@ void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ wri
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test) {
+	SKG_TRACE_FUNC();
 	if (pipeline->depth_test != test) {
 		pipeline->depth_test = test;
 		skg_pipeline_update_depth(pipeline);
@@ -1045,6 +1859,7 @@ void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test
 ///////////////////////////////////////////
 
 void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
+	SKG_TRACE_FUNC();
 	if (pipeline->wireframe != wireframe) {
 		pipeline->wireframe  = wireframe;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1054,6 +1869,7 @@ void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_scissor(skg_pipeline_t *pipeline, bool enable) {
+	SKG_TRACE_FUNC();
 	if (pipeline->scissor != enable) {
 		pipeline->scissor  = enable;
 		skg_pipeline_update_rasterizer(pipeline);
@@ -1111,6 +1927,7 @@ bool skg_pipeline_get_scissor(const skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
 	skg_shader_meta_release(pipeline->meta);
 	if (pipeline->_blend    ) pipeline->_blend    ->Release();
 	if (pipeline->_rasterize) pipeline->_rasterize->Release();
@@ -1126,6 +1943,7 @@ void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
+	SKG_TRACE_FUNC();
 	skg_swapchain_t result = {};
 	result.width  = requested_width;
 	result.height = requested_height;
@@ -1179,6 +1997,7 @@ skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fm
 ///////////////////////////////////////////
 
 void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
 	if (swapchain->_swapchain == nullptr || (width == swapchain->width && height == swapchain->height))
 		return;
 
@@ -1212,6 +2031,7 @@ void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t hei
 ///////////////////////////////////////////
 
 void skg_swapchain_present(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	HRESULT hr = swapchain->_swapchain->Present(1, 0);
 	if (FAILED(hr)) {
 		skg_logf(skg_log_critical, "Couldn't present swapchain: 0x%08X", hr);
@@ -1225,12 +2045,14 @@ void skg_swapchain_present(skg_swapchain_t *swapchain) {
 ///////////////////////////////////////////
 
 void skg_swapchain_bind(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	skg_tex_target_bind(swapchain->_target.format != 0 ? &swapchain->_target : nullptr, -1, 0);
 }
 
 ///////////////////////////////////////////
 
 void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	skg_tex_destroy(&swapchain->_target);
 	skg_tex_destroy(&swapchain->_depth);
 	swapchain->_swapchain->Release();
@@ -1240,9 +2062,11 @@ void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ override_format, int32_t width, int32_t height, int32_t array_count, int32_t multisample, int32_t framebuffer_multisample) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type     = type;
 	result.use      = skg_use_static;
+	result._id      = d3d_tex_next_id++;
 	result._texture = (ID3D11Texture2D *)native_tex;
 	result._texture->AddRef();
 
@@ -1255,6 +2079,7 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 	result.multisample = color_desc.SampleDesc.Count;
 	result.mips        = color_desc.MipLevels > 1 ? skg_mip_generate : skg_mip_none;
 	result.format      = override_format != 0 ? override_format : skg_tex_fmt_from_native(color_desc.Format);
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
 	skg_tex_make_view(&result, color_desc.MipLevels, -1, color_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE);
 	skg_tex_settings (&result, skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 0);
 
@@ -1264,9 +2089,11 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ override_format, int32_t width, int32_t height, int32_t array_layer) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type     = type;
 	result.use      = skg_use_static;
+	result._id      = d3d_tex_next_id++;
 	result._texture = (ID3D11Texture2D *)native_tex;
 	result._texture->AddRef();
 
@@ -1279,6 +2106,7 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 	result.array_start = array_layer;
 	result.multisample = color_desc.SampleDesc.Count;
 	result.format      = override_format != 0 ? override_format : skg_tex_fmt_from_native(color_desc.Format);
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
 	skg_tex_make_view(&result, color_desc.MipLevels, array_layer, color_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE);
 	skg_tex_settings (&result, skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 0);
 
@@ -1288,21 +2116,27 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type   = type;
 	result.use    = use;
 	result.format = format;
 	result.mips   = mip_maps;
+	result._id    = d3d_tex_next_id++;
+	skg_mem_add(skg_mem_key(&result));
 
 	if (use == skg_use_dynamic && mip_maps == skg_mip_generate)
 		skg_log(skg_log_warning, "Dynamic textures don't support mip-maps!");
 
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create, &result));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_name(skg_tex_t *tex, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(tex), name);
 	if (tex->_texture != nullptr) tex->_texture->SetPrivateData(WKPDID_D3DDebugObjectName, (UINT)strlen(name), name);
 
 	char postfix_name[256];
@@ -1331,6 +2165,8 @@ void skg_tex_name(skg_tex_t *tex, const char* name) {
 ///////////////////////////////////////////
 
 void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_copy_to, skg_capture_id(tex), tex_surface, skg_capture_id(destination), dest_surface));
 	if (destination->width != tex->width || destination->height != tex->height) {
 		skg_tex_set_contents_arr(destination, nullptr, tex->array_count, 1, tex->width, tex->height, tex->multisample);
 	}
@@ -1350,6 +2186,7 @@ void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *desti
 ///////////////////////////////////////////
 
 void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
+	SKG_TRACE_FUNC();
 	skg_tex_copy_to(tex, -1, &destination->_target, -1);
 }
 
@@ -1362,6 +2199,8 @@ bool skg_tex_is_valid(const skg_tex_t *tex) {
 ///////////////////////////////////////////
 
 void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_attach_depth, skg_capture_id(tex), 0, skg_capture_id(depth), 0));
 	if (depth->type == skg_tex_type_zbuffer || depth->type == skg_tex_type_depthtarget) {
 		if (tex->_depth_view) tex->_depth_view->Release();
 		tex->_depth_view = depth->_depth_view;
@@ -1390,6 +2229,8 @@ void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
 ///////////////////////////////////////////
 
 void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_settings(tex, address, sample, compare, anisotropy));
 	if (tex->_sampler)
 		tex->_sampler->Release();
 
@@ -1523,6 +2364,7 @@ void skg_make_mips(D3D11_SUBRESOURCE_DATA *tex_mem, const void *curr_data, skg_t
 ///////////////////////////////////////////
 
 bool skg_tex_make_view(skg_tex_t *tex, uint32_t mip_count, uint32_t array_start, bool use_in_shader) {
+	SKG_TRACE_FUNC();
 	DXGI_FORMAT format = d3d_tex_fmt_to_view(d3d_tex_fmt_to_native(tex->format, tex->type == skg_tex_type_depthtarget));
 	HRESULT     hr     = E_FAIL;
 	
@@ -1704,6 +2546,7 @@ bool skg_tex_make_view(skg_tex_t *tex, uint32_t mip_count, uint32_t array_start,
 ///////////////////////////////////////////
 
 void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
 	const void *data_arr[1] = { data };
 	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
 }
@@ -1886,6 +2729,7 @@ ID3D11Texture2D *d3d_gen_mips_data(ID3D11DeviceContext *context, D3D11_TEXTURE2D
 ///////////////////////////////////////////
 
 void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t array_count, int32_t array_mip_count, int32_t width, int32_t height, int32_t multisample) {
+	SKG_TRACE_FUNC();
 	// Some warning messages
 	if (tex->use != skg_use_dynamic && tex->_texture) {
 		skg_log(skg_log_warning, "Only dynamic textures can be updated!");
@@ -1896,6 +2740,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		return;
 	}
 
+	SKG_CAPTURE_CALL(skg_capture_tex_set_contents(tex, array_data, array_count, array_mip_count, width, height, multisample));
 	tex->width       = width;
 	tex->height      = height;
 	tex->array_count = array_count;
@@ -1931,6 +2776,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		if (generate_mips) {
 			desc.MipLevels = array_mip_count;
 
+			SKG_TRACE_SCOPE("d3d_tex_upload_gen_mips");
 			ID3D11DeviceContext *context = d3d_threadsafe_context_get();
 			tex->_texture = d3d_gen_mips_data(context, desc, array_data);
 			d3d_threadsafe_context_release(context);
@@ -1959,9 +2805,11 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 
 						mip_offset += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
 					}
+					skg_stats_upload(mip_offset);
 				}
 			}
 			
+			SKG_TRACE_SCOPE("d3d_tex_upload");
 			hr = d3d_device->CreateTexture2D(&desc, tex_mem, &tex->_texture);
 			if (FAILED(hr)) {
 				skg_logf(skg_log_critical, "Create texture error: 0x%08X", hr);
@@ -1970,6 +2818,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		}
 
 		skg_tex_make_view(tex, mip_levels, -1, true);
+		skg_mem_track_tex(skg_mem_key(tex), tex, mip_levels, multisample);
 	} else {
 		// For dynamic textures, just upload the new value into the texture!
 		
@@ -1996,6 +2845,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 		}
 		
 		context->Unmap(tex->_texture, 0);
+		skg_stats_upload((int64_t)mem_pitch * height);
 
 		d3d_threadsafe_context_release(context);
 	}
@@ -2009,18 +2859,21 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void** array_data, int32_t a
 ///////////////////////////////////////////
 
 bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
 bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
 bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	// Double check on mips first
 	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
 	if (mip_level != 0) {
@@ -2115,7 +2968,138 @@ bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr
 
 ///////////////////////////////////////////
 
+void d3d_readback_prepare(skg_readback_t *readback, size_t size) {
+	if (readback->_query == nullptr) {
+		D3D11_QUERY_DESC query_desc = {};
+		query_desc.Query = D3D11_QUERY_EVENT;
+		d3d_device->CreateQuery(&query_desc, &readback->_query);
+	}
+	if (readback->size != size) {
+		free(readback->_data);
+		readback->_data = malloc(size);
+	}
+	readback->size    = size;
+	readback->_copied = false;
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_read_async(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	if (mip_level >= mip_levels || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "skg_tex_read_async: this texture doesn't have the mip level or array slice you asked for.");
+		return false;
+	}
+
+	int32_t width  = 0;
+	int32_t height = 0;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	tex->_texture->GetDesc(&desc);
+	if (desc.SampleDesc.Count > 1) {
+		skg_log(skg_log_warning, "skg_tex_read_async MSAA surfaces not implemented");
+		return false;
+	}
+	desc.Width          = width;
+	desc.Height         = height;
+	desc.MipLevels      = 1;
+	desc.ArraySize      = 1;
+	desc.MiscFlags      = 0;
+	desc.BindFlags      = 0;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.Usage          = D3D11_USAGE_STAGING;
+
+	// Reuse the staging texture when the shape hasn't changed
+	if (ref_readback->_staging && (ref_readback->width != width || ref_readback->height != height || ref_readback->format != tex->format)) {
+		ref_readback->_staging->Release();
+		ref_readback->_staging = nullptr;
+	}
+	if (ref_readback->_staging == nullptr) {
+		ID3D11Texture2D *staging = nullptr;
+		HRESULT hr = d3d_device->CreateTexture2D(&desc, nullptr, &staging);
+		if (FAILED(hr)) {
+			skg_logf(skg_log_critical, "skg_tex_read_async CreateTexture2D failed: 0x%08X", hr);
+			return false;
+		}
+		ref_readback->_staging = staging;
+	}
+	d3d_readback_prepare(ref_readback, skg_tex_fmt_memory(tex->format, width, height));
+	ref_readback->width  = width;
+	ref_readback->height = height;
+	ref_readback->format = tex->format;
+
+	D3D11_BOX box = {};
+	box.right  = width;
+	box.bottom = height;
+	box.back   = 1;
+	d3d_context->CopySubresourceRegion(ref_readback->_staging, 0, 0, 0, 0, tex->_texture, mip_level + (arr_index * mip_levels), &box);
+	if (ref_readback->_query) d3d_context->End(ref_readback->_query);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool skg_readback_poll(skg_readback_t *readback) {
+	if (readback->_staging == nullptr) return false;
+	if (readback->_copied  || readback->_query == nullptr) return true;
+	return d3d_context->GetData(readback->_query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+}
+
+///////////////////////////////////////////
+
+const void *skg_readback_map(skg_readback_t *readback, size_t *out_size) {
+	SKG_TRACE_FUNC();
+	if (out_size) *out_size = readback->size;
+	if (readback->_staging == nullptr) return nullptr;
+	if (readback->_copied)             return readback->_data;
+
+	// Map waits on the GPU if the copy hasn't finished yet
+	D3D11_MAPPED_SUBRESOURCE data;
+	HRESULT hr = d3d_context->Map(readback->_staging, 0, D3D11_MAP_READ, 0, &data);
+	if (FAILED(hr)) {
+		skg_logf(skg_log_critical, "skg_readback_map Map failed: 0x%08X", hr);
+		return nullptr;
+	}
+
+	if (readback->format == skg_tex_fmt_none) {
+		memcpy(readback->_data, data.pData, readback->size);
+		d3d_context->Unmap(readback->_staging, 0);
+		readback->_copied = true;
+		return readback->_data;
+	}
+
+	// Staging rows are padded, so pack them tightly
+	uint8_t *src_ptr   = (uint8_t*)data.pData;
+	uint8_t *dest_ptr  = (uint8_t*)readback->_data;
+	size_t   mem_pitch = skg_tex_fmt_pitch(readback->format, readback->width);
+	size_t   rows      = readback->size / mem_pitch;
+	for (size_t h = 0; h < rows; ++h) {
+		memcpy(dest_ptr, src_ptr, mem_pitch);
+		src_ptr  += data.RowPitch;
+		dest_ptr += mem_pitch;
+	}
+	d3d_context->Unmap(readback->_staging, 0);
+	readback->_copied = true;
+	return readback->_data;
+}
+
+///////////////////////////////////////////
+
+void skg_readback_destroy(skg_readback_t *readback) {
+	SKG_TRACE_FUNC();
+	if (readback->_staging) readback->_staging->Release();
+	if (readback->_query  ) readback->_query  ->Release();
+	free(readback->_data);
+	*readback = {};
+}
+
+///////////////////////////////////////////
+
 bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_gen_mips, skg_capture_id(tex_mipped_rt)));
 	ID3D11DeviceContext *context = d3d_threadsafe_context_get();
 	bool result = d3d_gen_mips(context, tex_mipped_rt->_texture);
 	d3d_threadsafe_context_release(context);
@@ -2125,12 +3109,15 @@ bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
 ///////////////////////////////////////////
 
 void* skg_tex_get_native(const skg_tex_t* tex) {
+	SKG_TRACE_FUNC();
 	return tex->_texture;
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_clear, 0, bind));
 	switch (bind.register_type) {
 	case skg_register_resource: {
 		ID3D11SamplerState       *null_state = nullptr;
@@ -2161,6 +3148,9 @@ void skg_tex_clear(skg_bind_t bind) {
 ///////////////////////////////////////////
 
 void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_bind, skg_capture_id(texture), bind));
+	SKG_STAT_MISS(skg_stat_texture);
 	switch (bind.register_type) {
 	case skg_register_resource: {
 		if (bind.stage_bits & skg_stage_pixel ){
@@ -2186,11 +3176,14 @@ void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
 ///////////////////////////////////////////
 
 void skg_tex_destroy(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_destroy, skg_capture_id(tex)));
 	if (tex->_target_view) tex->_target_view->Release();
 	if (tex->_depth_view ) tex->_depth_view ->Release();
 	if (tex->_resource   ) tex->_resource   ->Release();
 	if (tex->_sampler    ) tex->_sampler    ->Release();
 	if (tex->_texture    ) tex->_texture    ->Release();
+	skg_mem_release(skg_mem_key(tex));
 
 	if (tex->_target_array_view) {
 		int32_t mip_count = tex->mips == skg_mip_generate ? skg_mip_count(tex->width, tex->height) : 1;
@@ -2365,7 +3358,7 @@ bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
 
 ///////////////////////////////////////////
 
-const char *skg_semantic_to_d3d(skg_el_semantic_ semantic) {
+const char *skg_el_semantic_to_d3d(skg_el_semantic_ semantic) {
 	switch (semantic) {
 	case skg_el_semantic_none:         return "";
 	case skg_el_semantic_position:     return "SV_POSITION";
@@ -2379,6 +3372,61 @@ const char *skg_semantic_to_d3d(skg_el_semantic_ semantic) {
 
 ///////////////////////////////////////////
 
+DXGI_FORMAT skg_fmt_to_dxgi(skg_fmt_ format, uint8_t count) {
+	// Indexed by component count, D3D has no 3 wide 8 or 16 bit formats
+	static const DXGI_FORMAT f32  [] = { DXGI_FORMAT_R32_FLOAT,  DXGI_FORMAT_R32G32_FLOAT,  DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT };
+	static const DXGI_FORMAT f16  [] = { DXGI_FORMAT_R16_FLOAT,  DXGI_FORMAT_R16G16_FLOAT,  DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_FLOAT };
+	static const DXGI_FORMAT i32  [] = { DXGI_FORMAT_R32_SINT,   DXGI_FORMAT_R32G32_SINT,   DXGI_FORMAT_R32G32B32_SINT,  DXGI_FORMAT_R32G32B32A32_SINT  };
+	static const DXGI_FORMAT ui32 [] = { DXGI_FORMAT_R32_UINT,   DXGI_FORMAT_R32G32_UINT,   DXGI_FORMAT_R32G32B32_UINT,  DXGI_FORMAT_R32G32B32A32_UINT  };
+	static const DXGI_FORMAT i16  [] = { DXGI_FORMAT_R16_SINT,   DXGI_FORMAT_R16G16_SINT,   DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_SINT  };
+	static const DXGI_FORMAT i16n [] = { DXGI_FORMAT_R16_SNORM,  DXGI_FORMAT_R16G16_SNORM,  DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_SNORM };
+	static const DXGI_FORMAT ui16 [] = { DXGI_FORMAT_R16_UINT,   DXGI_FORMAT_R16G16_UINT,   DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_UINT  };
+	static const DXGI_FORMAT ui16n[] = { DXGI_FORMAT_R16_UNORM,  DXGI_FORMAT_R16G16_UNORM,  DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R16G16B16A16_UNORM };
+	static const DXGI_FORMAT i8   [] = { DXGI_FORMAT_R8_SINT,    DXGI_FORMAT_R8G8_SINT,     DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_SINT      };
+	static const DXGI_FORMAT i8n  [] = { DXGI_FORMAT_R8_SNORM,   DXGI_FORMAT_R8G8_SNORM,    DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_SNORM     };
+	static const DXGI_FORMAT ui8  [] = { DXGI_FORMAT_R8_UINT,    DXGI_FORMAT_R8G8_UINT,     DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_UINT      };
+	static const DXGI_FORMAT ui8n [] = { DXGI_FORMAT_R8_UNORM,   DXGI_FORMAT_R8G8_UNORM,    DXGI_FORMAT_UNKNOWN,         DXGI_FORMAT_R8G8B8A8_UNORM     };
+
+	const DXGI_FORMAT *formats = nullptr;
+	switch (format) {
+	case skg_fmt_f32:             formats = f32;   break;
+	case skg_fmt_f16:             formats = f16;   break;
+	case skg_fmt_i32:             formats = i32;   break;
+	case skg_fmt_ui32:            formats = ui32;  break;
+	case skg_fmt_i16:             formats = i16;   break;
+	case skg_fmt_i16_normalized:  formats = i16n;  break;
+	case skg_fmt_ui16:            formats = ui16;  break;
+	case skg_fmt_ui16_normalized: formats = ui16n; break;
+	case skg_fmt_i8:              formats = i8;    break;
+	case skg_fmt_i8_normalized:   formats = i8n;   break;
+	case skg_fmt_ui8:             formats = ui8;   break;
+	case skg_fmt_ui8_normalized:  formats = ui8n;  break;
+	default: break;
+	}
+	return formats != nullptr && count >= 1 && count <= 4
+		? formats[count - 1]
+		: DXGI_FORMAT_UNKNOWN;
+}
+
+///////////////////////////////////////////
+
+const char *skg_semantic_to_d3d(skg_semantic_ semantic) {
+	switch (semantic) {
+	case skg_semantic_position:     return "SV_POSITION";
+	case skg_semantic_texcoord:     return "TEXCOORD";
+	case skg_semantic_normal:       return "NORMAL";
+	case skg_semantic_binormal:     return "BINORMAL";
+	case skg_semantic_tangent:      return "TANGENT";
+	case skg_semantic_color:        return "COLOR";
+	case skg_semantic_psize:        return "PSIZE";
+	case skg_semantic_blendweight:  return "BLENDWEIGHT";
+	case skg_semantic_blendindices: return "BLENDINDICES";
+	default: return "";
+	}
+}
+
+///////////////////////////////////////////
+
 DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	switch (format) {
 	case skg_ind_fmt_u32: return DXGI_FORMAT_R32_UINT;
@@ -2388,4 +3436,30 @@ DXGI_FORMAT skg_ind_to_dxgi(skg_ind_fmt_ format) {
 	}
 }
 
+///////////////////////////////////////////
+
+// Buffer pointers are always aligned, so the low bit keeps textures apart.
+uint64_t skg_mem_key(const skg_buffer_t *buffer) {
+	return (uint64_t)buffer->_buffer;
+}
+uint64_t skg_mem_key(const skg_tex_t *tex) {
+	return (uint64_t)tex->_id << 1 | 1;
+}
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+uint64_t skg_capture_id(const skg_buffer_t *buffer) {
+	return (uint64_t)buffer->_buffer;
+}
+uint64_t skg_capture_id(const skg_shader_t *shader) {
+	return shader->_vertex ? (uint64_t)shader->_vertex : (uint64_t)shader->_compute;
+}
+uint64_t skg_capture_id(const skg_tex_t *tex) {
+	// _texture is recreated when a texture's size changes, so it can't be
+	// used to identify the texture.
+	return tex->_id;
+}
+#endif
+
 #endif
@@ -28,6 +28,8 @@ typedef struct skg_buffer_t {
 	ID3D11Buffer    *_buffer;
 	ID3D11ShaderResourceView  *_resource;
 	ID3D11UnorderedAccessView *_unordered;
+	struct d3d_buffer_dirty_t *_dirty;
+	skg_ind_fmt_               _ind_format;
 } skg_buffer_t;
 
 typedef struct skg_computebuffer_t {
@@ -40,6 +42,8 @@ typedef struct skg_computebuffer_t {
 typedef struct skg_mesh_t {
 	ID3D11Buffer* _ind_buffer;
 	ID3D11Buffer* _vert_buffer;
+	skg_ind_fmt_  _ind_format;
+	int32_t       _vert_fmt;
 } skg_mesh_t;
 
 typedef struct skg_shader_stage_t {
@@ -84,6 +88,7 @@ typedef struct skg_tex_t {
 	skg_tex_type_              type;
 	skg_tex_fmt_               format;
 	skg_mip_                   mips;
+	uint32_t                   _id;
 	ID3D11Texture2D           *_texture;
 	ID3D11SamplerState        *_sampler;
 	ID3D11ShaderResourceView  *_resource;
@@ -94,6 +99,17 @@ typedef struct skg_tex_t {
 	ID3D11DepthStencilView   **_depth_array_view;
 } skg_tex_t;
 
+typedef struct skg_readback_t {
+	int32_t          width;
+	int32_t          height;
+	skg_tex_fmt_     format;
+	size_t           size;
+	ID3D11Resource  *_staging;
+	ID3D11Query     *_query;
+	void            *_data;
+	bool             _copied;
+} skg_readback_t;
+
 typedef struct skg_swapchain_t {
 	int32_t          width;
 	int32_t          height;
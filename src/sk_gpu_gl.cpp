@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <mutex>
+#include <atomic>
 
 ///////////////////////////////////////////
 
@@ -14,6 +16,9 @@
 	#include <emscripten.h>
 	#include <emscripten/html5.h>
 	#include <GLES3/gl32.h>
+	// Emscripten implements this with WebGL2's getBufferSubData, but the
+	// GLES headers don't declare it.
+	extern "C" void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void *data);
 #elif defined(_SKG_GL_LOAD_EGL)
 	#include <EGL/egl.h>
 	#include <EGL/eglext.h>
@@ -22,6 +27,17 @@
 	EGLContext egl_context;
 	EGLConfig  egl_config;
 	EGLSurface egl_temp_surface;
+	bool       egl_headless = false;
+	EGLContext egl_upload_context = EGL_NO_CONTEXT;
+	EGLSurface egl_upload_surface = EGL_NO_SURFACE;
+
+	const EGLint egl_context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 3,
+		EGL_NONE };
+
+	#ifndef EGL_PLATFORM_SURFACELESS_MESA
+	#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+	#endif
 #elif defined(_SKG_GL_LOAD_GLX)
 	#include <X11/Xutil.h>
 	#include <X11/Xlib.h>
@@ -37,6 +53,7 @@
 	HWND  gl_hwnd;
 	HDC   gl_hdc;
 	HGLRC gl_hrc;
+	HGLRC gl_upload_hrc;
 #endif
 
 ///////////////////////////////////////////
@@ -69,6 +86,15 @@
 	wglChoosePixelFormatARB_proc    wglChoosePixelFormatARB;
 	wglCreateContextAttribsARB_proc wglCreateContextAttribsARB;
 	wglSwapIntervalEXT_proc         wglSwapIntervalEXT;
+
+	const int wgl_context_attribs[] = {
+		WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+		WGL_CONTEXT_MINOR_VERSION_ARB, 3,
+#if !defined(NDEBUG)
+		WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
+#endif
+		WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+		0 };
 #endif
 
 #ifdef _SKG_GL_LOAD_GLX
@@ -103,6 +129,18 @@
 	static GLXFBConfig  glxFBConfig;
 	static GLXDrawable  glxDrawable;
 	static GLXContext   glxContext;
+	static GLXContext   glxUploadContext;
+
+	static const int glx_context_attribs[] = {
+		GLX_RENDER_TYPE,               GLX_RGBA_TYPE,
+		GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
+		GLX_CONTEXT_MINOR_VERSION_ARB, 5,
+#if !defined(NDEBUG)
+		GLX_CONTEXT_FLAGS_ARB,         GLX_CONTEXT_DEBUG_BIT_ARB,
+#endif
+		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+		0
+	};
 #endif
 
 #ifdef _SKG_GL_MAKE_FUNCTIONS
@@ -328,7 +366,14 @@
 #define GL_COMPILE_STATUS 0x8B81
 #define GL_LINK_STATUS 0x8B82
 #define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_VENDOR 0x1F00
+#define GL_COMPLETION_STATUS_KHR 0x91B1
 #define GL_NUM_EXTENSIONS 0x821D
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MINOR_VERSION 0x821C
 #define GL_EXTENSIONS 0x1F03
 
 #define GL_DEBUG_OUTPUT                0x92E0
@@ -339,6 +384,28 @@
 #define GL_DEBUG_SEVERITY_LOW          0x9148
 #define GL_DEBUG_SOURCE_APPLICATION    0x824A
 
+#define GL_TIMESTAMP                   0x8E28
+#define GL_QUERY_RESULT                0x8866
+#define GL_QUERY_RESULT_AVAILABLE      0x8867
+#define GL_GPU_DISJOINT_EXT            0x8FBB
+
+#define GL_PIXEL_PACK_BUFFER           0x88EB
+#define GL_STREAM_READ                 0x88E1
+#define GL_MAP_READ_BIT                0x0001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE  0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT     0x00000001
+#define GL_TIMEOUT_EXPIRED             0x911B
+#define GL_COPY_READ_BUFFER            0x8F36
+#define GL_COPY_WRITE_BUFFER           0x8F37
+#define GL_BUFFER_UPDATE_BARRIER_BIT   0x00000200
+#define GL_COMMAND_BARRIER_BIT         0x00000040
+#define GL_DRAW_INDIRECT_BUFFER        0x8F3F
+#define GL_MAP_WRITE_BIT               0x0002
+#define GL_MAP_PERSISTENT_BIT          0x0040
+#define GL_MAP_COHERENT_BIT            0x0080
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT        0x8A34
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+
 // Reference from here:
 // https://github.com/ApoorvaJ/Papaya/blob/3808e39b0f45d4ca4972621c847586e4060c042a/src/libs/gl_lite.h
 
@@ -405,6 +472,11 @@ GLE(void,     glTexParameteri,           uint32_t target, uint32_t pname, int32_
 GLE(void,     glGetInternalformativ,     uint32_t target, uint32_t internalformat, uint32_t pname, int32_t bufSize, int32_t *params)\
 GLE(void,     glGetTexLevelParameteriv,  uint32_t target, int32_t level, uint32_t pname, int32_t *params) \
 GLE(void,     glTexParameterf,           uint32_t target, uint32_t pname, float param) \
+GLE(void,     glGenSamplers,             int32_t n, uint32_t *samplers) \
+GLE(void,     glDeleteSamplers,          int32_t n, const uint32_t *samplers) \
+GLE(void,     glBindSampler,             uint32_t unit, uint32_t sampler) \
+GLE(void,     glSamplerParameteri,       uint32_t sampler, uint32_t pname, int32_t param) \
+GLE(void,     glSamplerParameterf,       uint32_t sampler, uint32_t pname, float param) \
 GLE(void,     glTexImage2D,              uint32_t target, int32_t level, int32_t internalformat, int32_t width, int32_t height, int32_t border, uint32_t format, uint32_t type, const void *data) \
 GLE(void,     glCompressedTexImage2D,    uint32_t target, int32_t level, uint32_t internalformat, uint32_t width, uint32_t height, int32_t border, uint32_t imageSize, const void *data) \
 GLE(void,     glTexStorage2D,            uint32_t target, uint32_t levels, uint32_t internalformat, uint32_t width, uint32_t height) \
@@ -428,10 +500,20 @@ GLE(void,     glUniform4fv,              int32_t location, int32_t count, const
 GLE(void,     glDeleteVertexArrays,      int32_t n, const uint32_t *arrays) \
 GLE(void,     glEnableVertexAttribArray, uint32_t index) \
 GLE(void,     glVertexAttribPointer,     uint32_t index, int32_t size, uint32_t type, uint8_t normalized, int32_t stride, const void *pointer) \
+GLE(void,     glVertexAttribIPointer,    uint32_t index, int32_t size, uint32_t type, int32_t stride, const void *pointer) \
+GLE(void,     glDisableVertexAttribArray,uint32_t index) \
+GLE(void,     glVertexAttrib4f,          uint32_t index, float x, float y, float z, float w) \
+GLE(void,     glVertexAttribFormat,      uint32_t index, int32_t size, uint32_t type, uint8_t normalized, uint32_t offset) \
+GLE(void,     glVertexAttribIFormat,     uint32_t index, int32_t size, uint32_t type, uint32_t offset) \
+GLE(void,     glVertexAttribBinding,     uint32_t index, uint32_t binding) \
 GLE(void,     glUniform1i,               int32_t location, int32_t v0) \
+GLE(void,     glProgramUniform1i,        uint32_t program, int32_t location, int32_t v0) \
 GLE(void,     glDrawElementsInstanced,   uint32_t mode, int32_t count, uint32_t type, const void *indices, int32_t primcount) \
 GLE(void,     glDrawElementsInstancedBaseVertex,   uint32_t mode, int32_t count, uint32_t type, const void *indices, int32_t instancecount, int32_t basevertex) \
 GLE(void,     glDrawElements,            uint32_t mode, int32_t count, uint32_t type, const void *indices) \
+GLE(void,     glDrawElementsIndirect,    uint32_t mode, uint32_t type, const void *indirect) \
+GLE(void,     glMultiDrawElementsIndirect,    uint32_t mode, uint32_t type, const void *indirect, int32_t drawcount, int32_t stride) \
+GLE(void,     glMultiDrawElementsIndirectEXT, uint32_t mode, uint32_t type, const void *indirect, int32_t drawcount, int32_t stride) \
 GLE(void,     glDebugMessageCallback,    GLDEBUGPROC callback, const void *userParam) \
 GLE(void,     glBindBufferBase,          uint32_t target, uint32_t index, uint32_t buffer) \
 GLE(void,     glBufferSubData,           uint32_t target, int64_t offset, int32_t size, const void *data) \
@@ -445,6 +527,31 @@ GLE(void,     glDispatchCompute,         uint32_t num_groups_x, uint32_t num_gro
 GLE(void,     glObjectLabel,             uint32_t identifier, uint32_t name, uint32_t length, const char* label) \
 GLE(void,     glPushDebugGroupKHR,       uint32_t source, uint32_t id, uint32_t length, const char* message) \
 GLE(void,     glPopDebugGroupKHR,        void) \
+GLE(void,     glGenQueries,              int32_t n, uint32_t *ids) \
+GLE(void,     glDeleteQueries,           int32_t n, const uint32_t *ids) \
+GLE(void,     glQueryCounter,            uint32_t id, uint32_t target) \
+GLE(void,     glQueryCounterEXT,         uint32_t id, uint32_t target) \
+GLE(void,     glGetQueryObjectuiv,       uint32_t id, uint32_t pname, uint32_t *params) \
+GLE(void,     glGetQueryObjectui64v,     uint32_t id, uint32_t pname, uint64_t *params) \
+GLE(void,     glGetQueryObjectui64vEXT,  uint32_t id, uint32_t pname, uint64_t *params) \
+GLE(void *,   glFenceSync,               uint32_t condition, uint32_t flags) \
+GLE(uint32_t, glClientWaitSync,          void *sync, uint32_t flags, uint64_t timeout) \
+GLE(void,     glDeleteSync,              void *sync) \
+GLE(void *,   glMapBufferRange,          uint32_t target, int64_t offset, int64_t length, uint32_t access) \
+GLE(uint8_t,  glUnmapBuffer,             uint32_t target) \
+GLE(void,     glCopyBufferSubData,       uint32_t read_target, uint32_t write_target, int64_t read_offset, int64_t write_offset, int64_t size) \
+GLE(void,     glMemoryBarrier,           uint32_t barriers) \
+GLE(void,     glBufferStorage,           uint32_t target, int64_t size, const void *data, uint32_t flags) \
+GLE(void,     glBufferStorageEXT,        uint32_t target, int64_t size, const void *data, uint32_t flags) \
+GLE(void,     glBindBufferRange,         uint32_t target, uint32_t index, uint32_t buffer, int64_t offset, int64_t size) \
+GLE(void,     glBindBuffersRange,        uint32_t target, uint32_t first, int32_t count, const uint32_t *buffers, const intptr_t *offsets, const intptr_t *sizes) \
+GLE(void,     glBindTextures,            uint32_t first, int32_t count, const uint32_t *textures) \
+GLE(void,     glBindSamplers,            uint32_t first, int32_t count, const uint32_t *samplers) \
+GLE(void,     glGetProgramBinary,        uint32_t program, int32_t buf_size, int32_t *length, uint32_t *binary_format, void *binary) \
+GLE(void,     glProgramBinary,           uint32_t program, uint32_t binary_format, const void *binary, int32_t length) \
+GLE(void,     glProgramParameteri,       uint32_t program, uint32_t pname, int32_t value) \
+GLE(void,     glMaxShaderCompilerThreadsKHR, uint32_t count) \
+GLE(void,     glMaxShaderCompilerThreadsARB, uint32_t count) \
 GLE(const char *, glGetString,           uint32_t name) \
 GLE(const char *, glGetStringi,          uint32_t name, uint32_t index)
 
@@ -480,9 +587,39 @@ static void gl_load_extensions( ) {
 
 ///////////////////////////////////////////
 
+#define SKG_GL_MAX_ATTRIBS 16
+// Cache value for bindings the state cache can't vouch for
+#define SKG_GL_UNKNOWN     0xFFFFFFFF
+
+// A vertex array object, and the shader inputs its attributes are currently
+// pointed at. With vertex binding points, these are shared by every mesh of
+// a format, otherwise each mesh has its own.
+typedef struct gl_layout_t {
+	uint32_t vao;
+	uint32_t vert_buffer;
+	int32_t  vert_fmt;
+	uint32_t enabled;
+	uint64_t inputs;
+} gl_layout_t;
+
+#define SKG_GL_BIND_SLOTS 32
+
+typedef struct gl_buffer_range_t {
+	uint32_t buffer;
+	uint32_t offset;
+	uint32_t size;
+} gl_buffer_range_t;
+
 typedef struct gl_pipeline_state_t {
 	uint32_t          program;
 	uint32_t          layout;
+	skg_shader_meta_t*meta;
+	uint64_t          inputs;
+	// The bound mesh, applied at draw time once the shader is known too
+	gl_layout_t      *mesh;
+	uint32_t          mesh_verts;
+	uint32_t          mesh_inds;
+	int32_t           mesh_fmt;
 	skg_transparency_ transparency;
 	skg_cull_         cull;
 	skg_depth_test_   depth_test_type;
@@ -492,19 +629,184 @@ typedef struct gl_pipeline_state_t {
 	skg_color_write_  color_write;
 	bool              scissor;
 	bool              wireframe;
-	uint32_t          tex_bind[32];
-	uint32_t          buffer_bind[4];
+	uint32_t          tex_bind    [SKG_GL_BIND_SLOTS];
+	uint32_t          sampler_bind[SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ubo_bind    [SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ssbo_bind   [SKG_GL_BIND_SLOTS];
+	uint32_t          buffer_bind[5];
 } gl_pipeline_state_t;
 gl_pipeline_state_t gl_pipeline = {};
 
+// Shader resources bound since the last draw or dispatch. Dirty slots are
+// checked against gl_pipeline right before the GPU needs them, so only
+// real changes reach GL, and with multi-bind a run of them is one call.
+// Slots without a dirty bit always match gl_pipeline.
+typedef struct gl_bind_queue_t {
+	uint32_t          tex       [SKG_GL_BIND_SLOTS];
+	uint32_t          tex_target[SKG_GL_BIND_SLOTS];
+	uint32_t          sampler   [SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ubo       [SKG_GL_BIND_SLOTS];
+	gl_buffer_range_t ssbo      [SKG_GL_BIND_SLOTS];
+	uint32_t          tex_dirty;
+	uint32_t          ubo_dirty;
+	uint32_t          ssbo_dirty;
+} gl_bind_queue_t;
+gl_bind_queue_t gl_binds = {};
+
+inline bool gl_stat_check(skg_stat_ stat, bool changed) {
+	if (changed) SKG_STAT_MISS(stat);
+	else         SKG_STAT_HIT (stat);
+	return changed;
+}
+
 #if !defined(SKG_GL_EXPLICIT_STATE)
-#define PIPELINE_CHECK(state_cache, state) if ((state_cache) != (state)) { state_cache = (state);
+#define PIPELINE_CHECK(stat, state_cache, state) if (gl_stat_check(stat, (state_cache) != (state))) { state_cache = (state);
 #define PIPELINE_CHECK_END }
 #else
-#define PIPELINE_CHECK(state_cache, state)
-#define PIPELINE_CHECK_END
+#define PIPELINE_CHECK(stat, state_cache, state) { SKG_STAT_MISS(stat);
+#define PIPELINE_CHECK_END }
 #endif
 
+#define SKG_GL_TIMER_COUNT 256
+#define SKG_GL_TIMER_DEPTH 16
+
+typedef struct gl_timer_t {
+	char     name[32];
+	int32_t  depth;
+	uint64_t frame;
+	uint32_t queries[2];
+	bool     ended;
+} gl_timer_t;
+
+gl_timer_t         gl_timers       [SKG_GL_TIMER_COUNT];
+skg_timer_result_t gl_timer_results[SKG_GL_TIMER_COUNT];
+int32_t            gl_timer_result_count = 0;
+uint32_t           gl_timer_head         = 0;
+uint32_t           gl_timer_tail         = 0;
+int32_t            gl_timer_stack[SKG_GL_TIMER_DEPTH];
+int32_t            gl_timer_stack_count  = 0;
+uint64_t           gl_frame              = 0;
+uint32_t           gl_readback_fbo       = 0;
+
+bool               gl_buffer_storage     = false;
+bool               gl_vertex_binding     = false;
+bool               gl_sampler_objects    = false;
+bool               gl_multi_bind         = false;
+bool               gl_program_binary     = false;
+bool               gl_parallel_compile   = false;
+// Resources can be made on other threads through a second, shared context.
+// Only one thread holds it at a time, and render thread caches are left
+// alone while it does.
+std::mutex         gl_upload_mtx;
+thread_local bool  gl_upload_thread      = false;
+thread_local bool  gl_render_thread      = false;
+
+// Resources destroyed while deferred destruction is on wait here until a
+// fence shows the GPU is past the frame they were destroyed in. Any thread
+// can push onto the queue, and the render thread takes the whole list at
+// once, so a compare and swap is all it needs.
+typedef enum gl_destroy_type_ {
+	gl_destroy_type_buffer,
+	gl_destroy_type_tex,
+	gl_destroy_type_shader,
+} gl_destroy_type_;
+typedef struct gl_destroy_t {
+	struct gl_destroy_t *next;
+	gl_destroy_type_     type;
+	union {
+		skg_buffer_t buffer;
+		skg_tex_t    tex;
+		skg_shader_t shader;
+	};
+} gl_destroy_t;
+typedef struct gl_destroy_batch_t {
+	gl_destroy_t *items;
+	void         *fence;
+} gl_destroy_batch_t;
+std::atomic<bool>          gl_destroy_deferred    = { false };
+std::atomic<gl_destroy_t*> gl_destroy_queue       = { nullptr };
+gl_destroy_batch_t        *gl_destroy_batches     = nullptr;
+int32_t                    gl_destroy_batch_count = 0;
+int32_t                    gl_destroy_batch_cap   = 0;
+int32_t            gl_ubo_align          = 256;
+int32_t            gl_ssbo_align         = 256;
+
+#define SKG_GL_TRANSIENT_FRAMES 3
+#define SKG_GL_TRANSIENT_MIN    (64 * 1024)
+
+// One uniform buffer split into a section per frame. Each frame fills its
+// section from the start, and the section is fenced when the frame ends.
+// Dynamic buffer writes are staged here on their way to the GPU.
+typedef struct gl_transient_t {
+	uint32_t buffer;
+	uint8_t *map;
+	uint32_t frame_size;
+	uint32_t frame_index;
+	uint32_t used;
+	// Set by skg_draw_begin, and cleared when the section runs out
+	bool     frame_marked;
+	void    *fences[SKG_GL_TRANSIENT_FRAMES];
+	// Outgrown buffers, kept until the frame that used them ends
+	uint32_t*retired;
+	int32_t  retired_count;
+} gl_transient_t;
+gl_transient_t     gl_transient          = {};
+// Set by compute dispatches, so indirect draws know to wait on their writes
+bool               gl_compute_pending    = false;
+// Shared vertex layouts, keyed by vertex format and shader inputs
+gl_layout_t       *gl_layouts            = nullptr;
+int32_t            gl_layout_count       = 0;
+int32_t            gl_layout_cap         = 0;
+int32_t            gl_layout_last        = 0;
+// Shared sampler objects, keyed by the settings that went into them
+typedef struct gl_sampler_t {
+	uint64_t key;
+	uint32_t sampler;
+} gl_sampler_t;
+gl_sampler_t      *gl_samplers           = nullptr;
+int32_t            gl_sampler_count      = 0;
+int32_t            gl_sampler_cap        = 0;
+std::mutex         gl_sampler_mtx;
+// Programs still compiling on the driver's threads. Finished programs
+// leave the list, and ones that failed to link move to the failed list,
+// which is usually empty. Failed programs stay alive until
+// skg_shader_destroy, since copies of the skg_shader_t may refer to them.
+typedef struct gl_program_pending_t {
+	uint32_t           program;
+	skg_shader_meta_t *meta;
+	uint32_t           stages[3];
+	char              *cache_file;
+	uint64_t           cache_key;
+} gl_program_pending_t;
+gl_program_pending_t *gl_programs_pending      = nullptr;
+int32_t               gl_program_pending_count = 0;
+int32_t               gl_program_pending_cap   = 0;
+uint32_t             *gl_programs_failed       = nullptr;
+int32_t               gl_program_failed_count  = 0;
+int32_t               gl_program_failed_cap    = 0;
+// Format of the bound index buffer, every draw path reads from these
+uint32_t           gl_ind_type           = GL_UNSIGNED_INT;
+uint32_t           gl_ind_size           = sizeof(uint32_t);
+
+#define SKG_GL_DIRTY_RANGES 16
+
+// CPU side copy of a buffer's ranged writes that haven't reached the GPU
+// yet. Ranges are kept sorted, and touching ones are merged, so a flush
+// is one upload per contiguous run of changes.
+typedef struct gl_buffer_dirty_t {
+	uint32_t  buffer;
+	uint8_t  *shadow;
+	int32_t   range_count;
+	uint32_t  ranges[SKG_GL_DIRTY_RANGES][2];
+	bool      queued;
+} gl_buffer_dirty_t;
+
+// Buffers with pending ranged writes. Bound buffers can be written to
+// after the bind, so the queue is flushed before each draw and dispatch.
+gl_buffer_dirty_t **gl_dirty_queue       = nullptr;
+int32_t             gl_dirty_queue_count = 0;
+int32_t             gl_dirty_queue_cap   = 0;
+
 int32_t     gl_active_width        = 0;
 int32_t     gl_active_height       = 0;
 skg_tex_t  *gl_active_rendertarget = nullptr;
@@ -522,6 +824,34 @@ bool gl_tex_fmt_supported[skg_tex_fmt_max] = {};
 uint32_t skg_buffer_type_to_gl   (skg_buffer_type_ type);
 uint32_t skg_tex_fmt_to_gl_type  (skg_tex_fmt_ format);
 uint32_t skg_tex_fmt_to_gl_layout(skg_tex_fmt_ format);
+uint32_t skg_fmt_to_gl_type      (skg_fmt_ format);
+void     gl_readback_prepare     (skg_readback_t *readback, size_t size);
+void     gl_buffer_stage         (uint32_t buffer, uint32_t offset, const void *data, uint32_t size_bytes);
+void     gl_buffer_flush         (skg_buffer_t *buffer);
+void     gl_dirty_upload         (gl_buffer_dirty_t *dirty);
+void     gl_dirty_flush_queue    ();
+void     gl_transient_frame      ();
+void     gl_transient_advance    ();
+uint32_t gl_transient_alloc      (const void *data, uint32_t size_bytes, uint32_t align);
+void     gl_draw_elements        (uint32_t index_start, int32_t index_base, uint32_t index_count, uint32_t instance_count);
+void     gl_ind_format_set       (skg_ind_fmt_ format);
+uint64_t gl_layout_inputs        (const skg_shader_meta_t *meta);
+void     gl_layout_apply         ();
+gl_layout_t *gl_layout_find      (int32_t vert_fmt, uint64_t inputs);
+void     gl_layout_map           (gl_layout_t *layout, uint64_t inputs);
+void     gl_transient_release    ();
+uint32_t gl_sampler_find         (uint32_t wrap, uint32_t filter, uint32_t min_filter, float anisotropy, uint32_t comparison);
+void     gl_transient_free       (uint32_t buffer);
+void     gl_buffer_destroy       (skg_buffer_t *buffer);
+void     gl_tex_destroy          (skg_tex_t    *tex);
+void     gl_shader_destroy       (skg_shader_t *shader);
+void     gl_destroy_frame        ();
+void     gl_destroy_flush        ();
+void     gl_bind_buffer          (bool storage, uint32_t slot, uint32_t buffer, uint32_t offset, uint32_t size);
+void     gl_bind_forget          (uint32_t buffer);
+void     gl_bind_flush           ();
+void     gl_bind_flush_buffers   (bool storage);
+void     gl_bind_flush_textures  ();
 
 ///////////////////////////////////////////
 
@@ -634,15 +964,7 @@ int32_t gl_init_wgl() {
 	}
 
 	// Create an OpenGL context
-	int attributes[] = {
-		WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
-		WGL_CONTEXT_MINOR_VERSION_ARB, 3,
-#if !defined(NDEBUG)
-		WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
-#endif
-		WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-		0 };
-	gl_hrc = wglCreateContextAttribsARB( gl_hdc, 0, attributes );
+	gl_hrc = wglCreateContextAttribsARB( gl_hdc, 0, wgl_context_attribs );
 	if (!gl_hrc) {
 		skg_log(skg_log_critical, "Couldn't create GL context!");
 		return false;
@@ -679,9 +1001,53 @@ int32_t gl_init_emscripten() {
 
 ///////////////////////////////////////////
 
+#if defined(_SKG_GL_LOAD_EGL) && defined(SKG_LINUX_EGL)
+EGLDisplay gl_egl_headless_display() {
+	const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	bool        has_device        = client_extensions != nullptr && strstr(client_extensions, "EGL_EXT_platform_device"      ) != nullptr;
+	bool        has_surfaceless   = client_extensions != nullptr && strstr(client_extensions, "EGL_MESA_platform_surfaceless") != nullptr;
+
+	PFNEGLQUERYDEVICESEXTPROC eglQueryDevicesEXT = has_device
+		? (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT")
+		: nullptr;
+	if (eglQueryDevicesEXT) {
+		const int32_t MAX_DEVICES = 10;
+		EGLDeviceEXT  devices[MAX_DEVICES];
+		EGLint        device_count = 0;
+		eglQueryDevicesEXT(MAX_DEVICES, devices, &device_count);
+		skg_logf(skg_log_info, "Found %d EGL devices.", device_count);
+
+		// Not every device can make a display, software devices and
+		// devices missing their DRM node will fail to initialize.
+		for (int32_t i = 0; i < device_count; i++) {
+			EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+				skg_logf(skg_log_info, "Running headless on EGL device %d", i);
+				return display;
+			}
+			eglGetError();
+		}
+	}
+
+	if (has_surfaceless) {
+		EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+			skg_log(skg_log_info, "Running headless on the surfaceless EGL platform");
+			return display;
+		}
+		eglGetError();
+	}
+
+	skg_log(skg_log_warning, "No EGL device or surfaceless platform available, falling back to the default EGL display");
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif
+
+///////////////////////////////////////////
+
 int32_t gl_init_egl() {
 #ifdef _SKG_GL_LOAD_EGL
-	const EGLint attribs[] = {
+	EGLint attribs[] = {
 		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT | EGL_WINDOW_BIT,
 		EGL_CONFORMANT,   EGL_OPENGL_ES3_BIT_KHR,
 		EGL_BLUE_SIZE,  8,
@@ -691,9 +1057,6 @@ int32_t gl_init_egl() {
 		EGL_DEPTH_SIZE, 0,
 		EGL_NONE
 	};
-	EGLint context_attribs[] = { 
-		EGL_CONTEXT_CLIENT_VERSION, 3,
-		EGL_NONE };
 	EGLint format;
 	EGLint numConfigs;
 
@@ -702,26 +1065,8 @@ int32_t gl_init_egl() {
 		#if defined(SKG_LINUX_EGL)
 		const char* display = getenv("DISPLAY");
 		if (!display || display[0] == '\0') {
-			const int MAX_DEVICES = 10;
-			EGLDeviceEXT eglDevs[MAX_DEVICES];
-			EGLint numDevices = 0;
-
-			PFNEGLQUERYDEVICESEXTPROC eglQueryDevicesEXT = 
-				(PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
-			if (!eglQueryDevicesEXT) {
-				skg_log(skg_log_critical, "Failed to get eglQueryDevicesEXT");
-				return 0;
-			}
-
-			eglQueryDevicesEXT(MAX_DEVICES, eglDevs, &numDevices);
-			skg_logf(skg_log_info, "Found %d EGL devices.", numDevices);
-			for (int idx = 0; idx < numDevices; idx++) {
-				EGLDisplay disp = eglGetPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, eglDevs[idx], 0);
-				if (disp != EGL_NO_DISPLAY) {
-					egl_display = disp;
-					break;
-				}
-			}
+			egl_headless = true;
+			egl_display  = gl_egl_headless_display();
 		} else {
 			egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
 		}
@@ -729,7 +1074,7 @@ int32_t gl_init_egl() {
 		egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
 		#endif
 
-		if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglGetDisplay"); return 0; }
+		if (egl_display == EGL_NO_DISPLAY || eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglGetDisplay"); return 0; }
 	}
 
 	int32_t major=0, minor=0;
@@ -740,12 +1085,15 @@ int32_t gl_init_egl() {
 	snprintf(version, sizeof(version), "EGL version %d.%d", major, minor);
 	skg_log(skg_log_info, version);
 
+	// Device and surfaceless displays have no windows to make surfaces for.
+	if (egl_headless) attribs[1] = EGL_PBUFFER_BIT;
+
 	eglChooseConfig   (egl_display, attribs, &egl_config, 1, &numConfigs);
-	if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglChooseConfig"   ); return 0; }
+	if (eglGetError() != EGL_SUCCESS || numConfigs == 0) { skg_log(skg_log_critical, "Err eglChooseConfig"   ); return 0; }
 	eglGetConfigAttrib(egl_display, egl_config, EGL_NATIVE_VISUAL_ID, &format);
 	if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglGetConfigAttrib"); return 0; }
 
-	egl_context = eglCreateContext      (egl_display, egl_config, nullptr, context_attribs);
+	egl_context = eglCreateContext      (egl_display, egl_config, nullptr, egl_context_attribs);
 	if (eglGetError() != EGL_SUCCESS) { skg_log(skg_log_critical, "Err eglCreateContext"  ); return 0; }
 
 	const char* egl_extensions       = eglQueryString(egl_display, EGL_EXTENSIONS);
@@ -793,17 +1141,7 @@ int32_t gl_init_glx() {
 	GLXContext old_ctx = glXCreateContext(xDisplay, visualInfo, NULL, true);
 	glXMakeCurrent(xDisplay, glxDrawable, old_ctx);
 
-	int ctx_attribute_list[] = {
-		GLX_RENDER_TYPE,               GLX_RGBA_TYPE,
-		GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
-		GLX_CONTEXT_MINOR_VERSION_ARB, 5,
-#if !defined(NDEBUG)
-		GLX_CONTEXT_FLAGS_ARB,         GLX_CONTEXT_DEBUG_BIT_ARB,
-#endif
-		GLX_CONTEXT_PROFILE_MASK_ARB,  GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
-		0
-	};
-	glxContext = glXCreateContextAttribsARB(xDisplay, glxFBConfig, NULL, true, ctx_attribute_list);
+	glxContext = glXCreateContextAttribsARB(xDisplay, glxFBConfig, NULL, true, glx_context_attribs);
 	glXDestroyContext(xDisplay, old_ctx);
 	glXMakeCurrent(xDisplay, glxDrawable, glxContext);
 
@@ -813,7 +1151,114 @@ int32_t gl_init_glx() {
 
 ///////////////////////////////////////////
 
+// Makes the upload context current on this thread, creating it the first
+// time. It shares objects with the main context, but not container objects
+// like VAOs and framebuffers.
+bool gl_upload_context_make() {
+#if   defined(_SKG_GL_LOAD_EGL)
+	if (egl_upload_context == EGL_NO_CONTEXT) {
+		egl_upload_context = eglCreateContext(egl_display, egl_config, egl_context, egl_context_attribs);
+		if (egl_upload_context == EGL_NO_CONTEXT) { skg_log(skg_log_warning, "Err eglCreateContext for uploads"); return false; }
+
+		// A surface can only be current on one thread, so this can't share
+		// the main context's temporary one.
+		if (egl_temp_surface != nullptr) {
+			EGLint temp_buffer_attr[] = {
+				EGL_WIDTH,  1,
+				EGL_HEIGHT, 1,
+				EGL_NONE };
+			egl_upload_surface = eglCreatePbufferSurface(egl_display, egl_config, temp_buffer_attr);
+		}
+	}
+	return eglMakeCurrent(egl_display, egl_upload_surface, egl_upload_surface, egl_upload_context) == EGL_TRUE;
+#elif defined(_SKG_GL_LOAD_GLX)
+	if (glxUploadContext == nullptr) {
+		glxUploadContext = glXCreateContextAttribsARB(xDisplay, glxFBConfig, glxContext, true, glx_context_attribs);
+		if (glxUploadContext == nullptr) { skg_log(skg_log_warning, "Couldn't create GL context for uploads!"); return false; }
+	}
+	return glXMakeCurrent(xDisplay, glxDrawable, glxUploadContext);
+#elif defined(_SKG_GL_LOAD_WGL)
+	if (gl_upload_hrc == nullptr) {
+		gl_upload_hrc = wglCreateContextAttribsARB(gl_hdc, gl_hrc, wgl_context_attribs);
+		if (gl_upload_hrc == nullptr) { skg_log(skg_log_warning, "Couldn't create GL context for uploads!"); return false; }
+	}
+	return wglMakeCurrent(gl_hdc, gl_upload_hrc);
+#else
+	skg_log(skg_log_warning, "Uploads from other threads aren't supported on this platform.");
+	return false;
+#endif
+}
+
+///////////////////////////////////////////
+
+void gl_upload_context_release() {
+#if   defined(_SKG_GL_LOAD_EGL)
+	eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#elif defined(_SKG_GL_LOAD_GLX)
+	glXMakeCurrent(xDisplay, 0, nullptr);
+#elif defined(_SKG_GL_LOAD_WGL)
+	wglMakeCurrent(NULL, NULL);
+#endif
+}
+
+///////////////////////////////////////////
+
+void gl_upload_context_destroy() {
+#if   defined(_SKG_GL_LOAD_EGL)
+	if (egl_upload_surface != EGL_NO_SURFACE) eglDestroySurface(egl_display, egl_upload_surface);
+	if (egl_upload_context != EGL_NO_CONTEXT) eglDestroyContext(egl_display, egl_upload_context);
+	egl_upload_surface = EGL_NO_SURFACE;
+	egl_upload_context = EGL_NO_CONTEXT;
+#elif defined(_SKG_GL_LOAD_GLX)
+	if (glxUploadContext) glXDestroyContext(xDisplay, glxUploadContext);
+	glxUploadContext = nullptr;
+#elif defined(_SKG_GL_LOAD_WGL)
+	if (gl_upload_hrc) wglDeleteContext(gl_upload_hrc);
+	gl_upload_hrc = nullptr;
+#endif
+}
+
+///////////////////////////////////////////
+
+bool skg_upload_thread_begin() {
+	SKG_TRACE_FUNC();
+	if (gl_render_thread) {
+		skg_log(skg_log_warning, "skg_upload_thread_begin can't be used on the thread that called skg_init.");
+		return false;
+	}
+	gl_upload_mtx.lock();
+	if (!gl_upload_context_make()) {
+		gl_upload_mtx.unlock();
+		return false;
+	}
+	gl_upload_thread = true;
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_upload_thread_end() {
+	SKG_TRACE_FUNC();
+	if (!gl_upload_thread) return;
+
+	// Nothing from this context is safe to use elsewhere until the GPU is
+	// done with it. Waiting here keeps the stall on the worker, and off the
+	// render thread.
+	void *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+	}
+	glDeleteSync(fence);
+
+	gl_upload_context_release();
+	gl_upload_thread = false;
+	gl_upload_mtx.unlock();
+}
+
+///////////////////////////////////////////
+
 void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
+	SKG_TRACE_FUNC();
 #ifdef _SKG_GL_LOAD_GLX
 	xDisplay    =  (Display    *) dpy;
 	visualInfo  =  (XVisualInfo*) vi;
@@ -825,6 +1270,12 @@ void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
 ///////////////////////////////////////////
 
 void gl_check_exts() {
+	bool    multi_draw_ext     = false;
+	bool    vertex_binding_ext = false;
+	bool    sampler_ext        = false;
+	bool    multi_bind_ext     = false;
+	bool    program_binary_ext = false;
+	bool    parallel_ext       = false;
 	int32_t ct;
 	glGetIntegerv(GL_NUM_EXTENSIONS, &ct);
 	for (int32_t i = 0; i < ct; i++) {
@@ -838,7 +1289,119 @@ void gl_check_exts() {
 		if (strcmp(ext, "GL_IMG_texture_compression_pvrtc2"              ) == 0) gl_caps[skg_cap_fmt_pvrtc2] = true;
 		if (strcmp(ext, "GL_KHR_texture_compression_astc_ldr"            ) == 0) gl_caps[skg_cap_fmt_astc] = true;
 		if (strcmp(ext, "GL_AMD_compressed_ATC_texture"                  ) == 0) gl_caps[skg_cap_fmt_atc] = true;
+		if (strcmp(ext, "GL_EXT_disjoint_timer_query"                    ) == 0) gl_caps[skg_cap_gpu_timer] = true;
+		if (strcmp(ext, "GL_ARB_buffer_storage"                          ) == 0) gl_buffer_storage = true;
+		if (strcmp(ext, "GL_EXT_buffer_storage"                          ) == 0) gl_buffer_storage = true;
+		if (strcmp(ext, "GL_EXT_multi_draw_indirect"                     ) == 0) multi_draw_ext    = true;
+		if (strcmp(ext, "GL_ARB_vertex_attrib_binding"                   ) == 0) vertex_binding_ext = true;
+		if (strcmp(ext, "GL_ARB_sampler_objects"                         ) == 0) sampler_ext        = true;
+		if (strcmp(ext, "GL_ARB_multi_bind"                              ) == 0) multi_bind_ext     = true;
+		if (strcmp(ext, "GL_ARB_get_program_binary"                      ) == 0) program_binary_ext = true;
+		if (strcmp(ext, "GL_KHR_parallel_shader_compile"                 ) == 0) parallel_ext       = true;
+		if (strcmp(ext, "GL_ARB_parallel_shader_compile"                 ) == 0) parallel_ext       = true;
+	}
+
+#if defined(_SKG_GL_DESKTOP)
+	// Timestamp queries are core in desktop GL
+	gl_caps[skg_cap_gpu_timer] = true;
+#elif defined(_SKG_GL_WEB)
+	// WebGL2 only has GL_TIME_ELAPSED, which can't nest
+	gl_caps[skg_cap_gpu_timer] = false;
+#endif
+#if !defined(_SKG_GL_WEB)
+	// GLES only has these through GL_EXT_disjoint_timer_query
+	if (glQueryCounter        == nullptr) glQueryCounter        = glQueryCounterEXT;
+	if (glGetQueryObjectui64v == nullptr) glGetQueryObjectui64v = glGetQueryObjectui64vEXT;
+	if (glQueryCounter == nullptr || glGetQueryObjectui64v == nullptr || glGenQueries == nullptr)
+		gl_caps[skg_cap_gpu_timer] = false;
+
+	// Loaders hand back stubs for functions the context doesn't have, so
+	// indirect draws go by version. They're core in GL 4.3 and GLES 3.1, and
+	// multi-draw is only an extension on GLES.
+	int32_t major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	int32_t version = major * 10 + minor;
+#if defined(_SKG_GL_ES)
+	if (version < 31) glDrawElementsIndirect = nullptr;
+	glMultiDrawElementsIndirect = multi_draw_ext && glDrawElementsIndirect ? glMultiDrawElementsIndirectEXT : nullptr;
+#else
+	if (version < 43) {
+		glDrawElementsIndirect      = nullptr;
+		glMultiDrawElementsIndirect = nullptr;
+	}
+	(void)multi_draw_ext;
+#endif
+	// Separate vertex formats and buffers are core in GL 4.3 and GLES 3.1
+#if defined(_SKG_GL_ES)
+	gl_vertex_binding = version >= 31;
+	(void)vertex_binding_ext;
+#else
+	gl_vertex_binding = version >= 43 || vertex_binding_ext;
+#endif
+	gl_vertex_binding = gl_vertex_binding && glVertexAttribFormat && glVertexAttribIFormat && glVertexAttribBinding && glBindVertexBuffer;
+
+	// Sampler objects are core in GL 3.3 and GLES 3.0
+#if defined(_SKG_GL_ES)
+	gl_sampler_objects = version >= 30;
+	(void)sampler_ext;
+#else
+	gl_sampler_objects = version >= 33 || sampler_ext;
+#endif
+	gl_sampler_objects = gl_sampler_objects && glGenSamplers && glBindSampler && glSamplerParameteri;
+
+	// Multi-bind is core in GL 4.4, and isn't on GLES at all
+#if defined(_SKG_GL_ES)
+	gl_multi_bind = false;
+	(void)multi_bind_ext;
+#else
+	gl_multi_bind = version >= 44 || multi_bind_ext;
+#endif
+	gl_multi_bind = gl_multi_bind && gl_sampler_objects && glBindBuffersRange && glBindTextures && glBindSamplers;
+
+	// Program binaries are core in GL 4.1 and GLES 3.0, but a driver can
+	// still support zero binary formats, which makes them useless.
+#if defined(_SKG_GL_ES)
+	gl_program_binary = version >= 30;
+	(void)program_binary_ext;
+#else
+	gl_program_binary = version >= 41 || program_binary_ext;
+#endif
+	gl_program_binary = gl_program_binary && glGetProgramBinary && glProgramBinary && glProgramParameteri;
+	if (gl_program_binary) {
+		int32_t binary_formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+		gl_program_binary = binary_formats > 0;
 	}
+
+	// Parallel compiles let us poll a program instead of waiting on it, the
+	// thread limit starts out implementation defined, so ask for all of them.
+	if (glMaxShaderCompilerThreadsKHR == nullptr) glMaxShaderCompilerThreadsKHR = glMaxShaderCompilerThreadsARB;
+	gl_parallel_compile = parallel_ext && glMaxShaderCompilerThreadsKHR;
+	if (gl_parallel_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+	// Persistent mapping is core in GL 4.4, and an extension on GLES
+	if (glBufferStorage == nullptr) glBufferStorage = glBufferStorageEXT;
+	if (glBufferStorage == nullptr || glMapBufferRange == nullptr) gl_buffer_storage = false;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &gl_ssbo_align);
+#else
+	gl_buffer_storage = false;
+	gl_vertex_binding  = false;
+	gl_sampler_objects = true; // WebGL2 always has these
+	gl_multi_bind      = false;
+	gl_program_binary  = false; // WebGL doesn't expose program binaries
+	gl_parallel_compile = false;
+	(void)multi_draw_ext;
+	(void)vertex_binding_ext;
+	(void)sampler_ext;
+	(void)multi_bind_ext;
+	(void)program_binary_ext;
+	(void)parallel_ext;
+#endif
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &gl_ubo_align);
+	if (gl_ubo_align  <= 0) gl_ubo_align  = 256;
+	if (gl_ssbo_align <= 0) gl_ssbo_align = 256;
 	
 #ifndef _SKG_GL_WEB
 	// On some platforms, glPolygonMode is a function and not a function 
@@ -883,6 +1446,7 @@ void gl_check_exts() {
 ///////////////////////////////////////////
 
 int32_t skg_init(const char *app_name, void *adapter_id) {
+	SKG_TRACE_FUNC();
 #if   defined(_SKG_GL_LOAD_WGL)
 	int32_t result = gl_init_wgl();
 #elif defined(_SKG_GL_LOAD_EGL)
@@ -894,6 +1458,7 @@ int32_t skg_init(const char *app_name, void *adapter_id) {
 #endif
 	if (!result)
 		return result;
+	gl_render_thread = true;
 
 	// Load OpenGL function pointers
 #ifdef _SKG_GL_MAKE_FUNCTIONS
@@ -981,9 +1546,58 @@ const char* skg_adapter_name() {
 ///////////////////////////////////////////
 
 void skg_shutdown() {
+	SKG_TRACE_FUNC();
+	gl_destroy_flush();
 	free(gl_adapter_name); gl_adapter_name = nullptr;
 
+	for (int32_t i = 0; i < SKG_GL_TIMER_COUNT; i++) {
+		if (gl_timers[i].queries[0] != 0) glDeleteQueries(2, gl_timers[i].queries);
+		gl_timers[i] = {};
+	}
+	gl_timer_head         = 0;
+	gl_timer_tail         = 0;
+	gl_timer_stack_count  = 0;
+	gl_timer_result_count = 0;
+
+	if (gl_readback_fbo != 0) glDeleteFramebuffers(1, &gl_readback_fbo);
+	gl_readback_fbo = 0;
+	gl_transient_release();
+	free(gl_dirty_queue);
+	gl_dirty_queue       = nullptr;
+	gl_dirty_queue_count = 0;
+	gl_dirty_queue_cap   = 0;
+	for (int32_t i = 0; i < gl_layout_count; i++)
+		glDeleteVertexArrays(1, &gl_layouts[i].vao);
+	free(gl_layouts);
+	gl_layouts      = nullptr;
+	gl_layout_count = 0;
+	gl_layout_cap   = 0;
+	gl_layout_last  = 0;
+	for (int32_t i = 0; i < gl_sampler_count; i++)
+		glDeleteSamplers(1, &gl_samplers[i].sampler);
+	free(gl_samplers);
+	gl_samplers      = nullptr;
+	gl_sampler_count = 0;
+	gl_sampler_cap   = 0;
+	for (int32_t i = 0; i < gl_program_pending_count; i++)
+		free(gl_programs_pending[i].cache_file);
+	free(gl_programs_pending);
+	gl_programs_pending      = nullptr;
+	gl_program_pending_count = 0;
+	gl_program_pending_cap   = 0;
+	free(gl_programs_failed);
+	gl_programs_failed      = nullptr;
+	gl_program_failed_count = 0;
+	gl_program_failed_cap   = 0;
+	skg_vert_fmt_clear();
+
 	gl_pipeline = {};
+	gl_binds    = {};
+
+	gl_upload_mtx.lock();
+	gl_upload_context_destroy();
+	gl_upload_mtx.unlock();
+	gl_render_thread = false;
 
 #if defined(_SKG_GL_LOAD_WGL)
 	wglMakeCurrent(NULL, NULL);
@@ -1001,24 +1615,142 @@ void skg_shutdown() {
 		if (egl_context != EGL_NO_CONTEXT) eglDestroyContext(egl_display, egl_context);
 		eglTerminate(egl_display);
 	}
-	egl_display = EGL_NO_DISPLAY;
-	egl_context = EGL_NO_CONTEXT;
+	egl_display  = EGL_NO_DISPLAY;
+	egl_context  = EGL_NO_CONTEXT;
+	egl_headless = false;
+#endif
+}
+
+///////////////////////////////////////////
+
+void gl_timer_poll() {
+#if !defined(_SKG_GL_WEB)
+	// A disjoint event means the timestamps can't be trusted, so anything
+	// completed during it gets thrown away.
+	int32_t disjoint = 0;
+#if defined(_SKG_GL_ES)
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+#endif
+
+	// Timers complete in the order they were issued, so we can stop at the
+	// first one that isn't ready yet.
+	while (gl_timer_tail != gl_timer_head) {
+		gl_timer_t *timer = &gl_timers[gl_timer_tail % SKG_GL_TIMER_COUNT];
+		if (!timer->ended) break;
+
+		uint32_t available = 0;
+		glGetQueryObjectuiv(timer->queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+
+		uint64_t start = 0, end = 0;
+		glGetQueryObjectui64v(timer->queries[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(timer->queries[1], GL_QUERY_RESULT, &end);
+		if (!disjoint && gl_timer_result_count < SKG_GL_TIMER_COUNT) {
+			skg_timer_result_t *result = &gl_timer_results[gl_timer_result_count];
+			memcpy(result->name, timer->name, sizeof(result->name));
+			result->depth       = timer->depth;
+			result->frame       = timer->frame;
+			result->duration_ns = end > start ? end - start : 0;
+			gl_timer_result_count += 1;
+		}
+		timer->ended   = false;
+		gl_timer_tail += 1;
+	}
 #endif
 }
 
 ///////////////////////////////////////////
 
 void skg_draw_begin() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_frame());
+	if (gl_caps[skg_cap_gpu_timer]) gl_timer_poll();
+	gl_transient_frame();
+	gl_destroy_frame();
+	gl_frame += 1;
+}
+
+///////////////////////////////////////////
+
+void skg_deferred_destroy_enable(bool enabled) {
+	gl_destroy_deferred = enabled;
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_push(gl_destroy_t *item) {
+	item->next = gl_destroy_queue.load(std::memory_order_relaxed);
+	while (!gl_destroy_queue.compare_exchange_weak(item->next, item, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_release(gl_destroy_t *items) {
+	while (items != nullptr) {
+		gl_destroy_t *next = items->next;
+		switch (items->type) {
+		case gl_destroy_type_buffer: gl_buffer_destroy(&items->buffer); break;
+		case gl_destroy_type_tex:    gl_tex_destroy   (&items->tex);    break;
+		case gl_destroy_type_shader: gl_shader_destroy(&items->shader); break;
+		}
+		free(items);
+		items = next;
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_frame() {
+	// Fences pass in order, so stop at the first the GPU hasn't reached
+	int32_t done = 0;
+	while (done < gl_destroy_batch_count && glClientWaitSync(gl_destroy_batches[done].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED) {
+		glDeleteSync      (gl_destroy_batches[done].fence);
+		gl_destroy_release(gl_destroy_batches[done].items);
+		done += 1;
+	}
+	if (done > 0) {
+		gl_destroy_batch_count -= done;
+		memmove(gl_destroy_batches, &gl_destroy_batches[done], sizeof(gl_destroy_batch_t) * gl_destroy_batch_count);
+	}
+
+	// Everything queued since last frame was last used before this point
+	gl_destroy_t *items = gl_destroy_queue.exchange(nullptr, std::memory_order_acquire);
+	if (items == nullptr) return;
+
+	if (gl_destroy_batch_count + 1 > gl_destroy_batch_cap) {
+		gl_destroy_batch_cap = gl_destroy_batch_cap == 0 ? 4 : gl_destroy_batch_cap * 2;
+		gl_destroy_batches   = (gl_destroy_batch_t*)realloc(gl_destroy_batches, sizeof(gl_destroy_batch_t) * gl_destroy_batch_cap);
+	}
+	gl_destroy_batches[gl_destroy_batch_count] = { items, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) };
+	gl_destroy_batch_count += 1;
+}
+
+///////////////////////////////////////////
+
+void gl_destroy_flush() {
+	for (int32_t i = 0; i < gl_destroy_batch_count; i++) {
+		glDeleteSync      (gl_destroy_batches[i].fence);
+		gl_destroy_release(gl_destroy_batches[i].items);
+	}
+	gl_destroy_release(gl_destroy_queue.exchange(nullptr, std::memory_order_acquire));
+	free(gl_destroy_batches);
+	gl_destroy_batches     = nullptr;
+	gl_destroy_batch_count = 0;
+	gl_destroy_batch_cap   = 0;
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_target_discard(skg_tex_t *render_target) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_target_discard, skg_capture_id(render_target)));
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_target_bind(render_target ? skg_capture_id(render_target) : 0, layer_idx, mip_level));
 	gl_active_rendertarget = render_target;
 	gl_current_framebuffer = render_target == nullptr
 		? 0 
@@ -1043,12 +1775,14 @@ void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mi
 ///////////////////////////////////////////
 
 void skg_target_clear(bool depth, const float *clear_color_4) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_target_clear(depth, clear_color_4));
 	uint32_t clear_mask = 0;
 	if (depth) {
 		clear_mask = GL_DEPTH_BUFFER_BIT;
 		// If DepthMask is false, glClear won't clear depth
 		
-		PIPELINE_CHECK(gl_pipeline.depth_write, true)
+		PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_write, true)
 		glDepthMask(true);
 		PIPELINE_CHECK_END
 	}
@@ -1096,6 +1830,8 @@ bool skg_capability(skg_cap_ capability) {
 ///////////////////////////////////////////
 
 void skg_event_begin (const char *name) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_begin(name));
 #if defined(_DEBUG) && !defined(_SKG_GL_WEB)
 	if (glPushDebugGroupKHR)
 		glPushDebugGroupKHR(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
@@ -1105,6 +1841,8 @@ void skg_event_begin (const char *name) {
 ///////////////////////////////////////////
 
 void skg_event_end () {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_end());
 #if defined(_DEBUG) && !defined(_SKG_GL_WEB)
 	if (glPopDebugGroupKHR)
 		glPopDebugGroupKHR();
@@ -1113,130 +1851,1058 @@ void skg_event_end () {
 
 ///////////////////////////////////////////
 
-void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
-#ifdef _SKG_GL_WEB
-	glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, (void*)(index_start*sizeof(uint32_t)), instance_count);
-#else
-	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, (void*)(index_start*sizeof(uint32_t)), instance_count, index_base);
+void skg_timer_begin(const char *name) {
+	SKG_TRACE_FUNC();
+	if (!gl_caps[skg_cap_gpu_timer]) return;
+	if (gl_timer_stack_count >= SKG_GL_TIMER_DEPTH) {
+		skg_log(skg_log_warning, "skg_timer_begin nested too deeply, ignoring timer");
+		gl_timer_stack_count += 1;
+		return;
+	}
+
+	// If the GPU is so far behind that the ring is full of unread timers, we
+	// skip this one rather than wait for it.
+	if (gl_timer_head - gl_timer_tail >= SKG_GL_TIMER_COUNT) {
+		gl_timer_stack[gl_timer_stack_count++] = -1;
+		return;
+	}
+
+#if !defined(_SKG_GL_WEB)
+	int32_t     index = gl_timer_head % SKG_GL_TIMER_COUNT;
+	gl_timer_t *timer = &gl_timers[index];
+	if (timer->queries[0] == 0)
+		glGenQueries(2, timer->queries);
+	snprintf(timer->name, sizeof(timer->name), "%s", name ? name : "");
+	timer->depth = gl_timer_stack_count;
+	timer->frame = gl_frame;
+	timer->ended = false;
+	glQueryCounter(timer->queries[0], GL_TIMESTAMP);
+
+	gl_timer_head += 1;
+	gl_timer_stack[gl_timer_stack_count++] = index;
 #endif
 }
 
 ///////////////////////////////////////////
 
-void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
-	glDispatchCompute(thread_count_x, thread_count_y, thread_count_z);
-}
+void skg_timer_end() {
+	SKG_TRACE_FUNC();
+	if (!gl_caps[skg_cap_gpu_timer]) return;
+	if (gl_timer_stack_count <= 0) {
+		skg_log(skg_log_warning, "skg_timer_end called without a matching skg_timer_begin");
+		return;
+	}
 
-///////////////////////////////////////////
+	gl_timer_stack_count -= 1;
+	if (gl_timer_stack_count >= SKG_GL_TIMER_DEPTH) return;
+	int32_t index = gl_timer_stack[gl_timer_stack_count];
+	if (index < 0) return;
 
-void skg_viewport(const int32_t *xywh) {
-	glViewport(xywh[0], xywh[1], xywh[2], xywh[3]);
+#if !defined(_SKG_GL_WEB)
+	glQueryCounter(gl_timers[index].queries[1], GL_TIMESTAMP);
+	gl_timers[index].ended = true;
+#endif
 }
 
 ///////////////////////////////////////////
 
-void skg_viewport_get(int32_t *out_xywh) {
-	glGetIntegerv(GL_VIEWPORT, out_xywh);
+int32_t skg_timer_get_results(skg_timer_result_t *out_results, int32_t max_results) {
+	int32_t count = gl_timer_result_count < max_results ? gl_timer_result_count : max_results;
+	if (count <= 0) return 0;
+
+	memcpy(out_results, gl_timer_results, sizeof(skg_timer_result_t) * count);
+	gl_timer_result_count -= count;
+	memmove(gl_timer_results, &gl_timer_results[count], sizeof(skg_timer_result_t) * gl_timer_result_count);
+	return count;
 }
 
 ///////////////////////////////////////////
 
-void skg_scissor(const int32_t *xywh) {
-	int32_t viewport[4];
-	skg_viewport_get(viewport);
-	glScissor(xywh[0], (viewport[3]-xywh[1])-xywh[3], xywh[2], xywh[3]);
+void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw(index_start, index_base, index_count, instance_count));
+	_skg_stats.draws += 1;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_bind_flush();
+	gl_layout_apply();
+	gl_draw_elements(index_start, index_base, index_count, instance_count);
 }
 
 ///////////////////////////////////////////
 
-skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
-	skg_buffer_t result = {};
-	result.use     = use;
-	result.type    = type;
-	result.stride  = size_stride;
-	result._target = skg_buffer_type_to_gl(type);
-
-	glGenBuffers(1, &result._buffer);
-	glBindBuffer(result._target, result._buffer);
-	gl_pipeline.buffer_bind[result.type] = result._buffer;
-	glBufferData(result._target, size_count * size_stride, data, use == skg_use_static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-
-	return result;
+void gl_draw_elements(uint32_t index_start, int32_t index_base, uint32_t index_count, uint32_t instance_count) {
+#ifdef _SKG_GL_WEB
+	glDrawElementsInstanced(GL_TRIANGLES, index_count, gl_ind_type, (void*)(uint64_t)(index_start*gl_ind_size), instance_count);
+#else
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count, gl_ind_type, (void*)(uint64_t)(index_start*gl_ind_size), instance_count, index_base);
+#endif
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
-	if (buffer->_buffer != 0)
-		glObjectLabel(GL_BUFFER, buffer->_buffer, (uint32_t)strlen(name), name);
+void gl_ind_format_set(skg_ind_fmt_ format) {
+	switch (format) {
+	case skg_ind_fmt_u16: gl_ind_type = GL_UNSIGNED_SHORT; break;
+	case skg_ind_fmt_u8:  gl_ind_type = GL_UNSIGNED_BYTE;  break;
+	default:              gl_ind_type = GL_UNSIGNED_INT;   break;
+	}
+	gl_ind_size = skg_ind_fmt_size(format);
 }
 
 ///////////////////////////////////////////
 
-bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
-	return buffer->_buffer != 0;
+uint64_t gl_layout_inputs(const skg_shader_meta_t *meta) {
+	// FNV-1a over the input list, never 0, since that marks a layout that
+	// hasn't been pointed at any shader yet.
+	uint64_t hash = 14695981039346656037ULL;
+	int32_t  count = meta ? meta->vertex_input_count : 0;
+	for (int32_t i = 0; i < count; i++) {
+		const skg_vert_component_t *input = &meta->vertex_inputs[i];
+		uint8_t bytes[3] = { (uint8_t)input->semantic, input->semantic_slot, (uint8_t)input->format };
+		for (int32_t b = 0; b < 3; b++)
+			hash = (hash ^ bytes[b]) * 1099511628211ULL;
+	}
+	return hash == 0 ? 1 : hash;
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
-	if (buffer->use != skg_use_dynamic) {
-		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
-		return;
-	}
+void gl_layout_apply() {
+	gl_layout_t *layout = gl_pipeline.mesh;
+	if (gl_vertex_binding && gl_pipeline.mesh_verts != 0)
+		layout = gl_layout_find(gl_pipeline.mesh_fmt, gl_pipeline.inputs);
+	if (layout == nullptr) return;
+
+	PIPELINE_CHECK(skg_stat_layout, gl_pipeline.layout, layout->vao)
+	glBindVertexArray(layout->vao);
+	// The element buffer binding belongs to the VAO, so what's cached no
+	// longer says anything about it.
+	gl_pipeline.buffer_bind[skg_buffer_type_index] = SKG_GL_UNKNOWN;
+	PIPELINE_CHECK_END
+	if (layout->inputs != gl_pipeline.inputs) gl_layout_map(layout, gl_pipeline.inputs);
 
-	PIPELINE_CHECK(gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
-	glBindBuffer(buffer->_target, buffer->_buffer);
+#if !defined(_SKG_GL_WEB)
+	// Shared layouts only describe the format, the mesh's vertices are a
+	// single bind.
+	if (gl_vertex_binding) {
+		PIPELINE_CHECK(skg_stat_buffer, layout->vert_buffer, gl_pipeline.mesh_verts)
+		glBindVertexBuffer(0, gl_pipeline.mesh_verts, 0, skg_vert_fmt_get(gl_pipeline.mesh_fmt)->stride);
+		PIPELINE_CHECK_END
+	}
+#endif
+	PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_index], gl_pipeline.mesh_inds)
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl_pipeline.mesh_inds);
 	PIPELINE_CHECK_END
-	glBufferSubData(buffer->_target, 0, size_bytes, data);
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
-	if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute) {
-		glBindBufferBase(buffer->_target, bind.slot, buffer->_buffer);
-		gl_pipeline.buffer_bind[buffer->type] = buffer->_buffer;
-	} else {
-		PIPELINE_CHECK(gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
-		glBindBuffer(buffer->_target, buffer->_buffer);
-		PIPELINE_CHECK_END
+gl_layout_t *gl_layout_find(int32_t vert_fmt, uint64_t inputs) {
+	if (gl_layout_last < gl_layout_count &&
+		gl_layouts[gl_layout_last].vert_fmt == vert_fmt &&
+		gl_layouts[gl_layout_last].inputs   == inputs)
+		return &gl_layouts[gl_layout_last];
+
+	for (int32_t i = 0; i < gl_layout_count; i++) {
+		if (gl_layouts[i].vert_fmt == vert_fmt && gl_layouts[i].inputs == inputs) {
+			gl_layout_last = i;
+			return &gl_layouts[i];
+		}
+	}
+
+	if (gl_layout_count + 1 > gl_layout_cap) {
+		gl_layout_cap = gl_layout_cap == 0 ? 8 : gl_layout_cap * 2;
+		gl_layouts    = (gl_layout_t*)realloc(gl_layouts, sizeof(gl_layout_t) * gl_layout_cap);
 	}
+	gl_layout_t *layout = &gl_layouts[gl_layout_count];
+	*layout = {};
+	layout->vert_fmt = vert_fmt;
+	glGenVertexArrays(1, &layout->vao);
+	gl_layout_last   = gl_layout_count;
+	gl_layout_count += 1;
+	return layout;
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_clear(skg_bind_t bind) {
-	if (bind.stage_bits == skg_stage_compute) {
-		if (bind.register_type == skg_register_constant) {
-			glBindBufferBase(GL_UNIFORM_BUFFER, bind.slot, 0);
-			gl_pipeline.buffer_bind[skg_buffer_type_constant] = 0;
+void gl_layout_map(gl_layout_t *layout, uint64_t inputs) {
+	SKG_STAT_MISS(skg_stat_layout);
+	layout->inputs = inputs;
+
+	// The VAO is already bound. Without vertex binding points, attribute
+	// pointers read from whatever's on GL_ARRAY_BUFFER.
+	if (!gl_vertex_binding) {
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_vertex], layout->vert_buffer)
+		glBindBuffer(GL_ARRAY_BUFFER, layout->vert_buffer);
+		PIPELINE_CHECK_END
+	}
+
+	// Shader inputs are located in the order they're declared. Without
+	// any metadata to match semantics against, components map straight
+	// across.
+	const skg_vert_fmt_t    *fmt         = skg_vert_fmt_get(layout->vert_fmt);
+	const skg_shader_meta_t *meta        = gl_pipeline.meta && gl_pipeline.meta->vertex_input_count > 0 ? gl_pipeline.meta : nullptr;
+	int32_t                  input_count = meta ? meta->vertex_input_count : fmt->component_count;
+	uint32_t                 enabled     = 0;
+	for (int32_t loc = 0; loc < input_count && loc < SKG_GL_MAX_ATTRIBS; loc++) {
+		const skg_vert_component_t *input = meta ? &meta->vertex_inputs[loc] : nullptr;
+		int32_t                     id    = input ? skg_vert_fmt_find(fmt, input->semantic, input->semantic_slot) : loc;
+		if (id < 0) {
+			glVertexAttrib4f(loc, 1, 1, 1, 1);
+			continue;
 		}
-		if (bind.register_type == skg_register_readwrite) {
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bind.slot, 0);
-			gl_pipeline.buffer_bind[skg_buffer_type_compute] = 0;
+
+		const skg_vert_component_t *com        = &fmt->components[id];
+		uint32_t                    offset     = fmt->offsets[id];
+		uint32_t                    type       = skg_fmt_to_gl_type(com->format);
+		bool                        normalized =
+			com->format == skg_fmt_i16_normalized  || com->format == skg_fmt_i8_normalized ||
+			com->format == skg_fmt_ui16_normalized || com->format == skg_fmt_ui8_normalized;
+		bool                        integer    = input && (input->format == skg_fmt_i32 || input->format == skg_fmt_ui32)
+		                                      && type != GL_FLOAT && type != GL_HALF_FLOAT && !normalized;
+#if !defined(_SKG_GL_WEB)
+		if (gl_vertex_binding) {
+			if (integer) glVertexAttribIFormat(loc, com->count, type,             offset);
+			else         glVertexAttribFormat (loc, com->count, type, normalized, offset);
+			glVertexAttribBinding(loc, 0);
+			enabled |= 1 << loc;
+			continue;
 		}
+#endif
+		if (integer) glVertexAttribIPointer(loc, com->count, type,             fmt->stride, (void*)(uint64_t)offset);
+		else         glVertexAttribPointer (loc, com->count, type, normalized, fmt->stride, (void*)(uint64_t)offset);
+		enabled |= 1 << loc;
+	}
+	for (int32_t loc = 0; loc < SKG_GL_MAX_ATTRIBS; loc++) {
+		uint32_t bit = 1 << loc;
+		if      ( (enabled & bit) && !(layout->enabled & bit)) glEnableVertexAttribArray (loc);
+		else if (!(enabled & bit) &&  (layout->enabled & bit)) glDisableVertexAttribArray(loc);
 	}
+	layout->enabled = enabled;
 }
 
 ///////////////////////////////////////////
 
-void skg_buffer_destroy(skg_buffer_t *buffer) {
-	// If this buffer is currently bound, we unbind it and remove it from our
-	// pipeline cache to prevent accidental re-use of any kind.
-	if (gl_pipeline.buffer_bind[buffer->type] == buffer->_buffer) {
+void skg_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_indirect(args_buffer, offset, draw_count, stride));
+	if (args_buffer->type != skg_buffer_type_indirect) {
+		skg_log(skg_log_warning, "skg_draw_indirect needs a skg_buffer_type_indirect buffer");
+		return;
+	}
+	if (stride == 0) stride = sizeof(skg_draw_args_t);
+	if (draw_count == 0) return;
+	if (offset % 4 != 0 || stride % 4 != 0) {
+		skg_log(skg_log_warning, "skg_draw_indirect offset and stride need to be multiples of 4");
+		return;
+	}
+	if (offset + (uint64_t)stride * (draw_count - 1) + sizeof(skg_draw_args_t) > args_buffer->_size) {
+		skg_log(skg_log_warning, "skg_draw_indirect is reading past the end of the args buffer");
+		return;
+	}
+
+	_skg_stats.draws += draw_count;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_buffer_flush((skg_buffer_t*)args_buffer);
+	gl_bind_flush();
+	gl_layout_apply();
+
+#if !defined(_SKG_GL_WEB)
+	if (glDrawElementsIndirect) {
+		// Args written by a compute shader need to be visible to the
+		// command processor, not just other shaders.
+		if (gl_compute_pending && glMemoryBarrier) glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+		gl_compute_pending = false;
+
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_indirect], args_buffer->_buffer)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, args_buffer->_buffer);
+		PIPELINE_CHECK_END
+		if (glMultiDrawElementsIndirect) {
+			glMultiDrawElementsIndirect(GL_TRIANGLES, gl_ind_type, (void*)(uint64_t)offset, draw_count, stride);
+		} else {
+			for (uint32_t i = 0; i < draw_count; i++)
+				glDrawElementsIndirect(GL_TRIANGLES, gl_ind_type, (void*)(uint64_t)(offset + i * stride));
+		}
+		return;
+	}
+#endif
+
+	// No indirect draws on this device, so bring the args back and loop on
+	// the CPU. This waits on the GPU, but keeps GPU driven content working.
+	uint8_t *args = (uint8_t*)malloc(args_buffer->_size);
+	skg_buffer_get_contents(args_buffer, args, args_buffer->_size);
+	for (uint32_t i = 0; i < draw_count; i++) {
+		const skg_draw_args_t *draw = (const skg_draw_args_t*)(args + offset + i * stride);
+		gl_draw_elements(draw->index_start, draw->index_base, draw->index_count, draw->instance_count);
+	}
+	free(args);
+}
+
+///////////////////////////////////////////
+
+void skg_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_multi(draws, draw_count));
+	if (draw_count == 0) return;
+	_skg_stats.draws += draw_count;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_bind_flush();
+	gl_layout_apply();
+
+#if !defined(_SKG_GL_WEB)
+	// The args go through this frame's transient memory, so the whole list
+	// is one upload and one draw call.
+	if (glMultiDrawElementsIndirect) {
+		uint32_t offset = gl_transient_alloc(draws, sizeof(skg_draw_args_t) * draw_count, sizeof(uint32_t));
+		skg_stats_upload(sizeof(skg_draw_args_t) * draw_count);
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_indirect], gl_transient.buffer)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gl_transient.buffer);
+		PIPELINE_CHECK_END
+		glMultiDrawElementsIndirect(GL_TRIANGLES, gl_ind_type, (void*)(uint64_t)offset, draw_count, sizeof(skg_draw_args_t));
+		return;
+	}
+#endif
+	for (uint32_t i = 0; i < draw_count; i++)
+		gl_draw_elements(draws[i].index_start, draws[i].index_base, draws[i].index_count, draws[i].instance_count);
+}
+
+///////////////////////////////////////////
+
+void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_compute(thread_count_x, thread_count_y, thread_count_z));
+	_skg_stats.dispatches += 1;
+	if (gl_dirty_queue_count > 0) gl_dirty_flush_queue();
+	gl_bind_flush();
+	gl_compute_pending = true;
+	glDispatchCompute(thread_count_x, thread_count_y, thread_count_z);
+}
+
+///////////////////////////////////////////
+
+void skg_viewport(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_viewport, xywh));
+	glViewport(xywh[0], xywh[1], xywh[2], xywh[3]);
+}
+
+///////////////////////////////////////////
+
+void skg_viewport_get(int32_t *out_xywh) {
+	SKG_TRACE_FUNC();
+	glGetIntegerv(GL_VIEWPORT, out_xywh);
+}
+
+///////////////////////////////////////////
+
+void skg_scissor(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_scissor, xywh));
+	int32_t viewport[4];
+	skg_viewport_get(viewport);
+	glScissor(xywh[0], (viewport[3]-xywh[1])-xywh[3], xywh[2], xywh[3]);
+}
+
+///////////////////////////////////////////
+
+skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
+	SKG_TRACE_FUNC();
+	skg_buffer_t result = {};
+	result.use     = use;
+	result.type    = type;
+	result.stride  = size_stride;
+	result._target = skg_buffer_type_to_gl(type);
+	if (type == skg_buffer_type_index)
+		result._ind_format = skg_ind_fmt_from_stride(size_stride);
+
+	result._size   = size_count * size_stride;
+
+	glGenBuffers(1, &result._buffer);
+	glBindBuffer(result._target, result._buffer);
+	if (!gl_upload_thread) gl_pipeline.buffer_bind[result.type] = result._buffer;
+	glBufferData(result._target, result._size, data, use == skg_use_static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+	if (data) skg_stats_upload(result._size);
+	skg_mem_track(skg_mem_key(&result), skg_mem_buffer, result._size);
+
+	SKG_CAPTURE_CALL(skg_capture_buffer_create(&result, data, size_count, size_stride));
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(buffer), name);
+	if (buffer->_buffer != 0)
+		glObjectLabel(GL_BUFFER, buffer->_buffer, (uint32_t)strlen(name), name);
+}
+
+///////////////////////////////////////////
+
+bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
+	return buffer->_buffer != 0;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+	// Updates go through render thread state, like the binding cache and
+	// the transient buffer.
+	if (gl_upload_thread) {
+		skg_log(skg_log_warning, "Dynamic buffers can't be updated on an upload thread!");
+		return;
+	}
+
+	if (size_bytes > buffer->_size) {
+		skg_log(skg_log_warning, "Attempting to set more data than the buffer can hold!");
+		size_bytes = buffer->_size;
+	}
+
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_contents(buffer, data, size_bytes));
+	skg_stats_upload(size_bytes);
+	// Older ranged writes either get replaced outright, or need to land
+	// before this one.
+	if (buffer->_dirty && buffer->_dirty->range_count > 0) {
+		if (size_bytes == buffer->_size) buffer->_dirty->range_count = 0;
+		else                             gl_buffer_flush(buffer);
+	}
+
+	if (gl_buffer_storage) {
+		gl_buffer_stage(buffer->_buffer, 0, data, size_bytes);
+		return;
+	}
+
+	PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
+	glBindBuffer(buffer->_target, buffer->_buffer);
+	PIPELINE_CHECK_END
+	// Orphaning a fully overwritten buffer lets the driver hand us fresh
+	// memory instead of waiting on draws that still use the old contents.
+	if (size_bytes == buffer->_size)
+		glBufferData(buffer->_target, buffer->_size, nullptr, GL_DYNAMIC_DRAW);
+	glBufferSubData(buffer->_target, 0, size_bytes, data);
+}
+
+///////////////////////////////////////////
+
+void gl_buffer_stage(uint32_t buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	// The data lands in this frame's part of the persistently mapped
+	// transient buffer, and the GPU copies it over in order with the draws
+	// around it. Draws before this keep the old contents, draws after see
+	// the new ones, and the CPU never waits on either. Everything else that
+	// uses the copy targets binds them first, so they're left bound.
+	uint32_t src = gl_transient_alloc(data, size_bytes, 16);
+	glBindBuffer       (GL_COPY_READ_BUFFER,  gl_transient.buffer);
+	glBindBuffer       (GL_COPY_WRITE_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, src, offset, size_bytes);
+	// Indirect buffers can live on this target too, see skg_buffer_type_to_gl
+	gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+}
+
+///////////////////////////////////////////
+
+bool gl_dirty_add(gl_buffer_dirty_t *dirty, uint32_t start, uint32_t end) {
+	// Swallow any ranges this one touches
+	int32_t insert = 0;
+	for (int32_t i = 0; i < dirty->range_count; ) {
+		uint32_t *range = dirty->ranges[i];
+		if (range[1] < start) { insert = i + 1; i++; continue; }
+		if (range[0] > end  ) break;
+
+		if (range[0] < start) start = range[0];
+		if (range[1] > end  ) end   = range[1];
+		memmove(&dirty->ranges[i], &dirty->ranges[i + 1], sizeof(dirty->ranges[0]) * (dirty->range_count - i - 1));
+		dirty->range_count -= 1;
+	}
+	if (dirty->range_count == SKG_GL_DIRTY_RANGES)
+		return false;
+
+	memmove(&dirty->ranges[insert + 1], &dirty->ranges[insert], sizeof(dirty->ranges[0]) * (dirty->range_count - insert));
+	dirty->ranges[insert][0] = start;
+	dirty->ranges[insert][1] = end;
+	dirty->range_count += 1;
+	return true;
+}
+
+///////////////////////////////////////////
+
+void gl_dirty_upload(gl_buffer_dirty_t *dirty) {
+	if (dirty->range_count == 0) return;
+	if (gl_buffer_storage) {
+		for (int32_t i = 0; i < dirty->range_count; i++) {
+			uint32_t start = dirty->ranges[i][0];
+			uint32_t end   = dirty->ranges[i][1];
+			gl_buffer_stage(dirty->buffer, start, dirty->shadow + start, end - start);
+		}
+		dirty->range_count = 0;
+		return;
+	}
+
+	// The copy target leaves the cached vertex, index, and uniform bindings
+	// alone.
+	glBindBuffer(GL_COPY_WRITE_BUFFER, dirty->buffer);
+	for (int32_t i = 0; i < dirty->range_count; i++) {
+		uint32_t start = dirty->ranges[i][0];
+		uint32_t end   = dirty->ranges[i][1];
+		glBufferSubData(GL_COPY_WRITE_BUFFER, start, end - start, dirty->shadow + start);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	// Indirect buffers can live on this target too, see skg_buffer_type_to_gl
+	gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+	dirty->range_count = 0;
+}
+
+///////////////////////////////////////////
+
+void gl_buffer_flush(skg_buffer_t *buffer) {
+	gl_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr || dirty->range_count == 0) return;
+	SKG_TRACE_FUNC();
+	gl_dirty_upload(dirty);
+}
+
+///////////////////////////////////////////
+
+void gl_dirty_flush_queue() {
+	for (int32_t i = 0; i < gl_dirty_queue_count; i++) {
+		gl_dirty_upload(gl_dirty_queue[i]);
+		gl_dirty_queue[i]->queued = false;
+	}
+	gl_dirty_queue_count = 0;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents_range(skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+	// Updates go through render thread state, like the binding cache and
+	// the transient buffer.
+	if (gl_upload_thread) {
+		skg_log(skg_log_warning, "Dynamic buffers can't be updated on an upload thread!");
+		return;
+	}
+	if (offset > buffer->_size || size_bytes > buffer->_size - offset) {
+		skg_log(skg_log_warning, "skg_buffer_set_contents_range is writing outside of the buffer!");
+		return;
+	}
+	if (size_bytes == 0) return;
+
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_range(buffer, offset, data, size_bytes));
+	skg_stats_upload(size_bytes);
+
+	gl_buffer_dirty_t *dirty = buffer->_dirty;
+	if (dirty == nullptr) {
+		dirty = (gl_buffer_dirty_t*)calloc(1, sizeof(gl_buffer_dirty_t));
+		dirty->buffer   = buffer->_buffer;
+		dirty->shadow   = (uint8_t*)malloc(buffer->_size);
+		buffer->_dirty  = dirty;
+	}
+	memcpy(dirty->shadow + offset, data, size_bytes);
+	if (!gl_dirty_add(dirty, offset, offset + size_bytes)) {
+		// Out of ranges, so send what we have and start over
+		gl_buffer_flush(buffer);
+		gl_dirty_add(dirty, offset, offset + size_bytes);
+	}
+
+	if (!dirty->queued) {
+		if (gl_dirty_queue_count == gl_dirty_queue_cap) {
+			gl_dirty_queue_cap = gl_dirty_queue_cap == 0 ? 16 : gl_dirty_queue_cap * 2;
+			gl_dirty_queue     = (gl_buffer_dirty_t**)realloc(gl_dirty_queue, sizeof(gl_buffer_dirty_t*) * gl_dirty_queue_cap);
+		}
+		gl_dirty_queue[gl_dirty_queue_count++] = dirty;
+		dirty->queued = true;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	SKG_TRACE_FUNC();
+	uint32_t copy_size = buffer_size < buffer->_size ? buffer_size : buffer->_size;
+
+	if (buffer->_dirty && buffer->_dirty->range_count > 0) gl_dirty_upload(buffer->_dirty);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer->_buffer);
+#if defined(_SKG_GL_WEB)
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, copy_size, ref_buffer);
+#else
+	// Compute shaders may have written to this, and mapping doesn't wait
+	// for incoherent writes on its own.
+	if (glMemoryBarrier) glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	void *data = copy_size > 0 ? glMapBufferRange(GL_COPY_READ_BUFFER, 0, copy_size, GL_MAP_READ_BIT) : nullptr;
+	if (data) {
+		memcpy(ref_buffer, data, copy_size);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+	} else {
+		if (copy_size > 0) skg_log(skg_log_critical, "Failed to get contents of buffer");
+		copy_size = 0;
+	}
+#endif
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	if (copy_size < buffer_size) memset((uint8_t*)ref_buffer + copy_size, 0, buffer_size - copy_size);
+}
+
+///////////////////////////////////////////
+
+bool skg_buffer_read_async(const skg_buffer_t *buffer, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	uint32_t size = buffer->_size;
+	if (size == 0) return false;
+	// Pending writes are part of the contents, even if they haven't been
+	// uploaded yet.
+	gl_buffer_flush((skg_buffer_t*)buffer);
+
+	gl_readback_prepare(ref_readback, (size_t)size);
+	ref_readback->width  = size;
+	ref_readback->height = 1;
+	ref_readback->format = skg_tex_fmt_none;
+
+#if defined(_SKG_GL_WEB)
+	// WebGL can't map buffers, so this one has to wait on the GPU.
+	glBindBuffer      (GL_COPY_READ_BUFFER, buffer->_buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, ref_readback->_data);
+	glBindBuffer      (GL_COPY_READ_BUFFER, 0);
+#else
+	if (glMemoryBarrier) glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer       (GL_COPY_READ_BUFFER,  buffer->_buffer);
+	glBindBuffer       (GL_COPY_WRITE_BUFFER, ref_readback->_buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+	glBindBuffer       (GL_COPY_READ_BUFFER,  0);
+	glBindBuffer       (GL_COPY_WRITE_BUFFER, 0);
+	gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+	ref_readback->_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_bind, skg_capture_id(buffer), bind));
+	if (buffer->type == skg_buffer_type_indirect) {
+		// Indirect args are only bound to shaders for compute to fill them,
+		// draws bind them on their own.
+		gl_buffer_flush((skg_buffer_t*)buffer);
+		gl_bind_buffer(true, bind.slot, buffer->_buffer, 0, buffer->_size);
+	} else if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute) {
+		// Pending ranged writes land here, so everything written since the
+		// last bind costs at most one upload per dirty run.
+		gl_buffer_flush((skg_buffer_t*)buffer);
+		gl_bind_buffer(buffer->type == skg_buffer_type_compute, bind.slot, buffer->_buffer, 0, buffer->_size);
+	} else {
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[buffer->type], buffer->_buffer)
+		glBindBuffer(buffer->_target, buffer->_buffer);
+		PIPELINE_CHECK_END
+		if (buffer->type == skg_buffer_type_index) {
+			// Draws bind the mesh's index buffer, so this needs to replace it
+			gl_pipeline.mesh_inds = buffer->_buffer;
+			gl_ind_format_set(buffer->_ind_format);
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_bind_range(const skg_buffer_t *buffer, skg_bind_t bind, uint32_t offset, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_buffer_bind_range, skg_capture_id(buffer), bind, offset, size_bytes, nullptr));
+	if (buffer->type != skg_buffer_type_constant && buffer->type != skg_buffer_type_compute) {
+		skg_log(skg_log_warning, "skg_buffer_bind_range only works with constant and compute buffers");
+		return;
+	}
+#if !defined(NDEBUG)
+	if (offset % skg_buffer_range_align(buffer->type) != 0) skg_log(skg_log_critical, "skg_buffer_bind_range offset isn't aligned, see skg_buffer_range_align");
+	if (offset + size_bytes > buffer->_size) skg_log(skg_log_critical, "skg_buffer_bind_range range is outside of the buffer");
+#endif
+	gl_buffer_flush((skg_buffer_t*)buffer);
+	gl_bind_buffer(buffer->type == skg_buffer_type_compute, bind.slot, buffer->_buffer, offset, size_bytes);
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_buffer_range_align(skg_buffer_type_ type) {
+	switch (type) {
+	case skg_buffer_type_constant: return (uint32_t)gl_ubo_align;
+	case skg_buffer_type_compute:  return (uint32_t)gl_ssbo_align;
+	default:                       return 1;
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_bind_buffer(bool storage, uint32_t slot, uint32_t buffer, uint32_t offset, uint32_t size) {
+	if (slot >= SKG_GL_BIND_SLOTS) {
+		// Past the end of the cache, so this goes straight to GL
+		uint32_t target = storage ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+		SKG_STAT_MISS(skg_stat_buffer);
+		if (buffer == 0) glBindBufferBase (target, slot, 0);
+		else             glBindBufferRange(target, slot, buffer, offset, size);
+		gl_pipeline.buffer_bind[storage ? skg_buffer_type_compute : skg_buffer_type_constant] = buffer;
+		return;
+	}
+
+	gl_buffer_range_t range = { buffer, offset, size };
+	if (storage) { gl_binds.ssbo[slot] = range; gl_binds.ssbo_dirty |= 1u << slot; }
+	else         { gl_binds.ubo [slot] = range; gl_binds.ubo_dirty  |= 1u << slot; }
+}
+
+///////////////////////////////////////////
+
+void gl_bind_forget(uint32_t buffer) {
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if (gl_binds   .ubo      [i].buffer == buffer) gl_binds   .ubo      [i] = {};
+		if (gl_binds   .ssbo     [i].buffer == buffer) gl_binds   .ssbo     [i] = {};
+		if (gl_pipeline.ubo_bind [i].buffer == buffer) gl_pipeline.ubo_bind [i] = {};
+		if (gl_pipeline.ssbo_bind[i].buffer == buffer) gl_pipeline.ssbo_bind[i] = {};
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_bind_flush() {
+	if (gl_binds.tex_dirty  != 0) gl_bind_flush_textures();
+	if (gl_binds.ubo_dirty  != 0) gl_bind_flush_buffers(false);
+	if (gl_binds.ssbo_dirty != 0) gl_bind_flush_buffers(true);
+}
+
+///////////////////////////////////////////
+
+void gl_bind_flush_buffers(bool storage) {
+	gl_buffer_range_t *queue   = storage ? gl_binds.ssbo          : gl_binds.ubo;
+	gl_buffer_range_t *current = storage ? gl_pipeline.ssbo_bind  : gl_pipeline.ubo_bind;
+	uint32_t           target  = storage ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+	uint32_t          *dirty   = storage ? &gl_binds.ssbo_dirty   : &gl_binds.ubo_dirty;
+
+	uint32_t changed = 0;
+	int32_t  first   = SKG_GL_BIND_SLOTS;
+	int32_t  last    = -1;
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if ((*dirty & (1u << i)) == 0) continue;
+#if !defined(SKG_GL_EXPLICIT_STATE)
+		bool diff =
+			queue[i].buffer != current[i].buffer ||
+			queue[i].offset != current[i].offset ||
+			queue[i].size   != current[i].size;
+#else
+		bool diff = true;
+#endif
+		if (!gl_stat_check(skg_stat_buffer, diff)) continue;
+		changed |= 1u << i;
+		if (i < first) first = i;
+		last = i;
+	}
+	*dirty = 0;
+	if (changed == 0) return;
+
+#if !defined(_SKG_GL_WEB)
+	if (gl_multi_bind) {
+		// One call covers everything from the first change to the last,
+		// slots in between are handed their current value again.
+		uint32_t buffers[SKG_GL_BIND_SLOTS];
+		intptr_t offsets[SKG_GL_BIND_SLOTS];
+		intptr_t sizes  [SKG_GL_BIND_SLOTS];
+		for (int32_t i = first; i <= last; i++) {
+			current[i] = queue[i];
+			buffers[i - first] = queue[i].buffer;
+			offsets[i - first] = queue[i].offset;
+			// Drivers check sizes even on empty slots
+			sizes  [i - first] = queue[i].buffer != 0 ? queue[i].size : 1;
+		}
+		glBindBuffersRange(target, first, last - first + 1, buffers, offsets, sizes);
+		return;
+	}
+#endif
+
+	// These also change the generic binding point
+	for (int32_t i = first; i <= last; i++) {
+		if ((changed & (1u << i)) == 0) continue;
+		current[i] = queue[i];
+		if (queue[i].buffer == 0) glBindBufferBase (target, i, 0);
+		else                      glBindBufferRange(target, i, queue[i].buffer, queue[i].offset, queue[i].size);
+		gl_pipeline.buffer_bind[storage ? skg_buffer_type_compute : skg_buffer_type_constant] = queue[i].buffer;
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_bind_flush_textures() {
+	uint32_t tex_changed     = 0;
+	uint32_t sampler_changed = 0;
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if ((gl_binds.tex_dirty & (1u << i)) == 0) continue;
+#if !defined(SKG_GL_EXPLICIT_STATE)
+		bool tex_diff     = gl_binds.tex    [i] != gl_pipeline.tex_bind    [i];
+		bool sampler_diff = gl_binds.sampler[i] != gl_pipeline.sampler_bind[i];
+#else
+		bool tex_diff     = true;
+		bool sampler_diff = true;
+#endif
+		if (gl_stat_check(skg_stat_texture, tex_diff)) tex_changed |= 1u << i;
+		if (gl_sampler_objects && gl_stat_check(skg_stat_sampler, sampler_diff)) sampler_changed |= 1u << i;
+	}
+	gl_binds.tex_dirty = 0;
+
+#if !defined(_SKG_GL_WEB)
+	if (gl_multi_bind) {
+		uint32_t names[SKG_GL_BIND_SLOTS];
+		int32_t  first, last;
+		if (tex_changed != 0) {
+			for (first = 0;                     (tex_changed & (1u << first)) == 0; first++) {}
+			for (last  = SKG_GL_BIND_SLOTS - 1; (tex_changed & (1u << last )) == 0; last--)  {}
+			for (int32_t i = first; i <= last; i++) {
+				gl_pipeline.tex_bind[i] = gl_binds.tex[i];
+				names[i - first] = gl_binds.tex[i];
+			}
+			glBindTextures(first, last - first + 1, names);
+		}
+		if (sampler_changed != 0) {
+			for (first = 0;                     (sampler_changed & (1u << first)) == 0; first++) {}
+			for (last  = SKG_GL_BIND_SLOTS - 1; (sampler_changed & (1u << last )) == 0; last--)  {}
+			for (int32_t i = first; i <= last; i++) {
+				gl_pipeline.sampler_bind[i] = gl_binds.sampler[i];
+				names[i - first] = gl_binds.sampler[i];
+			}
+			glBindSamplers(first, last - first + 1, names);
+		}
+		return;
+	}
+#endif
+
+	for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+		if (tex_changed & (1u << i)) {
+			gl_pipeline.tex_bind[i] = gl_binds.tex[i];
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture  (gl_binds.tex_target[i], gl_binds.tex[i]);
+		}
+		if (sampler_changed & (1u << i)) {
+			gl_pipeline.sampler_bind[i] = gl_binds.sampler[i];
+			glBindSampler(i, gl_binds.sampler[i]);
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+void gl_transient_release() {
+	for (int32_t i = 0; i < gl_transient.retired_count; i++)
+		gl_transient_free(gl_transient.retired[i]);
+	free(gl_transient.retired);
+	for (int32_t i = 0; i < SKG_GL_TRANSIENT_FRAMES; i++) {
+		if (gl_transient.fences[i]) glDeleteSync(gl_transient.fences[i]);
+	}
+	if (gl_transient.buffer != 0) gl_transient_free(gl_transient.buffer);
+	gl_transient = {};
+}
+
+///////////////////////////////////////////
+
+void gl_transient_free(uint32_t buffer) {
+	if (gl_pipeline.buffer_bind[skg_buffer_type_constant] == buffer)
+		gl_pipeline.buffer_bind[skg_buffer_type_constant] = 0;
+	if (gl_pipeline.buffer_bind[skg_buffer_type_indirect] == buffer)
+		gl_pipeline.buffer_bind[skg_buffer_type_indirect] = 0;
+	gl_bind_forget(buffer);
+	skg_mem_release((uint64_t)buffer << 1);
+	glDeleteBuffers(1, &buffer);
+}
+
+///////////////////////////////////////////
+
+void gl_transient_grow(uint32_t min_size) {
+	SKG_TRACE_FUNC();
+	// GL keeps the old buffer alive for any draws still using it
+	uint32_t align = (uint32_t)gl_ubo_align;
+	uint32_t size  = gl_transient.frame_size * 2;
+	if (size < SKG_GL_TRANSIENT_MIN) size = SKG_GL_TRANSIENT_MIN;
+	if (size < min_size)             size = min_size;
+	size = ((size + align - 1) / align) * align;
+
+	// Bindings queued up for the next draw can still point at the old
+	// buffer, so it's retired until this frame ends instead of deleted.
+	for (int32_t i = 0; i < SKG_GL_TRANSIENT_FRAMES; i++) {
+		if (gl_transient.fences[i]) glDeleteSync(gl_transient.fences[i]);
+	}
+	uint32_t *retired       = gl_transient.retired;
+	int32_t   retired_count = gl_transient.retired_count;
+	if (gl_transient.buffer != 0) {
+		retired = (uint32_t*)realloc(retired, sizeof(uint32_t) * (retired_count + 1));
+		retired[retired_count] = gl_transient.buffer;
+		retired_count += 1;
+	}
+	gl_transient = {};
+	gl_transient.retired       = retired;
+	gl_transient.retired_count = retired_count;
+
+	int64_t total = (int64_t)size * SKG_GL_TRANSIENT_FRAMES;
+	gl_transient.frame_size = size;
+	glGenBuffers(1, &gl_transient.buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, gl_transient.buffer);
+	gl_pipeline.buffer_bind[skg_buffer_type_constant] = gl_transient.buffer;
+	if (gl_buffer_storage) {
+		uint32_t flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, total, nullptr, flags);
+		gl_transient.map = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, total, flags);
+	} else {
+		glBufferData(GL_UNIFORM_BUFFER, (int32_t)total, nullptr, GL_DYNAMIC_DRAW);
+	}
+	skg_mem_track((uint64_t)gl_transient.buffer << 1, skg_mem_buffer, total);
+	skg_mem_name ((uint64_t)gl_transient.buffer << 1, "skg_transient");
+}
+
+///////////////////////////////////////////
+
+void gl_transient_frame() {
+	for (int32_t i = 0; i < gl_transient.retired_count; i++)
+		gl_transient_free(gl_transient.retired[i]);
+	gl_transient.retired_count = 0;
+	gl_transient.frame_marked  = true;
+	if (gl_transient.buffer == 0) return;
+	gl_transient_advance();
+}
+
+///////////////////////////////////////////
+
+void gl_transient_advance() {
+	if (gl_transient.map) gl_transient.fences[gl_transient.frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_transient.frame_index = (gl_transient.frame_index + 1) % SKG_GL_TRANSIENT_FRAMES;
+	gl_transient.used        = 0;
+
+	void **fence = &gl_transient.fences[gl_transient.frame_index];
+	if (*fence) {
+		if (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+			SKG_TRACE_SCOPE("gl_transient_wait");
+			while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+		}
+		glDeleteSync(*fence);
+		*fence = nullptr;
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t gl_transient_alloc(const void *data, uint32_t size_bytes, uint32_t align) {
+	// Copies data into this frame's section, and returns where it landed
+	// from the start of the buffer.
+	uint32_t offset = ((gl_transient.used + align - 1) / align) * align;
+	if (gl_transient.buffer == 0 || offset + size_bytes > gl_transient.frame_size) {
+		// Running out once in a frame means frames need more room. Running
+		// out again before skg_draw_begin, or in an app that never calls
+		// it, moves on to the next section like a new frame would, instead
+		// of growing without end.
+		if (gl_transient.buffer != 0 && !gl_transient.frame_marked && size_bytes <= gl_transient.frame_size)
+			gl_transient_advance();
+		else
+			gl_transient_grow(size_bytes);
+		gl_transient.frame_marked = false;
+		offset = 0;
+	}
+	gl_transient.used = offset + size_bytes;
+	offset += gl_transient.frame_index * gl_transient.frame_size;
+
+	if (gl_transient.map) {
+		memcpy(gl_transient.map + offset, data, size_bytes);
+	} else {
+		PIPELINE_CHECK(skg_stat_buffer, gl_pipeline.buffer_bind[skg_buffer_type_constant], gl_transient.buffer)
+		glBindBuffer(GL_UNIFORM_BUFFER, gl_transient.buffer);
+		PIPELINE_CHECK_END
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size_bytes, data);
+	}
+	return offset;
+}
+
+///////////////////////////////////////////
+
+bool skg_transient_bind(const void *data, uint32_t size_bytes, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_transient_bind, 0, bind, 0, size_bytes, data));
+	if (bind.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_transient_bind only works with constant registers");
+		return false;
+	}
+
+	uint32_t offset = gl_transient_alloc(data, size_bytes, (uint32_t)gl_ubo_align);
+	gl_bind_buffer(false, bind.slot, gl_transient.buffer, offset, size_bytes);
+	skg_stats_upload(size_bytes);
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_clear, 0, bind));
+	if (bind.stage_bits == skg_stage_compute) {
+		if (bind.register_type == skg_register_constant) gl_bind_buffer(false, bind.slot, 0, 0, 0);
+		if (bind.register_type == skg_register_readwrite) gl_bind_buffer(true,  bind.slot, 0, 0, 0);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_destroy(skg_buffer_t *buffer) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_buffer_destroy, skg_capture_id(buffer)));
+	if (gl_destroy_deferred) {
+		gl_destroy_t *item = (gl_destroy_t*)calloc(1, sizeof(gl_destroy_t));
+		item->type   = gl_destroy_type_buffer;
+		item->buffer = *buffer;
+		gl_destroy_push(item);
+		*buffer = {};
+		return;
+	}
+	gl_buffer_destroy(buffer);
+}
+
+///////////////////////////////////////////
+
+void gl_buffer_destroy(skg_buffer_t *buffer) {
+	// If this buffer is currently bound, we unbind it and remove it from our
+	// pipeline cache to prevent accidental re-use of any kind.
+	if (gl_pipeline.buffer_bind[buffer->type] == buffer->_buffer) {
 		gl_pipeline.buffer_bind[buffer->type] = 0;
 		glBindBuffer(buffer->_target, 0);
 	}
+	// Deleting also drops it from indexed slots, and the name can be reused
+	if (buffer->type == skg_buffer_type_constant || buffer->type == skg_buffer_type_compute || buffer->type == skg_buffer_type_indirect)
+		gl_bind_forget(buffer->_buffer);
+	// Shared layouts that aren't bound keep a deleted buffer alive, and
+	// the name may come back for a new buffer, so they need a fresh bind.
+	if (buffer->type == skg_buffer_type_vertex) {
+		for (int32_t i = 0; i < gl_layout_count; i++) {
+			if (gl_layouts[i].vert_buffer == buffer->_buffer)
+				gl_layouts[i].vert_buffer = 0;
+		}
+	}
 
+	if (buffer->_dirty) {
+		for (int32_t i = 0; i < gl_dirty_queue_count; i++) {
+			if (gl_dirty_queue[i] == buffer->_dirty) {
+				gl_dirty_queue[i] = gl_dirty_queue[--gl_dirty_queue_count];
+				break;
+			}
+		}
+		free(buffer->_dirty->shadow);
+		free(buffer->_dirty);
+	}
 	uint32_t buffer_list[] = { buffer->_buffer };
 	glDeleteBuffers(1, buffer_list);
+	skg_mem_release(skg_mem_key(buffer));
 	*buffer = {};
 }
 
 ///////////////////////////////////////////
 
 skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
 	skg_mesh_t result = {};
 	skg_mesh_set_verts(&result, vert_buffer);
 	skg_mesh_set_inds (&result, ind_buffer);
@@ -1247,6 +2913,7 @@ skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *
 ///////////////////////////////////////////
 
 void skg_mesh_name(skg_mesh_t *mesh, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (mesh->_vert_buffer != 0) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_verts", name);
@@ -1261,67 +2928,79 @@ void skg_mesh_name(skg_mesh_t *mesh, const char* name) {
 ///////////////////////////////////////////
 
 void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
+	SKG_TRACE_FUNC();
 	mesh->_vert_buffer = vert_buffer ? vert_buffer->_buffer : 0;
-	if (mesh->_vert_buffer != 0) {
-		if (mesh->_layout != 0) {
-			glDeleteVertexArrays(1, &mesh->_layout);
-			mesh->_layout = 0;
-		}
-
-		PIPELINE_CHECK(gl_pipeline.buffer_bind[skg_buffer_type_vertex], mesh->_vert_buffer)
-		glBindBuffer(GL_ARRAY_BUFFER, mesh->_vert_buffer);
-		PIPELINE_CHECK_END
-
-		// Create a vertex layout
-		glGenVertexArrays(1, &mesh->_layout);
-		glBindVertexArray(mesh->_layout);
-		gl_pipeline.layout = mesh->_layout;
-		// enable the vertex data for the shader
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-		glEnableVertexAttribArray(3);
-		// tell the shader how our vertex data binds to the shader inputs
-		glVertexAttribPointer(0, 3, GL_FLOAT,         0, sizeof(skg_vert_t), nullptr);
-		glVertexAttribPointer(1, 3, GL_FLOAT,         0, sizeof(skg_vert_t), (void*)(sizeof(float) * 3));
-		glVertexAttribPointer(2, 2, GL_FLOAT,         0, sizeof(skg_vert_t), (void*)(sizeof(float) * 6));
-		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, 1, sizeof(skg_vert_t), (void*)(sizeof(float) * 8));
+	// With vertex binding points, layouts are shared by format, and the
+	// buffer is bound on its own at draw time.
+	if (gl_vertex_binding) return;
+
+	if (mesh->_vert_buffer != 0 && mesh->_layout == nullptr) {
+		mesh->_layout = (gl_layout_t*)calloc(1, sizeof(gl_layout_t));
+		mesh->_layout->vert_fmt = mesh->_vert_fmt;
+		glGenVertexArrays(1, &mesh->_layout->vao);
+	}
+	// Attributes get pointed at the buffer on the next draw, once the
+	// shader they need to feed is known.
+	if (mesh->_layout != nullptr) {
+		mesh->_layout->vert_buffer = mesh->_vert_buffer;
+		mesh->_layout->inputs      = 0;
 	}
 }
 
 ///////////////////////////////////////////
 
 void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
 	mesh->_ind_buffer = ind_buffer ? ind_buffer->_buffer : 0;
+	mesh->_ind_format = ind_buffer ? ind_buffer->_ind_format : skg_ind_fmt_u32;
 }
 
 ///////////////////////////////////////////
 
-void skg_mesh_bind(const skg_mesh_t *mesh) {
-	PIPELINE_CHECK(gl_pipeline.layout, mesh->_layout)
-	glBindVertexArray(mesh->_layout);
-	PIPELINE_CHECK_END
+void skg_mesh_set_format(skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count) {
+	SKG_TRACE_FUNC();
+	int32_t fmt = skg_vert_fmt_register(components, component_count);
+	if (fmt < 0) return;
 
-	PIPELINE_CHECK(gl_pipeline.buffer_bind[skg_buffer_type_vertex], mesh->_vert_buffer)
-	glBindBuffer(GL_ARRAY_BUFFER, mesh->_vert_buffer);
-	PIPELINE_CHECK_END
-	
-	PIPELINE_CHECK(gl_pipeline.buffer_bind[skg_buffer_type_index], mesh->_ind_buffer)
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->_ind_buffer );
-	PIPELINE_CHECK_END
+	mesh->_vert_fmt = fmt;
+	if (mesh->_layout != nullptr) {
+		mesh->_layout->vert_fmt = fmt;
+		mesh->_layout->inputs   = 0;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_bind(const skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_mesh_bind(mesh->_vert_buffer, mesh->_ind_buffer, mesh->_vert_fmt));
+	// Which VAO this needs depends on the shader too, so the GL work waits
+	// for the draw.
+	gl_pipeline.mesh       = mesh->_layout;
+	gl_pipeline.mesh_verts = mesh->_vert_buffer;
+	gl_pipeline.mesh_inds  = mesh->_ind_buffer;
+	gl_pipeline.mesh_fmt   = mesh->_vert_fmt;
+	gl_ind_format_set(mesh->_ind_format);
 }
 
 ///////////////////////////////////////////
 
 void skg_mesh_destroy(skg_mesh_t *mesh) {
-	// If this layout is currently bound, unbind it before deleting.
-	if (gl_pipeline.layout == mesh->_layout){
-		gl_pipeline.layout = 0;
-		glBindVertexArray(0);
-	}
+	SKG_TRACE_FUNC();
+	if (mesh->_layout != nullptr) {
+		// If this layout is currently bound, unbind it before deleting.
+		if (gl_pipeline.layout == mesh->_layout->vao) {
+			gl_pipeline.layout = 0;
+			gl_pipeline.buffer_bind[skg_buffer_type_index] = SKG_GL_UNKNOWN;
+			glBindVertexArray(0);
+		}
+		if (gl_pipeline.mesh == mesh->_layout)
+			gl_pipeline.mesh = nullptr;
 
-	uint32_t vao_list[] = {mesh->_layout};
-	glDeleteVertexArrays(1, vao_list);
+		uint32_t vao_list[] = {mesh->_layout->vao};
+		glDeleteVertexArrays(1, vao_list);
+		free(mesh->_layout);
+	}
 	*mesh = {};
 }
 
@@ -1329,16 +3008,31 @@ void skg_mesh_destroy(skg_mesh_t *mesh) {
 // skg_shader_t                          //
 ///////////////////////////////////////////
 
-skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
-	const char *file_chars = (const char *)file_data;
+bool gl_shader_check(uint32_t shader) {
+	// check for errors?
+	int32_t err, length;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &err);
+	if (err == 0) {
+		char *log;
 
-	skg_shader_stage_t result = {}; 
-	result.type = type;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		log = (char*)malloc(length);
+		glGetShaderInfoLog(shader, length, &err, log);
 
-	// Include terminating character
-	if (shader_size > 0 && file_chars[shader_size-1] != '\0')
-		shader_size += 1;
+		// Trim trailing newlines, we've already got that covered
+		size_t len = strlen(log);
+		while(len > 0 && log[len-1] == '\n') { log[len-1] = '\0'; len -= 1; }
+
+		skg_logf(skg_log_warning, "Unable to compile shader (%d):\n%s", err, log);
+		free(log);
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
 
+uint32_t gl_shader_compile(const char *source, skg_stage_ type) {
 	uint32_t gl_type = 0;
 	switch (type) {
 	case skg_stage_pixel:   gl_type = GL_FRAGMENT_SHADER; break;
@@ -1346,6 +3040,46 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 	case skg_stage_compute: gl_type = GL_COMPUTE_SHADER;  break;
 	}
 
+	// create and compile the vertex shader
+	SKG_TRACE_SCOPE("gl_shader_compile");
+	uint32_t shader = glCreateShader(gl_type);
+	try {
+		glShaderSource (shader, 1, &source, NULL);
+		glCompileShader(shader);
+	} catch (...) {
+		// Some GL drivers have a habit of crashing during shader compile.
+		const char *stage_name = "";
+		switch (type) {
+			case skg_stage_pixel:   stage_name = "Pixel";   break;
+			case skg_stage_vertex:  stage_name = "Vertex";  break;
+			case skg_stage_compute: stage_name = "Compute"; break; }
+		skg_logf(skg_log_warning, "%s shader compile exception", stage_name);
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	// Parallel compiles are checked when the program links, asking now
+	// would wait on the compile.
+	if (!gl_parallel_compile && !gl_shader_check(shader)) {
+		glDeleteShader(shader);
+		shader = 0;
+	}
+	return shader;
+}
+
+///////////////////////////////////////////
+
+skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
+	SKG_TRACE_FUNC();
+	const char *file_chars = (const char *)file_data;
+
+	skg_shader_stage_t result = {}; 
+	result.type = type;
+
+	// Include terminating character
+	if (shader_size > 0 && file_chars[shader_size-1] != '\0')
+		shader_size += 1;
+
 	// Convert the prefix if it doesn't match the GL version we're using
 #if   defined(_SKG_GL_ES)
 	const char   *prefix_gl      = "#version 310 es";
@@ -1369,114 +3103,166 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 		needs_free = true;
 	}
 
-	// create and compile the vertex shader
-	result._shader = glCreateShader(gl_type);
-	try {
-		glShaderSource (result._shader, 1, &final_data, NULL);
-		glCompileShader(result._shader);
-	} catch (...) {
-		// Some GL drivers have a habit of crashing during shader compile.
-		const char *stage_name = "";
-		switch (type) {
-			case skg_stage_pixel:   stage_name = "Pixel";   break;
-			case skg_stage_vertex:  stage_name = "Vertex";  break;
-			case skg_stage_compute: stage_name = "Compute"; break; }
-		skg_logf(skg_log_warning, "%s shader compile exception", stage_name);
-		glDeleteShader(result._shader);
-		result._shader = 0;
-		if (needs_free)
-			free(final_data);
+	// With the program cache on, compiling waits until
+	// skg_shader_create_manual knows whether the program is already cached.
+	if (gl_program_binary && skg_shader_cache_folder() != nullptr) {
+		if (!needs_free) {
+			size_t len = strlen(final_data);
+			final_data = (char*)malloc(len + 1);
+			memcpy(final_data, file_chars, len + 1);
+		}
+		result._source = final_data;
 		return result;
 	}
 
-	// check for errors?
-	int32_t err, length;
-	glGetShaderiv(result._shader, GL_COMPILE_STATUS, &err);
-	if (err == 0) {
-		char *log;
+	result._shader = gl_shader_compile(final_data, type);
+	if (needs_free)
+		free(final_data);
 
-		glGetShaderiv(result._shader, GL_INFO_LOG_LENGTH, &length);
-		log = (char*)malloc(length);
-		glGetShaderInfoLog(result._shader, length, &err, log);
+	return result;
+}
 
-		// Trim trailing newlines, we've already got that covered
-		size_t len = strlen(log);
-		while(len > 0 && log[len-1] == '\n') { log[len-1] = '\0'; len -= 1; }
+///////////////////////////////////////////
 
-		skg_logf(skg_log_warning, "Unable to compile shader (%d):\n%s", err, log);
-		free(log);
+void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+	SKG_TRACE_FUNC();
+	//glDeleteShader(shader->shader);
+	free(shader->_source);
+	*shader = {};
+}
+
+///////////////////////////////////////////
+
+#if !defined(_SKG_GL_WEB)
 
-		glDeleteShader(result._shader);
-		result._shader = 0;
+#define SKG_GL_PROGRAM_MAGIC   0x50474B53 // "SKGP"
+#define SKG_GL_PROGRAM_VERSION 1
+
+typedef struct gl_program_file_t {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;
+	uint32_t size;
+} gl_program_file_t;
+
+uint64_t gl_program_hash(uint64_t hash, const char *string) {
+	if (string == nullptr) string = "";
+	while (*string != '\0') {
+		hash = (hash ^ (uint8_t)*string) * 1099511628211;
+		string++;
 	}
-	if (needs_free)
-		free(final_data);
+	// Separate strings, so "ab"+"c" and "a"+"bc" don't collide
+	return (hash ^ 0xFF) * 1099511628211;
+}
 
-	return result;
+///////////////////////////////////////////
+
+// Binaries are only valid for the driver that made them, so the driver's
+// identity is part of the key along with each stage's source.
+uint64_t gl_program_key(const skg_shader_stage_t **stages, int32_t stage_count) {
+	uint64_t hash = 14695981039346656037UL;
+	hash = gl_program_hash(hash, (const char *)glGetString(GL_VENDOR));
+	hash = gl_program_hash(hash, (const char *)glGetString(GL_RENDERER));
+	hash = gl_program_hash(hash, (const char *)glGetString(GL_VERSION));
+	for (int32_t i = 0; i < stage_count; i++) {
+		hash = (hash ^ (uint64_t)(stages[i]->type + 1)) * 1099511628211;
+		hash = gl_program_hash(hash, stages[i]->_source);
+	}
+	return hash;
 }
 
 ///////////////////////////////////////////
 
-void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
-	//glDeleteShader(shader->shader);
-	*shader = {};
+bool gl_program_load(uint32_t program, const char *filename, uint64_t key) {
+	SKG_TRACE_FUNC();
+	void  *data = nullptr;
+	size_t size = 0;
+	if (!skg_read_file(filename, &data, &size))
+		return false;
+
+	gl_program_file_t header = {};
+	if (size >= sizeof(header))
+		memcpy(&header, data, sizeof(header));
+	bool valid = size >= sizeof(header)
+		&& header.magic   == SKG_GL_PROGRAM_MAGIC
+		&& header.version == SKG_GL_PROGRAM_VERSION
+		&& header.key     == key
+		&& header.size    == size - sizeof(header);
+
+	int32_t linked = 0;
+	if (valid) {
+		glProgramBinary(program, header.format, (uint8_t*)data + sizeof(header), (int32_t)header.size);
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	}
+	free(data);
+
+	// Driver updates are the usual reason for this, so it's not a warning
+	if (linked == 0)
+		skg_logf(skg_log_info, "Program cache rejected %s, recompiling.", filename);
+	return linked != 0;
 }
 
 ///////////////////////////////////////////
 
-skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
-	if (v_shader._shader == 0 && p_shader._shader == 0 && c_shader._shader == 0) {
-#if   defined(_SKG_GL_ES)
-		const char   *gl_name      = "GLES";
-#elif defined(_SKG_GL_DESKTOP)
-		const char   *gl_name      = "OpenGL";
-#elif defined(_SKG_GL_WEB)
-		const char   *gl_name      = "WebGL";
+void gl_program_save(uint32_t program, const char *filename, uint64_t key) {
+	SKG_TRACE_FUNC();
+	int32_t length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	gl_program_file_t header = {};
+	header.magic   = SKG_GL_PROGRAM_MAGIC;
+	header.version = SKG_GL_PROGRAM_VERSION;
+	header.key     = key;
+
+	uint8_t *data = (uint8_t*)malloc(sizeof(header) + length);
+	glGetProgramBinary(program, length, &length, &header.format, data + sizeof(header));
+	header.size = (uint32_t)length;
+	memcpy(data, &header, sizeof(header));
+
+	if (!skg_write_file(filename, data, sizeof(header) + length))
+		skg_logf(skg_log_warning, "Couldn't write program cache file %s", filename);
+	free(data);
+}
+
 #endif
-		skg_logf(skg_log_warning, "Shader '%s' has no valid stages for %s!", meta->name, gl_name);
-		return {};
-	}
 
-	skg_shader_t result = {};
-	result.meta     = meta;
-	result._vertex  = v_shader._shader;
-	result._pixel   = p_shader._shader;
-	result._compute = c_shader._shader;
-	skg_shader_meta_reference(result.meta);
+///////////////////////////////////////////
 
-	result._program = glCreateProgram();
-	if (result._vertex)  glAttachShader(result._program, result._vertex);
-	if (result._pixel)   glAttachShader(result._program, result._pixel);
-	if (result._compute) glAttachShader(result._program, result._compute);
-	try {
-		glLinkProgram(result._program);
-	} catch (...) {
-		// Some GL drivers have a habit of crashing during shader compile.
-		skg_logf(skg_log_warning, "Shader link exception in %s:", meta->name);
-		glDeleteProgram(result._program);
-		result._program = 0;
-		return result;
-	}
+// Checks the link, and sets up everything that needs a linked program.
+bool gl_program_setup(uint32_t program, skg_shader_meta_t *meta, const uint32_t *stages, const char *cache_file, uint64_t cache_key) {
+	SKG_TRACE_SCOPE_DETAIL("gl_program_setup", meta->name);
 
 	// check for errors?
 	int32_t err, length;
-	glGetProgramiv(result._program, GL_LINK_STATUS, &err);
+	glGetProgramiv(program, GL_LINK_STATUS, &err);
 	if (err == 0) {
+		// Parallel compiles skip the stage checks, so report them here
+		if (gl_parallel_compile) {
+			for (int32_t i = 0; i < 3; i++)
+				if (stages[i]) gl_shader_check(stages[i]);
+		}
+
 		char *log;
 
-		glGetProgramiv(result._program, GL_INFO_LOG_LENGTH, &length);
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
 		log = (char*)malloc(length);
-		glGetProgramInfoLog(result._program, length, &err, log);
+		glGetProgramInfoLog(program, length, &err, log);
 
 		skg_logf(skg_log_warning, "Unable to link %s:", meta->name);
 		skg_log(skg_log_warning, log);
 		free(log);
 
-		glDeleteProgram(result._program);
-		result._program = 0;
-
-		return result;
+		return false;
 	}
+#if !defined(_SKG_GL_WEB)
+	if (cache_file)
+		gl_program_save(program, cache_file, cache_key);
+#else
+	(void)cache_file;
+	(void)cache_key;
+#endif
 
 	// Set buffer binds
 	char t_name[64];
@@ -1491,42 +3277,212 @@ skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_
 			pr++;
 		}
 
-		uint32_t slot = glGetUniformBlockIndex(result._program, t_name);
+		uint32_t slot = glGetUniformBlockIndex(program, t_name);
 		if (slot != GL_INVALID_INDEX) {
-			glUniformBlockBinding(result._program, slot, meta->buffers[i].bind.slot);
+			glUniformBlockBinding(program, slot, meta->buffers[i].bind.slot);
 		} else {
 			skg_logf(skg_log_warning, "Couldn't find uniform block index for: %s", meta->buffers[i].name);
 		}
 	}
 
-	// Set sampler uniforms
-	PIPELINE_CHECK(gl_pipeline.program, result._program)
-		glUseProgram(result._program);
+	// Set sampler uniforms. GL 4.1 and GLES 3.1 can do this without binding
+	// the program, which matters when setup happens mid-frame.
+#if defined(_SKG_GL_WEB)
+	PIPELINE_CHECK(skg_stat_program, gl_pipeline.program, program)
+		glUseProgram(program);
 	PIPELINE_CHECK_END
+#endif
 	for (uint32_t i = 0; i < meta->resource_count; i++) {
-		int32_t loc = glGetUniformLocation(result._program, meta->resources[i].name);
+		int32_t loc = glGetUniformLocation(program, meta->resources[i].name);
 		if (loc == -1) {
 			// Sometimes the shader compiler will prefix the variable with an
 			// _, particularly if it overlaps with a keyword of some sort.
 			snprintf(t_name, 64, "_%s", meta->resources[i].name);
-			loc = glGetUniformLocation(result._program, t_name);
+			loc = glGetUniformLocation(program, t_name);
 		}
 
 		if (loc != -1) {
+#if defined(_SKG_GL_WEB)
 			glUniform1i(loc, meta->resources[i].bind.slot);
+#else
+			glProgramUniform1i(program, loc, meta->resources[i].bind.slot);
+#endif
 		} else {
 			// This may not be much of an issue under current usage patterns,
 			// but could cause problems for compute shaders later on.
 			skg_logf(skg_log_warning, "Couldn't find uniform location for: %s (is it a compute shader buffer?)", meta->resources[i].name);
 		}
 	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+void gl_program_pending_add(uint32_t program, skg_shader_meta_t *meta, const uint32_t *stages, const char *cache_file, uint64_t cache_key) {
+	if (gl_program_pending_count + 1 > gl_program_pending_cap) {
+		gl_program_pending_cap = gl_program_pending_cap == 0 ? 16 : gl_program_pending_cap * 2;
+		gl_programs_pending    = (gl_program_pending_t*)realloc(gl_programs_pending, sizeof(gl_program_pending_t) * gl_program_pending_cap);
+	}
+	gl_program_pending_t *item = &gl_programs_pending[gl_program_pending_count];
+	*item = {};
+	item->program   = program;
+	item->meta      = meta;
+	item->cache_key = cache_key;
+	memcpy(item->stages, stages, sizeof(item->stages));
+	if (cache_file) {
+		size_t len = strlen(cache_file);
+		item->cache_file = (char*)malloc(len + 1);
+		memcpy(item->cache_file, cache_file, len + 1);
+	}
+	gl_program_pending_count += 1;
+}
+
+///////////////////////////////////////////
+
+int32_t gl_program_pending_find(uint32_t program) {
+	if (program == 0) return -1;
+	for (int32_t i = 0; i < gl_program_pending_count; i++) {
+		if (gl_programs_pending[i].program == program) return i;
+	}
+	return -1;
+}
+
+///////////////////////////////////////////
+
+void gl_program_pending_remove(int32_t index) {
+	free(gl_programs_pending[index].cache_file);
+	gl_programs_pending[index] = gl_programs_pending[gl_program_pending_count - 1];
+	gl_program_pending_count -= 1;
+}
+
+///////////////////////////////////////////
+
+int32_t gl_program_failed_find(uint32_t program) {
+	if (program == 0) return -1;
+	for (int32_t i = 0; i < gl_program_failed_count; i++) {
+		if (gl_programs_failed[i] == program) return i;
+	}
+	return -1;
+}
+
+///////////////////////////////////////////
+
+// Waits on a pending program and finishes setting it up. Returns false if
+// the program failed to link.
+bool gl_program_finish(uint32_t program) {
+	if (gl_program_failed_count > 0 && gl_program_failed_find(program) >= 0) return false;
+	if (gl_program_pending_count == 0) return true;
+	int32_t index = gl_program_pending_find(program);
+	if (index < 0) return true;
+
+	gl_program_pending_t *item = &gl_programs_pending[index];
+	bool linked = gl_program_setup(item->program, item->meta, item->stages, item->cache_file, item->cache_key);
+	gl_program_pending_remove(index);
+	if (!linked) {
+		if (gl_program_failed_count == gl_program_failed_cap) {
+			gl_program_failed_cap = gl_program_failed_cap == 0 ? 4 : gl_program_failed_cap * 2;
+			gl_programs_failed    = (uint32_t*)realloc(gl_programs_failed, sizeof(uint32_t) * gl_program_failed_cap);
+		}
+		gl_programs_failed[gl_program_failed_count++] = program;
+	}
+	return linked;
+}
+
+///////////////////////////////////////////
+
+skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
+	SKG_TRACE_FUNC();
+	bool deferred = v_shader._source || p_shader._source || c_shader._source;
+	if (v_shader._shader == 0 && p_shader._shader == 0 && c_shader._shader == 0 && !deferred) {
+#if   defined(_SKG_GL_ES)
+		const char   *gl_name      = "GLES";
+#elif defined(_SKG_GL_DESKTOP)
+		const char   *gl_name      = "OpenGL";
+#elif defined(_SKG_GL_WEB)
+		const char   *gl_name      = "WebGL";
+#endif
+		skg_logf(skg_log_warning, "Shader '%s' has no valid stages for %s!", meta->name, gl_name);
+		return {};
+	}
+
+	skg_shader_t result = {};
+	result.meta     = meta;
+	result._vertex  = v_shader._shader;
+	result._pixel   = p_shader._shader;
+	result._compute = c_shader._shader;
+	result._inputs  = gl_layout_inputs(meta);
+	skg_shader_meta_reference(result.meta);
+
+	// Drivers often defer the real link work until the program's status is
+	// queried, so unless the link is left to run in parallel, this covers
+	// everything through to the uniform setup.
+	SKG_TRACE_SCOPE_DETAIL("gl_program_link", meta->name);
+	result._program = glCreateProgram();
+
+	// Stages deferred by the program cache only compile when the cached
+	// binary is missing, or the driver rejects it.
+	bool     loaded          = false;
+	char     cache_file[1024] = "";
+	uint64_t cache_key       = 0;
+#if !defined(_SKG_GL_WEB)
+	if (deferred) {
+		const skg_shader_stage_t *stages[3];
+		int32_t                   stage_count = 0;
+		if (v_shader._source) stages[stage_count++] = &v_shader;
+		if (p_shader._source) stages[stage_count++] = &p_shader;
+		if (c_shader._source) stages[stage_count++] = &c_shader;
+		cache_key = gl_program_key(stages, stage_count);
+		snprintf(cache_file, sizeof(cache_file), "%s/%016llx.skgp", skg_shader_cache_folder(), (unsigned long long)cache_key);
+
+		loaded = gl_program_load(result._program, cache_file, cache_key);
+		if (!loaded) {
+			// A rejected binary can leave the program in an odd state
+			glDeleteProgram(result._program);
+			result._program = glCreateProgram();
+			glProgramParameteri(result._program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+			if (v_shader._source) result._vertex  = gl_shader_compile(v_shader._source, v_shader.type);
+			if (p_shader._source) result._pixel   = gl_shader_compile(p_shader._source, p_shader.type);
+			if (c_shader._source) result._compute = gl_shader_compile(c_shader._source, c_shader.type);
+		}
+	}
+#endif
+
+	if (!loaded) {
+		if (result._vertex)  glAttachShader(result._program, result._vertex);
+		if (result._pixel)   glAttachShader(result._program, result._pixel);
+		if (result._compute) glAttachShader(result._program, result._compute);
+		try {
+			glLinkProgram(result._program);
+		} catch (...) {
+			// Some GL drivers have a habit of crashing during shader compile.
+			skg_logf(skg_log_warning, "Shader link exception in %s:", meta->name);
+			glDeleteProgram(result._program);
+			result._program = 0;
+			return result;
+		}
+	}
+
+	uint32_t    stages[3] = { result._vertex, result._pixel, result._compute };
+	const char *save_file = deferred && !loaded ? cache_file : nullptr;
+
+	// Parallel compiles finish on the driver's threads. skg_shader_is_ready
+	// polls them, and anything that needs the program waits on it.
+	if (gl_parallel_compile && !loaded) {
+		gl_program_pending_add(result._program, meta, stages, save_file, cache_key);
+		return result;
+	}
 
+	if (!gl_program_setup(result._program, meta, stages, save_file, cache_key)) {
+		glDeleteProgram(result._program);
+		result._program = 0;
+	}
 	return result;
 }
 
 ///////////////////////////////////////////
 
 void skg_shader_name(skg_shader_t *shader, const char* name) {
+	SKG_TRACE_FUNC();
 	char postfix_name[256];
 	if (shader->_program != 0) {
 		snprintf(postfix_name, sizeof(postfix_name), "%s_program", name);
@@ -1549,8 +3505,16 @@ void skg_shader_name(skg_shader_t *shader, const char* name) {
 ///////////////////////////////////////////
 
 void skg_shader_compute_bind(const skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_compute_bind, shader ? skg_capture_id(shader) : 0));
 	uint32_t program = shader? shader->_program : 0;
-	PIPELINE_CHECK(gl_pipeline.program, program)
+	PIPELINE_CHECK(skg_stat_program, gl_pipeline.program, program)
+		// A program that failed to link can't be used, and leaving the last
+		// one bound would dispatch the wrong shader.
+		if (!gl_program_finish(program)) {
+			program             = 0;
+			gl_pipeline.program = 0;
+		}
 		glUseProgram(program);
 	PIPELINE_CHECK_END
 }
@@ -1559,12 +3523,52 @@ void skg_shader_compute_bind(const skg_shader_t *shader) {
 
 bool skg_shader_is_valid(const skg_shader_t *shader) {
 	return shader->meta
-		&& shader->_program;
+		&& shader->_program
+		&& gl_program_finish(shader->_program);
+}
+
+///////////////////////////////////////////
+
+bool skg_shader_is_ready(const skg_shader_t *shader) {
+	if (gl_program_pending_find(shader->_program) < 0)
+		return true;
+
+#if !defined(_SKG_GL_WEB)
+	int32_t complete = 0;
+	glGetProgramiv(shader->_program, GL_COMPLETION_STATUS_KHR, &complete);
+	if (complete == 0)
+		return false;
+#endif
+	gl_program_finish(shader->_program);
+	return true;
 }
 
 ///////////////////////////////////////////
 
 void skg_shader_destroy(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_destroy, skg_capture_id(shader)));
+	if (gl_destroy_deferred) {
+		gl_destroy_t *item = (gl_destroy_t*)calloc(1, sizeof(gl_destroy_t));
+		item->type   = gl_destroy_type_shader;
+		item->shader = *shader;
+		gl_destroy_push(item);
+		*shader = {};
+		return;
+	}
+	gl_shader_destroy(shader);
+}
+
+///////////////////////////////////////////
+
+void gl_shader_destroy(skg_shader_t *shader) {
+	int32_t pending = gl_program_pending_find(shader->_program);
+	if (pending >= 0) gl_program_pending_remove(pending);
+	int32_t failed = gl_program_failed_find(shader->_program);
+	if (failed >= 0) gl_programs_failed[failed] = gl_programs_failed[--gl_program_failed_count];
+	// Draws read vertex inputs from the bound meta, which may be freed here
+	if (gl_pipeline.meta == shader->meta)
+		gl_pipeline.meta = nullptr;
 	skg_shader_meta_release(shader->meta);
 	glDeleteProgram(shader->_program);
 	glDeleteShader (shader->_vertex);
@@ -1577,6 +3581,7 @@ void skg_shader_destroy(skg_shader_t *shader) {
 ///////////////////////////////////////////
 
 skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
 	skg_pipeline_t result = {};
 	result.transparency = skg_transparency_none;
 	result.cull         = skg_cull_back;
@@ -1594,17 +3599,29 @@ skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
 ///////////////////////////////////////////
 
 void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+	SKG_TRACE_FUNC();
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
-	PIPELINE_CHECK(gl_pipeline.program, pipeline->_shader._program)
-		glUseProgram(pipeline->_shader._program);
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_pipeline_bind(pipeline, skg_capture_id(&pipeline->_shader)));
+	PIPELINE_CHECK(skg_stat_program, gl_pipeline.program, pipeline->_shader._program)
+		// A program that failed to link can't be used, and leaving the last
+		// one bound would draw with the wrong shader.
+		uint32_t program = pipeline->_shader._program;
+		if (!gl_program_finish(program)) {
+			program             = 0;
+			gl_pipeline.program = 0;
+		}
+		glUseProgram(program);
 	PIPELINE_CHECK_END
+	gl_pipeline.meta   = pipeline->_shader.meta;
+	gl_pipeline.inputs = pipeline->_shader._inputs;
 
 	
-	PIPELINE_CHECK(gl_pipeline.transparency, pipeline->transparency)
+	PIPELINE_CHECK(skg_stat_blend, gl_pipeline.transparency, pipeline->transparency)
 		switch (pipeline->transparency) {
 		case skg_transparency_alpha_to_coverage:
 			glDisable  (GL_BLEND);
@@ -1630,7 +3647,7 @@ void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
 	PIPELINE_CHECK_END
 
 
-	PIPELINE_CHECK(gl_pipeline.cull, pipeline->cull)
+	PIPELINE_CHECK(skg_stat_cull, gl_pipeline.cull, pipeline->cull)
 		switch (pipeline->cull) {
 		case skg_cull_back: {
 			glEnable  (GL_CULL_FACE);
@@ -1647,12 +3664,12 @@ void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
 	PIPELINE_CHECK_END
 
 
-	PIPELINE_CHECK(gl_pipeline.scissor, pipeline->scissor)
+	PIPELINE_CHECK(skg_stat_cull, gl_pipeline.scissor, pipeline->scissor)
 		if (pipeline->scissor) glEnable (GL_SCISSOR_TEST);
 		else                   glDisable(GL_SCISSOR_TEST);
 	PIPELINE_CHECK_END
 
-	PIPELINE_CHECK(gl_pipeline.color_write, pipeline->color_write)
+	PIPELINE_CHECK(skg_stat_blend, gl_pipeline.color_write, pipeline->color_write)
 		switch(pipeline->color_write) {
 			case skg_color_write_rgba: glColorMask(true,  true,  true,  true ); break;
 			case skg_color_write_rgb:  glColorMask(true,  true,  true,  false); break;
@@ -1661,23 +3678,23 @@ void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
 		}
 	PIPELINE_CHECK_END
 	
-	PIPELINE_CHECK(gl_pipeline.depth_write, pipeline->depth_write)
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_write, pipeline->depth_write)
 		glDepthMask(pipeline->depth_write);
 	PIPELINE_CHECK_END
 	
-	PIPELINE_CHECK(gl_pipeline.depth_clip, pipeline->depth_clip)
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_clip, pipeline->depth_clip)
 		if (pipeline->depth_clip) glDisable(GL_DEPTH_CLAMP);
 		else                      glEnable (GL_DEPTH_CLAMP);
 	PIPELINE_CHECK_END
 
 	bool depth_test = pipeline->depth_test != skg_depth_test_always;
-	PIPELINE_CHECK(gl_pipeline.depth_test, depth_test)
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_test, depth_test)
 		if (depth_test) glEnable (GL_DEPTH_TEST);
 		else            glDisable(GL_DEPTH_TEST);
 	PIPELINE_CHECK_END
 
 
-	PIPELINE_CHECK(gl_pipeline.depth_test_type, pipeline->depth_test)
+	PIPELINE_CHECK(skg_stat_depth, gl_pipeline.depth_test_type, pipeline->depth_test)
 		switch (pipeline->depth_test) {
 		case skg_depth_test_always:        glDepthFunc(GL_ALWAYS);   break;
 		case skg_depth_test_equal:         glDepthFunc(GL_EQUAL);    break;
@@ -1691,7 +3708,7 @@ void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
 	PIPELINE_CHECK_END
 	
 #ifdef _SKG_GL_DESKTOP
-	PIPELINE_CHECK(gl_pipeline.wireframe, pipeline->wireframe)
+	PIPELINE_CHECK(skg_stat_cull, gl_pipeline.wireframe, pipeline->wireframe)
 		glPolygonMode(GL_FRONT_AND_BACK, pipeline->wireframe ? GL_LINE : GL_FILL);
 	PIPELINE_CHECK_END
 #endif
@@ -1700,48 +3717,56 @@ void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 void skg_pipeline_set_transparency(skg_pipeline_t *pipeline, skg_transparency_ transparency) {
+	SKG_TRACE_FUNC();
 	pipeline->transparency = transparency;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_cull(skg_pipeline_t *pipeline, skg_cull_ cull) {
+	SKG_TRACE_FUNC();
 	pipeline->cull = cull;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_wireframe(skg_pipeline_t *pipeline, bool wireframe) {
+	SKG_TRACE_FUNC();
 	pipeline->wireframe = wireframe;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_write(skg_pipeline_t *pipeline, bool write) {
+	SKG_TRACE_FUNC();
 	pipeline->depth_write = write;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_clip(skg_pipeline_t *pipeline, bool clip) {
+	SKG_TRACE_FUNC();
 	pipeline->depth_clip = clip;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_color_write(skg_pipeline_t *pipeline, skg_color_write_ write) {
+	SKG_TRACE_FUNC();
 	pipeline->color_write = write;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_depth_test (skg_pipeline_t *pipeline, skg_depth_test_ test) {
+	SKG_TRACE_FUNC();
 	pipeline->depth_test = test;
 }
 
 ///////////////////////////////////////////
 
 void skg_pipeline_set_scissor(skg_pipeline_t *pipeline, bool enable) {
+	SKG_TRACE_FUNC();
 	pipeline->scissor = enable;
 
 }
@@ -1797,14 +3822,30 @@ bool skg_pipeline_get_scissor(const skg_pipeline_t *pipeline) {
 ///////////////////////////////////////////
 
 void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
 	// TODO: destroy pipeline handles and reset gl_pipeline state
+	if (gl_pipeline.meta == pipeline->_shader.meta)
+		gl_pipeline.meta = nullptr;
 	skg_shader_meta_release(pipeline->_shader.meta);
 	*pipeline = {};
 }
 
 ///////////////////////////////////////////
 
+#if defined(_SKG_GL_LOAD_EGL)
+EGLSurface gl_egl_pbuffer_create(int32_t width, int32_t height) {
+	EGLint attribs[] = {
+		EGL_WIDTH,  width  > 0 ? width  : 1,
+		EGL_HEIGHT, height > 0 ? height : 1,
+		EGL_NONE };
+	return eglCreatePbufferSurface(egl_display, egl_config, attribs);
+}
+#endif
+
+///////////////////////////////////////////
+
 skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
+	SKG_TRACE_FUNC();
 	skg_swapchain_t result = {};
 
 #if defined(_SKG_GL_LOAD_WGL)
@@ -1843,11 +3884,23 @@ skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fm
 		return result;
 	}
 #elif defined(_SKG_GL_LOAD_EGL)
-	EGLint attribs[] = { 
-		EGL_GL_COLORSPACE_KHR, EGL_GL_COLORSPACE_SRGB_KHR,
-		EGL_NONE };
-	result._egl_surface = eglCreateWindowSurface(egl_display, egl_config, (EGLNativeWindowType)hwnd, attribs);
-	if (eglGetError() != EGL_SUCCESS) skg_log(skg_log_critical, "Err eglCreateWindowSurface");
+	if (hwnd == nullptr) {
+		// No window, so this is an offscreen swapchain for headless
+		// rendering. Presenting it does nothing.
+		result._egl_pbuffer = true;
+		result._egl_surface = gl_egl_pbuffer_create(requested_width, requested_height);
+		if (result._egl_surface == EGL_NO_SURFACE) {
+			skg_log(skg_log_critical, "Err eglCreatePbufferSurface, headless swapchains need pbuffer support");
+			result = {};
+			return result;
+		}
+	} else {
+		EGLint attribs[] = { 
+			EGL_GL_COLORSPACE_KHR, EGL_GL_COLORSPACE_SRGB_KHR,
+			EGL_NONE };
+		result._egl_surface = eglCreateWindowSurface(egl_display, egl_config, (EGLNativeWindowType)hwnd, attribs);
+		if (eglGetError() != EGL_SUCCESS) skg_log(skg_log_critical, "Err eglCreateWindowSurface");
+	}
 	
 	if (eglMakeCurrent(egl_display, result._egl_surface, result._egl_surface, egl_context) == EGL_FALSE)
 		skg_log(skg_log_critical, "Unable to eglMakeCurrent for swapchain");
@@ -1903,6 +3956,8 @@ void main() {
 	skg_shader_stage_t v_stage = skg_shader_stage_create(vs, strlen(vs), skg_stage_vertex);
 	skg_shader_stage_t p_stage = skg_shader_stage_create(ps, strlen(ps), skg_stage_pixel);
 	result._convert_shader = skg_shader_create_manual(meta, v_stage, p_stage, {});
+	skg_shader_stage_destroy(&v_stage);
+	skg_shader_stage_destroy(&p_stage);
 	result._convert_pipe   = skg_pipeline_create(&result._convert_shader);
 
 	result._surface = skg_tex_create(skg_tex_type_rendertarget, skg_use_static, skg_tex_fmt_rgba32_linear, skg_mip_none);
@@ -1928,9 +3983,25 @@ void main() {
 ///////////////////////////////////////////
 
 void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
 	if (width == swapchain->width && height == swapchain->height)
 		return;
 
+#if defined(_SKG_GL_LOAD_EGL)
+	if (swapchain->_egl_pbuffer) {
+		// Make the new surface before letting go of the old one, so a
+		// failure leaves the swapchain, and the context, as they were.
+		EGLSurface surface = gl_egl_pbuffer_create(width, height);
+		if (surface == EGL_NO_SURFACE) {
+			skg_log(skg_log_critical, "Err eglCreatePbufferSurface while resizing");
+			return;
+		}
+		eglMakeCurrent   (egl_display, surface, surface, egl_context);
+		eglDestroySurface(egl_display, swapchain->_egl_surface);
+		swapchain->_egl_surface = surface;
+	}
+#endif
+
 	swapchain->width  = width;
 	swapchain->height = height;
 
@@ -1953,6 +4024,7 @@ void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t hei
 ///////////////////////////////////////////
 
 void skg_swapchain_present(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 #if   defined(_SKG_GL_LOAD_WGL)
 	SwapBuffers((HDC)swapchain->_hdc);
 #elif defined(_SKG_GL_LOAD_EGL)
@@ -1973,6 +4045,7 @@ void skg_swapchain_present(skg_swapchain_t *swapchain) {
 ///////////////////////////////////////////
 
 void skg_swapchain_bind(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 	gl_active_width  = swapchain->width;
 	gl_active_height = swapchain->height;
 #if   defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
@@ -1993,6 +4066,7 @@ void skg_swapchain_bind(skg_swapchain_t *swapchain) {
 ///////////////////////////////////////////
 
 void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
 #if defined(_SKG_GL_LOAD_WGL)
 	if (swapchain->_hdc != nullptr) {
 		wglMakeCurrent(nullptr, nullptr);
@@ -2024,6 +4098,7 @@ uint32_t gl_tex_target(skg_use_ tex_use, int32_t array_count, int32_t multisampl
 ///////////////////////////////////////////
 
 void gl_framebuffer_attach(uint32_t texture, uint32_t target, skg_tex_fmt_ format, int32_t physical_multisample, int32_t multisample, int32_t array_count, uint32_t layer, uint32_t mip_level, bool multiview) {
+	SKG_TRACE_FUNC();
 	uint32_t attach = GL_COLOR_ATTACHMENT0;
 	if      (format == skg_tex_fmt_depthstencil)                             attach = GL_DEPTH_STENCIL_ATTACHMENT;
 	else if (format == skg_tex_fmt_depth16 || format == skg_tex_fmt_depth32) attach = GL_DEPTH_ATTACHMENT;
@@ -2046,6 +4121,7 @@ void gl_framebuffer_attach(uint32_t texture, uint32_t target, skg_tex_fmt_ forma
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_count, int32_t physical_multisample, int32_t framebuffer_multisample) {
+	SKG_TRACE_FUNC();
 	uint32_t err = glGetError();
 	while(err) {
 		skg_logf(skg_log_warning, "Unsourced (skg_tex_create_from_existing) err: %x", err);
@@ -2068,6 +4144,7 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 
 	// Check if this is an external texture
 	gl_pipeline.tex_bind[0] = result._texture; // Similar to a PIPELINE_CHECK
+	gl_binds.tex_dirty     |= 1;               // Queued binds for slot 0 need to come back
 	skg_log_enable(false); // Intentional error, don't scare the users.
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture  (GL_TEXTURE_EXTERNAL_OES, result._texture);
@@ -2088,6 +4165,11 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 		}
 
 		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
+
+		// The texture itself belongs to whoever made it, but any tiled MSAA
+		// surfaces behind our framebuffers are ours.
+		if (gl_caps[skg_cap_tiled_multisample])
+			skg_mem_track_tex(skg_mem_key(&result), &result, 0, result._physical_multisample);
 	}
 
 	err = glGetError();
@@ -2096,12 +4178,14 @@ skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg
 		err = glGetError();
 	}
 	
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_layer) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type        = type;
 	result.use         = skg_use_static;
@@ -2116,6 +4200,7 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 	result._texture    = (uint32_t)(uint64_t)native_tex;
 	result._format     = (uint32_t)skg_tex_fmt_to_native(result.format);
 	result._target     = gl_tex_target(result.use, 2, result._physical_multisample);
+	result._view       = true;
 
 	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
 		result._framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * 1);
@@ -2127,12 +4212,14 @@ skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_te
 		glBindFramebuffer(GL_FRAMEBUFFER, gl_current_framebuffer);
 	}
 
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
 	return result;
 }
 
 ///////////////////////////////////////////
 
 skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
+	SKG_TRACE_FUNC();
 	skg_tex_t result = {};
 	result.type    = type;
 	result.use     = use;
@@ -2145,7 +4232,15 @@ skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format,
 	else if (use & skg_use_compute_write)                               result._access = GL_WRITE_ONLY;
 	result._format = (uint32_t)skg_tex_fmt_to_native(result.format);
 
+	// Framebuffers belong to the context that made them
+	if (gl_upload_thread && (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget)) {
+		skg_log(skg_log_warning, "Render targets can't be created on an upload thread!");
+		return {};
+	}
+
 	glGenTextures(1, &result._texture);
+	skg_mem_add(skg_mem_key(&result));
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create, &result));
 	skg_tex_settings(&result, (use & skg_use_cubemap) > 0 ? skg_tex_address_clamp : skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 1);
 
 	if (type == skg_tex_type_rendertarget || type == skg_tex_type_depthtarget) {
@@ -2159,6 +4254,8 @@ skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format,
 ///////////////////////////////////////////
 
 void skg_tex_name(skg_tex_t *tex, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(tex), name);
 	if (tex->_texture != 0)
 		glObjectLabel(GL_TEXTURE, tex->_texture, (uint32_t)strlen(name), name);
 
@@ -2181,6 +4278,8 @@ bool skg_tex_is_valid(const skg_tex_t *tex) {
 ///////////////////////////////////////////
 
 void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_copy_to, skg_capture_id(tex), tex_surface, skg_capture_id(destination), dest_surface));
 	uint32_t err = glGetError();
 	while(err) {
 		skg_logf(skg_log_warning, "Unsourced (skg_tex_copy_to) err: %x", err);
@@ -2240,6 +4339,7 @@ void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *desti
 ///////////////////////////////////////////
 
 void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
+	SKG_TRACE_FUNC();
 	skg_swapchain_bind(destination);
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, tex->_framebuffer_layers[0]); // TODO: layer stuff
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
@@ -2249,6 +4349,7 @@ void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destinatio
 ///////////////////////////////////////////
 
 void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
+	SKG_TRACE_FUNC();
 	if (tex->type != skg_tex_type_rendertarget) {
 		skg_log(skg_log_warning, "Can't bind a depth texture to a non-rendertarget");
 		return;
@@ -2258,6 +4359,7 @@ void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
 		return;
 	}
 
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_attach_depth, skg_capture_id(tex), 0, skg_capture_id(depth), 0));
 	uint32_t err = glGetError();
 	while(err) {
 		skg_logf(skg_log_warning, "Unsourced (skg_tex_attach_depth) err: %x", err);
@@ -2281,6 +4383,8 @@ void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
 ///////////////////////////////////////////
 
 void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_settings(tex, address, sample, compare, anisotropy));
 	tex->_address    = address;
 	tex->_sample     = sample;
 	tex->_anisotropy = anisotropy;
@@ -2302,9 +4406,42 @@ void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_
 	default: filter = GL_LINEAR; min_filter = GL_LINEAR;
 	}
 
-	if (!skg_tex_is_valid(tex)) return;
+	uint32_t comparison = 0;
+	switch (compare) {
+		case skg_sample_compare_none:          comparison = 0;          break;
+		case skg_sample_compare_less:          comparison = GL_LESS;    break;
+		case skg_sample_compare_less_or_eq:    comparison = GL_LEQUAL;  break;
+		case skg_sample_compare_greater:       comparison = GL_GREATER; break;
+		case skg_sample_compare_greater_or_eq: comparison = GL_GEQUAL;  break;
+		case skg_sample_compare_equal:         comparison = GL_EQUAL;   break;
+		case skg_sample_compare_not_equal:     comparison = GL_NOTEQUAL;break;
+		case skg_sample_compare_always:        comparison = GL_ALWAYS;  break;
+		case skg_sample_compare_never:         comparison = GL_NEVER;   break;
+		default: comparison = GL_LESS;
+	}
+	float aniso = sample == skg_tex_sample_anisotropic ? (float)anisotropy : 1.0f;
+
 	// Multisample textures throw errors if you try to set sampler states.
-	if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE || tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) return;
+	bool multisample = tex->_target == GL_TEXTURE_2D_MULTISAMPLE || tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY;
+
+	// With sampler objects, the texture itself is left alone. It picks up
+	// a shared sampler that skg_tex_bind puts on the same slot.
+	if (gl_sampler_objects) {
+		tex->_sampler = multisample ? 0 : gl_sampler_find(mode, filter, min_filter, aniso, comparison);
+
+		// Slots this texture is already on need the new sampler too
+		if (tex->_texture != 0 && !gl_upload_thread) {
+			for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+				if (gl_binds.tex[i] != tex->_texture) continue;
+				gl_binds.sampler[i] = tex->_sampler;
+				gl_binds.tex_dirty |= 1u << i;
+			}
+		}
+		return;
+	}
+
+	if (!skg_tex_is_valid(tex)) return;
+	if (multisample) return;
 
 	glActiveTexture(skg_settings_tex_slot);
 	glBindTexture(tex->_target, tex->_texture);
@@ -2317,23 +4454,10 @@ void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_
 	glTexParameteri(tex->_target, GL_TEXTURE_MIN_FILTER, min_filter);
 	glTexParameteri(tex->_target, GL_TEXTURE_MAG_FILTER, filter    );
 #ifdef _SKG_GL_DESKTOP
-	glTexParameterf(tex->_target, GL_TEXTURE_MAX_ANISOTROPY_EXT, sample == skg_tex_sample_anisotropic ? anisotropy : 1.0f);
+	glTexParameterf(tex->_target, GL_TEXTURE_MAX_ANISOTROPY_EXT, aniso);
 #endif
 	
-	if (compare != skg_sample_compare_none) {
-		uint32_t comparison;
-		switch (compare) {
-			case skg_sample_compare_none:          comparison = GL_LESS;    break; // Shouldn't matter, but this is what we've been using
-			case skg_sample_compare_less:          comparison = GL_LESS;    break;
-			case skg_sample_compare_less_or_eq:    comparison = GL_LEQUAL;  break;
-			case skg_sample_compare_greater:       comparison = GL_GREATER; break;
-			case skg_sample_compare_greater_or_eq: comparison = GL_GEQUAL;  break;
-			case skg_sample_compare_equal:         comparison = GL_EQUAL;   break;
-			case skg_sample_compare_not_equal:     comparison = GL_NOTEQUAL;break;
-			case skg_sample_compare_always:        comparison = GL_ALWAYS;  break;
-			case skg_sample_compare_never:         comparison = GL_NEVER;   break;
-			default: comparison = GL_LESS;
-		}
+	if (comparison != 0) {
 		glTexParameteri(tex->_target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
 		glTexParameteri(tex->_target, GL_TEXTURE_COMPARE_FUNC, comparison);
 	}
@@ -2347,7 +4471,56 @@ void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_
 
 ///////////////////////////////////////////
 
+uint32_t gl_sampler_find(uint32_t wrap, uint32_t filter, uint32_t min_filter, float anisotropy, uint32_t comparison) {
+	// GL enums for these all fit in 16 bits, so they pack into one key
+	uint32_t aniso_bits = anisotropy < 1 ? 1 : (uint32_t)anisotropy;
+	uint64_t key =
+		((uint64_t)(wrap       & 0xFFFF)      ) |
+		((uint64_t)(min_filter & 0xFFFF) << 16) |
+		((uint64_t)(comparison & 0xFFFF) << 32) |
+		((uint64_t)(aniso_bits & 0xFF  ) << 48) |
+		((uint64_t)(filter == GL_NEAREST ? 1 : 0) << 56);
+
+	// Samplers are shared between contexts, so upload threads use this too
+	std::lock_guard<std::mutex> lock(gl_sampler_mtx);
+	for (int32_t i = 0; i < gl_sampler_count; i++) {
+		if (gl_samplers[i].key == key) return gl_samplers[i].sampler;
+	}
+
+	if (gl_sampler_count + 1 > gl_sampler_cap) {
+		gl_sampler_cap = gl_sampler_cap == 0 ? 8 : gl_sampler_cap * 2;
+		gl_samplers    = (gl_sampler_t*)realloc(gl_samplers, sizeof(gl_sampler_t) * gl_sampler_cap);
+	}
+	uint32_t sampler = 0;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S,     wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T,     wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R,     wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, min_filter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, filter);
+#ifdef _SKG_GL_DESKTOP
+	glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+#endif
+	if (comparison != 0) {
+		glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, comparison);
+	}
+
+	int32_t err = glGetError();
+	while (err != 0) {
+		skg_logf(skg_log_warning, "gl_sampler_find err: 0x%x", err);
+		err = glGetError();
+	}
+
+	gl_samplers[gl_sampler_count] = { key, sampler };
+	gl_sampler_count += 1;
+	return sampler;
+}
+
+///////////////////////////////////////////
+
 void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
 	const void *data_arr[1] = { data };
 	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
 }
@@ -2355,6 +4528,8 @@ void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32
 ///////////////////////////////////////////
 
 void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_set_contents(tex, array_data, array_count, mip_count, width, height, multisample));
 	int32_t err = glGetError();
 	while (err != 0) {
 		skg_logf(skg_log_info, "Clearing unsourced (skg_tex_set_contents_arr) err: 0x%x", err);
@@ -2402,12 +4577,14 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t a
 	else if (tex->_target == GL_TEXTURE_2D_ARRAY)             { glTexStorage3D           (tex->_target, mip_count,        tex->_format, width, height, array_count); }
 
 	for (int32_t array_idx = 0; array_idx < array_count; array_idx++) {
+		SKG_TRACE_SCOPE("gl_tex_upload");
 		int32_t mip_offset = 0;
 		for (int32_t m = 0; m < mip_count; m++) {
 			int32_t mip_width, mip_height;
 			skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
 			int32_t mip_bytes = skg_tex_fmt_memory(tex->format, mip_width, mip_height);
 			void*   mip_data  = array_data == nullptr ? nullptr : (uint8_t*)array_data[array_idx] + mip_offset;
+			if (mip_data) skg_stats_upload(mip_bytes);
 
 			if        (tex->_target == GL_TEXTURE_2D_MULTISAMPLE) {
 			} else if (tex->_target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) {
@@ -2434,6 +4611,7 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t a
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
 	if (tex->mips == skg_mip_generate && mip_count == 1) {
+		SKG_TRACE_SCOPE("glGenerateMipmap");
 		glGenerateMipmap(tex->_target);
 
 		err = glGetError();
@@ -2441,8 +4619,10 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t a
 			skg_logf(skg_log_warning, "skg_tex_set_contents_arr mip err: 0x%x", err);
 		}
 	}
+	skg_mem_track_tex(skg_mem_key(tex), tex, tex->mips == skg_mip_generate && mip_count == 1 ? (int32_t)skg_mip_count(width, height) : mip_count, tex->_physical_multisample);
 
 	if (tex->type == skg_tex_type_rendertarget || tex->type == skg_tex_type_depthtarget) {
+		SKG_TRACE_SCOPE("gl_framebuffer_setup");
 		tex->_framebuffer_layers = (uint32_t*)malloc(sizeof(uint32_t) * tex->array_count);
 		glGenFramebuffers(tex->array_count, tex->_framebuffer_layers);
 
@@ -2466,18 +4646,21 @@ void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t a
 ///////////////////////////////////////////
 
 bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
 bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
 }
 
 ///////////////////////////////////////////
 
 bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
 	uint32_t result = glGetError();
 	while (result != 0) {
 		skg_logf(skg_log_warning, "skg_tex_get_mip_contents_arr: eating a gl error from somewhere else: 0x%x", result);
@@ -2545,7 +4728,136 @@ bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr
 
 ///////////////////////////////////////////
 
+void gl_readback_prepare(skg_readback_t *readback, size_t size) {
+#if defined(_SKG_GL_WEB)
+	if (readback->size != size) {
+		free(readback->_data);
+		readback->_data = malloc(size);
+	}
+#else
+	if (readback->_fence) glDeleteSync(readback->_fence);
+	readback->_fence = nullptr;
+
+	if (readback->_buffer == 0) glGenBuffers(1, &readback->_buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->_buffer);
+	if (readback->_data) {
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		readback->_data = nullptr;
+	}
+	if (readback->size != size)
+		glBufferData(GL_PIXEL_PACK_BUFFER, (int32_t)size, nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+	readback->size = size;
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_read_async(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	if (skg_tex_fmt_is_compressed(tex->format) || skg_tex_fmt_is_depth(tex->format) || tex->_physical_multisample > 1) {
+		skg_log(skg_log_warning, "skg_tex_read_async doesn't support compressed, depth, or MSAA textures");
+		return false;
+	}
+	int32_t mip_levels = tex->mips == skg_mip_generate ? (int32_t)skg_mip_count(tex->width, tex->height) : 1;
+	if (mip_level >= mip_levels || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "skg_tex_read_async: this texture doesn't have the mip level or array slice you asked for.");
+		return false;
+	}
+
+	int32_t width, height;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+	gl_readback_prepare(ref_readback, skg_tex_fmt_memory(tex->format, width, height));
+	ref_readback->width  = width;
+	ref_readback->height = height;
+	ref_readback->format = tex->format;
+
+	// Reading through a framebuffer works on every flavor of GL, and lets
+	// us pick out a single array slice.
+	if (gl_readback_fbo == 0) glGenFramebuffers(1, &gl_readback_fbo);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, gl_readback_fbo);
+	if      (tex->_target == GL_TEXTURE_CUBE_MAP) glFramebufferTexture2D   (GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X+arr_index, tex->_texture, mip_level);
+	else if (tex->_target == GL_TEXTURE_2D_ARRAY) glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->_texture, mip_level, arr_index);
+	else                                          glFramebufferTexture2D   (GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->_target, tex->_texture, mip_level);
+
+	uint32_t layout = skg_tex_fmt_to_gl_layout(tex->format);
+	uint32_t type   = skg_tex_fmt_to_gl_type  (tex->format);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#if defined(_SKG_GL_WEB)
+	// WebGL can't map buffers, so this one has to wait on the GPU.
+	glReadPixels(0, 0, width, height, layout, type, ref_readback->_data);
+#else
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ref_readback->_buffer);
+	glReadPixels(0, 0, width, height, layout, type, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	ref_readback->_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	// Detach, so the framebuffer doesn't keep a destroyed texture alive.
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+	glBindFramebuffer     (GL_READ_FRAMEBUFFER, gl_current_framebuffer);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool skg_readback_poll(skg_readback_t *readback) {
+#if defined(_SKG_GL_WEB)
+	return readback->_data != nullptr;
+#else
+	if (readback->_buffer == 0) return false;
+	if (readback->_fence  == nullptr) return true;
+
+	if (glClientWaitSync(readback->_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+		return false;
+	glDeleteSync(readback->_fence);
+	readback->_fence = nullptr;
+	return true;
+#endif
+}
+
+///////////////////////////////////////////
+
+const void *skg_readback_map(skg_readback_t *readback, size_t *out_size) {
+	SKG_TRACE_FUNC();
+	if (out_size) *out_size = readback->size;
+#if !defined(_SKG_GL_WEB)
+	if (readback->_buffer == 0 || readback->_data != nullptr)
+		return readback->_data;
+
+	if (readback->_fence) {
+		SKG_TRACE_SCOPE("gl_readback_wait");
+		while (glClientWaitSync(readback->_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+		glDeleteSync(readback->_fence);
+		readback->_fence = nullptr;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->_buffer);
+	readback->_data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback->size, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+	return readback->_data;
+}
+
+///////////////////////////////////////////
+
+void skg_readback_destroy(skg_readback_t *readback) {
+	SKG_TRACE_FUNC();
+#if defined(_SKG_GL_WEB)
+	free(readback->_data);
+#else
+	// Deleting a mapped buffer unmaps it too.
+	if (readback->_fence ) glDeleteSync   (readback->_fence);
+	if (readback->_buffer) glDeleteBuffers(1, &readback->_buffer);
+#endif
+	*readback = {};
+}
+
+///////////////////////////////////////////
+
 bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_gen_mips, skg_capture_id(tex_mipped_rt)));
 	uint32_t err = glGetError();
 	while (err != 0) {
 		skg_logf(skg_log_warning, "skg_tex_gen_mips: eating a gl error from somewhere else: 0x%x", err);
@@ -2567,36 +4879,63 @@ bool skg_tex_gen_mips(skg_tex_t *tex_mipped_rt) {
 ///////////////////////////////////////////
 
 void* skg_tex_get_native(const skg_tex_t* tex) {
+	SKG_TRACE_FUNC();
 	return (void*)((uint64_t)tex->_texture);
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_bind(const skg_tex_t *texture, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_bind, skg_capture_id(texture), bind));
 	if (bind.stage_bits & skg_stage_compute) {
 #if !defined(_SKG_GL_WEB)
 		glBindImageTexture(bind.slot, texture->_texture, 0, false, 0, texture->_access, (uint32_t)skg_tex_fmt_to_native( texture->format ));
 #endif
-	} else {
-		PIPELINE_CHECK(gl_pipeline.tex_bind[bind.slot], texture->_texture)
+	} else if (bind.slot >= SKG_GL_BIND_SLOTS) {
+		// Past the end of the cache, so this goes straight to GL
+		SKG_STAT_MISS(skg_stat_texture);
 		glActiveTexture(GL_TEXTURE0 + bind.slot);
 		glBindTexture(texture->_target, texture->_texture);
-		PIPELINE_CHECK_END
+		if (gl_sampler_objects) glBindSampler(bind.slot, texture->_sampler);
+	} else {
+		gl_binds.tex       [bind.slot] = texture->_texture;
+		gl_binds.tex_target[bind.slot] = texture->_target;
+		gl_binds.sampler   [bind.slot] = texture->_sampler;
+		gl_binds.tex_dirty |= 1u << bind.slot;
 	}
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_clear, 0, bind));
 }
 
 ///////////////////////////////////////////
 
 void skg_tex_destroy(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_destroy, skg_capture_id(tex)));
+	if (gl_destroy_deferred) {
+		gl_destroy_t *item = (gl_destroy_t*)calloc(1, sizeof(gl_destroy_t));
+		item->type = gl_destroy_type_tex;
+		item->tex  = *tex;
+		gl_destroy_push(item);
+		*tex = {};
+		return;
+	}
+	gl_tex_destroy(tex);
+}
+
+///////////////////////////////////////////
+
+void gl_tex_destroy(skg_tex_t *tex) {
 	// Make sure it's not bound or cached in our pipeline state
 	if (tex->_target) {
-		int32_t slot_count = sizeof(gl_pipeline.tex_bind) / sizeof(gl_pipeline.tex_bind[0]);
-		for (int32_t i = 0; i < slot_count; i++) {
+		for (int32_t i = 0; i < SKG_GL_BIND_SLOTS; i++) {
+			if (gl_binds.tex[i] == tex->_texture) gl_binds.tex[i] = 0;
 			if (gl_pipeline.tex_bind[i] != tex->_texture) continue;
 
 			glActiveTexture(GL_TEXTURE0 + i);
@@ -2611,6 +4950,7 @@ void skg_tex_destroy(skg_tex_t *tex) {
 		glDeleteFramebuffers(tex->array_count, tex->_framebuffer_layers);
 		free(tex->_framebuffer_layers);
 	}
+	skg_mem_release(skg_mem_key(tex));
 	*tex = {};
 }
 
@@ -2622,6 +4962,32 @@ uint32_t skg_buffer_type_to_gl(skg_buffer_type_ type) {
 	case skg_buffer_type_index:    return GL_ELEMENT_ARRAY_BUFFER;
 	case skg_buffer_type_constant: return GL_UNIFORM_BUFFER;
 	case skg_buffer_type_compute:  return GL_SHADER_STORAGE_BUFFER;
+#if defined(_SKG_GL_WEB)
+	case skg_buffer_type_indirect: return GL_COPY_WRITE_BUFFER;
+#else
+	// Without indirect draws, the buffer is only ever a copy source
+	case skg_buffer_type_indirect: return glDrawElementsIndirect ? GL_DRAW_INDIRECT_BUFFER : GL_COPY_WRITE_BUFFER;
+#endif
+	default: return 0;
+	}
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_fmt_to_gl_type(skg_fmt_ format) {
+	switch (format) {
+	case skg_fmt_f32:             return GL_FLOAT;
+	case skg_fmt_f16:             return GL_HALF_FLOAT;
+	case skg_fmt_i32:             return GL_INT;
+	case skg_fmt_i16:
+	case skg_fmt_i16_normalized:  return GL_SHORT;
+	case skg_fmt_i8:
+	case skg_fmt_i8_normalized:   return GL_BYTE;
+	case skg_fmt_ui32:            return GL_UNSIGNED_INT;
+	case skg_fmt_ui16:
+	case skg_fmt_ui16_normalized: return GL_UNSIGNED_SHORT;
+	case skg_fmt_ui8:
+	case skg_fmt_ui8_normalized:  return GL_UNSIGNED_BYTE;
 	default: return 0;
 	}
 }
@@ -2808,4 +5174,31 @@ bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
 	return gl_tex_fmt_supported[format];
 }
 
+///////////////////////////////////////////
+
+// Buffer and texture names can overlap, so the low bit keeps them apart.
+// Layer views share their texture with the one that owns the memory, and
+// are never tracked, so the next bit gives them keys that match nothing.
+uint64_t skg_mem_key(const skg_buffer_t *buffer) {
+	return (uint64_t)buffer->_buffer << 1;
+}
+uint64_t skg_mem_key(const skg_tex_t *tex) {
+	return (uint64_t)tex->_texture << 2 | (tex->_view ? 2 : 0) | 1;
+}
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+uint64_t skg_capture_id(const skg_buffer_t *buffer) {
+	return buffer->_buffer;
+}
+uint64_t skg_capture_id(const skg_shader_t *shader) {
+	return shader->_program;
+}
+uint64_t skg_capture_id(const skg_tex_t *tex) {
+	// Layers made with skg_tex_create_from_layer share their texture name.
+	return (uint64_t)tex->array_start << 32 | tex->_texture;
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -9,17 +9,23 @@ typedef struct skg_buffer_t {
 	uint32_t         stride;
 	uint32_t         _target;
 	uint32_t         _buffer;
+	uint32_t         _size;
+	struct gl_buffer_dirty_t *_dirty;
+	skg_ind_fmt_     _ind_format;
 } skg_buffer_t;
 
 typedef struct skg_mesh_t {
-	uint32_t _ind_buffer;
-	uint32_t _vert_buffer;
-	uint32_t _layout;
+	uint32_t            _ind_buffer;
+	uint32_t            _vert_buffer;
+	struct gl_layout_t *_layout;
+	skg_ind_fmt_        _ind_format;
+	int32_t             _vert_fmt;
 } skg_mesh_t;
 
 typedef struct skg_shader_stage_t {
 	skg_stage_ type;
 	uint32_t   _shader;
+	char      *_source;
 } skg_shader_stage_t;
 
 typedef struct skg_shader_t {
@@ -28,6 +34,7 @@ typedef struct skg_shader_t {
 	uint32_t           _pixel;
 	uint32_t           _program;
 	uint32_t           _compute;
+	uint64_t           _inputs;
 } skg_shader_t;
 
 typedef struct skg_pipeline_t {
@@ -63,8 +70,20 @@ typedef struct skg_tex_t {
 	skg_tex_sample_     _sample;
 	skg_sample_compare_ _compare;
 	int32_t             _anisotropy;
+	uint32_t            _sampler;
+	bool                _view;
 } skg_tex_t;
 
+typedef struct skg_readback_t {
+	int32_t       width;
+	int32_t       height;
+	skg_tex_fmt_  format;
+	size_t        size;
+	uint32_t      _buffer;
+	void         *_fence;
+	void         *_data;
+} skg_readback_t;
+
 typedef struct skg_swapchain_t {
 	int32_t  width;
 	int32_t  height;
@@ -74,6 +93,7 @@ typedef struct skg_swapchain_t {
 	void *_hwnd;
 #elif defined(_SKG_GL_LOAD_EGL)
 	void *_egl_surface;
+	bool  _egl_pbuffer;
 #elif defined(_SKG_GL_LOAD_GLX)
 	void *_x_window;
 #elif defined(_SKG_GL_LOAD_EMSCRIPTEN) && defined(SKG_MANUAL_SRGB)
@@ -4,9 +4,470 @@
 // Null Implementation                   //
 ///////////////////////////////////////////
 
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////
+
+skg_null_calls_t null_calls       = {};
+skg_null_calls_t null_calls_last  = {};
+skg_null_live_t  null_live        = {};
+uint32_t         null_next_id     = 1;
+int32_t          null_viewport[4] = {};
+skg_tex_t       *null_active_rendertarget = nullptr;
+char             null_adapter_name[]      = "sk_gpu null device";
+
+///////////////////////////////////////////
+
+size_t null_tex_mip_offset(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index) {
+	size_t layer_size = 0;
+	size_t mip_offset = 0;
+	for (int32_t m = 0; m < tex->_mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(tex->width, tex->height, m, &mip_width, &mip_height);
+		if (m == mip_level) mip_offset = layer_size;
+		layer_size += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	return layer_size * arr_index + mip_offset;
+}
+
+///////////////////////////////////////////
+
+void skg_setup_xlib(void *dpy, void *vi, void *fbconfig, void *drawable) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+int32_t skg_init(const char *app_name, void *adapter_id) {
+	SKG_TRACE_FUNC();
+	null_calls      = {};
+	null_calls_last = {};
+	null_live       = {};
+	skg_logf(skg_log_info, "Using %s", null_adapter_name);
+	return 1;
+}
+
+///////////////////////////////////////////
+
+const char* skg_adapter_name() {
+	return null_adapter_name;
+}
+
+///////////////////////////////////////////
+
+void skg_shutdown() {
+	SKG_TRACE_FUNC();
+	if (null_live.buffers + null_live.textures + null_live.shaders + null_live.pipelines + null_live.meshes > 0) {
+		skg_logf(skg_log_info, "Null shutdown with live resources: %d buffers, %d meshes, %d shaders, %d pipelines, %d textures",
+			null_live.buffers, null_live.meshes, null_live.shaders, null_live.pipelines, null_live.textures);
+	}
+	null_active_rendertarget = nullptr;
+	skg_vert_fmt_clear();
+}
+
+///////////////////////////////////////////
+
+skg_platform_data_t skg_get_platform_data() {
+	skg_platform_data_t result = {};
+	result._calls_last_frame = &null_calls_last;
+	result._calls_this_frame = &null_calls;
+	result._live             = &null_live;
+	return result;
+}
+
+///////////////////////////////////////////
+
+bool skg_capability(skg_cap_ capability) {
+	return false;
+}
+
+///////////////////////////////////////////
+
+bool skg_upload_thread_begin() {
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_upload_thread_end() {
+}
+
+///////////////////////////////////////////
+
+void skg_deferred_destroy_enable(bool enabled) {
+}
+
+///////////////////////////////////////////
+
+void skg_event_begin(const char *name) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_begin(name));
+}
+
+///////////////////////////////////////////
+
+void skg_event_end() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_event_end());
+}
+
+///////////////////////////////////////////
+
+void skg_timer_begin(const char *name) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_timer_end() {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+int32_t skg_timer_get_results(skg_timer_result_t *out_results, int32_t max_results) {
+	return 0;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_begin() {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_frame());
+	null_calls_last = null_calls;
+	null_calls      = {};
+}
+
+///////////////////////////////////////////
+
+void skg_draw(int32_t index_start, int32_t index_base, int32_t index_count, int32_t instance_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw(index_start, index_base, index_count, instance_count));
+	_skg_stats.draws          += 1;
+	null_calls.draws          += 1;
+	null_calls.draw_indices   += index_count;
+	null_calls.draw_instances += instance_count;
+}
+
+///////////////////////////////////////////
+
+void skg_draw_indirect(const skg_buffer_t *args_buffer, uint32_t offset, uint32_t draw_count, uint32_t stride) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_indirect(args_buffer, offset, draw_count, stride));
+	if (args_buffer->type != skg_buffer_type_indirect) {
+		skg_log(skg_log_warning, "skg_draw_indirect needs a skg_buffer_type_indirect buffer");
+		return;
+	}
+	if (stride == 0) stride = sizeof(skg_draw_args_t);
+	if (draw_count == 0) return;
+	if (offset % 4 != 0 || stride % 4 != 0) {
+		skg_log(skg_log_warning, "skg_draw_indirect offset and stride need to be multiples of 4");
+		return;
+	}
+	if (offset + (uint64_t)stride * (draw_count - 1) + sizeof(skg_draw_args_t) > args_buffer->_size) {
+		skg_log(skg_log_warning, "skg_draw_indirect is reading past the end of the args buffer");
+		return;
+	}
+	_skg_stats.draws += draw_count;
+	for (uint32_t i = 0; i < draw_count; i++) {
+		const skg_draw_args_t *draw = (const skg_draw_args_t*)((uint8_t*)args_buffer->_data + offset + i * stride);
+		null_calls.draws          += 1;
+		null_calls.draw_indices   += draw->index_count;
+		null_calls.draw_instances += draw->instance_count;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_draw_multi(const skg_draw_args_t *draws, uint32_t draw_count) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_draw_multi(draws, draw_count));
+	_skg_stats.draws += draw_count;
+	for (uint32_t i = 0; i < draw_count; i++) {
+		null_calls.draws          += 1;
+		null_calls.draw_indices   += draws[i].index_count;
+		null_calls.draw_instances += draws[i].instance_count;
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_compute(uint32_t thread_count_x, uint32_t thread_count_y, uint32_t thread_count_z) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_compute(thread_count_x, thread_count_y, thread_count_z));
+	_skg_stats.dispatches += 1;
+	null_calls.computes   += 1;
+}
+
+///////////////////////////////////////////
+
+void skg_viewport(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_viewport, xywh));
+	memcpy(null_viewport, xywh, sizeof(null_viewport));
+}
+
+///////////////////////////////////////////
+
+void skg_viewport_get(int32_t *out_xywh) {
+	SKG_TRACE_FUNC();
+	memcpy(out_xywh, null_viewport, sizeof(null_viewport));
+}
+
+///////////////////////////////////////////
+
+void skg_scissor(const int32_t *xywh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_rect(skg_capture_op_scissor, xywh));
+}
+
+///////////////////////////////////////////
+
+void skg_target_clear(bool depth, const float *clear_color_4) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_target_clear(depth, clear_color_4));
+	null_calls.target_clears += 1;
+}
+
+///////////////////////////////////////////
+// skg_buffer_t                          //
+///////////////////////////////////////////
+
+skg_buffer_t skg_buffer_create(const void *data, uint32_t size_count, uint32_t size_stride, skg_buffer_type_ type, skg_use_ use) {
+	SKG_TRACE_FUNC();
+	skg_buffer_t result = {};
+	result.use    = use;
+	result.type   = type;
+	result.stride = size_stride;
+	result._id    = null_next_id++;
+	result._size  = size_count * size_stride;
+	result._data  = calloc(result._size > 0 ? result._size : 1, 1);
+	if (data) memcpy(result._data, data, result._size);
+	if (type == skg_buffer_type_index)
+		result._ind_format = skg_ind_fmt_from_stride(size_stride);
+
+	null_live.buffers      += 1;
+	null_live.buffer_bytes += result._size;
+	skg_mem_track(skg_mem_key(&result), skg_mem_buffer, result._size);
+	SKG_CAPTURE_CALL(skg_capture_buffer_create(&result, data, size_count, size_stride));
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_name(skg_buffer_t *buffer, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(buffer), name);
+}
+
+///////////////////////////////////////////
+
+bool skg_buffer_is_valid(const skg_buffer_t *buffer) {
+	return buffer->_id != 0;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents(skg_buffer_t *buffer, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_contents(buffer, data, size_bytes));
+	if (size_bytes > buffer->_size) {
+		skg_log(skg_log_warning, "Attempting to set more data than the buffer can hold!");
+		size_bytes = buffer->_size;
+	}
+	memcpy(buffer->_data, data, size_bytes);
+
+	skg_stats_upload(size_bytes);
+	null_calls.buffer_uploads += 1;
+	null_calls.upload_bytes   += size_bytes;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_set_contents_range(skg_buffer_t *buffer, uint32_t offset, const void *data, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	if (buffer->use != skg_use_dynamic) {
+		skg_log(skg_log_warning, "Attempting to dynamically set contents of a static buffer!");
+		return;
+	}
+	if (offset > buffer->_size || size_bytes > buffer->_size - offset) {
+		skg_log(skg_log_warning, "skg_buffer_set_contents_range is writing outside of the buffer!");
+		return;
+	}
+	SKG_CAPTURE_CALL(skg_capture_buffer_set_range(buffer, offset, data, size_bytes));
+	memcpy((uint8_t*)buffer->_data + offset, data, size_bytes);
+
+	skg_stats_upload(size_bytes);
+	null_calls.buffer_uploads += 1;
+	null_calls.upload_bytes   += size_bytes;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_get_contents(const skg_buffer_t *buffer, void *ref_buffer, uint32_t buffer_size) {
+	SKG_TRACE_FUNC();
+	uint32_t copy_size = buffer_size < buffer->_size ? buffer_size : buffer->_size;
+	memcpy(ref_buffer, buffer->_data, copy_size);
+	if (copy_size < buffer_size) memset((uint8_t*)ref_buffer + copy_size, 0, buffer_size - copy_size);
+}
+
+///////////////////////////////////////////
+
+bool skg_buffer_read_async(const skg_buffer_t *buffer, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	if (buffer->_data == nullptr || buffer->_size == 0) return false;
+
+	if (ref_readback->size != buffer->_size) {
+		free(ref_readback->_data);
+		ref_readback->_data = malloc(buffer->_size);
+		ref_readback->size  = buffer->_size;
+	}
+	ref_readback->width  = (int32_t)buffer->_size;
+	ref_readback->height = 1;
+	ref_readback->format = skg_tex_fmt_none;
+	memcpy(ref_readback->_data, buffer->_data, buffer->_size);
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_bind(const skg_buffer_t *buffer, skg_bind_t slot_vc) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_bind, skg_capture_id(buffer), slot_vc));
+	SKG_STAT_MISS(skg_stat_buffer);
+	null_calls.buffer_binds += 1;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_bind_range(const skg_buffer_t *buffer, skg_bind_t slot_vc, uint32_t offset, uint32_t size_bytes) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_buffer_bind_range, skg_capture_id(buffer), slot_vc, offset, size_bytes, nullptr));
+	if (offset % skg_buffer_range_align(buffer->type) != 0 || offset + size_bytes > buffer->_size)
+		skg_log(skg_log_warning, "skg_buffer_bind_range range is misaligned, or outside of the buffer");
+	SKG_STAT_MISS(skg_stat_buffer);
+	null_calls.buffer_binds += 1;
+}
+
+///////////////////////////////////////////
+
+uint32_t skg_buffer_range_align(skg_buffer_type_ type) {
+	return type == skg_buffer_type_constant ? 256 : 1;
+}
+
+///////////////////////////////////////////
+
+bool skg_transient_bind(const void *data, uint32_t size_bytes, skg_bind_t slot_vc) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind_range(skg_capture_op_transient_bind, 0, slot_vc, 0, size_bytes, data));
+	if (slot_vc.register_type != skg_register_constant) {
+		skg_log(skg_log_warning, "skg_transient_bind only works with constant registers");
+		return false;
+	}
+	SKG_STAT_MISS(skg_stat_buffer);
+	skg_stats_upload(size_bytes);
+	null_calls.buffer_binds   += 1;
+	null_calls.upload_bytes   += size_bytes;
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_buffer_clear, 0, bind));
+}
+
+///////////////////////////////////////////
+
+void skg_buffer_destroy(skg_buffer_t *buffer) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_buffer_destroy, skg_capture_id(buffer)));
+	if (buffer->_id != 0) {
+		null_live.buffers      -= 1;
+		null_live.buffer_bytes -= buffer->_size;
+		skg_mem_release(skg_mem_key(buffer));
+	}
+	free(buffer->_data);
+	*buffer = {};
+}
+
+///////////////////////////////////////////
+// skg_mesh_t                            //
+///////////////////////////////////////////
+
+skg_mesh_t skg_mesh_create(const skg_buffer_t *vert_buffer, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
+	skg_mesh_t result = {};
+	result._id = null_next_id++;
+	skg_mesh_set_verts(&result, vert_buffer);
+	skg_mesh_set_inds (&result, ind_buffer);
+
+	null_live.meshes += 1;
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_name(skg_mesh_t *mesh, const char* name) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_set_verts(skg_mesh_t *mesh, const skg_buffer_t *vert_buffer) {
+	SKG_TRACE_FUNC();
+	mesh->_vert_buffer = vert_buffer ? vert_buffer->_id : 0;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_set_inds(skg_mesh_t *mesh, const skg_buffer_t *ind_buffer) {
+	SKG_TRACE_FUNC();
+	mesh->_ind_buffer = ind_buffer ? ind_buffer->_id : 0;
+	mesh->_ind_format = ind_buffer ? ind_buffer->_ind_format : skg_ind_fmt_u32;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_set_format(skg_mesh_t *mesh, const skg_vert_component_t *components, int32_t component_count) {
+	SKG_TRACE_FUNC();
+	int32_t fmt = skg_vert_fmt_register(components, component_count);
+	if (fmt >= 0) mesh->_vert_fmt = fmt;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_bind(const skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_mesh_bind(mesh->_vert_buffer, mesh->_ind_buffer, mesh->_vert_fmt));
+	SKG_STAT_MISS(skg_stat_layout);
+	SKG_STAT_MISS(skg_stat_buffer);
+	null_calls.mesh_binds += 1;
+}
+
+///////////////////////////////////////////
+
+void skg_mesh_destroy(skg_mesh_t *mesh) {
+	SKG_TRACE_FUNC();
+	if (mesh->_id != 0) null_live.meshes -= 1;
+	*mesh = {};
+}
+
+///////////////////////////////////////////
+// skg_shader_t                          //
+///////////////////////////////////////////
+
 skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_size, skg_stage_ type) {
+	SKG_TRACE_FUNC();
 	skg_shader_stage_t result = {};
 	result.type = type;
+	result._id  = null_next_id++;
 
 	return result;
 }
@@ -14,15 +475,530 @@ skg_shader_stage_t skg_shader_stage_create(const void *file_data, size_t shader_
 ///////////////////////////////////////////
 
 void skg_shader_stage_destroy(skg_shader_stage_t *shader) {
+	SKG_TRACE_FUNC();
+	*shader = {};
 }
 
 ///////////////////////////////////////////
 
 skg_shader_t skg_shader_create_manual(skg_shader_meta_t *meta, skg_shader_stage_t v_shader, skg_shader_stage_t p_shader, skg_shader_stage_t c_shader) {
+	SKG_TRACE_FUNC();
+	if (v_shader._id == 0 && p_shader._id == 0 && c_shader._id == 0) {
+		skg_logf(skg_log_warning, "Shader '%s' has no valid stages!", meta->name);
+		return {};
+	}
+
 	skg_shader_t result = {};
 	result.meta = meta;
+	result._id  = null_next_id++;
 	skg_shader_meta_reference(result.meta);
+
+	null_live.shaders += 1;
 	return result;
 }
 
-#endif
\ No newline at end of file
+///////////////////////////////////////////
+
+void skg_shader_name(skg_shader_t *shader, const char* name) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+bool skg_shader_is_valid(const skg_shader_t *shader) {
+	return shader->meta
+		&& shader->_id;
+}
+
+///////////////////////////////////////////
+
+bool skg_shader_is_ready(const skg_shader_t *shader) {
+	return true;
+}
+
+///////////////////////////////////////////
+
+void skg_shader_compute_bind(const skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_compute_bind, shader ? skg_capture_id(shader) : 0));
+}
+
+///////////////////////////////////////////
+
+void skg_shader_destroy(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_shader_destroy, skg_capture_id(shader)));
+	if (shader->_id != 0) null_live.shaders -= 1;
+	skg_shader_meta_release(shader->meta);
+	*shader = {};
+}
+
+///////////////////////////////////////////
+// skg_pipeline                          //
+///////////////////////////////////////////
+
+skg_pipeline_t skg_pipeline_create(skg_shader_t *shader) {
+	SKG_TRACE_FUNC();
+	skg_pipeline_t result = {};
+	result.transparency = skg_transparency_none;
+	result.cull         = skg_cull_back;
+	result.wireframe    = false;
+	result.depth_test   = skg_depth_test_less;
+	result.depth_write  = true;
+	result.depth_clip   = true;
+	result.meta         = shader->meta;
+	result._id          = null_next_id++;
+	result._shader      = shader->_id;
+	skg_shader_meta_reference(result.meta);
+
+	null_live.pipelines += 1;
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_name(skg_pipeline_t *pipeline, const char* name) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_pipeline_bind(const skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_pipeline_bind(pipeline, pipeline->_shader));
+	SKG_STAT_MISS(skg_stat_program);
+	SKG_STAT_MISS(skg_stat_blend);
+	SKG_STAT_MISS(skg_stat_cull);
+	SKG_STAT_MISS(skg_stat_depth);
+	null_calls.pipeline_binds += 1;
+}
+
+///////////////////////////////////////////
+
+void              skg_pipeline_set_transparency(      skg_pipeline_t *pipeline, skg_transparency_ transparency) { pipeline->transparency = transparency; }
+skg_transparency_ skg_pipeline_get_transparency(const skg_pipeline_t *pipeline)                                 { return pipeline->transparency; }
+void              skg_pipeline_set_cull        (      skg_pipeline_t *pipeline, skg_cull_ cull)                 { pipeline->cull = cull; }
+skg_cull_         skg_pipeline_get_cull        (const skg_pipeline_t *pipeline)                                 { return pipeline->cull; }
+void              skg_pipeline_set_wireframe   (      skg_pipeline_t *pipeline, bool wireframe)                 { pipeline->wireframe = wireframe; }
+bool              skg_pipeline_get_wireframe   (const skg_pipeline_t *pipeline)                                 { return pipeline->wireframe; }
+void              skg_pipeline_set_depth_write (      skg_pipeline_t *pipeline, bool write)                     { pipeline->depth_write = write; }
+bool              skg_pipeline_get_depth_write (const skg_pipeline_t *pipeline)                                 { return pipeline->depth_write; }
+void              skg_pipeline_set_depth_clip  (      skg_pipeline_t *pipeline, bool clip)                      { pipeline->depth_clip = clip; }
+bool              skg_pipeline_get_depth_clip  (const skg_pipeline_t *pipeline)                                 { return pipeline->depth_clip; }
+void              skg_pipeline_set_color_write (      skg_pipeline_t *pipeline, skg_color_write_ write)         { pipeline->color_write = write; }
+skg_color_write_  skg_pipeline_get_color_write (const skg_pipeline_t *pipeline)                                 { return pipeline->color_write; }
+void              skg_pipeline_set_depth_test  (      skg_pipeline_t *pipeline, skg_depth_test_ test)           { pipeline->depth_test = test; }
+skg_depth_test_   skg_pipeline_get_depth_test  (const skg_pipeline_t *pipeline)                                 { return pipeline->depth_test; }
+void              skg_pipeline_set_scissor     (      skg_pipeline_t *pipeline, bool enable)                    { pipeline->scissor = enable; }
+bool              skg_pipeline_get_scissor     (const skg_pipeline_t *pipeline)                                 { return pipeline->scissor; }
+
+///////////////////////////////////////////
+
+void skg_pipeline_destroy(skg_pipeline_t *pipeline) {
+	SKG_TRACE_FUNC();
+	if (pipeline->_id != 0) null_live.pipelines -= 1;
+	skg_shader_meta_release(pipeline->meta);
+	*pipeline = {};
+}
+
+///////////////////////////////////////////
+// skg_swapchain_t                       //
+///////////////////////////////////////////
+
+skg_swapchain_t skg_swapchain_create(void *hwnd, skg_tex_fmt_ format, skg_tex_fmt_ depth_format, int32_t requested_width, int32_t requested_height) {
+	SKG_TRACE_FUNC();
+	skg_swapchain_t result = {};
+	result.width  = requested_width;
+	result.height = requested_height;
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_resize(skg_swapchain_t *swapchain, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
+	swapchain->width  = width;
+	swapchain->height = height;
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_present(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_bind(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+	null_active_rendertarget = nullptr;
+	int32_t viewport[4] = { 0, 0, swapchain->width, swapchain->height };
+	skg_viewport(viewport);
+}
+
+///////////////////////////////////////////
+
+void skg_swapchain_destroy(skg_swapchain_t *swapchain) {
+	SKG_TRACE_FUNC();
+	*swapchain = {};
+}
+
+///////////////////////////////////////////
+// skg_tex_t                             //
+///////////////////////////////////////////
+
+skg_tex_t skg_tex_create_from_existing(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_count, int32_t multisample, int32_t framebuffer_multisample) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = {};
+	result.type        = type;
+	result.use         = skg_use_static;
+	result.mips        = skg_mip_none;
+	result.format      = format;
+	result.width       = width;
+	result.height      = height;
+	result.array_count = array_count;
+	result.multisample = framebuffer_multisample > multisample ? framebuffer_multisample : multisample;
+	result._id         = null_next_id++;
+	result._mip_count  = 1;
+
+	null_live.textures += 1;
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create_existing, &result));
+	return result;
+}
+
+///////////////////////////////////////////
+
+skg_tex_t skg_tex_create_from_layer(void *native_tex, skg_tex_type_ type, skg_tex_fmt_ format, int32_t width, int32_t height, int32_t array_layer) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = skg_tex_create_from_existing(native_tex, type, format, width, height, 1, 1, 1);
+	result.array_start = array_layer;
+	return result;
+}
+
+///////////////////////////////////////////
+
+skg_tex_t skg_tex_create(skg_tex_type_ type, skg_use_ use, skg_tex_fmt_ format, skg_mip_ mip_maps) {
+	SKG_TRACE_FUNC();
+	skg_tex_t result = {};
+	result.type        = type;
+	result.use         = use;
+	result.format      = format;
+	result.mips        = mip_maps;
+	result.array_count = 1;
+	result._id         = null_next_id++;
+	skg_mem_add(skg_mem_key(&result));
+	SKG_CAPTURE_CALL(skg_capture_tex_create(skg_capture_op_tex_create, &result));
+	skg_tex_settings(&result, (use & skg_use_cubemap) > 0 ? skg_tex_address_clamp : skg_tex_address_repeat, skg_tex_sample_linear, skg_sample_compare_none, 1);
+
+	null_live.textures += 1;
+	return result;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_name(skg_tex_t *tex, const char* name) {
+	SKG_TRACE_FUNC();
+	skg_mem_name(skg_mem_key(tex), name);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_is_valid(const skg_tex_t *tex) {
+	return tex->_id != 0;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_copy_to(const skg_tex_t *tex, int32_t tex_surface, skg_tex_t *destination, int32_t dest_surface) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_copy_to, skg_capture_id(tex), tex_surface, skg_capture_id(destination), dest_surface));
+	if (destination->width != tex->width || destination->height != tex->height) {
+		skg_tex_set_contents_arr(destination, nullptr, tex->array_count, 1, tex->width, tex->height, tex->multisample);
+	}
+	if (tex->_data == nullptr || destination->_data == nullptr || tex->format != destination->format) return;
+
+	if (tex_surface == -1 && dest_surface == -1) {
+		for (int32_t i = 0; i < destination->array_count && i < tex->array_count; i++) {
+			size_t size = skg_tex_fmt_memory(tex->format, tex->width, tex->height);
+			memcpy((uint8_t*)destination->_data + null_tex_mip_offset(destination, 0, i), (uint8_t*)tex->_data + null_tex_mip_offset(tex, 0, i), size);
+		}
+	} else {
+		size_t size = skg_tex_fmt_memory(tex->format, tex->width, tex->height);
+		memcpy((uint8_t*)destination->_data + null_tex_mip_offset(destination, 0, dest_surface < 0 ? 0 : dest_surface), (uint8_t*)tex->_data + null_tex_mip_offset(tex, 0, tex_surface < 0 ? 0 : tex_surface), size);
+	}
+}
+
+///////////////////////////////////////////
+
+void skg_tex_copy_to_swapchain(const skg_tex_t *tex, skg_swapchain_t *destination) {
+	SKG_TRACE_FUNC();
+}
+
+///////////////////////////////////////////
+
+void skg_tex_attach_depth(skg_tex_t *tex, skg_tex_t *depth) {
+	SKG_TRACE_FUNC();
+	if (tex->type != skg_tex_type_rendertarget) {
+		skg_log(skg_log_warning, "Can't bind a depth texture to a non-rendertarget");
+		return;
+	}
+	if (tex->array_count != depth->array_count) {
+		skg_log(skg_log_warning, "Mismatching array count for depth texture");
+		return;
+	}
+	SKG_CAPTURE_CALL(skg_capture_tex_pair(skg_capture_op_tex_attach_depth, skg_capture_id(tex), 0, skg_capture_id(depth), 0));
+	tex->_depth = depth->_id;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_settings(skg_tex_t *tex, skg_tex_address_ address, skg_tex_sample_ sample, skg_sample_compare_ compare, int32_t anisotropy) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_settings(tex, address, sample, compare, anisotropy));
+	tex->_address    = address;
+	tex->_sample     = sample;
+	tex->_compare    = compare;
+	tex->_anisotropy = anisotropy;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_set_contents(skg_tex_t *tex, const void *data, int32_t width, int32_t height) {
+	SKG_TRACE_FUNC();
+	const void *data_arr[1] = { data };
+	return skg_tex_set_contents_arr(tex, data_arr, 1, 1, width, height, 1);
+}
+
+///////////////////////////////////////////
+
+void skg_tex_set_contents_arr(skg_tex_t *tex, const void **array_data, int32_t array_count, int32_t mip_count, int32_t width, int32_t height, int32_t multisample) {
+	SKG_TRACE_FUNC();
+	if ((tex->use & skg_use_cubemap) > 0 && array_count != 6) {
+		skg_log(skg_log_warning, "Cubemaps need 6 data frames");
+		return;
+	}
+
+	SKG_CAPTURE_CALL(skg_capture_tex_set_contents(tex, array_data, array_count, mip_count, width, height, multisample));
+	null_live.tex_bytes -= tex->_data_size;
+	free(tex->_data);
+
+	tex->width       = width;
+	tex->height      = height;
+	tex->array_count = array_count;
+	tex->multisample = multisample;
+	tex->_mip_count  = tex->mips == skg_mip_generate && mip_count == 1
+		? (int32_t)skg_mip_count(width, height)
+		: mip_count;
+
+	// Keep a CPU copy of the texture's contents, laid out as
+	// [array][mip], same as the data we're given.
+	size_t layer_size = null_tex_mip_offset(tex, 0, 1);
+	size_t data_size  = 0;
+	for (int32_t m = 0; m < mip_count; m++) {
+		int32_t mip_width, mip_height;
+		skg_mip_dimensions(width, height, m, &mip_width, &mip_height);
+		data_size += skg_tex_fmt_memory(tex->format, mip_width, mip_height);
+	}
+	tex->_data_size = layer_size * array_count;
+	tex->_data      = calloc(tex->_data_size > 0 ? tex->_data_size : 1, 1);
+	for (int32_t a = 0; array_data != nullptr && a < array_count; a++) {
+		if (array_data[a] == nullptr) continue;
+		memcpy((uint8_t*)tex->_data + layer_size * a, array_data[a], data_size);
+		null_calls.upload_bytes += data_size;
+		skg_stats_upload(data_size);
+	}
+
+	null_live.tex_bytes   += tex->_data_size;
+	null_calls.tex_uploads += 1;
+	// Account for memory the way a GPU would store it, every sample of a
+	// multisample texture included.
+	skg_mem_track_tex(skg_mem_key(tex), tex, tex->_mip_count, tex->multisample);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_get_contents(skg_tex_t *tex, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	return skg_tex_get_mip_contents_arr(tex, 0, 0, ref_data, data_size);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_get_mip_contents(skg_tex_t *tex, int32_t mip_level, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	return skg_tex_get_mip_contents_arr(tex, mip_level, 0, ref_data, data_size);
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_get_mip_contents_arr(skg_tex_t *tex, int32_t mip_level, int32_t arr_index, void *ref_data, size_t data_size) {
+	SKG_TRACE_FUNC();
+	// Textures wrapping an existing or parent resource have no CPU copy
+	if (tex->_data == nullptr || mip_level >= tex->_mip_count || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "This texture doesn't have quite as many mip levels or array slices as you think.");
+		return false;
+	}
+
+	int32_t width, height;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+	if (data_size != skg_tex_fmt_memory(tex->format, width, height)) {
+		skg_log(skg_log_critical, "Insufficient buffer size for skg_tex_get_mip_contents_arr");
+		return false;
+	}
+
+	memcpy(ref_data, (uint8_t*)tex->_data + null_tex_mip_offset(tex, mip_level, arr_index), data_size);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_read_async(const skg_tex_t *tex, int32_t mip_level, int32_t arr_index, skg_readback_t *ref_readback) {
+	SKG_TRACE_FUNC();
+	if (tex->_data == nullptr || mip_level >= tex->_mip_count || arr_index >= tex->array_count) {
+		skg_log(skg_log_critical, "skg_tex_read_async: this texture doesn't have the mip level or array slice you asked for.");
+		return false;
+	}
+
+	int32_t width, height;
+	skg_mip_dimensions(tex->width, tex->height, mip_level, &width, &height);
+	size_t size = skg_tex_fmt_memory(tex->format, width, height);
+	if (ref_readback->size != size) {
+		free(ref_readback->_data);
+		ref_readback->_data = malloc(size);
+		ref_readback->size  = size;
+	}
+	ref_readback->width  = width;
+	ref_readback->height = height;
+	ref_readback->format = tex->format;
+
+	// There's no GPU to wait on, so the copy is ready right away.
+	memcpy(ref_readback->_data, (uint8_t*)tex->_data + null_tex_mip_offset(tex, mip_level, arr_index), size);
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool skg_readback_poll(skg_readback_t *readback) {
+	return readback->_data != nullptr;
+}
+
+///////////////////////////////////////////
+
+const void *skg_readback_map(skg_readback_t *readback, size_t *out_size) {
+	if (out_size) *out_size = readback->size;
+	return readback->_data;
+}
+
+///////////////////////////////////////////
+
+void skg_readback_destroy(skg_readback_t *readback) {
+	free(readback->_data);
+	*readback = {};
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_gen_mips(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_gen_mips, skg_capture_id(tex)));
+	return true;
+}
+
+///////////////////////////////////////////
+
+void* skg_tex_get_native(const skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	return (void*)(uint64_t)tex->_id;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_bind(const skg_tex_t *tex, skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_bind, skg_capture_id(tex), bind));
+	SKG_STAT_MISS(skg_stat_texture);
+	null_calls.tex_binds += 1;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_clear(skg_bind_t bind) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_bind(skg_capture_op_tex_clear, 0, bind));
+}
+
+///////////////////////////////////////////
+
+void skg_tex_target_discard(skg_tex_t *render_target) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_target_discard, skg_capture_id(render_target)));
+}
+
+///////////////////////////////////////////
+
+void skg_tex_target_bind(skg_tex_t *render_target, int32_t layer_idx, int32_t mip_level) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_tex_target_bind(render_target ? skg_capture_id(render_target) : 0, layer_idx, mip_level));
+	null_active_rendertarget = render_target;
+	null_calls.target_binds += 1;
+	if (render_target) {
+		int32_t viewport[4] = { 0, 0, render_target->width, render_target->height };
+		skg_viewport(viewport);
+	}
+}
+
+///////////////////////////////////////////
+
+skg_tex_t *skg_tex_target_get() {
+	return null_active_rendertarget;
+}
+
+///////////////////////////////////////////
+
+void skg_tex_destroy(skg_tex_t *tex) {
+	SKG_TRACE_FUNC();
+	SKG_CAPTURE_CALL(skg_capture_id_op(skg_capture_op_tex_destroy, skg_capture_id(tex)));
+	if (null_active_rendertarget == tex) null_active_rendertarget = nullptr;
+	if (tex->_id != 0) {
+		null_live.textures  -= 1;
+		null_live.tex_bytes -= tex->_data_size;
+		skg_mem_release(skg_mem_key(tex));
+	}
+	free(tex->_data);
+	*tex = {};
+}
+
+///////////////////////////////////////////
+
+int64_t skg_tex_fmt_to_native(skg_tex_fmt_ format) {
+	return (int64_t)format;
+}
+
+///////////////////////////////////////////
+
+skg_tex_fmt_ skg_tex_fmt_from_native(int64_t format) {
+	return format > skg_tex_fmt_none && format < skg_tex_fmt_max
+		? (skg_tex_fmt_)format
+		: skg_tex_fmt_none;
+}
+
+///////////////////////////////////////////
+
+bool skg_tex_fmt_supported(skg_tex_fmt_ format) {
+	return format > skg_tex_fmt_none && format < skg_tex_fmt_max;
+}
+
+///////////////////////////////////////////
+
+uint64_t skg_mem_key(const skg_buffer_t *buffer) { return buffer->_id; }
+uint64_t skg_mem_key(const skg_tex_t    *tex   ) { return tex   ->_id; }
+
+///////////////////////////////////////////
+
+#if defined(SKG_CAPTURE)
+uint64_t skg_capture_id(const skg_buffer_t *buffer) { return buffer->_id; }
+uint64_t skg_capture_id(const skg_shader_t *shader) { return shader->_id; }
+uint64_t skg_capture_id(const skg_tex_t    *tex   ) { return tex   ->_id; }
+#endif
+
+#endif
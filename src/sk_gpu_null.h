@@ -2,10 +2,47 @@
 #include "sk_gpu_dev.h"
 ///////////////////////////////////////////
 
+// The null backend does no rendering at all, it just keeps CPU-side records
+// of the resources it's been handed, and counts the calls made into it. This
+// makes it handy for headless CI, and for measuring the CPU cost of an app's
+// own render loop without any driver noise.
+
+typedef struct skg_null_calls_t {
+	int32_t draws;
+	int32_t draw_instances;
+	int32_t draw_indices;
+	int32_t computes;
+	int32_t pipeline_binds;
+	int32_t mesh_binds;
+	int32_t tex_binds;
+	int32_t buffer_binds;
+	int32_t target_binds;
+	int32_t target_clears;
+	int32_t buffer_uploads;
+	int32_t tex_uploads;
+	int64_t upload_bytes;
+} skg_null_calls_t;
+
+typedef struct skg_null_live_t {
+	int32_t buffers;
+	int32_t meshes;
+	int32_t shaders;
+	int32_t pipelines;
+	int32_t textures;
+	int64_t buffer_bytes;
+	int64_t tex_bytes;
+} skg_null_live_t;
+
+///////////////////////////////////////////
+
 typedef struct skg_buffer_t {
 	skg_use_           use;
 	skg_buffer_type_   type;
 	uint32_t           stride;
+	uint32_t           _id;
+	uint32_t           _size;
+	void              *_data;
+	skg_ind_fmt_       _ind_format;
 } skg_buffer_t;
 
 typedef struct skg_computebuffer_t {
@@ -14,14 +51,21 @@ typedef struct skg_computebuffer_t {
 } skg_computebuffer_t;
 
 typedef struct skg_mesh_t {
+	uint32_t           _id;
+	uint32_t           _vert_buffer;
+	uint32_t           _ind_buffer;
+	skg_ind_fmt_       _ind_format;
+	int32_t            _vert_fmt;
 } skg_mesh_t;
 
 typedef struct skg_shader_stage_t {
 	skg_stage_         type;
+	uint32_t           _id;
 } skg_shader_stage_t;
 
 typedef struct skg_shader_t {
 	skg_shader_meta_t* meta;
+	uint32_t           _id;
 } skg_shader_t;
 
 typedef struct skg_pipeline_t {
@@ -29,9 +73,13 @@ typedef struct skg_pipeline_t {
 	skg_cull_          cull;
 	bool               wireframe;
 	bool               depth_write;
+	bool               depth_clip;
+	skg_color_write_   color_write;
 	bool               scissor;
 	skg_depth_test_    depth_test;
 	skg_shader_meta_t* meta;
+	uint32_t           _id;
+	uint32_t           _shader;
 } skg_pipeline_t;
 
 typedef struct skg_tex_t {
@@ -44,12 +92,32 @@ typedef struct skg_tex_t {
 	skg_tex_type_      type;
 	skg_tex_fmt_       format;
 	skg_mip_           mips;
+	uint32_t           _id;
+	uint32_t           _depth;
+	int32_t            _mip_count;
+	size_t             _data_size;
+	void              *_data;
+	skg_tex_address_    _address;
+	skg_tex_sample_     _sample;
+	skg_sample_compare_ _compare;
+	int32_t             _anisotropy;
 } skg_tex_t;
 
+typedef struct skg_readback_t {
+	int32_t            width;
+	int32_t            height;
+	skg_tex_fmt_       format;
+	size_t             size;
+	void              *_data;
+} skg_readback_t;
+
 typedef struct skg_swapchain_t {
 	int32_t            width;
 	int32_t            height;
 } skg_swapchain_t;
 
 typedef struct skg_platform_data_t {
+	const skg_null_calls_t *_calls_last_frame;
+	const skg_null_calls_t *_calls_this_frame;
+	const skg_null_live_t  *_live;
 } skg_platform_data_t;